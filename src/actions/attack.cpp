@@ -408,26 +408,28 @@ battle_context& battle_context::operator=(const battle_context &other)
 
 /** @todo FIXME: better to initialize combatant initially (move into
                  battle_context_unit_stats?), just do fight() when required. */
-const combatant &battle_context::get_attacker_combatant(const combatant *prev_def)
+const combatant &battle_context::get_attacker_combatant(const combatant *prev_def,
+                                                        const fight_sampling *sampling)
 {
 	// We calculate this lazily, since AI doesn't always need it.
 	if (!attacker_combatant_) {
 		assert(!defender_combatant_);
 		attacker_combatant_ = new combatant(*attacker_stats_);
 		defender_combatant_ = new combatant(*defender_stats_, prev_def);
-		attacker_combatant_->fight(*defender_combatant_);
+		attacker_combatant_->fight(*defender_combatant_, true, sampling);
 	}
 	return *attacker_combatant_;
 }
 
-const combatant &battle_context::get_defender_combatant(const combatant *prev_def)
+const combatant &battle_context::get_defender_combatant(const combatant *prev_def,
+                                                        const fight_sampling *sampling)
 {
 	// We calculate this lazily, since AI doesn't always need it.
 	if (!defender_combatant_) {
 		assert(!attacker_combatant_);
 		attacker_combatant_ = new combatant(*attacker_stats_);
 		defender_combatant_ = new combatant(*defender_stats_, prev_def);
-		attacker_combatant_->fight(*defender_combatant_);
+		attacker_combatant_->fight(*defender_combatant_, true, sampling);
 	}
 	return *defender_combatant_;
 }
@@ -23,6 +23,7 @@
 #define ACTIONS_ATTACK_H_INCLUDED
 
 struct combatant;
+struct fight_sampling;
 struct map_location;
 class  team;
 class  unit;
@@ -162,9 +163,14 @@ public:
 	/** This method returns the statistics of the defender. */
 	const battle_context_unit_stats& get_defender_stats() const { return *defender_stats_; }
 
-	/** Get the simulation results. */
-	const combatant &get_attacker_combatant(const combatant *prev_def = NULL);
-	const combatant &get_defender_combatant(const combatant *prev_def = NULL);
+	/**
+	 * Get the simulation results. The first call runs the simulation, which
+	 * may be sampled according to @a sampling (see combatant::fight()).
+	 */
+	const combatant &get_attacker_combatant(const combatant *prev_def = NULL,
+	                                        const fight_sampling *sampling = NULL);
+	const combatant &get_defender_combatant(const combatant *prev_def = NULL,
+	                                        const fight_sampling *sampling = NULL);
 
 	/** Given this harm_weight, is this attack better than that? */
 	bool better_attack(class battle_context &that, double harm_weight);
@@ -78,12 +78,54 @@ namespace {
 	}
 
 
+	/**
+	 * The hexes the [heals] abilities can reach: those of the units having
+	 * one and the hexes next to them, found with a single sweep over the
+	 * units. The other patients cannot be healed by units, so they skip
+	 * the lookup of those abilities and of their filters.
+	 */
+	class healer_coverage
+	{
+	public:
+		healer_coverage(const unit_map & units, const gamemap & map) :
+			map_(map),
+			hexes_(map.w() * map.h(), false)
+		{
+			map_location adjacent[6];
+			BOOST_FOREACH(const unit & healer, units) {
+				if ( healer.incapacitated() || !healer.has_ability_type("heals") )
+					continue;
+				mark(healer.get_location());
+				get_adjacent_tiles(healer.get_location(), adjacent);
+				BOOST_FOREACH(const map_location & loc, adjacent)
+					mark(loc);
+			}
+		}
+
+		bool covers(const map_location & loc) const
+		{
+			return !map_.on_board(loc) || hexes_[loc.y * map_.w() + loc.x];
+		}
+
+	private:
+		void mark(const map_location & loc)
+		{
+			if ( map_.on_board(loc) )
+				hexes_[loc.y * map_.w() + loc.x] = true;
+		}
+
+		const gamemap & map_;
+		std::vector<bool> hexes_;
+	};
+
+
 	/**
 	 * Determines if @a patient is affected by anything that impacts poison.
 	 * If cured by a unit, that unit is added to @a healers.
+	 * Units only heal when @a covered, see healer_coverage.
 	 */
 	POISON_STATUS poison_progress(int side, const unit & patient,
-	                              std::vector<unit *> & healers)
+	                              std::vector<unit *> & healers, bool covered)
 	{
 		const std::vector<team> &teams = *resources::teams;
 		unit_map &units = *resources::units;
@@ -108,6 +150,9 @@ namespace {
 			}
 		}
 
+		if ( !covered )
+			return curing;
+
 		// Look through the healers to find a curer.
 		unit_map::iterator curer = units.end();
 		// Assumed: curing is not POISON_CURE at the start of any iteration.
@@ -179,8 +224,10 @@ namespace {
 	/**
 	 * Calculate how much @patient heals this turn.
 	 * If healed by units, those units are added to @a healers.
+	 * Units only heal when @a covered, see healer_coverage.
 	 */
-	int heal_amount(int side, const unit & patient, std::vector<unit *> & healers)
+	int heal_amount(int side, const unit & patient, std::vector<unit *> & healers,
+	                bool covered)
 	{
 		unit_map &units = *resources::units;
 
@@ -200,6 +247,9 @@ namespace {
 			update_healing(healing, harming, regen_effect.get_composite_value());
 		}
 
+		if ( !covered )
+			return healing + harming;
+
 		// Check healing from other units.
 		unit_ability_list heal_list = patient.get_abilities("heals");
 		// Remove all healers not on this side (since they do not heal now).
@@ -233,6 +283,7 @@ namespace {
 
 	/**
 	 * Handles the actual healing.
+	 * The caller invalidates the display.
 	 */
 	void do_heal(unit &patient, int amount, bool cure_poison)
 	{
@@ -242,7 +293,6 @@ namespace {
 			patient.heal(amount);
 		else if ( amount < 0 )
 			patient.take_hit(-amount);
-		resources::screen->invalidate_unit();
 	}
 
 
@@ -282,6 +332,7 @@ namespace {
 			unit_display::unit_healing(nearest->healed, nearest->healers,
 			                           nearest->amount, cure_text);
 			do_heal(nearest->healed, nearest->amount, nearest->cure_poison);
+			resources::screen->invalidate_unit();
 
 			// Update the loop variables.
 			last_loc = nearest->healed.get_location();
@@ -297,7 +348,16 @@ void calculate_healing(int side, bool update_display)
 {
 	DBG_NG << "beginning of healing calculations\n";
 
+	// The animated healings, then those done without animation. All are
+	// worked out before any is done, so that every unit heals from the
+	// state of the start of the turn, as the animated ones always did.
 	std::list<heal_unit> unit_list;
+	std::list<heal_unit> quiet_list;
+
+	const healer_coverage coverage(*resources::units, resources::gameboard->map());
+	const team & viewing_team =
+		(*resources::teams)[resources::screen->viewing_team()];
+	const bool animate = update_display && !resources::controller->is_skipping_replay();
 
 	// We look for all allied units, then we see if our healer is near them.
 	BOOST_FOREACH(unit &patient, *resources::units) {
@@ -323,11 +383,12 @@ void calculate_healing(int side, bool update_display)
 		}
 
 		// Main healing.
+		const bool covered = coverage.covers(patient.get_location());
 		if ( !patient.get_state(unit::STATE_POISONED) ) {
-			healing += heal_amount(side, patient, healers);
+			healing += heal_amount(side, patient, healers, covered);
 		}
 		else {
-			curing = poison_progress(side, patient, healers);
+			curing = poison_progress(side, patient, healers, covered);
 			// Poison can be cured at any time, but damage is only
 			// taken on the patient's turn.
 			if ( curing == POISON_NORMAL  &&  patient.side() == side )
@@ -350,20 +411,23 @@ void calculate_healing(int side, bool update_display)
 			DBG_NG << "Just before healing animations, unit has " << healers.size() << " potential healers.\n";
 		}
 
-		const team & viewing_team =
-			(*resources::teams)[resources::screen->viewing_team()];
-		if (!resources::controller->is_skipping_replay() && update_display &&
+		if ( animate &&
 		    patient.is_visible_to_team(viewing_team, resources::gameboard->map(), false) )
 		{
 			unit_list.push_front(heal_unit(patient, healers, healing, curing == POISON_CURE));
 		}
 		else
 		{
-			// Do the healing now since it will not be animated.
-			do_heal(patient, healing, curing == POISON_CURE);
+			quiet_list.push_back(heal_unit(patient, healers, healing, curing == POISON_CURE));
 		}
 	}
 
+	// The healings not animated are done at once, with one redraw.
+	BOOST_FOREACH(const heal_unit & heal, quiet_list)
+		do_heal(heal.healed, heal.amount, heal.cure_poison);
+	if ( !quiet_list.empty() )
+		resources::screen->invalidate_unit();
+
 	animate_heals(unit_list);
 
 	DBG_NG << "end of healing calculations\n";
@@ -27,6 +27,7 @@
 #include "../map.hpp"                      // for gamemap
 #include "../map_location.hpp"  // for map_location, operator<<, etc
 #include "../mouse_handler_base.hpp"       // for command_disabler
+#include "../packed_command.hpp"        // for pack_command, unpack_command
 #include "../recall_list_manager.hpp"   // for recall_list_manager
 #include "../replay.hpp"                // for recorder, replay
 #include "../replay_helper.hpp"         // for replay_helper
@@ -76,13 +77,39 @@ undo_list::undo_action::~undo_action()
 	delete view_info;
 }
 
+void undo_list::undo_action::set_replay_data(config & cfg)
+{
+	if ( cfg.empty() )
+		replay_data.clear();
+	else
+		pack_command(cfg, replay_data);
+	cfg.clear();
+}
+
+void undo_list::undo_action::write_replay_data(config & cfg) const
+{
+	config & child = cfg.add_child("replay_data");
+	if ( !replay_data.empty() )
+		unpack_command(replay_data, child);
+}
+
+void undo_list::undo_action::redo_replay_data()
+{
+	config cfg;
+	if ( !replay_data.empty() )
+		unpack_command(replay_data, cfg);
+	replay_data.clear();
+	resources::recorder->redo(cfg);
+}
+
 
 struct undo_list::dismiss_action : undo_list::undo_action {
 	unit_ptr dismissed_unit;
 
 
+	/// The dismissed unit leaves the recall list, so it is kept rather than copied.
 	explicit dismiss_action(const unit_const_ptr dismissed) : undo_action(),
-		dismissed_unit(new unit(*dismissed))
+		dismissed_unit(boost::const_pointer_cast<unit>(dismissed))
 	{
 		this->unit_id_diff = synced_context::get_unit_id_diff();
 	}
@@ -317,7 +344,8 @@ undo_list::undo_action::create(const config & cfg)
 		ERR_NG << "Unrecognized undo action type: " << str << "." << std::endl;
 		return NULL;
 	}
-	res->replay_data = cfg.child_or_empty("replay_data");
+	config replay_data = cfg.child_or_empty("replay_data");
+	res->set_replay_data(replay_data);
 	res->unit_id_diff = cfg["unit_id_diff"];
 	return res;
 }
@@ -328,7 +356,7 @@ undo_list::undo_action::create(const config & cfg)
  */
 void undo_list::dismiss_action::write(config & cfg) const
 {
-	cfg.add_child("replay_data", replay_data);
+	write_replay_data(cfg);
 	cfg["unit_id_diff"] = unit_id_diff;
 	cfg["type"] = "dismiss";
 	dismissed_unit->write(cfg.add_child("unit"));
@@ -339,7 +367,7 @@ void undo_list::dismiss_action::write(config & cfg) const
  */
 void undo_list::recall_action::write(config & cfg) const
 {
-	cfg.add_child("replay_data", replay_data);
+	write_replay_data(cfg);
 	cfg["unit_id_diff"] = unit_id_diff;
 	cfg["type"] = "recall";
 	route.front().write(cfg);
@@ -355,7 +383,7 @@ void undo_list::recall_action::write(config & cfg) const
  */
 void undo_list::recruit_action::write(config & cfg) const
 {
-	cfg.add_child("replay_data", replay_data);
+	write_replay_data(cfg);
 	cfg["unit_id_diff"] = unit_id_diff;
 	cfg["type"] = "recruit";
 	route.front().write(cfg);
@@ -371,7 +399,7 @@ void undo_list::recruit_action::write(config & cfg) const
  */
 void undo_list::move_action::write(config & cfg) const
 {
-	cfg.add_child("replay_data", replay_data);
+	write_replay_data(cfg);
 	cfg["unit_id_diff"] = unit_id_diff;
 	cfg["type"] = "move";
 	cfg["starting_direction"] = map_location::write_direction(starting_dir);
@@ -391,7 +419,7 @@ void undo_list::move_action::write(config & cfg) const
  */
 void undo_list::auto_shroud_action::write(config & cfg) const
 {
-	cfg.add_child("replay_data", replay_data);
+	write_replay_data(cfg);
 	cfg["unit_id_diff"] = unit_id_diff;
 	cfg["type"] = "auto_shroud";
 	cfg["active"] = active;
@@ -402,7 +430,7 @@ void undo_list::auto_shroud_action::write(config & cfg) const
  */
 void undo_list::update_shroud_action::write(config & cfg) const
 {
-	cfg.add_child("replay_data", replay_data);
+	write_replay_data(cfg);
 	cfg["unit_id_diff"] = unit_id_diff;
 	cfg["type"] = "update_shroud";
 }
@@ -659,7 +687,9 @@ void undo_list::undo()
 	n_unit::id_manager::instance().set_save_id(last_unit_id - action->unit_id_diff);
 
 	// Bookkeeping.
-	resources::recorder->undo_cut(action->get_replay_data());
+	config replay_data;
+	resources::recorder->undo_cut(replay_data);
+	action->set_replay_data(replay_data);
 	redos_.push_back(action.release());
 	resources::whiteboard->on_gamestate_change();
 
@@ -881,8 +911,7 @@ bool undo_list::dismiss_action::redo(int side)
 {
 	team &current_team = (*resources::teams)[side-1];
 
-	resources::recorder->redo(replay_data);
-	replay_data.clear();
+	redo_replay_data();
 	current_team.recall_list().erase_if_matches_id(dismissed_unit->id());
 	return true;
 }
@@ -908,8 +937,7 @@ bool undo_list::recall_action::redo(int side)
 
 	const std::string &msg = find_recall_location(side, loc, from, *un);
 	if ( msg.empty() ) {
-		resources::recorder->redo(replay_data);
-		replay_data.clear();
+		redo_replay_data();
 		set_scontext_synced sync;
 		recall_unit(id, current_team, loc, from, true, false);
 
@@ -956,8 +984,7 @@ bool undo_list::recruit_action::redo(int side)
 	if ( msg.empty() ) {
 		//MP_COUNTDOWN: restore recruitment bonus
 		current_team.set_action_bonus_count(1 + current_team.action_bonus_count());
-		resources::recorder->redo(replay_data);
-		replay_data.clear();
+		redo_replay_data();
 		set_scontext_synced sync;
 		recruit_unit(u_type, side, loc, from, true, false);
 
@@ -1021,8 +1048,7 @@ bool undo_list::move_action::redo(int side)
 	}
 
 	gui.invalidate_unit_after_move(route.front(), route.back());
-	resources::recorder->redo(replay_data);
-	replay_data.clear();
+	redo_replay_data();
 	return true;
 }
 
@@ -27,6 +27,7 @@
 #include <boost/noncopyable.hpp>
 #include <boost/ptr_container/ptr_vector.hpp>
 #include <boost/optional.hpp>
+#include <string>
 #include <vector>
 
 
@@ -97,13 +98,19 @@ class undo_list : boost::noncopyable {
 		/// @return true on success; false on an error.
 		virtual bool redo(int side) = 0;
 
-		config& get_replay_data() { return replay_data; }
+		/// Takes the contents of @a cfg as the replay data, clearing it.
+		void set_replay_data(config & cfg);
+		/// Writes the replay data as a [replay_data] child of @a cfg.
+		void write_replay_data(config & cfg) const;
+		/// Gives the replay data back to the replay, clearing it.
+		void redo_replay_data();
 
 		// Data:
 		/// the replay data to do this action, this is only !empty() when this action is on the redo stack
 		/// we need this because we don’t recalculate the redos like they would be in real game,
 		/// but even undoable commands can have "dependent" (= user_input) commands, which we save here.
-		config replay_data;
+		/// It is kept packed (see packed_command.hpp), as it is only read to redo or save the action.
+		std::string replay_data;
 
 		int unit_id_diff;
 		/// The hexes occupied by the affected unit during this action.
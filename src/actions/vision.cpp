@@ -650,11 +650,9 @@ bool actor_sighted(const unit & target, const std::vector<int> * cache)
 	for ( size_t i = 0; i != teams_size; ++i )
 		needs_event[i] = needs_event[i] && target.is_visible_to_team(teams[i], resources::gameboard->map(), false);
 
-	// Cache "jamming".
+	// Cache "jamming" (calculated when first needed).
 	std::vector< std::map<map_location, int> > jamming_cache(teams_size);
-	for ( size_t i = 0; i != teams_size; ++i )
-		if ( needs_event[i] )
-			create_jamming_map(jamming_cache[i], teams[i]);
+	std::vector<bool> jamming_cached(teams_size, false);
 
 	// Look for units that can be used as the second unit in sighted events.
 	std::vector<const unit *> second_units(teams_size, NULL);
@@ -663,15 +661,27 @@ bool actor_sighted(const unit & target, const std::vector<int> * cache)
 		const size_t index = viewer.side() - 1;
 		// Does viewer belong to a team for which we still need a unit?
 		if ( needs_event[index]  &&  distances[index] != 0 ) {
-			if ( can_see(viewer, target_loc, &jamming_cache[index]) ) {
+			// Seeing costs at least one vision point per hex, and the vision
+			// path's edges are one hex further; skip the path of the units
+			// that are too far away to see the target.
+			const size_t viewer_distance =
+				distance_between(target_loc, viewer.get_location());
+			bool sees = false;
+			if ( viewer.vision() >= 0  &&
+			     viewer_distance <= static_cast<size_t>(viewer.vision()) + 1 ) {
+				if ( !jamming_cached[index] ) {
+					create_jamming_map(jamming_cache[index], teams[index]);
+					jamming_cached[index] = true;
+				}
+				sees = can_see(viewer, target_loc, &jamming_cache[index]);
+			}
+			if ( sees ) {
 				// Definitely use viewer as the second unit.
 				second_units[index] = &viewer;
 				distances[index] = 0;
 			}
 			else {
 				// Consider viewer as a backup if it is close.
-				size_t viewer_distance =
-					distance_between(target_loc, viewer.get_location());
 				if ( viewer_distance < distances[index] ) {
 					second_units[index] = &viewer;
 					distances[index] = viewer_distance;
@@ -726,10 +736,9 @@ void recalculate_fog(int side)
 	resources::screen->invalidate_all();
 
 	shroud_clearer clearer;
-	BOOST_FOREACH(const unit &u, *resources::units)
+	BOOST_FOREACH(const unit_map::const_unit_iterator &u, resources::units->units_of_side(side))
 	{
-		if ( u.side() == side )
-			clearer.clear_unit(u.get_location(), u, tm, &visible_locs);
+		clearer.clear_unit(u->get_location(), *u, tm, &visible_locs);
 	}
 	// Update the screen.
 	clearer.invalidate_after_clear();
@@ -762,10 +771,9 @@ bool clear_shroud(int side, bool reset_fog, bool fire_events)
 	bool result = false;
 
 	shroud_clearer clearer;
-	BOOST_FOREACH(const unit &u, *resources::units)
+	BOOST_FOREACH(const unit_map::const_unit_iterator &u, resources::units->units_of_side(side))
 	{
-		if ( u.side() == side )
-			result |= clearer.clear_unit(u.get_location(), u, tm);
+		result |= clearer.clear_unit(u->get_location(), *u, tm);
 	}
 	// Update the screen.
 	if ( result )
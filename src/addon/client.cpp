@@ -185,50 +185,67 @@ bool addons_client::delete_remote_addon(const std::string& id, std::string& resp
 	return !this->update_last_error(response_buf);
 }
 
-bool addons_client::download_addon(config& archive_cfg, const std::string& id, const std::string& title, bool increase_downloads)
+bool addons_client::download_addon(addon_unarchiver& archive, const std::string& id, const std::string& title, bool increase_downloads)
 {
-	archive_cfg.clear();
-
 	config request_buf;
 	config& request_body = request_buf.add_child("request_campaign");
 
 	request_body["name"] = id;
 	request_body["increase_downloads"] = increase_downloads;
 
+	if(is_addon_installed(id)) {
+		config info_cfg;
+		get_addon_install_info(id, info_cfg);
+		if(const config& info = info_cfg.child("info")) {
+			if(info["uploads"].to_int() > 0) {
+				request_body["from_uploads"] = info["uploads"];
+			}
+		}
+	}
+
 	utils::string_map i18n_symbols;
 	i18n_symbols["addon_title"] = title;
 
 	LOG_ADDONS << "downloading " << id << '\n';
 
-	this->send_request(request_buf, archive_cfg);
+	check_connected();
+	this->conn_->transfer(request_buf, archive);
 	this->wait_for_transfer_done(vgettext("Downloading add-on <i>$addon_title</i>...", i18n_symbols));
 
-	return !this->update_last_error(archive_cfg);
+	return !this->update_last_error(archive.info());
 }
 
-bool addons_client::install_addon(config& archive_cfg, const addon_info& info)
+bool addons_client::install_addon(addon_unarchiver& archive, const addon_info& info)
 {
 	const cursor::setter cursor_setter(cursor::WAIT);
 
 	utils::string_map i18n_symbols;
 	i18n_symbols["addon_title"] = info.title;
 
-	if(!check_names_legal(archive_cfg)) {
+	if(!archive.names_legal()) {
 		gui2::show_error_message(disp_.video(),
 			vgettext("The add-on <i>$addon_title</i> has an invalid file or directory "
 				"name and cannot be installed.", i18n_symbols));
 		return false;
 	}
 
-	// Add local version information before unpacking
-
-	config* maindir = &archive_cfg.find_child("dir", "name", info.id);
-	if(!*maindir) {
-		LOG_ADDONS << "downloaded add-on '" << info.id << "' is missing its directory in the archive; creating it\n";
-		maindir = &archive_cfg.add_child("dir");
-		(*maindir)["name"] = info.id;
+	const config& archive_cfg = archive.info();
+	const bool is_delta = archive_cfg.has_attribute("delta_from");
+	if(is_delta) {
+		config info_cfg;
+		get_addon_install_info(info.id, info_cfg);
+		if(info_cfg.child_or_empty("info")["uploads"] != archive_cfg["delta_from"]) {
+			ERR_ADDONS << "received changes to upload " << archive_cfg["delta_from"] << " of '"
+				<< info.id << "', which is not the one installed\n";
+			gui2::show_error_message(disp_.video(),
+				vgettext("The update of the add-on <i>$addon_title</i> does not match the "
+					"installed version and cannot be installed.", i18n_symbols));
+			return false;
+		}
 	}
 
+	// Add local version information before unpacking
+
 	LOG_ADDONS << "generating version info for add-on '" << info.id << "'\n";
 
 	std::ostringstream info_contents;
@@ -243,26 +260,22 @@ bool addons_client::install_addon(config& archive_cfg, const addon_info& info)
 	info.write_minimal(wml.add_child("info"));
 	write(info_contents, wml);
 
-	config file;
-	file["name"] = "_info.cfg";
-	file["contents"] = info_contents.str();
-
-	maindir->add_child("file", file);
+	// Also creates the add-on's directory if the archive is missing it.
+	archive.add_file(info.id + "/_info.cfg", info_contents.str());
 
-	LOG_ADDONS << "unpacking " << info.id << '\n';
+	LOG_ADDONS << "unpacking " << info.id << (is_delta ? " over the installed version" : "") << '\n';
 
-	// Remove any previously installed versions
-	if(!remove_local_addon(info.id)) {
-		WRN_ADDONS << "failed to uninstall previous version of " << info.id << "; the add-on may not work properly!" << std::endl;
+	if(!archive.commit(info.id)) {
+		gui2::show_error_message(disp_.video(),
+			vgettext("The add-on <i>$addon_title</i> could not be written to disk.", i18n_symbols));
+		return false;
 	}
-
-	unarchive_addon(archive_cfg);
 	LOG_ADDONS << "unpacking finished\n";
 
 	return true;
 }
 
-bool addons_client::update_last_error(config& response_cfg)
+bool addons_client::update_last_error(const config& response_cfg)
 {
 	if(config const &error = response_cfg.child("error")) {
 		this->last_error_ = error["message"].str();
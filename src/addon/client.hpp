@@ -21,6 +21,7 @@
 #include "network_asio.hpp"
 
 struct addon_info;
+class addon_unarchiver;
 
 /**
  * Add-ons (campaignd) client class.
@@ -82,25 +83,34 @@ public:
 	 *
 	 * @param id          Add-on id.
 	 * @param title       Add-on title, used for status display.
-	 * @param archive_cfg Config object to hold the downloaded add-on archive data.
+	 * @param archive     Unpacks the add-on files as they are parsed, and keeps the
+	 *                    rest of the server response.
 	 * @param increase_downloads Whether to request the server to increase the add-on's
 	 *                           download count or not (e.g. when upgrading).
+	 *
+	 * When the add-on is installed, the server may send only the changes
+	 * from the installed upload, with a @a delta_from attribute naming it.
+	 * install_addon() applies them over the installed files.
 	 */
-	bool download_addon(config& archive_cfg, const std::string& id, const std::string& title, bool increase_downloads = true);
+	bool download_addon(addon_unarchiver& archive, const std::string& id, const std::string& title, bool increase_downloads = true);
 
 	/**
-	 * Installs the specified add-on using an archive received from the server.
+	 * Installs the specified add-on from an archive received from the server,
+	 * moving the files @a archive has unpacked into place.
 	 *
 	 * An _info.cfg file will be added to the local directory for the add-on
 	 * to keep track of version and dependency information.
 	 *
+	 * A delta from download_addon() is applied to the installed version,
+	 * which must be the one it was made from.
+	 *
 	 * @todo FIXME Refactor this again once I figure out a better way
 	 * to not transfer so much information in the method signature! Perhaps
 	 * we'd reask the server for the add-ons list and extract the information
 	 * from there again, since there isn't any way to request info for a
 	 * single entry atm.
 	 */
-	bool install_addon(config& archive_cfg, const addon_info& info);
+	bool install_addon(addon_unarchiver& archive, const addon_info& info);
 
 	/**
 	 * Requests the specified add-on to be uploaded.
@@ -181,7 +191,7 @@ private:
 	 */
 	void wait_for_transfer_done(const std::string& status_message, bool track_upload = false);
 
-	bool update_last_error(config& response_cfg);
+	bool update_last_error(const config& response_cfg);
 };
 
 #endif
@@ -33,9 +33,11 @@
 #include "gui/dialogs/transient_message.hpp"
 #include "gui/widgets/settings.hpp"
 #include "gui/widgets/window.hpp"
+#include "hash.hpp"
 #include "log.hpp"
 #include "marked-up_text.hpp"
 #include "serialization/parser.hpp"
+#include "thread.hpp"
 #include "version.hpp"
 #include "wml_separators.hpp"
 #include "formula_string_utils.hpp"
@@ -288,14 +290,42 @@ static std::pair<std::vector<std::string>, std::vector<std::string> > read_ignor
 	return patterns;
 }
 
-static void archive_file(const std::string& path, const std::string& fname, config& cfg)
+namespace {
+	/** The files to archive, and the configs their contents go to. */
+	typedef std::vector<std::pair<std::string, config*> > archived_files;
+
+	/** Reads and encodes the files of an add-on. */
+	class archive_job : public threading::parallel_job
+	{
+	public:
+		explicit archive_job(const archived_files& files)
+			: files_(files)
+			, contents(files.size())
+		{
+		}
+
+		void run(size_t index)
+		{
+			const std::string& fname = files_[index].first;
+			const bool is_cfg = (fname.size() > 4 ? (fname.substr(fname.size() - 4) == ".cfg") : false);
+			contents[index] = encode_binary(strip_cr(filesystem::read_file(fname),is_cfg));
+		}
+
+	private:
+		const archived_files& files_;
+
+	public:
+		std::vector<std::string> contents;
+	};
+}
+
+static void archive_file(const std::string& path, const std::string& fname, config& cfg, archived_files& files)
 {
 	cfg["name"] = fname;
-	const bool is_cfg = (fname.size() > 4 ? (fname.substr(fname.size() - 4) == ".cfg") : false);
-	cfg["contents"] = encode_binary(strip_cr(filesystem::read_file(path + '/' + fname),is_cfg));
+	files.push_back(std::make_pair(path + '/' + fname, &cfg));
 }
 
-static void archive_dir(const std::string& path, const std::string& dirname, config& cfg, std::pair<std::vector<std::string>, std::vector<std::string> >& ignore_patterns)
+static void archive_dir(const std::string& path, const std::string& dirname, config& cfg, std::pair<std::vector<std::string>, std::vector<std::string> >& ignore_patterns, archived_files& archived)
 {
 	cfg["name"] = dirname;
 	const std::string dir = path + '/' + dirname;
@@ -311,7 +341,7 @@ static void archive_dir(const std::string& path, const std::string& dirname, con
 			}
 		}
 		if (valid) {
-			archive_file(dir,*i,cfg.add_child("file"));
+			archive_file(dir,*i,cfg.add_child("file"),archived);
 		}
 	}
 
@@ -324,7 +354,7 @@ static void archive_dir(const std::string& path, const std::string& dirname, con
 			}
 		}
 		if (valid) {
-			archive_dir(dir,*j,cfg.add_child("dir"),ignore_patterns);
+			archive_dir(dir,*j,cfg.add_child("dir"),ignore_patterns,archived);
 		}
 	}
 }
@@ -334,13 +364,21 @@ void archive_addon(const std::string& addon_name, config& cfg)
 	const std::string parentd = filesystem::get_addons_dir();
 
 	std::pair<std::vector<std::string>, std::vector<std::string> > ignore_patterns;
+	archived_files files;
 	// External .cfg may not exist; newer campaigns have a _main.cfg
 	const std::string external_cfg = addon_name + ".cfg";
 	if (filesystem::file_exists(parentd + "/" + external_cfg)) {
-		archive_file(parentd, external_cfg, cfg.add_child("file"));
+		archive_file(parentd, external_cfg, cfg.add_child("file"), files);
 	}
 	ignore_patterns = read_ignore_patterns(addon_name);
-	archive_dir(parentd, addon_name, cfg.add_child("dir"), ignore_patterns);
+	archive_dir(parentd, addon_name, cfg.add_child("dir"), ignore_patterns, files);
+
+	// The files are read in parallel, but the configs are only set here.
+	archive_job job(files);
+	threading::run_parallel(job, files.size());
+	for(size_t i = 0; i != files.size(); ++i) {
+		(*files[i].second)["contents"] = job.contents[i];
+	}
 }
 
 static void unarchive_file(const std::string& path, const config& cfg)
@@ -358,6 +396,16 @@ static void unarchive_dir(const std::string& path, const config& cfg)
 
 	filesystem::make_directory(dir);
 
+	// Deltas name the files and directories their version no longer has.
+	BOOST_FOREACH(const config &r, cfg.child_range("remove")) {
+		const std::string target = dir + '/' + r["name"].str();
+		if (filesystem::is_directory(target)) {
+			filesystem::delete_directory(target);
+		} else {
+			filesystem::delete_file(target);
+		}
+	}
+
 	BOOST_FOREACH(const config &d, cfg.child_range("dir")) {
 		unarchive_dir(dir, d);
 	}
@@ -373,6 +421,298 @@ void unarchive_addon(const config& cfg)
 	unarchive_dir(parentd, cfg);
 }
 
+namespace {
+	/** Files waiting to be written are written once they are this large. */
+	const size_t max_pending_size = 16 * 1024 * 1024;
+}
+
+/** Writes a batch of files, linking them to the store. */
+class addon_unarchiver::write_job : public threading::parallel_job
+{
+public:
+	write_job(const std::string& staging_dir, const std::string& store_dir, const std::deque<pending_file>& files)
+		: staging_dir_(staging_dir)
+		, store_dir_(store_dir)
+		, files_(files)
+		, failed_(files.size(), false)
+	{
+	}
+
+	void run(size_t index)
+	{
+		const pending_file& file = files_[index];
+		const std::string path = staging_dir_ + '/' + file.path;
+		const std::string stored = store_dir_ + '/' + file.hash;
+
+		// A file edited in place changes its copy in the store too; this
+		// catches most of those edits.
+		if(filesystem::file_exists(stored)
+				&& filesystem::file_size(stored) == static_cast<int>(file.contents.size())
+				&& filesystem::hard_link_file(stored, path)) {
+			return;
+		}
+
+		try {
+			filesystem::write_file(path, file.contents);
+		} catch(filesystem::io_exception& e) {
+			ERR_FS << "could not write " << path << ": " << e.what() << '\n';
+			failed_[index] = true;
+			return;
+		}
+		filesystem::hard_link_file(path, stored);
+	}
+
+	bool failed() const
+	{
+		return std::find(failed_.begin(), failed_.end(), true) != failed_.end();
+	}
+
+private:
+	const std::string& staging_dir_;
+	const std::string& store_dir_;
+	const std::deque<pending_file>& files_;
+	/** Not a vector<bool>, whose elements can't be set by different threads. */
+	std::vector<char> failed_;
+};
+
+addon_unarchiver::addon_unarchiver()
+	: staging_dir_(filesystem::get_addons_dir() + "/.unpacking")
+	, store_dir_(filesystem::get_addons_dir() + "/.store")
+	, stack_(1, frame(frame::ROOT_TAG))
+	, pending_()
+	, pending_size_(0)
+	, removals_()
+	, info_()
+	, names_legal_(true)
+	, write_failed_(false)
+{
+	// Left over by an installation that was interrupted.
+	if(filesystem::file_exists(staging_dir_)) {
+		filesystem::delete_directory(staging_dir_);
+	}
+	filesystem::make_directory(staging_dir_);
+	filesystem::make_directory(store_dir_);
+}
+
+addon_unarchiver::~addon_unarchiver()
+{
+	if(filesystem::file_exists(staging_dir_)) {
+		filesystem::delete_directory(staging_dir_);
+	}
+}
+
+bool addon_unarchiver::open_tag(const std::string& tag, bool append)
+{
+	const frame& top = stack_.back();
+	if(top.type == frame::ROOT_TAG || top.type == frame::DIR_TAG) {
+		if(tag == "dir" || tag == "file" || tag == "remove") {
+			make_directories();
+			stack_.push_back(frame(tag == "dir" ? frame::DIR_TAG
+				: tag == "file" ? frame::FILE_TAG : frame::REMOVE_TAG));
+			return true;
+		} else if(top.type == frame::DIR_TAG) {
+			return false;
+		}
+	} else if(top.type != frame::OTHER_TAG) {
+		return false;
+	}
+
+	config& parent = top.type == frame::OTHER_TAG ? *top.cfg : info_;
+	config& child = append && parent.has_child(tag) ? parent.child(tag, -1) : parent.add_child(tag);
+	stack_.push_back(frame(frame::OTHER_TAG, &child));
+	return true;
+}
+
+void addon_unarchiver::close_tag(const std::string& /*tag*/)
+{
+	const frame& top = stack_.back();
+	if(top.type == frame::DIR_TAG) {
+		// Creates the empty directories.
+		make_directories();
+	} else if(top.type == frame::FILE_TAG || top.type == frame::REMOVE_TAG) {
+		const std::string dir = current_dir();
+		const std::string path = dir.empty() ? top.name : dir + '/' + top.name;
+		if(!addon_filename_legal(top.name)) {
+			names_legal_ = false;
+		} else if(top.type == frame::FILE_TAG) {
+			queue_file(path, unencode_binary(top.contents));
+		} else {
+			removals_.push_back(path);
+		}
+	}
+	stack_.pop_back();
+}
+
+void addon_unarchiver::attribute(const std::string& key, const config::attribute_value& value)
+{
+	frame& top = stack_.back();
+	switch(top.type) {
+	case frame::ROOT_TAG:
+		info_[key] = value;
+		break;
+	case frame::OTHER_TAG:
+		(*top.cfg)[key] = value;
+		break;
+	case frame::FILE_TAG:
+		if(key == "contents") {
+			top.contents = value.str();
+			break;
+		}
+		// fall through
+	default:
+		if(key == "name") {
+			top.name = value.str();
+		}
+	}
+}
+
+void addon_unarchiver::add_file(const std::string& name, const std::string& contents)
+{
+	std::string dir = staging_dir_;
+	const std::vector<std::string> dirs = utils::split(name, '/');
+	for(size_t i = 0; i + 1 < dirs.size(); ++i) {
+		dir += '/' + dirs[i];
+		filesystem::make_directory(dir);
+	}
+	queue_file(name, contents);
+}
+
+void addon_unarchiver::queue_file(const std::string& path, const std::string& contents)
+{
+	if(!names_legal_) {
+		return;
+	}
+
+	pending_.push_back(pending_file());
+	pending_file& file = pending_.back();
+	file.path = path;
+	file.contents = contents;
+	file.hash = util::content_hash_hex(contents);
+
+	pending_size_ += contents.size();
+	if(pending_size_ >= max_pending_size) {
+		flush();
+	}
+}
+
+std::string addon_unarchiver::current_dir() const
+{
+	std::string res;
+	BOOST_FOREACH(const frame& f, stack_) {
+		if(f.type == frame::DIR_TAG) {
+			if(!res.empty()) {
+				res += '/';
+			}
+			res += f.name;
+		}
+	}
+	return res;
+}
+
+void addon_unarchiver::make_directories()
+{
+	std::string dir = staging_dir_;
+	BOOST_FOREACH(frame& f, stack_) {
+		if(f.type != frame::DIR_TAG) {
+			continue;
+		}
+		dir += '/' + f.name;
+		if(!f.created && names_legal_) {
+			if(!addon_filename_legal(f.name)) {
+				names_legal_ = false;
+				return;
+			}
+			filesystem::make_directory(dir);
+			f.created = true;
+		}
+	}
+}
+
+void addon_unarchiver::flush()
+{
+	if(pending_.empty()) {
+		return;
+	}
+
+	write_job job(staging_dir_, store_dir_, pending_);
+	threading::run_parallel(job, pending_.size());
+	if(job.failed()) {
+		write_failed_ = true;
+	}
+
+	pending_.clear();
+	pending_size_ = 0;
+}
+
+bool addon_unarchiver::commit(const std::string& addon)
+{
+	flush();
+	if(!names_legal_ || write_failed_) {
+		return false;
+	}
+
+	// Remove any previously installed versions, unless only the changes
+	// to it were received
+	if(!info_.has_attribute("delta_from") && !remove_local_addon(addon)) {
+		WRN_CFG << "failed to uninstall previous version of " << addon << "; the add-on may not work properly!" << std::endl;
+	}
+
+	const std::string parentd = filesystem::get_addons_dir();
+	BOOST_FOREACH(const std::string& name, removals_) {
+		const std::string target = parentd + '/' + name;
+		if(filesystem::is_directory(target)) {
+			filesystem::delete_directory(target);
+		} else if(filesystem::file_exists(target)) {
+			filesystem::delete_file(target);
+		}
+	}
+
+	const bool moved = merge_directory(staging_dir_, parentd);
+	prune_store();
+	return moved;
+}
+
+bool addon_unarchiver::merge_directory(const std::string& from, const std::string& to)
+{
+	bool ret = true;
+	std::vector<std::string> files, dirs;
+	filesystem::get_files_in_dir(from, &files, &dirs);
+
+	BOOST_FOREACH(const std::string& f, files) {
+		const std::string target = to + '/' + f;
+		if(filesystem::is_directory(target)) {
+			filesystem::delete_directory(target);
+		} else if(filesystem::file_exists(target)) {
+			filesystem::delete_file(target);
+		}
+		ret = filesystem::rename_file(from + '/' + f, target) && ret;
+	}
+
+	BOOST_FOREACH(const std::string& d, dirs) {
+		const std::string target = to + '/' + d;
+		if(filesystem::is_directory(target)) {
+			ret = merge_directory(from + '/' + d, target) && ret;
+			continue;
+		} else if(filesystem::file_exists(target)) {
+			filesystem::delete_file(target);
+		}
+		ret = filesystem::rename_file(from + '/' + d, target) && ret;
+	}
+
+	return ret;
+}
+
+void addon_unarchiver::prune_store()
+{
+	std::vector<std::string> files;
+	filesystem::get_files_in_dir(store_dir_, &files, NULL, filesystem::ENTIRE_FILE_PATH);
+	BOOST_FOREACH(const std::string& f, files) {
+		if(filesystem::hard_link_count(f) <= 1) {
+			filesystem::delete_file(f);
+		}
+	}
+}
+
 namespace {
 	std::map< std::string, version_info > version_info_cache;
 } // end unnamed namespace 5
@@ -20,7 +20,11 @@ class config;
 class version_info;
 
 #include "addon/validation.hpp"
+#include "serialization/parser.hpp"
 
+#include <boost/noncopyable.hpp>
+
+#include <deque>
 #include <string>
 #include <vector>
 #include <utility>
@@ -108,9 +112,119 @@ bool is_addon_installed(const std::string& addon_name);
 /** Archives an add-on into a config object for campaignd transactions. */
 void archive_addon(const std::string& addon_name, class config& cfg);
 
-/** Unarchives an add-on from campaignd's retrieved config object. */
+/**
+ * Unarchives an add-on from campaignd's retrieved config object.
+ *
+ * This also applies the deltas campaignd sends to update an installed
+ * add-on: their [remove] children are deleted before the files are written.
+ */
 void unarchive_addon(const class config& cfg);
 
+/**
+ * Unarchives an add-on from campaignd's response as it is parsed, without
+ * building a config of the whole archive.
+ *
+ * The files are written by a few threads at a time to a staging directory,
+ * and only replace the installed version once commit() is called. A file
+ * with the same contents as one installed earlier, by any add-on, becomes
+ * another name of that file instead of a copy: the add-ons share a store of
+ * hard links, where it is supported.
+ *
+ * What isn't part of the archived tree (the attributes of the response,
+ * such as delta_from, and children such as [error]) is kept in info().
+ */
+class addon_unarchiver : public wml_event_handler, private boost::noncopyable
+{
+public:
+	addon_unarchiver();
+	~addon_unarchiver();
+
+	bool open_tag(const std::string& tag, bool append);
+	void close_tag(const std::string& tag);
+	void attribute(const std::string& key, const config::attribute_value& value);
+
+	/** The response received, without its files and directories. */
+	const config& info() const { return info_; }
+
+	/** Whether the archive only had legal names, see check_names_legal(). */
+	bool names_legal() const { return names_legal_; }
+
+	/**
+	 * Adds a file to the archive received.
+	 *
+	 * @param name                The path of the file, relative to the
+	 *                            add-ons directory.
+	 * @param contents            Its contents.
+	 */
+	void add_file(const std::string& name, const std::string& contents);
+
+	/**
+	 * Moves the add-on received to the add-ons directory.
+	 *
+	 * The installed version of @a addon is removed first, unless the
+	 * archive only contains the changes to it and the files to remove.
+	 *
+	 * @returns                   False if some files could not be written.
+	 */
+	bool commit(const std::string& addon);
+
+private:
+	/** A tag of the response being read. */
+	struct frame
+	{
+		enum kind { ROOT_TAG, DIR_TAG, FILE_TAG, REMOVE_TAG, OTHER_TAG };
+
+		explicit frame(kind k, config* c = NULL)
+			: type(k), name(), contents(), cfg(c), created(k == ROOT_TAG)
+		{}
+
+		kind type;
+		std::string name;
+		/** The encoded contents of a [file]. */
+		std::string contents;
+		/** The config of info() an OTHER_TAG is read into. */
+		config* cfg;
+		/** Whether a directory exists in the staging one. */
+		bool created;
+	};
+
+	/** A file waiting to be written, its path relative to the staging directory. */
+	struct pending_file
+	{
+		std::string path, contents, hash;
+	};
+
+	class write_job;
+
+	/** The path of the directory at the top of the stack, relative to the staging one. */
+	std::string current_dir() const;
+
+	/** Queues a file for flush(), @a path being relative to the staging directory. */
+	void queue_file(const std::string& path, const std::string& contents);
+
+	/** Creates the directories of the stack not created yet. */
+	void make_directories();
+
+	/** Writes the files waiting in pending_. */
+	void flush();
+
+	/** Moves the contents of @a from into @a to, replacing what is there. */
+	bool merge_directory(const std::string& from, const std::string& to);
+
+	/** Deletes the files of the store no add-on uses any more. */
+	void prune_store();
+
+	std::string staging_dir_, store_dir_;
+	std::vector<frame> stack_;
+	std::deque<pending_file> pending_;
+	size_t pending_size_;
+	/** The files and directories a delta removes, relative to the add-ons directory. */
+	std::vector<std::string> removals_;
+	config info_;
+	bool names_legal_;
+	bool write_failed_;
+};
+
 /** Refreshes the per-session cache of add-on's version information structs. */
 void refresh_addon_version_info_cache();
 
@@ -119,7 +119,7 @@ std::string describe_addon_status(const addon_tracking_info& info)
 // Asks the client to download and install an addon, reporting errors in a gui dialog. Returns true if new content was installed, false otherwise.
 static bool try_fetch_addon(display & disp, addons_client & client, const addon_info & addon)
 {
-	config archive;
+	addon_unarchiver archive;
 
 	if(!(
 		client.download_addon(archive, addon.id, addon.title, !is_addon_installed(addon.id)) &&
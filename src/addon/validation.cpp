@@ -74,6 +74,9 @@ bool check_names_legal(const config& dir)
 	BOOST_FOREACH(const config &path, dir.child_range("file")) {
 		if (!addon_filename_legal(path["name"])) return false;
 	}
+	BOOST_FOREACH(const config &path, dir.child_range("remove")) {
+		if (!addon_filename_legal(path["name"])) return false;
+	}
 	BOOST_FOREACH(const config &path, dir.child_range("dir")) {
 		if (!addon_filename_legal(path["name"])) return false;
 		if (!check_names_legal(path)) return false;
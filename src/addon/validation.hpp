@@ -64,7 +64,7 @@ std::string get_addon_type_string(ADDON_TYPE type);
 bool addon_name_legal(const std::string& name);
 /** Checks whether an add-on file name is legal or not. */
 bool addon_filename_legal(const std::string& name);
-/** Probes an add-on archive for illegal names. */
+/** Probes an add-on archive, or the delta to update one, for illegal names. */
 bool check_names_legal(const config& dir);
 
 std::string encode_binary(const std::string& str);
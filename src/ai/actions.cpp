@@ -39,6 +39,9 @@
 #include "../actions/attack.hpp"
 #include "../actions/create.hpp"
 #include "../attack_prediction.hpp"
+#include "../game_board.hpp"
+#include "../game_events/manager.hpp"
+#include "../game_events/pump.hpp"
 #include "../game_preferences.hpp"
 #include "../log.hpp"
 #include "../mouse_handler_base.hpp"
@@ -61,6 +64,16 @@ static lg::log_domain log_ai_actions("ai/actions");
 #define WRN_AI_ACTIONS LOG_STREAM(warn, log_ai_actions)
 #define ERR_AI_ACTIONS LOG_STREAM(err, log_ai_actions)
 
+/** What recruiting or recalling a unit at @a loc changes, unless WML runs. */
+static int recruit_changes(const map_location& loc)
+{
+	int changes = gamestate_change::SIDE_UNITS | gamestate_change::GOLD;
+	if (resources::gameboard->map().is_village(loc)) {
+		changes |= gamestate_change::VILLAGES;
+	}
+	return changes;
+}
+
 // =======================================================================
 // AI ACTIONS
 // =======================================================================
@@ -283,6 +296,8 @@ void attack_result::do_execute()
 		return;
 	}
 
+	const size_t wml_track = resources::game_events->pump().wml_tracking();
+
 	//to get rid of an unused member variable warning, FIXME: find a way to 'ask' the ai which advancement should be chosen from synced_commands.cpp .
 	if(synced_context::get_synced_state() != synced_context::SYNCED) //RAII block for set_scontext_synced
 	{
@@ -308,7 +323,12 @@ void attack_result::do_execute()
 	get_info().recent_attacks.insert(defender_loc_);
 	//end of ugly hack
 	try {
-		manager::raise_gamestate_changed();
+		if (wml_track == resources::game_events->pump().wml_tracking()) {
+			manager::raise_gamestate_changed(gamestate_change(get_side(),
+				gamestate_change::SIDE_UNITS | gamestate_change::OTHER_UNITS));
+		} else {
+			manager::raise_gamestate_changed();
+		}
 	} catch (...) {
 		if (!is_ok()) { DBG_AI_ACTIONS << "Return value of AI ACTION was not checked. This may cause bugs! " << std::endl; } //Demotes to DBG "unchecked result" warning
 		throw;
@@ -465,6 +485,7 @@ void move_result::do_execute()
 
 	::actions::move_unit_spectator move_spectator(*resources::units);
 	move_spectator.set_unit(resources::units->find(from_));
+	const size_t wml_track = resources::game_events->pump().wml_tracking();
 
 	if (from_ != to_) {
 		size_t num_steps = ::actions::move_unit_and_record(
@@ -505,9 +526,23 @@ void move_result::do_execute()
 	has_ambusher_ = move_spectator.get_ambusher().valid();
 	has_interrupted_teleport_ = move_spectator.get_failed_teleport().valid();
 
+	// Whether only the moved unit changed, so that the AI can update what
+	// depends on unit positions (such as its move maps) incrementally.
+	const bool only_unit_moved = unit_location_.valid() &&
+		!has_ambusher_ && !has_interrupted_teleport_ &&
+		move_spectator.get_seen_enemies().empty() &&
+		move_spectator.get_seen_friends().empty() &&
+		!(*resources::teams)[get_side()-1].uses_shroud() &&
+		!resources::gameboard->map().is_village(unit_location_) &&
+		wml_track == resources::game_events->pump().wml_tracking();
+
 	if (is_gamestate_changed()) {
 		try {
-			manager::raise_gamestate_changed();
+			if (only_unit_moved) {
+				manager::raise_unit_moved(from_, unit_location_);
+			} else {
+				manager::raise_gamestate_changed();
+			}
 		} catch (...) {
 			if (!is_ok()) { DBG_AI_ACTIONS << "Return value of AI ACTION was not checked. This may cause bugs! " << std::endl; } //Demotes to DBG "unchecked result" warning
 			throw;
@@ -651,6 +686,7 @@ void recall_result::do_execute()
 	// Do the actual recalling.
 	// We ignore possible errors (=unit doesn't exist on the recall list)
 	// because that was the previous behavior.
+	const size_t wml_track = resources::game_events->pump().wml_tracking();
 	synced_context::run_in_synced_context_if_not_already("recall",
 		replay_helper::get_recall(unit_id_, recall_location_, recall_from_),
 		false,
@@ -659,7 +695,11 @@ void recall_result::do_execute()
 
 	set_gamestate_changed();
 	try {
-		manager::raise_gamestate_changed();
+		if (wml_track == resources::game_events->pump().wml_tracking()) {
+			manager::raise_gamestate_changed(gamestate_change(get_side(), recruit_changes(recall_location_)));
+		} else {
+			manager::raise_gamestate_changed();
+		}
 	} catch (...) {
 		if (!is_ok()) { DBG_AI_ACTIONS << "Return value of AI ACTION was not checked. This may cause bugs! " << std::endl; } //Demotes to DBG "unchecked result" warning
 		throw;
@@ -801,6 +841,7 @@ void recruit_result::do_execute()
 		return;
 	}
 
+	const size_t wml_track = resources::game_events->pump().wml_tracking();
 	synced_context::run_in_synced_context_if_not_already("recruit", replay_helper::get_recruit(u->id(), recruit_location_, recruit_from_), false, preferences::show_ai_moves());
 	//TODO: should we do something to pass use_undo = false in replays and ai moves ?
 	//::actions::recruit_unit(*u, get_side(), recruit_location_, recruit_from_,
@@ -808,7 +849,11 @@ void recruit_result::do_execute()
 
 	set_gamestate_changed();
 	try {
-		manager::raise_gamestate_changed();
+		if (wml_track == resources::game_events->pump().wml_tracking()) {
+			manager::raise_gamestate_changed(gamestate_change(get_side(), recruit_changes(recruit_location_)));
+		} else {
+			manager::raise_gamestate_changed();
+		}
 	} catch (...) {
 		if (!is_ok()) { DBG_AI_ACTIONS << "Return value of AI ACTION was not checked. This may cause bugs! " << std::endl; } //Demotes to DBG "unchecked result" warning
 		throw;
@@ -908,12 +953,12 @@ void stopunit_result::do_execute()
 		if (remove_movement_){
 			un->remove_movement_ai();
 			set_gamestate_changed();
-			manager::raise_gamestate_changed();
+			manager::raise_unit_moved(unit_location_, unit_location_);
 		}
 		if (remove_attacks_){
 			un->remove_attacks_ai();
 			set_gamestate_changed();
-			manager::raise_gamestate_changed();//to be on the safe side
+			manager::raise_gamestate_changed(gamestate_change(get_side(), gamestate_change::SIDE_UNITS));
 		}
 	} catch (...) {
 		if (!is_ok()) { DBG_AI_ACTIONS << "Return value of AI ACTION was not checked. This may cause bugs! " << std::endl; } //Demotes to DBG "unchecked result" warning
@@ -19,6 +19,9 @@
 #include "aspect.hpp"
 #include "../manager.hpp"
 #include "../../log.hpp"
+#include "../../serialization/string_utils.hpp"
+
+#include <boost/foreach.hpp>
 
 namespace ai {
 
@@ -28,12 +31,39 @@ static lg::log_domain log_ai_aspect("ai/aspect");
 #define WRN_AI_ASPECT LOG_STREAM(warn, log_ai_aspect)
 #define ERR_AI_ASPECT LOG_STREAM(err, log_ai_aspect)
 
+aspect::statistics aspect::statistics_;
+
+/** The dependency flags named in a depends_on= key. */
+static int parse_dependencies(const std::string& depends_on)
+{
+	int res = 0;
+	BOOST_FOREACH(const std::string& name, utils::split(depends_on)) {
+		if (name == "turn") {
+			res |= aspect::DEPENDS_ON_TURN;
+		} else if (name == "own_units") {
+			res |= aspect::DEPENDS_ON_OWN_UNITS;
+		} else if (name == "enemy_units") {
+			res |= aspect::DEPENDS_ON_ENEMY_UNITS;
+		} else if (name == "units") {
+			res |= aspect::DEPENDS_ON_OWN_UNITS | aspect::DEPENDS_ON_ENEMY_UNITS;
+		} else if (name == "gold") {
+			res |= aspect::DEPENDS_ON_GOLD;
+		} else if (name == "villages") {
+			res |= aspect::DEPENDS_ON_VILLAGES;
+		} else {
+			ERR_AI_ASPECT << "unknown aspect dependency: " << name << std::endl;
+		}
+	}
+	return res;
+}
+
 aspect::aspect(readonly_context &context, const config &cfg, const std::string &id):
 	valid_(false), valid_variant_(false), valid_lua_(false), cfg_(cfg),
 	invalidate_on_turn_start_(cfg["invalidate_on_turn_start"].to_bool(true)),
 	invalidate_on_tod_change_(cfg["invalidate_on_tod_change"].to_bool(true)),
 	invalidate_on_gamestate_change_(cfg["invalidate_on_gamestate_change"].to_bool()),
 	invalidate_on_minor_gamestate_change_(cfg["invalidate_on_minor_gamestate_change"].to_bool()),
+	depends_on_(cfg["depends_on"]), dependencies_(parse_dependencies(depends_on_)),
 	engine_(cfg["engine"]), name_(cfg["name"]), id_(id)
 	{
 		DBG_AI_ASPECT << "creating new aspect: engine=["<<engine_<<"], name=["<<name_<<"], id=["<<id_<<"]"<< std::endl;
@@ -51,7 +81,7 @@ aspect::~aspect()
 			///@todo 1.9 add tod_changed_observer
 			//manager::remove_tod_changed_observer(this);
 		}
-		if (invalidate_on_gamestate_change_) {
+		if (invalidate_on_gamestate_change_ || dependencies_) {
 			manager::remove_gamestate_observer(this);
 		}
 		if (invalidate_on_minor_gamestate_change_) {
@@ -78,7 +108,7 @@ bool aspect::redeploy(const config &cfg, const std::string& /*id*/)
 		///@todo 1.9 add tod_changed_observer
 		//manager::remove_tod_changed_observer(this);
 	}
-	if (invalidate_on_gamestate_change_) {
+	if (invalidate_on_gamestate_change_ || dependencies_) {
 		manager::remove_gamestate_observer(this);
 	}
 	if (invalidate_on_minor_gamestate_change_) {
@@ -94,6 +124,8 @@ bool aspect::redeploy(const config &cfg, const std::string& /*id*/)
 	invalidate_on_tod_change_ = cfg["invalidate_on_tod_change"].to_bool(true);
 	invalidate_on_gamestate_change_ = cfg["invalidate_on_gamestate_change"].to_bool();
 	invalidate_on_minor_gamestate_change_ = cfg["invalidate_on_minor_gamestate_change"].to_bool();
+	depends_on_ = cfg["depends_on"].str();
+	dependencies_ = parse_dependencies(depends_on_);
 	engine_ = cfg["engine"].str();
 	name_ = cfg["name"].str();
 	id_ = cfg["id"].str();
@@ -105,7 +137,7 @@ bool aspect::redeploy(const config &cfg, const std::string& /*id*/)
 		///@todo 1.9 add tod_changed_observer
 		//manager::add_tod_changed_observer(this);
 	}
-	if (invalidate_on_gamestate_change_) {
+	if (invalidate_on_gamestate_change_ || dependencies_) {
 		manager::add_gamestate_observer(this);
 	}
 	if (invalidate_on_minor_gamestate_change_) {
@@ -122,6 +154,9 @@ config aspect::to_config() const
 	cfg["invalidate_on_tod_change"] = invalidate_on_tod_change_;
 	cfg["invalidate_on_gamestate_change"] = invalidate_on_gamestate_change_;
 	cfg["invalidate_on_minor_gamestate_change"] = invalidate_on_minor_gamestate_change_;
+	if (!depends_on_.empty()) {
+		cfg["depends_on"] = depends_on_;
+	}
 	cfg["engine"] = engine_;
 	cfg["name"] = name_;
 	cfg["id"] = id_;
@@ -129,6 +164,51 @@ config aspect::to_config() const
 }
 
 
+void aspect::handle_generic_event(const std::string &event_name)
+{
+	if (event_name == "ai_gamestate_changed" && !invalidate_on_gamestate_change_ &&
+			!affected_by(manager::get_gamestate_change())) {
+		++statistics_.kept;
+		return;
+	}
+	invalidate();
+}
+
+void aspect::add_dependencies(int dependencies)
+{
+	if ((dependencies & ~dependencies_) == 0) {
+		return;
+	}
+	if (!dependencies_ && !invalidate_on_gamestate_change_) {
+		manager::add_gamestate_observer(this);
+	}
+	dependencies_ |= dependencies;
+}
+
+bool aspect::affected_by(const gamestate_change* change) const
+{
+	if (!change) {
+		return dependencies_ != DEPENDS_ON_TURN;
+	}
+
+	// Seen from the side of this aspect.
+	const bool own = change->side == get_side();
+	int affected = 0;
+	if (change->changes & gamestate_change::SIDE_UNITS) {
+		affected |= own ? DEPENDS_ON_OWN_UNITS : DEPENDS_ON_ENEMY_UNITS;
+	}
+	if (change->changes & gamestate_change::OTHER_UNITS) {
+		affected |= own ? DEPENDS_ON_ENEMY_UNITS : DEPENDS_ON_OWN_UNITS | DEPENDS_ON_ENEMY_UNITS;
+	}
+	if (own && (change->changes & gamestate_change::GOLD)) {
+		affected |= DEPENDS_ON_GOLD;
+	}
+	if (change->changes & gamestate_change::VILLAGES) {
+		affected |= DEPENDS_ON_VILLAGES;
+	}
+	return (dependencies_ & affected) != 0;
+}
+
 bool aspect::delete_all_facets()
 {
 	return false;
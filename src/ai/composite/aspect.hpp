@@ -23,6 +23,7 @@
 #include "value_translator.hpp"
 #include "../lua/lua_object.hpp"
 #include "../lua/core.hpp"
+#include "../profiler.hpp"
 #include "../../scripting/game_lua_kernel.hpp"
 
 #include "../../log.hpp"
@@ -38,6 +39,8 @@
 
 namespace ai {
 
+struct gamestate_change;
+
 class aspect : public readonly_context_proxy, public events::observer, public component {
 public:
 	aspect(readonly_context &context, const config &cfg, const std::string &id);
@@ -73,10 +76,47 @@ public:
 	virtual bool delete_all_facets();
 
 
-	void handle_generic_event(const std::string &/*event_name*/)
-	{
-		invalidate();
-	}
+	/**
+	 * Invalidates the aspect, unless the game state changed in a way its
+	 * dependencies say it does not care about.
+	 */
+	void handle_generic_event(const std::string &event_name);
+
+
+	/**
+	 * What the value of an aspect depends on, as given by its depends_on=
+	 * key. With dependencies, the aspect is invalidated on each change of
+	 * the game state made by the AI that may affect them, on top of the
+	 * usual invalidation at the start of each turn; "turn" alone keeps the
+	 * value for the whole turn.
+	 */
+	enum dependency {
+		DEPENDS_ON_TURN = 1,
+		DEPENDS_ON_OWN_UNITS = 2,
+		DEPENDS_ON_ENEMY_UNITS = 4,
+		DEPENDS_ON_GOLD = 8,
+		DEPENDS_ON_VILLAGES = 16
+	};
+
+	/** Adds @a dependencies, such as those of a facet, to those of the aspect. */
+	void add_dependencies(int dependencies);
+
+	int get_dependencies() const
+	{ return dependencies_; }
+
+
+	/** How often the values of all aspects were asked for. */
+	struct statistics {
+		statistics() : hits(0), misses(0), kept(0) {}
+
+		/** Values that were still valid, and those that got recalculated. */
+		size_t hits, misses;
+		/** Changes of the game state that did not invalidate a dependent aspect. */
+		size_t kept;
+	};
+
+	static const statistics& get_statistics()
+	{ return statistics_; }
 
 
 	virtual bool active() const
@@ -96,6 +136,11 @@ public:
 	static lg::log_domain& log();
 
 protected:
+	/** Whether a change of the game state, NULL if unknown, affects the dependencies. */
+	bool affected_by(const gamestate_change* change) const;
+
+	static statistics statistics_;
+
 	mutable bool valid_;
 	mutable bool valid_variant_;
 	mutable bool valid_lua_;
@@ -105,6 +150,8 @@ protected:
 	bool invalidate_on_tod_change_;
 	bool invalidate_on_gamestate_change_;
 	bool invalidate_on_minor_gamestate_change_;
+	std::string depends_on_;
+	int dependencies_;
 	std::string engine_;
 	std::string name_;
 	std::string id_;
@@ -142,6 +189,8 @@ public:
 	{
 		if (!valid_variant_) {
 			if (!valid_) {
+				++statistics_.misses;
+				const profiler::scope timer(profiler::ASPECT, this->get_side(), this->get_id());
 				recalculate();
 			}
 
@@ -155,6 +204,8 @@ public:
 			} else {
 				assert(valid_variant_);
 			}
+		} else {
+			++statistics_.hits;
 		}
 		return value_variant_;
 	}
@@ -166,6 +217,8 @@ public:
 	{
 		if (!valid_) {
 			if (!(valid_variant_ || valid_lua_)) {
+				++statistics_.misses;
+				const profiler::scope timer(profiler::ASPECT, this->get_side(), this->get_id());
 				recalculate();
 			}
 
@@ -180,6 +233,8 @@ public:
 					assert(valid_);
 				}
 			}
+		} else {
+			++statistics_.hits;
 		}
 		return value_;
 	}
@@ -336,6 +391,10 @@ public:
 		BOOST_FOREACH(aspect_ptr a, facets ){
 			typename aspect_type<T>::typesafe_ptr b = boost::dynamic_pointer_cast< typesafe_aspect<T> > (a);
 			facets_.insert(facets_.begin()+pos+j,b);
+			if (b) {
+				// The facets are only asked for when this is recalculated.
+				this->add_dependencies(b->get_dependencies());
+			}
 			j++;
 		}
 		return (j>0);
@@ -279,10 +279,11 @@ void protect_goal::add_targets(std::back_insert_iterator< std::vector< target >
 	// Look for directions to protect a specific location or specific unit.
 	BOOST_FOREACH(const map_location &loc, items)
 	{
-		BOOST_FOREACH(const unit &u, units)
+		BOOST_FOREACH(const unit_map::const_unit_iterator &i, units.units_in_radius(loc, radius_ - 1))
 		{
+			const unit &u = *i;
 			int distance = distance_between(u.get_location(), loc);
-			if (current_team().is_enemy(u.side()) && distance < radius_ &&
+			if (current_team().is_enemy(u.side()) &&
 			    !u.invisible(u.get_location()))
 			{
 				DBG_AI_GOAL << "side " << get_side() << ": in " << goal_type << ": found threat target. " << u.get_location() << " is a threat to "<< loc << '\n';
@@ -61,6 +61,21 @@ public:
 	 */
 	virtual void execute() = 0;
 
+	/**
+	 * Whether evaluate() may run at the same time as the evaluate() of
+	 * other candidate actions, in another thread. It must then only read
+	 * the game state and the context, and only values computed before by
+	 * prepare_concurrent_evaluation(), and must not log.
+	 */
+	virtual bool is_thread_safe() const
+	{ return false; }
+
+	/**
+	 * Called in the main thread before a concurrent evaluate(), to compute
+	 * the lazily calculated values (aspects, move maps...) it reads.
+	 */
+	virtual void prepare_concurrent_evaluation() {}
+
 	/**
 	 * Is this candidate action enabled ?
 	 */
@@ -210,6 +210,8 @@ readonly_context_impl::readonly_context_impl(side_context &context, const config
 		leader_value_(),
 		move_maps_enemy_valid_(false),
 		move_maps_valid_(false),
+		power_projection_cache_(),
+		enemy_power_projection_cache_(),
 		dst_src_valid_lua_(false),
 		dst_src_enemy_valid_lua_(false),
 		src_dst_valid_lua_(false),
@@ -324,7 +326,12 @@ readonly_context_impl::~readonly_context_impl()
 
 void readonly_context_impl::handle_generic_event(const std::string& /*event_name*/)
 {
-	invalidate_move_maps();
+	const std::pair<map_location, map_location>* move = manager::get_unit_move();
+	if (move) {
+		update_move_maps(move->first, move->second);
+	} else {
+		invalidate_move_maps();
+	}
 }
 
 
@@ -375,93 +382,252 @@ void readonly_context_impl::calculate_moves(const unit_map& units, std::map<map_
 {
 
 	for(unit_map::const_iterator un_it = units.begin(); un_it != units.end(); ++un_it) {
-		// If we are looking for the movement of enemies, then this unit must be an enemy unit.
-		// If we are looking for movement of our own units, it must be on our side.
-		// If we are assuming full movement, then it may be a unit on our side, or allied.
-		if ((enemy && current_team().is_enemy(un_it->side()) == false) ||
-		    (!enemy && !assume_full_movement && un_it->side() != get_side()) ||
-		    (!enemy && assume_full_movement && current_team().is_enemy(un_it->side()))) {
-			continue;
-		}
-		// Discount incapacitated units
-		if (un_it->incapacitated() ||
-		    (!assume_full_movement && un_it->movement_left() == 0)) {
-			continue;
-		}
+		calculate_unit_paths(*un_it, res, srcdst, dstsrc, enemy, assume_full_movement, see_all);
+	}
 
-		// We can't see where invisible enemy units might move.
-		if (enemy && un_it->invisible(un_it->get_location()) && !see_all) {
-			continue;
-		}
-		// If it's an enemy unit, reset its moves while we do the calculations.
-		unit* held_unit = const_cast<unit *>(&*un_it);
-		const unit_movement_resetter move_resetter(*held_unit,enemy || assume_full_movement);
-
-		// Insert the trivial moves of staying on the same map location.
-		if (un_it->movement_left() > 0) {
-			std::pair<map_location,map_location> trivial_mv(un_it->get_location(), un_it->get_location());
-			srcdst.insert(trivial_mv);
-			dstsrc.insert(trivial_mv);
-		}
-		/**
-		 * @todo This is where support for a speculative unit map is incomplete.
-		 *       There are several places (deep) within the paths constructor
-		 *       where *resources::units is assumed to be the unit map. Rather
-		 *       than introduce a new parameter to numerous functions, a better
-		 *       solution may be for the creator of the speculative map (if one
-		 *       is used in the future) to cause resources::units to point to
-		 *       that map (and restore the "real" pointer when the speculating
-		 *       is completed). If that approach is adopted, calculate_moves()
-		 *       and calculate_possible_moves() become redundant, and one of
-		 *       them should probably be eliminated.
-		 */
-		res.insert(std::pair<map_location,pathfind::paths>(
-			un_it->get_location(), pathfind::paths(
-				*un_it, false, true, current_team(), 0, see_all)));
+	remove_destinations = destinations_filter(remove_destinations);
+
+	for(std::map<map_location,pathfind::paths>::iterator m = res.begin(); m != res.end(); ++m) {
+		add_destinations(m->first, m->second, srcdst, dstsrc, enemy, remove_destinations);
 	}
+}
+
 
+bool readonly_context_impl::calculate_unit_paths(const unit& u,
+		std::map<map_location,pathfind::paths>& res, move_map& srcdst,
+		move_map& dstsrc, bool enemy, bool assume_full_movement,
+		bool see_all) const
+{
+	// If we are looking for the movement of enemies, then this unit must be an enemy unit.
+	// If we are looking for movement of our own units, it must be on our side.
+	// If we are assuming full movement, then it may be a unit on our side, or allied.
+	if ((enemy && current_team().is_enemy(u.side()) == false) ||
+	    (!enemy && !assume_full_movement && u.side() != get_side()) ||
+	    (!enemy && assume_full_movement && current_team().is_enemy(u.side()))) {
+		return false;
+	}
+	// Discount incapacitated units
+	if (u.incapacitated() ||
+	    (!assume_full_movement && u.movement_left() == 0)) {
+		return false;
+	}
+
+	// We can't see where invisible enemy units might move.
+	if (enemy && u.invisible(u.get_location()) && !see_all) {
+		return false;
+	}
+	// If it's an enemy unit, reset its moves while we do the calculations.
+	unit* held_unit = const_cast<unit *>(&u);
+	const unit_movement_resetter move_resetter(*held_unit,enemy || assume_full_movement);
+
+	// Insert the trivial moves of staying on the same map location.
+	if (u.movement_left() > 0) {
+		std::pair<map_location,map_location> trivial_mv(u.get_location(), u.get_location());
+		srcdst.insert(trivial_mv);
+		dstsrc.insert(trivial_mv);
+	}
+	/**
+	 * @todo This is where support for a speculative unit map is incomplete.
+	 *       There are several places (deep) within the paths constructor
+	 *       where *resources::units is assumed to be the unit map. Rather
+	 *       than introduce a new parameter to numerous functions, a better
+	 *       solution may be for the creator of the speculative map (if one
+	 *       is used in the future) to cause resources::units to point to
+	 *       that map (and restore the "real" pointer when the speculating
+	 *       is completed). If that approach is adopted, calculate_moves()
+	 *       and calculate_possible_moves() become redundant, and one of
+	 *       them should probably be eliminated.
+	 */
+	res.insert(std::pair<map_location,pathfind::paths>(
+		u.get_location(), pathfind::paths(
+			u, false, true, current_team(), 0, see_all)));
+	return true;
+}
+
+
+const terrain_filter* readonly_context_impl::destinations_filter(const terrain_filter* remove_destinations)
+{
 	// deactivate terrain filtering if it's just the dummy 'matches nothing'
 	static const config only_not_tag("not");
 	if(remove_destinations && remove_destinations->to_config() == only_not_tag) {
-		remove_destinations = NULL;
+		return NULL;
 	}
+	return remove_destinations;
+}
 
-	for(std::map<map_location,pathfind::paths>::iterator m = res.begin(); m != res.end(); ++m) {
-		BOOST_FOREACH(const pathfind::paths::step &dest, m->second.destinations)
-		{
-			const map_location& src = m->first;
-			const map_location& dst = dest.curr;
 
-			if(remove_destinations != NULL && remove_destinations->match(dst)) {
-				continue;
+bool readonly_context_impl::is_destination(const map_location& dst, bool enemy,
+		const terrain_filter* remove_destinations) const
+{
+	if(remove_destinations != NULL && remove_destinations->match(dst)) {
+		return false;
+	}
+
+	// Don't take friendly villages
+	if(!enemy && resources::gameboard->map().is_village(dst)) {
+		for(size_t n = 0; n != resources::teams->size(); ++n) {
+			if((*resources::teams)[n].owns_village(dst)) {
+				int side = n + 1;
+				if (get_side() != side && !current_team().is_enemy(side)) {
+					return false;
+				}
+
+				break;
 			}
+		}
+	}
+
+	return resources::gameboard->find_visible_unit(dst, current_team()) == resources::units->end();
+}
 
-			bool friend_owns = false;
 
-			// Don't take friendly villages
-			if(!enemy && resources::gameboard->map().is_village(dst)) {
-				for(size_t n = 0; n != resources::teams->size(); ++n) {
-					if((*resources::teams)[n].owns_village(dst)) {
-						int side = n + 1;
-						if (get_side() != side && !current_team().is_enemy(side)) {
-							friend_owns = true;
-						}
+void readonly_context_impl::add_destinations(const map_location& src, const pathfind::paths& paths,
+		move_map& srcdst, move_map& dstsrc, bool enemy,
+		const terrain_filter* remove_destinations) const
+{
+	BOOST_FOREACH(const pathfind::paths::step &dest, paths.destinations)
+	{
+		const map_location& dst = dest.curr;
 
-						break;
-					}
-				}
+		if(src != dst && is_destination(dst, enemy, remove_destinations)) {
+			srcdst.insert(std::pair<map_location,map_location>(src,dst));
+			dstsrc.insert(std::pair<map_location,map_location>(dst,src));
+		}
+	}
+}
+
+
+/** Removes the moves of the unit at @a src from the move maps. */
+static void remove_moves(const map_location& src,
+		std::map<map_location,pathfind::paths>& possible_moves,
+		move_map& srcdst, move_map& dstsrc)
+{
+	possible_moves.erase(src);
+
+	typedef move_map::iterator Itor;
+	const std::pair<Itor,Itor> moves = srcdst.equal_range(src);
+	for(Itor mv = moves.first; mv != moves.second; ++mv) {
+		std::pair<Itor,Itor> its = dstsrc.equal_range(mv->second);
+		while(its.first != its.second) {
+			if(its.first->second == src) {
+				dstsrc.erase(its.first++);
+			} else {
+				++its.first;
 			}
+		}
+	}
+	srcdst.erase(moves.first, moves.second);
+}
 
-			if(friend_owns) {
-				continue;
+
+/** Removes the moves to @a dst (except for staying there) from the move maps. */
+static void remove_moves_to(const map_location& dst, move_map& srcdst, move_map& dstsrc)
+{
+	typedef move_map::iterator Itor;
+	const std::pair<Itor,Itor> moves = dstsrc.equal_range(dst);
+	for(Itor mv = moves.first; mv != moves.second; ) {
+		if(mv->second == dst) {
+			++mv;
+			continue;
+		}
+		std::pair<Itor,Itor> its = srcdst.equal_range(mv->second);
+		while(its.first != its.second) {
+			if(its.first->second == dst) {
+				srcdst.erase(its.first++);
+			} else {
+				++its.first;
+			}
+		}
+		dstsrc.erase(mv++);
+	}
+}
+
+
+void readonly_context_impl::update_moves(std::map<map_location,pathfind::paths>& possible_moves,
+		move_map& srcdst, move_map& dstsrc, bool enemy,
+		const terrain_filter* remove_destinations,
+		const map_location& from, const map_location& to) const
+{
+	const unit_map& units = *resources::units;
+	const unit_map::const_iterator moved = units.find(to);
+	remove_destinations = destinations_filter(remove_destinations);
+
+	// The hexes where the moved unit now blocks, or no longer blocks,
+	// the movement of its enemies (itself and its zone of control).
+	std::set<map_location> area;
+	if(from != to) {
+		map_location adj[6];
+		area.insert(from);
+		get_adjacent_tiles(from, adj);
+		area.insert(adj, adj + 6);
+		area.insert(to);
+		get_adjacent_tiles(to, adj);
+		area.insert(adj, adj + 6);
+	}
+
+	// Find the units whose moves may have changed.
+	std::vector<map_location> affected;
+	affected.push_back(from);
+	if(to != from) {
+		affected.push_back(to);
+	}
+	for(std::map<map_location,pathfind::paths>::const_iterator m = possible_moves.begin();
+			m != possible_moves.end(); ++m) {
+		const map_location& src = m->first;
+		if(src == from || src == to) {
+			continue;
+		}
+		const unit_map::const_iterator u = units.find(src);
+		if(u == units.end()) {
+			// Stale, see below.
+			affected.push_back(src);
+			continue;
+		}
+		if(area.empty() || moved == units.end() ||
+				!(*resources::teams)[u->side()-1].is_enemy(moved->side())) {
+			continue;
+		}
+		BOOST_FOREACH(const map_location& loc, area) {
+			if(m->second.destinations.contains(loc)) {
+				affected.push_back(src);
+				break;
 			}
+		}
+	}
 
-			if(src != dst && (resources::gameboard->find_visible_unit(dst, current_team()) == resources::units->end()) ) {
-				srcdst.insert(std::pair<map_location,map_location>(src,dst));
-				dstsrc.insert(std::pair<map_location,map_location>(dst,src));
+	BOOST_FOREACH(const map_location& src, affected) {
+		remove_moves(src, possible_moves, srcdst, dstsrc);
+	}
+
+	// The vacated hex is now a possible destination for the units that can
+	// reach it, and the occupied one no longer is.
+	if(from != to) {
+		remove_moves_to(to, srcdst, dstsrc);
+		if(is_destination(from, enemy, remove_destinations)) {
+			for(std::map<map_location,pathfind::paths>::const_iterator m = possible_moves.begin();
+					m != possible_moves.end(); ++m) {
+				if(m->first != from && m->second.destinations.contains(from)) {
+					srcdst.insert(std::make_pair(m->first, from));
+					dstsrc.insert(std::make_pair(from, m->first));
+				}
 			}
 		}
 	}
+
+	// Recalculate the affected units. (There may be none left at a location
+	// if a unit is gone; entries for units that moved earlier without
+	// telling us are dropped this way too.)
+	std::map<map_location,pathfind::paths> recalculated;
+	BOOST_FOREACH(const map_location& src, affected) {
+		const unit_map::const_iterator u = units.find(src);
+		if(u != units.end()) {
+			calculate_unit_paths(*u, recalculated, srcdst, dstsrc, enemy, false, false);
+		}
+	}
+	for(std::map<map_location,pathfind::paths>::iterator m = recalculated.begin(); m != recalculated.end(); ++m) {
+		add_destinations(m->first, m->second, srcdst, dstsrc, enemy, remove_destinations);
+	}
+	possible_moves.insert(recalculated.begin(), recalculated.end());
 }
 
 
@@ -986,6 +1152,8 @@ void readonly_context_impl::invalidate_move_maps() const
 {
 	move_maps_valid_ = false;
 	move_maps_enemy_valid_ = false;
+	power_projection_cache_.clear();
+	enemy_power_projection_cache_.clear();
 
 	dst_src_valid_lua_ = false;
 	dst_src_enemy_valid_lua_ = false;
@@ -1107,6 +1275,32 @@ const map_location& readonly_context_impl::nearest_keep(const map_location& loc)
 
 
 double readonly_context_impl::power_projection(const map_location& loc, const move_map& dstsrc) const
+{
+	const gamemap& map_ = resources::gameboard->map();
+
+	// Only the move maps of this context are known to stay the same
+	// until invalidate_move_maps().
+	std::vector<double>* cache = NULL;
+	if (&dstsrc == &dstsrc_ && move_maps_valid_) {
+		cache = &power_projection_cache_;
+	} else if (&dstsrc == &enemy_dstsrc_ && move_maps_enemy_valid_) {
+		cache = &enemy_power_projection_cache_;
+	}
+	if (cache == NULL || !map_.on_board(loc)) {
+		return calculate_power_projection(loc, dstsrc);
+	}
+
+	if (cache->empty()) {
+		cache->resize(map_.w() * map_.h(), -1.0);
+	}
+	double& res = (*cache)[loc.x + loc.y * map_.w()];
+	if (res < 0.0) {
+		res = calculate_power_projection(loc, dstsrc);
+	}
+	return res;
+}
+
+double readonly_context_impl::calculate_power_projection(const map_location& loc, const move_map& dstsrc) const
 {
 	map_location used_locs[6];
 	int ratings[6];
@@ -1220,10 +1414,22 @@ double readonly_context_impl::power_projection(const map_location& loc, const mo
 
 void readonly_context_impl::recalculate_move_maps() const
 {
+	power_projection_cache_.clear();
 	dstsrc_ = move_map();
 	possible_moves_ = moves_map();
 	srcdst_ = move_map();
 	calculate_possible_moves(possible_moves_,srcdst_,dstsrc_,false,false,&get_avoid());
+	remove_passive_leader_moves();
+	move_maps_valid_ = true;
+
+	// invalidate lua cache
+	dst_src_valid_lua_ = false;
+	src_dst_valid_lua_ = false;
+}
+
+
+void readonly_context_impl::remove_passive_leader_moves() const
+{
 	if (get_passive_leader()||get_passive_leader_shares_keep()) {
 		unit_map::iterator i = resources::units->find_leader(get_side());
 		if (i.valid()) {
@@ -1239,16 +1445,39 @@ void readonly_context_impl::recalculate_move_maps() const
 		///@todo 1.9: shall possible moves be modified as well ?
 		}
 	}
-	move_maps_valid_ = true;
+}
 
-	// invalidate lua cache
+
+void readonly_context_impl::update_move_maps(const map_location& from, const map_location& to) const
+{
+	// Hidden units make everything more complicated, and only the moves
+	// of our own units matter for the speed of our turn.
+	const unit_map::const_iterator moved = resources::units->find(to);
+	if (moved == resources::units->end() || moved->side() != get_side()) {
+		invalidate_move_maps();
+		return;
+	}
+
+	if (move_maps_valid_) {
+		update_moves(possible_moves_, srcdst_, dstsrc_, false, &get_avoid(), from, to);
+		remove_passive_leader_moves();
+	}
+	if (move_maps_enemy_valid_) {
+		update_moves(enemy_possible_moves_, enemy_srcdst_, enemy_dstsrc_, true, NULL, from, to);
+	}
+
+	power_projection_cache_.clear();
+	enemy_power_projection_cache_.clear();
 	dst_src_valid_lua_ = false;
+	dst_src_enemy_valid_lua_ = false;
 	src_dst_valid_lua_ = false;
+	src_dst_enemy_valid_lua_ = false;
 }
 
 
 void readonly_context_impl::recalculate_move_maps_enemy() const
 {
+	enemy_power_projection_cache_.clear();
 	enemy_dstsrc_ = move_map();
 	enemy_srcdst_ = move_map();
 	enemy_possible_moves_ = moves_map();
@@ -1512,6 +1512,11 @@ public:
 	virtual const map_location& nearest_keep(const map_location& loc) const;
 
 
+	/**
+	 * For the move maps of this context (get_dstsrc() and
+	 * get_enemy_dstsrc()), the results are cached per hex until the move
+	 * maps are recalculated.
+	 */
 	virtual double power_projection(const map_location& loc, const move_map& dstsrc) const;
 
 
@@ -1549,6 +1554,49 @@ private:
 	template<typename T>
 	void add_known_aspect(const std::string &name, boost::shared_ptr< typesafe_aspect <T> >& where);
 
+	/** The uncached part of power_projection(). */
+	double calculate_power_projection(const map_location& loc, const move_map& dstsrc) const;
+
+	/**
+	 * Adds the paths of @a u to @a possible_moves, with its trivial move to
+	 * the move maps, if calculate_moves() takes units like it into account.
+	 * @returns whether it did.
+	 */
+	bool calculate_unit_paths(const unit& u,
+		std::map<map_location,pathfind::paths>& possible_moves, move_map& srcdst,
+		move_map& dstsrc, bool enemy, bool assume_full_movement,
+		bool see_all) const;
+
+	/** Adds the moves from @a src along @a paths to the move maps. */
+	void add_destinations(const map_location& src, const pathfind::paths& paths,
+		move_map& srcdst, move_map& dstsrc, bool enemy,
+		const terrain_filter* remove_destinations) const;
+
+	/** Whether calculate_moves() lets units move to @a dst. */
+	bool is_destination(const map_location& dst, bool enemy,
+		const terrain_filter* remove_destinations) const;
+
+	/** @returns @a remove_destinations, or NULL if it filters nothing. */
+	static const terrain_filter* destinations_filter(const terrain_filter* remove_destinations);
+
+	/**
+	 * Updates the move maps after the unit now at @a to moved there from
+	 * @a from (see manager::raise_unit_moved()), recalculating only the
+	 * units whose moves may have changed: the moved unit itself, and its
+	 * enemies that could reach it or the hexes it left, or their neighbours.
+	 * Falls back to invalidate_move_maps() for the moves of other sides.
+	 */
+	void update_move_maps(const map_location& from, const map_location& to) const;
+
+	/** Does the incremental part of update_move_maps() for one set of maps. */
+	void update_moves(std::map<map_location,pathfind::paths>& possible_moves,
+		move_map& srcdst, move_map& dstsrc, bool enemy,
+		const terrain_filter* remove_destinations,
+		const map_location& from, const map_location& to) const;
+
+	/** Removes the moves of a passive leader from dstsrc_ and srcdst_. */
+	void remove_passive_leader_moves() const;
+
 	const config cfg_;
 
 	/**
@@ -1579,6 +1627,11 @@ private:
 	aspect_type< double >::typesafe_ptr leader_value_;
 	mutable bool move_maps_enemy_valid_;
 	mutable bool move_maps_valid_;
+	/**
+	 * power_projection() of each hex (indexed by x + y * width) for dstsrc_,
+	 * respectively enemy_dstsrc_; negative where not calculated yet.
+	 */
+	mutable std::vector<double> power_projection_cache_, enemy_power_projection_cache_;
 	mutable bool dst_src_valid_lua_;
 	mutable bool dst_src_enemy_valid_lua_;
 	mutable bool src_dst_valid_lua_;
@@ -187,9 +187,6 @@ bool ai_default_recruitment_stage::recruit_usage(const std::string& usage)
 	log_scope2(log_ai, "recruiting troops");
 	LOG_AI << "recruiting '" << usage << "'\n";
 
-	//make sure id, usage and cost are known for the coming evaluation of unit types
-	unit_types.build_all(unit_type::HELP_INDEXED);
-
 	std::vector<std::string> options;
 	bool found = false;
 	// Find an available unit that can be recruited,
@@ -219,8 +216,8 @@ bool ai_default_recruitment_stage::recruit_usage(const std::string& usage)
 
 			if (imc != maximum_counts_.end()) {
 				int count_active = 0;
-				for (unit_map::const_iterator u = resources::units->begin(); u != resources::units->end(); ++u) {
-					if (u->side() == get_side() && !u->incapacitated() && u->type().base_id() == name) {
+				BOOST_FOREACH(const unit_map::const_unit_iterator &u, resources::units->units_of_side(get_side())) {
+					if (!u->incapacitated() && u->type().base_id() == name) {
 						++count_active;
 					}
 				}
@@ -866,10 +863,8 @@ bool ai_default_recruitment_stage::do_play_stage()
 
 		std::map<std::string,int> unit_types;
 
-		for(unit_map::const_iterator u = units_.begin(); u != units_.end(); ++u) {
-			if (u->side() == get_side()) {
-				++unit_types[u->usage()];
-			}
+		BOOST_FOREACH(const unit_map::const_unit_iterator &u, units_.units_of_side(get_side())) {
+			++unit_types[u->usage()];
 		}
 
 		LOG_AI << "we have " << unit_types["scout"] << " scouts already and we want "
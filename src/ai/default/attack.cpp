@@ -28,8 +28,12 @@
 #include "../../log.hpp"
 #include "../../map.hpp"
 #include "../../team.hpp"
+#include "../../thread.hpp"
 #include "../../unit.hpp"
 
+#include <SDL_cpuinfo.h>
+#include <SDL_version.h>
+
 static lg::log_domain log_ai("ai/attack");
 #define LOG_AI LOG_STREAM(info, log_ai)
 #define ERR_AI LOG_STREAM(err, log_ai)
@@ -126,8 +130,10 @@ void attack_analysis::analyze(const gamemap& map, unit_map& units,
 		} else {
 			bc = new battle_context(units, m->second, target, -1, -1, m_aggression, prev_def);
 		}
-		const combatant &att = bc->get_attacker_combatant(prev_def);
-		const combatant &def = bc->get_defender_combatant(prev_def);
+		// Estimate the fights too costly to calculate exactly.
+		static const fight_sampling sampling;
+		const combatant &att = bc->get_attacker_combatant(prev_def, &sampling);
+		const combatant &def = bc->get_defender_combatant(prev_def, &sampling);
 
 		delete prev_bc;
 		prev_bc = bc;
@@ -331,4 +337,87 @@ double attack_analysis::rating(double aggression, const readonly_context& ai_obj
 	return value;
 }
 
+namespace {
+
+/** A part of the work of rate_attacks(), done by one thread. */
+struct rating_task
+{
+	const std::vector<attack_analysis>* analysis;
+	const std::vector<size_t>* candidates;
+	double aggression;
+	const readonly_context* ai_obj;
+	std::vector<double>* ratings;
+	size_t begin, end;
+};
+
+int rate_attack_range(void* data)
+{
+	const rating_task& task = *static_cast<const rating_task*>(data);
+	for(size_t i = task.begin; i != task.end; ++i) {
+		(*task.ratings)[i] = (*task.analysis)[(*task.candidates)[i]].rating(task.aggression, *task.ai_obj);
+	}
+	return 0;
+}
+
+} // end anon namespace
+
+void rate_attacks(const std::vector<attack_analysis>& analysis,
+                  const std::vector<size_t>& candidates,
+                  double aggression, const readonly_context& ai_obj,
+                  std::vector<double>& ratings, unsigned workers)
+{
+	// Starting a thread costs more than rating a few hundred attacks.
+	const size_t min_per_worker = 500;
+
+	ratings.resize(candidates.size());
+	workers = std::min<size_t>(workers, candidates.size() / min_per_worker);
+	// rating() logs, and the log streams are not shared safely between threads.
+	if(!lg::info.dont_log(log_ai)) {
+		workers = 1;
+	}
+
+	if(workers <= 1) {
+		for(size_t i = 0; i != candidates.size(); ++i) {
+			ratings[i] = analysis[candidates[i]].rating(aggression, ai_obj);
+		}
+		return;
+	}
+
+	// The aspects are calculated lazily, so do it before the threads read them.
+	ai_obj.get_leader_aggression();
+	ai_obj.get_caution();
+
+	std::vector<rating_task> tasks(workers);
+	for(unsigned w = 0; w != workers; ++w) {
+		rating_task& task = tasks[w];
+		task.analysis = &analysis;
+		task.candidates = &candidates;
+		task.aggression = aggression;
+		task.ai_obj = &ai_obj;
+		task.ratings = &ratings;
+		task.begin = candidates.size() * w / workers;
+		task.end = candidates.size() * (w+1) / workers;
+	}
+
+	// This thread does the first part itself.
+	std::vector<threading::thread*> threads;
+	for(unsigned w = 1; w != workers; ++w) {
+		threads.push_back(new threading::thread(rate_attack_range, &tasks[w]));
+	}
+	rate_attack_range(&tasks[0]);
+	for(size_t t = 0; t != threads.size(); ++t) {
+		// Joins the thread.
+		delete threads[t];
+	}
+}
+
+unsigned attack_rating_workers()
+{
+#if SDL_VERSION_ATLEAST(2,0,0)
+	return std::max(1, SDL_GetCPUCount());
+#else
+	return 1;
+#endif
+}
+
 } //end of namespace ai
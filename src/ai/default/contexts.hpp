@@ -131,6 +131,20 @@ public:
 
 };
 
+/**
+ * Rates the attacks of @a analysis whose indices are in @a candidates (see
+ * attack_analysis::rating()), storing the ratings in @a ratings in the same
+ * order. Big batches are split over up to @a workers threads; the ratings
+ * do not depend on how they were split.
+ */
+void rate_attacks(const std::vector<attack_analysis>& analysis,
+                  const std::vector<size_t>& candidates,
+                  double aggression, const readonly_context& ai_obj,
+                  std::vector<double>& ratings, unsigned workers);
+
+/** The number of threads rate_attacks() should use on this machine. */
+unsigned attack_rating_workers();
+
 
 class default_ai_context;
 class default_ai_context : public virtual readwrite_context{
@@ -585,141 +585,142 @@ variant villages_from_set(const Container& villages,
 }
 }
 
+namespace {
+
+enum formula_ai_attribute {
+	AI_AGGRESSION, AI_ATTACK_DEPTH, AI_AVOID, AI_CAUTION, AI_GROUPING,
+	AI_LEADER_AGGRESSION, AI_LEADER_IGNORES_KEEP, AI_LEADER_VALUE,
+	AI_NUMBER_OF_POSSIBLE_RECRUITS_TO_FORCE_RECRUIT, AI_PASSIVE_LEADER,
+	AI_PASSIVE_LEADER_SHARES_KEEP, AI_RECRUITMENT_IGNORE_BAD_MOVEMENT,
+	AI_RECRUITMENT_IGNORE_BAD_COMBAT, AI_RECRUITMENT_PATTERN,
+	AI_SCOUT_VILLAGE_TARGETING, AI_SUPPORT_VILLAGES, AI_VILLAGE_VALUE,
+	AI_VILLAGES_PER_SCOUT, AI_ATTACKS, AI_TURN, AI_TIME_OF_DAY, AI_MY_SIDE,
+	AI_MY_SIDE_NUMBER, AI_TEAMS, AI_ALLIES, AI_ENEMIES, AI_MY_RECRUITS,
+	AI_RECRUITS_OF_SIDE, AI_UNITS, AI_UNITS_OF_SIDE, AI_MY_UNITS,
+	AI_ENEMY_UNITS, AI_MY_MOVES, AI_MY_ATTACKS, AI_ENEMY_MOVES, AI_MY_LEADER,
+	AI_RECALL_LIST, AI_VARS, AI_KEEPS, AI_MAP, AI_VILLAGES, AI_VILLAGES_OF_SIDE,
+	AI_MY_VILLAGES, AI_ENEMY_AND_UNOWNED_VILLAGES
+};
+
+const char* const formula_ai_attribute_names[] = {
+	"aggression", "attack_depth", "avoid", "caution", "grouping",
+	"leader_aggression", "leader_ignores_keep", "leader_value",
+	"number_of_possible_recruits_to_force_recruit", "passive_leader",
+	"passive_leader_shares_keep", "recruitment_ignore_bad_movement",
+	"recruitment_ignore_bad_combat", "recruitment_pattern",
+	"scout_village_targeting", "support_villages", "village_value",
+	"villages_per_scout", "attacks", "turn", "time_of_day", "my_side",
+	"my_side_number", "teams", "allies", "enemies", "my_recruits",
+	"recruits_of_side", "units", "units_of_side", "my_units", "enemy_units",
+	"my_moves", "my_attacks", "enemy_moves", "my_leader", "recall_list", "vars",
+	"keeps", "map", "villages", "villages_of_side", "my_villages",
+	"enemy_and_unowned_villages", NULL
+};
+
+const game_logic::formula_key_table& formula_ai_keys()
+{
+	static const game_logic::formula_key_table keys(formula_ai_attribute_names);
+	return keys;
+}
+
+}
+
 variant formula_ai::get_value(const std::string& key) const
+{
+	return get_attribute(formula_ai_keys().find(key));
+}
+
+variant formula_ai::get_key_value(const game_logic::formula_key& key) const
+{
+	return get_attribute(formula_ai_keys().find(key));
+}
+
+variant formula_ai::get_attribute(int attribute) const
 {
 	const unit_map& units = *resources::units;
 
-	if(key == "aggression")
-	{
+	switch(attribute) {
+	case AI_AGGRESSION:
 		return variant(get_aggression()*1000,variant::DECIMAL_VARIANT);
-
-	} else if(key == "attack_depth")
-	{
+	case AI_ATTACK_DEPTH:
 		return variant(get_attack_depth());
-
-	} else if(key == "avoid")
-	{
+	case AI_AVOID: {
 		std::set<map_location> av_locs;
 		get_avoid().get_locations(av_locs);
 		return villages_from_set(av_locs);
-
-	} else if(key == "caution")
-	{
+	}
+	case AI_CAUTION:
 		return variant(get_caution()*1000,variant::DECIMAL_VARIANT);
-
-	} else if(key == "grouping")
-	{
+	case AI_GROUPING:
 		return variant(get_grouping());
-
-	} else if(key == "leader_aggression")
-	{
+	case AI_LEADER_AGGRESSION:
 		return variant(get_leader_aggression()*1000,variant::DECIMAL_VARIANT);
-
-	} else if(key == "leader_ignores_keep")
-	{
+	case AI_LEADER_IGNORES_KEEP:
 		return variant(get_leader_ignores_keep());
-
-	} else if(key == "leader_value")
-	{
+	case AI_LEADER_VALUE:
 		return variant(get_leader_value()*1000,variant::DECIMAL_VARIANT);
-
-	} else if(key == "number_of_possible_recruits_to_force_recruit")
-	{
+	case AI_NUMBER_OF_POSSIBLE_RECRUITS_TO_FORCE_RECRUIT:
 		return variant(get_number_of_possible_recruits_to_force_recruit()*1000,variant::DECIMAL_VARIANT);
-
-	} else if(key == "passive_leader")
-	{
+	case AI_PASSIVE_LEADER:
 		return variant(get_passive_leader());
-
-	} else if(key == "passive_leader_shares_keep")
-	{
+	case AI_PASSIVE_LEADER_SHARES_KEEP:
 		return variant(get_passive_leader_shares_keep());
-
-	} else if(key == "recruitment_ignore_bad_movement")
-	{
+	case AI_RECRUITMENT_IGNORE_BAD_MOVEMENT:
 		return variant(get_recruitment_ignore_bad_movement());
-
-	} else if(key == "recruitment_ignore_bad_combat")
-	{
+	case AI_RECRUITMENT_IGNORE_BAD_COMBAT:
 		return variant(get_recruitment_ignore_bad_combat());
-
-	} else if(key == "recruitment_pattern")
-	{
+	case AI_RECRUITMENT_PATTERN: {
 		const std::vector<std::string> &rp = get_recruitment_pattern();
 		std::vector<variant> vars;
 		BOOST_FOREACH(const std::string &i, rp) {
 			vars.push_back(variant(i));
 		}
 		return variant(&vars);
-
-	} else if(key == "scout_village_targeting")
-	{
+	}
+	case AI_SCOUT_VILLAGE_TARGETING:
 		return variant(get_scout_village_targeting()*1000,variant::DECIMAL_VARIANT);
-
-	} else if(key == "support_villages")
-	{
+	case AI_SUPPORT_VILLAGES:
 		return variant(get_support_villages());
-
-	} else if(key == "village_value")
-	{
+	case AI_VILLAGE_VALUE:
 		return variant(get_village_value()*1000,variant::DECIMAL_VARIANT);
-
-	} else if(key == "villages_per_scout")
-	{
+	case AI_VILLAGES_PER_SCOUT:
 		return variant(get_villages_per_scout());
-
-	} else if(key == "attacks")
-	{
+	case AI_ATTACKS:
 		return get_attacks_as_variant();
-
-	} else if(key == "turn")
-	{
+	case AI_TURN:
 		return variant(resources::tod_manager->turn());
-
-	} else if(key == "time_of_day")
-	{
+	case AI_TIME_OF_DAY:
 		return variant(resources::tod_manager->get_time_of_day().id);
-
-	} else if(key == "my_side")
-	{
+	case AI_MY_SIDE:
 		return variant(new team_callable((*resources::teams)[get_side()-1]));
-
-	} else if(key == "my_side_number")
-	{
+	case AI_MY_SIDE_NUMBER:
 		return variant(get_side()-1);
-
-	} else if(key == "teams")
-	{
+	case AI_TEAMS: {
 		std::vector<variant> vars;
 		for(std::vector<team>::const_iterator i = resources::teams->begin(); i != resources::teams->end(); ++i) {
 			vars.push_back(variant(new team_callable(*i)));
 		}
 		return variant(&vars);
-
-	} else if(key == "allies")
-	{
+	}
+	case AI_ALLIES: {
 		std::vector<variant> vars;
 		for( size_t i = 0; i < resources::teams->size(); ++i) {
 			if ( !current_team().is_enemy( i+1 ) )
 				vars.push_back(variant( i ));
 		}
 		return variant(&vars);
-
-	} else if(key == "enemies")
-	{
+	}
+	case AI_ENEMIES: {
 		std::vector<variant> vars;
 		for( size_t i = 0; i < resources::teams->size(); ++i) {
 			if ( current_team().is_enemy( i+1 ) )
 				vars.push_back(variant( i ));
 		}
 		return variant(&vars);
-
-	} else if(key == "my_recruits")
-	{
+	}
+	case AI_MY_RECRUITS: {
 		std::vector<variant> vars;
 
-		unit_types.build_all(unit_type::FULL);
-
 		const std::set<std::string>& recruits = current_team().recruits();
 		if(recruits.empty()) {
 			return variant( &vars );
@@ -733,14 +734,11 @@ variant formula_ai::get_value(const std::string& key) const
 			}
 		}
 		return variant( &vars );
-
-	} else if(key == "recruits_of_side")
-	{
+	}
+	case AI_RECRUITS_OF_SIDE: {
 		std::vector<variant> vars;
 		std::vector< std::vector< variant> > tmp;
 
-		unit_types.build_all(unit_type::FULL);
-
 		for( size_t i = 0; i<resources::teams->size(); ++i)
 		{
 			std::vector<variant> v;
@@ -763,17 +761,15 @@ variant formula_ai::get_value(const std::string& key) const
 		for( size_t i = 0; i<tmp.size(); ++i)
 			vars.push_back( variant( &tmp[i] ));
 		return variant(&vars);
-
-	} else if(key == "units")
-	{
+	}
+	case AI_UNITS: {
 		std::vector<variant> vars;
 		for(unit_map::const_iterator i = units.begin(); i != units.end(); ++i) {
 			vars.push_back(variant(new unit_callable(*i)));
 		}
 		return variant(&vars);
-
-	} else if(key == "units_of_side")
-	{
+	}
+	case AI_UNITS_OF_SIDE: {
 		std::vector<variant> vars;
 		std::vector< std::vector< variant> > tmp;
 		for( size_t i = 0; i<resources::teams->size(); ++i)
@@ -787,9 +783,8 @@ variant formula_ai::get_value(const std::string& key) const
 		for( size_t i = 0; i<tmp.size(); ++i)
 			vars.push_back( variant( &tmp[i] ));
 		return variant(&vars);
-
-	} else if(key == "my_units")
-	{
+	}
+	case AI_MY_UNITS: {
 		std::vector<variant> vars;
 		for(unit_map::const_iterator i = units.begin(); i != units.end(); ++i) {
 			if (i->side() == get_side()) {
@@ -797,9 +792,8 @@ variant formula_ai::get_value(const std::string& key) const
 			}
 		}
 		return variant(&vars);
-
-	} else if(key == "enemy_units")
-	{
+	}
+	case AI_ENEMY_UNITS: {
 		std::vector<variant> vars;
 		for(unit_map::const_iterator i = units.begin(); i != units.end(); ++i) {
 			if (current_team().is_enemy(i->side())) {
@@ -809,28 +803,21 @@ variant formula_ai::get_value(const std::string& key) const
 			}
 		}
 		return variant(&vars);
-
-	} else if(key == "my_moves")
-	{
+	}
+	case AI_MY_MOVES:
 		return variant(new move_map_callable(get_srcdst(), get_dstsrc(), units));
-
-	} else if(key == "my_attacks")
-	{
+	case AI_MY_ATTACKS:
 		return variant(new attack_map_callable(*this, units));
-	} else if(key == "enemy_moves")
-	{
+	case AI_ENEMY_MOVES:
 		return variant(new move_map_callable(get_enemy_srcdst(), get_enemy_dstsrc(), units));
-
-	} else if(key == "my_leader")
-	{
+	case AI_MY_LEADER: {
 		unit_map::const_iterator i = units.find_leader(get_side());
 		if(i == units.end()) {
 			return variant();
 		}
 		return variant(new unit_callable(*i));
-
-	} else if(key == "recall_list")
-	{
+	}
+	case AI_RECALL_LIST: {
 		std::vector<variant> tmp;
 
 		for(std::vector<unit_ptr >::const_iterator i = current_team().recall_list().begin(); i != current_team().recall_list().end(); ++i) {
@@ -838,21 +825,16 @@ variant formula_ai::get_value(const std::string& key) const
 		}
 
 		return variant( &tmp );
-
-	} else if(key == "vars")
-	{
+	}
+	case AI_VARS:
 		return variant(&vars_);
-	} else if(key == "keeps")
-	{
+	case AI_KEEPS:
 		return get_keeps();
-	} else if(key == "map")
-	{
+	case AI_MAP:
 		return variant(new gamemap_callable(resources::gameboard->map()));
-	} else if(key == "villages")
-	{
+	case AI_VILLAGES:
 		return villages_from_set(resources::gameboard->map().villages());
-	} else if(key == "villages_of_side")
-	{
+	case AI_VILLAGES_OF_SIDE: {
 		std::vector<variant> vars;
 		for(size_t i = 0; i<resources::teams->size(); ++i)
 		{
@@ -863,13 +845,10 @@ variant formula_ai::get_value(const std::string& key) const
 			vars[i] = villages_from_set((*resources::teams)[i].villages());
 		}
 		return variant(&vars);
-
-	} else if(key == "my_villages")
-	{
+	}
+	case AI_MY_VILLAGES:
 		return villages_from_set(current_team().villages());
-
-	} else if(key == "enemy_and_unowned_villages")
-	{
+	case AI_ENEMY_AND_UNOWNED_VILLAGES:
 		return villages_from_set(resources::gameboard->map().villages(), &current_team().villages());
 	}
 
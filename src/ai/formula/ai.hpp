@@ -154,6 +154,8 @@ private:
 	void display_message(const std::string& msg) const;
 	variant execute_variant(const variant& var, ai_context &ai_, bool commandline=false);
 	virtual variant get_value(const std::string& key) const;
+	virtual variant get_key_value(const game_logic::formula_key& key) const;
+	variant get_attribute(int attribute) const;
 	virtual void get_inputs(std::vector<game_logic::formula_input>* inputs) const;
 
 	mutable variant keeps_cache_;
@@ -13,6 +13,7 @@
 */
 
 
+#include <algorithm>
 #include <queue>
 #include <set>
 #include <utility>
@@ -103,6 +104,19 @@ public:
 	  : function_expression("distance_between", args, 2, 2)
 	{}
 
+	/** The distance between constant locations is computed once, here. */
+	bool compile(formula_bytecode& code) const {
+		const variant* a = constant_arg(0);
+		const variant* b = constant_arg(1);
+		const location_callable* loc1 = a ? try_convert_variant<location_callable>(*a) : NULL;
+		const location_callable* loc2 = b ? try_convert_variant<location_callable>(*b) : NULL;
+		if(!loc1 || !loc2) {
+			return false;
+		}
+		code.emit_constant(variant(distance_between(loc1->loc(), loc2->loc())));
+		return true;
+	}
+
 private:
 	variant execute(const formula_callable& variables, formula_debugger *fdb) const {
 		const map_location loc1 = convert_variant<location_callable>(args()[0]->evaluate(variables,add_debug_info(fdb,0,"distance_between:location_A")))->loc();
@@ -1767,97 +1781,95 @@ private:
 }
 
 
+namespace {
+
+typedef expression_ptr (*function_creator)(const std::vector<expression_ptr>& args, formula_ai& ai);
+
+template<typename T>
+expression_ptr create_plain_function(const std::vector<expression_ptr>& args, formula_ai& /*ai*/)
+{
+	return expression_ptr(new T(args));
+}
+
+template<typename T>
+expression_ptr create_ai_function(const std::vector<expression_ptr>& args, formula_ai& ai)
+{
+	return expression_ptr(new T(args, ai));
+}
+
+struct ai_function
+{
+	const char* name;
+	function_creator create;
+};
+
+/** The functions of the formula AI, sorted by name for the lookups. */
+#define FUNCTION(name) { #name, &create_plain_function<name##_function> }
+#define AI_FUNCTION(name) { #name, &create_ai_function<name##_function> }
+const ai_function ai_functions[] = {
+	AI_FUNCTION(adjacent_locs),
+	{ "aki_eval", &create_ai_function<akihara_battle_evaluation> },
+	AI_FUNCTION(attack),
+	AI_FUNCTION(calculate_map_ownership),
+	AI_FUNCTION(calculate_outcome),
+	AI_FUNCTION(castle_locs),
+	AI_FUNCTION(chance_to_hit),
+	AI_FUNCTION(close_enemies),
+	AI_FUNCTION(debug_label),
+	AI_FUNCTION(defense_on),
+	FUNCTION(distance_between),
+	AI_FUNCTION(distance_to_nearest_unowned_village),
+	FUNCTION(fallback),
+	AI_FUNCTION(find_shroud),
+	FUNCTION(get_unit_type),
+	AI_FUNCTION(is_avoided_location),
+	AI_FUNCTION(is_unowned_village),
+	FUNCTION(is_village),
+	AI_FUNCTION(locations_in_radius),
+	AI_FUNCTION(max_possible_damage),
+	AI_FUNCTION(max_possible_damage_with_retaliation),
+	FUNCTION(move),
+	FUNCTION(move_partial),
+	AI_FUNCTION(movement_cost),
+	AI_FUNCTION(nearest_keep),
+	AI_FUNCTION(nearest_loc),
+	AI_FUNCTION(next_hop),
+	AI_FUNCTION(outcomes),
+	AI_FUNCTION(rate_action),
+	FUNCTION(recall),
+	FUNCTION(recruit),
+	AI_FUNCTION(run_file),
+	FUNCTION(safe_call),
+	FUNCTION(set_unit_var),
+	FUNCTION(set_var),
+	AI_FUNCTION(shortest_path),
+	AI_FUNCTION(simplest_path),
+	AI_FUNCTION(suitable_keep),
+	AI_FUNCTION(timeofday_modifier),
+	AI_FUNCTION(unit_at),
+	AI_FUNCTION(unit_moves),
+	AI_FUNCTION(units_can_reach),
+};
+#undef AI_FUNCTION
+#undef FUNCTION
+
+const ai_function* const ai_functions_end =
+	ai_functions + sizeof(ai_functions) / sizeof(*ai_functions);
+
+bool ai_function_less(const ai_function& f, const std::string& name)
+{
+	return name.compare(f.name) > 0;
+}
+
+}
+
 expression_ptr ai_function_symbol_table::create_function(const std::string &fn,
 				const std::vector<expression_ptr>& args) const {
-	if(fn == "outcomes") {
-		return expression_ptr(new outcomes_function(args, ai_));
-	//} else if(fn == "evaluate_for_position") {
-	//	return expression_ptr(new evaluate_for_position_function(args, ai_));
-	} else if(fn == "move") {
-		return expression_ptr(new move_function(args));
-	} else if(fn == "move_partial") {
-		return expression_ptr(new move_partial_function(args));
-	} else if(fn == "attack") {
-		return expression_ptr(new attack_function(args, ai_));
-	} else if(fn == "rate_action") {
-		return expression_ptr(new rate_action_function(args, ai_));
-	} else if(fn == "recall") {
-		return expression_ptr(new recall_function(args));
-	} else if(fn == "recruit") {
-		return expression_ptr(new recruit_function(args));
-	} else if(fn == "safe_call") {
-		return expression_ptr(new safe_call_function(args));
-	} else if(fn == "get_unit_type") {
-		return expression_ptr(new get_unit_type_function(args));
-	} else if(fn == "is_avoided_location") {
-		return expression_ptr(new is_avoided_location_function(args,ai_));
-	} else if(fn == "is_village") {
-		return expression_ptr(new is_village_function(args));
-	} else if(fn == "is_unowned_village") {
-		return expression_ptr(new is_unowned_village_function(args, ai_));
-	} else if(fn == "unit_at") {
-		return expression_ptr(new unit_at_function(args, ai_));
-	} else if(fn == "unit_moves") {
-		return expression_ptr(new unit_moves_function(args, ai_));
-	} else if(fn == "set_var") {
-		return expression_ptr(new set_var_function(args));
-	} else if(fn == "set_unit_var") {
-		return expression_ptr(new set_unit_var_function(args));
-	} else if(fn == "fallback") {
-		return expression_ptr(new fallback_function(args));
-	} else if(fn == "units_can_reach") {
-		return expression_ptr(new units_can_reach_function(args, ai_));
-	} else if(fn == "debug_label") {
-		return expression_ptr(new debug_label_function(args, ai_));
-	} else if(fn == "defense_on") {
-		return expression_ptr(new defense_on_function(args, ai_));
-	} else if(fn == "chance_to_hit") {
-		return expression_ptr(new chance_to_hit_function(args, ai_));
-	} else if(fn == "movement_cost") {
-		return expression_ptr(new movement_cost_function(args, ai_));
-	} else if(fn == "max_possible_damage") {
-		return expression_ptr(new max_possible_damage_function(args, ai_));
-	} else if(fn == "max_possible_damage_with_retaliation") {
-		return expression_ptr(new max_possible_damage_with_retaliation_function(args, ai_));
-	} else if(fn == "next_hop") {
-		return expression_ptr(new next_hop_function(args, ai_));
-	} else if(fn == "adjacent_locs") {
-		return expression_ptr(new adjacent_locs_function(args, ai_));
-	} else if(fn == "locations_in_radius") {
-		return expression_ptr(new locations_in_radius_function(args, ai_));
-	} else if(fn == "castle_locs") {
-		return expression_ptr(new castle_locs_function(args, ai_));
-	} else if(fn == "timeofday_modifier") {
-		return expression_ptr(new timeofday_modifier_function(args, ai_));
-	} else if(fn == "distance_to_nearest_unowned_village") {
-		return expression_ptr(new distance_to_nearest_unowned_village_function(args, ai_));
-	} else if(fn == "shortest_path") {
-		return expression_ptr(new shortest_path_function(args, ai_));
-	} else if(fn == "simplest_path") {
-		return expression_ptr(new simplest_path_function(args, ai_));
-	} else if(fn == "nearest_keep") {
-		return expression_ptr(new nearest_keep_function(args, ai_));
-	} else if(fn == "suitable_keep") {
-		return expression_ptr(new suitable_keep_function(args, ai_));
-	} else if(fn == "nearest_loc") {
-		return expression_ptr(new nearest_loc_function(args, ai_));
-	} else if(fn == "find_shroud") {
-		return expression_ptr(new find_shroud_function(args, ai_));
-	} else if(fn == "close_enemies") {
-		return expression_ptr(new close_enemies_function(args, ai_));
-	} else if(fn == "calculate_outcome") {
-		return expression_ptr(new calculate_outcome_function(args, ai_));
-	} else if(fn == "distance_between") {
-		return expression_ptr(new distance_between_function(args));
-	} else if(fn == "run_file") {
-		return expression_ptr(new run_file_function(args, ai_));
-	} else if(fn == "calculate_map_ownership") {
-		return expression_ptr(new calculate_map_ownership_function(args, ai_));
-	} else if(fn == "aki_eval") {
-		return expression_ptr(new akihara_battle_evaluation(args, ai_));
-	} else {
-		return function_symbol_table::create_function(fn, args);
+	const ai_function* i = std::lower_bound(ai_functions, ai_functions_end, fn, ai_function_less);
+	if(i != ai_functions_end && fn == i->name) {
+		return i->create(args, ai_);
 	}
+	return function_symbol_table::create_function(fn, args);
 }
 
 }
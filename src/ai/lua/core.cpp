@@ -24,6 +24,8 @@
 #include "core.hpp"
 #include "../../scripting/game_lua_kernel.hpp"
 #include "../../scripting/lua_api.hpp"
+#include "../../scripting/lua_map_views.hpp"
+#include "../../scripting/lua_profiler.hpp"
 #include "lua_object.hpp" // (Nephro)
 
 #include "../../attack_prediction.hpp"
@@ -798,6 +800,34 @@ static int cfun_ai_get_enemy_srcdst(lua_State *L)
 	return 1;
 }
 
+static int cfun_ai_get_dstsrc_view(lua_State *L)
+{
+	luaW_pushmovemapview(L, get_readonly_context(L).get_dstsrc());
+	get_readonly_context(L).set_dst_src_valid_lua();
+	return 1;
+}
+
+static int cfun_ai_get_srcdst_view(lua_State *L)
+{
+	luaW_pushmovemapview(L, get_readonly_context(L).get_srcdst());
+	get_readonly_context(L).set_src_dst_valid_lua();
+	return 1;
+}
+
+static int cfun_ai_get_enemy_dstsrc_view(lua_State *L)
+{
+	luaW_pushmovemapview(L, get_readonly_context(L).get_enemy_dstsrc());
+	get_readonly_context(L).set_dst_src_enemy_valid_lua();
+	return 1;
+}
+
+static int cfun_ai_get_enemy_srcdst_view(lua_State *L)
+{
+	luaW_pushmovemapview(L, get_readonly_context(L).get_enemy_srcdst());
+	get_readonly_context(L).set_src_dst_enemy_valid_lua();
+	return 1;
+}
+
 static int cfun_ai_is_dst_src_valid(lua_State *L)
 {
 	bool valid = get_readonly_context(L).is_dst_src_valid_lua();
@@ -850,6 +880,10 @@ static void generate_and_push_ai_table(lua_State* L, ai::engine_lua* engine) {
 			{ "get_new_src_dst", &cfun_ai_get_srcdst },
 			{ "get_new_enemy_dst_src", &cfun_ai_get_enemy_dstsrc },
 			{ "get_new_enemy_src_dst", &cfun_ai_get_enemy_srcdst },
+			{ "get_dst_src_view", &cfun_ai_get_dstsrc_view },
+			{ "get_src_dst_view", &cfun_ai_get_srcdst_view },
+			{ "get_enemy_dst_src_view", &cfun_ai_get_enemy_dstsrc_view },
+			{ "get_enemy_src_dst_view", &cfun_ai_get_enemy_srcdst_view },
 			{ "recalculate_move_maps", &cfun_ai_recalculate_move_maps },
 			{ "recalculate_enemy_move_maps", &cfun_ai_recalculate_move_maps_enemy },
 			// End of move maps
@@ -994,6 +1028,7 @@ lua_ai_context::~lua_ai_context()
 void lua_ai_action_handler::handle(config &cfg, bool configOut, lua_object_ptr l_obj)
 {
 	int initial_top = lua_gettop(L);//get the old stack size
+	const lua_profiler::context profiling("AI", "");
 
 	// Load the user function from the registry.
 	lua_pushlightuserdata(L, static_cast<void *>(const_cast<char *>(&aisKey)));//stack size is now 1 [-1: ais_table key]
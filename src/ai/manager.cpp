@@ -27,6 +27,8 @@
 #include "../map_location.hpp"       // for map_location
 #include "../resources.hpp"
 #include "../serialization/string_utils.hpp"
+#include "../unit.hpp"
+#include "../unit_map.hpp"
 
 #include "composite/ai.hpp"             // for ai_composite
 #include "composite/component.hpp"      // for component_manager
@@ -40,6 +42,7 @@
 #include "game_errors.hpp"              // for game_error
 #include "interface.hpp"  // for ai_factory, etc
 #include "lua/unit_advancements_aspect.hpp"
+#include "profiler.hpp"                 // for profiler
 #include "registry.hpp"                 // for init
 #include "util.hpp"                     // for lexical_cast
 
@@ -338,6 +341,8 @@ events::generic_event manager::recruit_list_changed_("ai_recruit_list_changed");
 events::generic_event manager::map_changed_("ai_map_changed");
 int manager::last_interact_ = 0;
 int manager::num_interact_ = 0;
+const std::pair<map_location, map_location>* manager::unit_move_ = NULL;
+const gamestate_change* manager::gamestate_change_ = NULL;
 
 
 void manager::set_ai_info(const game_info& i)
@@ -450,6 +455,46 @@ void manager::raise_gamestate_changed() {
 }
 
 
+void manager::raise_unit_moved(const map_location& from, const map_location& to) {
+	const std::pair<map_location, map_location> move(from, to);
+	const unit_map::const_iterator u = resources::units->find(to);
+	const gamestate_change change(u.valid() ? u->side() : 0, gamestate_change::SIDE_UNITS);
+	unit_move_ = &move;
+	gamestate_change_ = &change;
+	try {
+		gamestate_changed_.notify_observers();
+	} catch (...) {
+		unit_move_ = NULL;
+		gamestate_change_ = NULL;
+		throw;
+	}
+	unit_move_ = NULL;
+	gamestate_change_ = NULL;
+}
+
+
+void manager::raise_gamestate_changed(const gamestate_change& change) {
+	gamestate_change_ = &change;
+	try {
+		gamestate_changed_.notify_observers();
+	} catch (...) {
+		gamestate_change_ = NULL;
+		throw;
+	}
+	gamestate_change_ = NULL;
+}
+
+
+const std::pair<map_location, map_location>* manager::get_unit_move() {
+	return unit_move_;
+}
+
+
+const gamestate_change* manager::get_gamestate_change() {
+	return gamestate_change_;
+}
+
+
 void manager::raise_turn_started() {
 	turn_started_.notify_observers();
 }
@@ -711,6 +756,7 @@ void manager::remove_all_ais_for_side( side_number side )
 
 void manager::clear_ais()
 {
+	profiler::write_report();
 	ai_map_.clear();
 }
 
@@ -792,8 +838,11 @@ void manager::play_turn( side_number side ){
 	interface& ai_obj = get_active_ai_for_side(side);
 	resources::game_events->pump().fire("ai turn");
 	raise_turn_started();
-	ai_obj.new_turn();
-	ai_obj.play_turn();
+	{
+		const profiler::scope timer(profiler::TURN, side, "turn");
+		ai_obj.new_turn();
+		ai_obj.play_turn();
+	}
 	const int turn_end_time= SDL_GetTicks();
 	DBG_AI_MANAGER << "side " << side << ": number of user interactions: "<<num_interact_<<std::endl;
 	DBG_AI_MANAGER << "side " << side << ": total turn time: "<<turn_end_time - turn_start_time << " ms "<< std::endl;
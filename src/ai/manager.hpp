@@ -113,6 +113,27 @@ private:
 
 };
 
+/**
+ * What an action of the AI changed in the game state, when that is known.
+ * Observers of 'ai_gamestate_changed' get it from get_gamestate_change().
+ */
+struct gamestate_change
+{
+	enum {
+		SIDE_UNITS = 1,   /**< units of the side that acted */
+		OTHER_UNITS = 2,  /**< units of other sides */
+		GOLD = 4,         /**< the gold of the side that acted */
+		VILLAGES = 8      /**< the owners of villages */
+	};
+
+	gamestate_change(int side, int changes)
+		: side(side), changes(changes)
+	{}
+
+	int side;
+	int changes;
+};
+
 /**
  * Class that manages AIs for all sides and manages AI redeployment.
  * This class is responsible for managing the AI lifecycle
@@ -203,6 +224,38 @@ public:
 	static void raise_gamestate_changed();
 
 
+	/**
+	 * Notifies all observers of 'ai_gamestate_changed' event, for a change
+	 * that only affected the unit now at @a to: it moved there from @a from
+	 * (or just lost its movement, if they are the same), and nothing else
+	 * happened on the way (no WML, sightings, ambushes or captures).
+	 * Observers may use get_unit_move() to update their data incrementally.
+	 */
+	static void raise_unit_moved(const map_location& from, const map_location& to);
+
+
+	/**
+	 * Notifies all observers of 'ai_gamestate_changed' event, for a change
+	 * that is fully described by @a change (no WML was run meanwhile).
+	 */
+	static void raise_gamestate_changed(const gamestate_change& change);
+
+
+	/**
+	 * While the observers of 'ai_gamestate_changed' are notified, returns
+	 * what changed, if known; otherwise returns NULL, and anything may have
+	 * changed.
+	 */
+	static const gamestate_change* get_gamestate_change();
+
+
+	/**
+	 * While raise_unit_moved() notifies the observers, returns the hexes it
+	 * was given (from, to); otherwise returns NULL.
+	 */
+	static const std::pair<map_location, map_location>* get_unit_move();
+
+
 	/**
 	 * Notifies all observers of 'ai_recruit_list_changed' event.
 	 */
@@ -472,6 +525,8 @@ private:
 	static events::generic_event turn_started_;
 	static int last_interact_;
 	static int num_interact_;
+	static const std::pair<map_location, map_location>* unit_move_;
+	static const gamestate_change* gamestate_change_;
 
 
 
@@ -0,0 +1,329 @@
+/*
+   Copyright (C) 2015 by the Battle for Wesnoth Project
+   Part of the Battle for Wesnoth Project http://www.wesnoth.org/
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY.
+
+   See the COPYING file for more details.
+*/
+
+/**
+ * @file
+ * Timing and counters of what the AI does during its turns.
+ */
+
+#include "profiler.hpp"
+
+#include "../attack_prediction.hpp"
+#include "../config.hpp"
+#include "../filesystem.hpp"
+#include "../log.hpp"
+#include "../pathfind/pathfind.hpp"
+#include "composite/aspect.hpp"
+#include "../serialization/parser.hpp"
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/foreach.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <vector>
+
+static lg::log_domain log_ai_profiler("ai/profiler");
+#define LOG_AI_PROFILER LOG_STREAM(info, log_ai_profiler)
+#define ERR_AI_PROFILER LOG_STREAM(err, log_ai_profiler)
+
+namespace ai {
+
+bool profiler::enabled_ = false;
+
+namespace {
+
+struct record_key
+{
+	int side;
+	profiler::category what;
+	std::string name;
+
+	bool operator<(const record_key& other) const
+	{
+		if(side != other.side) {
+			return side < other.side;
+		}
+		if(what != other.what) {
+			return what < other.what;
+		}
+		return name < other.name;
+	}
+};
+
+typedef std::map<record_key, profiler::record> record_map;
+
+record_map& records()
+{
+	static record_map records;
+	return records;
+}
+
+/** The counters of the pathfinding and combat code, in a record. */
+profiler::record current_counters()
+{
+	const pathfind::search_statistics searches = pathfind::get_search_statistics();
+	const combat_cache::statistics fights = combat_cache::get_statistics();
+	profiler::record res;
+	res.route_searches = searches.routes;
+	res.astar_searches = searches.astar;
+	res.fights = fights.hits + fights.misses;
+	res.simulated_fights = fights.misses;
+	return res;
+}
+
+void write_record(config& cfg, const profiler::record& r)
+{
+	cfg["calls"] = static_cast<int>(r.calls);
+	cfg["seconds"] = r.seconds;
+	cfg["route_searches"] = static_cast<int>(r.route_searches);
+	cfg["astar_searches"] = static_cast<int>(r.astar_searches);
+	cfg["fights"] = static_cast<int>(r.fights);
+	cfg["simulated_fights"] = static_cast<int>(r.simulated_fights);
+}
+
+std::string json_string(const std::string& str)
+{
+	std::string res = "\"";
+	BOOST_FOREACH(const char c, str) {
+		if(c == '"' || c == '\\') {
+			res += '\\';
+			res += c;
+		} else if(static_cast<unsigned char>(c) < 0x20) {
+			std::ostringstream escaped;
+			escaped << "\\u" << std::hex << std::setw(4) << std::setfill('0') << int(c);
+			res += escaped.str();
+		} else {
+			res += c;
+		}
+	}
+	return res + '"';
+}
+
+/** The value as JSON, numbers unquoted. */
+std::string json_value(const config::attribute_value& value)
+{
+	const std::string str = value.str();
+	if(!str.empty()) {
+		char* end = NULL;
+		strtod(str.c_str(), &end);
+		if(*end == '\0') {
+			return str;
+		}
+	}
+	return json_string(str);
+}
+
+/** Appends @a cfg as an object; children with the same tag become an array. */
+void write_json(std::ostream& out, const config& cfg)
+{
+	out << '{';
+	bool first = true;
+	BOOST_FOREACH(const config::attribute& a, cfg.attribute_range()) {
+		out << (first ? "" : ",") << json_string(a.first) << ':' << json_value(a.second);
+		first = false;
+	}
+
+	std::vector<std::string> tags;
+	BOOST_FOREACH(const config::any_child& c, cfg.all_children_range()) {
+		if(std::find(tags.begin(), tags.end(), c.key) == tags.end()) {
+			tags.push_back(c.key);
+		}
+	}
+	BOOST_FOREACH(const std::string& tag, tags) {
+		out << (first ? "" : ",") << json_string(tag) << ":[";
+		first = false;
+		bool first_child = true;
+		BOOST_FOREACH(const config& child, cfg.child_range(tag)) {
+			if(!first_child) {
+				out << ',';
+			}
+			first_child = false;
+			write_json(out, child);
+		}
+		out << ']';
+	}
+	out << '}';
+}
+
+}
+
+profiler::record::record()
+	: calls(0)
+	, seconds(0)
+	, route_searches(0)
+	, astar_searches(0)
+	, fights(0)
+	, simulated_fights(0)
+{
+}
+
+profiler::scope::scope(category what, int side, const std::string& name)
+	: record_(NULL)
+	, start_()
+	, counters_()
+{
+	if(!enabled_) {
+		return;
+	}
+	const record_key key = { side, what, name };
+	record_ = &records()[key];
+	counters_ = current_counters();
+	start_ = boost::posix_time::microsec_clock::universal_time();
+}
+
+profiler::scope::~scope()
+{
+	if(!record_) {
+		return;
+	}
+	const boost::posix_time::time_duration elapsed =
+		boost::posix_time::microsec_clock::universal_time() - start_;
+	const record now = current_counters();
+
+	++record_->calls;
+	record_->seconds += elapsed.total_microseconds() / 1e6;
+	record_->route_searches += now.route_searches - counters_.route_searches;
+	record_->astar_searches += now.astar_searches - counters_.astar_searches;
+	record_->fights += now.fights - counters_.fights;
+	record_->simulated_fights += now.simulated_fights - counters_.simulated_fights;
+}
+
+void profiler::set_enabled(bool enabled)
+{
+	LOG_AI_PROFILER << (enabled ? "enabling" : "disabling") << " the AI profiler" << std::endl;
+	enabled_ = enabled;
+}
+
+void profiler::reset()
+{
+	// Scopes still alive point to their records; leave them be.
+	BOOST_FOREACH(record_map::value_type& r, records()) {
+		r.second = record();
+	}
+}
+
+config profiler::to_config()
+{
+	config res;
+	config& profile = res.add_child("ai_profile");
+	config* side_cfg = NULL;
+	std::map<std::string, config*> cas;
+	int side = 0;
+	BOOST_FOREACH(const record_map::value_type& r, records()) {
+		const record_key& key = r.first;
+		if(r.second.calls == 0) {
+			continue;
+		}
+		if(!side_cfg || key.side != side) {
+			side = key.side;
+			side_cfg = &profile.add_child("side");
+			(*side_cfg)["side"] = side;
+			cas.clear();
+		}
+
+		switch(key.what) {
+		case TURN:
+			write_record(side_cfg->add_child("turn"), r.second);
+			break;
+		case EVALUATE:
+		case EXECUTE: {
+			config*& ca = cas[key.name];
+			if(!ca) {
+				ca = &side_cfg->add_child("candidate_action");
+				(*ca)["name"] = key.name;
+			}
+			write_record(ca->add_child(key.what == EVALUATE ? "evaluate" : "execute"), r.second);
+			break;
+		}
+		case ASPECT: {
+			config& aspect = side_cfg->add_child("aspect");
+			aspect["name"] = key.name;
+			write_record(aspect, r.second);
+			break;
+		}
+		}
+	}
+
+	const aspect::statistics& aspects = aspect::get_statistics();
+	config& cache = profile.add_child("aspect_cache");
+	cache["hits"] = static_cast<int>(aspects.hits);
+	cache["misses"] = static_cast<int>(aspects.misses);
+	cache["kept"] = static_cast<int>(aspects.kept);
+	return res;
+}
+
+std::string profiler::to_json()
+{
+	std::ostringstream out;
+	write_json(out, to_config());
+	return out.str();
+}
+
+std::string profiler::summary()
+{
+	// The candidate actions, by the time their evaluation and execution took.
+	std::vector<std::pair<double, std::string> > cas;
+	BOOST_FOREACH(const record_map::value_type& r, records()) {
+		if(r.second.calls == 0 || (r.first.what != EVALUATE && r.first.what != EXECUTE)) {
+			continue;
+		}
+		std::ostringstream line;
+		line << "side " << r.first.side << ' ' << r.first.name
+			<< (r.first.what == EVALUATE ? " evaluate: " : " execute: ")
+			<< r.second.calls << " calls, " << r.second.seconds << " s, "
+			<< r.second.route_searches << " route searches, "
+			<< r.second.astar_searches << " A* searches, "
+			<< r.second.simulated_fights << '/' << r.second.fights << " fights simulated";
+		cas.push_back(std::make_pair(r.second.seconds, line.str()));
+	}
+	std::sort(cas.rbegin(), cas.rend());
+
+	std::ostringstream res;
+	res << (enabled_ ? "AI profiling is on." : "AI profiling is off.");
+	const aspect::statistics& aspects = aspect::get_statistics();
+	res << "\naspects: " << aspects.hits << " cached, " << aspects.misses << " recalculated, "
+		<< aspects.kept << " invalidations avoided by their dependencies";
+	const size_t shown = std::min<size_t>(cas.size(), 10);
+	for(size_t i = 0; i != shown; ++i) {
+		res << '\n' << cas[i].second;
+	}
+	return res.str();
+}
+
+void profiler::write_report()
+{
+	if(!enabled_ || records().empty()) {
+		return;
+	}
+	const std::string base = filesystem::get_user_data_dir() + "/ai_profile";
+	try {
+		{
+			filesystem::scoped_ostream out = filesystem::ostream_file(base + ".cfg");
+			write(*out, to_config());
+		}
+		{
+			filesystem::scoped_ostream out = filesystem::ostream_file(base + ".json");
+			*out << to_json() << '\n';
+		}
+		LOG_AI_PROFILER << "wrote the AI profile to " << base << ".cfg and .json" << std::endl;
+	} catch(filesystem::io_exception& e) {
+		ERR_AI_PROFILER << "could not write the AI profile: " << e.what() << std::endl;
+	}
+}
+
+}
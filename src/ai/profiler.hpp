@@ -0,0 +1,113 @@
+/*
+   Copyright (C) 2015 by the Battle for Wesnoth Project
+   Part of the Battle for Wesnoth Project http://www.wesnoth.org/
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY.
+
+   See the COPYING file for more details.
+*/
+
+/**
+ * @file
+ * Timing and counters of what the AI does during its turns.
+ */
+
+#ifndef AI_PROFILER_HPP_INCLUDED
+#define AI_PROFILER_HPP_INCLUDED
+
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/noncopyable.hpp>
+
+#include <cstddef>
+#include <string>
+
+class config;
+
+namespace ai {
+
+/**
+ * Where the time of the AI turns goes.
+ *
+ * For every side, the profiler counts how often each candidate action was
+ * evaluated and executed and each aspect recalculated, the wall time these
+ * took, and the path searches and fight simulations done meanwhile. Times
+ * and counts are inclusive: an aspect recalculated while evaluating a
+ * candidate action is accounted to both.
+ *
+ * Profiling is off unless enabled with --ai-profile or the :ai_profile
+ * command; the hooks then cost a flag test. Like the rest of the AI, it
+ * must only be used from the main thread.
+ */
+class profiler
+{
+public:
+	/** What is being measured. */
+	enum category { TURN, EVALUATE, EXECUTE, ASPECT };
+
+	/** The totals of one candidate action, aspect or side. */
+	struct record
+	{
+		record();
+
+		size_t calls;
+		double seconds;
+		/** find_routes() runs (reach, vision and cost maps) and A* searches. */
+		size_t route_searches, astar_searches;
+		/** Fights asked to combatant::fight(), and those not found in its cache. */
+		size_t fights, simulated_fights;
+	};
+
+	/**
+	 * Adds the time and counters of its lifetime to the record of @a name,
+	 * if profiling is enabled.
+	 */
+	class scope
+		: private boost::noncopyable
+	{
+	public:
+		scope(category what, int side, const std::string& name);
+		~scope();
+
+	private:
+		record* record_;
+		boost::posix_time::ptime start_;
+		record counters_;
+	};
+
+	static bool enabled() { return enabled_; }
+	static void set_enabled(bool enabled);
+
+	/** Drops everything recorded so far. */
+	static void reset();
+
+	/**
+	 * The records as
+	 * [ai_profile] [side] side=, [turn], [candidate_action] name=,
+	 * [aspect] name= [/side] [aspect_cache] [/ai_profile].
+	 */
+	static config to_config();
+
+	/** The same as to_config(), as a JSON object. */
+	static std::string to_json();
+
+	/** A short text summary of the candidate actions taking the most time. */
+	static std::string summary();
+
+	/**
+	 * Writes ai_profile.cfg and ai_profile.json to the userdata directory,
+	 * if profiling is enabled. Called when a game ends.
+	 */
+	static void write_report();
+
+private:
+	static bool enabled_;
+};
+
+}
+
+#endif
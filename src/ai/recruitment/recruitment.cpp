@@ -111,6 +111,9 @@ recruitment::recruitment(rca_context& context, const config& cfg)
 		  important_terrain_(),
 		  own_units_in_combat_counter_(0),
 		  average_local_cost_(),
+		  average_local_cost_revision_(0),
+		  average_local_cost_recruits_(),
+		  cost_map_cache_(),
 		  cheapest_unit_costs_(),
 		  combat_cache_(),
 		  recruit_situation_change_observer_(),
@@ -676,39 +679,92 @@ double recruitment::get_average_defense(const std::string& u_type) const {
  * b) how many units can reach this hex
  * for all units of side.
  */
-const  pathfind::full_cost_map recruitment::get_cost_map_of_side(int side) const {
+const pathfind::full_cost_map& recruitment::get_cost_map_of_side(int side) {
 	const unit_map& units = *resources::units;
 	const team& team = (*resources::teams)[side - 1];
 
-	pathfind::full_cost_map cost_map(true, true, team, true, true);
-
-	// First add all existing units to cost_map.
-	unsigned int unit_count = 0;
+	// First collect all existing units.
+	std::vector<const unit*> side_units;
+	std::multiset<cost_map_source> sources;
+	bool reusable = true;
 	BOOST_FOREACH(const unit& unit, units) {
 		if (unit.side() != side || unit.can_recruit() ||
 				unit.incapacitated() || unit.total_movement() <= 0) {
 			continue;
 		}
-		++unit_count;
-		cost_map.add_unit(unit);
+		side_units.push_back(&unit);
+		sources.insert(cost_map_source(unit));
+		// Where teleporters can go depends on the villages owned.
+		if (unit.get_ability_bool("teleport")) {
+			reusable = false;
+		}
 	}
+	unsigned int unit_count = side_units.size();
 
 	// If this side has not so many units yet, add unit_types with the leaders position as origin.
+	std::vector<std::pair<map_location, std::string> > type_units;
 	if (unit_count < UNIT_THRESHOLD) {
 		std::vector<unit_map::const_iterator> leaders = units.find_leaders(side);
 		BOOST_FOREACH(const unit_map::const_iterator& leader, leaders) {
 			// First add team-recruits (it's fine when (team-)recruits are added multiple times).
 			BOOST_FOREACH(const std::string& recruit, team.recruits()) {
-				cost_map.add_unit(leader->get_location(), unit_types.find(recruit), side);
+				type_units.push_back(std::make_pair(leader->get_location(), recruit));
 			}
 
 			// Next add extra-recruits.
 			BOOST_FOREACH(const std::string& recruit, leader->recruits()) {
-				cost_map.add_unit(leader->get_location(), unit_types.find(recruit), side);
+				type_units.push_back(std::make_pair(leader->get_location(), recruit));
 			}
 		}
 	}
-	return cost_map;
+	for (size_t i = 0; i != type_units.size(); ++i) {
+		sources.insert(cost_map_source(type_units[i].first, type_units[i].second));
+	}
+
+	// Reuse the cost map of the last execution if nothing it was built from changed,
+	// or add what was added since (e.g. the units recruited last time).
+	cached_cost_map& cached = cost_map_cache_[side];
+	const unsigned map_revision = resources::gameboard->map().revision();
+	const bool extend = cached.cost_map && cached.reusable && reusable &&
+			cached.map_revision == map_revision &&
+			std::includes(sources.begin(), sources.end(),
+					cached.sources.begin(), cached.sources.end());
+	if (extend && sources.size() == cached.sources.size()) {
+		return *cached.cost_map;
+	}
+	if (!extend) {
+		cached.cost_map.reset(new pathfind::full_cost_map(true, true, team, true, true));
+		cached.sources.clear();
+	}
+
+	std::multiset<cost_map_source> added;
+	std::set_difference(sources.begin(), sources.end(),
+			cached.sources.begin(), cached.sources.end(),
+			std::inserter(added, added.end()));
+
+	std::vector<const unit*> added_units;
+	BOOST_FOREACH(const unit* unit, side_units) {
+		std::multiset<cost_map_source>::iterator source = added.find(cost_map_source(*unit));
+		if (source != added.end()) {
+			added.erase(source);
+			added_units.push_back(unit);
+		}
+	}
+	cached.cost_map->add_units(added_units);
+	for (size_t i = 0; i != type_units.size(); ++i) {
+		std::multiset<cost_map_source>::iterator source =
+				added.find(cost_map_source(type_units[i].first, type_units[i].second));
+		if (source != added.end()) {
+			added.erase(source);
+			cached.cost_map->add_unit(type_units[i].first,
+					unit_types.find(type_units[i].second), side);
+		}
+	}
+
+	cached.sources.swap(sources);
+	cached.map_revision = map_revision;
+	cached.reusable = reusable;
+	return *cached.cost_map;
 }
 
 /**
@@ -738,7 +794,12 @@ void recruitment::update_average_lawful_bonus() {
 		++counter;
 	}
 	if (counter > 0) {
-		average_lawful_bonus_ = round_double(static_cast<double>(sum) / counter);
+		const int average_lawful_bonus = round_double(static_cast<double>(sum) / counter);
+		// The cached combat values were simulated with the old bonus.
+		if (average_lawful_bonus != average_lawful_bonus_) {
+			combat_cache_.clear();
+		}
+		average_lawful_bonus_ = average_lawful_bonus;
 	}
 }
 
@@ -747,9 +808,16 @@ void recruitment::update_average_lawful_bonus() {
  * Creates a map where each hex is mapped to the average cost of the terrain for our units.
  */
 void recruitment::update_average_local_cost() {
-	average_local_cost_.clear();
 	const gamemap& map = resources::gameboard->map();
 	const team& team = (*resources::teams)[get_side() - 1];
+	// This only depends on the terrain and our recruits.
+	if (!average_local_cost_.empty() && average_local_cost_revision_ == map.revision() &&
+			average_local_cost_recruits_ == team.recruits()) {
+		return;
+	}
+	average_local_cost_.clear();
+	average_local_cost_revision_ = map.revision();
+	average_local_cost_recruits_ = team.recruits();
 
 	for(int x = 0; x < map.w(); ++x) {
 		for (int y = 0; y < map.h(); ++y) {
@@ -897,11 +965,11 @@ double recruitment::compare_unit_types(const std::string& a, const std::string&
 		double value_of_b = damage_to_a / (a_max_hp * b_cost);
 
 		if (value_of_a > value_of_b) {
-			return value_of_a / value_of_b;
+			retval = value_of_a / value_of_b;
 		} else if (value_of_a < value_of_b) {
-			return -value_of_b / value_of_a;
+			retval = -value_of_b / value_of_a;
 		} else {
-			return 0.;
+			retval = 0.;
 		}
 	}
 
@@ -27,6 +27,7 @@
 
 #include <boost/foreach.hpp>
 #include <boost/optional.hpp>
+#include <boost/shared_ptr.hpp>
 #include <iomanip>
 
 #ifdef _MSC_VER
@@ -109,13 +110,63 @@ struct cached_combat_value {
 		a_defense(a_def), b_defense(b_def), value(v) {
 	}
 	bool operator<(const cached_combat_value& o) const {
-		return value < o.value;
+		if (a_defense != o.a_defense) {
+			return a_defense < o.a_defense;
+		}
+		return b_defense < o.b_defense;
 	}
 };
 
 typedef std::map<std::string, std::set<cached_combat_value> > table_row;
 typedef std::map<std::string, table_row> cache_table;
 
+/**
+ * One unit (or unit type placed at a leader) a cost map of a side was built from.
+ * underlying_id is 0 for unit types, and type only set for them.
+ */
+struct cost_map_source {
+	size_t underlying_id;
+	map_location location;
+	std::string type;
+	int moves;
+	bool slowed;
+	explicit cost_map_source(const unit& u) :
+		underlying_id(u.underlying_id()), location(u.get_location()), type(),
+		moves(u.total_movement()), slowed(u.get_state(unit::STATE_SLOWED)) {
+	}
+	cost_map_source(const map_location& loc, const std::string& t) :
+		underlying_id(0), location(loc), type(t), moves(0), slowed(false) {
+	}
+	bool operator<(const cost_map_source& o) const {
+		if (underlying_id != o.underlying_id) {
+			return underlying_id < o.underlying_id;
+		}
+		if (location != o.location) {
+			return location < o.location;
+		}
+		if (moves != o.moves) {
+			return moves < o.moves;
+		}
+		if (slowed != o.slowed) {
+			return slowed < o.slowed;
+		}
+		return type < o.type;
+	}
+};
+
+/**
+ * The cost map of a side from an earlier execution, and what it was built from.
+ * Since cost maps are sums over units, units added since can just be added to it.
+ */
+struct cached_cost_map {
+	boost::shared_ptr<pathfind::full_cost_map> cost_map;
+	std::multiset<cost_map_source> sources;
+	unsigned map_revision;
+	bool reusable;
+	cached_cost_map() : cost_map(), sources(), map_revision(0), reusable(false) {
+	}
+};
+
 class recruitment : public candidate_action {
 public:
 	recruitment(rca_context &context, const config &cfg);
@@ -139,7 +190,7 @@ private:
 			const pathfind::full_cost_map& my_cost_map,
 			const pathfind::full_cost_map& enemy_cost_map);
 	double get_average_defense(const std::string& unit_type) const;
-	const pathfind::full_cost_map get_cost_map_of_side(int side) const;
+	const pathfind::full_cost_map& get_cost_map_of_side(int side);
 	void show_important_hexes() const;  //Debug only
 	void update_average_lawful_bonus();
 	void update_average_local_cost();
@@ -207,6 +258,9 @@ private:
 	terrain_count_map important_terrain_;
 	int own_units_in_combat_counter_;
 	std::map<map_location, double> average_local_cost_;
+	unsigned average_local_cost_revision_;
+	std::set<std::string> average_local_cost_recruits_;
+	std::map<int, cached_cost_map> cost_map_cache_;
 	std::map<size_t, int> cheapest_unit_costs_;
 	cache_table combat_cache_;
 	enum states {NORMAL, SAVE_GOLD, SPEND_ALL_GOLD, LEADER_IN_DANGER};
@@ -0,0 +1,335 @@
+/*
+   Copyright (C) 2015 by the Battle for Wesnoth Project
+   Part of the Battle for Wesnoth Project http://www.wesnoth.org/
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY.
+
+   See the COPYING file for more details.
+*/
+
+/**
+ * @file
+ * A copy-on-write view of the game state, for AI lookahead.
+ */
+
+#include "simulated_state.hpp"
+
+#include "../game_board.hpp"
+#include "../game_config.hpp"
+#include "../log.hpp"
+#include "../map.hpp"
+#include "../resources.hpp"
+#include "../team.hpp"
+#include "../unit.hpp"
+#include "../unit_helper.hpp"
+#include "../unit_map.hpp"
+#include "../unit_types.hpp"
+
+#include <cassert>
+
+namespace ai {
+
+static lg::log_domain log_ai_sim_state("ai/sim_state");
+#define DBG_AI_SIM_STATE LOG_STREAM(debug, log_ai_sim_state)
+#define LOG_AI_SIM_STATE LOG_STREAM(info, log_ai_sim_state)
+#define ERR_AI_SIM_STATE LOG_STREAM(err, log_ai_sim_state)
+
+simulated_state::simulated_state()
+	: base_units_(resources::units)
+	, base_teams_(resources::teams)
+	, map_(&resources::gameboard->map())
+	, units_()
+	, village_owners_()
+	, gold_()
+	, rng_()
+{
+	assert(base_units_ && base_teams_);
+	// Fill the lazily computed enemy tables, so that forks used in other
+	// threads only read them.
+	for(std::vector<team>::const_iterator t = base_teams_->begin(); t != base_teams_->end(); ++t) {
+		t->is_enemy(1);
+	}
+}
+
+simulated_state::simulated_state(const unit_map& units, const std::vector<team>& teams,
+		const gamemap& map)
+	: base_units_(&units)
+	, base_teams_(&teams)
+	, map_(&map)
+	, units_()
+	, village_owners_()
+	, gold_()
+	, rng_()
+{
+	for(std::vector<team>::const_iterator t = base_teams_->begin(); t != base_teams_->end(); ++t) {
+		t->is_enemy(1);
+	}
+}
+
+const unit* simulated_state::find_unit(const map_location& loc) const
+{
+	std::map<map_location, unit_pointer>::const_iterator changed = units_.find(loc);
+	if(changed != units_.end()) {
+		return changed->second.get();
+	}
+	unit_map::const_iterator base = base_units_->find(loc);
+	return base != base_units_->end() ? &*base : NULL;
+}
+
+std::vector<const unit*> simulated_state::units() const
+{
+	std::vector<const unit*> result;
+	result.reserve(base_units_->size() + units_.size());
+	for(unit_map::const_iterator u = base_units_->begin(); u != base_units_->end(); ++u) {
+		if(units_.count(u->get_location()) == 0) {
+			result.push_back(&*u);
+		}
+	}
+	for(std::map<map_location, unit_pointer>::const_iterator u = units_.begin(); u != units_.end(); ++u) {
+		if(u->second) {
+			result.push_back(u->second.get());
+		}
+	}
+	return result;
+}
+
+int simulated_state::village_owner(const map_location& loc) const
+{
+	std::map<map_location, int>::const_iterator changed = village_owners_.find(loc);
+	if(changed != village_owners_.end()) {
+		return changed->second;
+	}
+	for(size_t i = 0; i != base_teams_->size(); ++i) {
+		if((*base_teams_)[i].owns_village(loc)) {
+			return i + 1;
+		}
+	}
+	return 0;
+}
+
+int simulated_state::gold(int side) const
+{
+	std::map<int, int>::const_iterator changed = gold_.find(side);
+	if(changed != gold_.end()) {
+		return changed->second;
+	}
+	return (*base_teams_)[side-1].gold();
+}
+
+bool simulated_state::fogged(int side, const map_location& loc) const
+{
+	return (*base_teams_)[side-1].fogged(loc);
+}
+
+bool simulated_state::attack(const map_location& attacker_loc, const map_location& defender_loc,
+		double attacker_hp, double defender_hp)
+{
+	unit* attacker = modify_unit(attacker_loc);
+	unit* defender = modify_unit(defender_loc);
+	if(!attacker || !defender) {
+		return false;
+	}
+
+	DBG_AI_SIM_STATE << attacker->type_name() << " at " << attacker_loc << " attack "
+		<< defender->type_name() << " at " << defender_loc << std::endl;
+
+	attacker->set_hitpoints(static_cast<int>(attacker_hp));
+	defender->set_hitpoints(static_cast<int>(defender_hp));
+
+	// Same experience rules as simulated_attack().
+	int attacker_xp = defender->level();
+	int defender_xp = attacker->level();
+	const bool attacker_died = attacker->hitpoints() <= 0;
+	const bool defender_died = defender->hitpoints() <= 0;
+	if(attacker_died) {
+		attacker_xp = 0;
+		defender_xp = game_config::kill_xp(attacker->level());
+	}
+	if(defender_died) {
+		defender_xp = 0;
+		attacker_xp = game_config::kill_xp(defender->level());
+	}
+
+	if(attacker_died) {
+		units_[attacker_loc].reset();
+	} else {
+		attacker->set_experience(attacker->experience() + attacker_xp);
+		advance_unit(attacker_loc);
+		stopunit(attacker_loc, true, true);
+	}
+	if(defender_died) {
+		units_[defender_loc].reset();
+	} else {
+		defender->set_experience(defender->experience() + defender_xp);
+		advance_unit(defender_loc);
+		stopunit(defender_loc, true, true);
+	}
+
+	return true;
+}
+
+bool simulated_state::move(int side, const map_location& from, const map_location& to, int steps)
+{
+	if(from == to) {
+		return find_unit(from) != NULL;
+	}
+	if(find_unit(to) || !modify_unit(from)) {
+		return false;
+	}
+
+	unit_pointer moved = units_[from];
+	units_[from].reset();
+	moved->set_location(to);
+	moved->set_movement(moved->movement_left() - steps);
+	units_[to] = moved;
+
+	DBG_AI_SIM_STATE << moved->type_name() << " move from " << from << " to " << to << std::endl;
+
+	if(map_->is_village(to)) {
+		check_village(to, side);
+	}
+	return true;
+}
+
+bool simulated_state::recruit(int side, const unit_type& type, const map_location& loc)
+{
+	if(find_unit(loc)) {
+		return false;
+	}
+
+	// Like simulated_recruit(), random traits, name and gender are not needed.
+	const unit recruit_unit(type, side, false);
+	place_unit(recruit_unit, loc);
+	gold_[side] = gold(side) - type.cost();
+
+	DBG_AI_SIM_STATE << "recruit " << type.type_name() << " at " << loc
+		<< " spend " << type.cost() << " gold" << std::endl;
+	return true;
+}
+
+bool simulated_state::stopunit(const map_location& loc, bool remove_movement, bool remove_attacks)
+{
+	if(!remove_movement && !remove_attacks) {
+		return false;
+	}
+	unit* u = modify_unit(loc);
+	if(!u) {
+		return false;
+	}
+	if(remove_movement) {
+		u->set_movement(0, true);
+	}
+	if(remove_attacks) {
+		u->set_attacks(0);
+	}
+	return true;
+}
+
+unit* simulated_state::modify_unit(const map_location& loc)
+{
+	std::map<map_location, unit_pointer>::iterator changed = units_.find(loc);
+	if(changed != units_.end()) {
+		unit_pointer& u = changed->second;
+		if(u && !u.unique()) {
+			// Shared with a fork, so copy it before writing.
+			u.reset(new unit(*u));
+		}
+		return u.get();
+	}
+
+	unit_map::const_iterator base = base_units_->find(loc);
+	if(base == base_units_->end()) {
+		return NULL;
+	}
+	unit_pointer& u = units_[loc];
+	u.reset(new unit(*base));
+	return u.get();
+}
+
+bool simulated_state::has_leader(int side) const
+{
+	const std::vector<const unit*> all = units();
+	for(std::vector<const unit*>::const_iterator u = all.begin(); u != all.end(); ++u) {
+		if((*u)->side() == side && (*u)->can_recruit()) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void simulated_state::check_village(const map_location& loc, int side)
+{
+	// The rules of helper_check_village() in simulated_actions.cpp.
+	const bool valid_side = unsigned(side - 1) < base_teams_->size();
+	int owner = village_owner(loc);
+	if(valid_side && owner == side) {
+		return;
+	}
+
+	const bool leader = has_leader(side);
+	if(owner != 0 && (!valid_side || leader || (*base_teams_)[side-1].is_enemy(owner))) {
+		owner = 0;
+	}
+	if(valid_side && leader) {
+		owner = side;
+	}
+	village_owners_[loc] = owner;
+}
+
+void simulated_state::place_unit(const unit& u, const map_location& loc)
+{
+	unit_pointer placed(new unit(u));
+	placed->set_location(loc);
+	placed->set_movement(0, true);
+	placed->set_attacks(0);
+	placed->heal_all();
+	units_[loc] = placed;
+
+	if(map_->is_village(loc)) {
+		check_village(loc, placed->side());
+	}
+}
+
+void simulated_state::advance_unit(const map_location& loc)
+{
+	const unit* current = find_unit(loc);
+	if(!current || !current->advances()) {
+		return;
+	}
+	const int options_num = unit_helper::number_of_possible_advances(*current);
+	if(options_num <= 0) {
+		return;
+	}
+
+	unit* u = modify_unit(loc);
+	const std::vector<std::string> options = u->advances_to();
+	const size_t advance_choice = rng_() % options_num;
+	const std::string old_type = u->type_name();
+
+	u->set_experience(u->experience() - u->max_experience());
+	if(advance_choice < options.size()) {
+		const unit_type *advanced_type = unit_types.find(options[advance_choice]);
+		if(!advanced_type) {
+			ERR_AI_SIM_STATE << "Simulating advancing to unknown unit type: " << options[advance_choice] << std::endl;
+			assert(false && "simulating to unknown unit type");
+			return;
+		}
+		u->advance_to(*advanced_type);
+		u->heal_all();
+		u->set_state(unit::STATE_POISONED, false);
+		u->set_state(unit::STATE_SLOWED, false);
+		u->set_state(unit::STATE_PETRIFIED, false);
+	} else {
+		const std::vector<config> mod_options = u->get_modification_advances();
+		u->add_modification("advance", mod_options[advance_choice - options.size()]);
+	}
+
+	LOG_AI_SIM_STATE << old_type << " at " << loc << " advanced to " << u->type_name() << std::endl;
+}
+
+}
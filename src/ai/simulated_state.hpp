@@ -0,0 +1,121 @@
+/*
+   Copyright (C) 2015 by the Battle for Wesnoth Project
+   Part of the Battle for Wesnoth Project http://www.wesnoth.org/
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY.
+
+   See the COPYING file for more details.
+*/
+
+/**
+ * @file
+ * A copy-on-write view of the game state, for AI lookahead.
+ */
+
+#ifndef AI_SIMULATED_STATE_HPP_INCLUDED
+#define AI_SIMULATED_STATE_HPP_INCLUDED
+
+#include "../map_location.hpp"
+
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <map>
+#include <vector>
+
+class gamemap;
+class team;
+class unit;
+class unit_map;
+class unit_type;
+
+namespace ai {
+
+/**
+ * The units, villages and gold of the game, as changed by a sequence of
+ * simulated actions.
+ *
+ * Unlike the simulated_* functions, which change the real unit map and
+ * teams and rely on the caller to restore them, a simulated_state only
+ * records the differences to the game state it was made from. Copying one
+ * is the way to fork it: the copy shares the units neither side changed,
+ * and a unit is only duplicated the first time one of the states changes
+ * it. So a few actions can be tried, or answered by the enemy, without
+ * copying the whole unit map for every branch.
+ *
+ * The forks of a state do not share anything mutable, so they can be used
+ * from different threads, as long as the game state they are based on does
+ * not change meanwhile. Recruiting still hands out unit ids through the
+ * global id manager though, and only the main thread should do that.
+ *
+ * Fog and shroud are those of the base state: simulated moves do not clear
+ * any, as that would need the vision code, which reads the real unit map.
+ */
+class simulated_state
+{
+public:
+	/** Starts from the current game state (resources::units and teams). */
+	simulated_state();
+
+	simulated_state(const unit_map& units, const std::vector<team>& teams,
+			const gamemap& map);
+
+	/** The unit at @a loc, or NULL if there is none. */
+	const unit* find_unit(const map_location& loc) const;
+
+	/** All the units, in no particular order. */
+	std::vector<const unit*> units() const;
+
+	/** The side owning the village at @a loc, or 0. */
+	int village_owner(const map_location& loc) const;
+
+	int gold(int side) const;
+
+	/** Whether @a loc is fogged or shrouded for @a side, in the base state. */
+	bool fogged(int side, const map_location& loc) const;
+
+	/** The number of changed (moved, hurt, killed...) units. */
+	size_t changed_units() const { return units_.size(); }
+
+	/**
+	 * The counterparts of the simulated_* functions.
+	 * They return false if the action could not be done.
+	 */
+	bool attack(const map_location& attacker_loc, const map_location& defender_loc,
+			double attacker_hp, double defender_hp);
+	bool move(int side, const map_location& from, const map_location& to, int steps);
+	bool recruit(int side, const unit_type& type, const map_location& loc);
+	bool stopunit(const map_location& loc, bool remove_movement, bool remove_attacks);
+
+private:
+	typedef boost::shared_ptr<unit> unit_pointer;
+
+	/** The unit at @a loc, copied first if it is shared with another state. */
+	unit* modify_unit(const map_location& loc);
+
+	bool has_leader(int side) const;
+	void check_village(const map_location& loc, int side);
+	void place_unit(const unit& u, const map_location& loc);
+	void advance_unit(const map_location& loc);
+
+	const unit_map* base_units_;
+	const std::vector<team>* base_teams_;
+	const gamemap* map_;
+
+	/** The changed hexes; a NULL pointer means the hex got empty. */
+	std::map<map_location, unit_pointer> units_;
+	std::map<map_location, int> village_owners_;
+	std::map<int, int> gold_;
+
+	/** Picks the advancements, as rand() is not safe to use from threads. */
+	boost::mt19937 rng_;
+};
+
+}
+
+#endif
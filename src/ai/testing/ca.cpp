@@ -322,9 +322,6 @@ bool recruitment_phase::recruit_usage(const std::string& usage)
 	log_scope2(log_ai_testing_ai_default, "recruiting troops");
 	LOG_AI_TESTING_AI_DEFAULT << "recruiting '" << usage << "'\n";
 
-	//make sure id, usage and cost are known for the coming evaluation of unit types
-	unit_types.build_all(unit_type::HELP_INDEXED);
-
 	std::vector<std::string> options;
 	bool found = false;
 	// Find an available unit that can be recruited,
@@ -577,14 +574,22 @@ double combat_phase::evaluate()
 	const int max_positions = 30000;
 	const int skip_num = analysis.size()/max_positions;
 
-	std::vector<attack_analysis>::const_iterator choice_it = analysis.end();
-	for(std::vector<attack_analysis>::const_iterator it = analysis.begin();
-			it != analysis.end(); ++it) {
-
-		if(skip_num > 0 && ((it - analysis.begin())%skip_num) && it->movements.size() > 1)
+	std::vector<size_t> candidates;
+	for(size_t i = 0; i != analysis.size(); ++i) {
+		if(skip_num > 0 && (i%skip_num) && analysis[i].movements.size() > 1)
 			continue;
+		candidates.push_back(i);
+	}
+
+	std::vector<double> ratings;
+	rate_attacks(analysis, candidates, get_aggression(), *this, ratings,
+	             attack_rating_workers());
 
-		const double rating = it->rating(get_aggression(),*this);
+	// Pick the first of the best rated, whichever thread rated them.
+	std::vector<attack_analysis>::const_iterator choice_it = analysis.end();
+	for(size_t i = 0; i != candidates.size(); ++i) {
+		const std::vector<attack_analysis>::const_iterator it = analysis.begin() + candidates[i];
+		const double rating = ratings[i];
 		LOG_AI_TESTING_AI_DEFAULT << "attack option rated at " << rating << " ("
 					  << (it->uses_leader ? get_leader_aggression() : get_aggression()) << ")\n";
 
@@ -30,6 +30,7 @@
 #include "../../terrain_filter.hpp"
 #include "../../pathfind/pathfind.hpp"
 
+#include <algorithm>
 #include <deque>
 
 namespace ai {
@@ -325,6 +326,17 @@ std::pair<map_location,map_location> testing_move_to_targets_phase::choose_move(
 
 	std::vector<rated_target>::iterator rated_tg = rated_targets.begin();
 
+	// locStopValue controls how quickly we give up on the A* search, due
+	// to it seeming futile. Be very cautious about changing this value,
+	// as it can cause the AI to give up on searches and just do nothing.
+	const double locStopValue = 500.0;
+
+	// The routes to the targets, in the order of rated_targets. The most
+	// promising target gets a search of its own, since it often is the only
+	// one considered; if it is not, the routes to all the others are found
+	// by a single search instead of one per target.
+	std::vector<pathfind::plain_route> routes(rated_targets.size());
+
 	for(; rated_tg != rated_targets.end(); ++rated_tg) {
 		const target& tg = *(rated_tg->tg);
 
@@ -333,11 +345,19 @@ std::pair<map_location,map_location> testing_move_to_targets_phase::choose_move(
 
 		raise_user_interact();
 
-		// locStopValue controls how quickly we give up on the A* search, due
-		// to it seeming futile. Be very cautious about changing this value,
-		// as it can cause the AI to give up on searches and just do nothing.
-		const double locStopValue = 500.0;
-		pathfind::plain_route real_route = a_star_search(u->get_location(), tg.loc, locStopValue, &cost_calc, map_.w(), map_.h());
+		const size_t route_index = rated_tg - rated_targets.begin();
+		if(route_index == 0) {
+			routes[0] = a_star_search(u->get_location(), tg.loc, locStopValue, &cost_calc, map_.w(), map_.h());
+		} else if(route_index == 1) {
+			std::vector<map_location> dsts;
+			for(std::vector<rated_target>::const_iterator i = rated_tg; i != rated_targets.end(); ++i) {
+				dsts.push_back(i->tg->loc);
+			}
+			const std::vector<pathfind::plain_route> others = pathfind::route_search_all(
+				u->get_location(), dsts, locStopValue, &cost_calc, map_.w(), map_.h());
+			std::copy(others.begin(), others.end(), routes.begin() + 1);
+		}
+		const pathfind::plain_route& real_route = routes[route_index];
 
 		if(real_route.steps.empty()) {
 			LOG_AI << "Can't reach target: " << locStopValue << " = " << tg.value << "/" << best_rating << "\n";
@@ -392,6 +412,12 @@ std::pair<map_location,map_location> testing_move_to_targets_phase::choose_move(
 				continue;
 			}
 
+			// The rating without a route is an upper bound of the real one,
+			// so units that cannot beat the best bid need no search.
+			if(rate_target(*best_target, u, dstsrc, enemy_dstsrc, dummy_route) <= best_rating) {
+				continue;
+			}
+
 			raise_user_interact();
 
 			const move_cost_calculator calc(*u, map_, units_, enemy_dstsrc);
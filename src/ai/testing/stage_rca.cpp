@@ -24,7 +24,9 @@
 #include "../composite/engine.hpp"
 #include "../composite/property_handler.hpp"
 #include "../gamestate_observer.hpp"
+#include "../profiler.hpp"
 #include "../../log.hpp"
+#include "../../thread.hpp"
 
 #include <boost/bind.hpp>
 #include <boost/foreach.hpp>
@@ -42,6 +44,7 @@ candidate_action_evaluation_loop::candidate_action_evaluation_loop( ai_context &
 	: stage(context,cfg)
 	, candidate_actions_()
 	, cfg_(cfg)
+	, parallel_evaluation_(cfg["parallel_evaluation"].to_bool())
 {
 }
 
@@ -68,6 +71,9 @@ void candidate_action_evaluation_loop::create_candidate_action(std::vector<candi
 config candidate_action_evaluation_loop::to_config() const
 {
 	config cfg = stage::to_config();
+	if (parallel_evaluation_) {
+		cfg["parallel_evaluation"] = true;
+	}
 	BOOST_FOREACH(candidate_action_ptr ca, candidate_actions_){
 		cfg.add_child("candidate_action",ca->to_config());
 	}
@@ -83,6 +89,61 @@ public:
 	}
 };
 
+namespace {
+
+/** Evaluates candidate actions; run() only touches the score of its index. */
+class evaluation_job : public threading::parallel_job {
+public:
+	evaluation_job(const std::vector<candidate_action_ptr>& batch, std::vector<double>& scores)
+		: batch_(batch), scores_(scores)
+	{
+	}
+
+	void run(size_t index)
+	{
+		scores_[index] = batch_[index]->evaluate();
+	}
+
+private:
+	const std::vector<candidate_action_ptr>& batch_;
+	std::vector<double>& scores_;
+};
+
+} // end anon namespace
+
+void candidate_action_evaluation_loop::evaluate_concurrently(size_t first, double best_score, std::map<size_t, double>& scores)
+{
+	std::vector<candidate_action_ptr> batch;
+	std::vector<size_t> indexes;
+	for (size_t i = first; i != candidate_actions_.size(); ++i) {
+		const candidate_action_ptr& ca_ptr = candidate_actions_[i];
+		if (!ca_ptr->is_enabled()) {
+			continue;
+		}
+		if (!ca_ptr->is_thread_safe() || ca_ptr->get_max_score() <= best_score) {
+			break;
+		}
+		batch.push_back(ca_ptr);
+		indexes.push_back(i);
+	}
+
+	BOOST_FOREACH(candidate_action_ptr ca_ptr, batch) {
+		ca_ptr->prepare_concurrent_evaluation();
+	}
+
+	DBG_AI_TESTING_RCA_DEFAULT << "Evaluating " << batch.size() << " candidate actions concurrently" << std::endl;
+	std::vector<double> batch_scores(batch.size(), candidate_action::BAD_SCORE);
+	evaluation_job job(batch, batch_scores);
+	{
+		const profiler::scope timer(profiler::EVALUATE, get_side(), "concurrent evaluation");
+		threading::run_parallel(job, batch.size());
+	}
+
+	for (size_t i = 0; i != batch.size(); ++i) {
+		scores[indexes[i]] = batch_scores[i];
+	}
+}
+
 bool candidate_action_evaluation_loop::do_play_stage()
 {
 	LOG_AI_TESTING_RCA_DEFAULT << "Starting candidate action evaluation loop for side "<< get_side() << std::endl;
@@ -101,8 +162,14 @@ bool candidate_action_evaluation_loop::do_play_stage()
 		double best_score = candidate_action::BAD_SCORE;
 		candidate_action_ptr best_ptr;
 
+		// Scores of candidate actions that were evaluated concurrently; the
+		// best one is still picked in order, as if they had been evaluated
+		// one after the other.
+		std::map<size_t, double> scores;
+
 		//Evaluation
-		BOOST_FOREACH(candidate_action_ptr ca_ptr, candidate_actions_){
+		for (size_t i = 0; i != candidate_actions_.size(); ++i) {
+			candidate_action_ptr ca_ptr = candidate_actions_[i];
 			if (!ca_ptr->is_enabled()){
 				DBG_AI_TESTING_RCA_DEFAULT << "Skipping disabled candidate action: "<< *ca_ptr << std::endl;
 				continue;
@@ -113,8 +180,17 @@ bool candidate_action_evaluation_loop::do_play_stage()
 				break;
 			}
 
-			DBG_AI_TESTING_RCA_DEFAULT << "Evaluating candidate action: "<< *ca_ptr << std::endl;
-			double score = ca_ptr->evaluate();
+			double score;
+			if (parallel_evaluation_ && ca_ptr->is_thread_safe()) {
+				if (scores.count(i) == 0) {
+					evaluate_concurrently(i, best_score, scores);
+				}
+				score = scores[i];
+			} else {
+				DBG_AI_TESTING_RCA_DEFAULT << "Evaluating candidate action: "<< *ca_ptr << std::endl;
+				const profiler::scope timer(profiler::EVALUATE, get_side(), ca_ptr->get_name());
+				score = ca_ptr->evaluate();
+			}
 			DBG_AI_TESTING_RCA_DEFAULT << "Evaluated candidate action to score "<< score << " : " << *ca_ptr << std::endl;
 
 			if (score>best_score) {
@@ -127,7 +203,10 @@ bool candidate_action_evaluation_loop::do_play_stage()
 		if (best_score>candidate_action::BAD_SCORE) {
 			DBG_AI_TESTING_RCA_DEFAULT << "Executing best candidate action: "<< *best_ptr << std::endl;
 			gamestate_observer gs_o;
-			best_ptr->execute();
+			{
+				const profiler::scope timer(profiler::EXECUTE, get_side(), best_ptr->get_name());
+				best_ptr->execute();
+			}
 			executed = true;
 			if (!gs_o.is_gamestate_changed()) {
 				//this means that this CA has lied to us in evaluate()
@@ -52,9 +52,20 @@ public:
 	void remove_completed_cas();
 
 private:
+	/**
+	 * Evaluates the thread safe candidate actions following @a first (which
+	 * is one of them) whose max score is above @a best_score, up to the
+	 * next one that is not thread safe, all at the same time. The scores go
+	 * to @a scores, at the indexes of the candidate actions.
+	 */
+	void evaluate_concurrently(size_t first, double best_score, std::map<size_t, double>& scores);
+
 	std::vector<candidate_action_ptr> candidate_actions_;
 
 	const config &cfg_;
+
+	/** Whether thread safe candidate actions are evaluated concurrently. */
+	bool parallel_evaluation_;
 };
 
 
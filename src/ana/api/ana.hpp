@@ -216,6 +216,34 @@ namespace ana
                 /** Returns false iff the sender is in raw data mode. */
                 bool header_mode() const {return ! raw_data_; }
 
+                /**
+                 * Enter write coalescing mode, ana will gather the messages sent in a short
+                 * window and write them to the socket in a single operation. Nagle's algorithm
+                 * is disabled (TCP_NODELAY) since messages are already batched.
+                 *
+                 * Each message still gets its own call to send_handler::handle_send.
+                 *
+                 * @param window_ms : How long the first message of a batch waits for the next
+                 *                    ones. With 0, only the messages sent while a write is in
+                 *                    progress, or from the same handler, are gathered.
+                 *
+                 * \sa send_handler
+                 */
+                void set_write_coalescing( size_t window_ms = 0 )
+                {
+                    coalescing_           = true;
+                    coalescing_window_ms_ = window_ms;
+                }
+
+                /** Write every message in its own operation, the default. */
+                void disable_write_coalescing() { coalescing_ = false; }
+
+                /** Returns true iff the sender is in write coalescing mode. */
+                bool write_coalescing() const {return coalescing_; }
+
+                /** Returns the window of the write coalescing mode, in milliseconds. */
+                size_t write_coalescing_window() const {return coalescing_window_ms_; }
+
                 /**
                  * Get associated stats_collector object.
                  *
@@ -230,6 +258,8 @@ namespace ana
                 /** Initialize component, assign fresh id and sets header-first and async modes. */
                 ana_component() :
                     raw_data_( false ),
+                    coalescing_( false ),
+                    coalescing_window_ms_( 0 ),
                     id_(++last_net_id_)
                 {
                 }
@@ -238,6 +268,12 @@ namespace ana
                 /** The component is in raw data mode.*/
                 bool raw_data_;
 
+                /** The component is in write coalescing mode.*/
+                bool coalescing_;
+
+                /** The coalescing window, in milliseconds. */
+                size_t coalescing_window_ms_;
+
                 /** This component's net_id. */
                 const net_id     id_;
         };
@@ -515,6 +551,12 @@ namespace ana
          */
         using ana::detail::ana_component::set_raw_data_mode;
 
+        /**
+         * Set the server to write coalescing mode, every time a client connects
+         * it will use the current mode.
+         */
+        using ana::detail::ana_component::set_write_coalescing;
+
         /** Returns the string representing the ip address of a connected client. */
         virtual std::string ip_address( net_id ) const = 0;
 
@@ -613,6 +655,9 @@ namespace ana
 
             /** Allow external object to call set_raw_data_mode() directly. */
             using ana::detail::ana_component::set_raw_data_mode;
+
+            /** Allow external object to call set_write_coalescing() directly. */
+            using ana::detail::ana_component::set_write_coalescing;
         };
     };
 
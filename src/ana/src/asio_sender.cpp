@@ -33,6 +33,16 @@
 
 #include "asio_sender.hpp"
 
+asio_sender::asio_sender() :
+    queued_(),
+    writing_(),
+    write_scheduled_( false ),
+    no_delay_set_( false ),
+    queue_mutex_(),
+    window_timer_()
+{
+}
+
 void asio_sender::send(ana::detail::shared_buffer buffer ,
                        tcp::socket&               socket ,
                        ana::send_handler*         handler,
@@ -55,7 +65,19 @@ void asio_sender::send(ana::detail::shared_buffer buffer ,
         stats_collector().start_send_packet(  buffer->size()
                                             + ( raw_mode() ? 0 : ana::HEADER_LENGTH ) );
 
-        if ( raw_mode() )
+        if ( write_coalescing() )
+        {
+            queued_message msg;
+            msg.buffer  = buffer;
+            msg.header  = buffer->size();
+            ana::host_to_network_long( msg.header );
+            msg.handler = handler;
+            msg.timer   = running_timer;
+            msg.op_id   = op_id;
+
+            queue_message( msg, socket );
+        }
+        else if ( raw_mode() )
         {
             socket.async_write_some( boost::asio::buffer(buffer->base(), buffer->size() ),
                                      boost::bind(&asio_sender::handle_partial_send,this,
@@ -86,6 +108,112 @@ void asio_sender::send(ana::detail::shared_buffer buffer ,
 }
 
 
+void asio_sender::queue_message(const queued_message& msg, tcp::socket& socket)
+{
+    boost::mutex::scoped_lock lock( queue_mutex_ );
+
+    queued_.push_back( msg );
+
+    if ( write_scheduled_ ) // it will be written along with the others
+        return;
+
+    write_scheduled_ = true;
+
+    if ( ! no_delay_set_ )
+    {
+        // Messages are batched here, waiting for more ACKs would only add latency.
+        ana::error_code ec;
+        socket.set_option( tcp::no_delay( true ), ec );
+        no_delay_set_ = true;
+    }
+
+    if ( write_coalescing_window() == 0 )
+        socket.get_io_service().post( boost::bind(&asio_sender::write_queued, this, &socket ) );
+    else
+    {
+        if ( ! window_timer_ )
+            window_timer_.reset( new boost::asio::deadline_timer( socket.get_io_service() ) );
+
+        window_timer_->expires_from_now(
+            boost::posix_time::milliseconds( write_coalescing_window() ) );
+        window_timer_->async_wait( boost::bind(&asio_sender::handle_coalescing_window, this,
+                                               boost::asio::placeholders::error, &socket ) );
+    }
+}
+
+void asio_sender::handle_coalescing_window(const ana::error_code& ec, tcp::socket* socket)
+{
+    if ( ec != boost::asio::error::operation_aborted )
+        write_queued( socket );
+}
+
+void asio_sender::write_queued(tcp::socket* socket)
+{
+    std::vector<boost::asio::const_buffer> buffers;
+    {
+        boost::mutex::scoped_lock lock( queue_mutex_ );
+
+        writing_.assign( queued_.begin(), queued_.end() );
+        queued_.clear();
+    }
+
+    buffers.reserve( writing_.size() * 2 );
+    for (std::vector<queued_message>::const_iterator it = writing_.begin();
+         it != writing_.end();
+         ++it)
+    {
+        if ( header_mode() )
+            buffers.push_back( boost::asio::buffer( &it->header, sizeof( ana::ana_uint32 ) ) );
+
+        buffers.push_back( boost::asio::buffer( it->buffer->base(), it->buffer->size() ) );
+    }
+
+    boost::asio::async_write( *socket, buffers,
+                              boost::bind(&asio_sender::handle_coalesced_send, this,
+                                          boost::asio::placeholders::error, socket, _2 ) );
+}
+
+void asio_sender::handle_coalesced_send(const ana::error_code& ec,
+                                        tcp::socket*           socket,
+                                        size_t                 /*bytes_sent*/)
+{
+    std::vector<queued_message> sent;
+    sent.swap( writing_ );
+
+    if ( ec == boost::asio::error::operation_aborted ) // equals only after cancellation
+        return;
+
+    for (std::vector<queued_message>::const_iterator it = sent.begin(); it != sent.end(); ++it)
+    {
+        if ( ! ec )
+            stats_collector().log_send(  it->buffer->size()
+                                       + ( header_mode() ? ana::HEADER_LENGTH : 0 ), true );
+
+        delete it->timer;
+        it->handler->handle_send( ec, id(), it->op_id );
+    }
+
+    if ( ec )
+    {
+        // Once for the whole batch, as it can destroy this object.
+        disconnect();
+        return;
+    }
+
+    {
+        boost::mutex::scoped_lock lock( queue_mutex_ );
+
+        if ( queued_.empty() )
+        {
+            write_scheduled_ = false;
+            return;
+        }
+    }
+
+    // The messages sent during the write are written right away, they already waited.
+    write_queued( socket );
+}
+
 void asio_sender::handle_sent_header(const ana::error_code&      ec,
                                      ana::serializer::bostream*  bos,
                                      tcp::socket*                socket,
@@ -33,6 +33,11 @@
 #define ASIO_SENDER_HPP
 
 #include <boost/asio.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <deque>
+#include <vector>
 
 #include "../api/ana.hpp"
 
@@ -42,6 +47,8 @@ class asio_sender : private ana::detail::sender
 {
 
     public:
+        asio_sender();
+
         void send( ana::detail::shared_buffer,
                    tcp::socket&,
                    ana::send_handler*,
@@ -49,6 +56,27 @@ class asio_sender : private ana::detail::sender
                    ana::operation_id);
 
     private:
+        /** A message waiting to be written in write coalescing mode. */
+        struct queued_message
+        {
+            ana::detail::shared_buffer buffer;
+            ana::ana_uint32            header; // network byte order
+            ana::send_handler*         handler;
+            ana::timer*                timer;
+            ana::operation_id          op_id;
+        };
+
+        void queue_message(const queued_message&, tcp::socket&);
+
+        /** Writes every queued message in a single operation. */
+        void write_queued(tcp::socket*);
+
+        void handle_coalescing_window(const boost::system::error_code&, tcp::socket*);
+
+        void handle_coalesced_send(const boost::system::error_code&,
+                                   tcp::socket*,
+                                   size_t);
+
         void handle_sent_header(const boost::system::error_code& ec,
                                 ana::serializer::bostream*,
                                 tcp::socket*,
@@ -72,6 +100,23 @@ class asio_sender : private ana::detail::sender
                          ana::timer*,
                          ana::operation_id,
                          bool from_timeout = false);
+
+        /** Messages sent in coalescing mode and not written yet. */
+        std::deque<queued_message>  queued_;
+
+        /** The messages of the write in progress, owned by the io_service thread. */
+        std::vector<queued_message> writing_;
+
+        /** A write or the coalescing window is pending, queued_ will be written. */
+        bool                        write_scheduled_;
+
+        /** TCP_NODELAY was set on the socket. */
+        bool                        no_delay_set_;
+
+        /** Protects queued_ and write_scheduled_, send() can be called from any thread. */
+        boost::mutex                queue_mutex_;
+
+        boost::scoped_ptr<boost::asio::deadline_timer> window_timer_;
 };
 
 #endif
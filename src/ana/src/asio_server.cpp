@@ -156,6 +156,9 @@ void asio_server::handle_accept(const boost::system::error_code& ec,
         if ( raw_mode() ) // only test for the non default setting
             client->set_raw_data_mode();
 
+        if ( write_coalescing() )
+            client->set_write_coalescing( write_coalescing_window() );
+
         register_client(client);
         handler->handle_connect( ec, client->id() );
     }
@@ -72,6 +72,13 @@ public:
 	void update_last_draw_time(double acceleration = 0);
 	bool need_update() const;
 
+	/**
+	 * Returns the last animation tick at which need_update() is still false,
+	 * INT_MIN if it is already true and INT_MAX if it never will be. Until
+	 * then, a started animation can skip its updates.
+	 */
+	int get_next_update_tick() const;
+
 	bool cycles() const {return cycles_;}
 
 	/** Returns true if the current animation was finished. */
@@ -173,6 +173,18 @@ bool animated<T,T_void_value>::need_update() const
 	return false;
 }
 
+template<typename T,  typename T_void_value>
+int animated<T,T_void_value>::get_next_update_tick() const
+{
+	if(force_next_update_) {
+		return INT_MIN;
+	}
+	if(does_not_change_ || frames_.empty() || (!started_ && start_tick_ == 0)) {
+		return INT_MAX;
+	}
+	return static_cast<int>(get_current_frame_end_time() / acceleration_ + start_tick_);
+}
+
 template<typename T,  typename T_void_value>
 bool animated<T,T_void_value>::animation_finished_potential() const
 {
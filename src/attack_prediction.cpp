@@ -32,14 +32,25 @@
  * for wesnoth-attack-sim.c).
  */
 
+#include <algorithm>
 #include <cfloat>
+#include <cmath>
 
 #include "attack_prediction.hpp"
 
 #include "actions/attack.hpp"
 #include "array.hpp"
+#include "attack_prediction_kernels.hpp"
 #include "game_config.hpp"
 
+#include <boost/cstdint.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/unordered_map.hpp>
+
+#include <iterator>
+#include <list>
+
 #if defined(BENCHMARK) || defined(CHECK)
 #include <time.h>
 #include <sys/time.h>
@@ -109,6 +120,217 @@ const T& limit(const T& val, const T& min, const T& max)
 	return val;
 }
 
+/**
+ * Recycles the storage of the probability planes, so that the many
+ * simulations run while the AI evaluates attacks do not allocate memory each.
+ * Simulations only run in the main thread, and one at a time, so a single
+ * arena (see get_plane_arena()) is enough.
+ */
+class plane_arena
+{
+public:
+	plane_arena() : free_() {}
+	~plane_arena();
+
+	/**
+	 * Returns a block of at least @a size values, set to zero.
+	 * @a capacity is set to the actual size of the block.
+	 */
+	double *acquire(size_t size, size_t & capacity);
+	/** Gives back a block obtained from acquire(), with its capacity. */
+	void release(double *block, size_t capacity);
+
+private:
+	/** Blocks are kept for reuse, up to this many. */
+	static const size_t max_blocks = 4;
+
+	struct block
+	{
+		double *data;
+		size_t size;
+	};
+	std::vector<block> free_;
+};
+
+plane_arena::~plane_arena()
+{
+	for ( size_t i = 0; i != free_.size(); ++i )
+		delete[] free_[i].data;
+}
+
+double *plane_arena::acquire(size_t size, size_t & capacity)
+{
+	// The most recently released blocks are the most likely to be cached.
+	for ( size_t i = free_.size(); i != 0; --i ) {
+		if ( free_[i-1].size >= size ) {
+			double *data = free_[i-1].data;
+			capacity = free_[i-1].size;
+			free_.erase(free_.begin() + (i-1));
+			memset(data, 0, sizeof(double) * size);
+			return data;
+		}
+	}
+
+	double *data = new double[size];
+	memset(data, 0, sizeof(double) * size);
+	capacity = size;
+	return data;
+}
+
+void plane_arena::release(double *data, size_t capacity)
+{
+	if ( free_.size() == max_blocks ) {
+		// Drop the smallest block.
+		std::vector<block>::iterator smallest = free_.begin();
+		for ( std::vector<block>::iterator i = free_.begin(); i != free_.end(); ++i )
+			if ( i->size < smallest->size )
+				smallest = i;
+		if ( smallest->size >= capacity ) {
+			delete[] data;
+			return;
+		}
+		delete[] smallest->data;
+		free_.erase(smallest);
+	}
+
+	const block b = { data, capacity };
+	free_.push_back(b);
+}
+
+plane_arena & get_plane_arena()
+{
+	static plane_arena arena;
+	return arena;
+}
+
+/**
+ * A set of row (or column) indices of a probability plane, stored as bits.
+ * The bits are kept in the object itself for up to inline_size indices, which
+ * covers the hitpoints of nearly all units; bigger sets use the heap.
+ * This is much cheaper to update and iterate than a std::set<unsigned>.
+ */
+class index_set
+{
+public:
+	static const unsigned inline_size = 256;
+
+	index_set() : num_words_(0), heap_()
+	{
+		std::fill(inline_, inline_ + inline_words, 0);
+	}
+
+	/** Makes this an empty set for the indices below @a size. */
+	void reset(unsigned size)
+	{
+		num_words_ = (size + word_bits - 1) / word_bits;
+		std::fill(inline_, inline_ + inline_words, 0);
+		if ( size > inline_size )
+			heap_.assign(num_words_, 0);
+		else
+			heap_.clear();
+	}
+
+	void insert(unsigned i) { words()[i / word_bits] |= boost::uint64_t(1) << (i % word_bits); }
+	void insert(const index_set & other)
+	{
+		boost::uint64_t * dst = words();
+		const boost::uint64_t * src = other.words();
+		for ( unsigned w = 0; w != num_words_; ++w )
+			dst[w] |= src[w];
+	}
+	template<typename Iterator>
+	void insert(Iterator first, Iterator last)
+	{
+		for ( ; first != last; ++first )
+			insert(*first);
+	}
+
+	/** The highest index in the set (which must not be empty). */
+	unsigned last() const
+	{
+		const boost::uint64_t * w = words();
+		unsigned i = num_words_;
+		while ( w[--i] == 0 ) {}
+		unsigned bit = word_bits - 1;
+		while ( !(w[i] >> bit & 1) )
+			--bit;
+		return i * word_bits + bit;
+	}
+
+	/** Iterates over the indices in increasing order. */
+	class const_iterator
+	{
+	public:
+		typedef std::forward_iterator_tag iterator_category;
+		typedef unsigned value_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef const unsigned * pointer;
+		typedef unsigned reference;
+
+		const_iterator() : words_(NULL), end_(0), pos_(0) {}
+		const_iterator(const boost::uint64_t * words, unsigned num_words, unsigned pos) :
+			words_(words), end_(num_words * word_bits), pos_(pos)
+		{
+			if ( pos_ != end_  &&  !(words_[pos_ / word_bits] >> (pos_ % word_bits) & 1) )
+				++*this;
+		}
+
+		unsigned operator*() const { return pos_; }
+		bool operator==(const const_iterator & that) const { return pos_ == that.pos_; }
+		bool operator!=(const const_iterator & that) const { return pos_ != that.pos_; }
+
+		const_iterator & operator++()
+		{
+			++pos_;
+			while ( pos_ != end_ ) {
+				// The bits left in the current word.
+				const boost::uint64_t rest = words_[pos_ / word_bits] >> (pos_ % word_bits);
+				if ( rest == 0 ) {
+					pos_ = (pos_ / word_bits + 1) * word_bits;
+					continue;
+				}
+				pos_ += lowest_bit(rest);
+				break;
+			}
+			return *this;
+		}
+		const_iterator operator++(int) { const_iterator old = *this; ++*this; return old; }
+
+	private:
+		static unsigned lowest_bit(boost::uint64_t w)
+		{
+#if defined(__GNUC__)
+			return __builtin_ctzll(w);
+#else
+			unsigned bit = 0;
+			while ( !(w & 1) ) {
+				w >>= 1;
+				++bit;
+			}
+			return bit;
+#endif
+		}
+
+		const boost::uint64_t * words_;
+		unsigned end_;
+		unsigned pos_;
+	};
+
+	const_iterator begin() const { return const_iterator(words(), num_words_, 0); }
+	const_iterator end() const { return const_iterator(words(), num_words_, num_words_ * word_bits); }
+
+private:
+	static const unsigned word_bits = 64;
+	static const unsigned inline_words = inline_size / word_bits;
+
+	boost::uint64_t * words() { return heap_.empty() ? inline_ : &heap_[0]; }
+	const boost::uint64_t * words() const { return heap_.empty() ? inline_ : &heap_[0]; }
+
+	unsigned num_words_;
+	boost::uint64_t inline_[inline_words];
+	std::vector<boost::uint64_t> heap_;
+};
+
 /**
  * A matrix of A's hitpoints vs B's hitpoints vs. their slowed states.
  * This class is concerned only with the matrix implementation and
@@ -174,8 +396,8 @@ public:
 	};
 
 private:
-	// This gives me 10% speed improvement over std::vector<> (g++4.0.3 x86)
-	double *new_plane();
+	/** Points the planes in @a used into a block from the plane arena. */
+	void allocate_planes(const bool used[NUM_PLANES]);
 
 	void initialize_plane(unsigned plane, unsigned a_cur, unsigned b_cur,
 	                      const std::vector<double> & a_initial,
@@ -196,7 +418,7 @@ private:
 	          unsigned row_dst, unsigned col_dst,
 	          unsigned row_src, unsigned col_src);
 
-	void shift_cols_in_row(unsigned dst, unsigned src, unsigned row,
+	bool shift_cols_in_row(unsigned dst, unsigned src, unsigned row,
 	                       const std::vector<unsigned> & cols,
 	                       unsigned damage, double prob, int drainmax,
 	                       int drain_constant, int drain_percent);
@@ -208,10 +430,13 @@ private:
 private: // data
 	const unsigned int rows_, cols_;
 	util::array<double *, NUM_PLANES> plane_;
+	/** The storage of all planes, one after the other. */
+	double *storage_;
+	size_t storage_capacity_;
 
 	// For optimization, we keep track of the rows and columns with data.
 	// (The matrices are likely going to be rather sparse, with data on a grid.)
-	util::array<std::set<unsigned>, NUM_PLANES> used_rows_, used_cols_;
+	util::array<index_set, NUM_PLANES> used_rows_, used_cols_;
 };
 
 
@@ -234,6 +459,8 @@ prob_matrix::prob_matrix(unsigned int a_max, unsigned int b_max,
 	: rows_(a_max+1)
 	, cols_(b_max+1)
 	, plane_()
+	, storage_(NULL)
+	, storage_capacity_(0)
 	, used_rows_()
 	, used_cols_()
 {
@@ -243,6 +470,8 @@ prob_matrix::prob_matrix(unsigned int a_max, unsigned int b_max,
 
 	// It will be convenient to always consider row/col 0 to be used.
 	for ( unsigned plane = 0; plane != NUM_PLANES; ++plane ) {
+		used_rows_[plane].reset(rows_);
+		used_cols_[plane].reset(cols_);
 		used_rows_[plane].insert(0u);
 		used_cols_[plane].insert(0u);
 	}
@@ -252,10 +481,12 @@ prob_matrix::prob_matrix(unsigned int a_max, unsigned int b_max,
 	need_b_slowed =  need_b_slowed || !b_initial[1].empty();
 
 	// Allocate the needed planes.
-	plane_[NEITHER_SLOWED] = new_plane();
-	plane_[A_SLOWED] = !need_a_slowed ? NULL : new_plane();
-	plane_[B_SLOWED] = !need_b_slowed ? NULL : new_plane();
-	plane_[BOTH_SLOWED] = !(need_a_slowed && need_b_slowed) ? NULL : new_plane();
+	bool used[NUM_PLANES];
+	used[NEITHER_SLOWED] = true;
+	used[A_SLOWED] = need_a_slowed;
+	used[B_SLOWED] = need_b_slowed;
+	used[BOTH_SLOWED] = need_a_slowed && need_b_slowed;
+	allocate_planes(used);
 
 	// Initialize the probability distribution.
 	initialize_plane(NEITHER_SLOWED, a_cur, b_cur, a_initial[0], b_initial[0]);
@@ -280,19 +511,31 @@ prob_matrix::prob_matrix(unsigned int a_max, unsigned int b_max,
 
 prob_matrix::~prob_matrix()
 {
-	delete[] plane_[NEITHER_SLOWED];
-	delete[] plane_[A_SLOWED];
-	delete[] plane_[B_SLOWED];
-	delete[] plane_[BOTH_SLOWED];
+	get_plane_arena().release(storage_, storage_capacity_);
 }
 
-/** Allocate a new probability array, initialized to 0. */
-double *prob_matrix::new_plane()
+/**
+ * Allocates the planes, initialized to 0, in a single block so that moving
+ * values between planes stays within the same region of memory.
+ */
+void prob_matrix::allocate_planes(const bool used[NUM_PLANES])
 {
-	unsigned int size = rows_ * cols_;
-	double *arr = new double[size];
-	memset(arr, 0, sizeof(double) * size);
-	return arr;
+	const size_t plane_size = rows_ * cols_;
+	unsigned count = 0;
+	for ( unsigned p = 0; p != NUM_PLANES; ++p )
+		if ( used[p] )
+			++count;
+
+	storage_ = get_plane_arena().acquire(plane_size * count, storage_capacity_);
+
+	double *next = storage_;
+	for ( unsigned p = 0; p != NUM_PLANES; ++p ) {
+		if ( used[p] ) {
+			plane_[p] = next;
+			next += plane_size;
+		} else
+			plane_[p] = NULL;
+	}
 }
 
 /**
@@ -443,8 +686,10 @@ void prob_matrix::xfer(unsigned dst_plane, unsigned src_plane,
 /**
  * Transfers a portion (value * prob) of the values in a row to another.
  * Part of shift_cols().
+ * @returns whether the non-killing blows moved anything, in which case the
+ *          caller has to mark their destination columns as used.
  */
-void prob_matrix::shift_cols_in_row(unsigned dst, unsigned src, unsigned row,
+bool prob_matrix::shift_cols_in_row(unsigned dst, unsigned src, unsigned row,
                                     const std::vector<unsigned> & cols,
                                     unsigned damage, double prob, int drainmax,
                                     int drain_constant, int drain_percent)
@@ -466,10 +711,23 @@ void prob_matrix::shift_cols_in_row(unsigned dst, unsigned src, unsigned row,
 		xfer(dst, src, newrow, 0, row, cols[col_x], prob);
 	}
 
-	// The remaining columns use the specified drainmax.
+	if ( col_x == cols.size() )
+		return false;
+
+	// The remaining columns use the specified drainmax, so they all go to
+	// the same row, and can be transferred as one span. (The unused columns
+	// within the span are zero.)
 	unsigned newrow = limit<int>(row_i + drainmax, 1, max_row);
-	for ( ; col_x < cols.size(); ++col_x )
-		xfer(dst, src, newrow, cols[col_x] - damage, row, cols[col_x], prob);
+	const unsigned first = cols[col_x];
+	const unsigned count = cols.back() - first + 1;
+	if ( !combat_kernels::transfer(&val(dst, newrow, first - damage),
+	                               &val(src, row, first), count, prob) )
+		return false;
+
+	used_rows_[dst].insert(newrow);
+	debug(("Shifted columns %u-%u of row %u by %u to row %u.\n",
+	       first, first + count - 1, row, damage, newrow));
+	return true;
 }
 
 /**
@@ -494,16 +752,25 @@ void prob_matrix::shift_cols(unsigned dst, unsigned src, unsigned damage,
 
 	// Loop downwards if we drain positive, but upwards if we drain negative,
 	// so we write behind us (for when src == dst).
+	bool shifted = false;
 	if(drainmax > 0) {
 		// rows[0] is excluded since that should be 0, representing already dead.
 		for ( unsigned row_x = rows.size()-1; row_x != 0; --row_x )
-			shift_cols_in_row(dst, src, rows[row_x], cols, damage, prob, drainmax,
-			                  drain_constant, drain_percent);
+			shifted |= shift_cols_in_row(dst, src, rows[row_x], cols, damage, prob,
+			                             drainmax, drain_constant, drain_percent);
 	} else {
 		// rows[0] is excluded since that should be 0, representing already dead.
 		for ( unsigned row_x = 1; row_x != rows.size(); ++row_x )
-			shift_cols_in_row(dst, src, rows[row_x], cols, damage, prob, drainmax,
-			                  drain_constant, drain_percent);
+			shifted |= shift_cols_in_row(dst, src, rows[row_x], cols, damage, prob,
+			                             drainmax, drain_constant, drain_percent);
+	}
+
+	// Track the columns the non-killing blows went to.
+	if ( shifted ) {
+		std::vector<unsigned>::const_iterator col_it =
+			std::lower_bound(cols.begin(), cols.end(), damage);
+		for ( ; col_it != cols.end(); ++col_it )
+			used_cols_[dst].insert(*col_it - damage);
 	}
 }
 
@@ -559,6 +826,31 @@ void prob_matrix::shift_rows(unsigned dst, unsigned src, unsigned damage,
 	const std::vector<unsigned> rows(used_rows_[src].begin(), used_rows_[src].end());
 	const std::vector<unsigned> cols(used_cols_[src].begin(), used_cols_[src].end());
 
+	if ( drain_constant == 0  &&  drain_percent == 0 ) {
+		// Without drains the values stay in their columns, so the used part
+		// of each row can be transferred at once. Rows are handled upwards, so
+		// we write behind us (for when src == dst).
+		if ( cols.size() < 2 )
+			// Only column 0 (already dead) is used.
+			return;
+		const unsigned first = cols[1];
+		const unsigned count = cols.back() - first + 1;
+		bool shifted = false;
+		// rows[0] is excluded since that should be 0, representing already dead.
+		for ( unsigned row_x = 1; row_x != rows.size(); ++row_x ) {
+			const unsigned row = rows[row_x];
+			const unsigned newrow = row < damage ? 0 : row - damage;
+			if ( combat_kernels::transfer(&val(dst, newrow, first),
+			                              &val(src, row, first), count, prob) ) {
+				used_rows_[dst].insert(newrow);
+				shifted = true;
+			}
+		}
+		if ( shifted )
+			used_cols_[dst].insert(cols.begin() + 1, cols.end());
+		return;
+	}
+
 	// Loop downwards if we drain positive, but upwards if we drain negative,
 	// so we write behind us (for when src == dst).
 	if(drainmax > 0) {
@@ -580,8 +872,8 @@ void prob_matrix::shift_rows(unsigned dst, unsigned src, unsigned damage,
 void prob_matrix::move_column(unsigned d_plane, unsigned s_plane,
                               unsigned d_col, unsigned s_col)
 {
-	std::set<unsigned>::const_iterator rows_end = used_rows_[s_plane].end();
-	std::set<unsigned>::const_iterator row_it = used_rows_[s_plane].begin();
+	index_set::const_iterator rows_end = used_rows_[s_plane].end();
+	index_set::const_iterator row_it = used_rows_[s_plane].begin();
 
 	// Transfer the data.
 	for ( ; row_it != rows_end; ++row_it )
@@ -594,8 +886,8 @@ void prob_matrix::move_column(unsigned d_plane, unsigned s_plane,
 void prob_matrix::move_row(unsigned d_plane, unsigned s_plane,
                            unsigned d_row, unsigned s_row)
 {
-	std::set<unsigned>::const_iterator cols_end = used_cols_[s_plane].end();
-	std::set<unsigned>::const_iterator col_it = used_cols_[s_plane].begin();
+	index_set::const_iterator cols_end = used_cols_[s_plane].end();
+	index_set::const_iterator col_it = used_cols_[s_plane].begin();
 
 	// Transfer the data.
 	for ( ; col_it != cols_end; ++col_it )
@@ -609,8 +901,8 @@ void prob_matrix::move_row(unsigned d_plane, unsigned s_plane,
 void prob_matrix::merge_col(unsigned d_plane, unsigned s_plane, unsigned col,
                             unsigned d_row)
 {
-	std::set<unsigned>::const_iterator rows_end = used_rows_[s_plane].end();
-	std::set<unsigned>::const_iterator row_it = used_rows_[s_plane].begin();
+	index_set::const_iterator rows_end = used_rows_[s_plane].end();
+	index_set::const_iterator row_it = used_rows_[s_plane].begin();
 
 	// Transfer the data, excluding row zero.
 	for ( ++row_it; row_it != rows_end; ++row_it )
@@ -623,16 +915,25 @@ void prob_matrix::merge_col(unsigned d_plane, unsigned s_plane, unsigned col,
  */
 void prob_matrix::merge_cols(unsigned d_plane, unsigned s_plane, unsigned d_row)
 {
-	std::set<unsigned>::const_iterator rows_end = used_rows_[s_plane].end();
-	std::set<unsigned>::const_iterator row_it = used_rows_[s_plane].begin();
-	std::set<unsigned>::const_iterator cols_end = used_cols_[s_plane].end();
-	std::set<unsigned>::const_iterator cols_begin = used_cols_[s_plane].begin();
-	std::set<unsigned>::const_iterator col_it;
+	const std::vector<unsigned> rows(used_rows_[s_plane].begin(), used_rows_[s_plane].end());
+	const index_set & cols = used_cols_[s_plane];
+	const unsigned count = cols.last() + 1;
+
+	// Transfer the data (whole rows at once), excluding row zero.
+	bool moved = false;
+	for ( unsigned row_x = 1; row_x < rows.size(); ++row_x ) {
+		if ( d_plane == s_plane  &&  rows[row_x] == d_row )
+			// Transferring to itself. Nothing to do.
+			continue;
+		moved |= combat_kernels::transfer(&val(d_plane, d_row, 0),
+		                                  &val(s_plane, rows[row_x], 0), count, 1.0);
+	}
 
-	// Transfer the data, excluding row zero.
-	for ( ++row_it; row_it != rows_end; ++row_it )
-		for ( col_it = cols_begin; col_it != cols_end; ++col_it )
-			xfer(d_plane, s_plane, d_row, *col_it, *row_it, *col_it);
+	if ( moved ) {
+		used_rows_[d_plane].insert(d_row);
+		if ( d_plane != s_plane )
+			used_cols_[d_plane].insert(cols);
+	}
 }
 
 /**
@@ -642,8 +943,8 @@ void prob_matrix::merge_cols(unsigned d_plane, unsigned s_plane, unsigned d_row)
 void prob_matrix::merge_row(unsigned d_plane, unsigned s_plane, unsigned row,
                             unsigned d_col)
 {
-	std::set<unsigned>::const_iterator cols_end = used_cols_[s_plane].end();
-	std::set<unsigned>::const_iterator col_it = used_cols_[s_plane].begin();
+	index_set::const_iterator cols_end = used_cols_[s_plane].end();
+	index_set::const_iterator col_it = used_cols_[s_plane].begin();
 
 	// Transfer the data, excluding column zero.
 	for ( ++col_it; col_it != cols_end; ++col_it )
@@ -657,18 +958,23 @@ void prob_matrix::merge_row(unsigned d_plane, unsigned s_plane, unsigned row,
  */
 void prob_matrix::merge_rows(unsigned d_plane, unsigned s_plane, unsigned d_col)
 {
-	std::set<unsigned>::const_iterator rows_end = used_rows_[s_plane].end();
-	std::set<unsigned>::const_iterator row_it = used_rows_[s_plane].begin();
-	std::set<unsigned>::const_iterator cols_end = used_cols_[s_plane].end();
-	std::set<unsigned>::const_iterator cols_begin = used_cols_[s_plane].begin();
-	// (excluding column zero)
-	++cols_begin;
-	std::set<unsigned>::const_iterator col_it;
-
-	// Transfer the data, excluding column zero.
-	for ( ; row_it != rows_end; ++row_it )
-		for ( col_it = cols_begin; col_it != cols_end; ++col_it )
-			xfer(d_plane, s_plane, *row_it, d_col, *row_it, *col_it);
+	const std::vector<unsigned> rows(used_rows_[s_plane].begin(), used_rows_[s_plane].end());
+	const unsigned last = used_cols_[s_plane].last();
+	// Leave what is already in the destination column in place.
+	const bool skip_d_col = d_plane == s_plane  &&  d_col != 0  &&  d_col <= last;
+
+	// Transfer the data (the sum of each row), excluding column zero.
+	for ( unsigned row_x = 0; row_x < rows.size(); ++row_x ) {
+		double * row = &val(s_plane, rows[row_x], 0);
+		const double moved = !skip_d_col ? combat_kernels::take_sum(row + 1, last) :
+			combat_kernels::take_sum(row + 1, d_col - 1) +
+			combat_kernels::take_sum(row + d_col + 1, last - d_col);
+		if ( moved != 0.0 ) {
+			val(d_plane, rows[row_x], d_col) += moved;
+			used_rows_[d_plane].insert(rows[row_x]);
+			used_cols_[d_plane].insert(d_col);
+		}
+	}
 }
 
 /**
@@ -684,15 +990,15 @@ double prob_matrix::prob_of_zero(bool check_a, bool check_b) const
 
 		// Column 0 is where b is at zero.
 		if ( check_b ) {
-			std::set<unsigned>::const_iterator rows_end = used_rows_[p].end();
-			std::set<unsigned>::const_iterator row_it = used_rows_[p].begin();
+			index_set::const_iterator rows_end = used_rows_[p].end();
+			index_set::const_iterator row_it = used_rows_[p].begin();
 			for ( ; row_it != rows_end; ++row_it )
 				prob += val(p, *row_it, 0);
 		}
 		// Row 0 is where a is at zero.
 		if ( check_a ) {
-			std::set<unsigned>::const_iterator cols_end = used_cols_[p].end();
-			std::set<unsigned>::const_iterator col_it = used_cols_[p].begin();
+			index_set::const_iterator cols_end = used_cols_[p].end();
+			index_set::const_iterator col_it = used_cols_[p].begin();
 			for ( ; col_it != cols_end; ++col_it )
 				prob += val(p, 0, *col_it);
 		}
@@ -710,11 +1016,11 @@ double prob_matrix::prob_of_zero(bool check_a, bool check_b) const
 void prob_matrix::sum(unsigned plane, std::vector<double> & row_sums,
                       std::vector<double> & col_sums) const
 {
-	std::set<unsigned>::const_iterator rows_end = used_rows_[plane].end();
-	std::set<unsigned>::const_iterator row_it = used_rows_[plane].begin();
-	std::set<unsigned>::const_iterator cols_end = used_cols_[plane].end();
-	std::set<unsigned>::const_iterator cols_begin = used_cols_[plane].begin();
-	std::set<unsigned>::const_iterator col_it;
+	index_set::const_iterator rows_end = used_rows_[plane].end();
+	index_set::const_iterator row_it = used_rows_[plane].begin();
+	index_set::const_iterator cols_end = used_cols_[plane].end();
+	index_set::const_iterator cols_begin = used_cols_[plane].begin();
+	index_set::const_iterator col_it;
 
 	for ( ; row_it != rows_end; ++row_it )
 		for ( col_it = cols_begin; col_it != cols_end; ++col_it ) {
@@ -1056,6 +1362,7 @@ combatant::combatant(const battle_context_unit_stats &u, const combatant *prev)
 	  untouched(0.0),
 	  poisoned(0.0),
 	  slowed(0.0),
+	  sampling_error(0.0),
 	  u_(u)
 {
 	// We inherit current state from previous combatant.
@@ -1066,6 +1373,7 @@ combatant::combatant(const battle_context_unit_stats &u, const combatant *prev)
 		untouched = prev->untouched;
 		poisoned = prev->poisoned;
 		slowed = prev->slowed;
+		sampling_error = prev->sampling_error;
 	} else {
 		hp_dist[std::min(u.hp, u.max_hp)] = 1.0;
 		untouched = 1.0;
@@ -1076,7 +1384,8 @@ combatant::combatant(const battle_context_unit_stats &u, const combatant *prev)
 
 // Copy constructor (except use this copy of battle_context_unit_stats)
 combatant::combatant(const combatant &that, const battle_context_unit_stats &u)
-	: hp_dist(that.hp_dist), untouched(that.untouched), poisoned(that.poisoned), slowed(that.slowed), u_(u)
+	: hp_dist(that.hp_dist), untouched(that.untouched), poisoned(that.poisoned), slowed(that.slowed),
+	  sampling_error(that.sampling_error), u_(u)
 {
 		summary[0] = that.summary[0];
 		summary[1] = that.summary[1];
@@ -1501,21 +1810,474 @@ void merge_slice_summary(std::vector<double> & dst, const std::vector<double> &
 		dst[i] += src[i] * prob;
 }
 
+/**
+ * Picks the hit points (and slowed state) a combatant starts a sampled fight
+ * with, according to the summary of its previous fights.
+ */
+class hp_sampler
+{
+public:
+	hp_sampler(const battle_context_unit_stats & stats,
+	           const std::vector<double> summary[2]) :
+		cumulative_(),
+		size_(summary[0].size()),
+		hp_(std::min(stats.hp, stats.max_hp))
+	{
+		double total = 0.0;
+		for ( unsigned plane = 0; plane != 2; ++plane )
+			for ( unsigned i = 0; i != summary[plane].size(); ++i ) {
+				total += summary[plane][i];
+				cumulative_.push_back(total);
+			}
+	}
+
+	/** @param r  A random number in [0, 1). */
+	void pick(double r, unsigned & hp, bool & slowed) const
+	{
+		if ( cumulative_.empty()  ||  cumulative_.back() <= 0.0 ) {
+			// No previous fight.
+			hp = hp_;
+			slowed = false;
+			return;
+		}
+		const unsigned i = std::min<unsigned>(cumulative_.size() - 1,
+			std::upper_bound(cumulative_.begin(), cumulative_.end(),
+			                 r * cumulative_.back()) - cumulative_.begin());
+		hp = i % size_;
+		slowed = i >= size_;
+	}
+
+private:
+	/** Running sums of the unslowed, then slowed, summary. */
+	std::vector<double> cumulative_;
+	unsigned size_;
+	/** The hit points when there is no summary. */
+	unsigned hp_;
+};
+
+/** The state of a combatant during a sampled fight. */
+struct sampled_state
+{
+	unsigned hp;
+	bool slowed;
+	bool hit;
+};
+
+/** One blow of a sampled fight (from @a att to @a def). */
+void sampled_blow(const battle_context_unit_stats & att_stats,
+                  const battle_context_unit_stats & def_stats,
+                  sampled_state & att, sampled_state & def, bool slows,
+                  boost::mt19937 & rng)
+{
+	if ( rng() % 100 >= att_stats.chance_to_hit )
+		return;
+
+	def.hit = true;
+	const int damage = att.slowed ? att_stats.slow_damage : att_stats.damage;
+	int drain_amount;
+	// Like in the matrix, petrifying is simulated as killing (and fixed
+	// up after the fight).
+	if ( att_stats.petrifies  ||  static_cast<int>(def.hp) <= damage ) {
+		// Killing blows drain according to the hit points left.
+		drain_amount = static_cast<int>(def.hp) * att_stats.drain_percent / 100 + att_stats.drain_constant;
+		def.hp = 0;
+	} else {
+		drain_amount = damage * att_stats.drain_percent / 100 + att_stats.drain_constant;
+		def.hp -= damage;
+	}
+	att.hp = limit<int>(static_cast<int>(att.hp) + drain_amount, 1, att_stats.max_hp);
+	if ( slows )
+		def.slowed = true;
+}
+
+/** Fixes up the hit points of a petrified combatant (see complex_fight()). */
+void sampled_petrify(const battle_context_unit_stats & att_stats,
+                     const battle_context_unit_stats & def_stats,
+                     const sampled_state & att, sampled_state & def)
+{
+	const unsigned damage = att.slowed ? att_stats.slow_damage : att_stats.damage;
+	if ( att_stats.petrifies  &&  def.hp == 0  &&  def_stats.hp > damage )
+		def.hp = def_stats.hp - damage;
+}
+
+/** Applies the level-ups complex_fight() considers, to a sampled fight. */
+void sampled_levelup(const battle_context_unit_stats & stats,
+                     const battle_context_unit_stats & opp_stats,
+                     sampled_state & self, const sampled_state & opp)
+{
+	if ( self.hp == 0 )
+		return;
+	if ( stats.experience + opp_stats.level >= stats.max_experience  ||
+	     (opp.hp == 0  &&  stats.experience + game_config::kill_xp(opp_stats.level) >= stats.max_experience) )
+	{
+		self.hp = stats.max_hp;
+		self.slowed = false;
+	}
+}
+
+/**
+ * Estimates the outcome of a fight by running @a trials random fights,
+ * instead of calculating the exact distributions like do_fight(). Swarm is
+ * handled directly, by giving each trial the number of blows matching its
+ * starting hit points.
+ */
+void sampled_fight(const battle_context_unit_stats &stats,
+                   const battle_context_unit_stats &opp_stats,
+                   std::vector<double> summary[2], std::vector<double> opp_summary[2],
+                   double & self_not_hit, double & opp_not_hit,
+                   bool levelup_considered, unsigned trials, boost::uint32_t seed)
+{
+	const hp_sampler sampler(stats, summary);
+	const hp_sampler opp_sampler(opp_stats, opp_summary);
+	const bool first_fight = summary[0].empty();
+	const bool opp_first_fight = opp_summary[0].empty();
+	const bool slows = stats.slows && !opp_stats.is_slowed;
+	const bool opp_slows = opp_stats.slows && !stats.is_slowed;
+	const unsigned rounds = std::max<unsigned>(stats.rounds, opp_stats.rounds);
+
+	// The slowed summaries exist when the matrix would have a slowed plane.
+	std::vector<double> result[2], opp_result[2];
+	result[0].assign(stats.max_hp + 1, 0.0);
+	opp_result[0].assign(opp_stats.max_hp + 1, 0.0);
+	if ( opp_slows  ||  !summary[1].empty() )
+		result[1].assign(stats.max_hp + 1, 0.0);
+	if ( slows  ||  !opp_summary[1].empty() )
+		opp_result[1].assign(opp_stats.max_hp + 1, 0.0);
+	unsigned not_hit = 0, opp_not_hit_count = 0;
+
+	// The generator behind rand_rng::mt_rng, used directly so that this file
+	// still compiles as a stand-alone program.
+	boost::mt19937 rng(seed);
+	const double scale = 1.0 / 4294967296.0;
+
+	for ( unsigned t = 0; t != trials; ++t ) {
+		sampled_state self = { 0, false, false }, opp = { 0, false, false };
+		sampler.pick(rng() * scale, self.hp, self.slowed);
+		opp_sampler.pick(rng() * scale, opp.hp, opp.slowed);
+		const unsigned strikes = first_fight ? stats.num_blows : stats.calc_blows(self.hp);
+		const unsigned opp_strikes = opp_first_fight ? opp_stats.num_blows : opp_stats.calc_blows(opp.hp);
+		const unsigned max_attacks = std::max(strikes, opp_strikes);
+
+		unsigned rounds_left = rounds;
+		do {
+			for ( unsigned i = 0; i < max_attacks  &&  self.hp != 0  &&  opp.hp != 0; ++i ) {
+				if ( i < strikes )
+					sampled_blow(stats, opp_stats, self, opp, slows, rng);
+				if ( i < opp_strikes  &&  self.hp != 0  &&  opp.hp != 0 )
+					sampled_blow(opp_stats, stats, opp, self, opp_slows, rng);
+			}
+		} while ( --rounds_left  &&  self.hp != 0  &&  opp.hp != 0 );
+
+		sampled_petrify(stats, opp_stats, self, opp);
+		sampled_petrify(opp_stats, stats, opp, self);
+		if ( levelup_considered ) {
+			// Based on the state before either levels up.
+			const sampled_state self_before = self;
+			sampled_levelup(stats, opp_stats, self, opp);
+			sampled_levelup(opp_stats, stats, opp, self_before);
+		}
+
+		result[self.slowed && !result[1].empty() ? 1 : 0][self.hp] += 1.0;
+		opp_result[opp.slowed && !opp_result[1].empty() ? 1 : 0][opp.hp] += 1.0;
+		if ( !self.hit )
+			++not_hit;
+		if ( !opp.hit )
+			++opp_not_hit_count;
+	}
+
+	for ( unsigned plane = 0; plane != 2; ++plane ) {
+		for ( unsigned i = 0; i != result[plane].size(); ++i )
+			result[plane][i] /= trials;
+		for ( unsigned i = 0; i != opp_result[plane].size(); ++i )
+			opp_result[plane][i] /= trials;
+		summary[plane].swap(result[plane]);
+		opp_summary[plane].swap(opp_result[plane]);
+	}
+	self_not_hit *= static_cast<double>(not_hit) / trials;
+	opp_not_hit *= static_cast<double>(opp_not_hit_count) / trials;
+}
+
+/**
+ * The half-width of the 95% confidence interval of the least certain value
+ * of a distribution estimated from @a trials samples.
+ */
+double sampling_bound(const std::vector<double> & dist, unsigned trials)
+{
+	double max_variance = 0.0;
+	for ( unsigned i = 0; i != dist.size(); ++i )
+		max_variance = std::max(max_variance, dist[i] * (1.0 - dist[i]));
+	return 1.96 * std::sqrt(max_variance / trials);
+}
+
 } // end anon namespace
 
+namespace {
+	/** The state of both combatants after a fight. */
+	struct fight_result
+	{
+		std::vector<double> hp_dist[2];
+		std::vector<double> summary[2][2];
+		double untouched[2], poisoned[2], slowed[2], sampling_error[2];
+	};
+
+	/** Hashes @a key eight bytes at a time, as it is mostly made of doubles. */
+	std::size_t hash_key(const std::string & key)
+	{
+		std::size_t seed = key.size();
+		std::size_t i = 0;
+		for ( ; i + sizeof(boost::uint64_t) <= key.size(); i += sizeof(boost::uint64_t) ) {
+			boost::uint64_t word;
+			memcpy(&word, key.data() + i, sizeof(word));
+			boost::hash_combine(seed, word);
+		}
+		for ( ; i != key.size(); ++i )
+			boost::hash_combine(seed, key[i]);
+		return seed;
+	}
+
+	/**
+	 * Least recently used cache of fight results, keyed on the serialized
+	 * stats and prior state of both combatants (see combatant::fight()).
+	 * The entries are indexed by the hash of their key; the key itself is
+	 * compared before a result is reused.
+	 */
+	class fight_cache
+	{
+	public:
+		fight_cache() : entries_(), index_(), stats_() {}
+
+		/** @returns the result stored for @a key (of hash @a hash), or NULL. */
+		const fight_result * find(const std::string & key, std::size_t hash)
+		{
+			const index_map::iterator it = index_.find(hash);
+			if ( it == index_.end()  ||  it->second->key != key ) {
+				++stats_.misses;
+				return NULL;
+			}
+			++stats_.hits;
+			// Move the entry to the front of the list.
+			entries_.splice(entries_.begin(), entries_, it->second);
+			return &it->second->result;
+		}
+
+		/** Stores an empty result for @a key, to be filled by the caller. */
+		fight_result & add(const std::string & key, std::size_t hash)
+		{
+			index_map::iterator it = index_.find(hash);
+			if ( it != index_.end() ) {
+				// Another key with the same hash; replace it.
+				entries_.erase(it->second);
+			} else if ( index_.size() >= max_entries ) {
+				index_.erase(entries_.back().hash);
+				entries_.pop_back();
+			}
+			entries_.push_front(entry());
+			entries_.front().key = key;
+			entries_.front().hash = hash;
+			index_[hash] = entries_.begin();
+			return entries_.front().result;
+		}
+
+		void clear()
+		{
+			index_.clear();
+			entries_.clear();
+		}
+
+		combat_cache::statistics get_statistics() const
+		{
+			combat_cache::statistics res = stats_;
+			res.entries = index_.size();
+			return res;
+		}
+
+	private:
+		/** Past this size the least recently used result is dropped. */
+		static const size_t max_entries = 2048;
+
+		struct entry
+		{
+			entry() : key(), hash(0), result() {}
+			std::string key;
+			std::size_t hash;
+			fight_result result;
+		};
+		typedef std::list<entry> entry_list;
+		typedef boost::unordered_map<std::size_t, entry_list::iterator> index_map;
+
+		/** Most recently used first. */
+		entry_list entries_;
+		index_map index_;
+		combat_cache::statistics stats_;
+	};
+
+	fight_cache & get_fight_cache()
+	{
+		static fight_cache cache;
+		return cache;
+	}
+
+	template<typename T>
+	void append_value(std::string & key, const T & value)
+	{
+		key.append(reinterpret_cast<const char *>(&value), sizeof(value));
+	}
+
+	void append_vector(std::string & key, const std::vector<double> & values)
+	{
+		append_value(key, values.size());
+		if ( !values.empty() )
+			key.append(reinterpret_cast<const char *>(&values[0]),
+			           values.size() * sizeof(double));
+	}
+}
+
+namespace combat_cache {
+
+void clear()
+{
+	get_fight_cache().clear();
+}
+
+statistics get_statistics()
+{
+	return get_fight_cache().get_statistics();
+}
+
+}
+
+void combatant::append_cache_key(std::string &key) const
+{
+	// Everything in the stats but the weapon and the plague type
+	// (which only matter for the UI and for the actual attack).
+	const unsigned flags =
+		u_.is_attacker  << 0  |  u_.is_poisoned << 1  |  u_.is_slowed    << 2  |
+		u_.slows        << 3  |  u_.drains      << 4  |  u_.petrifies    << 5  |
+		u_.plagues      << 6  |  u_.poisons     << 7  |  u_.backstab_pos << 8  |
+		u_.swarm        << 9  |  u_.firststrike << 10 |  u_.disable      << 11;
+	const int numbers[] = {
+		static_cast<int>(flags), u_.attack_num,
+		static_cast<int>(u_.experience), static_cast<int>(u_.max_experience),
+		static_cast<int>(u_.level), static_cast<int>(u_.rounds),
+		static_cast<int>(u_.hp), static_cast<int>(u_.max_hp),
+		static_cast<int>(u_.chance_to_hit), u_.damage, u_.slow_damage,
+		u_.drain_percent, u_.drain_constant, static_cast<int>(u_.num_blows),
+		static_cast<int>(u_.swarm_min), static_cast<int>(u_.swarm_max),
+	};
+	append_value(key, numbers);
+
+	// The state left by previous fights. (hp_dist is only an output.)
+	append_value(key, untouched);
+	append_value(key, poisoned);
+	append_value(key, slowed);
+	append_value(key, sampling_error);
+	append_vector(key, summary[0]);
+	append_vector(key, summary[1]);
+}
+
+fight_sampling::fight_sampling(double threshold, unsigned trial_count, boost::uint32_t rng_seed) :
+	complexity_threshold(threshold),
+	trials(trial_count),
+	seed(rng_seed)
+{
+}
+
+/**
+ * Estimates the work needed to calculate the exact outcome of a fight with
+ * @a opp: the size of the probability matrix, times the number of blows
+ * shifting it, times the number of swarm slices.
+ */
+double combatant::complexity(const combatant &opp) const
+{
+	const double planes = (opp.u_.slows && !u_.is_slowed  ||  !summary[1].empty() ? 2.0 : 1.0) *
+	                      (u_.slows && !opp.u_.is_slowed  ||  !opp.summary[1].empty() ? 2.0 : 1.0);
+	const double blows = std::max(u_.swarm_max, u_.num_blows) +
+	                     std::max(opp.u_.swarm_max, opp.u_.num_blows);
+	const double rounds = std::max(u_.rounds, opp.u_.rounds);
+	const double slices = static_cast<double>(split_summary().size()) *
+	                      opp.split_summary().size();
+	return (u_.max_hp + 1.0) * (opp.u_.max_hp + 1.0) * planes * blows * rounds * slices;
+}
+
 // Two man enter.  One man leave!
 // ... Or maybe two.  But definitely not three.
 // Of course, one could be a woman.  Or both.
 // And either could be non-human, too.
 // Um, ok, it was a stupid thing to say.
-void combatant::fight(combatant &opp, bool levelup_considered)
+/**
+ * Simulates a fight, or reuses the result of an earlier one with the same
+ * stats and prior state (see combat_cache).
+ */
+void combatant::fight(combatant &opp, bool levelup_considered,
+                      const fight_sampling *sampling)
 {
 	// If defender has firststrike and we don't, reverse.
 	if (opp.u_.firststrike && !u_.firststrike) {
-		opp.fight(*this, levelup_considered);
+		opp.fight(*this, levelup_considered, sampling);
 		return;
 	}
 
+	const bool sampled = sampling  &&  sampling->trials != 0  &&
+	                     complexity(opp) > sampling->complexity_threshold;
+
+	std::string key(1, levelup_considered ? 'l' : 'n');
+	if ( sampled ) {
+		key += 's';
+		append_value(key, sampling->trials);
+		append_value(key, sampling->seed);
+	}
+	append_cache_key(key);
+	opp.append_cache_key(key);
+
+	const std::size_t hash = hash_key(key);
+	fight_cache & cache = get_fight_cache();
+	if ( const fight_result * cached = cache.find(key, hash) ) {
+		combatant * const both[2] = { this, &opp };
+		for ( unsigned i = 0; i != 2; ++i ) {
+			both[i]->hp_dist = cached->hp_dist[i];
+			both[i]->summary[0] = cached->summary[i][0];
+			both[i]->summary[1] = cached->summary[i][1];
+			both[i]->untouched = cached->untouched[i];
+			both[i]->poisoned = cached->poisoned[i];
+			both[i]->slowed = cached->slowed[i];
+			both[i]->sampling_error = cached->sampling_error[i];
+		}
+		return;
+	}
+
+	if ( sampled )
+		simulate_sampled_fight(opp, levelup_considered, *sampling);
+	else
+		simulate_fight(opp, levelup_considered);
+
+	fight_result & result = cache.add(key, hash);
+	const combatant * const both[2] = { this, &opp };
+	for ( unsigned i = 0; i != 2; ++i ) {
+		result.hp_dist[i] = both[i]->hp_dist;
+		result.summary[i][0] = both[i]->summary[0];
+		result.summary[i][1] = both[i]->summary[1];
+		result.untouched[i] = both[i]->untouched;
+		result.poisoned[i] = both[i]->poisoned;
+		result.slowed[i] = both[i]->slowed;
+		result.sampling_error[i] = both[i]->sampling_error;
+	}
+}
+
+void combatant::simulate_sampled_fight(combatant &opp, bool levelup_considered,
+                                       const fight_sampling &sampling)
+{
+	double self_not_hit = 1.0;
+	double opp_not_hit = 1.0;
+	sampled_fight(u_, opp.u_, summary, opp.summary, self_not_hit, opp_not_hit,
+	              levelup_considered, sampling.trials, sampling.seed);
+	finish_fight(opp, self_not_hit, opp_not_hit);
+
+	sampling_error += sampling_bound(hp_dist, sampling.trials);
+	opp.sampling_error += sampling_bound(opp.hp_dist, sampling.trials);
+}
+
+void combatant::simulate_fight(combatant &opp, bool levelup_considered)
+{
 #ifdef ATTACK_PREDICTION_DEBUG
 	printf("A:\n");
 	dump(u_);
@@ -1613,6 +2375,15 @@ void combatant::fight(combatant &opp, bool levelup_considered)
 	}
 #endif
 
+	finish_fight(opp, self_not_hit, opp_not_hit);
+}
+
+/**
+ * Updates the distributions and chances from the summaries and chances of
+ * not being hit resulting from a fight.
+ */
+void combatant::finish_fight(combatant &opp, double self_not_hit, double opp_not_hit)
+{
 	// Combine summary into distribution.
 	if (summary[1].empty())
 		hp_dist = summary[0];
@@ -19,12 +19,32 @@
 
 #include "global.hpp"
 
+#include <string>
 #include <vector>
 
 #include <cstring>
 
+#include <boost/cstdint.hpp>
+
 struct battle_context_unit_stats;
 
+/**
+ * Lets combatant::fight() estimate the outcome of complex fights by
+ * sampling random fights, instead of calculating it exactly.
+ */
+struct fight_sampling
+{
+	explicit fight_sampling(double threshold = 1e7, unsigned trial_count = 2000,
+	                        boost::uint32_t rng_seed = 0);
+
+	/** Only fights whose combatant::complexity() is above this are sampled. */
+	double complexity_threshold;
+	/** The number of fights sampled. */
+	unsigned trials;
+	/** The random fights are seeded with this, for reproducible results. */
+	boost::uint32_t seed;
+};
+
 // This encapsulates all we need to know for this combat.
 /** All combat-related info. */
 struct combatant
@@ -35,8 +55,16 @@ struct combatant
 	/** Copy constructor */
 	combatant(const combatant &that, const battle_context_unit_stats &u);
 
-	/** Simulate a fight!  Can be called multiple times for cumulative calculations. */
-	void fight(combatant &opponent, bool levelup_considered=true);
+	/**
+	 * Simulate a fight!  Can be called multiple times for cumulative calculations.
+	 * If @a sampling is given, fights more complex than its threshold are
+	 * estimated by sampling (see sampling_error).
+	 */
+	void fight(combatant &opponent, bool levelup_considered=true,
+	           const fight_sampling *sampling=NULL);
+
+	/** Estimates the cost of calculating the exact outcome of a fight with @a opponent. */
+	double complexity(const combatant &opponent) const;
 
 	/** Resulting probability distribution (might be not as large as max_hp) */
 	std::vector<double> hp_dist;
@@ -50,6 +78,13 @@ struct combatant
 	/** Resulting chance we are slowed. */
 	double slowed;
 
+	/**
+	 * Bound of the sampling errors in hp_dist (the half-width of the 95%
+	 * confidence interval of its least certain value, summed over the
+	 * sampled fights). Zero when all fights were calculated exactly.
+	 */
+	double sampling_error;
+
 	/** What's the average hp (weighted average of hp_dist). */
 	double average_hp(unsigned int healing = 0) const;
 
@@ -67,6 +102,16 @@ private:
 	/** Split the combat by number of attacks per combatant (for swarm). */
 	std::vector<combat_slice> split_summary() const;
 
+	/** The actual simulation done by fight(), unless it found a cached result. */
+	void simulate_fight(combatant &opponent, bool levelup_considered);
+	/** Same as simulate_fight(), but estimating the outcome by sampling. */
+	void simulate_sampled_fight(combatant &opponent, bool levelup_considered,
+	                            const fight_sampling &sampling);
+	/** Computes the results from the summaries left by a simulation. */
+	void finish_fight(combatant &opponent, double self_not_hit, double opp_not_hit);
+	/** Appends what the result of a fight depends on to @a key. */
+	void append_cache_key(std::string &key) const;
+
 	const battle_context_unit_stats &u_;
 
 	/** Summary of matrix used to calculate last battle (unslowed & slowed).
@@ -74,4 +119,25 @@ private:
 	std::vector<double> summary[2];
 };
 
+/**
+ * combatant::fight() remembers the results of the last few thousand fights
+ * it simulated, since the AI and the attack prediction dialog simulate the
+ * same fights over and over. A result is reused only for exactly the same
+ * stats and prior state of both combatants, so clearing the cache (done at
+ * each new turn) merely frees memory.
+ * Like the rest of the combat code, the cache must only be used from the
+ * main thread.
+ */
+namespace combat_cache {
+	/** Drops all cached fight results. */
+	void clear();
+
+	struct statistics
+	{
+		statistics() : hits(0), misses(0), entries(0) {}
+		size_t hits, misses, entries;
+	};
+	statistics get_statistics();
+}
+
 #endif
@@ -0,0 +1,172 @@
+/*
+   Copyright (C) 2015 by the Battle for Wesnoth Project
+   Part of the Battle for Wesnoth Project http://www.wesnoth.org/
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY.
+
+   See the COPYING file for more details.
+*/
+
+/**
+ * @file
+ * Vectorized loops over the rows of the probability planes of
+ * attack_prediction.cpp.
+ *
+ * Each kernel has a plain C++ version (the *_scalar functions), and a
+ * version using the vector instructions the compiler was told to target:
+ * AVX, SSE2, or NEON on 64 bit ARM. The vector versions fall back to the
+ * scalar ones for the remaining elements, or when none of these is available.
+ * There is no runtime dispatch; AVX is only used when building with -mavx
+ * (or an -march implying it).
+ */
+
+#ifndef ATTACK_PREDICTION_KERNELS_HPP_INCLUDED
+#define ATTACK_PREDICTION_KERNELS_HPP_INCLUDED
+
+#if defined __AVX__
+#include <immintrin.h>
+#define COMBAT_KERNELS_AVX
+#elif defined __SSE2__ || defined _M_X64 || (defined _M_IX86_FP && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define COMBAT_KERNELS_SSE2
+#elif defined __GNUC__ && defined __ARM_NEON__ && defined __aarch64__
+#include <arm_neon.h>
+#define COMBAT_KERNELS_NEON
+#endif
+
+namespace combat_kernels {
+
+/** The name of the instruction set used by the vector kernels. */
+inline const char* instruction_set()
+{
+#if defined COMBAT_KERNELS_AVX
+	return "avx";
+#elif defined COMBAT_KERNELS_SSE2
+	return "sse2";
+#elif defined COMBAT_KERNELS_NEON
+	return "neon";
+#else
+	return "none";
+#endif
+}
+
+/**
+ * Moves the portion @a prob of each of the @a n values of @a src to the
+ * matching value of @a dst.
+ *
+ * @a dst may overlap @a src, as long as it does not start after it: every
+ * value of @a src is read before the values of @a dst it may overlap are
+ * written, like an element-by-element loop would.
+ *
+ * @returns whether any value of @a src was not zero
+ */
+inline bool transfer_scalar(double* dst, double* src, unsigned n, double prob)
+{
+	bool nonzero = false;
+	for ( unsigned i = 0; i != n; ++i ) {
+		if ( src[i] != 0.0 ) {
+			const double diff = src[i] * prob;
+			src[i] -= diff;
+			dst[i] += diff;
+			nonzero = true;
+		}
+	}
+	return nonzero;
+}
+
+/** Sets the @a n values of @a src to zero, and returns their sum. */
+inline double take_sum_scalar(double* src, unsigned n)
+{
+	double sum = 0.0;
+	for ( unsigned i = 0; i != n; ++i ) {
+		sum += src[i];
+		src[i] = 0.0;
+	}
+	return sum;
+}
+
+/** Same as transfer_scalar(), using vector instructions. */
+inline bool transfer(double* dst, double* src, unsigned n, double prob)
+{
+	unsigned i = 0;
+	bool nonzero = false;
+	// Each block of src is stored before the overlapping block of dst is
+	// loaded, so that dst == src (or dst a bit before src) works.
+#if defined COMBAT_KERNELS_AVX
+	const __m256d p = _mm256_set1_pd(prob);
+	const __m256d zero = _mm256_setzero_pd();
+	int mask = 0;
+	for ( ; i + 4 <= n; i += 4 ) {
+		const __m256d s = _mm256_loadu_pd(src + i);
+		const __m256d diff = _mm256_mul_pd(s, p);
+		mask |= _mm256_movemask_pd(_mm256_cmp_pd(s, zero, _CMP_NEQ_UQ));
+		_mm256_storeu_pd(src + i, _mm256_sub_pd(s, diff));
+		_mm256_storeu_pd(dst + i, _mm256_add_pd(_mm256_loadu_pd(dst + i), diff));
+	}
+	nonzero = mask != 0;
+#elif defined COMBAT_KERNELS_SSE2
+	const __m128d p = _mm_set1_pd(prob);
+	const __m128d zero = _mm_setzero_pd();
+	int mask = 0;
+	for ( ; i + 2 <= n; i += 2 ) {
+		const __m128d s = _mm_loadu_pd(src + i);
+		const __m128d diff = _mm_mul_pd(s, p);
+		mask |= _mm_movemask_pd(_mm_cmpneq_pd(s, zero));
+		_mm_storeu_pd(src + i, _mm_sub_pd(s, diff));
+		_mm_storeu_pd(dst + i, _mm_add_pd(_mm_loadu_pd(dst + i), diff));
+	}
+	nonzero = mask != 0;
+#elif defined COMBAT_KERNELS_NEON
+	const float64x2_t p = vdupq_n_f64(prob);
+	uint64x2_t all_zero = vdupq_n_u64(~0ull);
+	for ( ; i + 2 <= n; i += 2 ) {
+		const float64x2_t s = vld1q_f64(src + i);
+		const float64x2_t diff = vmulq_f64(s, p);
+		all_zero = vandq_u64(all_zero, vceqq_f64(s, vdupq_n_f64(0.0)));
+		vst1q_f64(src + i, vsubq_f64(s, diff));
+		vst1q_f64(dst + i, vaddq_f64(vld1q_f64(dst + i), diff));
+	}
+	nonzero = (vgetq_lane_u64(all_zero, 0) & vgetq_lane_u64(all_zero, 1)) == 0;
+#endif
+	return transfer_scalar(dst + i, src + i, n - i, prob) || nonzero;
+}
+
+/** Same as take_sum_scalar(), using vector instructions. */
+inline double take_sum(double* src, unsigned n)
+{
+	unsigned i = 0;
+	double sum = 0.0;
+#if defined COMBAT_KERNELS_AVX
+	__m256d acc = _mm256_setzero_pd();
+	for ( ; i + 4 <= n; i += 4 ) {
+		acc = _mm256_add_pd(acc, _mm256_loadu_pd(src + i));
+		_mm256_storeu_pd(src + i, _mm256_setzero_pd());
+	}
+	const __m128d half = _mm_add_pd(_mm256_castpd256_pd128(acc), _mm256_extractf128_pd(acc, 1));
+	sum = _mm_cvtsd_f64(_mm_add_sd(half, _mm_unpackhi_pd(half, half)));
+#elif defined COMBAT_KERNELS_SSE2
+	__m128d acc = _mm_setzero_pd();
+	for ( ; i + 2 <= n; i += 2 ) {
+		acc = _mm_add_pd(acc, _mm_loadu_pd(src + i));
+		_mm_storeu_pd(src + i, _mm_setzero_pd());
+	}
+	sum = _mm_cvtsd_f64(_mm_add_sd(acc, _mm_unpackhi_pd(acc, acc)));
+#elif defined COMBAT_KERNELS_NEON
+	float64x2_t acc = vdupq_n_f64(0.0);
+	for ( ; i + 2 <= n; i += 2 ) {
+		acc = vaddq_f64(acc, vld1q_f64(src + i));
+		vst1q_f64(src + i, vdupq_n_f64(0.0));
+	}
+	sum = vgetq_lane_f64(acc, 0) + vgetq_lane_f64(acc, 1);
+#endif
+	return sum + take_sum_scalar(src + i, n - i);
+}
+
+} // namespace combat_kernels
+
+#endif
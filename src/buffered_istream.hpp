@@ -101,6 +101,30 @@ public:
 		return eof_;
 	}
 
+	/**
+	 * The characters already buffered after the last one read, which
+	 * @ref get() would return next.
+	 *
+	 * The range is empty when the buffer needs to be filled again, which
+	 * only @ref get() and @ref peek() do. Together with @ref skip() it lets
+	 * callers scan runs of characters without a call for each of them.
+	 */
+	const char* buffered_begin() const
+	{
+		return buffer_ + buffer_offset_;
+	}
+
+	const char* buffered_end() const
+	{
+		return buffer_ + buffer_size_;
+	}
+
+	/** Consumes @a n characters of the buffered ones. */
+	void skip(unsigned n)
+	{
+		buffer_offset_ += n;
+	}
+
 	/** Returns the owned stream. */
 	std::istream& stream()
 	{
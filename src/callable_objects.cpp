@@ -78,19 +78,48 @@ void location_callable::serialize_to_string(std::string& str) const
 }
 
 
+namespace {
+
+enum attack_type_attribute {
+	ATTACK_ID, ATTACK_TYPE, ATTACK_RANGE, ATTACK_DAMAGE, ATTACK_NUMBER, ATTACK_SPECIAL
+};
+
+const char* const attack_type_attribute_names[] = {
+	"id", "type", "range", "damage", "number_of_attacks", "special", NULL
+};
+
+const game_logic::formula_key_table& attack_type_keys()
+{
+	static const game_logic::formula_key_table keys(attack_type_attribute_names);
+	return keys;
+}
+
+}
+
 variant attack_type_callable::get_value(const std::string& key) const
 {
-	if(key == "id") {
+	return get_attribute(attack_type_keys().find(key));
+}
+
+variant attack_type_callable::get_key_value(const game_logic::formula_key& key) const
+{
+	return get_attribute(attack_type_keys().find(key));
+}
+
+variant attack_type_callable::get_attribute(int attribute) const
+{
+	switch(attribute) {
+	case ATTACK_ID:
 		return variant(att_.id());
-	} else if(key == "type") {
+	case ATTACK_TYPE:
 		return variant(att_.type());
-	} else if(key == "range") {
+	case ATTACK_RANGE:
 		return variant(att_.range());
-	} else if(key == "damage") {
+	case ATTACK_DAMAGE:
 		return variant(att_.damage());
-	} else if(key == "number_of_attacks") {
+	case ATTACK_NUMBER:
 		return variant(att_.num_attacks());
-	} else if(key == "special") {
+	case ATTACK_SPECIAL: {
 		std::vector<std::pair<t_string, t_string> > specials = att_.special_tooltips();
 		std::vector<variant> res;
 
@@ -99,6 +128,7 @@ variant attack_type_callable::get_value(const std::string& key) const
 		}
 		return variant(&res);
 	}
+	}
 
 	return variant();
 }
@@ -139,46 +169,84 @@ int attack_type_callable::do_compare(const formula_callable* callable) const
 	return att_.weapon_specials().compare(att_callable->att_.weapon_specials());
 }
 
+namespace {
+
+enum unit_attribute {
+	UNIT_X, UNIT_Y, UNIT_LOC, UNIT_ID, UNIT_TYPE, UNIT_NAME, UNIT_USAGE,
+	UNIT_LEADER, UNIT_UNDEAD, UNIT_ATTACKS, UNIT_ABILITIES, UNIT_HITPOINTS,
+	UNIT_MAX_HITPOINTS, UNIT_EXPERIENCE, UNIT_MAX_EXPERIENCE, UNIT_LEVEL,
+	UNIT_TOTAL_MOVEMENT, UNIT_MOVEMENT_LEFT, UNIT_ATTACKS_LEFT, UNIT_TRAITS,
+	UNIT_STATES, UNIT_SIDE, UNIT_COST, UNIT_VARS
+};
+
+const char* const unit_attribute_names[] = {
+	"x", "y", "loc", "id", "type", "name", "usage",
+	"leader", "undead", "attacks", "abilities", "hitpoints",
+	"max_hitpoints", "experience", "max_experience", "level",
+	"total_movement", "movement_left", "attacks_left", "traits",
+	"states", "side", "cost", "vars", NULL
+};
+
+const game_logic::formula_key_table& unit_keys()
+{
+	static const game_logic::formula_key_table keys(unit_attribute_names);
+	return keys;
+}
+
+}
+
 variant unit_callable::get_value(const std::string& key) const
 {
-	if(key == "x") {
+	return get_attribute(unit_keys().find(key));
+}
+
+variant unit_callable::get_key_value(const game_logic::formula_key& key) const
+{
+	return get_attribute(unit_keys().find(key));
+}
+
+variant unit_callable::get_attribute(int attribute) const
+{
+	switch(attribute) {
+	case UNIT_X:
 		if (loc_==map_location::null_location()) {
 			return variant();
 		} else {
 			return variant(loc_.x+1);
 		}
-	} else if(key == "y") {
+	case UNIT_Y:
 		if (loc_==map_location::null_location()) {
 			return variant();
 		} else {
 			return variant(loc_.y+1);
 		}
-	} else if(key == "loc") {
+	case UNIT_LOC:
 		if (loc_==map_location::null_location()) {
 			return variant();
 		} else {
 			return variant(new location_callable(loc_));
 		}
-	} else if(key == "id") {
+	case UNIT_ID:
 		return variant(u_.id());
-	} else if(key == "type") {
+	case UNIT_TYPE:
 		return variant(u_.type_id());
-	} else if(key == "name") {
+	case UNIT_NAME:
 		return variant(u_.name());
-	} else if(key == "usage") {
+	case UNIT_USAGE:
 		return variant(u_.usage());
-	} else if(key == "leader") {
+	case UNIT_LEADER:
 		return variant(u_.can_recruit());
-	} else if(key == "undead") {
+	case UNIT_UNDEAD:
 		return variant(u_.get_state("not_living") ? 1 : 0);
-	} else if(key == "attacks") {
+	case UNIT_ATTACKS: {
 		const std::vector<attack_type>& att = u_.attacks();
 		std::vector<variant> res;
 
 		for( std::vector<attack_type>::const_iterator i = att.begin(); i != att.end(); ++i)
 			res.push_back(variant(new attack_type_callable(*i)));
 		return variant(&res);
-	} else if(key == "abilities") {
+	}
+	case UNIT_ABILITIES: {
 		std::vector<std::string> abilities = u_.get_ability_list();
 		std::vector<variant> res;
 
@@ -190,23 +258,24 @@ variant unit_callable::get_value(const std::string& key) const
 			res.push_back( variant(*it) );
 		}
 		return variant( &res );
-	} else if(key == "hitpoints") {
+	}
+	case UNIT_HITPOINTS:
 		return variant(u_.hitpoints());
-	} else if(key == "max_hitpoints") {
+	case UNIT_MAX_HITPOINTS:
 		return variant(u_.max_hitpoints());
-	} else if(key == "experience") {
+	case UNIT_EXPERIENCE:
 		return variant(u_.experience());
-	} else if(key == "max_experience") {
+	case UNIT_MAX_EXPERIENCE:
 		return variant(u_.max_experience());
-	} else if(key == "level") {
+	case UNIT_LEVEL:
 		return variant(u_.level());
-	} else if(key == "total_movement") {
+	case UNIT_TOTAL_MOVEMENT:
 		return variant(u_.total_movement());
-	} else if(key == "movement_left") {
+	case UNIT_MOVEMENT_LEFT:
 		return variant(u_.movement_left());
-	} else if(key == "attacks_left") {
+	case UNIT_ATTACKS_LEFT:
 		return variant(u_.attacks_left());
-	} else if(key == "traits") {
+	case UNIT_TRAITS: {
 		const std::vector<std::string> traits = u_.get_traits_list();
 		std::vector<variant> res;
 
@@ -218,23 +287,25 @@ variant unit_callable::get_value(const std::string& key) const
 			res.push_back( variant(*it) );
 		}
 		return variant( &res );
-	} else if(key == "states") {
+	}
+	case UNIT_STATES: {
 		const std::map<std::string, std::string>& states_map = u_.get_states();
 
 		return convert_map( states_map );
-	} else if(key == "side") {
+	}
+	case UNIT_SIDE:
 		return variant(u_.side()-1);
-	} else if(key == "cost") {
+	case UNIT_COST:
 		return variant(u_.cost());
-	} else if(key == "vars") {
+	case UNIT_VARS:
 		if(u_.formula_manager().formula_vars()) {
 			return variant(u_.formula_manager().formula_vars().get());
 		} else {
 			return variant();
 		}
-	} else {
-		return variant();
 	}
+
+	return variant();
 }
 
 void unit_callable::get_inputs(std::vector<game_logic::formula_input>* inputs) const
@@ -276,15 +347,50 @@ int unit_callable::do_compare(const formula_callable* callable) const
 	return u_.underlying_id() - u_callable->u_.underlying_id();
 }
 
+namespace {
+
+enum unit_type_attribute {
+	UNIT_TYPE_ID, UNIT_TYPE_TYPE, UNIT_TYPE_ALIGNMENT, UNIT_TYPE_ABILITIES,
+	UNIT_TYPE_ATTACKS, UNIT_TYPE_HITPOINTS, UNIT_TYPE_EXPERIENCE, UNIT_TYPE_LEVEL,
+	UNIT_TYPE_TOTAL_MOVEMENT, UNIT_TYPE_UNPOISONABLE, UNIT_TYPE_UNDRAINABLE,
+	UNIT_TYPE_UNPLAGUEABLE, UNIT_TYPE_COST, UNIT_TYPE_USAGE
+};
+
+const char* const unit_type_attribute_names[] = {
+	"id", "type", "alignment", "abilities",
+	"attacks", "hitpoints", "experience", "level",
+	"total_movement", "unpoisonable", "undrainable",
+	"unplagueable", "cost", "usage", NULL
+};
+
+const game_logic::formula_key_table& unit_type_keys()
+{
+	static const game_logic::formula_key_table keys(unit_type_attribute_names);
+	return keys;
+}
+
+}
+
 variant unit_type_callable::get_value(const std::string& key) const
 {
-	if(key == "id") {
+	return get_attribute(unit_type_keys().find(key));
+}
+
+variant unit_type_callable::get_key_value(const game_logic::formula_key& key) const
+{
+	return get_attribute(unit_type_keys().find(key));
+}
+
+variant unit_type_callable::get_attribute(int attribute) const
+{
+	switch(attribute) {
+	case UNIT_TYPE_ID:
 		return variant(u_.id());
-	} else if(key == "type") {
+	case UNIT_TYPE_TYPE:
 		return variant(u_.type_name());
-	} else if(key == "alignment") {
+	case UNIT_TYPE_ALIGNMENT:
 		return variant(lexical_cast<std::string>(u_.alignment()));
-	} else if(key == "abilities") {
+	case UNIT_TYPE_ABILITIES: {
 		std::vector<std::string> abilities = u_.get_ability_list();
 		std::vector<variant> res;
 
@@ -296,34 +402,36 @@ variant unit_type_callable::get_value(const std::string& key) const
 			res.push_back( variant(*it) );
 		}
 		return variant( &res );
-	} else if(key == "attacks") {
+	}
+	case UNIT_TYPE_ATTACKS: {
 		std::vector<attack_type> att = u_.attacks();
 		std::vector<variant> res;
 
 		for( std::vector<attack_type>::iterator i = att.begin(); i != att.end(); ++i)
 			res.push_back(variant(new attack_type_callable(*i)));
 		return variant(&res);
-	} else if(key == "hitpoints") {
+	}
+	case UNIT_TYPE_HITPOINTS:
 		return variant(u_.hitpoints());
-	} else if(key == "experience") {
+	case UNIT_TYPE_EXPERIENCE:
 		return variant(u_.experience_needed(true));
-	} else if(key == "level") {
+	case UNIT_TYPE_LEVEL:
 		return variant(u_.level());
-	} else if(key == "total_movement") {
+	case UNIT_TYPE_TOTAL_MOVEMENT:
 		return variant(u_.movement());
-	} else if(key == "unpoisonable") {
+	case UNIT_TYPE_UNPOISONABLE:
 		return variant(u_.musthave_status("unpoisonable"));
-	} else if(key == "undrainable") {
+	case UNIT_TYPE_UNDRAINABLE:
 		return variant(u_.musthave_status("undrainable"));
-	} else if(key == "unplagueable") {
+	case UNIT_TYPE_UNPLAGUEABLE:
 		return variant(u_.musthave_status("unplagueable"));
-	} else if(key == "cost") {
+	case UNIT_TYPE_COST:
 		return variant(u_.cost());
-	} else if(key == "usage") {
+	case UNIT_TYPE_USAGE:
 		return variant(u_.usage());
-	} else {
-		return variant();
 	}
+
+	return variant();
 }
 
 void unit_type_callable::get_inputs(std::vector<game_logic::formula_input>* inputs) const
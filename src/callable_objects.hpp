@@ -138,6 +138,9 @@ public:
 
 	int do_compare(const formula_callable* callable) const;
 private:
+	variant get_key_value(const game_logic::formula_key& key) const;
+	variant get_attribute(int attribute) const;
+
 	const attack_type att_;
 };
 
@@ -164,6 +167,9 @@ public:
 
 	int do_compare(const formula_callable* callable) const;
 private:
+	variant get_key_value(const game_logic::formula_key& key) const;
+	variant get_attribute(int attribute) const;
+
 	const location& loc_;
 	const unit& u_;
 };
@@ -183,6 +189,9 @@ public:
 
 	int do_compare(const formula_callable* callable) const;
 private:
+	variant get_key_value(const game_logic::formula_key& key) const;
+	variant get_attribute(int attribute) const;
+
 	const unit_type& u_;
 };
 
@@ -0,0 +1,148 @@
+/*
+   Copyright (C) 2015 by the Battle for Wesnoth Project
+   Part of the Battle for Wesnoth Project http://www.wesnoth.org/
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY.
+
+   See the COPYING file for more details.
+*/
+
+#include "campaign_server/addon_index.hpp"
+
+#include "config.hpp"
+#include "serialization/unicode.hpp"
+
+#include <boost/foreach.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <functional>
+#include <iterator>
+
+namespace campaignd
+{
+
+namespace
+{
+
+/** The fields of an add-on entry that are searched. */
+const char* const indexed_fields[] = { "title", "name", "author", "description", "type" };
+
+/** Bytes of UTF-8 sequences, which are kept in words, count as letters. */
+bool is_word_char(char c)
+{
+	return isalnum(static_cast<unsigned char>(c)) || (c & 0x80) != 0;
+}
+
+}
+
+addon_index::addon_index()
+	: words_()
+	, count_(0)
+	, stale_(true)
+{
+}
+
+void addon_index::clear()
+{
+	words_.clear();
+	count_ = 0;
+	stale_ = true;
+}
+
+void addon_index::build(const config& campaigns)
+{
+	clear();
+
+	BOOST_FOREACH(const config& campaign, campaigns.child_range("campaign")) {
+		BOOST_FOREACH(const char* field, indexed_fields) {
+			BOOST_FOREACH(const std::string& word, split_words(campaign[field].str())) {
+				std::vector<unsigned>& addons = words_[word];
+				// Add-ons are indexed in order, so a repeated word is last.
+				if(addons.empty() || addons.back() != count_) {
+					addons.push_back(count_);
+				}
+			}
+		}
+		++count_;
+	}
+
+	stale_ = false;
+}
+
+std::vector<unsigned> addon_index::search(const std::string& query) const
+{
+	std::vector<unsigned> res;
+	const std::vector<std::string>& terms = split_words(query);
+	if(terms.empty()) {
+		for(unsigned i = 0; i != count_; ++i) {
+			res.push_back(i);
+		}
+		return res;
+	}
+
+	// The add-ons matching each term; intersecting them starting from the
+	// rarest one keeps the intermediate results small.
+	std::vector<std::vector<unsigned> > matches;
+	BOOST_FOREACH(const std::string& term, terms) {
+		std::vector<unsigned> found;
+		for(word_map::const_iterator i = words_.lower_bound(term);
+			i != words_.end() && i->first.compare(0, term.size(), term) == 0; ++i)
+		{
+			std::vector<unsigned> merged;
+			std::set_union(found.begin(), found.end(), i->second.begin(), i->second.end(),
+				std::back_inserter(merged));
+			found.swap(merged);
+		}
+		if(found.empty()) {
+			return res;
+		}
+		matches.push_back(std::vector<unsigned>());
+		matches.back().swap(found);
+	}
+
+	size_t rarest = 0;
+	for(size_t i = 1; i != matches.size(); ++i) {
+		if(matches[i].size() < matches[rarest].size()) {
+			rarest = i;
+		}
+	}
+	res.swap(matches[rarest]);
+
+	for(size_t i = 0; i != matches.size() && !res.empty(); ++i) {
+		if(i == rarest) {
+			continue;
+		}
+		std::vector<unsigned> common;
+		std::set_intersection(res.begin(), res.end(), matches[i].begin(), matches[i].end(),
+			std::back_inserter(common));
+		res.swap(common);
+	}
+
+	return res;
+}
+
+std::vector<std::string> addon_index::split_words(const std::string& text)
+{
+	std::vector<std::string> res;
+	const std::string& lower = utf8::lowercase(text);
+
+	std::string::const_iterator i = lower.begin();
+	while(i != lower.end()) {
+		i = std::find_if(i, lower.end(), is_word_char);
+		std::string::const_iterator end = std::find_if(i, lower.end(), std::not1(std::ptr_fun(is_word_char)));
+		if(i != end) {
+			res.push_back(std::string(i, end));
+		}
+		i = end;
+	}
+
+	return res;
+}
+
+}
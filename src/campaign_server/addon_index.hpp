@@ -0,0 +1,71 @@
+/*
+   Copyright (C) 2015 by the Battle for Wesnoth Project
+   Part of the Battle for Wesnoth Project http://www.wesnoth.org/
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY.
+
+   See the COPYING file for more details.
+*/
+
+#ifndef CAMPAIGN_SERVER_ADDON_INDEX_HPP_INCLUDED
+#define CAMPAIGN_SERVER_ADDON_INDEX_HPP_INCLUDED
+
+#include <map>
+#include <string>
+#include <vector>
+
+class config;
+
+namespace campaignd
+{
+
+/**
+ * Full-text index of the add-ons list.
+ *
+ * Maps every word of the title, name, author, description and type of the
+ * add-ons to the add-ons it appears in, so that searches don't need to look
+ * at every add-on. Words are compared without regard to case, and a word of
+ * a query matches every word it is the beginning of.
+ */
+class addon_index
+{
+public:
+	addon_index();
+
+	/** Indexes the [campaign] children of @a campaigns, replacing the previous contents. */
+	void build(const config& campaigns);
+
+	/** Forgets the add-ons indexed, until the next build(). */
+	void clear();
+
+	/** Whether build() needs to be called before searching. */
+	bool stale() const { return stale_; }
+
+	/**
+	 * Finds the add-ons matching every word of @a query.
+	 *
+	 * @returns                   The indices of the matching [campaign]
+	 *                            children, in the order of the list. A
+	 *                            query without words matches all of them.
+	 */
+	std::vector<unsigned> search(const std::string& query) const;
+
+	/** The lowercase words of @a text, any character but letters and digits separating them. */
+	static std::vector<std::string> split_words(const std::string& text);
+
+private:
+	/** The add-ons, sorted, in which each word appears. */
+	typedef std::map<std::string, std::vector<unsigned> > word_map;
+	word_map words_;
+	unsigned count_;
+	bool stale_;
+};
+
+}
+
+#endif
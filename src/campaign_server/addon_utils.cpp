@@ -18,6 +18,7 @@
 #include "config.hpp"
 #include "filesystem.hpp"
 #include "game_config.hpp"
+#include "hash.hpp"
 #include "log.hpp"
 #include "serialization/string_utils.hpp"
 
@@ -135,4 +136,67 @@ void add_license(config& cfg)
 	copying["contents"] = contents;
 }
 
+namespace {
+
+std::string contents_hash(const config& file)
+{
+	return util::content_hash_hex(file["contents"]);
+}
+
+}
+
+void make_file_hashes(const config& archive, config& hashes)
+{
+	BOOST_FOREACH(const config& file, archive.child_range("file")) {
+		config& hash = hashes.add_child("file");
+		hash["name"] = file["name"];
+		hash["hash"] = contents_hash(file);
+	}
+
+	BOOST_FOREACH(const config& dir, archive.child_range("dir")) {
+		config& dir_hashes = hashes.add_child("dir");
+		dir_hashes["name"] = dir["name"];
+		make_file_hashes(dir, dir_hashes);
+	}
+}
+
+void make_archive_delta(const config& from_hashes, const config& archive, config& delta)
+{
+	// Removals come first, so a file can be replaced by a directory and
+	// conversely.
+	BOOST_FOREACH(const config& file, from_hashes.child_range("file")) {
+		if(!archive.find_child("file", "name", file["name"])) {
+			delta.add_child("remove")["name"] = file["name"];
+		}
+	}
+
+	BOOST_FOREACH(const config& dir, from_hashes.child_range("dir")) {
+		if(!archive.find_child("dir", "name", dir["name"])) {
+			delta.add_child("remove")["name"] = dir["name"];
+		}
+	}
+
+	BOOST_FOREACH(const config& file, archive.child_range("file")) {
+		const config& old = from_hashes.find_child("file", "name", file["name"]);
+		if(!old || old["hash"] != contents_hash(file)) {
+			delta.add_child("file", file);
+		}
+	}
+
+	BOOST_FOREACH(const config& dir, archive.child_range("dir")) {
+		const config& old = from_hashes.find_child("dir", "name", dir["name"]);
+		if(!old) {
+			delta.add_child("dir", dir);
+			continue;
+		}
+
+		config dir_delta;
+		make_archive_delta(old, dir, dir_delta);
+		if(!dir_delta.empty()) {
+			dir_delta["name"] = dir["name"];
+			delta.add_child("dir", dir_delta);
+		}
+	}
+}
+
 } // end namespace campaignd
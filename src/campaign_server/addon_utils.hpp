@@ -79,6 +79,37 @@ void find_translations(const config& base_dir, config& addon);
  */
 void add_license(config& cfg);
 
+/**
+ * Records the contents hash of every file of the add-on archive @a archive.
+ *
+ * @a hashes receives the same tree of [dir] and [file] nodes, with a
+ * @a hash attribute in place of the file contents.
+ */
+void make_file_hashes(const config& archive, config& hashes);
+
+/**
+ * Builds the update from an earlier version of an add-on to the archive
+ * @a archive, given the file hashes of that version.
+ *
+ * @a delta receives the [dir] and [file] nodes of @a archive leading to
+ * the files that are new or have changed, and a [remove] node with the
+ * name of each file or directory the new version no longer has:
+ *
+ * @verbatim
+ *     [dir]
+ *         name="My_Addon"
+ *         [remove]
+ *             name="obsolete.cfg"
+ *         [/remove]
+ *         [file]
+ *             name="_main.cfg"
+ *             contents="..."
+ *         [/file]
+ *     [/dir]
+ * @endverbatim
+ */
+void make_archive_delta(const config& from_hashes, const config& archive, config& delta);
+
 }
 
 #endif
@@ -104,14 +104,18 @@ server::server(const std::string& cfg_file, size_t min_threads, size_t max_threa
 	, cfg_file_(cfg_file)
 	, read_only_(false)
 	, compress_level_(0)
+	, delta_versions_(0)
 	, input_()
 	, hooks_()
 	, handlers_()
 	, feedback_url_format_()
+	, campaign_list_cache_()
+	, index_()
 	, blacklist_()
 	, blacklist_file_()
 	, net_manager_(min_threads, max_threads)
 	, server_manager_(load_config())
+	, uploads_()
 {
 #ifndef _MSC_VER
 	signal(SIGHUP, exit_sighup);
@@ -145,6 +149,7 @@ int server::load_config()
 
 	// Seems like compression level above 6 is a waste of CPU cycles.
 	compress_level_ = cfg_["compress_level"].to_int(6);
+	delta_versions_ = cfg_["delta_versions"].to_int(4);
 
 	const config& svinfo_cfg = server_info();
 	if(svinfo_cfg) {
@@ -201,6 +206,8 @@ void server::write_config()
 	DBG_CS << "writing configuration and add-ons list to disk...\n";
 	filesystem::scoped_ostream out = filesystem::ostream_file(cfg_file_);
 	write(*out, cfg_);
+	campaign_list_cache_.clear();
+	index_.clear();
 	DBG_CS << "... done\n";
 }
 
@@ -284,6 +291,8 @@ void server::run()
 				last_ts = cur_ts;
 			}
 
+			process_uploads();
+
 			network::process_send_queue();
 
 			sock = network::accept_connection();
@@ -343,6 +352,12 @@ void server::run()
 
 		SDL_Delay(20);
 	}
+
+	// Complete the uploads still waiting to be stored.
+	while(!uploads_.empty()) {
+		process_uploads();
+		SDL_Delay(20);
+	}
 }
 
 void server::register_handler(const std::string& cmd, const request_handler& func)
@@ -356,6 +371,7 @@ void server::register_handler(const std::string& cmd, const request_handler& fun
 void server::register_handlers()
 {
 	REGISTER_CAMPAIGND_HANDLER(request_campaign_list);
+	REGISTER_CAMPAIGND_HANDLER(request_campaign_search);
 	REGISTER_CAMPAIGND_HANDLER(request_campaign);
 	REGISTER_CAMPAIGND_HANDLER(request_terms);
 	REGISTER_CAMPAIGND_HANDLER(upload);
@@ -367,6 +383,20 @@ void server::handle_request_campaign_list(const server::request& req)
 {
 	LOG_CS << "sending campaign list to " << req.addr << " using gzip";
 
+	// Requests limited to a time range depend on the current time, so only
+	// the other ones are answered from the cache.
+	const bool cacheable = req.cfg["before"].empty() && req.cfg["after"].empty();
+	const std::string cache_key = req.cfg["name"].str() + '\n' + req.cfg["language"].str();
+
+	if(cacheable) {
+		const std::map<std::string, network::raw_packet>::const_iterator cached = campaign_list_cache_.find(cache_key);
+		if(cached != campaign_list_cache_.end()) {
+			network::send_raw_packet(cached->second, req.sock);
+			std::cerr << " size: " << (cached->second->size()/1024) << "KiB (cached)\n";
+			return;
+		}
+	}
+
 	time_t epoch = time(NULL);
 	config campaign_list;
 
@@ -428,26 +458,85 @@ void server::handle_request_campaign_list(const server::request& req)
 
 	BOOST_FOREACH(config& j, campaign_list.child_range("campaign"))
 	{
-		j["passphrase"] = "";
-		j["upload_ip"] = "";
-		j["email"] = "";
-		j["feedback_url"] = "";
-
-		// Build a feedback_url string attribute from the
-		// internal [feedback] data.
-		const config& url_params = j.child_or_empty("feedback");
-		if(!url_params.empty() && !feedback_url_format_.empty()) {
-			j["feedback_url"] = format_addon_feedback_url(feedback_url_format_, url_params);
-		}
+		make_public_entry(j);
+	}
 
-		// Clients don't need to see the original data, so discard it.
-		j.clear_children("feedback");
+	// Clients keeping the list they got earlier ask for the add-ons
+	// uploaded since, and need to know about the deleted ones too.
+	if(after_flag) {
+		BOOST_FOREACH(const config& i, campaigns().child_range("deleted"))
+		{
+			const time_t tm = i["timestamp"].to_time_t();
+			if((name.empty() || name == i["name"]) && tm > after && (!before_flag || tm < before)) {
+				campaign_list.add_child("deleted", i);
+			}
+		}
 	}
 
 	config response;
 	response.add_child("campaigns", campaign_list);
 
-	std::cerr << " size: " << (network::send_data(response, req.sock)/1024) << "KiB\n";
+	if(!cacheable) {
+		std::cerr << " size: " << (network::send_data(response, req.sock)/1024) << "KiB\n";
+		return;
+	}
+
+	std::ostringstream compressed;
+	{
+		config_writer writer(compressed, true, compress_level_);
+		writer.write(response);
+	}
+	const std::string& data = compressed.str();
+	const network::raw_packet packet = network::make_raw_packet(data.c_str(), data.size());
+	campaign_list_cache_[cache_key] = packet;
+
+	network::send_raw_packet(packet, req.sock);
+	std::cerr << " size: " << (packet->size()/1024) << "KiB\n";
+}
+
+void server::handle_request_campaign_search(const server::request& req)
+{
+	LOG_CS << "searching campaign list for '" << req.cfg["query"] << "' for " << req.addr << '\n';
+
+	if(index_.stale()) {
+		index_.build(campaigns());
+	}
+
+	const std::vector<unsigned>& found = index_.search(req.cfg["query"]);
+	const size_t offset = std::min<size_t>(std::max(req.cfg["offset"].to_int(), 0), found.size());
+	const size_t limit = std::min(std::max(req.cfg["limit"].to_int(50), 1), 200);
+
+	config response;
+	config& campaign_list = response.add_child("campaigns");
+	campaign_list["timestamp"] = time(NULL);
+	campaign_list["total"] = found.size();
+	campaign_list["offset"] = offset;
+
+	for(size_t i = offset; i != found.size() && i != offset + limit; ++i) {
+		make_public_entry(campaign_list.add_child("campaign", campaigns().child("campaign", found[i])));
+	}
+
+	network::send_data(response, req.sock);
+}
+
+void server::make_public_entry(config& campaign) const
+{
+	campaign["passphrase"] = "";
+	campaign["upload_ip"] = "";
+	campaign["email"] = "";
+	campaign["feedback_url"] = "";
+
+	// Build a feedback_url string attribute from the
+	// internal [feedback] data.
+	const config& url_params = campaign.child_or_empty("feedback");
+	if(!url_params.empty() && !feedback_url_format_.empty()) {
+		campaign["feedback_url"] = format_addon_feedback_url(feedback_url_format_, url_params);
+	}
+
+	// Clients don't need to see the original data, so discard it.
+	campaign.clear_children("feedback");
+	campaign.clear_children("file_hashes");
+	campaign.clear_children("delta");
 }
 
 void server::handle_request_campaign(const server::request& req)
@@ -459,7 +548,16 @@ void server::handle_request_campaign(const server::request& req)
 	if(!campaign) {
 		send_error("Add-on '" + req.cfg["name"].str() + "' not found.", req.sock);
 	} else {
-		const int size = filesystem::file_size(campaign["filename"]);
+		std::string filename = campaign["filename"];
+
+		// Clients updating an add-on say which upload they have installed,
+		// and only get the changes since then if we have them.
+		if(const config& delta = campaign.find_child("delta", "from_uploads", req.cfg["from_uploads"])) {
+			LOG_CS << "sending the changes since upload " << delta["from_uploads"] << " to " << req.addr << '\n';
+			filename = delta["filename"].str();
+		}
+
+		const int size = filesystem::file_size(filename);
 
 		if(size < 0) {
 			std::cerr << " size: <unknown> KiB\n";
@@ -469,7 +567,7 @@ void server::handle_request_campaign(const server::request& req)
 		}
 
 		std::cerr << " size: " << size/1024 << "KiB\n";
-		network::send_file(campaign["filename"], req.sock);
+		network::send_file(filename, req.sock);
 		// Clients doing upgrades or some other specific thing shouldn't bump
 		// the downloads count. Default to true for compatibility with old
 		// clients that won't tell us what they are trying to do.
@@ -571,6 +669,9 @@ void server::handle_upload(const server::request& req)
 	} else if(campaign && (*campaign)["passphrase"].str() != upload["passphrase"]) {
 		LOG_CS << "Upload aborted - incorrect passphrase.\n";
 		send_error("Add-on rejected: The add-on already exists, and your passphrase was incorrect.", req.sock);
+	} else if(upload_in_progress(name)) {
+		LOG_CS << "Upload aborted - another upload of the add-on is in progress.\n";
+		send_error("Add-on rejected: Another upload of the add-on is still being processed.", req.sock);
 	} else {
 		const time_t upload_ts = time(NULL);
 
@@ -594,74 +695,267 @@ void server::handle_upload(const server::request& req)
 			send_error("Add-on rejected: The add-on publish information contains an invalid UTF-8 sequence.", req.sock);
 		}
 
-		std::string message = "Add-on accepted.";
+		upload_job* job = new upload_job(req.sock);
+		uploads_.push_back(job);
+
+		job->message = "Add-on accepted.";
 
 		if(!version_info(upload["version"]).good()) {
-			message += "\n\nNote: The version you specified is invalid. This add-on will be ignored for automatic update checks.";
+			job->message += "\n\nNote: The version you specified is invalid. This add-on will be ignored for automatic update checks.";
 		}
 
-		if(campaign == NULL) {
-			campaign = &campaigns().add_child("campaign");
-			(*campaign)["original_timestamp"] = upload_ts;
+		job->upload.merge_attributes(upload);
+		if(const config& url_params = upload.child("feedback")) {
+			job->upload.add_child("feedback", url_params);
 		}
 
-		(*campaign)["title"] = upload["title"];
-		(*campaign)["name"] = upload["name"];
-		(*campaign)["filename"] = "data/" + upload["name"].str();
-		(*campaign)["passphrase"] = upload["passphrase"];
-		(*campaign)["author"] = upload["author"];
-		(*campaign)["description"] = upload["description"];
-		(*campaign)["version"] = upload["version"];
-		(*campaign)["icon"] = upload["icon"];
-		(*campaign)["translate"] = upload["translate"];
-		(*campaign)["dependencies"] = upload["dependencies"];
-		(*campaign)["upload_ip"] = req.addr;
-		(*campaign)["type"] = upload["type"];
-		(*campaign)["email"] = upload["email"];
-
-		if((*campaign)["downloads"].empty()) {
-			(*campaign)["downloads"] = 0;
+		job->filename = "data/" + name;
+		job->uploads = 1;
+		job->compress_level = compress_level_;
+		job->delta_versions = delta_versions_;
+
+		time_t original_ts = upload_ts;
+		if(campaign != NULL) {
+			job->previous_name = (*campaign)["name"].str();
+			job->uploads = (*campaign)["uploads"].to_int() + 1;
+			original_ts = (*campaign)["original_timestamp"].to_time_t(upload_ts);
+
+			BOOST_FOREACH(const config& version, campaign->child_range("file_hashes")) {
+				job->earlier.push_back(version);
+			}
+			// The oldest uploads are beyond the number kept.
+			while(job->earlier.size() > static_cast<size_t>(std::max(delta_versions_, 0))) {
+				job->earlier.erase(job->earlier.begin());
+			}
 		}
-		(*campaign)["timestamp"] = upload_ts;
 
-		int uploads = (*campaign)["uploads"].to_int() + 1;
-		(*campaign)["uploads"] = uploads;
+		job->data.swap(data);
+		job->data["title"] = upload["title"];
+		job->data["name"] = "";
+		job->data["campaign_name"] = name;
+		job->data["author"] = upload["author"];
+		job->data["description"] = upload["description"];
+		job->data["version"] = upload["version"];
+		job->data["timestamp"] = upload_ts;
+		job->data["original_timestamp"] = original_ts;
+		job->data["icon"] = upload["icon"];
+		job->data["type"] = upload["type"];
+
+		// Compressing a large add-on takes a while, so process_uploads()
+		// has it done aside while the other clients are served.
+	}
+}
 
-		(*campaign).clear_children("feedback");
-		if(const config& url_params = upload.child("feedback")) {
-			(*campaign).add_child("feedback", url_params);
+bool server::upload_in_progress(const std::string& name) const
+{
+	const std::string& lc_name = utf8::lowercase(name);
+	for(boost::ptr_vector<upload_job>::const_iterator job = uploads_.begin(); job != uploads_.end(); ++job) {
+		if(utf8::lowercase(job->upload["name"]) == lc_name) {
+			return true;
 		}
+	}
+	return false;
+}
 
-		const std::string& filename = (*campaign)["filename"].str();
-		data["title"] = (*campaign)["title"];
-		data["name"] = "";
-		data["campaign_name"] = (*campaign)["name"];
-		data["author"] = (*campaign)["author"];
-		data["description"] = (*campaign)["description"];
-		data["version"] = (*campaign)["version"];
-		data["timestamp"] = (*campaign)["timestamp"];
-		data["original_timestamp"] = (*campaign)["original_timestamp"];
-		data["icon"] = (*campaign)["icon"];
-		data["type"] = (*campaign)["type"];
-		(*campaign).clear_children("translation");
-		find_translations(data, *campaign);
-
-		add_license(data);
+int server::write_upload(void* data)
+{
+	upload_job& job = *static_cast<upload_job*>(data);
+
+	try {
+		find_translations(job.data, job.results);
+		add_license(job.data);
 
+		const std::string temp_file = job.filename + ".upload";
 		{
-			filesystem::scoped_ostream campaign_file = filesystem::ostream_file(filename);
-			config_writer writer(*campaign_file, true, compress_level_);
-			writer.write(data);
+			filesystem::scoped_ostream campaign_file = filesystem::ostream_file(temp_file);
+			config_writer writer(*campaign_file, true, job.compress_level);
+			writer.write(job.data);
 		}
+		job.size = filesystem::file_size(temp_file);
+
+		write_deltas(job);
+	} catch(const std::exception& e) {
+		job.error = e.what();
+	}
 
-		(*campaign)["size"] = filesystem::file_size(filename);
+	const threading::lock lock(job.mutex);
+	job.done = true;
+	return 0;
+}
 
-		write_config();
+void server::write_deltas(upload_job& job)
+{
+	const std::string uploads = str_cast(job.uploads);
+
+	BOOST_FOREACH(const config& version, job.earlier) {
+		config hashes;
+		try {
+			filesystem::scoped_istream in = filesystem::istream_file(version["filename"]);
+			read_gz(hashes, *in);
+		} catch(const config::error& e) {
+			ERR_CS << "could not read the file hashes of upload " << version["uploads"]
+				   << " of '" << job.upload["name"] << "': " << e.message << '\n';
+			continue;
+		}
+
+		config delta;
+		make_archive_delta(hashes, job.data, delta);
+		delta.merge_attributes(job.data);
+		delta["delta_from"] = version["uploads"];
+
+		// Named after both uploads, so the deltas sent meanwhile stay intact.
+		const std::string delta_file = job.filename + ".delta." + version["uploads"].str() + "." + uploads;
+		{
+			filesystem::scoped_ostream delta_stream = filesystem::ostream_file(delta_file);
+			config_writer writer(*delta_stream, true, job.compress_level);
+			writer.write(delta);
+		}
+
+		const int size = filesystem::file_size(delta_file);
+		if(size < 0 || size >= job.size) {
+			filesystem::delete_file(delta_file);
+		} else {
+			config& entry = job.results.add_child("delta");
+			entry["from_uploads"] = version["uploads"];
+			entry["filename"] = delta_file;
+			entry["size"] = size;
+		}
+
+		job.results.add_child("file_hashes", version);
+	}
+
+	if(job.delta_versions > 0) {
+		config hashes;
+		make_file_hashes(job.data, hashes);
+
+		const std::string hashes_file = job.filename + ".hashes." + uploads;
+		{
+			filesystem::scoped_ostream hashes_stream = filesystem::ostream_file(hashes_file);
+			config_writer writer(*hashes_stream, true, job.compress_level);
+			writer.write(hashes);
+		}
+
+		config& entry = job.results.add_child("file_hashes");
+		entry["uploads"] = job.uploads;
+		entry["filename"] = hashes_file;
+	}
+}
+
+void server::process_uploads()
+{
+	if(uploads_.empty()) {
+		return;
+	}
 
-		send_message(message, req.sock);
+	upload_job& job = uploads_.front();
+	if(!job.thread) {
+		job.thread.reset(new threading::thread(&server::write_upload, &job));
+		return;
+	}
 
-		fire("hook_post_upload", upload["name"]);
+	{
+		const threading::lock lock(job.mutex);
+		if(!job.done) {
+			return;
+		}
 	}
+
+	job.thread->join();
+	finish_upload(job);
+	uploads_.erase(uploads_.begin());
+}
+
+void server::finish_upload(upload_job& job)
+{
+	const config& upload = job.upload;
+	const std::string temp_file = job.filename + ".upload";
+
+	if(job.error.empty() && rename(temp_file.c_str(), job.filename.c_str()) != 0) {
+		job.error = strerror(errno);
+	}
+
+	if(!job.error.empty()) {
+		ERR_CS << "failed to store the upload of '" << upload["name"] << "': " << job.error << '\n';
+		filesystem::delete_file(temp_file);
+		BOOST_FOREACH(const config& entry, job.results.child_range("delta")) {
+			filesystem::delete_file(entry["filename"]);
+		}
+		if(const config& entry = job.results.find_child("file_hashes", "uploads", str_cast(job.uploads))) {
+			filesystem::delete_file(entry["filename"]);
+		}
+		send_error("Server error: The add-on could not be stored.", job.sock);
+		return;
+	}
+
+	// The add-on may have been deleted meanwhile.
+	config* campaign = job.previous_name.empty() ? NULL
+		: &campaigns().find_child("campaign", "name", job.previous_name);
+
+	if(campaign == NULL || !*campaign) {
+		campaign = &campaigns().add_child("campaign");
+		(*campaign)["original_timestamp"] = job.data["original_timestamp"];
+	}
+
+	// The entry may be renamed to a different case of the name, and the new
+	// name is no longer reported as deleted if it was.
+	if(!job.previous_name.empty() && job.previous_name != upload["name"]) {
+		record_deletion(job.previous_name);
+	}
+	config::const_child_itors deleted = campaigns().child_range("deleted");
+	for(size_t index = 0; deleted.first != deleted.second; ++index, ++deleted.first) {
+		if((*deleted.first)["name"] == upload["name"]) {
+			campaigns().remove_child("deleted", index);
+			break;
+		}
+	}
+
+	(*campaign)["title"] = upload["title"];
+	(*campaign)["name"] = upload["name"];
+	(*campaign)["filename"] = job.filename;
+	(*campaign)["passphrase"] = upload["passphrase"];
+	(*campaign)["author"] = upload["author"];
+	(*campaign)["description"] = upload["description"];
+	(*campaign)["version"] = upload["version"];
+	(*campaign)["icon"] = upload["icon"];
+	(*campaign)["translate"] = upload["translate"];
+	(*campaign)["dependencies"] = upload["dependencies"];
+	(*campaign)["upload_ip"] = job.addr;
+	(*campaign)["type"] = upload["type"];
+	(*campaign)["email"] = upload["email"];
+
+	if((*campaign)["downloads"].empty()) {
+		(*campaign)["downloads"] = 0;
+	}
+	(*campaign)["timestamp"] = job.data["timestamp"];
+	(*campaign)["uploads"] = job.uploads;
+
+	(*campaign).clear_children("feedback");
+	if(const config& url_params = upload.child("feedback")) {
+		(*campaign).add_child("feedback", url_params);
+	}
+
+	(*campaign)["size"] = job.size;
+
+	// The files of the earlier deltas that were not carried over are unused.
+	BOOST_FOREACH(const config& entry, (*campaign).child_range("delta")) {
+		filesystem::delete_file(entry["filename"]);
+	}
+	BOOST_FOREACH(const config& entry, (*campaign).child_range("file_hashes")) {
+		if(!job.results.find_child("file_hashes", "filename", entry["filename"])) {
+			filesystem::delete_file(entry["filename"]);
+		}
+	}
+
+	(*campaign).clear_children("translation");
+	(*campaign).clear_children("delta");
+	(*campaign).clear_children("file_hashes");
+	(*campaign).append_children(job.results);
+
+	write_config();
+
+	send_message(job.message, job.sock);
+
+	fire("hook_post_upload", upload["name"]);
 }
 
 void server::handle_delete(const server::request& req)
@@ -683,6 +977,11 @@ void server::handle_delete(const server::request& req)
 		return;
 	}
 
+	if(upload_in_progress(erase["name"])) {
+		send_error("Cannot delete add-on: An upload of it is still being processed.", req.sock);
+		return;
+	}
+
 	if(campaign["passphrase"] != erase["passphrase"]
 	   && (campaigns()["master_password"].empty()
 	   || campaigns()["master_password"] != erase["passphrase"]))
@@ -692,6 +991,7 @@ void server::handle_delete(const server::request& req)
 	}
 
 	// Erase the campaign.
+	delete_deltas(campaign);
 	filesystem::write_file(campaign["filename"], std::string());
 	if(remove(campaign["filename"].str().c_str()) != 0) {
 		ERR_CS << "failed to delete archive for campaign '" << erase["name"]
@@ -708,6 +1008,7 @@ void server::handle_delete(const server::request& req)
 		}
 	}
 
+	record_deletion(erase["name"]);
 	write_config();
 
 	send_message("Add-on deleted.", req.sock);
@@ -716,6 +1017,24 @@ void server::handle_delete(const server::request& req)
 
 }
 
+void server::record_deletion(const std::string& name)
+{
+	config& deleted = campaigns().find_child("deleted", "name", name);
+	config& entry = deleted ? deleted : campaigns().add_child("deleted");
+	entry["name"] = name;
+	entry["timestamp"] = time(NULL);
+}
+
+void server::delete_deltas(const config& campaign)
+{
+	BOOST_FOREACH(const config& delta, campaign.child_range("delta")) {
+		filesystem::delete_file(delta["filename"]);
+	}
+	BOOST_FOREACH(const config& version, campaign.child_range("file_hashes")) {
+		filesystem::delete_file(version["filename"]);
+	}
+}
+
 void server::handle_change_passphrase(const server::request& req)
 {
 	const config& cpass = req.cfg;
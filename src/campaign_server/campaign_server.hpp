@@ -17,12 +17,17 @@
 
 #include "campaign_server/blacklist.hpp"
 #include "network.hpp"
+#include "campaign_server/addon_index.hpp"
 #include "server/input_stream.hpp"
+#include "thread.hpp"
 
 #include "utils/boost_function_guarded.hpp"
+#include <boost/ptr_container/ptr_vector.hpp>
 #include <boost/scoped_ptr.hpp>
 #include <boost/unordered_map.hpp>
 
+#include <vector>
+
 namespace campaignd {
 
 /**
@@ -86,6 +91,7 @@ private:
 
 	bool read_only_;
 	int compress_level_; /**< Used for add-on archives. */
+	int delta_versions_; /**< Earlier uploads of an add-on that get a delta to the latest one. */
 
 	boost::scoped_ptr<input_stream> input_; /**< Server control socket. */
 
@@ -94,6 +100,19 @@ private:
 
 	std::string feedback_url_format_;
 
+	/**
+	 * The compressed add-ons list responses, by the name and language the
+	 * request filtered on.
+	 *
+	 * write_config() empties it, which every change to the list is followed
+	 * by; the download counts in it may lag by up to the ten minutes between
+	 * two periodic writes.
+	 */
+	std::map<std::string, network::raw_packet> campaign_list_cache_;
+
+	/** The words of the add-ons list, rebuilt after write_config() for the next search. */
+	addon_index index_;
+
 	blacklist blacklist_;
 	std::string blacklist_file_;
 
@@ -117,6 +136,128 @@ private:
 	 */
 	void load_blacklist();
 
+	/**
+	 * An upload being stored by a background thread.
+	 *
+	 * handle_upload() validates the request and queues it. process_uploads()
+	 * runs write_upload() in a thread for one upload at a time, then puts
+	 * the archive in place and updates the add-on entry in the main loop.
+	 */
+	struct upload_job : private boost::noncopyable
+	{
+		explicit upload_job(network::connection s)
+			: sock(s), addr(network::ip_address(s)), upload(), data(), message()
+			, previous_name(), filename(), uploads(0), earlier()
+			, compress_level(0), delta_versions(0), results(), size(0)
+			, error(), mutex(), done(false), thread()
+		{}
+
+		const network::connection sock;
+		const std::string addr;
+		/** The [upload] request, without its [data]. */
+		config upload;
+		/** The archive to store, with the add-on information. */
+		config data;
+		/** The answer to send once the add-on is stored. */
+		std::string message;
+
+		/** The name of the add-on entry this upload replaces, if any. */
+		std::string previous_name;
+		std::string filename;
+		int uploads;
+		/** The [file_hashes] of the earlier uploads to make deltas from. */
+		std::vector<config> earlier;
+		int compress_level;
+		int delta_versions;
+
+		/** The [translation], [delta] and [file_hashes] of the new entry. */
+		config results;
+		int size;
+		/** Why storing the upload failed, empty if it didn't. */
+		std::string error;
+
+		/** Guards @a done, set by the thread when it is through. */
+		threading::mutex mutex;
+		bool done;
+		boost::scoped_ptr<threading::thread> thread;
+	};
+
+	/** The uploads waiting to be stored, the first one being stored. */
+	boost::ptr_vector<upload_job> uploads_;
+
+	/** Whether an upload of the add-on @a name is waiting to be stored. */
+	bool upload_in_progress(const std::string& name) const;
+
+	/**
+	 * Stores an upload, in its own thread.
+	 *
+	 * The archive is written to a temporary file, then write_deltas() is
+	 * called. None of the server's data is touched.
+	 */
+	static int write_upload(void* job);
+
+	/**
+	 * Prebuilds the deltas from the earlier uploads of an add-on.
+	 *
+	 * The deltas to the previous upload will be replaced by deltas to this
+	 * one, from each of the last @a delta_versions_ uploads whose file
+	 * hashes were kept. A delta that isn't smaller than the archive is
+	 * dropped. The file hashes of the new upload are then kept in turn, in
+	 * the add-on entry:
+	 *
+	 * @verbatim
+	 *     [campaign]
+	 *         # ...
+	 *         [file_hashes]
+	 *             uploads=7
+	 *             filename="data/My_Addon.hashes.7"
+	 *         [/file_hashes]
+	 *         [delta]
+	 *             from_uploads=7
+	 *             filename="data/My_Addon.delta.7.8"
+	 *             size=1234
+	 *         [/delta]
+	 *     [/campaign]
+	 * @endverbatim
+	 */
+	static void write_deltas(upload_job& job);
+
+	/**
+	 * Starts storing the first of @a uploads_, or completes it when its
+	 * thread is through. Called on every iteration of the main loop.
+	 */
+	void process_uploads();
+
+	/**
+	 * Renames the archive of @a job over the previous one and updates the
+	 * add-on entry, or reports the failure to the uploader.
+	 */
+	void finish_upload(upload_job& job);
+
+	/**
+	 * Records that the add-on @a name is no longer on the server, for the
+	 * requests of the changes to the list since an earlier time:
+	 *
+	 * @verbatim
+	 *     [campaigns]
+	 *         [campaign]
+	 *             # ...
+	 *         [/campaign]
+	 *         [deleted]
+	 *             name="My_Addon"
+	 *             timestamp=1234567890
+	 *         [/deleted]
+	 *     [/campaigns]
+	 * @endverbatim
+	 */
+	void record_deletion(const std::string& name);
+
+	/** Removes the private information of an add-on entry before it is sent. */
+	void make_public_entry(config& campaign) const;
+
+	/** Removes the files of write_deltas() listed in @a campaign. */
+	void delete_deltas(const config& campaign);
+
 	/**
 	 * Fires a hook script.
 	 */
@@ -162,6 +303,7 @@ private:
 	void register_handler(const std::string& cmd, const request_handler& func);
 
 	void handle_request_campaign_list(const request&);
+	void handle_request_campaign_search(const request&);
 	void handle_request_campaign(const request&);
 	void handle_request_terms(const request&);
 	void handle_upload(const request&);
@@ -223,7 +223,7 @@ void carryover_info::transfer_to(config& level){
 
 }
 
-const config carryover_info::to_config()
+config carryover_info::to_config()
 {
 	config cfg;
 	cfg["next_underlying_unit_id"] = next_underlying_unit_id_;
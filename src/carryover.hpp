@@ -81,7 +81,7 @@ public:
 
 	const std::string& next_scenario() const { return next_scenario_; }
 
-	const config to_config();
+	config to_config();
 
 	void merge_old_carryover(const carryover_info& old_carryover);
 private:
@@ -66,6 +66,7 @@ bad_commandline_tuple::bad_commandline_tuple(const std::string& str,
 }
 
 commandline_options::commandline_options (const std::vector<std::string>& args) :
+	ai_profile(false),
 	bpp(),
 	bunzip2(),
 	bzip2(),
@@ -92,6 +93,9 @@ commandline_options::commandline_options (const std::vector<std::string>& args)
 	load(),
 	logdomains(),
 	log_precise_timestamps(false),
+	log_async(),
+	log_rotate(),
+	log_structured(false),
 	multiplayer(false),
 	multiplayer_ai_config(),
 	multiplayer_algorithm(),
@@ -102,6 +106,7 @@ commandline_options::commandline_options (const std::vector<std::string>& args)
 	multiplayer_label(),
 	multiplayer_parm(),
 	multiplayer_repeat(),
+	multiplayer_stats(),
 	multiplayer_scenario(),
 	multiplayer_side(),
 	multiplayer_turns(),
@@ -130,11 +135,15 @@ commandline_options::commandline_options (const std::vector<std::string>& args)
 	server(),
 	username(),
 	password(),
+	render_benchmark(),
+	render_image(),
+	render_image_dst(),
 	screenshot(false),
 	screenshot_map_file(),
 	screenshot_output_file(),
 	script_unsafe_mode(false),
 	strict_validation(false),
+	threads(),
 	test(),
 	unit_test(),
 	headless_unit_test(false),
@@ -145,6 +154,7 @@ commandline_options::commandline_options (const std::vector<std::string>& args)
 	userdata_path(false),
 	userdata_dir(),
 	validcache(false),
+	validate_replay(),
 	version(false),
 	windowed(false),
 	with_replay(false),
@@ -158,6 +168,7 @@ commandline_options::commandline_options (const std::vector<std::string>& args)
 	// Options are sorted alphabetically by --long-option.
 	po::options_description general_opts("General options");
 	general_opts.add_options()
+		("ai-profile", "records where the AI turns spend their time and writes ai_profile.cfg and ai_profile.json to the userdata directory when the game ends.")
 		("bunzip2", po::value<std::string>(), "decompresses a file (<arg>.bz2) in bzip2 format and stores it without the .bz2 suffix. <arg>.bz2 will be removed.")
 		("bzip2", po::value<std::string>(), "compresses a file (<arg>) in bzip2 format, stores it as <arg>.bz2 and removes <arg>.")
 		("clock", "Adds the option to show a clock for testing the drawing timer.")
@@ -185,6 +196,7 @@ commandline_options::commandline_options (const std::vector<std::string>& args)
 		("nosound", "runs the game without sounds and music.")
 		("path", "prints the path to the data directory and exits.")
 		("plugin", po::value<std::string>(), "(experimental) load a script which defines a wesnoth plugin. similar to --script below, but lua file should return a function which will be run as a coroutine and periodically woken up with updates.")
+		("render-benchmark", po::value<unsigned int>(), "draws <arg> frames of a fixed scroll and zoom sequence over the game started with --test or --load, prints the frame time percentiles and exits.")
 		("render-image", po::value<two_strings>()->multitoken(), "takes two arguments: <image> <output>. Like screenshot, but instead of a map, takes a valid wesnoth 'image path string' with image path functions, and outputs to a windows .bmp file")
 		("rng-seed", po::value<unsigned int>(), "seeds the random number generator with number <arg>. Example: --rng-seed 0")
 		("screenshot", po::value<two_strings>()->multitoken(), "takes two arguments: <map> <output>. Saves a screenshot of <map> to <output> without initializing a screen. Editor must be compiled in for this to work.")
@@ -194,6 +206,7 @@ commandline_options::commandline_options (const std::vector<std::string>& args)
 		("username", po::value<std::string>(), "uses <username> when connecting to a server, ignoring other preferences.")
 		("password", po::value<std::string>(), "uses <password> when connecting to a server, ignoring other preferences.")
 		("strict-validation", "makes validation errors fatal")
+		("threads", po::value<unsigned int>(), "sets the number of threads doing the parallel work, such as the pathfinding and the terrain building. 0, the default, uses one per processor; 1 does all the work in order on the main thread, for reproducible debugging.")
 		("userconfig-dir", po::value<std::string>(), "sets the path of the user config directory to $HOME/<arg> or My Documents\\My Games\\<arg> for Windows. You can specify also an absolute path outside the $HOME or My Documents\\My Games directory. Defaults to $HOME/.config/wesnoth on X11 and to the userdata-dir on other systems.")
 		("userconfig-path", "prints the path of the user config directory and exits.")
 		("userdata-dir", po::value<std::string>(), "sets the path of the userdata directory to $HOME/<arg> or My Documents\\My Games\\<arg> for Windows. You can specify also an absolute path outside the $HOME or My Documents\\My Games directory.")
@@ -229,6 +242,9 @@ commandline_options::commandline_options (const std::vector<std::string>& args)
 		("log-info", po::value<std::string>(), "sets the severity level of the specified log domain(s) to 'info'. Similar to --log-error.")
 		("log-debug", po::value<std::string>(), "sets the severity level of the specified log domain(s) to 'debug'. Similar to --log-error.")
 		("log-precise", "shows the timestamps in the logfile with more precision")
+		("log-async", po::value<std::string>()->implicit_value(std::string()), "writes the log from a background thread, so that logging never waits on the disk. The log goes to the file <arg> if given, to the standard error otherwise.")
+		("log-rotate", po::value<unsigned int>(), "with --log-async=<file>, starts a new log file when it gets bigger than <arg> MiB, the previous one being kept as <file>.1.")
+		("log-structured", "writes the log lines as key=value fields: time, severity, domain and message.")
 		;
 
 	po::options_description multiplayer_opts("Multiplayer options");
@@ -241,7 +257,8 @@ commandline_options::commandline_options (const std::vector<std::string>& args)
 		("exit-at-end", "exit Wesnoth at the end of the scenario.")
 		("ignore-map-settings", "do not use map settings.")
 		("label", po::value<std::string>(), "sets the label for AIs.") //TODO is the description precise? this option was undocumented before.
-		("multiplayer-repeat",  po::value<unsigned int>(), "repeats a multiplayer game after it is finished <arg> times.")
+		("multiplayer-repeat",  po::value<unsigned int>(), "repeats a multiplayer game after it is finished <arg> times. Each game gets its own random seed, drawn from --rng-seed if given.")
+		("multiplayer-stats", po::value<std::string>(), "writes the seed, outcome and statistics of each game to the file <arg>.")
 		("nogui", "runs the game without the GUI.")
 		("parm", po::value<std::vector<std::string> >()->composing(), "sets additional parameters for this side. <arg> should have format side:name:value.")
 		("scenario", po::value<std::string>(), "selects a multiplayer scenario. The default scenario is \"multiplayer_The_Freelands\".")
@@ -257,6 +274,7 @@ commandline_options::commandline_options (const std::vector<std::string>& args)
 		("timeout", po::value<unsigned int>(), "sets a timeout (milliseconds) for the unit test. (DEPRECATED)")
 		("log-strict", po::value<std::string>(), "sets the strict level of the logger. any messages sent to log domains of this level or more severe will cause the unit test to fail regardless of the victory result.")
 		("noreplaycheck", "don't try to validate replay of unit test")
+		("validate-replay", po::value<std::vector<std::string> >()->composing(), "replays the save <arg> to its end headlessly and as fast as possible, reporting the time taken and the out of sync errors. Can be given several times. The exit code is the worst one of the replays:\n\t0 - PASS\n\t1 - FAIL (OUT OF SYNC)\n\t3 - FAIL (INVALID REPLAY)\n\t4 - FAIL (ERRORED REPLAY)")
 		("mp-test", "load the test mp scenarios")
 		;
 
@@ -291,6 +309,8 @@ commandline_options::commandline_options (const std::vector<std::string>& args)
 	const int parsing_style = po::command_line_style::default_style ^ po::command_line_style::allow_guessing;
 	po::store(po::command_line_parser(args_).options(all_).positional(positional).style(parsing_style).run(),vm);
 
+	if (vm.count("ai-profile"))
+		ai_profile = true;
 	if (vm.count("ai-config"))
 		multiplayer_ai_config = parse_to_uint_string_tuples_(vm["ai-config"].as<std::vector<std::string> >());
 	if (vm.count("algorithm"))
@@ -369,6 +389,12 @@ commandline_options::commandline_options (const std::vector<std::string>& args)
 		logdomains = vm["logdomains"].as<std::string>();
 	if (vm.count("log-precise"))
 		log_precise_timestamps = true;
+	if (vm.count("log-async"))
+		log_async = vm["log-async"].as<std::string>();
+	if (vm.count("log-rotate"))
+		log_rotate = vm["log-rotate"].as<unsigned int>();
+	if (vm.count("log-structured"))
+		log_structured = true;
 	if (vm.count("log-strict"))
 		parse_log_strictness(vm["log-strict"].as<std::string>());
 	if (vm.count("max-fps"))
@@ -379,6 +405,8 @@ commandline_options::commandline_options (const std::vector<std::string>& args)
 		multiplayer = true;
 	if (vm.count("multiplayer-repeat"))
 		multiplayer_repeat = vm["multiplayer-repeat"].as<unsigned int>();
+	if (vm.count("multiplayer-stats"))
+		multiplayer_stats = vm["multiplayer-stats"].as<std::string>();
 	if (vm.count("new-widgets"))
 		new_widgets = true;
 	if (vm.count("noaddons"))
@@ -427,6 +455,8 @@ commandline_options::commandline_options (const std::vector<std::string>& args)
 		rng_seed = vm["rng-seed"].as<unsigned int>();
 	if (vm.count("scenario"))
 		multiplayer_scenario = vm["scenario"].as<std::string>();
+	if (vm.count("render-benchmark"))
+		render_benchmark = vm["render-benchmark"].as<unsigned int>();
 	if (vm.count("render-image"))
 	{
 		render_image = vm["render-image"].as<two_strings>().get<0>();
@@ -469,6 +499,8 @@ commandline_options::commandline_options (const std::vector<std::string>& args)
 		multiplayer_turns = vm["turns"].as<std::string>();
 	if (vm.count("strict-validation"))
 		strict_validation = true;
+	if (vm.count("threads"))
+		threads = vm["threads"].as<unsigned int>();
 	if (vm.count("userconfig-dir"))
 		userconfig_dir = vm["userconfig-dir"].as<std::string>();
 	if (vm.count("userconfig-path"))
@@ -479,6 +511,8 @@ commandline_options::commandline_options (const std::vector<std::string>& args)
 		userdata_path = true;
 	if (vm.count("validcache"))
 		validcache = true;
+	if (vm.count("validate-replay"))
+		validate_replay = vm["validate-replay"].as<std::vector<std::string> >();
 	if (vm.count("version"))
 		version = true;
 	if (vm.count("windowed"))
@@ -47,6 +47,8 @@ public:
 
 	config to_config() const; /* Used by lua scrips. Not all of the options need to be exposed here, just those exposed to lua */
 
+	/// True if --ai-profile was given on the command line. Profiles the AI turns.
+	bool ai_profile;
 	/// BitsPerPixel specified by --bpp option.
 	boost::optional<int> bpp;
 	/// Non-empty if --bunzip2 was given on the command line. Uncompresses a .bz2 file and exits.
@@ -102,6 +104,12 @@ public:
 	boost::optional<std::string> logdomains;
 	/// True if --log-precise was given on the command line. Shows timestamps in log with more precision.
 	bool log_precise_timestamps;
+	/// Non-empty if --log-async was given on the command line. The file to write the log to from a background thread, the standard error if empty.
+	boost::optional<std::string> log_async;
+	/// Non-empty if --log-rotate was given on the command line. The size in MiB past which a new log file is started.
+	boost::optional<unsigned int> log_rotate;
+	/// True if --log-structured was given on the command line. Writes the log lines as key=value fields.
+	bool log_structured;
 	/// True if --multiplayer was given on the command line. Goes directly into multiplayer mode.
 	bool multiplayer;
 	/// Non-empty if --ai-config was given on the command line. Vector of pairs (side number, value). Dependent on --multiplayer.
@@ -122,6 +130,8 @@ public:
 	boost::optional<std::vector<boost::tuple<unsigned int, std::string, std::string> > > multiplayer_parm;
 	/// Repeats specified by --multiplayer-repeat option. Repeats a multiplayer game after it is finished. Dependent on --multiplayer.
 	boost::optional<unsigned int> multiplayer_repeat;
+	/// Non-empty if --multiplayer-stats was given on the command line. File to write the outcome and statistics of each game to. Dependent on --multiplayer.
+	boost::optional<std::string> multiplayer_stats;
 	/// Non-empty if --scenario was given on the command line. Dependent on --multiplayer.
 	boost::optional<std::string> multiplayer_scenario;
 	/// Non-empty if --side was given on the command line. Vector of pairs (side number, faction id). Dependent on --multiplayer.
@@ -178,6 +188,8 @@ public:
 	boost::optional<std::string> username;
 	/// Non-empty if --password was given on the command line. Forces Wesnoth to use this network password.
 	boost::optional<std::string> password;
+	/// Number of frames specified by --render-benchmark. Benchmarks the rendering of the game started.
+	boost::optional<unsigned int> render_benchmark;
 	/// Image path to render. First parameter after --render-image
 	boost::optional<std::string> render_image;
 	/// Output file to put rendered image path in. Optional second parameter after --render-image
@@ -196,6 +208,8 @@ public:
 	bool script_unsafe_mode;
 	/// True if --strict-validation was given on the command line. Makes Wesnoth trust validation errors as fatal WML errors and create WML exception, if so.
 	bool strict_validation;
+	/// Non-empty if --threads was given on the command line. The number of threads for the parallel work, 0 meaning one per processor.
+	boost::optional<unsigned int> threads;
 	/// Non-empty if --test was given on the command line. Goes directly into test mode, into a scenario, if specified.
 	boost::optional<std::string> test;
 	/// Non-empty if --unit was given on the command line. Goes directly into unit test mode, into a scenario, if specified.
@@ -218,6 +232,8 @@ public:
 	boost::optional<std::string> userdata_dir;
 	/// True if --validcache was given on the command line. Makes Wesnoth assume the cache is valid.
 	bool validcache;
+	/// Non-empty if --validate-replay was given on the command line. Replays these saves headlessly, checking them for out of sync errors.
+	boost::optional<std::vector<std::string> > validate_replay;
 	/// True if --version was given on the command line. Prints version and exits.
 	bool version;
 	/// True if --windowed was given on the command line. Starts Wesnoth in windowed mode.
@@ -600,6 +600,11 @@ unsigned config::all_children_count() const
 	return ordered_children.size();
 }
 
+unsigned config::attribute_count() const
+{
+	return values.size();
+}
+
 bool config::has_child(const std::string &key) const
 {
 	check_valid();
@@ -729,6 +734,17 @@ config &config::add_child_at(const std::string &key, const config &val, unsigned
 	return *v[index];
 }
 
+#ifdef HAVE_CXX11
+config &config::add_child_at(const std::string &key, config &&val, unsigned index)
+{
+	check_valid(val);
+
+	config &res = add_child_at(key, config(), index);
+	res.swap(val);
+	return res;
+}
+#endif
+
 namespace {
 
 struct remove_ordered
@@ -836,6 +852,37 @@ void config::remove_child(const std::string &key, unsigned index)
 	remove_child(i, index);
 }
 
+void config::remove_children(const std::string &key, unsigned begin, unsigned end)
+{
+	check_valid();
+
+	child_map::iterator i = children.find(key);
+	if (i == children.end() || end > i->second.size() || begin > end) {
+		ERR_CF << "Error: attempting to delete non-existing children: "
+			<< key << "[" << begin << ", " << end << ")\n";
+		return;
+	}
+	if (begin == end) return;
+
+	// Drop the positions removed and shift those following them.
+	const unsigned count = end - begin;
+	std::vector<child_pos>::iterator kept = ordered_children.begin();
+	BOOST_FOREACH(child_pos &p, ordered_children)
+	{
+		if (p.pos == i) {
+			if (p.index >= begin && p.index < end) continue;
+			if (p.index >= end) p.index -= count;
+		}
+		*kept++ = p;
+	}
+	ordered_children.erase(kept, ordered_children.end());
+
+	for (unsigned j = begin; j != end; ++j) {
+		delete i->second[j];
+	}
+	i->second.erase(i->second.begin() + begin, i->second.begin() + end);
+}
+
 const config::attribute_value &config::operator[](const std::string &key) const
 {
 	check_valid();
@@ -1429,6 +1476,42 @@ std::string config::hash() const
 	return std::string(hash_str);
 }
 
+namespace {
+
+/** The memory of a node of a std::map, beside the pair it holds. */
+const size_t map_node_overhead = 4 * sizeof(void*);
+
+/** The characters held by an attribute value. */
+class value_memory_visitor : public boost::static_visitor<size_t>
+{
+public:
+	template<typename T>
+	size_t operator()(const T&) const { return 0; }
+	size_t operator()(const std::string& s) const { return s.size(); }
+	size_t operator()(const t_string& s) const { return s.value().size(); }
+};
+
+} // end anonymous namespace
+
+size_t config::memory_usage() const
+{
+	check_valid();
+
+	size_t res = sizeof(config) + ordered_children.capacity() * sizeof(child_pos);
+	BOOST_FOREACH(const attribute &val, values) {
+		res += map_node_overhead + sizeof(attribute) + val.first.size()
+			+ val.second.apply_visitor(value_memory_visitor());
+	}
+	BOOST_FOREACH(const child_map::value_type &list, children) {
+		res += map_node_overhead + sizeof(child_map::value_type) + list.first.size()
+			+ list.second.capacity() * sizeof(config*);
+		BOOST_FOREACH(const config *child, list.second) {
+			res += child->memory_usage();
+		}
+	}
+	return res;
+}
+
 void config::swap(config& cfg)
 {
 	check_valid(cfg);
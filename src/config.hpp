@@ -119,7 +119,7 @@ public:
 	struct child_iterator
 	{
 		typedef config value_type;
-		typedef std::forward_iterator_tag iterator_category;
+		typedef std::random_access_iterator_tag iterator_category;
 		typedef int difference_type;
 		typedef config *pointer;
 		typedef config &reference;
@@ -131,11 +131,23 @@ public:
 		child_iterator &operator--() { --i_; return *this; }
 		child_iterator operator--(int) { return child_iterator(i_--); }
 
+		// The children are stored in a vector, so std::advance() need not walk.
+		child_iterator &operator+=(difference_type n) { i_ += n; return *this; }
+		child_iterator &operator-=(difference_type n) { i_ -= n; return *this; }
+		child_iterator operator+(difference_type n) const { return child_iterator(i_ + n); }
+		child_iterator operator-(difference_type n) const { return child_iterator(i_ - n); }
+		difference_type operator-(const child_iterator &i) const { return i_ - i.i_; }
+
 		config &operator*() const { return **i_; }
 		config *operator->() const { return &**i_; }
+		config &operator[](difference_type n) const { return *i_[n]; }
 
 		bool operator==(const child_iterator &i) const { return i_ == i.i_; }
 		bool operator!=(const child_iterator &i) const { return i_ != i.i_; }
+		bool operator<(const child_iterator &i) const { return i_ < i.i_; }
+		bool operator>(const child_iterator &i) const { return i_ > i.i_; }
+		bool operator<=(const child_iterator &i) const { return i_ <= i.i_; }
+		bool operator>=(const child_iterator &i) const { return i_ >= i.i_; }
 
 	private:
 		Itor i_;
@@ -145,7 +157,7 @@ public:
 	struct const_child_iterator
 	{
 		typedef config value_type;
-		typedef std::forward_iterator_tag iterator_category;
+		typedef std::random_access_iterator_tag iterator_category;
 		typedef int difference_type;
 		typedef const config *pointer;
 		typedef const config &reference;
@@ -158,11 +170,22 @@ public:
 		const_child_iterator &operator--() { --i_; return *this; }
 		const_child_iterator operator--(int) { return const_child_iterator(i_--); }
 
+		const_child_iterator &operator+=(difference_type n) { i_ += n; return *this; }
+		const_child_iterator &operator-=(difference_type n) { i_ -= n; return *this; }
+		const_child_iterator operator+(difference_type n) const { return const_child_iterator(i_ + n); }
+		const_child_iterator operator-(difference_type n) const { return const_child_iterator(i_ - n); }
+		difference_type operator-(const const_child_iterator &i) const { return i_ - i.i_; }
+
 		const config &operator*() const { return **i_; }
 		const config *operator->() const { return &**i_; }
+		const config &operator[](difference_type n) const { return *i_[n]; }
 
 		bool operator==(const const_child_iterator &i) const { return i_ == i.i_; }
 		bool operator!=(const const_child_iterator &i) const { return i_ != i.i_; }
+		bool operator<(const const_child_iterator &i) const { return i_ < i.i_; }
+		bool operator>(const const_child_iterator &i) const { return i_ > i.i_; }
+		bool operator<=(const const_child_iterator &i) const { return i_ <= i.i_; }
+		bool operator>=(const const_child_iterator &i) const { return i_ >= i.i_; }
 
 	private:
 		Itor i_;
@@ -358,6 +381,8 @@ public:
 	const_child_itors child_range(const std::string& key) const;
 	unsigned child_count(const std::string &key) const;
 	unsigned all_children_count() const;
+	/** The number of attributes, blank ones included, as in attribute_range(). */
+	unsigned attribute_count() const;
 
 	/**
 	 * Determine whether a config has a child or not.
@@ -430,6 +455,7 @@ public:
 
 #ifdef HAVE_CXX11
 	config &add_child(const std::string &key, config &&val);
+	config &add_child_at(const std::string &key, config &&val, unsigned index);
 #endif
 
 	/**
@@ -494,6 +520,11 @@ public:
 	void splice_children(config &src, const std::string &key);
 
 	void remove_child(const std::string &key, unsigned index);
+	/**
+	 * Removes the children with tag @a key from @a begin to @a end (excluded),
+	 * with a single pass over the ordering whatever their number.
+	 */
+	void remove_children(const std::string &key, unsigned begin, unsigned end);
 	void recursive_clear_value(const std::string& key);
 
 	void clear();
@@ -502,6 +533,13 @@ public:
 	std::string debug() const;
 	std::string hash() const;
 
+	/**
+	 * An estimate of the memory used by this config and its children: their
+	 * nodes, maps and vectors, and the characters of their strings. The
+	 * shared text of the translatable strings is counted at each use.
+	 */
+	size_t memory_usage() const;
+
 	struct error : public game::error, public boost::exception {
 		error(const std::string& message) : game::error(message) {}
 	};
@@ -22,20 +22,33 @@
 #include "log.hpp"
 #include "marked-up_text.hpp"
 #include "show_dialog.hpp"
+#include "thread.hpp"
 #include "utils/sha1.hpp"
 #include "serialization/binary_or_text.hpp"
+#include "serialization/binary_wml.hpp"
 #include "serialization/parser.hpp"
 #include "version.hpp"
 
 #include <boost/foreach.hpp>
 #include <boost/algorithm/string/replace.hpp>
-#include <boost/iostreams/filter/gzip.hpp>
+
+#include <algorithm>
+#include <sstream>
 
 static lg::log_domain log_cache("cache");
 #define ERR_CACHE LOG_STREAM(err, log_cache)
 #define LOG_CACHE LOG_STREAM(info, log_cache)
 #define DBG_CACHE LOG_STREAM(debug, log_cache)
 
+namespace {
+
+const std::string extension = ".gz";
+// The game config itself is stored in the binary format, which is
+// much faster to read back than WML text.
+const std::string binary_extension = ".bin";
+
+}
+
 namespace game_config {
 
 	config_cache& config_cache::instance()
@@ -49,7 +62,8 @@ namespace game_config {
 		use_cache_(true),
 		fake_invalid_cache_(false),
 		defines_map_(),
-		cache_file_prefix_()
+		cache_file_prefix_(),
+		preprocessed_()
 	{
 		cache_file_prefix_
 				= "cache-v" +
@@ -122,6 +136,12 @@ namespace game_config {
 		}
 	}
 
+	void config_cache::write_binary_file(std::string path, const config& cfg)
+	{
+		filesystem::scoped_ostream stream = filesystem::ostream_file(path);
+		write_binary(*stream, cfg);
+	}
+
 	void config_cache::read_file(const std::string& path, config& cfg)
 	{
 		filesystem::scoped_istream stream = filesystem::istream_file(path);
@@ -151,17 +171,54 @@ namespace game_config {
 	}
 
 
-	void config_cache::read_configs(const std::string& path, config& cfg, preproc_map& defines_map)
+	void config_cache::read_configs(const std::string& path, config& cfg, preproc_map& defines_map,
+			std::set<std::string>* included)
 	{
+		preprocessed_map::iterator pre = preprocessed_.find(path);
+		if(pre != preprocessed_.end()) {
+			DBG_CACHE << "using the text preprocessed in advance for " << path << "\n";
+			std::istringstream stream(pre->second.text);
+			defines_map.swap(pre->second.defines);
+			if(included) {
+				included->swap(pre->second.included);
+			}
+			preprocessed_.erase(pre);
+			read(cfg, stream);
+			return;
+		}
+
 		//read the file and then write to the cache
-		filesystem::scoped_istream stream = preprocess_file(path, &defines_map);
+		filesystem::scoped_istream stream = preprocess_file(path, &defines_map, included);
 		read(cfg, *stream);
 	}
 
-	void config_cache::read_cache(const std::string& path, config& cfg)
+	std::string config_cache::segment_of(const std::string& file)
+	{
+		std::string name = file;
+		std::replace(name.begin(), name.end(), '\\', '/');
+
+		std::string user_data = filesystem::get_user_data_dir() + "/data/";
+		std::replace(user_data.begin(), user_data.end(), '\\', '/');
+		if(name.compare(0, user_data.size(), user_data) != 0) {
+			return "data/";
+		}
+
+		// Each directory of add-ons/ is a segment of its own; the other
+		// files of the user data share one.
+		const std::string addons = user_data + "add-ons/";
+		if(name.compare(0, addons.size(), addons) == 0) {
+			const size_t end = name.find('/', addons.size());
+			if(end != std::string::npos) {
+				return name.substr(0, end);
+			} else if(filesystem::is_directory(name)) {
+				return name;
+			}
+		}
+		return user_data;
+	}
+
+	std::string config_cache::cache_file_name(const std::string& path, std::string& defines) const
 	{
-		const std::string extension = ".gz";
-		bool is_valid = true;
 		std::stringstream defines_string;
 		defines_string << path;
 		for(preproc_map::const_iterator i = defines_map_.begin(); i != defines_map_.end(); ++i) {
@@ -169,88 +226,133 @@ namespace game_config {
 				// VERSION is defined non-empty by the engine,
 				// it should be safe to rely on caches containing it.
 				if(i->first != "WESNOTH_VERSION") {
-					is_valid = false;
 					ERR_CACHE << "Preprocessor define not valid" << std::endl;
-					break;
+					return std::string();
 				}
 			}
 
 			defines_string << " " << i->first;
 		}
+		defines = defines_string.str();
 
-		// Do cache check only if  define map is valid and
-		// caching is allowed
-		if(is_valid) {
-			const std::string& cache = filesystem::get_cache_dir();
-			if(cache != "") {
-				sha1_hash sha(defines_string.str()); // use a hash for a shorter display of the defines
-				const std::string fname = cache + "/" +
-										  cache_file_prefix_ + sha.display();
-				const std::string fname_checksum = fname + ".checksum" + extension;
-
-				filesystem::file_tree_checksum dir_checksum;
-
-				if(!force_valid_cache_ && !fake_invalid_cache_) {
-					try {
-						if(filesystem::file_exists(fname_checksum)) {
-							DBG_CACHE << "Reading checksum: " << fname_checksum << "\n";
-							config checksum_cfg;
-							read_file(fname_checksum, checksum_cfg);
-							dir_checksum = filesystem::file_tree_checksum(checksum_cfg);
-						}
-					} catch(config::error&) {
-						ERR_CACHE << "cache checksum is corrupt" << std::endl;
-					} catch(filesystem::io_exception&) {
-						ERR_CACHE << "error reading cache checksum" << std::endl;
-					}
-				}
+		const std::string& cache = filesystem::get_cache_dir();
+		if(cache.empty()) {
+			return std::string();
+		}
+		sha1_hash sha(defines); // use a hash for a shorter display of the defines
+		return cache + "/" + cache_file_prefix_ + sha.display();
+	}
 
-				if(force_valid_cache_) {
-					LOG_CACHE << "skipping cache validation (forced)\n";
+	bool config_cache::is_cache_up_to_date(const std::string& fname, segment_set& segments)
+	{
+		const std::string fname_checksum = fname + ".checksum" + extension;
+
+		config checksum_cfg;
+
+		if(!fake_invalid_cache_) {
+			try {
+				if(filesystem::file_exists(fname_checksum)) {
+					DBG_CACHE << "Reading checksum: " << fname_checksum << "\n";
+					read_file(fname_checksum, checksum_cfg);
 				}
+			} catch(config::error&) {
+				ERR_CACHE << "cache checksum is corrupt" << std::endl;
+				checksum_cfg.clear();
+			} catch(filesystem::io_exception&) {
+				ERR_CACHE << "error reading cache checksum" << std::endl;
+				checksum_cfg.clear();
+			}
+		}
+
+		if(force_valid_cache_) {
+			LOG_CACHE << "skipping cache validation (forced)\n";
+		}
+
+		// The checksums of caches written before the segments only cover
+		// the whole data tree, and are never up to date.
+		bool valid = checksum_cfg.has_child("segment");
+		BOOST_FOREACH(const config& segment, checksum_cfg.child_range("segment")) {
+			const std::string& dir = segment["path"];
+			segments.insert(dir);
+			if(valid && !force_valid_cache_
+					&& filesystem::file_tree_checksum(segment) != filesystem::dir_tree_checksum(dir)) {
+				DBG_CACHE << "segment " << dir << " has changed\n";
+				valid = false;
+			}
+		}
+
+		return filesystem::file_exists(fname + binary_extension) && (force_valid_cache_ || valid);
+	}
 
-				if(filesystem::file_exists(fname + extension) && (force_valid_cache_ || (dir_checksum == filesystem::data_tree_checksum()))) {
-					LOG_CACHE << "found valid cache at '" << fname << extension << "' with defines_map " << defines_string.str() << "\n";
-					log_scope("read cache");
-					try {
-						read_file(fname + extension,cfg);
-						const std::string define_file = fname + ".define" + extension;
-						if (filesystem::file_exists(define_file))
-						{
-							config_cache_transaction::instance().add_define_file(define_file);
-						}
-						return;
-					} catch(config::error& e) {
-						ERR_CACHE << "cache " << fname << extension << " is corrupt. Loading from files: "<< e.message<< std::endl;
-					} catch(filesystem::io_exception&) {
-						ERR_CACHE << "error reading cache " << fname << extension << ". Loading from files" << std::endl;
-					} catch (boost::iostreams::gzip_error& e) {
-						//read_file -> ... -> read_gz can throw this exception.
-						ERR_CACHE << "cache " << fname << extension << " is corrupt. Error code: " << e.error() << std::endl;
+	void config_cache::read_cache(const std::string& path, config& cfg)
+	{
+		std::string defines_string;
+		const std::string fname = cache_file_name(path, defines_string);
+
+		// Do cache check only if  define map is valid and
+		// caching is allowed
+		if(!fname.empty()) {
+			const std::string fname_checksum = fname + ".checksum" + extension;
+			const bool locked = config_cache_transaction::get_state() == config_cache_transaction::LOCKED;
+
+			segment_set segments;
+			if(is_cache_up_to_date(fname, segments)) {
+				LOG_CACHE << "found valid cache at '" << fname << binary_extension << "' with defines_map " << defines_string << "\n";
+				log_scope("read cache");
+				try {
+					read_binary_file(cfg, fname + binary_extension);
+					const std::string define_file = fname + ".define" + extension;
+					if (filesystem::file_exists(define_file))
+					{
+						config_cache_transaction::instance().add_define_file(define_file);
+					}
+					if(!locked) {
+						config_cache_transaction::instance().add_base_segments(segments);
 					}
+					return;
+				} catch(config::error& e) {
+					ERR_CACHE << "cache " << fname << binary_extension << " is corrupt. Loading from files: "<< e.message<< std::endl;
+				} catch(filesystem::io_exception& e) {
+					ERR_CACHE << "error reading cache " << fname << binary_extension << ". Loading from files: " << e.message << std::endl;
 				}
+			}
 
-				LOG_CACHE << "no valid cache found. Writing cache to '" << fname << extension << " with defines_map "<< defines_string.str() << "'\n";
-				// Now we need queued defines so read them to memory
-				read_defines_queue();
+			LOG_CACHE << "no valid cache found. Writing cache to '" << fname << binary_extension << " with defines_map "<< defines_string << "'\n";
+			// Now we need queued defines so read them to memory
+			read_defines_queue();
 
-				preproc_map copy_map(make_copy_map());
+			preproc_map copy_map(make_copy_map());
 
-				read_configs(path, cfg, copy_map);
+			std::set<std::string> included;
+			read_configs(path, cfg, copy_map, &included);
 
-				add_defines_map_diff(copy_map);
+			add_defines_map_diff(copy_map);
 
-				try {
-					write_file(fname + extension, cfg);
-					write_file(fname + ".define" + extension, copy_map);
-					config checksum_cfg;
-					filesystem::data_tree_checksum().write(checksum_cfg);
-					write_file(fname_checksum, checksum_cfg);
-				} catch(filesystem::io_exception&) {
-					ERR_CACHE << "could not write to cache '" << fname << "'" << std::endl;
+			segments.clear();
+			BOOST_FOREACH(const std::string& file, included) {
+				segments.insert(segment_of(file));
+			}
+			if(locked) {
+				const segment_set& base = config_cache_transaction::instance().get_base_segments();
+				segments.insert(base.begin(), base.end());
+			} else {
+				config_cache_transaction::instance().add_base_segments(segments);
+			}
+
+			try {
+				write_binary_file(fname + binary_extension, cfg);
+				write_file(fname + ".define" + extension, copy_map);
+				config checksum_cfg;
+				BOOST_FOREACH(const std::string& dir, segments) {
+					config& segment = checksum_cfg.add_child("segment");
+					segment["path"] = dir;
+					filesystem::dir_tree_checksum(dir).write(segment);
 				}
-				return;
+				write_file(fname_checksum, checksum_cfg);
+			} catch(filesystem::io_exception&) {
+				ERR_CACHE << "could not write to cache '" << fname << "'" << std::endl;
 			}
+			return;
 		}
 		LOG_CACHE << "Loading plain config instead of cache\n";
 		preproc_map copy_map(make_copy_map());
@@ -258,6 +360,96 @@ namespace game_config {
 		add_defines_map_diff(copy_map);
 	}
 
+	namespace {
+
+	/** Preprocesses independent files, each with its own copy of the defines. */
+	struct preprocess_job : public threading::parallel_job
+	{
+		struct result
+		{
+			result() : done(false), text(), defines(), included() {}
+			bool done;
+			std::string text;
+			preproc_map defines;
+			std::set<std::string> included;
+		};
+
+		preprocess_job(const std::vector<std::string>& paths, const preproc_map& defines)
+			: paths(paths)
+			, defines(defines)
+			, results(paths.size())
+		{
+		}
+
+		void run(size_t index)
+		{
+			result& res = results[index];
+			res.defines = defines;
+			try {
+				filesystem::scoped_istream stream = preprocess_file(paths[index], &res.defines, &res.included);
+				std::ostringstream text;
+				// Makes the preprocessor errors throw instead of only
+				// setting the failbit, as in preprocess_resource().
+				text.exceptions(std::ios_base::failbit);
+				text << stream->rdbuf();
+				res.text = text.str();
+				res.done = true;
+			} catch(...) {
+				// The file is preprocessed again when it is loaded, which
+				// reports the error in the usual way.
+				DBG_CACHE << "could not preprocess " << paths[index] << " in advance\n";
+				res.done = false;
+			}
+		}
+
+		const std::vector<std::string>& paths;
+		const preproc_map& defines;
+		std::vector<result> results;
+	};
+
+	}
+
+	void config_cache::preprocess_in_parallel(const std::vector<std::string>& paths)
+	{
+		preprocessed_.clear();
+
+		if (config_cache_transaction::get_state() != config_cache_transaction::LOCKED) {
+			return;
+		}
+
+		std::vector<std::string> todo;
+		BOOST_FOREACH(const std::string& path, paths) {
+			std::string defines_string;
+			segment_set segments;
+			const std::string fname = use_cache_ ? cache_file_name(path, defines_string) : std::string();
+			if (fname.empty() || !is_cache_up_to_date(fname, segments)) {
+				todo.push_back(path);
+			}
+		}
+		if (todo.size() < 2) {
+			return;
+		}
+
+		LOG_CACHE << "preprocessing " << todo.size() << " files in parallel\n";
+		log_scope("preprocess in parallel");
+
+		// The same defines get_config() would use for files from a locked
+		// transaction.
+		read_defines_queue();
+		preprocess_job job(todo, make_copy_map());
+		threading::run_parallel(job, todo.size());
+
+		for(size_t i = 0; i != todo.size(); ++i) {
+			preprocess_job::result& res = job.results[i];
+			if (res.done) {
+				preprocessed_file& file = preprocessed_[todo[i]];
+				file.text.swap(res.text);
+				file.defines.swap(res.defines);
+				file.included.swap(res.included);
+			}
+		}
+	}
+
 
 	void config_cache::read_defines_file(const std::string& path)
 	{
@@ -313,6 +505,7 @@ namespace game_config {
 
 	void config_cache::recheck_filetree_checksum()
 	{
+		preprocessed_.clear();
 		filesystem::data_tree_checksum(true);
 	}
 
@@ -412,6 +605,7 @@ namespace game_config {
 	config_cache_transaction::config_cache_transaction()
 		: define_filenames_()
 		, active_map_()
+		, base_segments_()
 	{
 		assert(state_ == FREE);
 		state_ = NEW;
@@ -429,6 +623,16 @@ namespace game_config {
 		state_ = LOCKED;
 	}
 
+	const std::set<std::string>& config_cache_transaction::get_base_segments() const
+	{
+		return base_segments_;
+	}
+
+	void config_cache_transaction::add_base_segments(const std::set<std::string>& segments)
+	{
+		base_segments_.insert(segments.begin(), segments.end());
+	}
+
 	const config_cache_transaction::filenames& config_cache_transaction::get_define_files() const
 	{
 		return define_filenames_;
@@ -21,6 +21,9 @@
 #define CONFIG_CACHE_HPP_INCLUDED
 
 #include <list>
+#include <map>
+#include <set>
+#include <vector>
 #include <boost/utility.hpp>
 #include <boost/scoped_ptr.hpp>
 #include <boost/shared_ptr.hpp>
@@ -71,9 +74,13 @@ namespace game_config {
 	/**
 	 * Singleton class to manage game config file caching.
 	 * It uses paths to config files as key to find correct cache
-	 * @todo Make smarter filetree checksum caching so only required parts
-	 *       of tree are checked at startup. Trees are overlapping so have
-	 *       to split trees to subtrees to only do check once per file.
+	 *
+	 * A cache only depends on the segments of the data tree its files come
+	 * from: the game data, the user data, or a single add-on. Each segment
+	 * has its own checksum, so a changed add-on only invalidates the caches
+	 * that include it. The caches loaded while a transaction is locked also
+	 * depend on the segments of the ones loaded before, whose macros they
+	 * use.
 	 * @todo Make cache system easily allow validation of in memory cache objects
 	 *       using hash checksum of preproc_map.
 	 **/
@@ -85,13 +92,46 @@ namespace game_config {
 
 		std::string cache_file_prefix_;
 
+		/** The names of the directories checksummed for a cache. */
+		typedef std::set<std::string> segment_set;
+
+		/**
+		 * A file preprocessed by preprocess_in_parallel(), the defines it
+		 * ended with, and the files it included.
+		 */
+		struct preprocessed_file
+		{
+			preprocessed_file() : text(), defines(), included() {}
+			std::string text;
+			preproc_map defines;
+			std::set<std::string> included;
+		};
+		typedef std::map<std::string, preprocessed_file> preprocessed_map;
+		/** The files preprocessed in advance, consumed by read_configs(). */
+		preprocessed_map preprocessed_;
+
 		void read_file(const std::string& file, config& cfg);
 		void write_file(std::string file, const config& cfg);
 		void write_file(std::string file, const preproc_map&);
+		/** Writes @a cfg in the binary format of read_binary_file(). */
+		void write_binary_file(std::string file, const config& cfg);
 
+		/**
+		 * The base name of the cache files for @a path, or an empty string
+		 * if it cannot be cached. @a defines receives the path and defines
+		 * the name is computed from.
+		 */
+		std::string cache_file_name(const std::string& path, std::string& defines) const;
+		/**
+		 * Whether the cache files named @a fname exist and the segments
+		 * they were built from are unchanged. @a segments receives these.
+		 */
+		bool is_cache_up_to_date(const std::string& fname, segment_set& segments);
 		void read_cache(const std::string& path, config& cfg);
 
-		void read_configs(const std::string& path, config& cfg, preproc_map& defines);
+		/** @a included, if not NULL, receives the files read. */
+		void read_configs(const std::string& path, config& cfg, preproc_map& defines,
+				std::set<std::string>* included = NULL);
 		void load_configs(const std::string& path, config& cfg);
 		void read_defines_queue();
 		void read_defines_file(const std::string& path);
@@ -108,6 +148,9 @@ namespace game_config {
 
 		void set_force_invalid_cache(bool);
 
+		/** The segment the file or directory @a file belongs to. */
+		static std::string segment_of(const std::string& file);
+
 
 		public:
 		/**
@@ -123,6 +166,19 @@ namespace game_config {
 		 */
 		void get_config(const std::string& path, config& cfg);
 
+		/**
+		 * Preprocesses the files at @a paths on several threads, for the
+		 * get_config() calls that follow to only have to parse them.
+		 *
+		 * This only happens while a transaction is locked: the files then
+		 * all see the same defines, and the ones they add are dropped, so
+		 * they do not depend on one another. Files with an up to date cache
+		 * are skipped, and so are files that cannot be preprocessed; the
+		 * later get_config() reports their errors. Parsing stays on the
+		 * calling thread, as translatable strings are not thread safe.
+		 */
+		void preprocess_in_parallel(const std::vector<std::string>& paths);
+
 		/**
 		 * Clear stored defines map to default values
 		 **/
@@ -196,6 +252,8 @@ namespace game_config {
 		static config_cache_transaction* active_;
 		filenames define_filenames_;
 		preproc_map active_map_;
+		/** The segments of the caches loaded before the lock. */
+		std::set<std::string> base_segments_;
 
 		static state get_state()
 		{return state_; }
@@ -207,6 +265,8 @@ namespace game_config {
 		friend class fake_transaction;
 		const filenames& get_define_files() const;
 		void add_define_file(const std::string&);
+		const std::set<std::string>& get_base_segments() const;
+		void add_base_segments(const std::set<std::string>&);
 		preproc_map& get_active_map(const preproc_map&);
 		void add_defines_map_diff(preproc_map& defines_map);
 	};
@@ -0,0 +1,58 @@
+/*
+   Copyright (C) 2015 by the Battle for Wesnoth Project
+   Part of the Battle for Wesnoth Project http://www.wesnoth.org/
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY.
+
+   See the COPYING file for more details.
+*/
+
+/**
+ * @file
+ * Keys and tags looked up often in configs, as ready-made strings.
+ */
+
+#include "config_keys.hpp"
+
+namespace config_keys {
+
+const std::string abilities = "abilities";
+const std::string active_on = "active_on";
+const std::string add = "add";
+const std::string adjacent = "adjacent";
+const std::string affect_adjacent = "affect_adjacent";
+const std::string affect_allies = "affect_allies";
+const std::string affect_enemies = "affect_enemies";
+const std::string affect_self = "affect_self";
+const std::string apply_to = "apply_to";
+const std::string backstab = "backstab";
+const std::string cumulative = "cumulative";
+const std::string description = "description";
+const std::string divide = "divide";
+const std::string equals = "equals";
+const std::string filter = "filter";
+const std::string filter_adjacent = "filter_adjacent";
+const std::string filter_adjacent_location = "filter_adjacent_location";
+const std::string filter_attacker = "filter_attacker";
+const std::string filter_base_value = "filter_base_value";
+const std::string filter_defender = "filter_defender";
+const std::string filter_opponent = "filter_opponent";
+const std::string filter_self = "filter_self";
+const std::string filter_weapon = "filter_weapon";
+const std::string greater_than = "greater_than";
+const std::string greater_than_equal_to = "greater_than_equal_to";
+const std::string id = "id";
+const std::string less_than = "less_than";
+const std::string less_than_equal_to = "less_than_equal_to";
+const std::string multiply = "multiply";
+const std::string name = "name";
+const std::string not_equals = "not_equals";
+const std::string sub = "sub";
+const std::string value = "value";
+
+}
@@ -0,0 +1,71 @@
+/*
+   Copyright (C) 2015 by the Battle for Wesnoth Project
+   Part of the Battle for Wesnoth Project http://www.wesnoth.org/
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY.
+
+   See the COPYING file for more details.
+*/
+
+/**
+ * @file
+ * Keys and tags looked up often in configs, as ready-made strings.
+ *
+ * Looking up cfg["id"] builds a std::string from the literal on each call,
+ * which means an allocation. The code evaluating abilities and weapon
+ * specials does such lookups many times for each simulated fight, so it
+ * uses these constants instead.
+ *
+ * They are initialized with the other statics, so they cannot be used while
+ * initializing statics of other translation units.
+ */
+
+#ifndef CONFIG_KEYS_HPP_INCLUDED
+#define CONFIG_KEYS_HPP_INCLUDED
+
+#include <string>
+
+namespace config_keys {
+
+extern const std::string abilities;
+extern const std::string active_on;
+extern const std::string add;
+extern const std::string adjacent;
+extern const std::string affect_adjacent;
+extern const std::string affect_allies;
+extern const std::string affect_enemies;
+extern const std::string affect_self;
+extern const std::string apply_to;
+extern const std::string backstab;
+extern const std::string cumulative;
+extern const std::string description;
+extern const std::string divide;
+extern const std::string equals;
+extern const std::string filter;
+extern const std::string filter_adjacent;
+extern const std::string filter_adjacent_location;
+extern const std::string filter_attacker;
+extern const std::string filter_base_value;
+extern const std::string filter_defender;
+extern const std::string filter_opponent;
+extern const std::string filter_self;
+extern const std::string filter_weapon;
+extern const std::string greater_than;
+extern const std::string greater_than_equal_to;
+extern const std::string id;
+extern const std::string less_than;
+extern const std::string less_than_equal_to;
+extern const std::string multiply;
+extern const std::string name;
+extern const std::string not_equals;
+extern const std::string sub;
+extern const std::string value;
+
+}
+
+#endif
@@ -0,0 +1,88 @@
+/*
+   Copyright (C) 2015 by the Battle for Wesnoth Project
+   Part of the Battle for Wesnoth Project http://www.wesnoth.org/
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY.
+
+   See the COPYING file for more details.
+*/
+
+#ifndef COUNTER_RNG_HPP_INCLUDED
+#define COUNTER_RNG_HPP_INCLUDED
+
+#include <boost/cstdint.hpp>
+
+#include <cstddef>
+
+namespace rand_rng
+{
+
+/**
+ * A generator whose n-th number is a hash of its seed and of n, for the
+ * randomness that is not synced, such as the map generators and the
+ * animations.
+ *
+ * Any number of the sequence can be had without drawing the ones before
+ * it, and the iterations of fill() do not depend on each other, so that
+ * the compilers can vectorize it. The sequence is the same on all
+ * platforms, but it is not the one of mt_rng: never use it for what must
+ * stay in sync between the players.
+ */
+class counter_rng
+{
+public:
+	explicit counter_rng(boost::uint32_t seed)
+		: key_(mix(seed))
+		, counter_(0)
+	{
+	}
+
+	/** The number at position @a counter of the sequence. */
+	boost::uint32_t at(boost::uint32_t counter) const
+	{
+		return mix(counter * 0x9e3779b9u + key_);
+	}
+
+	boost::uint32_t get_next_random()
+	{
+		return at(counter_++);
+	}
+
+	/** Gets the next @a n numbers, as @a n calls of get_next_random() would. */
+	void fill(boost::uint32_t* out, size_t n)
+	{
+		const boost::uint32_t first = counter_;
+		for(size_t i = 0; i != n; ++i) {
+			out[i] = at(first + static_cast<boost::uint32_t>(i));
+		}
+		counter_ += static_cast<boost::uint32_t>(n);
+	}
+
+	/** The position of the next number in the sequence. */
+	boost::uint32_t get_position() const { return counter_; }
+	void set_position(boost::uint32_t counter) { counter_ = counter; }
+
+private:
+	/** A bijective mix of the bits of @a x, each changing half of the result. */
+	static boost::uint32_t mix(boost::uint32_t x)
+	{
+		x ^= x >> 16;
+		x *= 0x7feb352du;
+		x ^= x >> 15;
+		x *= 0x846ca68bu;
+		x ^= x >> 16;
+		return x;
+	}
+
+	boost::uint32_t key_;
+	boost::uint32_t counter_;
+};
+
+} // ends rand_rng namespace
+
+#endif
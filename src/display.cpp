@@ -165,6 +165,7 @@ display::display(const display_context * dc, CVideo& video, boost::weak_ptr<wb::
 	fake_unit_man_(new fake_unit_manager(*this)),
 	builder_(new terrain_builder(level, &dc_->map(), theme_.border().tile_image)),
 	minimap_(NULL),
+	minimap_renderer_(new image::incremental_minimap()),
 	minimap_location_(sdl::empty_rect),
 	redrawMinimap_(false),
 	redraw_background_(true),
@@ -205,6 +206,12 @@ display::display(const display_context * dc, CVideo& video, boost::weak_ptr<wb::
 	flags_(),
 	activeTeam_(0),
 	drawing_buffer_(),
+	drawing_buffer_sorted_(),
+	drawing_images_(),
+#ifndef SDL_GPU
+	terrain_cache_(),
+	terrain_cache_bytes_(0),
+#endif
 	map_screenshot_(false),
 	reach_map_(),
 	reach_map_old_(),
@@ -494,6 +501,7 @@ const std::string& display::get_variant(const std::vector<std::string>& variants
 void display::rebuild_all()
 {
 	builder_->rebuild_all();
+	minimap_renderer_->clear();
 }
 
 void display::reload_map()
@@ -1193,21 +1201,27 @@ void display::drawing_buffer_add(const tdrawing_layer layer,
 								 const map_location& loc, int x, int y,
 								 const sdl::timage &img)
 {
-	drawing_buffer_.push_back(tblit(layer, loc, x, y, img));
+	const unsigned begin = drawing_images_.size();
+	drawing_images_.push_back(img);
+	drawing_buffer_.push_back(tblit(layer, loc, x, y, begin, begin + 1));
 }
 
 void display::drawing_buffer_add(const tdrawing_layer layer,
 								 const map_location& loc, int x, int y,
 								 const std::vector<sdl::timage> &imgs)
 {
-	drawing_buffer_.push_back(tblit(layer, loc, x, y, imgs));
+	const unsigned begin = drawing_images_.size();
+	drawing_images_.insert(drawing_images_.end(), imgs.begin(), imgs.end());
+	drawing_buffer_.push_back(tblit(layer, loc, x, y, begin, drawing_images_.size()));
 }
 #else
 void display::drawing_buffer_add(const tdrawing_layer layer,
 		const map_location& loc, int x, int y, const surface& surf,
 		const SDL_Rect &clip)
 {
-	drawing_buffer_.push_back(tblit(layer, loc, x, y, surf, clip));
+	const unsigned begin = drawing_images_.size();
+	drawing_images_.push_back(surf);
+	drawing_buffer_.push_back(tblit(layer, loc, x, y, begin, begin + 1, clip));
 }
 
 void display::drawing_buffer_add(const tdrawing_layer layer,
@@ -1215,7 +1229,79 @@ void display::drawing_buffer_add(const tdrawing_layer layer,
 		const std::vector<surface> &surf,
 		const SDL_Rect &clip)
 {
-	drawing_buffer_.push_back(tblit(layer, loc, x, y, surf, clip));
+	const unsigned begin = drawing_images_.size();
+	drawing_images_.insert(drawing_images_.end(), surf.begin(), surf.end());
+	drawing_buffer_.push_back(tblit(layer, loc, x, y, begin, drawing_images_.size(), clip));
+}
+#endif
+
+#ifndef SDL_GPU
+void display::drawing_buffer_add_terrain(const tdrawing_layer layer,
+		const map_location& loc, int x, int y,
+		const std::string& timeid,
+		image::TYPE image_type,
+		TERRAIN_TYPE terrain_type)
+{
+	// Above this, the cache is emptied rather than growing further.
+	static const size_t max_terrain_cache_bytes = 32 * 1024 * 1024;
+
+	std::vector<surface> images = get_terrain_images(loc, timeid, image_type, terrain_type);
+	if(images.size() < 2) {
+		drawing_buffer_add(layer, loc, x, y, images);
+		return;
+	}
+
+	if(animate_map_) {
+		const terrain_builder::imagelist* const terrains = builder_->get_terrain_at(loc, timeid,
+			terrain_type == FOREGROUND ? terrain_builder::FOREGROUND : terrain_builder::BACKGROUND);
+		if(terrains != NULL) {
+			BOOST_FOREACH(const animated<image::locator>& image, *terrains) {
+				if(!image.does_not_change()) {
+					drawing_buffer_add(layer, loc, x, y, images);
+					return;
+				}
+			}
+		}
+	}
+
+	const std::pair<map_location, TERRAIN_TYPE> key(loc, terrain_type);
+	tterrain_cache::iterator cached = terrain_cache_.find(key);
+	if(cached == terrain_cache_.end() || cached->second.images != images) {
+		// Blending only pays off for hexes drawn more than once as they are.
+		tcomposited_terrain& terrain = terrain_cache_[key];
+		if(terrain.composite) {
+			terrain_cache_bytes_ -= terrain.composite->w * terrain.composite->h * 4;
+			terrain.composite = NULL;
+		}
+		terrain.images.swap(images);
+		drawing_buffer_add(layer, loc, x, y, terrain.images);
+		return;
+	}
+
+	if(!cached->second.composite) {
+		const std::vector<surface>& parts = cached->second.images;
+		int w = 0, h = 0;
+		BOOST_FOREACH(const surface& part, parts) {
+			w = std::max(w, part->w);
+			h = std::max(h, part->h);
+		}
+
+		if(terrain_cache_bytes_ + w * h * 4 > max_terrain_cache_bytes) {
+			terrain_cache_.clear();
+			terrain_cache_bytes_ = 0;
+			drawing_buffer_add(layer, loc, x, y, images);
+			return;
+		}
+
+		surface composite = create_neutral_surface(w, h);
+		BOOST_FOREACH(const surface& part, parts) {
+			blit_surface(part, NULL, composite, NULL);
+		}
+		cached->second.composite = create_optimized_surface(composite);
+		terrain_cache_bytes_ += w * h * 4;
+	}
+
+	drawing_buffer_add(layer, loc, x, y, cached->second.composite);
 }
 #endif
 
@@ -1286,10 +1372,57 @@ inline display::drawing_buffer_key::drawing_buffer_key(const map_location &loc,
 	key_ |= (static_cast<unsigned int>(layer) << SHIFT_LAYER) | static_cast<unsigned int>(loc.x + MAX_BORDER) / 2;
 }
 
+namespace {
+
+/**
+ * Sorts @a v by key(), keeping the order of equal keys.
+ *
+ * This is an LSD radix sort of the 32 bits key a byte at a time, using
+ * @a scratch as the second buffer. The passes whose byte is the same for
+ * all the elements, such as the layer group of most blits, are skipped.
+ */
+template <typename T>
+void radix_sort(std::vector<T>& v, std::vector<T>& scratch)
+{
+	if(v.size() < 2) {
+		return;
+	}
+
+	unsigned counts[4][256] = {};
+	for(typename std::vector<T>::const_iterator i = v.begin(); i != v.end(); ++i) {
+		const unsigned int key = i->key();
+		++counts[0][key & 0xff];
+		++counts[1][(key >> 8) & 0xff];
+		++counts[2][(key >> 16) & 0xff];
+		++counts[3][key >> 24];
+	}
+
+	scratch.resize(v.size(), v.front());
+	for(unsigned pass = 0; pass != 4; ++pass) {
+		const unsigned shift = pass * 8;
+		unsigned* const count = counts[pass];
+		if(count[(v.front().key() >> shift) & 0xff] == v.size()) {
+			continue;
+		}
+
+		unsigned offset = 0;
+		for(unsigned b = 0; b != 256; ++b) {
+			const unsigned n = count[b];
+			count[b] = offset;
+			offset += n;
+		}
+		for(typename std::vector<T>::const_iterator i = v.begin(); i != v.end(); ++i) {
+			scratch[count[(i->key() >> shift) & 0xff]++] = *i;
+		}
+		v.swap(scratch);
+	}
+}
+
+}
+
 void display::drawing_buffer_commit()
 {
-	// std::list::sort() is a stable sort
-	drawing_buffer_.sort();
+	radix_sort(drawing_buffer_, drawing_buffer_sorted_);
 
 #ifdef SDL_GPU
 	SDL_Rect clip_rect = map_area();
@@ -1308,8 +1441,9 @@ void display::drawing_buffer_commit()
 	 * layergroup > location > layer > 'tblit' > surface
 	 */
 
-	BOOST_FOREACH(tblit &blit, drawing_buffer_) {
-		BOOST_FOREACH(sdl::timage& img, blit.images()) {
+	BOOST_FOREACH(const tblit &blit, drawing_buffer_) {
+		for(unsigned i = blit.images_begin(); i != blit.images_end(); ++i) {
+			sdl::timage& img = drawing_images_[i];
 			if (!img.null()) {
 				screen_.draw_texture(img, blit.x(), blit.y());
 			}
@@ -1336,7 +1470,8 @@ void display::drawing_buffer_commit()
 	 */
 
 	BOOST_FOREACH(const tblit &blit, drawing_buffer_) {
-		BOOST_FOREACH(const surface& surf, blit.surf()) {
+		for(unsigned i = blit.images_begin(); i != blit.images_end(); ++i) {
+			const surface& surf = drawing_images_[i];
 			// Note that dstrect can be changed by sdl_blit
 			// and so a new instance should be initialized
 			// to pass to each call to sdl_blit.
@@ -1355,6 +1490,7 @@ void display::drawing_buffer_commit()
 void display::drawing_buffer_clear()
 {
 	drawing_buffer_.clear();
+	drawing_images_.clear();
 }
 
 void display::sunset(const size_t delay)
@@ -1368,6 +1504,15 @@ void display::toggle_benchmark()
 	benchmark = !benchmark;
 }
 
+bool display::toggle_profiler(const std::string& csv_file)
+{
+	if(profiler_.enabled()) {
+		profiler_.stop();
+		return true;
+	}
+	return profiler_.start(csv_file);
+}
+
 void display::toggle_debug_foreground()
 {
 	debug_foreground = !debug_foreground;
@@ -1416,7 +1561,7 @@ void display::update_display()
 		return;
 	}
 
-	if(preferences::show_fps() || benchmark) {
+	if(preferences::show_fps() || benchmark || profiler_.enabled()) {
 		static int last_sample = SDL_GetTicks();
 		static int frames = 0;
 		++frames;
@@ -1442,6 +1587,12 @@ void display::update_display()
 			drawn_hexes_ = 0;
 			invalidated_hexes_ = 0;
 
+			if (profiler_.enabled()) {
+				const std::string report = profiler_.report();
+				LOG_DP << "frame profile:\n" << report << "\n";
+				stream << "\n" << report;
+			}
+
 			font::floating_label flabel(stream.str());
 			flabel.set_font_size(12);
 			flabel.set_color(benchmark ? font::BAD_COLOR : font::NORMAL_COLOR);
@@ -1842,12 +1993,16 @@ void display::draw_wrap(bool update, bool force)
 	const int wait_time = nextDraw_ - current_time;
 
 	if(redrawMinimap_) {
+		frame_profiler::timer timer(profiler_, frame_profiler::MINIMAP);
 		redrawMinimap_ = false;
 		draw_minimap();
 	}
 
 	if(update) {
-		update_display();
+		{
+			frame_profiler::timer timer(profiler_, frame_profiler::FLIP);
+			update_display();
+		}
 		if(!force && !benchmark && wait_time > 0) {
 			// If it's not time yet to draw, delay until it is
 			SDL_Delay(wait_time);
@@ -2074,7 +2229,7 @@ void display::draw_minimap()
 	draw_minimap_units();
 #else
 	if(minimap_ == NULL || minimap_->w > area.w || minimap_->h > area.h) {
-		minimap_ = image::getMinimap(area.w, area.h, get_map(), &dc_->teams()[currentTeam_], (selectedHex_.valid() && !is_blindfolded()) ? &reach_map_ : NULL);
+		minimap_ = minimap_renderer_->get(area.w, area.h, get_map(), &dc_->teams()[currentTeam_], (selectedHex_.valid() && !is_blindfolded()) ? &reach_map_ : NULL);
 		if(minimap_ == NULL) {
 			return;
 		}
@@ -2257,10 +2412,52 @@ bool display::scroll(int xmove, int ymove, bool force)
 	update_rect(map_area());
 #endif
 
+	prefetch_terrain(-dx, -dy);
+
 	redrawMinimap_ = true;
 	return true;
 }
 
+void display::prefetch_terrain(int xmove, int ymove)
+{
+	// Scrolling at full speed crosses about a hex per frame.
+	const int band = 2 * hex_size();
+	const SDL_Rect area = map_area();
+
+	std::vector<SDL_Rect> bands;
+	if(xmove != 0) {
+		SDL_Rect r = area;
+		r.x = xmove > 0 ? area.x + area.w : area.x - band;
+		r.w = band;
+		bands.push_back(r);
+	}
+	if(ymove != 0) {
+		SDL_Rect r = area;
+		r.y = ymove > 0 ? area.y + area.h : area.y - band;
+		r.h = band;
+		bands.push_back(r);
+	}
+
+	BOOST_FOREACH(const SDL_Rect& r, bands) {
+		BOOST_FOREACH(const map_location& loc, hexes_under_rect(r)) {
+			if(!get_map().on_board_with_border(loc)) {
+				continue;
+			}
+			const std::string& timeid = get_time_of_day(loc).id;
+			for(int type = 0; type != 2; ++type) {
+				const terrain_builder::imagelist* const terrains = builder_->get_terrain_at(loc, timeid,
+					type ? terrain_builder::FOREGROUND : terrain_builder::BACKGROUND);
+				if(terrains == NULL) {
+					continue;
+				}
+				BOOST_FOREACH(const animated<image::locator>& image, *terrains) {
+					image::prefetch(animate_map_ ? image.get_current_frame() : image.get_first_frame());
+				}
+			}
+		}
+	}
+}
+
 bool display::zoom_at_max() const
 {
 	return zoom_ == MaxZoom;
@@ -2298,6 +2495,11 @@ bool display::set_zoom(int amount, bool absolute)
 			last_zoom_ = zoom_;
 		}
 		image::set_zoom(zoom_);
+#ifndef SDL_GPU
+		// None of the images of the previous zoom will be drawn again.
+		terrain_cache_.clear();
+		terrain_cache_bytes_ = 0;
+#endif
 
 		labels().recalculate_labels();
 		redraw_background_ = true;
@@ -2699,16 +2901,23 @@ void display::draw(bool update,bool force) {
 	set_scontext_leave_for_draw leave_synced_context;
 	local_tod_light_ = has_time_area() && preferences::get("local_tod_lighting", true);
 
-	draw_init();
-	pre_draw();
-	// invalidate all that needs to be invalidated
-	invalidate_animations();
-	// at this stage we have everything that needs to be invalidated for this redraw
-	// save it as the previous invalidated, and merge with the previous invalidated_
-	// we merge with the previous redraw because if a hex had a unit last redraw but
-	// not this one, nobody will tell us to redraw (cleanup)
-	previous_invalidated_.swap(invalidated_);
-	invalidated_.insert(previous_invalidated_.begin(),previous_invalidated_.end());
+	profiler_.begin_frame();
+
+	{
+		frame_profiler::timer timer(profiler_, frame_profiler::INVALIDATION);
+		draw_init();
+		pre_draw();
+		// invalidate all that needs to be invalidated
+		invalidate_animations();
+		// at this stage we have everything that needs to be invalidated for this redraw
+		// save it as the previous invalidated, and merge with the previous invalidated_
+		// we merge with the previous redraw because if a hex had a unit last redraw but
+		// not this one, nobody will tell us to redraw (cleanup)
+		previous_invalidated_.swap(invalidated_);
+		invalidated_.insert(previous_invalidated_.begin(),previous_invalidated_.end());
+	}
+	const size_t hexes = invalidated_.size();
+	size_t blits = 0;
 	// these new invalidations cannot cause any propagation because
 	// if a hex was invalidated last turn but not this turn, then
 	// * case of no unit in neighbor hex=> no propagation
@@ -2725,15 +2934,26 @@ void display::draw(bool update,bool force) {
 			draw_invalidated();
 			invalidated_.clear();
 		}
-		drawing_buffer_commit();
-		post_commit();
-		draw_sidebar();
+		blits = drawing_buffer_.size();
+		{
+			frame_profiler::timer timer(profiler_, frame_profiler::COMMIT);
+			drawing_buffer_commit();
+		}
+		{
+			frame_profiler::timer timer(profiler_, frame_profiler::HALOS);
+			post_commit();
+		}
+		{
+			frame_profiler::timer timer(profiler_, frame_profiler::REPORTS);
+			draw_sidebar();
+		}
 
 		// Simulate slow PC:
 		//SDL_Delay(2*simulate_delay + rand() % 20);
 	}
 	draw_wrap(update, force);
 	post_draw();
+	profiler_.end_frame(hexes, blits);
 }
 
 map_labels& display::labels()
@@ -2763,26 +2983,30 @@ void display::draw_invalidated() {
 	SDL_Rect clip_rect = get_clip_rect();
 	surface screen = get_screen_surface();
 	clip_rect_setter set_clip_rect(screen, &clip_rect);
-	BOOST_FOREACH(const map_location& loc, invalidated_) {
-		int xpos = get_location_x(loc);
-		int ypos = get_location_y(loc);
+	{
+		frame_profiler::timer timer(profiler_, frame_profiler::TERRAIN);
+		BOOST_FOREACH(const map_location& loc, invalidated_) {
+			int xpos = get_location_x(loc);
+			int ypos = get_location_y(loc);
 
-		update_rect(xpos, ypos, zoom_, zoom_);
+			update_rect(xpos, ypos, zoom_, zoom_);
 
-		const bool on_map = get_map().on_board(loc);
-		SDL_Rect hex_rect = sdl::create_rect(xpos, ypos, zoom_, zoom_);
-		if(!sdl::rects_overlap(hex_rect,clip_rect)) {
-			continue;
-		}
-		draw_hex(loc);
-		drawn_hexes_+=1;
-		// If the tile is at the border, we start to blend it
-		if(!on_map) {
-			 draw_border(loc, xpos, ypos);
+			const bool on_map = get_map().on_board(loc);
+			SDL_Rect hex_rect = sdl::create_rect(xpos, ypos, zoom_, zoom_);
+			if(!sdl::rects_overlap(hex_rect,clip_rect)) {
+				continue;
+			}
+			draw_hex(loc);
+			drawn_hexes_+=1;
+			// If the tile is at the border, we start to blend it
+			if(!on_map) {
+				 draw_border(loc, xpos, ypos);
+			}
 		}
 	}
 	invalidated_hexes_ += invalidated_.size();
 
+	frame_profiler::timer timer(profiler_, frame_profiler::UNITS);
 	unit_drawer drawer = unit_drawer(*this, energy_bar_rects_);
 
 	BOOST_FOREACH(const map_location& loc, invalidated_) {
@@ -2805,13 +3029,13 @@ void display::draw_hex(const map_location& loc) {
 	const time_of_day& tod = get_time_of_day(loc);
 	if(!shrouded(loc)) {
 		// unshrouded terrain (the normal case)
+#ifdef SDL_GPU
 		drawing_buffer_add(LAYER_TERRAIN_BG, loc, xpos, ypos,
 			get_terrain_images(loc,tod.id, image_type, BACKGROUND));
 
 		drawing_buffer_add(LAYER_TERRAIN_FG, loc, xpos, ypos,
 			get_terrain_images(loc,tod.id,image_type, FOREGROUND));
 
-#ifdef SDL_GPU
 		// Draw the grid, if that's been enabled
 		if(grid_ && on_map && !off_map_tile) {
 			static const image::locator grid_top(game_config::images::grid_top);
@@ -2824,6 +3048,12 @@ void display::draw_hex(const map_location& loc) {
 		// village-control flags.
 		drawing_buffer_add(LAYER_TERRAIN_BG, loc, xpos, ypos, get_flag(loc));
 #else
+		drawing_buffer_add_terrain(LAYER_TERRAIN_BG, loc, xpos, ypos,
+			tod.id, image_type, BACKGROUND);
+
+		drawing_buffer_add_terrain(LAYER_TERRAIN_FG, loc, xpos, ypos,
+			tod.id, image_type, FOREGROUND);
+
 		// Draw the grid, if that's been enabled
 		if(grid_ && on_map && !off_map_tile) {
 			static const image::locator grid_top(game_config::images::grid_top);
@@ -40,6 +40,10 @@ class map_labels;
 class arrow;
 class reports;
 
+namespace image {
+	class incremental_minimap;
+}
+
 namespace halo {
 	class manager;
 }
@@ -52,6 +56,7 @@ namespace wb {
 #include "display_context.hpp"
 #include "filter_context.hpp"
 #include "font.hpp"
+#include "frame_profiler.hpp"
 #include "image.hpp" //only needed for enums (!)
 #include "key.hpp"
 #include "team.hpp"
@@ -475,6 +480,15 @@ public:
 	/** Toggle to continuously redraw the screen. */
 	static void toggle_benchmark();
 
+	/**
+	 * Toggles the timing of the phases of draw(), shown under the fps.
+	 *
+	 * @param csv_file            If not empty, the frames are also written
+	 *                            to this file.
+	 * @returns                   False if the file can't be written.
+	 */
+	bool toggle_profiler(const std::string& csv_file);
+
 	/**
 	 * Toggle to debug foreground terrain.
 	 * Separate background and foreground layer
@@ -754,6 +768,12 @@ protected:
 
 	void scroll_to_xy(int screenxpos, int screenypos, SCROLL_TYPE scroll_type,bool force = true);
 
+	/**
+	 * Starts decoding the terrain images of the hexes just beyond the
+	 * edges of the map area the view moves towards, see image::prefetch().
+	 */
+	void prefetch_terrain(int xmove, int ymove);
+
 	void fill_images_list(const std::string& prefix, std::vector<std::string>& images);
 
 	const std::string& get_variant(const std::vector<std::string>& variants, const map_location &loc) const;
@@ -770,6 +790,8 @@ protected:
 	boost::scoped_ptr<fake_unit_manager> fake_unit_man_;
 	boost::scoped_ptr<terrain_builder> builder_;
 	surface minimap_;
+	/** Keeps the hexes of the minimap which don't change. */
+	boost::scoped_ptr<image::incremental_minimap> minimap_renderer_;
 	SDL_Rect minimap_location_;
 	bool redrawMinimap_;
 	bool redraw_background_;
@@ -834,6 +856,9 @@ protected:
 	/** Local cache for preferences "local_tod_lighting" */
 	bool local_tod_light_;
 
+	/** Times the phases of draw() when enabled. */
+	frame_profiler profiler_;
+
 private:
 
 #ifdef SDL_GPU
@@ -990,67 +1015,98 @@ protected:
 		drawing_buffer_key(const map_location &loc, tdrawing_layer layer);
 
 		bool operator<(const drawing_buffer_key &rhs) const { return key_ < rhs.key_; }
+
+		unsigned int key() const { return key_; }
 	};
 
-	/** Helper structure for rendering the terrains. */
+	/**
+	 * Helper structure for rendering the terrains.
+	 *
+	 * The images to render are not held by the blit but stored one after
+	 * the other in @ref drawing_images_, the blit only knows their range.
+	 * This keeps the blits small and free of any reference counting, so
+	 * that sorting them doesn't cost more than moving a few words.
+	 */
 	class tblit
 	{
 	public:
 #ifdef SDL_GPU
 		tblit(const tdrawing_layer layer, const map_location& loc,
-				const int x, const int y, const sdl::timage& image)
-			: x_(x), y_(y), images_(1, image), key_(loc, layer)
-		{}
-
-		tblit(const tdrawing_layer layer, const map_location& loc,
-			  const int x, const int y,
-			  const std::vector<sdl::timage>& images)
-			: x_(x), y_(y), images_(images), key_(loc, layer)
+				const int x, const int y,
+				const unsigned images_begin, const unsigned images_end)
+			: x_(x), y_(y), images_begin_(images_begin),
+			images_end_(images_end), key_(drawing_buffer_key(loc, layer).key())
 		{}
 #else
 		tblit(const tdrawing_layer layer, const map_location& loc,
-				const int x, const int y, const surface& surf,
+				const int x, const int y,
+				const unsigned images_begin, const unsigned images_end,
 				const SDL_Rect& clip)
-			: x_(x), y_(y), surf_(1, surf), clip_(clip),
-			key_(loc, layer)
-		{}
-
-		tblit(const tdrawing_layer layer, const map_location& loc,
-				const int x, const int y, const std::vector<surface>& surf,
-				const SDL_Rect& clip)
-			: x_(x), y_(y), surf_(surf), clip_(clip),
-			key_(loc, layer)
+			: x_(x), y_(y), images_begin_(images_begin),
+			images_end_(images_end), clip_(clip),
+			key_(drawing_buffer_key(loc, layer).key())
 		{}
 #endif
 
 		int x() const { return x_; }
 		int y() const { return y_; }
-#ifdef SDL_GPU
-		std::vector<sdl::timage> &images() { return images_; }
-#else
-		const std::vector<surface> &surf() const { return surf_; }
+		unsigned images_begin() const { return images_begin_; }
+		unsigned images_end() const { return images_end_; }
+#ifndef SDL_GPU
 		const SDL_Rect &clip() const { return clip_; }
 #endif
 
-		bool operator<(const tblit &rhs) const { return key_ < rhs.key_; }
+		/** The drawing order, see drawing_buffer_key. */
+		unsigned int key() const { return key_; }
 
 	private:
 		int x_;                      /**< x screen coordinate to render at. */
 		int y_;                      /**< y screen coordinate to render at. */
-#ifdef SDL_GPU
-		std::vector<sdl::timage> images_;
-#else
-		std::vector<surface> surf_;  /**< surface(s) to render. */
+		unsigned images_begin_;      /**< First image in drawing_images_. */
+		unsigned images_end_;        /**< Past the last image in drawing_images_. */
+#ifndef SDL_GPU
 		SDL_Rect clip_;              /**<
 									  * The clipping area of the source if
 									  * omitted the entire source is used.
 									  */
 #endif
-		drawing_buffer_key key_;
+		unsigned int key_;
 	};
 
-	typedef std::list<tblit> tdrawing_buffer;
+	/**
+	 * The blits of the frame, sorted by drawing_buffer_commit().
+	 *
+	 * The vectors are only cleared after each frame, so once the first
+	 * frames are drawn they don't allocate any more.
+	 */
+	typedef std::vector<tblit> tdrawing_buffer;
 	tdrawing_buffer drawing_buffer_;
+	/** Scratch space for sorting drawing_buffer_. */
+	tdrawing_buffer drawing_buffer_sorted_;
+#ifdef SDL_GPU
+	std::vector<sdl::timage> drawing_images_;
+#else
+	/** The surfaces of all the blits of drawing_buffer_. */
+	std::vector<surface> drawing_images_;
+
+	/** The terrain of a hex last drawn, and the images blended if it was drawn again. */
+	struct tcomposited_terrain
+	{
+		tcomposited_terrain() : images(), composite() {}
+
+		/**
+		 * Held so that the surfaces stay alive: as their addresses can't be
+		 * reused, comparing them tells whether the terrain changed.
+		 */
+		std::vector<surface> images;
+		surface composite;
+	};
+
+	typedef std::map<std::pair<map_location, TERRAIN_TYPE>, tcomposited_terrain> tterrain_cache;
+	tterrain_cache terrain_cache_;
+	/** The memory used by the composites of terrain_cache_. */
+	size_t terrain_cache_bytes_;
+#endif
 
 public:
 #ifdef SDL_GPU
@@ -1077,6 +1133,21 @@ public:
 			const map_location& loc, int x, int y,
 			const std::vector<surface> &surf,
 			const SDL_Rect &clip = SDL_Rect());
+
+	/**
+	 * Adds the terrain images of @a loc to the drawing buffer, see
+	 * get_terrain_images().
+	 *
+	 * When a hex is drawn again with the same images, as happens while
+	 * units are animated around it, the images are blended once into a
+	 * surface of @ref terrain_cache_ which is then drawn in their place.
+	 * Animated terrains are always drawn image by image.
+	 */
+	void drawing_buffer_add_terrain(const tdrawing_layer layer,
+					const map_location &loc, int x, int y,
+					const std::string& timeid,
+					image::TYPE type,
+					TERRAIN_TYPE terrain_type);
 #endif
 
 protected:
@@ -127,18 +127,14 @@ bool display_context::is_observer() const
 
 int display_context::side_units(int side) const
 {
-	int res = 0;
-	BOOST_FOREACH(const unit &u, units()) {
-		if (u.side() == side) ++res;
-	}
-	return res;
+	return units().units_of_side(side).size();
 }
 
 int display_context::side_units_cost(int side) const
 {
 	int res = 0;
-	BOOST_FOREACH(const unit &u, units()) {
-		if (u.side() == side) res += u.cost();
+	BOOST_FOREACH(const unit_map::const_unit_iterator &u, units().units_of_side(side)) {
+		res += u->cost();
 	}
 	return res;
 }
@@ -146,8 +142,8 @@ int display_context::side_units_cost(int side) const
 int display_context::side_upkeep(int side) const
 {
 	int res = 0;
-	BOOST_FOREACH(const unit &u, units()) {
-		if (u.side() == side) res += u.upkeep();
+	BOOST_FOREACH(const unit_map::const_unit_iterator &u, units().units_of_side(side)) {
+		res += u->upkeep();
 	}
 	return res;
 }
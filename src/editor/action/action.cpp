@@ -61,9 +61,13 @@ std::string editor_action::get_description() const
 
 editor_action* editor_action::perform(map_context& mc) const
 {
-	util::unique_ptr<editor_action> undo(new editor_action_whole_map(mc.get_map()));
+	const editor_map before(mc.get_map());
 	perform_without_undo(mc);
-	return undo.release();
+	// Keep only what changed, unless the map was resized.
+	if (!mc.get_map().same_size_as(before)) {
+		return new editor_action_whole_map(before);
+	}
+	return new editor_action_map_diff(before, mc.get_map());
 }
 
 editor_action_whole_map* editor_action_whole_map::clone() const
@@ -74,6 +78,58 @@ void editor_action_whole_map::perform_without_undo(map_context& mc) const {
 	mc.set_map(m_);
 }
 
+editor_action_map_diff::editor_action_map_diff(const editor_map& before, const editor_map& after)
+	: terrain_()
+	, starting_positions_()
+	, selection_(before.selection())
+{
+	map_location loc;
+	for (loc.x = -before.border_size(); loc.x < before.w() + before.border_size(); ++loc.x) {
+		for (loc.y = -before.border_size(); loc.y < before.h() + before.border_size(); ++loc.y) {
+			if (before.get_terrain(loc) != after.get_terrain(loc)) {
+				terrain_.add_tile(before, loc);
+			}
+		}
+	}
+	for (int side = 0; side <= gamemap::MAX_PLAYERS; ++side) {
+		starting_positions_.push_back(before.starting_position(side));
+	}
+}
+
+editor_action_map_diff* editor_action_map_diff::clone() const
+{
+	return new editor_action_map_diff(*this);
+}
+
+editor_action_map_diff* editor_action_map_diff::perform(map_context& mc) const
+{
+	const editor_map& map = mc.get_map();
+	util::unique_ptr<editor_action_map_diff> undo(new editor_action_map_diff());
+	undo->terrain_ = map_fragment(map, terrain_.get_area());
+	for (int side = 0; side <= gamemap::MAX_PLAYERS; ++side) {
+		undo->starting_positions_.push_back(map.starting_position(side));
+	}
+	undo->selection_ = map.selection();
+	perform_without_undo(mc);
+	return undo.release();
+}
+
+void editor_action_map_diff::perform_without_undo(map_context& mc) const
+{
+	editor_map& map = mc.get_map();
+	terrain_.paste_into(map, map_location(0, 0));
+	mc.add_changed_location(terrain_.get_area());
+	mc.set_needs_terrain_rebuild();
+	for (size_t side = 0; side != starting_positions_.size(); ++side) {
+		map.set_starting_position(side, starting_positions_[side]);
+	}
+	mc.set_needs_labels_reset();
+	if (map.selection() != selection_) {
+		map.set_selection(selection_);
+		mc.set_everything_changed();
+	}
+}
+
 editor_action_chain::editor_action_chain(const editor::editor_action_chain &other)
 	: editor_action(), actions_()
 {
@@ -194,7 +250,6 @@ editor_action_paste* editor_action_paint_area::perform(map_context& mc) const
 void editor_action_paint_area::perform_without_undo(map_context& mc) const
 {
 	mc.draw_terrain(t_, area_, one_layer_);
-	mc.set_needs_terrain_rebuild();
 }
 
 editor_action_fill* editor_action_fill::clone() const
@@ -206,14 +261,12 @@ editor_action_paint_area* editor_action_fill::perform(map_context& mc) const
 	std::set<map_location> to_fill = mc.get_map().get_contiguous_terrain_tiles(loc_);
 	util::unique_ptr<editor_action_paint_area> undo(new editor_action_paint_area(to_fill, mc.get_map().get_terrain(loc_)));
 	mc.draw_terrain(t_, to_fill, one_layer_);
-	mc.set_needs_terrain_rebuild();
 	return undo.release();
 }
 void editor_action_fill::perform_without_undo(map_context& mc) const
 {
 	std::set<map_location> to_fill = mc.get_map().get_contiguous_terrain_tiles(loc_);
 	mc.draw_terrain(t_, to_fill, one_layer_);
-	mc.set_needs_terrain_rebuild();
 }
 
 editor_action_starting_position* editor_action_starting_position::clone() const
@@ -311,7 +364,6 @@ void editor_action_shuffle_area::perform_without_undo(map_context& mc) const
 		++orig_it;
 		++shuffle_it;
 	}
-	mc.set_needs_terrain_rebuild();
 }
 
 } //end namespace editor
@@ -49,6 +49,35 @@ class editor_action_whole_map : public editor_action
 		editor_map m_;
 };
 
+/**
+ * Restore the hexes, starting positions and selection that differ between
+ * two maps of the same size.
+ * The undo of the actions that may change any part of the map, keeping
+ * only what they changed rather than a copy of the entire map.
+ */
+class editor_action_map_diff : public editor_action
+{
+	public:
+		/**
+		 * Create the action changing @a after back into @a before.
+		 */
+		editor_action_map_diff(const editor_map& before, const editor_map& after);
+		editor_action_map_diff* clone() const;
+		editor_action_map_diff* perform(map_context& m) const;
+		void perform_without_undo(map_context& m) const;
+		const char* get_name() const { return "map_diff"; }
+	protected:
+		editor_action_map_diff()
+		: terrain_(), starting_positions_(), selection_()
+		{
+		}
+		/** The previous terrain of the hexes that changed. */
+		map_fragment terrain_;
+		/** The starting positions to restore, indexed by side. */
+		std::vector<map_location> starting_positions_;
+		std::set<map_location> selection_;
+};
+
 /**
  * Base class for actions that:
  * 1) operate on an area
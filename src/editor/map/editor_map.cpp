@@ -260,6 +260,7 @@ void editor_map::resize(int width, int height, int x_offset, int y_offset,
 			}
 		}
 	}
+	new_revision();
 	sanity_check();
 }
 
@@ -355,6 +355,9 @@ void map_context::draw_terrain_actual(const t_translation::t_terrain & terrain,
 			map_.set_terrain(loc, terrain);
 		}
 		add_changed_location(loc);
+		// Only rebuild when something was actually painted over, so that
+		// dragging a brush over its own terrain stays cheap.
+		set_needs_terrain_rebuild();
 	}
 }
 
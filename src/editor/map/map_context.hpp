@@ -254,7 +254,7 @@ public:
 	 */
 	void set_needs_labels_reset(bool value=true) { needs_labels_reset_ = value; }
 
-	const std::set<map_location> changed_locations() const { return changed_locations_; }
+	const std::set<map_location>& changed_locations() const { return changed_locations_; }
 	void clear_changed_locations();
 	void add_changed_location(const map_location& loc);
 	void add_changed_location(const std::set<map_location>& locs);
@@ -177,8 +177,7 @@ void terrain_palette::draw_item(const t_translation::t_terrain& terrain,
 		}
 
 		if(base_image->w != item_size_ || base_image->h != item_size_) {
-			base_image.assign(scale_surface(base_image,
-					item_size_, item_size_));
+			base_image = image::scaled_image(base_image, item_size_, item_size_);
 		}
 	}
 
@@ -195,8 +194,7 @@ void terrain_palette::draw_item(const t_translation::t_terrain& terrain,
 	}
 
 	if(image->w != item_size_ || image->h != item_size_) {
-		image.assign(scale_surface(image,
-				item_size_, item_size_));
+		image = image::scaled_image(image, item_size_, item_size_);
 	}
 
 	tooltip_text << map().get_terrain_editor_string(terrain);
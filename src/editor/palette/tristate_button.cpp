@@ -43,7 +43,7 @@ tristate_button::tristate_button(CVideo& video,
 		const bool auto_join) :
 				widget(video, auto_join),
 				baseImage_(NULL), touchedBaseImage_(NULL), activeBaseImage_(NULL),
-				itemImage_(NULL),
+				itemImage_(NULL), neutralItemImage_(NULL),
 				pressedDownImage_(NULL), pressedUpImage_(NULL), pressedBothImage_(NULL),
 				pressedBothActiveImage_(NULL), pressedDownActiveImage_(NULL), pressedUpActiveImage_(NULL),
 				touchedDownImage_(NULL), touchedUpImage_(NULL), touchedBothImage_(NULL),
@@ -234,17 +234,14 @@ void tristate_button::draw_contents() {
 
 	SDL_Color button_color = font::BUTTON_COLOR;
 
-	surface scalled_item;
-	scalled_item.assign(scale_surface(itemImage_,
-			36, 36));
-
 	// blit_surface want neutral surfaces
-	surface nitem = make_neutral_surface(scalled_item);
 	surface nbase = make_neutral_surface(base);
 
 	//TODO avoid magic numbers
 	SDL_Rect r = sdl::create_rect(1, 1, 0, 0);
-	blit_surface(nitem, NULL, nbase, &r);
+	if(neutralItemImage_) {
+		blit_surface(neutralItemImage_, NULL, nbase, &r);
+	}
 
 	if (!overlay.null()) {
 		surface noverlay = make_neutral_surface(overlay);
@@ -271,6 +268,18 @@ void tristate_button::draw_contents() {
 	update_rect(loc);
 }
 
+void tristate_button::set_item_image(const surface& image)
+{
+	// The palettes set the same images at every redraw.
+	if(image == itemImage_) {
+		return;
+	}
+	itemImage_ = image;
+
+	//TODO avoid magic numbers
+	neutralItemImage_ = make_neutral_surface(image::scaled_image(image, 36, 36));
+}
+
 //TODO move to widget
 bool tristate_button::hit(int x, int y) const {
 	return sdl::point_in_rect(x, y, location());
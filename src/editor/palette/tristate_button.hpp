@@ -55,11 +55,7 @@ public:
 	virtual void enable(bool new_val=true);
 	void release();
 
-	void set_item_image(
-			const surface& image)
-	{
-		itemImage_ = image;
-	}
+	void set_item_image(const surface& image);
 
 	void set_item_id(const std::string& id) {
 		item_id_ = id;
@@ -86,6 +82,8 @@ private:
 
 	surface baseImage_, touchedBaseImage_, activeBaseImage_,
 		itemImage_,
+		/** The item image scaled for the button, neutral for blitting. */
+		neutralItemImage_,
 	//	normalImage_, activeImage_,
 		pressedDownImage_, pressedUpImage_, pressedBothImage_,
 		pressedBothActiveImage_, pressedDownActiveImage_, pressedUpActiveImage_,
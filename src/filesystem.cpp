@@ -341,6 +341,36 @@ bool delete_file(const std::string& path)
 	return ret;
 }
 
+bool rename_file(const std::string& from, const std::string& to)
+{
+	if(rename(from.c_str(), to.c_str()) != 0) {
+		ERR_FS << "rename(" << from << ", " << to << "): " << strerror(errno) << "\n";
+		return false;
+	}
+	return true;
+}
+
+#ifdef _WIN32
+bool hard_link_file(const std::string& /*target*/, const std::string& /*link*/)
+{
+	return false;
+}
+#else
+bool hard_link_file(const std::string& target, const std::string& link)
+{
+	return ::link(target.c_str(), link.c_str()) == 0;
+}
+#endif
+
+unsigned hard_link_count(const std::string& fname)
+{
+	struct stat st;
+	if(::stat(fname.c_str(), &st) == -1) {
+		return 0;
+	}
+	return st.st_nlink;
+}
+
 std::string get_cwd()
 {
 	char buf[1024];
@@ -650,16 +680,21 @@ std::istream *istream_file(const std::string &fname, bool treat_failure_as_error
 	return s;
 }
 
+std::istream *istream_mapped_file(const std::string &fname, bool treat_failure_as_error)
+{
+	return istream_file(fname, treat_failure_as_error);
+}
+
 std::string read_file(const std::string &fname)
 {
 	scoped_istream s = istream_file(fname);
 	return read_stream(*s);
 }
 
-std::ostream *ostream_file(std::string const &fname)
+std::ostream *ostream_file(std::string const &fname, bool append)
 {
 	LOG_FS << "streaming " << fname << " for writing." << std::endl;
-	return new std::ofstream(fname.c_str(), std::ios_base::binary);
+	return new std::ofstream(fname.c_str(), append ? std::ios_base::binary | std::ios_base::app : std::ios_base::binary);
 }
 
 // Throws io_exception if an error occurs
@@ -878,6 +913,7 @@ void binary_paths_manager::set_paths(const config& cfg)
 void binary_paths_manager::cleanup()
 {
 	binary_paths_cache.clear();
+	clear_binary_file_indexes();
 
 	for(std::vector<std::string>::const_iterator i = paths_.begin(); i != paths_.end(); ++i) {
 		binary_paths.erase(*i);
@@ -887,6 +923,7 @@ void binary_paths_manager::cleanup()
 void clear_binary_paths_cache()
 {
 	binary_paths_cache.clear();
+	clear_binary_file_indexes();
 }
 
 const std::vector<std::string>& get_binary_paths(const std::string& type)
@@ -948,18 +985,13 @@ std::string get_binary_file_location(const std::string& type, const std::string&
 		return std::string();
 	}
 
-	BOOST_FOREACH(const std::string &path, get_binary_paths(type))
-	{
-		const std::string file = path + filename;
-		DBG_FS << "  checking '" << path << "'" << std::endl;
-		if(file_exists(file)) {
-			DBG_FS << "  found at '" << file << "'" << std::endl;
-			return file;
-		}
+	const std::string file = find_binary_file(type, filename);
+	if(file.empty()) {
+		DBG_FS << "  not found" << std::endl;
+	} else {
+		DBG_FS << "  found at '" << file << "'" << std::endl;
 	}
-
-	DBG_FS << "  not found" << std::endl;
-	return std::string();
+	return file;
 }
 
 std::string get_binary_dir_location(const std::string &type, const std::string &filename)
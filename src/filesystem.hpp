@@ -96,6 +96,20 @@ bool make_directory(const std::string& dirname);
 bool delete_directory(const std::string& dirname, const bool keep_pbl = false);
 bool delete_file(const std::string &filename);
 
+/** Renames a file or directory, which @a to must not exist as. */
+bool rename_file(const std::string& from, const std::string& to);
+
+/**
+ * Gives the file @a target the additional name @a link, which must not
+ * exist yet, without copying the file.
+ *
+ * @returns                       False if the filesystem doesn't allow it.
+ */
+bool hard_link_file(const std::string& target, const std::string& link);
+
+/** The number of names of a file, 0 if it doesn't exist. */
+unsigned hard_link_count(const std::string& fname);
+
 bool looks_like_pbl(const std::string& file);
 
 // Basic disk I/O:
@@ -103,7 +117,14 @@ bool looks_like_pbl(const std::string& file);
 /** Basic disk I/O - read file. */
 std::string read_file(const std::string &fname);
 std::istream *istream_file(const std::string &fname, bool treat_failure_as_error = true);
-std::ostream *ostream_file(std::string const &fname);
+/**
+ * Same as istream_file(), reading the file through a memory mapping where
+ * possible, which spares the copies and system calls for large files read
+ * once, such as saves.
+ */
+std::istream *istream_mapped_file(const std::string &fname, bool treat_failure_as_error = true);
+/** Opens @a fname for writing, truncating it unless @a append. */
+std::ostream *ostream_file(std::string const &fname, bool append = false);
 /** Throws io_exception if an error occurs. */
 void write_file(const std::string& fname, const std::string& data);
 
@@ -159,9 +180,18 @@ struct file_tree_checksum
 	{ return !operator==(rhs); }
 };
 
-/** Get the time at which the data/ tree was last modified at. */
+/**
+ * Get the time at which the data/ tree was last modified at.
+ * @a reset also forgets the checksums of dir_tree_checksum().
+ */
 const file_tree_checksum& data_tree_checksum(bool reset = false);
 
+/**
+ * The checksum of the tree under @a dir alone, computed once and then
+ * remembered until data_tree_checksum(true).
+ */
+const file_tree_checksum& dir_tree_checksum(const std::string& dir);
+
 /** Returns the size of a file, or -1 if the file doesn't exist. */
 int file_size(const std::string& fname);
 
@@ -226,6 +256,25 @@ private:
 
 void clear_binary_paths_cache();
 
+/**
+ * Builds the index of the files under the binary paths of @a type, unless
+ * it already exists. The paths are scanned in parallel.
+ */
+void index_binary_paths(const std::string& type);
+
+/**
+ * Returns the first of the binary paths of @a type having @a filename, as
+ * get_binary_file_location() does once it checked the name.
+ *
+ * The directories named after the type are looked up in the index, which
+ * is built on first use; the others are probed. The index is kept until
+ * the binary paths change, so files added under them later are missed.
+ */
+std::string find_binary_file(const std::string& type, const std::string& filename);
+
+/** Forgets the indexes of the binary paths, scanning them again on next use. */
+void clear_binary_file_indexes();
+
 /**
  * Returns a vector with all possible paths to a given type of binary,
  * e.g. 'images', 'sounds', etc,
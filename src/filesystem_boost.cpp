@@ -28,6 +28,7 @@
 #include <boost/foreach.hpp>
 #include <boost/system/windows_error.hpp>
 #include <boost/iostreams/device/file_descriptor.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
 #include <boost/iostreams/stream.hpp>
 #include <set>
 
@@ -719,6 +720,35 @@ bool delete_file(const std::string &filename)
 	return ret;
 }
 
+bool rename_file(const std::string& from, const std::string& to)
+{
+	error_code ec;
+	bfs::rename(path(from), path(to), ec);
+	if (ec) {
+		ERR_FS << "Could not rename " << from << " to " << to << ": " << ec.message() << '\n';
+		return false;
+	}
+	return true;
+}
+
+bool hard_link_file(const std::string& target, const std::string& link)
+{
+	error_code ec;
+	bfs::create_hard_link(path(target), path(link), ec);
+	if (ec) {
+		DBG_FS << "Could not link " << link << " to " << target << ": " << ec.message() << '\n';
+		return false;
+	}
+	return true;
+}
+
+unsigned hard_link_count(const std::string& fname)
+{
+	error_code ec;
+	const uintmax_t count = bfs::hard_link_count(path(fname), ec);
+	return ec ? 0 : count;
+}
+
 std::string read_file(const std::string &fname)
 {
 	scoped_istream is = istream_file(fname);
@@ -782,13 +812,33 @@ std::istream *istream_file(const std::string &fname, bool treat_failure_as_error
 	}
 }
 
-std::ostream *ostream_file(std::string const &fname)
+std::istream *istream_mapped_file(const std::string &fname, bool treat_failure_as_error)
+{
+	if (!fname.empty()) {
+		try
+		{
+			// (Empty files cannot be mapped, they are read as usual.)
+			const iostream_path file_path(fname);
+			boost::iostreams::mapped_file_source file(file_path);
+			LOG_FS << "Mapping " << fname << " for reading.\n";
+			return new boost::iostreams::stream<boost::iostreams::mapped_file_source>(file);
+		}
+		catch(const std::exception& e)
+		{
+			DBG_FS << "Could not map '" << fname << "': " << e.what() << '\n';
+		}
+	}
+	return istream_file(fname, treat_failure_as_error);
+}
+
+std::ostream *ostream_file(std::string const &fname, bool append)
 {
 	LOG_FS << "streaming " << fname << " for writing.\n";
 #if 1
 	try
 	{
-		boost::iostreams::file_descriptor_sink fd(iostream_path(fname), std::ios_base::binary);
+		boost::iostreams::file_descriptor_sink fd(iostream_path(fname),
+			append ? std::ios_base::binary | std::ios_base::app : std::ios_base::binary);
 		return new boost::iostreams::stream<boost::iostreams::file_descriptor_sink>(fd, 4096, 0);
 	}
 	catch(BOOST_IOSTREAMS_FAILURE& e)
@@ -796,7 +846,7 @@ std::ostream *ostream_file(std::string const &fname)
 		throw filesystem::io_exception(e.what());
 	}
 #else
-	return new bfs::ofstream(path(fname), std::ios_base::binary);
+	return new bfs::ofstream(path(fname), append ? std::ios_base::binary | std::ios_base::app : std::ios_base::binary);
 #endif
 }
 // Throws io_exception if an error occurs
@@ -978,6 +1028,7 @@ void binary_paths_manager::set_paths(const config& cfg)
 void binary_paths_manager::cleanup()
 {
 	binary_paths_cache.clear();
+	clear_binary_file_indexes();
 
 	for(std::vector<std::string>::const_iterator i = paths_.begin(); i != paths_.end(); ++i) {
 		binary_paths.erase(*i);
@@ -988,6 +1039,7 @@ void binary_paths_manager::cleanup()
 void clear_binary_paths_cache()
 {
 	binary_paths_cache.clear();
+	clear_binary_file_indexes();
 }
 
 static bool is_legal_file(const std::string &filename)
@@ -1062,19 +1114,13 @@ std::string get_binary_file_location(const std::string& type, const std::string&
 	if (!is_legal_file(filename))
 		return std::string();
 
-	BOOST_FOREACH(const std::string &bp, get_binary_paths(type))
-	{
-		path bpath(bp);
-		bpath /= filename;
-		DBG_FS << "  checking '" << bp << "'\n";
-		if (file_exists(bpath)) {
-			DBG_FS << "  found at '" << bpath.string() << "'\n";
-			return bpath.string();
-		}
+	const std::string file = find_binary_file(type, filename);
+	if(file.empty()) {
+		DBG_FS << "  not found\n";
+	} else {
+		DBG_FS << "  found at '" << file << "'\n";
 	}
-
-	DBG_FS << "  not found\n";
-	return std::string();
+	return file;
 }
 
 std::string get_binary_dir_location(const std::string &type, const std::string &filename)
@@ -2,6 +2,7 @@
 #include "global.hpp"
 
 #include <fstream>
+#include <map>
 
 #include "filesystem.hpp"
 
@@ -11,8 +12,12 @@
 #include "log.hpp"
 #include "serialization/string_utils.hpp"
 #include "serialization/unicode.hpp"
+#include "thread.hpp"
 #include "util.hpp"
 
+#include <boost/foreach.hpp>
+#include <boost/unordered_map.hpp>
+
 #include <SDL_rwops.h>
 
 static lg::log_domain log_filesystem("filesystem");
@@ -185,11 +190,15 @@ static void get_file_tree_checksum_internal(const std::string& path, file_tree_c
 	}
 }
 
+static std::map<std::string, file_tree_checksum> dir_checksums;
+
 const file_tree_checksum& data_tree_checksum(bool reset)
 {
 	static file_tree_checksum checksum;
-	if (reset)
+	if (reset) {
 		checksum.reset();
+		dir_checksums.clear();
+	}
 	if(checksum.nfiles == 0) {
 		get_file_tree_checksum_internal("data/",checksum);
 		get_file_tree_checksum_internal(get_user_data_dir() + "/data/",checksum);
@@ -201,6 +210,178 @@ const file_tree_checksum& data_tree_checksum(bool reset)
 	return checksum;
 }
 
+const file_tree_checksum& dir_tree_checksum(const std::string& dir)
+{
+	std::map<std::string, file_tree_checksum>::iterator i = dir_checksums.find(dir);
+	if(i == dir_checksums.end()) {
+		i = dir_checksums.insert(std::make_pair(dir, file_tree_checksum())).first;
+		get_file_tree_checksum_internal(dir, i->second);
+		LOG_FS << "calculated tree checksum of " << dir << ": "
+			   << i->second.nfiles << " files; "
+			   << i->second.sum_size << " bytes" << std::endl;
+	}
+
+	return i->second;
+}
+
+namespace {
+
+/** The files under the binary paths of a type. */
+struct binary_file_index
+{
+	binary_file_index() : paths(), scanned(), first_path()
+	{
+	}
+
+	std::vector<std::string> paths;
+
+	/**
+	 * Whether each of the paths was scanned. The others, the data
+	 * directories themselves, are too large for it and are still probed.
+	 */
+	std::vector<bool> scanned;
+
+	/** The first of the scanned paths having each file, by name. */
+	boost::unordered_map<std::string, size_t> first_path;
+};
+
+std::map<std::string, binary_file_index> binary_file_indexes;
+
+/** The key of @a filename in the index, folded where the file names are. */
+std::string index_key(const std::string& filename)
+{
+#if defined(_WIN32) || defined(__APPLE__)
+	return utf8::lowercase(filename);
+#else
+	return filename;
+#endif
+}
+
+/** Whether @a filename is named as the index has it, a scanned file being found. */
+bool indexable(const std::string& filename)
+{
+	if(filename.empty() || filename[0] == '/' || filename[0] == '.'
+			|| filename.find('\\') != std::string::npos
+			|| filename.find("//") != std::string::npos
+			|| filename.find("/.") != std::string::npos) {
+		return false;
+	}
+	return *filename.rbegin() != '/';
+}
+
+/** Lists the files under each of the paths, each path as a task of its own. */
+class scan_job : public threading::parallel_job
+{
+public:
+	scan_job(const std::vector<std::string>& dirs)
+		: dirs_(dirs)
+		, files_(dirs.size())
+	{
+	}
+
+	void run(size_t index)
+	{
+		files_[index].clear();
+		scan(dirs_[index], std::string(), files_[index]);
+	}
+
+	const std::vector<std::string>& files(size_t index) const
+	{
+		return files_[index];
+	}
+
+private:
+	static void scan(const std::string& dir, const std::string& prefix, std::vector<std::string>& out)
+	{
+		std::vector<std::string> files, dirs;
+		get_files_in_dir(dir + prefix, &files, &dirs, FILE_NAME_ONLY, NO_FILTER, DONT_REORDER);
+		BOOST_FOREACH(const std::string& f, files) {
+			out.push_back(prefix + f);
+		}
+		BOOST_FOREACH(const std::string& d, dirs) {
+			scan(dir, prefix + d + '/', out);
+		}
+	}
+
+	const std::vector<std::string>& dirs_;
+	std::vector<std::vector<std::string> > files_;
+};
+
+const binary_file_index& get_binary_file_index(const std::string& type)
+{
+	std::map<std::string, binary_file_index>::iterator i = binary_file_indexes.find(type);
+	if(i != binary_file_indexes.end()) {
+		return i->second;
+	}
+
+	binary_file_index& index = binary_file_indexes[type];
+	index.paths = get_binary_paths(type);
+
+	// Only the directories named after the type are scanned.
+	const std::string suffix = '/' + type + '/';
+	std::vector<std::string> dirs;
+	std::vector<size_t> positions;
+	for(size_t p = 0; p != index.paths.size(); ++p) {
+		const bool scanned = !type.empty() && ends_with(index.paths[p], suffix);
+		index.scanned.push_back(scanned);
+		if(scanned) {
+			dirs.push_back(index.paths[p]);
+			positions.push_back(p);
+		}
+	}
+
+	scan_job job(dirs);
+	threading::run_parallel(job, dirs.size());
+
+	for(size_t d = 0; d != dirs.size(); ++d) {
+		BOOST_FOREACH(const std::string& f, job.files(d)) {
+			// The paths come in the order of the search, the first one wins.
+			index.first_path.insert(std::make_pair(index_key(f), positions[d]));
+		}
+	}
+	LOG_FS << "indexed " << index.first_path.size() << " files in "
+		<< dirs.size() << " binary paths of type '" << type << "'\n";
+	return index;
+}
+
+}
+
+void index_binary_paths(const std::string& type)
+{
+	get_binary_file_index(type);
+}
+
+std::string find_binary_file(const std::string& type, const std::string& filename)
+{
+	const binary_file_index& index = get_binary_file_index(type);
+	const bool use_index = indexable(filename);
+
+	size_t found = index.paths.size();
+	if(use_index) {
+		boost::unordered_map<std::string, size_t>::const_iterator i = index.first_path.find(index_key(filename));
+		if(i != index.first_path.end()) {
+			found = i->second;
+		}
+	}
+
+	// The paths not covered by the index come before the file found.
+	for(size_t p = 0; p != found; ++p) {
+		if(use_index && index.scanned[p]) {
+			continue;
+		}
+		const std::string file = index.paths[p] + filename;
+		if(file_exists(file)) {
+			return file;
+		}
+	}
+	return found == index.paths.size() ? std::string() : index.paths[found] + filename;
+}
+
+void clear_binary_file_indexes()
+{
+	binary_file_indexes.clear();
+}
+
 
 static int SDLCALL ifs_seek(struct SDL_RWops *context, int offset, int whence);
 static int SDLCALL ifs_read(struct SDL_RWops *context, void *ptr, int size, int maxnum);
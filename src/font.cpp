@@ -593,6 +593,9 @@ public:
 #endif
 	std::vector<surface> const & get_surfaces() const;
 
+	/** The memory of the surfaces rendered, none being rendered for this. */
+	size_t memory_usage() const;
+
 	bool operator==(text_surface const &t) const {
 		return hash_ == t.hash_ && font_size_ == t.font_size_
 			&& color_ == t.color_ && style_ == t.style_ && str_ == t.str_;
@@ -744,6 +747,17 @@ size_t text_surface::height() const
 	return h_;
 }
 
+size_t text_surface::memory_usage() const
+{
+	size_t res = 0;
+	BOOST_FOREACH(const surface& s, surfs_) {
+		if(s) {
+			res += s->h * s->pitch;
+		}
+	}
+	return res;
+}
+
 std::vector<surface> const &text_surface::get_surfaces() const
 {
 	if(initialized_)
@@ -773,6 +787,7 @@ class text_cache
 public:
 	static text_surface &find(text_surface const &t);
 	static void resize(unsigned int size);
+	static size_t memory_usage();
 private:
 	typedef std::list< text_surface > text_list;
 	static text_list cache_;
@@ -794,6 +809,15 @@ void text_cache::resize(unsigned int size)
 }
 
 
+size_t text_cache::memory_usage()
+{
+	size_t res = 0;
+	BOOST_FOREACH(const text_surface& t, cache_) {
+		res += t.memory_usage();
+	}
+	return res;
+}
+
 text_surface &text_cache::find(text_surface const &t)
 {
 	static size_t lookup_ = 0, hit_ = 0;
@@ -1118,5 +1142,22 @@ void cache_mode(CACHE mode)
 	}
 }
 
+size_t cache_memory_usage()
+{
+	// A node of a std::map is about four pointers beside the pair it holds.
+	const size_t node = 4 * sizeof(void*);
+	size_t res = text_cache::memory_usage();
+	typedef std::map<int, line_size_cache_map> size_map;
+	typedef std::map<int, size_map> style_map;
+	BOOST_FOREACH(const style_map::value_type& style, line_size_cache) {
+		BOOST_FOREACH(const size_map::value_type& size, style.second) {
+			BOOST_FOREACH(const line_size_cache_map::value_type& line, size.second) {
+				res += node + sizeof(line) + line.first.size();
+			}
+		}
+	}
+	return res;
+}
+
 
 }
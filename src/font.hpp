@@ -111,6 +111,9 @@ const t_string& get_font_families();
 enum CACHE { CACHE_LOBBY, CACHE_GAME };
 void cache_mode(CACHE mode);
 
+/** The memory used by the rendered texts and the line sizes cached. */
+size_t cache_memory_usage();
+
 }
 
 #endif
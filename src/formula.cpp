@@ -12,7 +12,10 @@
 #include "global.hpp"
 
 #include <boost/lexical_cast.hpp>
+#include <boost/unordered_map.hpp>
+#include <algorithm>
 #include <iostream>
+#include <list>
 #include <set>
 #include <sstream>
 
@@ -25,6 +28,53 @@
 namespace game_logic
 {
 
+namespace {
+
+/** The interned names; std::map nodes do not move, so names can point to the keys. */
+std::map<std::string, size_t>& interned_keys()
+{
+	static std::map<std::string, size_t> keys;
+	if(keys.empty()) {
+		keys.insert(std::make_pair(std::string("self"), formula_key::self_id));
+	}
+	return keys;
+}
+
+}
+
+formula_key::formula_key(const std::string& name)
+	: id_()
+	, name_()
+{
+	std::map<std::string, size_t>& keys = interned_keys();
+	std::map<std::string, size_t>::iterator i =
+		keys.insert(std::make_pair(name, keys.size())).first;
+	id_ = i->second;
+	name_ = &i->first;
+}
+
+formula_key_table::formula_key_table(const char* const* names)
+	: by_id_()
+	, by_name_()
+{
+	for(int attribute = 0; names[attribute]; ++attribute) {
+		const formula_key key(names[attribute]);
+		if(key.id() >= by_id_.size()) {
+			by_id_.resize(key.id() + 1, -1);
+		}
+		by_id_[key.id()] = attribute;
+		by_name_.push_back(std::make_pair(key.name(), attribute));
+	}
+	std::sort(by_name_.begin(), by_name_.end());
+}
+
+int formula_key_table::find(const std::string& name) const
+{
+	std::vector<std::pair<std::string, int> >::const_iterator i =
+		std::lower_bound(by_name_.begin(), by_name_.end(), std::make_pair(name, -1));
+	return i != by_name_.end() && i->first == name ? i->second : -1;
+}
+
 void formula_callable::set_value(const std::string& key, const variant& /*value*/)
 {
 	std::cerr << "ERROR: cannot set key '" << key << "' on object" << std::endl;
@@ -50,6 +100,15 @@ variant map_formula_callable::get_value(const std::string& key) const
 	        fallback_ ? fallback_->query_value(key) : variant());
 }
 
+variant map_formula_callable::get_key_value(const formula_key& key) const
+{
+	std::map<std::string,variant>::const_iterator i = values_.find(key.name());
+	if(i != values_.end()) {
+		return i->second;
+	}
+	return fallback_ ? fallback_->query_value(key) : variant();
+}
+
 void map_formula_callable::get_inputs(std::vector<formula_input>* inputs) const
 {
 	if(fallback_) {
@@ -109,6 +168,14 @@ private:
 		return variant(&res);
 	}
 
+	bool compile(formula_bytecode& code) const {
+		for(std::vector<expression_ptr>::const_iterator i = items_.begin(); i != items_.end(); ++i) {
+			code.compile(**i);
+		}
+		code.emit_list(items_.size());
+		return true;
+	}
+
 	std::vector<expression_ptr> items_;
 
 	std::string str() const
@@ -161,6 +228,17 @@ private:
 		return variant(&res);
 	}
 
+	bool compile(formula_bytecode& code) const {
+		unsigned pairs = 0;
+		for(std::vector<expression_ptr>::const_iterator i = items_.begin(); ( i != items_.end() ) && ( i+1 != items_.end() ) ; i+=2) {
+			code.compile(**i);
+			code.compile(**(i+1));
+			++pairs;
+		}
+		code.emit_map(pairs);
+		return true;
+	}
+
 	std::vector<expression_ptr> items_;
 };
 
@@ -196,6 +274,13 @@ private:
 			return -res;
 		}
 	}
+
+	bool compile(formula_bytecode& code) const {
+		code.compile(*operand_);
+		code.emit(op_ == NOT ? formula_bytecode::NOT : formula_bytecode::NEGATE);
+		return true;
+	}
+
 	enum OP { NOT, SUB };
 	OP op_;
 	std::string op_str_;
@@ -259,6 +344,15 @@ private:
 		else
 			return v;
 	}
+
+	variant get_key_value(const formula_key& key) const {
+		variant v = local_.query_value(key);
+
+		if ( v == variant() )
+			return global_.query_value(key);
+		else
+			return v;
+	}
 };
 
 class dot_expression : public formula_expression {
@@ -289,6 +383,12 @@ private:
 		return right_->evaluate(callable,add_debug_info(fdb,1,".right"));
 	}
 
+	bool compile(formula_bytecode& code) const {
+		code.compile(*left_);
+		code.emit_dot(*right_);
+		return true;
+	}
+
 	expression_ptr left_, right_;
 };
 
@@ -315,6 +415,13 @@ private:
 		}
 	}
 
+	bool compile(formula_bytecode& code) const {
+		code.compile(*left_);
+		code.compile(*key_);
+		code.emit(formula_bytecode::INDEX);
+		return true;
+	}
+
 	expression_ptr left_, key_;
 };
 
@@ -322,26 +429,40 @@ class operator_expression : public formula_expression {
 public:
 	operator_expression(const std::string& op, expression_ptr left,
 	                             expression_ptr right)
-		: op_(OP(op[0])), op_str_(op), left_(left), right_(right)
+		: op_(formula_bytecode::DICE), op_str_(op), left_(left), right_(right)
 	{
 		if(op == ">=") {
-			op_ = GTE;
+			op_ = formula_bytecode::GTE;
 		} else if(op == "<=") {
-			op_ = LTE;
+			op_ = formula_bytecode::LTE;
 		} else if(op == "!=") {
-			op_ = NEQ;
+			op_ = formula_bytecode::NEQ;
 		} else if(op == "and") {
-			op_ = AND;
+			op_ = formula_bytecode::AND;
 		} else if(op == "or") {
-			op_ = OR;
+			op_ = formula_bytecode::OR;
 		} else if(op == ".+") {
-			op_ = ADDL;
+			op_ = formula_bytecode::ADDL;
 		} else if(op == ".-") {
-			op_ = SUBL;
+			op_ = formula_bytecode::SUBL;
 		} else if(op == ".*") {
-			op_ = MULL;
+			op_ = formula_bytecode::MULL;
 		} else if(op == "./") {
-			op_ = DIVL;
+			op_ = formula_bytecode::DIVL;
+		} else {
+			switch(op[0]) {
+			case '>': op_ = formula_bytecode::GT; break;
+			case '<': op_ = formula_bytecode::LT; break;
+			case '=': op_ = formula_bytecode::EQ; break;
+			case '+': op_ = formula_bytecode::ADD; break;
+			case '-': op_ = formula_bytecode::SUB; break;
+			case '*': op_ = formula_bytecode::MUL; break;
+			case '/': op_ = formula_bytecode::DIV; break;
+			case '^': op_ = formula_bytecode::POW; break;
+			case '%': op_ = formula_bytecode::MOD; break;
+			case 'd':
+			default: op_ = formula_bytecode::DICE; break;
+			}
 		}
 	}
 
@@ -355,61 +476,17 @@ private:
 	variant execute(const formula_callable& variables, formula_debugger *fdb) const {
 		const variant left = left_->evaluate(variables,add_debug_info(fdb,0,"left_OP"));
 		const variant right = right_->evaluate(variables,add_debug_info(fdb,1,"OP_right"));
-		switch(op_) {
-		case AND:
-			return left.as_bool() == false ? left : right;
-		case OR:
-			return left.as_bool() ? left : right;
-		case ADD:
-			return left + right;
-		case SUB:
-			return left - right;
-		case MUL:
-			return left * right;
-		case DIV:
-			return left / right;
-		case POW:
-			return left ^ right;
-		case ADDL:
-			return left.list_elements_add(right);
-		case SUBL:
-			return left.list_elements_sub(right);
-		case MULL:
-			return left.list_elements_mul(right);
-		case DIVL:
-			return left.list_elements_div(right);
-		case EQ:
-			return left == right ? variant(1) : variant(0);
-		case NEQ:
-			return left != right ? variant(1) : variant(0);
-		case LTE:
-			return left <= right ? variant(1) : variant(0);
-		case GTE:
-			return left >= right ? variant(1) : variant(0);
-		case LT:
-			return left < right ? variant(1) : variant(0);
-		case GT:
-			return left > right ? variant(1) : variant(0);
-		case MOD:
-			return left % right;
-		case DICE:
-		default:
-			return variant(dice_roll(left.as_int(), right.as_int()));
-		}
+		return formula_bytecode::apply(op_, left, right);
 	}
 
-	static int dice_roll(int num_rolls, int faces) {
-		int res = 0;
-		while(faces > 0 && num_rolls-- > 0) {
-			res += (rand()%faces)+1;
-		}
-		return res;
+	bool compile(formula_bytecode& code) const {
+		code.compile(*left_);
+		code.compile(*right_);
+		code.emit(op_);
+		return true;
 	}
 
-	enum OP { AND, OR, NEQ, LTE, GTE, GT='>', LT='<', EQ='=',
-	          ADD='+', SUB='-', MUL='*', DIV='/', ADDL, SUBL, MULL, DIVL, DICE='d', POW='^', MOD='%' };
-
-	OP op_;
+	formula_bytecode::opcode op_;
 	std::string op_str_;
 	expression_ptr left_, right_;
 };
@@ -441,18 +518,37 @@ private:
 	}
 
 	variant get_value(const std::string& key) const {
-		expr_table::iterator i = table_->find(key);
-		if(i != table_->end()) {
-			exp_table_evaluated::const_iterator ev = evaluated_table_.find(key);
-			if( ev != evaluated_table_.end())
-				return ev->second;
+		variant v;
+		if(find_clause(key, v)) {
+			return v;
+		}
+		return base_.query_value(key);
+	}
 
-			variant v = i->second->evaluate(base_);
-			evaluated_table_[key] = v;
+	variant get_key_value(const formula_key& key) const {
+		variant v;
+		if(find_clause(key.name(), v)) {
 			return v;
 		}
 		return base_.query_value(key);
 	}
+
+	/** Evaluates the clause @a key into @a value, once; false if there is none. */
+	bool find_clause(const std::string& key, variant& value) const {
+		expr_table::iterator i = table_->find(key);
+		if(i == table_->end()) {
+			return false;
+		}
+		exp_table_evaluated::const_iterator ev = evaluated_table_.find(key);
+		if( ev != evaluated_table_.end()) {
+			value = ev->second;
+			return true;
+		}
+
+		value = i->second->evaluate(base_);
+		evaluated_table_[key] = value;
+		return true;
+	}
 };
 
 class where_expression: public formula_expression {
@@ -460,7 +556,11 @@ public:
 	explicit where_expression(expression_ptr body,
 				  expr_table_ptr clauses)
 		: body_(body), clauses_(clauses)
-	{}
+	{
+		for(expr_table::iterator i = clauses_->begin(); i != clauses_->end(); ++i) {
+			i->second = compiled_expression::wrap(i->second);
+		}
+	}
 
 	std::string str() const
 	{
@@ -482,6 +582,11 @@ private:
 		where_variables wrapped_variables(variables, clauses_);
 		return body_->evaluate(wrapped_variables,fdb);
 	}
+
+	bool compile(formula_bytecode& code) const {
+		code.emit_where(*body_, clauses_);
+		return true;
+	}
 };
 
 
@@ -491,13 +596,17 @@ public:
 	{}
 	std::string str() const
 	{
-		return id_;
+		return id_.name();
 	}
 private:
 	variant execute(const formula_callable& variables, formula_debugger * /*fdb*/) const {
 		return variables.query_value(id_);
 	}
-	std::string id_;
+	bool compile(formula_bytecode& code) const {
+		code.emit_identifier(id_);
+		return true;
+	}
+	formula_key id_;
 };
 
 class null_expression : public formula_expression {
@@ -510,6 +619,10 @@ private:
 	variant execute(const formula_callable& /*variables*/, formula_debugger * /*fdb*/) const {
 		return variant();
 	}
+	bool compile(formula_bytecode& code) const {
+		code.emit_constant(variant());
+		return true;
+	}
 };
 
 
@@ -527,6 +640,10 @@ private:
 	variant execute(const formula_callable& /*variables*/, formula_debugger * /*fdb*/) const {
 		return variant(i_);
 	}
+	bool compile(formula_bytecode& code) const {
+		code.emit_constant(variant(i_));
+		return true;
+	}
 
 	int i_;
 };
@@ -546,6 +663,10 @@ private:
 	variant execute(const formula_callable& /*variables*/, formula_debugger * /*fdb*/) const {
 		return variant(i_ * 1000 + f_, variant::DECIMAL_VARIANT );
 	}
+	bool compile(formula_bytecode& code) const {
+		code.emit_constant(variant(i_ * 1000 + f_, variant::DECIMAL_VARIANT));
+		return true;
+	}
 
 	int i_, f_;
 };
@@ -598,6 +719,14 @@ private:
 		}
 	}
 
+	bool compile(formula_bytecode& code) const {
+		if(!subs_.empty()) {
+			return false;
+		}
+		code.emit_constant(str_);
+		return true;
+	}
+
 	struct substitution {
 
 		substitution() :
@@ -999,6 +1128,431 @@ expression_ptr parse_expression(const token* i1, const token* i2, function_symbo
 
 }
 
+formula_bytecode::formula_bytecode()
+	: code_()
+	, constants_()
+	, identifiers_()
+	, expressions_()
+	, programs_()
+	, where_clauses_()
+	, depth_(0)
+	, max_depth_(0)
+{
+}
+
+formula_bytecode::formula_bytecode(const formula_expression& expr)
+	: code_()
+	, constants_()
+	, identifiers_()
+	, expressions_()
+	, programs_()
+	, where_clauses_()
+	, depth_(0)
+	, max_depth_(0)
+{
+	compile(expr);
+}
+
+namespace {
+
+int dice_roll(int num_rolls, int faces) {
+	int res = 0;
+	while(faces > 0 && num_rolls-- > 0) {
+		res += (rand()%faces)+1;
+	}
+	return res;
+}
+
+bool is_number(const variant& v)
+{
+	return v.is_int() || v.is_decimal();
+}
+
+/**
+ * Whether applying @a op to the constants @a left and @a right at compile
+ * time is fine: it has to give the same value every time, and must not
+ * throw (type_error complains on construction already).
+ */
+bool can_fold(formula_bytecode::opcode op, const variant& left, const variant& right)
+{
+	switch(op) {
+	case formula_bytecode::AND:
+	case formula_bytecode::OR:
+		return true;
+	case formula_bytecode::EQ:
+	case formula_bytecode::NEQ:
+		return (is_number(left) && is_number(right)) ||
+			(left.is_string() && right.is_string());
+	case formula_bytecode::ADD:
+	case formula_bytecode::SUB:
+	case formula_bytecode::MUL:
+	case formula_bytecode::POW:
+	case formula_bytecode::LT:
+	case formula_bytecode::GT:
+	case formula_bytecode::LTE:
+	case formula_bytecode::GTE:
+		return is_number(left) && is_number(right);
+	case formula_bytecode::DIV:
+	case formula_bytecode::MOD:
+		return is_number(left) && is_number(right) &&
+			right.as_int() != 0 && right.as_decimal() != 0;
+	default:
+		// Dice are random, list operators and indexing may fail.
+		return false;
+	}
+}
+
+}
+
+variant formula_bytecode::apply(opcode op, const variant& left, const variant& right)
+{
+	switch(op) {
+	case AND:
+		return left.as_bool() == false ? left : right;
+	case OR:
+		return left.as_bool() ? left : right;
+	case ADD:
+		return left + right;
+	case SUB:
+		return left - right;
+	case MUL:
+		return left * right;
+	case DIV:
+		return left / right;
+	case POW:
+		return left ^ right;
+	case ADDL:
+		return left.list_elements_add(right);
+	case SUBL:
+		return left.list_elements_sub(right);
+	case MULL:
+		return left.list_elements_mul(right);
+	case DIVL:
+		return left.list_elements_div(right);
+	case EQ:
+		return left == right ? variant(1) : variant(0);
+	case NEQ:
+		return left != right ? variant(1) : variant(0);
+	case LTE:
+		return left <= right ? variant(1) : variant(0);
+	case GTE:
+		return left >= right ? variant(1) : variant(0);
+	case LT:
+		return left < right ? variant(1) : variant(0);
+	case GT:
+		return left > right ? variant(1) : variant(0);
+	case MOD:
+		return left % right;
+	case DICE:
+	default:
+		return variant(dice_roll(left.as_int(), right.as_int()));
+	}
+}
+
+void formula_bytecode::compile(const formula_expression& expr)
+{
+	if(!expr.compile(*this)) {
+		expressions_.push_back(&expr);
+		push(EXPRESSION, expressions_.size() - 1, 1);
+	}
+}
+
+void formula_bytecode::emit_constant(const variant& value)
+{
+	constants_.push_back(value);
+	push(CONSTANT, constants_.size() - 1, 1);
+}
+
+void formula_bytecode::emit_identifier(const formula_key& id)
+{
+	size_t i = 0;
+	while(i != identifiers_.size() && identifiers_[i].id() != id.id()) {
+		++i;
+	}
+	if(i == identifiers_.size()) {
+		identifiers_.push_back(id);
+	}
+	push(IDENTIFIER, i, 1);
+}
+
+void formula_bytecode::emit(opcode op)
+{
+	if(op == NOT || op == NEGATE) {
+		if(constants_on_top(1)) {
+			const variant operand = pop_constants(1).front();
+			if(op == NOT) {
+				emit_constant(operand.as_bool() ? variant(0) : variant(1));
+				return;
+			} else if(is_number(operand)) {
+				emit_constant(-operand);
+				return;
+			}
+			emit_constant(operand);
+		}
+		push(op, 0, 0);
+		return;
+	}
+
+	if(constants_on_top(2)) {
+		const std::vector<variant> operands = pop_constants(2);
+		if(can_fold(op, operands[0], operands[1])) {
+			emit_constant(apply(op, operands[0], operands[1]));
+			return;
+		}
+		emit_constant(operands[0]);
+		emit_constant(operands[1]);
+	}
+	push(op, 0, -1);
+}
+
+void formula_bytecode::emit_list(unsigned size)
+{
+	if(constants_on_top(size)) {
+		std::vector<variant> items = pop_constants(size);
+		emit_constant(variant(&items));
+	} else {
+		push(LIST, size, 1 - int(size));
+	}
+}
+
+void formula_bytecode::emit_map(unsigned size)
+{
+	if(constants_on_top(2 * size)) {
+		const std::vector<variant> items = pop_constants(2 * size);
+		std::map<variant,variant> res;
+		for(unsigned i = 0; i != size; ++i) {
+			res[items[2*i]] = items[2*i + 1];
+		}
+		emit_constant(variant(&res));
+	} else {
+		push(MAP, size, 1 - 2 * int(size));
+	}
+}
+
+void formula_bytecode::emit_dot(const formula_expression& right)
+{
+	programs_.push_back(boost::shared_ptr<formula_bytecode>(new formula_bytecode(right)));
+	where_clauses_.push_back(expr_table_ptr());
+	push(DOT, programs_.size() - 1, 0);
+}
+
+void formula_bytecode::emit_where(const formula_expression& body,
+		const boost::shared_ptr<std::map<std::string, expression_ptr> >& clauses)
+{
+	programs_.push_back(boost::shared_ptr<formula_bytecode>(new formula_bytecode(body)));
+	where_clauses_.push_back(clauses);
+	push(WHERE, programs_.size() - 1, 1);
+}
+
+void formula_bytecode::push(opcode op, unsigned arg, int depth_change)
+{
+	code_.push_back(instruction(op, arg));
+	depth_ += depth_change;
+	max_depth_ = std::max(max_depth_, depth_);
+}
+
+bool formula_bytecode::constants_on_top(unsigned n) const
+{
+	if(n > code_.size()) {
+		return false;
+	}
+	for(unsigned i = code_.size() - n; i != code_.size(); ++i) {
+		if(code_[i].op != CONSTANT) {
+			return false;
+		}
+	}
+	return true;
+}
+
+std::vector<variant> formula_bytecode::pop_constants(unsigned n)
+{
+	std::vector<variant> res;
+	res.reserve(n);
+	for(unsigned i = code_.size() - n; i != code_.size(); ++i) {
+		res.push_back(constants_[code_[i].arg]);
+	}
+	// Constants are only ever referred to by the instruction that added them.
+	code_.erase(code_.end() - n, code_.end());
+	constants_.resize(constants_.size() - n);
+	depth_ -= n;
+	return res;
+}
+
+namespace {
+
+/**
+ * The values of formula_bytecode::run(). They live on the C++ stack unless
+ * there are uncommonly many at once, since most formulas are short.
+ */
+class value_stack
+{
+public:
+	explicit value_stack(size_t capacity)
+		: size_(0)
+		, heap_(capacity > inline_capacity ? new char[capacity * sizeof(variant)] : NULL)
+		, values_(heap_ ? reinterpret_cast<variant*>(heap_) : reinterpret_cast<variant*>(inline_.bytes))
+	{
+	}
+
+	~value_stack()
+	{
+		while(size_ != 0) {
+			pop();
+		}
+		delete[] heap_;
+	}
+
+	/** Where to construct the next value; push() it afterwards. */
+	void* next() { return values_ + size_; }
+	void push() { ++size_; }
+
+	void pop() { values_[--size_].~variant(); }
+	variant& top() { return values_[size_ - 1]; }
+	variant& operator[](size_t i) { return values_[i]; }
+	size_t size() const { return size_; }
+
+private:
+	value_stack(const value_stack&);
+	void operator=(const value_stack&);
+
+	static const size_t inline_capacity = 16;
+
+	size_t size_;
+	char* heap_;
+	union {
+		char bytes[inline_capacity * sizeof(variant)];
+		double align_double;
+		void* align_pointer;
+	} inline_;
+	variant* values_;
+};
+
+}
+
+variant formula_bytecode::run(const formula_callable& variables) const
+{
+	// Many formulas (and right hand sides of '.') are a single value.
+	if(code_.size() == 1) {
+		const instruction& i = code_.front();
+		switch(i.op) {
+		case CONSTANT:
+			return constants_[i.arg];
+		case IDENTIFIER:
+			return variables.query_value(identifiers_[i.arg]);
+		case EXPRESSION:
+			return expressions_[i.arg]->evaluate(variables);
+		default:
+			break;
+		}
+	}
+
+	value_stack stack(max_depth_);
+	for(std::vector<instruction>::const_iterator i = code_.begin(); i != code_.end(); ++i) {
+		switch(i->op) {
+		case CONSTANT:
+			new (stack.next()) variant(constants_[i->arg]);
+			stack.push();
+			break;
+		case IDENTIFIER:
+			new (stack.next()) variant(variables.query_value(identifiers_[i->arg]));
+			stack.push();
+			break;
+		case EXPRESSION:
+			new (stack.next()) variant(expressions_[i->arg]->evaluate(variables));
+			stack.push();
+			break;
+		case LIST: {
+			std::vector<variant> items;
+			items.reserve(i->arg);
+			for(size_t item = stack.size() - i->arg; item != stack.size(); ++item) {
+				items.push_back(stack[item]);
+			}
+			for(unsigned n = 0; n != i->arg; ++n) {
+				stack.pop();
+			}
+			new (stack.next()) variant(&items);
+			stack.push();
+			break;
+		}
+		case MAP: {
+			std::map<variant,variant> res;
+			for(size_t item = stack.size() - 2 * i->arg; item != stack.size(); item += 2) {
+				res[stack[item]] = stack[item + 1];
+			}
+			for(unsigned n = 0; n != 2 * i->arg; ++n) {
+				stack.pop();
+			}
+			new (stack.next()) variant(&res);
+			stack.push();
+			break;
+		}
+		case NOT:
+			stack.top() = stack.top().as_bool() ? variant(0) : variant(1);
+			break;
+		case NEGATE:
+			stack.top() = -stack.top();
+			break;
+		case INDEX: {
+			const variant& left = stack[stack.size() - 2];
+			const variant res = left.is_list() || left.is_map() ? left[stack.top()] : variant();
+			stack.pop();
+			stack.top() = res;
+			break;
+		}
+		case DOT: {
+			// Same as dot_expression.
+			const variant left = stack.top();
+			if(left.is_callable()) {
+				dot_callable callable(variables, *left.as_callable());
+				stack.top() = programs_[i->arg]->run(callable);
+			} else if(left.is_list()) {
+				list_callable list_call(left);
+				dot_callable callable(variables, list_call);
+				stack.top() = programs_[i->arg]->run(callable);
+			}
+			break;
+		}
+		case WHERE: {
+			where_variables wrapped_variables(variables, where_clauses_[i->arg]);
+			new (stack.next()) variant(programs_[i->arg]->run(wrapped_variables));
+			stack.push();
+			break;
+		}
+		default: {
+			variant& left = stack[stack.size() - 2];
+			left = apply(i->op, left, stack.top());
+			stack.pop();
+			break;
+		}
+		}
+	}
+	assert(stack.size() == 1);
+	return stack.top();
+}
+
+compiled_expression::compiled_expression(const expression_ptr& expr)
+	: expr_(expr)
+	, code_(*expr)
+{
+	set_name(expr->get_name());
+}
+
+expression_ptr compiled_expression::wrap(const expression_ptr& expr)
+{
+	if(dynamic_cast<const compiled_expression*>(expr.get())) {
+		return expr;
+	}
+	return expression_ptr(new compiled_expression(expr));
+}
+
+variant compiled_expression::execute(const formula_callable& variables, formula_debugger *fdb) const
+{
+	if(fdb != NULL) {
+		return expr_->execute(variables, fdb);
+	}
+	return code_.run(variables);
+}
+
 formula_ptr formula::create_optional_formula(const std::string& str, function_symbol_table* symbols)
 {
 	if(str.empty()) {
@@ -1008,8 +1562,138 @@ formula_ptr formula::create_optional_formula(const std::string& str, function_sy
 	return formula_ptr(new formula(str, symbols));
 }
 
+namespace {
+
+/** Least recently used formulas, see formula_cache. */
+class parse_cache
+{
+public:
+	parse_cache() : entries_(), index_(), text_size_(0), stats_() {}
+
+	const_formula_ptr get(const std::string& str, function_symbol_table* symbols)
+	{
+		const size_t generation = symbols ? symbols->generation() : 0;
+		std::string key(reinterpret_cast<const char*>(&symbols), sizeof(symbols));
+		key.append(reinterpret_cast<const char*>(&generation), sizeof(generation));
+		key += str;
+
+		const index_map::iterator it = index_.find(key);
+		if(it != index_.end()) {
+			++stats_.hits;
+			entries_.splice(entries_.begin(), entries_, it->second);
+			return it->second->f;
+		}
+		++stats_.misses;
+
+		const const_formula_ptr f(new formula(str, symbols));
+		if((symbols && symbols->generation() != generation) ||
+				str.size() > formula_cache::max_text_size) {
+			// It defined functions, or is too big to be kept.
+			++stats_.uncached;
+			return f;
+		}
+
+		entries_.push_front(entry(symbols, f));
+		index_[key] = entries_.begin();
+		entries_.front().key = &index_.find(key)->first;
+		text_size_ += str.size();
+		while(index_.size() > formula_cache::max_entries || text_size_ > formula_cache::max_text_size) {
+			drop(--entries_.end());
+		}
+		return f;
+	}
+
+	void clear()
+	{
+		index_.clear();
+		entries_.clear();
+		text_size_ = 0;
+	}
+
+	void clear(const function_symbol_table* symbols)
+	{
+		for(entry_list::iterator i = entries_.begin(); i != entries_.end(); ) {
+			if(i->symbols == symbols) {
+				drop(i++);
+			} else {
+				++i;
+			}
+		}
+	}
+
+	formula_cache::statistics get_statistics() const
+	{
+		formula_cache::statistics res = stats_;
+		res.entries = index_.size();
+		res.text_size = text_size_;
+		return res;
+	}
+
+private:
+	struct entry
+	{
+		entry(const function_symbol_table* s, const const_formula_ptr& formula)
+			: key(NULL), symbols(s), f(formula)
+		{}
+		/** The key in index_, to erase it. */
+		const std::string* key;
+		const function_symbol_table* symbols;
+		const_formula_ptr f;
+	};
+	typedef std::list<entry> entry_list;
+	typedef boost::unordered_map<std::string, entry_list::iterator> index_map;
+
+	void drop(entry_list::iterator i)
+	{
+		text_size_ -= i->f->str().size();
+		const std::string key = *i->key;
+		entries_.erase(i);
+		index_.erase(key);
+	}
+
+	/** Most recently used first. */
+	entry_list entries_;
+	index_map index_;
+	size_t text_size_;
+	formula_cache::statistics stats_;
+};
+
+parse_cache& get_parse_cache()
+{
+	// Never destroyed, as tables destroyed at exit still clear their entries.
+	static parse_cache* cache = new parse_cache;
+	return *cache;
+}
+
+}
+
+const_formula_ptr formula::get_cached(const std::string& str, function_symbol_table* symbols)
+{
+	return get_parse_cache().get(str, symbols);
+}
+
+namespace formula_cache {
+
+void clear()
+{
+	get_parse_cache().clear();
+}
+
+void clear(const function_symbol_table* symbols)
+{
+	get_parse_cache().clear(symbols);
+}
+
+statistics get_statistics()
+{
+	return get_parse_cache().get_statistics();
+}
+
+}
+
 formula::formula(const std::string& str, function_symbol_table* symbols) :
 	expr_(),
+	code_(),
 	str_(str)
 {
 	using namespace formula_tokenizer;
@@ -1113,9 +1797,11 @@ formula::formula(const std::string& str, function_symbol_table* symbols) :
 	} else {
 		expr_ = expression_ptr(new null_expression());
 	}
+	code_ = formula_bytecode(*expr_);
 }
 formula::formula(const token* i1, const token* i2, function_symbol_table* symbols) :
 	expr_(),
+	code_(),
 	str_()
 {
 
@@ -1124,11 +1810,15 @@ formula::formula(const token* i1, const token* i2, function_symbol_table* symbol
 	} else {
 		expr_ = expression_ptr(new null_expression());
 	}
+	code_ = formula_bytecode(*expr_);
 }
 
 variant formula::execute(const formula_callable& variables, formula_debugger *fdb) const
 {
 	try {
+		if(fdb == NULL) {
+			return code_.run(variables);
+		}
 		return expr_->evaluate(variables, fdb);
 	} catch(type_error& e) {
 		std::cerr << "formula type error: " << e.message << "\n";
@@ -1136,6 +1826,16 @@ variant formula::execute(const formula_callable& variables, formula_debugger *fd
 	}
 }
 
+variant formula::evaluate_tree(const formula_callable& variables) const
+{
+	try {
+		return expr_->evaluate(variables);
+	} catch(type_error& e) {
+		std::cerr << "formula type error: " << e.message << "\n";
+		return variant();
+	}
+}
+
 variant formula::execute(formula_debugger *fdb) const
 {
 	static map_formula_callable null_callable;
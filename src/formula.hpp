@@ -13,6 +13,7 @@
 #ifndef FORMULA_HPP_INCLUDED
 #define FORMULA_HPP_INCLUDED
 
+#include "formula_bytecode.hpp"
 #include "formula_debugger_fwd.hpp"
 #include "formula_fwd.hpp"
 #include "formula_tokenizer.hpp"
@@ -57,20 +58,64 @@ public:
 	}
 
 	static formula_ptr create_optional_formula(const std::string& str, function_symbol_table* symbols=NULL);
+
+	/**
+	 * The formula parsed from @a str with @a symbols, shared with earlier
+	 * calls with the same text and table, in every scenario; see
+	 * formula_cache. Throws formula_error like the constructor.
+	 */
+	static const_formula_ptr get_cached(const std::string& str, function_symbol_table* symbols=NULL);
+
 	explicit formula(const std::string& str, function_symbol_table* symbols=NULL);
 	explicit formula(const formula_tokenizer::token* i1, const formula_tokenizer::token* i2, function_symbol_table* symbols=NULL);
 	const std::string& str() const { return str_; }
 
+	/**
+	 * Evaluates the expression tree instead of the compiled program, like
+	 * the debugger does. Only meant for comparing the two.
+	 */
+	variant evaluate_tree(const formula_callable& variables) const;
+
 private:
 	variant execute(const formula_callable& variables, formula_debugger *fdb = NULL) const;
 	variant execute(formula_debugger *fdb) const;
-	formula() : expr_(), str_()
+	formula() : expr_(), code_(), str_()
    	{}
 	expression_ptr expr_;
+	formula_bytecode code_;
 	std::string str_;
 	friend class formula_debugger;
 };
 
+/**
+ * The formulas shared by formula::get_cached().
+ *
+ * They are keyed by their text and their function table; a table dropping
+ * out of use, or getting new functions, makes its formulas unreachable.
+ * Formulas defining functions are not cached, as parsing them adds to the
+ * table. At most max_entries formulas of max_text_size characters in all
+ * are kept, the least recently used one being dropped first.
+ */
+namespace formula_cache {
+	static const size_t max_entries = 1024;
+	static const size_t max_text_size = 256 * 1024;
+
+	/** Forgets all the formulas, or those parsed with @a symbols. */
+	void clear();
+	void clear(const function_symbol_table* symbols);
+
+	struct statistics
+	{
+		statistics() : hits(0), misses(0), uncached(0), entries(0), text_size(0) {}
+		/** Lookups finding a formula, and those having to parse one. */
+		size_t hits, misses;
+		/** Parsed formulas that could not be kept. */
+		size_t uncached;
+		size_t entries, text_size;
+	};
+	statistics get_statistics();
+}
+
 struct formula_error : public game::error
 {
 	formula_error()
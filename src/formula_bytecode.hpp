@@ -0,0 +1,137 @@
+/*
+   Copyright (C) 2015 by the Battle for Wesnoth Project
+   Part of the Battle for Wesnoth Project http://www.wesnoth.org/
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY.
+
+   See the COPYING file for more details.
+*/
+
+/**
+ * @file
+ * Formula expression trees lowered to a stack machine program.
+ */
+
+#ifndef FORMULA_BYTECODE_HPP_INCLUDED
+#define FORMULA_BYTECODE_HPP_INCLUDED
+
+#include "formula_callable.hpp"
+#include "variant.hpp"
+
+#include <boost/shared_ptr.hpp>
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace game_logic
+{
+
+class formula_expression;
+typedef boost::shared_ptr<formula_expression> expression_ptr;
+
+/**
+ * The program a formula runs instead of walking its expression tree.
+ *
+ * Operators, literals, lists, maps, identifiers, indexing, '.' and 'where'
+ * become instructions; constant operands are folded while compiling.
+ * Anything else, most notably function calls (which decide themselves how
+ * and in which scope to evaluate their arguments), stays an expression
+ * that is evaluated as before. Such functions were already resolved when
+ * the formula got parsed, so the program just keeps a pointer to them.
+ *
+ * The results are the same as those of the tree, including errors, since
+ * both use the same variant operations. The program does not own the
+ * expressions it refers to; the formula it belongs to does.
+ *
+ * Defined in formula.cpp, together with the expressions it is compiled from.
+ */
+class formula_bytecode
+{
+public:
+	enum opcode {
+		CONSTANT,    /**< pushes constants_[arg] */
+		IDENTIFIER,  /**< pushes the value of identifiers_[arg] */
+		EXPRESSION,  /**< pushes the result of expressions_[arg] */
+		LIST,        /**< replaces the top arg values by a list of them */
+		MAP,         /**< replaces the top 2*arg values by a map of the pairs */
+		NOT, NEGATE,
+		AND, OR, ADD, SUB, MUL, DIV, MOD, POW, ADDL, SUBL, MULL, DIVL,
+		EQ, NEQ, LT, GT, LTE, GTE, DICE,
+		INDEX,       /**< replaces container and key by the element */
+		DOT,         /**< runs programs_[arg] in the scope of the top value */
+		WHERE        /**< runs programs_[arg] with the where_clauses_[arg] */
+	};
+
+	formula_bytecode();
+
+	/** Compiles the expression tree @a expr. */
+	explicit formula_bytecode(const formula_expression& expr);
+
+	variant run(const formula_callable& variables) const;
+
+	/** The number of instructions, 0 until something got compiled. */
+	size_t size() const { return code_.size(); }
+
+	/** The value of the program if it is a constant, NULL otherwise. */
+	const variant* constant() const
+	{
+		return code_.size() == 1 && code_.front().op == CONSTANT ? &constants_[code_.front().arg] : NULL;
+	}
+
+	/** @name Used by formula_expression::compile(). */
+	//@{
+	/**
+	 * Emits the code of @a expr, or an EXPRESSION instruction if @a expr
+	 * cannot be compiled.
+	 */
+	void compile(const formula_expression& expr);
+
+	void emit_constant(const variant& value);
+	void emit_identifier(const formula_key& id);
+	/** Emits an instruction without an operand, folding constants. */
+	void emit(opcode op);
+	void emit_list(unsigned size);
+	void emit_map(unsigned size);
+	void emit_dot(const formula_expression& right);
+	void emit_where(const formula_expression& body,
+			const boost::shared_ptr<std::map<std::string, expression_ptr> >& clauses);
+	//@}
+
+	/** Applies the operator @a op; shared with the expression tree. */
+	static variant apply(opcode op, const variant& left, const variant& right);
+
+private:
+	struct instruction {
+		instruction(opcode o, unsigned a) : op(o), arg(a) {}
+		opcode op;
+		unsigned arg;
+	};
+
+	void push(opcode op, unsigned arg, int depth_change);
+
+	/** Whether the last @a n instructions are constants. */
+	bool constants_on_top(unsigned n) const;
+
+	/** Removes the last @a n (constant) instructions and returns their values. */
+	std::vector<variant> pop_constants(unsigned n);
+
+	std::vector<instruction> code_;
+	std::vector<variant> constants_;
+	std::vector<formula_key> identifiers_;
+	std::vector<const formula_expression*> expressions_;
+	std::vector<boost::shared_ptr<formula_bytecode> > programs_;
+	std::vector<boost::shared_ptr<std::map<std::string, expression_ptr> > > where_clauses_;
+
+	/** The stack depth, while compiling, and the largest one. */
+	int depth_, max_depth_;
+};
+
+}
+
+#endif
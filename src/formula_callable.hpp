@@ -18,9 +18,56 @@
 #include "reference_counted_object.hpp"
 #include "variant.hpp"
 
+#include <utility>
+#include <vector>
+
 namespace game_logic
 {
 
+/**
+ * The name of an attribute, interned when the formula using it is parsed.
+ *
+ * The same name always gets the same small id, so callables can look up
+ * their attributes by index rather than comparing strings. The names are
+ * never released; they are the identifiers found in formulas, so there are
+ * not many of them.
+ */
+class formula_key {
+public:
+	explicit formula_key(const std::string& name);
+
+	size_t id() const { return id_; }
+	const std::string& name() const { return *name_; }
+
+	/** The id of "self", which is interned first. */
+	static const size_t self_id = 0;
+
+private:
+	size_t id_;
+	const std::string* name_;
+};
+
+/**
+ * Maps keys to the index of the attribute in the list of names of a
+ * callable, or -1 for unknown keys.
+ */
+class formula_key_table {
+public:
+	/** @param names                 The attribute names, terminated by NULL. */
+	explicit formula_key_table(const char* const* names);
+
+	int find(const formula_key& key) const {
+		return key.id() < by_id_.size() ? by_id_[key.id()] : -1;
+	}
+
+	/** The same for a key which was not interned. */
+	int find(const std::string& name) const;
+
+private:
+	std::vector<int> by_id_;
+	std::vector<std::pair<std::string, int> > by_name_;
+};
+
 enum FORMULA_ACCESS_TYPE { FORMULA_READ_ONLY, FORMULA_WRITE_ONLY, FORMULA_READ_WRITE };
 struct formula_input {
 	std::string name;
@@ -43,6 +90,13 @@ public:
 		return get_value(key);
 	}
 
+	variant query_value(const formula_key& key) const {
+		if(has_self_ && key.id() == formula_key::self_id) {
+			return variant(this);
+		}
+		return get_key_value(key);
+	}
+
 	void mutate_value(const std::string& key, const variant& value) {
 		set_value(key, value);
 	}
@@ -99,6 +153,15 @@ protected:
 	TYPE type_;
 private:
 	virtual variant get_value(const std::string& key) const = 0;
+
+	/**
+	 * get_value() for an interned key; callables with many attributes
+	 * override it to dispatch on formula_key_table::find().
+	 */
+	virtual variant get_key_value(const formula_key& key) const {
+		return get_value(key.name());
+	}
+
 	bool has_self_;
 };
 
@@ -122,6 +185,15 @@ class formula_callable_with_backup : public formula_callable {
 		return var;
 	}
 
+	variant get_key_value(const formula_key& key) const {
+		variant var = main_.query_value(key);
+		if(var.is_null()) {
+			return backup_.query_value(key);
+		}
+
+		return var;
+	}
+
 	void get_inputs(std::vector<formula_input>* inputs) const {
 		main_.get_inputs(inputs);
 		backup_.get_inputs(inputs);
@@ -143,6 +215,15 @@ class formula_variant_callable_with_backup : public formula_callable {
 		return var;
 	}
 
+	variant get_key_value(const formula_key& key) const {
+		variant var = var_.get_member(key.name());
+		if(var.is_null()) {
+			return backup_.query_value(key);
+		}
+
+		return var;
+	}
+
 	void get_inputs(std::vector<formula_input>* inputs) const {
 		backup_.get_inputs(inputs);
 	}
@@ -167,6 +248,7 @@ public:
 
 private:
 	variant get_value(const std::string& key) const;
+	variant get_key_value(const formula_key& key) const;
 	void get_inputs(std::vector<formula_input>* inputs) const;
 	void set_value(const std::string& key, const variant& value);
 	std::map<std::string,variant> values_;
@@ -25,9 +25,7 @@
 #include <boost/math/constants/constants.hpp>
 using namespace boost::math::constants;
 
-#ifdef HAVE_VISUAL_LEAK_DETECTOR
-#include "vld.h"
-#endif
+#include <algorithm>
 
 
 static lg::log_domain log_engine("engine");
@@ -672,6 +670,47 @@ private:
 	}
 };
 
+/**
+ * The elements of a list or a map as iterating over it gives them: the
+ * items of a list, a key_value_pair for each element of a map, and nothing
+ * for the other values.
+ *
+ * Unlike variant_iterator, it gives the key and the value of an element of
+ * a map without making the pair again and looking them up in it, as map
+ * and filter did for every element. The maps are copied to two lists once
+ * for this.
+ */
+class elements
+{
+public:
+	explicit elements(const variant& items)
+		: map_(items.is_map())
+		, values_(map_ ? items.get_values() : items)
+		, keys_(map_ ? items.get_keys() : variant())
+		, size_(map_ || items.is_list() ? items.num_elements() : 0)
+	{
+	}
+
+	bool is_map() const { return map_; }
+	size_t size() const { return size_; }
+
+	/** The @a n-th element, as dereferencing a variant_iterator would give it. */
+	variant operator[](size_t n) const
+	{
+		return map_ ? variant(new key_value_pair(keys_[n], values_[n])) : values_[n];
+	}
+
+	/** The key of the @a n-th element of a map. */
+	const variant& key(size_t n) const { return keys_[n]; }
+	/** The value of the @a n-th element of a map, the @a n-th item of a list. */
+	const variant& value(size_t n) const { return values_[n]; }
+
+private:
+	bool map_;
+	variant values_, keys_;
+	size_t size_;
+};
+
 class filter_function : public function_expression {
 public:
 	explicit filter_function(const args_list& args)
@@ -682,30 +721,31 @@ private:
 		std::vector<variant> list_vars;
 		std::map<variant,variant> map_vars;
 
-		const variant items = args()[0]->evaluate(variables,fdb);
+		const elements items(args()[0]->evaluate(variables,fdb));
 
 		if(args().size() == 2) {
-			for(variant_iterator it = items.begin(); it != items.end(); ++it)  {
-				const variant val = args()[1]->evaluate(formula_variant_callable_with_backup(*it, variables),fdb);
+			for(size_t n = 0; n != items.size(); ++n) {
+				const variant val = args()[1]->evaluate(formula_variant_callable_with_backup(items[n], variables),fdb);
 				if(val.as_bool()) {
 					if (items.is_map() )
-						map_vars[ (*it).get_member("key") ] = (*it).get_member("value");
+						map_vars.insert(map_vars.end(), std::make_pair(items.key(n), items.value(n)));
 					else
-						list_vars.push_back(*it);
+						list_vars.push_back(items.value(n));
 				}
 			}
 		} else {
 			map_formula_callable self_callable;
 			self_callable.add_ref();
 			const std::string self = args()[1]->evaluate(variables,fdb).as_string();
-			for(variant_iterator it = items.begin(); it != items.end(); ++it) {
-				self_callable.add(self, *it);
-				const variant val = args()[2]->evaluate(formula_callable_with_backup(self_callable, formula_variant_callable_with_backup(*it, variables)),fdb);
+			for(size_t n = 0; n != items.size(); ++n) {
+				const variant item = items[n];
+				self_callable.add(self, item);
+				const variant val = args()[2]->evaluate(formula_callable_with_backup(self_callable, formula_variant_callable_with_backup(item, variables)),fdb);
 				if(val.as_bool()) {
 					if (items.is_map() )
-						map_vars[ (*it).get_member("key") ] = (*it).get_member("value");
+						map_vars.insert(map_vars.end(), std::make_pair(items.key(n), items.value(n)));
 					else
-						list_vars.push_back(*it);
+						list_vars.push_back(items.value(n));
 				}
 			}
 		}
@@ -758,13 +798,15 @@ private:
 	variant execute(const formula_callable& variables, formula_debugger *fdb) const {
 		std::vector<variant> list_vars;
 		std::map<variant,variant> map_vars;
-		const variant items = args()[0]->evaluate(variables,fdb);
+		const elements items(args()[0]->evaluate(variables,fdb));
+		if (!items.is_map() )
+			list_vars.reserve(items.size());
 
 		if(args().size() == 2) {
-			for(variant_iterator it = items.begin(); it != items.end(); ++it) {
-				const variant val = args().back()->evaluate(formula_variant_callable_with_backup(*it, variables),fdb);
+			for(size_t n = 0; n != items.size(); ++n) {
+				const variant val = args().back()->evaluate(formula_variant_callable_with_backup(items[n], variables),fdb);
 				if (items.is_map() )
-					map_vars[ (*it).get_member("key") ] = val;
+					map_vars.insert(map_vars.end(), std::make_pair(items.key(n), val));
 				else
 					list_vars.push_back(val);
 			}
@@ -772,11 +814,12 @@ private:
 			map_formula_callable self_callable;
 			self_callable.add_ref();
 			const std::string self = args()[1]->evaluate(variables,fdb).as_string();
-			for(variant_iterator it = items.begin(); it != items.end(); ++it) {
-				self_callable.add(self, *it);
-				const variant val = args().back()->evaluate(formula_callable_with_backup(self_callable, formula_variant_callable_with_backup(*it, variables)),fdb);
+			for(size_t n = 0; n != items.size(); ++n) {
+				const variant item = items[n];
+				self_callable.add(self, item);
+				const variant val = args().back()->evaluate(formula_callable_with_backup(self_callable, formula_variant_callable_with_backup(item, variables)),fdb);
 				if (items.is_map() )
-					map_vars[ (*it).get_member("key") ] = val;
+					map_vars.insert(map_vars.end(), std::make_pair(items.key(n), val));
 				else
 					list_vars.push_back(val);
 			}
@@ -851,12 +894,43 @@ private:
 			}
 		}
 
-		for(size_t n = 0; n != items.num_elements(); ++n) {
+		const size_t size = items.num_elements();
+		if(items.is_list() && size > 0) {
+			// Adding the items one by one is slow for the most common sums:
+			// numbers make a variant per item, and lists are copied whole.
+			const std::vector<variant>& list = items.as_list();
+			if(res.is_int() && all_of_type(list, &variant::is_int)) {
+				int sum = res.as_int();
+				BOOST_FOREACH(const variant& item, list) {
+					sum += item.as_int();
+				}
+				return variant(sum);
+			}
+			if(res.is_list() && all_of_type(list, &variant::is_list)) {
+				std::vector<variant> sum(res.as_list());
+				BOOST_FOREACH(const variant& item, list) {
+					sum.insert(sum.end(), item.as_list().begin(), item.as_list().end());
+				}
+				return variant(&sum);
+			}
+		}
+
+		for(size_t n = 0; n != size; ++n) {
 			res = res + items[n];
 		}
 
 		return res;
 	}
+
+	static bool all_of_type(const std::vector<variant>& list, bool (variant::*is_type)() const)
+	{
+		BOOST_FOREACH(const variant& item, list) {
+			if(!(item.*is_type)()) {
+				return false;
+			}
+		}
+		return true;
+	}
 };
 
 class head_function : public function_expression {
@@ -1006,6 +1080,17 @@ public:
 	explicit loc_function(const args_list& args)
 	  : function_expression("loc", args, 2, 2)
 	{}
+
+	/** The location of constant coordinates is made once, here. */
+	bool compile(formula_bytecode& code) const {
+		const variant* x = constant_arg(0);
+		const variant* y = constant_arg(1);
+		if(!x || !y || !x->is_int() || !y->is_int()) {
+			return false;
+		}
+		code.emit_constant(variant(new location_callable(map_location(x->as_int() - 1, y->as_int() - 1))));
+		return true;
+	}
 private:
 	variant execute(const formula_callable& variables, formula_debugger *fdb) const {
 		return variant(new location_callable(map_location(
@@ -1084,9 +1169,15 @@ function_expression_ptr formula_function::generate_function_expression(const std
 	return function_expression_ptr(new formula_function_expression(name_, args, formula_, precondition_, args_));
 }
 
+function_symbol_table::~function_symbol_table()
+{
+	formula_cache::clear(this);
+}
+
 void function_symbol_table::add_formula_function(const std::string& name, const_formula_ptr formula, const_formula_ptr precondition, const std::vector<std::string>& args)
 {
 	custom_formulas_[name] = formula_function(name, formula, precondition, args);
+	++generation_;
 }
 
 expression_ptr function_symbol_table::create_function(const std::string& fn, const std::vector<expression_ptr>& args) const
@@ -1110,78 +1201,73 @@ std::vector<std::string> function_symbol_table::get_function_names() const
 
 namespace {
 
-class base_function_creator {
-public:
-	virtual expression_ptr create_function(const std::vector<expression_ptr>& args) const = 0;
-	virtual ~base_function_creator() {}
-};
+typedef expression_ptr (*function_creator)(const std::vector<expression_ptr>& args);
 
 template<typename T>
-class function_creator : public base_function_creator {
-public:
-	virtual expression_ptr create_function(const std::vector<expression_ptr>& args) const {
-		return expression_ptr(new T(args));
-	}
-	virtual ~function_creator() {}
+expression_ptr create_builtin(const std::vector<expression_ptr>& args)
+{
+	return expression_ptr(new T(args));
+}
+
+struct builtin_function
+{
+	const char* name;
+	function_creator create;
 };
 
-typedef std::map<std::string, base_function_creator*> functions_map;
-
-functions_map& get_functions_map() {
-
-	static functions_map functions_table;
-
-#ifdef HAVE_VISUAL_LEAK_DETECTOR
-	VLDDisable();
-#endif
-
-	if(functions_table.empty()) {
-#define FUNCTION(name) functions_table[#name] = new function_creator<name##_function>();
-		FUNCTION(debug);
-		FUNCTION(dir);
-		FUNCTION(if);
-		FUNCTION(switch);
-		FUNCTION(abs);
-		FUNCTION(min);
-		FUNCTION(max);
-		FUNCTION(choose);
-                FUNCTION(debug_float);
-		FUNCTION(debug_print);
-		FUNCTION(wave);
-		FUNCTION(sort);
-		FUNCTION(contains_string);
-		FUNCTION(filter);
-		FUNCTION(find);
-		FUNCTION(map);
-		FUNCTION(reduce);
-		FUNCTION(sum);
-		FUNCTION(head);
-		FUNCTION(size);
-		FUNCTION(null);
-		FUNCTION(ceil);
-		FUNCTION(floor);
-		FUNCTION(round);
-		FUNCTION(as_decimal);
-		FUNCTION(refcount);
-		FUNCTION(loc);
-		FUNCTION(index_of);
-		FUNCTION(keys);
-		FUNCTION(values);
-		FUNCTION(tolist);
-		FUNCTION(tomap);
-		FUNCTION(substring);
-		FUNCTION(length);
-		FUNCTION(concatenate);
-		FUNCTION(sin);
-		FUNCTION(cos);
+/**
+ * The builtin functions, sorted by name for the lookups. A constant table
+ * needs neither building nor locking, and is searched without comparing
+ * std::strings.
+ */
+#define FUNCTION(name) { #name, &create_builtin<name##_function> }
+const builtin_function builtin_functions[] = {
+	FUNCTION(abs),
+	FUNCTION(as_decimal),
+	FUNCTION(ceil),
+	FUNCTION(choose),
+	FUNCTION(concatenate),
+	FUNCTION(contains_string),
+	FUNCTION(cos),
+	FUNCTION(debug),
+	FUNCTION(debug_float),
+	FUNCTION(debug_print),
+	FUNCTION(dir),
+	FUNCTION(filter),
+	FUNCTION(find),
+	FUNCTION(floor),
+	FUNCTION(head),
+	FUNCTION(if),
+	FUNCTION(index_of),
+	FUNCTION(keys),
+	FUNCTION(length),
+	FUNCTION(loc),
+	FUNCTION(map),
+	FUNCTION(max),
+	FUNCTION(min),
+	FUNCTION(null),
+	FUNCTION(reduce),
+	FUNCTION(refcount),
+	FUNCTION(round),
+	FUNCTION(sin),
+	FUNCTION(size),
+	FUNCTION(sort),
+	FUNCTION(substring),
+	FUNCTION(sum),
+	FUNCTION(switch),
+	FUNCTION(tolist),
+	FUNCTION(tomap),
+	FUNCTION(values),
+	FUNCTION(wave),
+};
 #undef FUNCTION
-	}
 
-#ifdef HAVE_VISUAL_LEAK_DETECTOR
-	VLDEnable();
-#endif
+const builtin_function* const builtin_functions_end =
+	builtin_functions + sizeof(builtin_functions) / sizeof(*builtin_functions);
 
-	return functions_table;
+bool builtin_less(const builtin_function& f, const std::string& name)
+{
+	return name.compare(f.name) > 0;
 }
 
 }
@@ -1199,20 +1285,20 @@ expression_ptr create_function(const std::string& fn,
 
 	//DBG_NG << "FN: '" << fn << "' " << fn.size() << "\n";
 
-	functions_map::const_iterator i = get_functions_map().find(fn);
-	if(i == get_functions_map().end()) {
+	const builtin_function* i = std::lower_bound(builtin_functions,
+		builtin_functions_end, fn, builtin_less);
+	if(i == builtin_functions_end || fn != i->name) {
 		throw formula_error("Unknow function: " + fn, "", "", 0);
 	}
 
-	return i->second->create_function(args);
+	return i->create(args);
 }
 
 std::vector<std::string> builtin_function_names()
 {
 	std::vector<std::string> res;
-	const functions_map& m = get_functions_map();
-	for(functions_map::const_iterator i = m.begin(); i != m.end(); ++i) {
-		res.push_back(i->first);
+	for(const builtin_function* i = builtin_functions; i != builtin_functions_end; ++i) {
+		res.push_back(i->name);
 	}
 
 	return res;
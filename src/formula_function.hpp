@@ -17,6 +17,7 @@
 #define FORMULA_FUNCTION_HPP_INCLUDED
 
 #include "formula.hpp"
+#include "formula_bytecode.hpp"
 #include "formula_callable.hpp"
 
 namespace game_logic {
@@ -37,14 +38,53 @@ public:
 
 	const char* get_name() const { return name_; }
 	virtual std::string str() const = 0;
+
+	/**
+	 * Emits the instructions computing this expression to @a code.
+	 * Returns false (without emitting anything) if it needs to be evaluated
+	 * as an expression.
+	 */
+	virtual bool compile(formula_bytecode& /*code*/) const { return false; }
 private:
 	virtual variant execute(const formula_callable& variables, formula_debugger *fdb = NULL) const = 0;
 	const char* name_;
 	friend class formula_debugger;
+	friend class compiled_expression;
 };
 
 typedef boost::shared_ptr<formula_expression> expression_ptr;
 
+/**
+ * An expression that runs its bytecode when evaluated, except for the
+ * debugger, which gets to walk the tree as usual.
+ *
+ * The arguments of functions, and the clauses of 'where', are evaluated by
+ * whoever uses them instead of by the program of the formula, so they are
+ * wrapped in one.
+ */
+class compiled_expression : public formula_expression {
+public:
+	/** Returns @a expr wrapped, unless it already is. */
+	static expression_ptr wrap(const expression_ptr& expr);
+
+	virtual std::string str() const { return expr_->str(); }
+
+	/** The value of the expression if it is a constant, NULL otherwise. */
+	const variant* constant() const { return code_.constant(); }
+
+	/** Inlines the expression, when part of another program. */
+	virtual bool compile(formula_bytecode& code) const
+	{
+		code.compile(*expr_);
+		return true;
+	}
+private:
+	explicit compiled_expression(const expression_ptr& expr);
+	virtual variant execute(const formula_callable& variables, formula_debugger *fdb) const;
+	expression_ptr expr_;
+	formula_bytecode code_;
+};
+
 class function_expression : public formula_expression {
 public:
 	typedef std::vector<expression_ptr> args_list;
@@ -55,6 +95,9 @@ public:
 	    : name_(name), args_(args)
 	{
 		set_name(name.c_str());
+		for(args_list::iterator i = args_.begin(); i != args_.end(); ++i) {
+			*i = compiled_expression::wrap(*i);
+		}
 		if(min_args >= 0 && args_.size() < static_cast<size_t>(min_args)) {
 			throw formula_error("Too few arguments", "", "", 0);
 		}
@@ -66,6 +109,15 @@ public:
 	virtual std::string str() const;
 protected:
 	const args_list& args() const { return args_; }
+
+	/**
+	 * The value of the @a n-th argument if it is a constant, NULL otherwise,
+	 * for the functions computing their result once when compiled.
+	 */
+	const variant* constant_arg(size_t n) const
+	{
+		return static_cast<const compiled_expression&>(*args_[n]).constant();
+	}
 private:
 	std::string name_;
 	args_list args_;
@@ -117,17 +169,22 @@ public:
 
 class function_symbol_table {
 	std::map<std::string, formula_function> custom_formulas_;
+	size_t generation_;
 public:
 	function_symbol_table() :
-		custom_formulas_()
+		custom_formulas_(),
+		generation_(0)
 	{
 	}
 
-	virtual ~function_symbol_table() {}
+	virtual ~function_symbol_table();
 	virtual void add_formula_function(const std::string& name, const_formula_ptr formula, const_formula_ptr precondition, const std::vector<std::string>& args);
 	virtual expression_ptr create_function(const std::string& fn,
 					                       const std::vector<expression_ptr>& args) const;
 	std::vector<std::string> get_function_names() const;
+
+	/** Changes whenever a function is added, for formula_cache. */
+	size_t generation() const { return generation_; }
 };
 
 expression_ptr create_function(const std::string& fn,
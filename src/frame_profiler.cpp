@@ -0,0 +1,215 @@
+/*
+   Copyright (C) 2015 by the Battle for Wesnoth Project
+   Part of the Battle for Wesnoth Project http://www.wesnoth.org/
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY.
+
+   See the COPYING file for more details.
+*/
+
+#include "global.hpp"
+
+#include "frame_profiler.hpp"
+
+#include "filesystem.hpp"
+#include "image.hpp"
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/foreach.hpp>
+
+#include <algorithm>
+#include <iomanip>
+#include <ostream>
+#include <sstream>
+
+namespace {
+
+const char* const phase_names[frame_profiler::PHASE_COUNT] = {
+	"invalidation", "terrain", "units", "halos", "commit", "reports", "minimap", "flip"
+};
+
+boost::posix_time::ptime now()
+{
+	return boost::posix_time::microsec_clock::universal_time();
+}
+
+size_t image_cache_misses()
+{
+	size_t misses = 0;
+	BOOST_FOREACH(const image::cache_stats& stats, image::cache_statistics()) {
+		misses += stats.misses;
+	}
+	return misses;
+}
+
+}
+
+const int frame_profiler::bucket_count;
+const int frame_profiler::bucket_limits[bucket_count - 1] = { 4, 8, 16, 33, 66 };
+
+frame_profiler::frame_profiler()
+	: enabled_(false)
+	, frame_start_()
+	, frames_(0)
+	, total_frame_(0)
+	, longest_frame_(0)
+	, hexes_(0)
+	, blits_(0)
+	, cache_misses_(0)
+	, last_cache_misses_(0)
+	, frame_number_(0)
+	, csv_()
+{
+	std::fill(frame_phases_, frame_phases_ + PHASE_COUNT, 0);
+	reset_statistics();
+}
+
+frame_profiler::~frame_profiler()
+{
+}
+
+bool frame_profiler::start(const std::string& csv_file)
+{
+	enabled_ = true;
+	frame_number_ = 0;
+	last_cache_misses_ = image_cache_misses();
+	reset_statistics();
+
+	csv_.reset();
+	if(csv_file.empty()) {
+		return true;
+	}
+
+	try {
+		csv_.reset(filesystem::ostream_file(csv_file));
+	} catch(filesystem::io_exception&) {
+		return false;
+	}
+	if(!csv_->good()) {
+		csv_.reset();
+		return false;
+	}
+
+	*csv_ << "frame,total";
+	for(int phase = 0; phase != PHASE_COUNT; ++phase) {
+		*csv_ << ',' << phase_names[phase];
+	}
+	*csv_ << ",hexes,blits,cache_misses\n";
+	return true;
+}
+
+void frame_profiler::stop()
+{
+	enabled_ = false;
+	csv_.reset();
+}
+
+void frame_profiler::begin_frame()
+{
+	if(!enabled_) {
+		return;
+	}
+	std::fill(frame_phases_, frame_phases_ + PHASE_COUNT, 0);
+	frame_start_ = now();
+}
+
+void frame_profiler::end_frame(size_t hexes, size_t blits)
+{
+	if(!enabled_ || frame_start_.is_not_a_date_time()) {
+		return;
+	}
+
+	const long frame = (now() - frame_start_).total_microseconds();
+	frame_start_ = boost::posix_time::ptime();
+
+	const size_t misses = image_cache_misses();
+	const size_t frame_misses = misses - last_cache_misses_;
+	last_cache_misses_ = misses;
+
+	++frames_;
+	total_frame_ += frame;
+	longest_frame_ = std::max(longest_frame_, frame);
+	for(int phase = 0; phase != PHASE_COUNT; ++phase) {
+		total_[phase] += frame_phases_[phase];
+		longest_[phase] = std::max(longest_[phase], frame_phases_[phase]);
+	}
+	const int* bucket = std::upper_bound(bucket_limits, bucket_limits + bucket_count - 1, frame / 1000);
+	++histogram_[bucket - bucket_limits];
+	hexes_ += hexes;
+	blits_ += blits;
+	cache_misses_ += frame_misses;
+
+	if(csv_) {
+		*csv_ << frame_number_ << ',' << frame;
+		for(int phase = 0; phase != PHASE_COUNT; ++phase) {
+			*csv_ << ',' << frame_phases_[phase];
+		}
+		*csv_ << ',' << hexes << ',' << blits << ',' << frame_misses << '\n';
+	}
+	++frame_number_;
+}
+
+frame_profiler::timer::timer(frame_profiler& profiler, PHASE phase)
+	: profiler_(profiler)
+	, phase_(phase)
+	, start_()
+{
+	if(profiler_.enabled_) {
+		start_ = now();
+	}
+}
+
+frame_profiler::timer::~timer()
+{
+	if(profiler_.enabled_ && !start_.is_not_a_date_time()) {
+		profiler_.frame_phases_[phase_] += (now() - start_).total_microseconds();
+	}
+}
+
+std::string frame_profiler::report()
+{
+	std::ostringstream stream;
+	if(frames_ == 0) {
+		return stream.str();
+	}
+
+	stream << std::fixed << std::setprecision(2);
+	stream << "frame (ms): " << total_frame_ / 1000.0 / frames_
+		<< " avg, " << longest_frame_ / 1000.0 << " max\n";
+	for(int phase = 0; phase != PHASE_COUNT; ++phase) {
+		stream << "  " << phase_names[phase] << ": " << total_[phase] / 1000.0 / frames_
+			<< ", " << longest_[phase] / 1000.0 << "\n";
+	}
+
+	stream << "frames under";
+	for(int bucket = 0; bucket != bucket_count - 1; ++bucket) {
+		stream << ' ' << bucket_limits[bucket] << "ms: " << histogram_[bucket];
+	}
+	stream << ", slower: " << histogram_[bucket_count - 1] << "\n";
+
+	stream << std::setprecision(1)
+		<< "per frame: " << double(hexes_) / frames_ << " hexes, "
+		<< double(blits_) / frames_ << " blits, "
+		<< double(cache_misses_) / frames_ << " cache misses";
+
+	reset_statistics();
+	return stream.str();
+}
+
+void frame_profiler::reset_statistics()
+{
+	frames_ = 0;
+	std::fill(total_, total_ + PHASE_COUNT, 0);
+	std::fill(longest_, longest_ + PHASE_COUNT, 0);
+	total_frame_ = 0;
+	longest_frame_ = 0;
+	std::fill(histogram_, histogram_ + bucket_count, 0);
+	hexes_ = 0;
+	blits_ = 0;
+	cache_misses_ = 0;
+}
@@ -0,0 +1,124 @@
+/*
+   Copyright (C) 2015 by the Battle for Wesnoth Project
+   Part of the Battle for Wesnoth Project http://www.wesnoth.org/
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY.
+
+   See the COPYING file for more details.
+*/
+
+/**
+ * @file
+ * Timing of the phases of display::draw().
+ */
+
+#ifndef FRAME_PROFILER_HPP_INCLUDED
+#define FRAME_PROFILER_HPP_INCLUDED
+
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+
+#include <iosfwd>
+#include <string>
+
+/**
+ * Measures how long each phase of the frames drawn takes, along with the
+ * work done: hexes invalidated, blits and image cache misses.
+ *
+ * The frames are summed up until @ref report() is called, and each of them
+ * can also be written to a CSV file, to compare runs or machines.
+ */
+class frame_profiler : private boost::noncopyable
+{
+public:
+	enum PHASE {
+		INVALIDATION,
+		TERRAIN,
+		UNITS,
+		HALOS,
+		COMMIT,
+		REPORTS,
+		MINIMAP,
+		FLIP,
+		PHASE_COUNT
+	};
+
+	frame_profiler();
+	~frame_profiler();
+
+	bool enabled() const { return enabled_; }
+
+	/**
+	 * Starts profiling.
+	 *
+	 * @param csv_file            If not empty, each frame is appended to
+	 *                            this file.
+	 * @returns                   False if the file can't be written, the
+	 *                            profiling is started anyway.
+	 */
+	bool start(const std::string& csv_file);
+	void stop();
+
+	void begin_frame();
+
+	/**
+	 * @param hexes               The hexes invalidated during the frame.
+	 * @param blits               The blits of the drawing buffer.
+	 */
+	void end_frame(size_t hexes, size_t blits);
+
+	/** Adds the time spent in its scope to a phase of the current frame. */
+	class timer : private boost::noncopyable
+	{
+	public:
+		timer(frame_profiler& profiler, PHASE phase);
+		~timer();
+
+	private:
+		frame_profiler& profiler_;
+		PHASE phase_;
+		boost::posix_time::ptime start_;
+	};
+
+	/**
+	 * Describes the frames since the previous call: the average and
+	 * longest time of each phase, the distribution of the frame times and
+	 * the work done per frame.
+	 */
+	std::string report();
+
+private:
+	static const int bucket_count = 6;
+
+	/** The upper bounds of the frame time histogram, in milliseconds. */
+	static const int bucket_limits[bucket_count - 1];
+
+	bool enabled_;
+
+	/** When the frame began and the time of its phases, in microseconds. */
+	boost::posix_time::ptime frame_start_;
+	long frame_phases_[PHASE_COUNT];
+
+	/** The statistics of the frames since the last report. */
+	unsigned frames_;
+	long total_[PHASE_COUNT], longest_[PHASE_COUNT];
+	long total_frame_, longest_frame_;
+	unsigned histogram_[bucket_count];
+	size_t hexes_, blits_, cache_misses_;
+
+	/** The image cache misses counted at the end of the previous frame. */
+	size_t last_cache_misses_;
+
+	unsigned frame_number_;
+	boost::scoped_ptr<std::ostream> csv_;
+
+	void reset_statistics();
+};
+
+#endif
@@ -0,0 +1,274 @@
+/*
+   Copyright (C) 2015 by the Battle for Wesnoth Project
+   Part of the Battle for Wesnoth Project http://www.wesnoth.org/
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY.
+
+   See the COPYING file for more details.
+*/
+
+/**
+ * @file
+ * A read-only copy of a config tree, stored compactly.
+ */
+
+#include "frozen_config.hpp"
+
+#include "tstring.hpp"
+
+#include <boost/foreach.hpp>
+#include <boost/variant/static_visitor.hpp>
+
+#include <algorithm>
+#include <deque>
+#include <sstream>
+
+namespace {
+
+/** A string identifying an attribute value and its type, to intern it. */
+class value_identity : public boost::static_visitor<std::string>
+{
+public:
+	std::string operator()(boost::blank) const
+	{ return std::string(); }
+	std::string operator()(config::attribute_value::true_false b) const
+	{ return b ? "B1" : "B0"; }
+	std::string operator()(config::attribute_value::yes_no b) const
+	{ return b ? "Y1" : "Y0"; }
+	std::string operator()(int i) const
+	{ return number('I', i); }
+	std::string operator()(unsigned long long u) const
+	{ return number('U', u); }
+	std::string operator()(double d) const
+	{
+		std::ostringstream res;
+		res.precision(17);
+		res << 'D' << d;
+		return res.str();
+	}
+	std::string operator()(const std::string& s) const
+	{ return 'S' + s; }
+	std::string operator()(const t_string& s) const
+	{ return 'T' + s.to_serialized(); }
+
+private:
+	template <typename T>
+	static std::string number(char type, T value)
+	{
+		std::ostringstream res;
+		res << type << value;
+		return res.str();
+	}
+};
+
+}
+
+frozen_config::frozen_config(const config& cfg)
+	: strings_()
+	, string_ids_()
+	, values_()
+	, nodes_()
+	, attributes_()
+	, ordered_()
+	, by_tag_()
+{
+	boost::unordered_map<std::string, unsigned> value_ids;
+
+	// Breadth first, so that the children of a node are numbered in a row.
+	std::deque<std::pair<const config*, unsigned> > queue;
+	nodes_.push_back(node_data());
+	queue.push_back(std::make_pair(&cfg, 0u));
+
+	while(!queue.empty()) {
+		const config& current = *queue.front().first;
+		const unsigned index = queue.front().second;
+		queue.pop_front();
+
+		node_data data;
+		data.attributes_begin = attributes_.size();
+		BOOST_FOREACH(const config::attribute& a, current.attribute_range()) {
+			std::pair<boost::unordered_map<std::string, unsigned>::iterator, bool> value =
+				value_ids.insert(std::make_pair(a.second.apply_visitor(value_identity()), values_.size()));
+			if(value.second) {
+				values_.push_back(a.second);
+			}
+			const attribute_data attribute = { find_or_add_string(a.first), value.first->second };
+			attributes_.push_back(attribute);
+		}
+		data.attributes_end = attributes_.size();
+
+		data.children_begin = ordered_.size();
+		BOOST_FOREACH(const config::any_child& c, current.all_children_range()) {
+			const child_data child = { find_or_add_string(c.key), static_cast<unsigned>(nodes_.size()) };
+			ordered_.push_back(child);
+			nodes_.push_back(node_data());
+			queue.push_back(std::make_pair(&c.cfg, child.node));
+		}
+		data.children_end = ordered_.size();
+
+		// The same children, sorted by tag; stable, so that they keep their order.
+		by_tag_.insert(by_tag_.end(), ordered_.begin() + data.children_begin, ordered_.end());
+		std::stable_sort(by_tag_.begin() + data.children_begin, by_tag_.end(), &tag_less);
+
+		nodes_[index] = data;
+	}
+}
+
+bool frozen_config::tag_less(const child_data& a, const child_data& b)
+{
+	return a.tag < b.tag;
+}
+
+unsigned frozen_config::find_or_add_string(const std::string& str)
+{
+	std::pair<boost::unordered_map<std::string, unsigned>::iterator, bool> res =
+		string_ids_.insert(std::make_pair(str, static_cast<unsigned>(strings_.size())));
+	if(res.second) {
+		strings_.push_back(&res.first->first);
+	}
+	return res.first->second;
+}
+
+int frozen_config::find_string(const std::string& str) const
+{
+	const boost::unordered_map<std::string, unsigned>::const_iterator i = string_ids_.find(str);
+	return i == string_ids_.end() ? -1 : static_cast<int>(i->second);
+}
+
+frozen_config::node frozen_config::root() const
+{
+	return node(*this, 0);
+}
+
+size_t frozen_config::memory_usage() const
+{
+	return strings_.capacity() * sizeof(const std::string*)
+		+ string_ids_.size() * (sizeof(std::string) + sizeof(unsigned) + 2 * sizeof(void*))
+		+ values_.capacity() * sizeof(config::attribute_value)
+		+ nodes_.capacity() * sizeof(node_data)
+		+ attributes_.capacity() * sizeof(attribute_data)
+		+ (ordered_.capacity() + by_tag_.capacity()) * sizeof(child_data);
+}
+
+const config::attribute_value* frozen_config::node::get(const std::string& key) const
+{
+	if(!tree_) {
+		return NULL;
+	}
+	const int id = tree_->find_string(key);
+	if(id < 0) {
+		return NULL;
+	}
+	const node_data& d = data();
+	for(unsigned i = d.attributes_begin; i != d.attributes_end; ++i) {
+		const attribute_data& a = tree_->attributes_[i];
+		if(a.key == static_cast<unsigned>(id)) {
+			return &tree_->values_[a.value];
+		}
+	}
+	return NULL;
+}
+
+const config::attribute_value& frozen_config::node::operator[](const std::string& key) const
+{
+	static const config::attribute_value empty;
+	const config::attribute_value* res = get(key);
+	return res ? *res : empty;
+}
+
+std::pair<const frozen_config::child_data*, const frozen_config::child_data*>
+	frozen_config::node::tagged(const std::string& key) const
+{
+	if(!tree_) {
+		return std::pair<const child_data*, const child_data*>(NULL, NULL);
+	}
+	const child_data* begin = at(tree_->by_tag_, data().children_begin);
+	const child_data* end = at(tree_->by_tag_, data().children_end);
+	const int id = tree_->find_string(key);
+	if(id < 0) {
+		return std::make_pair(end, end);
+	}
+	const child_data wanted = { static_cast<unsigned>(id), 0 };
+	return std::equal_range(begin, end, wanted, &tag_less);
+}
+
+frozen_config::node frozen_config::node::child(const std::string& key, int n) const
+{
+	const std::pair<const child_data*, const child_data*> range = tagged(key);
+	const int count = range.second - range.first;
+	if(n < 0) {
+		n += count;
+	}
+	if(n < 0 || n >= count) {
+		return node();
+	}
+	return node(*tree_, range.first[n].node);
+}
+
+unsigned frozen_config::node::child_count(const std::string& key) const
+{
+	const std::pair<const child_data*, const child_data*> range = tagged(key);
+	return range.second - range.first;
+}
+
+unsigned frozen_config::node::all_children_count() const
+{
+	return tree_ ? data().children_end - data().children_begin : 0;
+}
+
+frozen_config::attribute_itors frozen_config::node::attribute_range() const
+{
+	if(!tree_) {
+		return attribute_itors(attribute_iterator(NULL, NULL), attribute_iterator(NULL, NULL));
+	}
+	return attribute_itors(attribute_iterator(tree_, at(tree_->attributes_, data().attributes_begin)),
+	                       attribute_iterator(tree_, at(tree_->attributes_, data().attributes_end)));
+}
+
+frozen_config::child_itors frozen_config::node::child_range(const std::string& key) const
+{
+	const std::pair<const child_data*, const child_data*> range = tagged(key);
+	return child_itors(child_iterator(tree_, range.first), child_iterator(tree_, range.second));
+}
+
+frozen_config::all_children_itors frozen_config::node::all_children_range() const
+{
+	if(!tree_) {
+		return all_children_itors(all_children_iterator(NULL, NULL), all_children_iterator(NULL, NULL));
+	}
+	return all_children_itors(all_children_iterator(tree_, at(tree_->ordered_, data().children_begin)),
+	                          all_children_iterator(tree_, at(tree_->ordered_, data().children_end)));
+}
+
+bool frozen_config::node::empty() const
+{
+	return !tree_ || (data().attributes_begin == data().attributes_end
+		&& data().children_begin == data().children_end);
+}
+
+config frozen_config::node::thaw() const
+{
+	config res;
+	if(tree_) {
+		thaw(res);
+	}
+	return res;
+}
+
+void frozen_config::node::thaw(config& cfg) const
+{
+	const node_data& d = data();
+	for(unsigned i = d.attributes_begin; i != d.attributes_end; ++i) {
+		const attribute_data& a = tree_->attributes_[i];
+		cfg[*tree_->strings_[a.key]] = tree_->values_[a.value];
+	}
+	for(unsigned i = d.children_begin; i != d.children_end; ++i) {
+		const child_data& c = tree_->ordered_[i];
+		node(*tree_, c.node).thaw(cfg.add_child(*tree_->strings_[c.tag]));
+	}
+}
@@ -0,0 +1,269 @@
+/*
+   Copyright (C) 2015 by the Battle for Wesnoth Project
+   Part of the Battle for Wesnoth Project http://www.wesnoth.org/
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY.
+
+   See the COPYING file for more details.
+*/
+
+/**
+ * @file
+ * A read-only copy of a config tree, stored compactly.
+ */
+
+#ifndef FROZEN_CONFIG_HPP_INCLUDED
+#define FROZEN_CONFIG_HPP_INCLUDED
+
+#include "config.hpp"
+
+#include <boost/noncopyable.hpp>
+#include <boost/unordered_map.hpp>
+
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * An immutable config tree held in a few flat arrays instead of one map
+ * per node and per attribute list.
+ *
+ * Keys and tags are interned, and so are the attribute values: the many
+ * "yes", small numbers and repeated strings of a game config are stored
+ * once. A node then costs 16 bytes, an attribute 8 bytes and a child 16
+ * bytes, plus the distinct strings and values.
+ *
+ * The tree is queried through frozen_config::node, which offers the const
+ * query functions of config (operator[], child(), child_range(),
+ * all_children_range(), ...) with the same meaning. Nodes are small
+ * handles that stay valid as long as the frozen_config they come from.
+ * thaw() gives back a config for code that needs one.
+ */
+class frozen_config : private boost::noncopyable
+{
+	struct node_data;
+	struct attribute_data;
+	struct child_data;
+
+public:
+	explicit frozen_config(const config& cfg);
+
+	class node;
+
+	/** An attribute, as config::attribute but referring to the frozen data. */
+	struct attribute
+	{
+		attribute(const std::string& f, const config::attribute_value& s) : first(f), second(s) {}
+		const std::string& first;
+		const config::attribute_value& second;
+	};
+
+	/** A child and its tag, as config::any_child. */
+	struct any_child;
+
+	class attribute_iterator;
+	class child_iterator;
+	class all_children_iterator;
+
+	typedef std::pair<attribute_iterator, attribute_iterator> attribute_itors;
+	typedef std::pair<child_iterator, child_iterator> child_itors;
+	typedef std::pair<all_children_iterator, all_children_iterator> all_children_itors;
+
+	/** The root of the tree. */
+	node root() const;
+
+	/** The bytes used by the frozen tree, not counting the text of the strings. */
+	size_t memory_usage() const;
+
+private:
+	/** The index of @a str among the interned strings, or -1. */
+	int find_string(const std::string& str) const;
+	unsigned find_or_add_string(const std::string& str);
+
+	struct node_data
+	{
+		/** The attributes, and the children in attributes_, ordered_ and by_tag_. */
+		unsigned attributes_begin, attributes_end;
+		unsigned children_begin, children_end;
+	};
+
+	struct attribute_data
+	{
+		unsigned key, value;
+	};
+
+	struct child_data
+	{
+		unsigned tag, node;
+	};
+
+	/** The interned keys, tags and string values, and their indices. */
+	std::vector<const std::string*> strings_;
+	boost::unordered_map<std::string, unsigned> string_ids_;
+	/** The interned attribute values. */
+	std::vector<config::attribute_value> values_;
+
+	std::vector<node_data> nodes_;
+	/** The attributes of each node, sorted by key as in config. */
+	std::vector<attribute_data> attributes_;
+	/** The children of each node in their order, and sorted by tag. */
+	std::vector<child_data> ordered_, by_tag_;
+
+	static bool tag_less(const child_data& a, const child_data& b);
+
+	/** Pointers to the elements of the arrays, NULL if they are empty. */
+	template <typename T>
+	static const T* at(const std::vector<T>& v, unsigned i)
+	{ return v.empty() ? NULL : &v[0] + i; }
+};
+
+class frozen_config::node
+{
+#ifndef HAVE_CXX11
+	struct safe_bool_impl { void nonnull() {} };
+	/** See config::safe_bool. */
+	typedef void (safe_bool_impl::*safe_bool)();
+#endif
+
+public:
+	/** An invalid node, as the config returned by a failed config::child(). */
+	node() : tree_(NULL), index_(0) {}
+
+	/** Whether the node exists, as with config. */
+#ifdef HAVE_CXX11
+	explicit operator bool() const
+	{ return tree_ != NULL; }
+#else
+	operator safe_bool() const
+	{ return tree_ != NULL ? &safe_bool_impl::nonnull : NULL; }
+#endif
+
+	/** The value of @a key, or an empty value. */
+	const config::attribute_value& operator[](const std::string& key) const;
+	/** The value of @a key, or NULL. */
+	const config::attribute_value* get(const std::string& key) const;
+	bool has_attribute(const std::string& key) const { return get(key) != NULL; }
+
+	/** The @a n-th child with tag @a key (counting from the end if negative), or an invalid node. */
+	node child(const std::string& key, int n = 0) const;
+	bool has_child(const std::string& key) const { return child_count(key) != 0; }
+	unsigned child_count(const std::string& key) const;
+	unsigned all_children_count() const;
+
+	attribute_itors attribute_range() const;
+	child_itors child_range(const std::string& key) const;
+	all_children_itors all_children_range() const;
+
+	/** Whether the node has neither attributes nor children. */
+	bool empty() const;
+
+	/** A config with the contents of the node. */
+	config thaw() const;
+
+private:
+	node(const frozen_config& tree, unsigned index) : tree_(&tree), index_(index) {}
+
+	const node_data& data() const { return tree_->nodes_[index_]; }
+
+	/** The children with tag @a key, in by_tag_. */
+	std::pair<const child_data*, const child_data*> tagged(const std::string& key) const;
+
+	void thaw(config& cfg) const;
+
+	const frozen_config* tree_;
+	unsigned index_;
+
+	friend class frozen_config;
+};
+
+struct frozen_config::any_child
+{
+	any_child(const std::string& k, const node& c) : key(k), cfg(c) {}
+	const std::string& key;
+	node cfg;
+};
+
+/** Iterates over child_data, giving the nodes they refer to. */
+class frozen_config::child_iterator
+{
+public:
+	typedef node value_type;
+	typedef std::forward_iterator_tag iterator_category;
+	typedef int difference_type;
+	typedef const node* pointer;
+	typedef const node& reference;
+
+	child_iterator(const frozen_config* tree, const child_data* i) : tree_(tree), i_(i), current_() {}
+
+	child_iterator& operator++() { ++i_; return *this; }
+	child_iterator operator++(int) { child_iterator res = *this; ++i_; return res; }
+
+	const node& operator*() const { current_ = node(*tree_, i_->node); return current_; }
+	const node* operator->() const { return &**this; }
+
+	bool operator==(const child_iterator& i) const { return i_ == i.i_; }
+	bool operator!=(const child_iterator& i) const { return i_ != i.i_; }
+
+private:
+	const frozen_config* tree_;
+	const child_data* i_;
+	mutable node current_;
+};
+
+class frozen_config::all_children_iterator
+{
+public:
+	typedef any_child value_type;
+	typedef std::forward_iterator_tag iterator_category;
+	typedef int difference_type;
+	typedef const any_child* pointer;
+	typedef any_child reference;
+
+	all_children_iterator(const frozen_config* tree, const child_data* i) : tree_(tree), i_(i) {}
+
+	all_children_iterator& operator++() { ++i_; return *this; }
+	all_children_iterator operator++(int) { all_children_iterator res = *this; ++i_; return res; }
+
+	any_child operator*() const
+	{ return any_child(*tree_->strings_[i_->tag], node(*tree_, i_->node)); }
+
+	bool operator==(const all_children_iterator& i) const { return i_ == i.i_; }
+	bool operator!=(const all_children_iterator& i) const { return i_ != i.i_; }
+
+private:
+	const frozen_config* tree_;
+	const child_data* i_;
+};
+
+class frozen_config::attribute_iterator
+{
+public:
+	typedef frozen_config::attribute value_type;
+	typedef std::forward_iterator_tag iterator_category;
+	typedef int difference_type;
+	typedef const frozen_config::attribute* pointer;
+	typedef frozen_config::attribute reference;
+
+	attribute_iterator(const frozen_config* tree, const attribute_data* i) : tree_(tree), i_(i) {}
+
+	attribute_iterator& operator++() { ++i_; return *this; }
+	attribute_iterator operator++(int) { attribute_iterator res = *this; ++i_; return res; }
+
+	frozen_config::attribute operator*() const
+	{ return frozen_config::attribute(*tree_->strings_[i_->key], tree_->values_[i_->value]); }
+
+	bool operator==(const attribute_iterator& i) const { return i_ == i.i_; }
+	bool operator!=(const attribute_iterator& i) const { return i_ != i.i_; }
+
+private:
+	const frozen_config* tree_;
+	const attribute_data* i_;
+};
+
+#endif
@@ -12,11 +12,13 @@
    See the COPYING file for more details.
 */
 
+#include "attack_prediction.hpp"
 #include "config.hpp"
 #include "game_board.hpp"
 #include "game_preferences.hpp"
 #include "log.hpp"
 #include "map.hpp"
+#include "pathfind/pathfind.hpp"
 #include "recall_list_manager.hpp"
 #include "terrain_type_data.hpp"
 #include "unit.hpp"
@@ -59,11 +61,13 @@ game_board & game_board::operator= (game_board other)
 }
 
 void game_board::new_turn(int player_num) {
-	BOOST_FOREACH (unit & i, units_) {
-		if (i.side() == player_num) {
-			i.new_turn();
-		}
+	BOOST_FOREACH (const unit_map::unit_iterator & i, units_.units_of_side(player_num)) {
+		i->new_turn();
 	}
+	// Abilities (skirmisher, hides) may depend on the time of day.
+	pathfind::reach_cache::invalidate_all();
+	// Last turn's fights are unlikely to be simulated again.
+	combat_cache::clear();
 }
 
 void game_board::end_turn(int player_num) {
@@ -277,6 +281,7 @@ boost::optional<std::string> game_board::replace_map(const gamemap & newmap) {
 	}
 
 	*map_ = newmap;
+	pathfind::reach_cache::invalidate_all();
 	return ret;
 }
 
@@ -284,6 +289,7 @@ boost::optional<std::string> game_board::replace_map(const gamemap & newmap) {
 
 void game_board::overlay_map(const gamemap & mask_map, const config & cfg, map_location loc, bool border) {
 	map_->overlay(mask_map, cfg, loc.x, loc.y, border);
+	pathfind::reach_cache::invalidate_all();
 }
 
 bool game_board::change_terrain(const map_location &loc, const std::string &t_str,
@@ -321,6 +327,7 @@ bool game_board::change_terrain(const map_location &loc, const std::string &t_st
 	}
 
 	map_->set_terrain(loc, new_t);
+	pathfind::reach_cache::invalidate(loc);
 
 	BOOST_FOREACH(const t_translation::t_terrain &ut, map_->underlying_union_terrain(loc)) {
 		preferences::encountered_terrains().insert(ut);
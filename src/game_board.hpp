@@ -36,6 +36,10 @@ namespace events {
 	class menu_handler;
 }
 
+namespace test_utils {
+	class benchmark_board;
+}
+
 /**
  *
  * Game board class.
@@ -64,6 +68,7 @@ class game_board : public display_context {
 	friend class events::menu_handler;
 	friend class game_state;
 	friend class game_lua_kernel;
+	friend class test_utils::benchmark_board; // Sets up sides and units for the pathfinding benchmark
 
 	/**
 	 * Temporary unit move structs:
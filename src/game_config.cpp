@@ -64,6 +64,8 @@ namespace game_config
 
 	int cache_compression_level = 6;
 
+	unsigned render_benchmark_frames = 0;
+
 	std::string title_music,
 			lobby_music,
 			default_victory_music,
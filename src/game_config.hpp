@@ -57,6 +57,9 @@ namespace game_config
 
 	extern int cache_compression_level;
 
+	/** The frames drawn by --render-benchmark, 0 when not benchmarking. */
+	extern unsigned render_benchmark_frames;
+
 	extern std::string path;
 	extern std::string default_preferences_path;
 
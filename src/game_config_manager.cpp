@@ -132,7 +132,8 @@ void game_config_manager::load_game_config(FORCE_RELOAD_CONFIG force_reload,
 		// Handle terrains so that they are last loaded from the core.
 		// Load every compatible addon.
 		loadscreen::start_stage("verify cache");
-		filesystem::data_tree_checksum();
+		// The add-ons are only checked along with their caches.
+		filesystem::dir_tree_checksum("data/");
 		loadscreen::start_stage("create cache");
 
 		// Start transaction so macros are shared.
@@ -393,6 +394,14 @@ void game_config_manager::load_addons_cfg()
 		}
 	}
 
+	// The add-ons only see the core macros, so they can be preprocessed
+	// together instead of one after the other.
+	std::vector<std::string> addon_main_cfgs;
+	BOOST_FOREACH(const addon_source & addon, addons_to_load) {
+		addon_main_cfgs.push_back(addon.main_cfg);
+	}
+	cache_.preprocess_in_parallel(addon_main_cfgs);
+
 	// Load the addons.
 	BOOST_FOREACH(const addon_source & addon, addons_to_load) {
 		try {
@@ -27,6 +27,11 @@
 
 #include <boost/assign.hpp>
 
+namespace {
+	/// The last version given to some variables, see variable_version().
+	size_t last_variable_version = 0;
+}
+
 static lg::log_domain log_engine("engine");
 #define ERR_NG LOG_STREAM(err, log_engine)
 #define WRN_NG LOG_STREAM(warn, log_engine)
@@ -39,6 +44,9 @@ game_data::game_data()
 		, last_selected(map_location::null_location())
 		, rng_()
 		, variables_()
+		, variable_versions_()
+		, base_version_(++last_variable_version)
+		, variables_version_(base_version_)
 		, phase_(INITIAL)
 		, can_end_turn_(true)
 		, next_scenario_()
@@ -50,6 +58,9 @@ game_data::game_data(const config& level)
 		, last_selected(map_location::null_location())
 		, rng_(level)
 		, variables_(level.child_or_empty("variables"))
+		, variable_versions_()
+		, base_version_(++last_variable_version)
+		, variables_version_(base_version_)
 		, phase_(INITIAL)
 		, can_end_turn_(level["can_end_turn"].to_bool(true))
 		, next_scenario_(level["next_scenario"])
@@ -62,6 +73,9 @@ game_data::game_data(const game_data& data)
 		, last_selected(data.last_selected)
 		, rng_(data.rng_)
 		, variables_(data.variables_)
+		, variable_versions_(data.variable_versions_)
+		, base_version_(data.base_version_)
+		, variables_version_(data.variables_version_)
 		, phase_(data.phase_)
 		, can_end_turn_(data.can_end_turn_)
 		, next_scenario_(data.next_scenario_)
@@ -131,6 +145,27 @@ void game_data::clear_variable(const std::string& varname)
 	}
 }
 
+namespace {
+	/// The top-level variable of @a varname, the part before any '.' or '['.
+	std::string top_level_name(const std::string& varname)
+	{
+		return varname.substr(0, varname.find_first_of(".["));
+	}
+}
+
+size_t game_data::variable_version(const std::string& varname) const
+{
+	const boost::unordered_map<std::string, size_t>::const_iterator it =
+		variable_versions_.find(top_level_name(varname));
+	return it == variable_versions_.end() ? base_version_ : it->second;
+}
+
+void game_data::touch_variable(const std::string& varname)
+{
+	variables_version_ = ++last_variable_version;
+	variable_versions_[top_level_name(varname)] = variables_version_;
+}
+
 void game_data::write_snapshot(config& cfg) const
 {
 	cfg["next_scenario"] = next_scenario_;
@@ -23,6 +23,8 @@
 #include "mt_rng.hpp"
 #include "variable_info.hpp"
 
+#include <boost/unordered_map.hpp>
+
 class scoped_wml_variable;
 class t_string;
 
@@ -55,6 +57,7 @@ public:
 	variable_access_create get_variable_access_write(const std::string& varname)
 	{
 		activate_scope_variable(varname);
+		touch_variable(varname);
 		return variable_access_create(varname, variables_);
 	}
 	/// Clears attributes config children
@@ -64,6 +67,15 @@ public:
 	/// does nothing if varname is no valid variable name.
 	void clear_variable_cfg(const std::string& varname); 
 
+	/**
+	 * A number which changes whenever the top-level variable of @a varname
+	 * might have been written, for the caches of strings interpolated from
+	 * it. The numbers are never reused, even by other game_data objects.
+	 */
+	size_t variable_version(const std::string& varname) const;
+	/// Like variable_version(), for all the variables at once.
+	size_t variables_version() const { return variables_version_; }
+
 	const rand_rng::mt_rng& rng() const { return rng_; }
 	rand_rng::mt_rng& rng() { return rng_; }
 
@@ -95,11 +107,20 @@ private:
 	variable_access_throw get_variable_access_throw(const std::string& varname)
 	{
 		activate_scope_variable(varname);
+		touch_variable(varname);
 		return variable_access_throw(varname, variables_);
 	}
+	/// Gives a new version to the top-level variable of @a varname.
+	void touch_variable(const std::string& varname);
 
 	rand_rng::mt_rng rng_;
 	config variables_;
+	/// The versions of the top-level variables written, see variable_version().
+	boost::unordered_map<std::string, size_t> variable_versions_;
+	/// The version of the variables not written yet.
+	size_t base_version_;
+	/// The version of the last variable written, see variables_version().
+	size_t variables_version_;
 	PHASE phase_;
 	bool can_end_turn_;
 	std::string next_scenario_;                       /**< the scenario coming next (for campaigns) */
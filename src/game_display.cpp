@@ -47,6 +47,8 @@
 #include <boost/foreach.hpp>
 #include <boost/make_shared.hpp>
 
+#include <ctime>
+
 static lg::log_domain log_display("display");
 #define ERR_DP LOG_STREAM(err, log_display)
 #define LOG_DP LOG_STREAM(info, log_display)
@@ -73,6 +75,8 @@ game_display::game_display(game_board& board, CVideo& video, boost::weak_ptr<wb:
 		const tod_manager& tod,
 		const config& theme_cfg, const config& level) :
 		display(&board, video, wb, reports_object, theme_cfg, level),
+		clock_refreshed_(0),
+		countdown_refreshed_(-1),
 		overlay_map_(),
 		attack_indicator_src_(),
 		attack_indicator_dst_(),
@@ -266,9 +270,13 @@ void game_display::post_draw() {
 
 void game_display::draw_invalidated()
 {
-	halo_man_->unrender(invalidated_);
+	{
+		frame_profiler::timer timer(profiler_, frame_profiler::HALOS);
+		halo_man_->unrender(invalidated_);
+	}
 	display::draw_invalidated();
 
+	frame_profiler::timer timer(profiler_, frame_profiler::UNITS);
 	unit_drawer drawer = unit_drawer(*this, energy_bar_rects_);
 
 	BOOST_FOREACH(const unit* temp_unit, *fake_unit_man_) {
@@ -464,8 +472,16 @@ void game_display::draw_sidebar()
 	if ( !team_valid() )
 		return;
 
-	refresh_report("report_clock");
-	refresh_report("report_countdown");
+	// The clocks change at most once a second, don't generate them at every
+	// frame in between.
+	const time_t now = std::time(NULL);
+	const int countdown = dc_->teams()[viewing_team()].countdown_time() / 1000;
+	if (invalidateGameStatus_ || now != clock_refreshed_ || countdown != countdown_refreshed_) {
+		refresh_report("report_clock");
+		refresh_report("report_countdown");
+		clock_refreshed_ = now;
+		countdown_refreshed_ = countdown;
+	}
 
 	if (invalidateGameStatus_)
 	{
@@ -29,6 +29,7 @@ class game_board;
 #include "display.hpp"
 #include "pathfind/pathfind.hpp"
 
+#include <ctime>
 #include <deque>
 
 // This needs to be separate from display.h because of the static
@@ -230,6 +231,13 @@ private:
 
 	void draw_sidebar();
 
+	/**
+	 * The second and countdown the clock reports were last refreshed for,
+	 * they are only generated again once one of them changes.
+	 */
+	time_t clock_refreshed_;
+	int countdown_refreshed_;
+
 	overlay_map overlay_map_;
 
 	// Locations of the attack direction indicator's parts
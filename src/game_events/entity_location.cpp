@@ -104,5 +104,17 @@ bool entity_location::matches_unit_filter(const unit_map::const_iterator & un_it
 	       matches_unit(un_it);
 }
 
+/**
+ * As above, for a filter already built (from a non-empty config).
+ */
+bool entity_location::matches_unit_filter(const unit_map::const_iterator & un_it,
+                                          const unit_filter & filter) const
+{
+	if ( !un_it.valid() )
+		return false;
+
+	return filter.matches(*un_it, filter_loc_)  &&  matches_unit(un_it);
+}
+
 } // end namespace game_events
 
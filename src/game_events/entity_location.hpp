@@ -24,6 +24,7 @@
 #include "../unit_map.hpp"
 
 class unit;
+class unit_filter;
 class vconfig;
 
 
@@ -41,6 +42,8 @@ namespace game_events
 		bool matches_unit(const unit_map::const_iterator & un_it) const;
 		bool matches_unit_filter(const unit_map::const_iterator & un_it,
 		                         const vconfig & filter) const;
+		bool matches_unit_filter(const unit_map::const_iterator & un_it,
+		                         const unit_filter & filter) const;
 
 		static const entity_location null_entity;
 
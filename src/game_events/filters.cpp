@@ -0,0 +1,233 @@
+/*
+   Copyright (C) 2015 by the Battle for Wesnoth Project
+   Part of the Battle for Wesnoth Project http://www.wesnoth.org/
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY.
+
+   See the COPYING file for more details.
+*/
+
+/**
+ * @file
+ * The filters of the event handlers, prepared once for all their fires.
+ */
+
+#include "global.hpp"
+#include "filters.hpp"
+
+#include "entity_location.hpp"
+#include "pump.hpp"
+
+#include "../serialization/string_utils.hpp"
+#include "../unit.hpp"
+#include "../util.hpp"
+
+#include <boost/foreach.hpp>
+
+#include <algorithm>
+
+
+// This file is in the game_events namespace.
+namespace game_events {
+
+namespace { // Support functions
+
+	/**
+	 * Whether a vconfig of @a cfg could differ from @a cfg, through its
+	 * variables or [insert_tag].
+	 */
+	bool uses_variables(const config & cfg)
+	{
+		BOOST_FOREACH(const config::attribute & attr, cfg.attribute_range()) {
+			if ( attr.second.str().find('$') != std::string::npos )
+				return true;
+		}
+		BOOST_FOREACH(const config::any_child & child, cfg.all_children_range()) {
+			if ( child.key == "insert_tag"  ||  uses_variables(child.cfg) )
+				return true;
+		}
+		return false;
+	}
+
+	/// The most hexes of a handler filed by hex, see filter_hexes().
+	const size_t max_filter_hexes = 64;
+
+	/**
+	 * Parses @a range, as in map_location::matches_range(), into the
+	 * (zero-based) coordinates @a bot to @a top.
+	 * Only plain numbers and ranges of numbers are accepted.
+	 */
+	bool parse_range(const std::string & range, int & bot, int & top)
+	{
+		const std::string::size_type dash = range.find('-');
+		const std::string beg = range.substr(0, dash);
+		const std::string end = dash == std::string::npos ? beg : range.substr(dash + 1);
+		if ( beg.empty()  ||  end.empty()  ||
+		     beg.find_first_not_of("0123456789") != std::string::npos  ||
+		     end.find_first_not_of("0123456789") != std::string::npos )
+			return false;
+
+		bot = atoi(beg.c_str()) - 1;
+		top = atoi(end.c_str()) - 1;
+		return true;
+	}
+
+	/**
+	 * Adds the hexes of the location range @a xloc, @a yloc to @a hexes.
+	 * Returns false if the range has more than max_filter_hexes hexes, or
+	 * whole rows or columns.
+	 */
+	bool range_hexes(const std::string & xloc, const std::string & yloc,
+	                 std::vector<map_location> & hexes)
+	{
+		std::vector<std::string> xlocs = utils::split(xloc);
+		std::vector<std::string> ylocs = utils::split(yloc);
+		// As in matches_range(), the missing coordinates match everything.
+		if ( xlocs.size() != ylocs.size() )
+			return false;
+
+		for ( size_t i = 0; i != xlocs.size(); ++i ) {
+			int x_bot, x_top, y_bot, y_top;
+			if ( !parse_range(xlocs[i], x_bot, x_top)  ||
+			     !parse_range(ylocs[i], y_bot, y_top) )
+				return false;
+			for ( int x = x_bot; x <= x_top; ++x ) {
+				for ( int y = y_bot; y <= y_top; ++y ) {
+					if ( hexes.size() == max_filter_hexes )
+						return false;
+					hexes.push_back(map_location(x, y));
+				}
+			}
+		}
+		return true;
+	}
+
+} // end anonymous namespace (support functions)
+
+unit_filters::filter::filter(const vconfig & cfg_) :
+	cfg(cfg_), compiled(), sides(), side(0), checks_location(false), x(), y()
+{
+}
+
+unit_filters::unit_filters(const vconfig::child_list & filters, const filter_context * fc) :
+	filters_()
+{
+	BOOST_FOREACH(const vconfig & f, filters) {
+		filters_.push_back(filter(f));
+		filter & res = filters_.back();
+
+		// An empty filter only needs the unit (see matches_unit_filter()).
+		if ( f.empty()  ||  uses_variables(f.get_config()) )
+			continue;
+
+		res.compiled = unit_filter(f, fc);
+
+		if ( f.has_child("or") )
+			continue;
+
+		const config & cfg = f.get_config();
+		if ( !cfg["side"].empty() ) {
+			res.sides = utils::split(cfg["side"]);
+			res.side = cfg["side"].to_int(-999);
+		}
+
+		// The same tests as the location range of the unit filters.
+		const config::attribute_value & x = cfg["x"];
+		const config::attribute_value & y = cfg["y"];
+		if ( (!x.blank() || !y.blank())  &&  !(x == "recall" && y == "recall")
+		     &&  !(x.empty() && y.empty()) ) {
+			res.checks_location = true;
+			res.x = x.str();
+			res.y = y.str();
+		}
+	}
+}
+
+bool unit_filters::rejects(const entity_location & loc, const unit_map::const_iterator & un_it) const
+{
+	if ( filters_.empty() )
+		return false;
+	if ( !un_it.valid() )
+		return true;
+
+	BOOST_FOREACH(const filter & f, filters_) {
+		if ( !f.sides.empty()  &&  f.side != un_it->side() ) {
+			const std::string side = str_cast(un_it->side());
+			if ( std::find(f.sides.begin(), f.sides.end(), side) == f.sides.end() )
+				return true;
+		}
+		if ( f.checks_location  &&
+		     !map_location(loc.filter_x(), loc.filter_y()).matches_range(f.x, f.y) )
+			return true;
+	}
+	return false;
+}
+
+bool unit_filters::matches(const entity_location & loc, const unit_map::const_iterator & un_it) const
+{
+	BOOST_FOREACH(const filter & f, filters_) {
+		const bool matches = f.compiled ?
+			loc.matches_unit_filter(un_it, *f.compiled) :
+			loc.matches_unit_filter(un_it, f.cfg);
+		if ( !matches )
+			return false;
+	}
+	return true;
+}
+
+
+event_filters::event_filters(const config & handler_cfg, const filter_context * fc) :
+	cfg_(handler_cfg),
+	conditions_(cfg_.get_children("filter_condition")),
+	side_filters_(cfg_.get_children("filter_side")),
+	first_(cfg_.get_children("filter"), fc),
+	first_attack_(cfg_.get_children("filter_attack")),
+	second_(cfg_.get_children("filter_second"), fc),
+	second_attack_(cfg_.get_children("filter_second_attack"))
+{
+}
+
+bool event_filters::rejects(const queued_event & ev, const unit_map & units) const
+{
+	return first_.rejects(ev.loc1, units.find(ev.loc1))  ||
+	       second_.rejects(ev.loc2, units.find(ev.loc2));
+}
+
+bool event_filters::can_prepare(const config & handler_cfg)
+{
+	return !handler_cfg.has_child("insert_tag");
+}
+
+bool event_filters::filter_hexes(const config & handler_cfg, std::vector<map_location> & hexes)
+{
+	if ( !can_prepare(handler_cfg) )
+		return false;
+
+	// The same filters as those getting a location pre-check.
+	BOOST_FOREACH(const config & f, handler_cfg.child_range("filter")) {
+		if ( f.empty()  ||  uses_variables(f)  ||  f.has_child("or") )
+			continue;
+
+		const config::attribute_value & x = f["x"];
+		const config::attribute_value & y = f["y"];
+		if ( x.empty()  ||  y.empty()  ||  (x == "recall" && y == "recall") )
+			continue;
+
+		hexes.clear();
+		if ( range_hexes(x, y, hexes)  &&  !hexes.empty() ) {
+			// A handler must only be filed once at each hex.
+			std::sort(hexes.begin(), hexes.end());
+			hexes.erase(std::unique(hexes.begin(), hexes.end()), hexes.end());
+			return true;
+		}
+	}
+	hexes.clear();
+	return false;
+}
+
+} // end namespace game_events
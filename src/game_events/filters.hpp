@@ -0,0 +1,120 @@
+/*
+   Copyright (C) 2015 by the Battle for Wesnoth Project
+   Part of the Battle for Wesnoth Project http://www.wesnoth.org/
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY.
+
+   See the COPYING file for more details.
+*/
+
+/**
+ * @file
+ * The filters of the event handlers, prepared once for all their fires.
+ */
+
+#ifndef GAME_EVENTS_FILTERS_H_INCLUDED
+#define GAME_EVENTS_FILTERS_H_INCLUDED
+
+#include "../unit_filter.hpp"
+#include "../unit_map.hpp"
+#include "../variable.hpp"
+
+#include <boost/noncopyable.hpp>
+#include <boost/optional.hpp>
+
+#include <string>
+#include <vector>
+
+class filter_context;
+
+namespace game_events
+{
+	struct entity_location;
+	struct queued_event;
+
+	/// The [filter] or [filter_second] children of an event handler.
+	///
+	/// The unit filters which don't use variables are built once, instead
+	/// of from their vconfig at every fire; those using variables still are,
+	/// to see the current values. Each filter also gets a pre-check on the
+	/// side and location of the unit when it has no [or] child, which could
+	/// let other units pass.
+	class unit_filters
+	{
+	public:
+		unit_filters(const vconfig::child_list & filters, const filter_context * fc);
+
+		/// Whether the unit at @a loc can't pass the filters, as seen from its
+		/// side and location alone.
+		bool rejects(const entity_location & loc, const unit_map::const_iterator & un_it) const;
+		/// Whether the unit at @a loc passes all the filters.
+		bool matches(const entity_location & loc, const unit_map::const_iterator & un_it) const;
+
+	private:
+		struct filter {
+			explicit filter(const vconfig & cfg);
+
+			vconfig cfg;
+			/// The unit filter built from cfg, unless it uses variables.
+			boost::optional<unit_filter> compiled;
+
+			/// The sides of the pre-check, empty for any side.
+			std::vector<std::string> sides;
+			int side;
+			/// The location range of the pre-check, if checks_location.
+			bool checks_location;
+			std::string x, y;
+		};
+
+		std::vector<filter> filters_;
+	};
+
+	/// The filters of an event handler, taken out of its config at its first
+	/// fire rather than at each one.
+	///
+	/// The handlers whose config uses [insert_tag] at the top level can't be
+	/// prepared, since the filters found there depend on the variables:
+	/// event_handler::filters() then returns NULL.
+	class event_filters : private boost::noncopyable
+	{
+	public:
+		event_filters(const config & handler_cfg, const filter_context * fc);
+
+		/// Whether the event can't pass the unit filters, as seen from the
+		/// sides and locations of its units alone. This is checked before
+		/// the units and weapons are stored in the variables.
+		bool rejects(const queued_event & ev, const unit_map & units) const;
+
+		const vconfig::child_list & conditions() const { return conditions_; }
+		const vconfig::child_list & side_filters() const { return side_filters_; }
+		const unit_filters & first() const { return first_; }
+		const vconfig::child_list & first_attack() const { return first_attack_; }
+		const unit_filters & second() const { return second_; }
+		const vconfig::child_list & second_attack() const { return second_attack_; }
+
+		/// Whether event filters can be prepared from @a handler_cfg.
+		static bool can_prepare(const config & handler_cfg);
+
+		/// Finds the few hexes a [filter] of @a handler_cfg restricts the
+		/// location of the primary unit to, so that rejects() is true for
+		/// the events elsewhere.
+		/// Returns false if the handler isn't restricted to a few hexes.
+		static bool filter_hexes(const config & handler_cfg, std::vector<map_location> & hexes);
+
+	private:
+		vconfig cfg_;
+		vconfig::child_list conditions_;
+		vconfig::child_list side_filters_;
+		unit_filters first_;
+		vconfig::child_list first_attack_;
+		unit_filters second_;
+		vconfig::child_list second_attack_;
+	};
+}
+
+#endif // GAME_EVENTS_FILTERS_H_INCLUDED
@@ -20,6 +20,7 @@
 
 #include "../global.hpp"
 #include "handlers.hpp"
+#include "filters.hpp"
 #include "manager.hpp"
 #include "manager_impl.hpp"
 #include "menu_item.hpp"
@@ -82,8 +83,27 @@ event_handler::event_handler(const config &cfg, bool imi, handler_vec::size_type
 	, index_(index)
 	, man_(&man)
 	, cfg_(cfg)
+	, filters_()
+	, filters_prepared_(false)
 {}
 
+/**
+ * Default destructor, defined here where event_filters is complete.
+ */
+event_handler::~event_handler()
+{
+}
+
+const event_filters * event_handler::filters(const filter_context * fc) const
+{
+	if ( !filters_prepared_ ) {
+		filters_prepared_ = true;
+		if ( event_filters::can_prepare(cfg_) )
+			filters_.reset(new event_filters(cfg_, fc));
+	}
+	return filters_.get();
+}
+
 /**
  * Disables *this, removing it from the game.
  * (Technically, the handler is only removed once no one is hanging on to a
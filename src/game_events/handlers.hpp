@@ -34,12 +34,14 @@
 #include <set>
 #include <string>
 
+class filter_context;
 class game_data;
 class game_lua_kernel;
 
 namespace game_events
 {
 	struct queued_event;
+	class event_filters;
 	class event_handler;  // Defined a few lines down.
 	class manager;
 
@@ -54,6 +56,7 @@ namespace game_events
 		public:
 			event_handler(const config &cfg, bool is_menu_item,
 			              handler_vec::size_type index, manager &);
+			~event_handler();
 
 			/// The index of *this should only be of interest when controlling iterations.
 			handler_vec::size_type index() const { return index_; }
@@ -68,12 +71,18 @@ namespace game_events
 
 			const config &get_config() const { return cfg_; }
 
+			/// The filters of *this, prepared at the first call.
+			/// Returns NULL if they can't be prepared (see event_filters).
+			const event_filters * filters(const filter_context * fc) const;
+
 		private:
 			bool first_time_only_;
 			bool is_menu_item_;
 			handler_vec::size_type index_;
 			manager * man_;
 			config cfg_;
+			mutable boost::scoped_ptr<event_filters> filters_;
+			mutable bool filters_prepared_;
 	};
 
 
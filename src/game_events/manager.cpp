@@ -144,15 +144,25 @@ manager::~manager() {}
  * (including those defined via menu items).
  * An empty @a event_name will automatically match nothing.
  */
-manager::iteration::iteration(const std::string & event_name, manager & man) :
+manager::iteration::iteration(const std::string & event_name, manager & man,
+                              const map_location & loc) :
 	main_list_(man.event_handlers_->get(event_name)),
+	hex_list_(man.event_handlers_->get(event_name, loc)),
 	var_list_(man.event_handlers_->get()),
+	var_index_(event_name.empty() ? boost::shared_ptr<const handler_list>() :
+	           man.event_handlers_->get_dynamic(event_name, man.resources_->gamedata)),
+	handlers_(*man.event_handlers_),
+	var_generation_(handlers_.dynamic_generation()),
 	event_name_(event_name),
 	end_(man.event_handlers_->size()),
 	current_is_known_(false),
-	main_is_current_(false),
+	current_(MAIN),
+	current_index_(0),
+	floor_(0),
 	main_it_(main_list_.begin()),
-	var_it_(event_name.empty() ? var_list_.end() : var_list_.begin()),
+	hex_it_(hex_list_.begin()),
+	var_it_(event_name.empty() ? var_list_.end() :
+	        var_index_ ? var_index_->begin() : var_list_.begin()),
 	gamedata_(man.resources_->gamedata)
 {
 }
@@ -172,8 +182,11 @@ manager::iteration & manager::iteration::operator++()
 		return *this;
 
 	// Guarantee a different element next dereference.
-	if ( main_is_current_ )
+	floor_ = current_index_ + 1;
+	if ( current_ == MAIN )
 		++main_it_;
+	else if ( current_ == HEX )
+		++hex_it_;
 	else
 		++var_it_; // (We'll check for a name match when we dereference.)
 
@@ -194,22 +207,46 @@ handler_ptr manager::iteration::operator*()
 	handler_ptr main_ptr = *main_it_;
 	handler_vec::size_type main_index = ptr_index(main_ptr);
 
+	// Get the candidate for the current element from the hex list.
+	// (The handlers there are not in the main list.)
+	handler_ptr hex_ptr = *hex_it_;
+	handler_vec::size_type hex_index = ptr_index(hex_ptr);
+	const handler_vec::size_type fixed_index = std::min(main_index, hex_index);
+
+	// The names of the var list may have been resolved again meanwhile, from
+	// variables changed by the handlers. They are then searched as they are now.
+	if ( var_index_  &&  !handlers_.dynamic_index_current(var_generation_, *gamedata_) ) {
+		var_index_.reset();
+		var_it_ = var_list_.begin();
+	}
+
 	// Get the candidate for the current element from the var list.
 	handler_ptr var_ptr = *var_it_;
-	// (Loop while var_ptr would be chosen over main_ptr, but the name does not match.)
-	while ( var_ptr  &&  var_ptr->index() < main_index  &&
-	        !var_ptr->matches_name(event_name_, gamedata_) )
+	// (Loop while var_ptr would be chosen over the fixed-name lists, but the
+	// name does not match, or it was passed before changing lists.)
+	while ( var_ptr  &&  (var_ptr->index() < floor_  ||
+	        (var_ptr->index() < fixed_index  &&
+	         !var_ptr->matches_name(event_name_, gamedata_))) )
 		var_ptr = *++var_it_;
 	handler_vec::size_type var_index = ptr_index(var_ptr);
 
-	// Which list? (Index ties go to the main list.)
-	current_is_known_ = main_index < end_  ||  var_index < end_;
-	main_is_current_ = main_index <= var_index;
+	// Which list? (Index ties go to the main list, then to the hex list.)
+	current_is_known_ = fixed_index < end_  ||  var_index < end_;
+	if ( main_index <= var_index  &&  main_index <= hex_index )
+		current_ = MAIN;
+	else if ( hex_index <= var_index )
+		current_ = HEX;
+	else
+		current_ = VAR;
 
 	if ( !current_is_known_ )
 		return handler_ptr(); // End of list; return a null pointer.
+
+	current_index_ = std::min(fixed_index, var_index);
+	if ( current_ == MAIN )
+		return main_ptr;
 	else
-		return main_is_current_ ? main_ptr : var_ptr;
+		return current_ == HEX ? hex_ptr : var_ptr;
 }
 
 
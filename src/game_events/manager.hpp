@@ -17,6 +17,7 @@
 
 #include "game_events/handlers.hpp"
 #include "game_events/wmi_container.hpp"
+#include "map_location.hpp"
 
 #include <boost/function.hpp>
 #include <boost/noncopyable.hpp>
@@ -75,7 +76,10 @@ namespace game_events {
 		{
 		public:
 			/// Event-specific constructor.
-			explicit iteration(const std::string & event_name, manager &);
+			/// The handlers filed by hex are those at @a loc, the filter
+			/// location of the primary unit of the event.
+			iteration(const std::string & event_name, manager &,
+			          const map_location & loc = map_location::null_location());
 
 			// Increment:
 			iteration & operator++();
@@ -90,8 +94,16 @@ namespace game_events {
 		private: // data
 			/// The fixed-name event handlers for this iteration.
 			const handler_list & main_list_;
+			/// The fixed-name event handlers filed at the hex of this iteration.
+			const handler_list & hex_list_;
 			/// The varying-name event handlers for this iteration.
 			const handler_list & var_list_;
+			/// The handlers of var_list_ whose names may match, as resolved
+			/// when *this was constructed, or NULL to search all of var_list_.
+			boost::shared_ptr<const handler_list> var_index_;
+			t_event_handlers & handlers_;
+			/// The version of the lists of handlers_ var_index_ comes from.
+			const size_t var_generation_;
 			/// The event name for this iteration.
 			const std::string event_name_;
 			/// The end of this iteration. We intentionally exclude handlers
@@ -100,10 +112,16 @@ namespace game_events {
 
 			/// Set to true upon dereferencing.
 			bool current_is_known_;
-			/// true if the most recent dereference was taken from main_list_.
-			bool main_is_current_;
+			/// The list the most recent dereference was taken from.
+			enum { MAIN, HEX, VAR } current_;
+			/// The index of the most recent dereference.
+			handler_vec::size_type current_index_;
+			/// The handlers before this index are done with.
+			handler_vec::size_type floor_;
 			/// The current (or next) element from main_list_.
 			handler_list::iterator main_it_;
+			/// The current (or next) element from hex_list_.
+			handler_list::iterator hex_it_;
 			/// The current (or next) element from var_list_.
 			handler_list::iterator var_it_;
 
@@ -14,6 +14,7 @@
 
 #include "game_events/manager_impl.hpp"
 
+#include "game_events/filters.hpp"
 #include "game_events/handlers.hpp"
 #include "game_events/manager.hpp"
 #include "game_events/menu_item.hpp"
@@ -30,8 +31,11 @@
 #include "util.hpp"
 
 #include <boost/foreach.hpp>
+#include <boost/make_shared.hpp>
 #include <boost/unordered_map.hpp>
+#include <algorithm>
 #include <iostream>
+#include <map>
 
 
 static lg::log_domain log_engine("engine");
@@ -44,6 +48,41 @@ static lg::log_domain log_event_handler("event_handler");
 
 namespace game_events {
 
+namespace { // Support functions
+
+	/// The variables of a game_data, recording the variables read.
+	class recording_variables : public variable_set
+	{
+	public:
+		explicit recording_variables(const game_data & gd) :
+			gd_(gd), names_()
+		{}
+
+		virtual config::attribute_value get_variable_const(const std::string & id) const
+		{
+			names_.push_back(id);
+			return gd_.get_variable_const(id);
+		}
+
+		/// The variables read so far, in no particular order.
+		const std::vector<std::string> & names() const { return names_; }
+
+	private:
+		const game_data & gd_;
+		mutable std::vector<std::string> names_;
+	};
+
+} // end anonymous namespace (support functions)
+
+	t_event_handlers::dynamic_name::dynamic_name(const handler_ptr & h) :
+		handler(h),
+		uses_formula(h->get_config()["name"].str().find("$(") != std::string::npos),
+		resolved(false),
+		variables(),
+		keys()
+	{
+	}
+
 	void t_event_handlers::log_handlers()
 	{
 		if(lg::debug.dont_log("event_handler")) return;
@@ -101,6 +140,153 @@ namespace game_events {
 		return find_it == by_name_.end() ? empty_list : find_it->second;
 	}
 
+	/**
+	 * Read-only access to the handlers with fixed event names filed by hex,
+	 * by event name and the filter location of the primary unit.
+	 */
+	const handler_list & t_event_handlers::get(const std::string & name, const map_location & loc) const
+	{
+		// Empty list for the "not found" case.
+		static const handler_list empty_list;
+
+		if ( by_hex_.empty() )
+			return empty_list;
+
+		hex_name_map_t::const_iterator name_it = by_hex_.find(standardize_name(name));
+		if ( name_it == by_hex_.end() )
+			return empty_list;
+
+		hex_map_t::const_iterator find_it = name_it->second.find(loc);
+		return find_it == name_it->second.end() ? empty_list : find_it->second;
+	}
+
+	/**
+	 * The handlers with varying event names which may match @a name, given the
+	 * current values of the variables of @a gd.
+	 * The lists are rebuilt when the variables used in the event names change,
+	 * and the caller must still check the names with matches_name().
+	 */
+	boost::shared_ptr<const handler_list> t_event_handlers::get_dynamic(const std::string & name, const game_data * gd)
+	{
+		// The names with unusual whitespace are left to matches_name().
+		if ( !gd  ||  name.find_first_of("\f\n\r\t\v") != std::string::npos )
+			return boost::shared_ptr<const handler_list>();
+
+		if ( !dynamic_index_current(dynamic_generation_, *gd) )
+			index_dynamic_names(*gd);
+
+		resolved_map_t::const_iterator find_it = by_resolved_name_.find(standardize_name(name));
+		return find_it == by_resolved_name_.end() ? unresolved_ : find_it->second;
+	}
+
+	/**
+	 * Whether the lists of get_dynamic() at @a generation still hold for the
+	 * variables of @a gd.
+	 */
+	bool t_event_handlers::dynamic_index_current(size_t generation, const game_data & gd) const
+	{
+		if ( !dynamic_index_valid_  ||  generation != dynamic_generation_ )
+			return false;
+
+		BOOST_FOREACH( const version_list::value_type & var, dynamic_variables_ ) {
+			if ( gd.variable_version(var.first) != var.second )
+				return false;
+		}
+		return true;
+	}
+
+	/**
+	 * Resolves the event names of @a dn from the variables of @a gd, recording
+	 * the variables they depend on.
+	 */
+	void t_event_handlers::resolve(dynamic_name & dn, const game_data & gd)
+	{
+		const handler_ptr handler = dn.handler.lock();
+		if ( !handler )
+			return;
+
+		recording_variables variables(gd);
+		const std::string names =
+			utils::interpolate_variables_into_string(handler->get_config()["name"], variables);
+
+		dn.keys.clear();
+		BOOST_FOREACH( const std::string & single_name, utils::split(names) )
+			dn.keys.push_back(standardize_name(single_name));
+		std::sort(dn.keys.begin(), dn.keys.end());
+		dn.keys.erase(std::unique(dn.keys.begin(), dn.keys.end()), dn.keys.end());
+
+		// The versions are taken after resolving, since reading a scoped
+		// variable can activate it.
+		std::vector<std::string> names_read = variables.names();
+		std::sort(names_read.begin(), names_read.end());
+		names_read.erase(std::unique(names_read.begin(), names_read.end()), names_read.end());
+		dn.variables.clear();
+		BOOST_FOREACH( const std::string & var, names_read )
+			dn.variables.push_back(std::make_pair(var, gd.variable_version(var)));
+
+		dn.resolved = true;
+	}
+
+	/**
+	 * Builds by_resolved_name_, resolving again only the event names whose
+	 * variables changed since they were last resolved.
+	 */
+	void t_event_handlers::index_dynamic_names(const game_data & gd)
+	{
+		std::vector<dynamic_name> names;
+		names.reserve(dynamic_names_.size());
+		std::map<std::string, size_t> variables;
+
+		BOOST_FOREACH( dynamic_name & dn, dynamic_names_ ) {
+			if ( dn.handler.expired() )
+				continue;
+
+			if ( !dn.uses_formula ) {
+				bool changed = !dn.resolved;
+				BOOST_FOREACH( const version_list::value_type & var, dn.variables )
+					changed = changed  ||  gd.variable_version(var.first) != var.second;
+				if ( changed )
+					resolve(dn, gd);
+				BOOST_FOREACH( const version_list::value_type & var, dn.variables )
+					variables[var.first] = var.second;
+			}
+			names.push_back(dn);
+		}
+		dynamic_names_.swap(names);
+		dynamic_variables_.assign(variables.begin(), variables.end());
+
+		// Lists still used by iterations are left to them.
+		by_resolved_name_.clear();
+		unresolved_ = boost::make_shared<handler_list>();
+		BOOST_FOREACH( const dynamic_name & dn, dynamic_names_ ) {
+			BOOST_FOREACH( const std::string & key, dn.keys ) {
+				boost::shared_ptr<handler_list> & list = by_resolved_name_[key];
+				if ( !list )
+					list = boost::make_shared<handler_list>();
+			}
+		}
+
+		// Filled in index order, with the formulas everywhere.
+		BOOST_FOREACH( const dynamic_name & dn, dynamic_names_ ) {
+			const handler_ptr handler = dn.handler.lock();
+			if ( !handler )
+				continue;
+
+			if ( dn.uses_formula ) {
+				unresolved_->push_back(handler);
+				BOOST_FOREACH( resolved_map_t::value_type & list, by_resolved_name_ )
+					list.second->push_back(handler);
+			}
+			else {
+				BOOST_FOREACH( const std::string & key, dn.keys )
+					by_resolved_name_[key]->push_back(handler);
+			}
+		}
+
+		dynamic_index_valid_ = true;
+		++dynamic_generation_;
+	}
+
 	/**
 	 * Adds an event handler.
 	 * An event with a nonempty ID will not be added if an event with that
@@ -128,12 +314,26 @@ namespace game_events {
 		active_.push_back(new_handler);
 
 		// File by name.
-		if ( utils::might_contain_variables(name) )
+		if ( utils::might_contain_variables(name) ) {
 			dynamic_.push_back(new_handler);
+			dynamic_names_.push_back(dynamic_name(new_handler));
+			dynamic_index_valid_ = false;
+		}
 		else {
+			// The handlers for a few hexes are only offered the events there.
+			std::vector<map_location> hexes;
+			event_filters::filter_hexes(cfg, hexes);
+
 			std::vector<std::string> name_list = utils::split(name);
-			BOOST_FOREACH( const std::string & single_name, name_list )
-				by_name_[standardize_name(single_name)].push_back(new_handler);
+			BOOST_FOREACH( const std::string & single_name, name_list ) {
+				if ( hexes.empty() )
+					by_name_[standardize_name(single_name)].push_back(new_handler);
+				else {
+					hex_map_t & by_hex = by_hex_[standardize_name(single_name)];
+					BOOST_FOREACH( const map_location & hex, hexes )
+						by_hex[hex].push_back(new_handler);
+				}
+			}
 		}
 		// File by ID.
 		if ( !id.empty() )
@@ -16,6 +16,10 @@
 #define GAME_EVENTS_MANAGER_IMPL_HPP
 
 #include "game_events/handlers.hpp"
+#include "map_location.hpp"
+
+#include <utility>
+#include <vector>
 
 #include <boost/noncopyable.hpp>
 #include <boost/scoped_ptr.hpp>
@@ -28,7 +32,28 @@ namespace game_events {
 	//t_event_handlers is essentially the implementation details of the manager
 	class t_event_handlers {
 		typedef boost::unordered_map<std::string, handler_list> map_t;
+		typedef boost::unordered_map<map_location, handler_list> hex_map_t;
+		typedef boost::unordered_map<std::string, hex_map_t> hex_name_map_t;
 		typedef boost::unordered_map<std::string, boost::weak_ptr<event_handler> > id_map_t;
+		typedef boost::unordered_map<std::string, boost::shared_ptr<handler_list> > resolved_map_t;
+		/// Variables, with the versions they had at some point.
+		typedef std::vector<std::pair<std::string, size_t> > version_list;
+
+		/// The event names of a handler with variables in its event name,
+		/// as resolved from the current values of the variables.
+		struct dynamic_name {
+			explicit dynamic_name(const handler_ptr & h);
+
+			boost::weak_ptr<event_handler> handler;
+			/// Whether the event name uses a formula, so it can't be resolved ahead.
+			bool uses_formula;
+			/// Whether keys and variables are set.
+			bool resolved;
+			/// The variables read when resolving, with their versions then.
+			version_list variables;
+			/// The resolved event names, standardized.
+			std::vector<std::string> keys;
+		};
 
 	public:
 		typedef handler_vec::iterator iterator;
@@ -37,13 +62,25 @@ namespace game_events {
 	private:
 		handler_vec  active_;  /// Active event handlers. Will not have elements removed unless the t_event_handlers is clear()ed.
 		map_t        by_name_; /// Active event handlers with fixed event names, organized by event name.
+		hex_name_map_t by_hex_; /// Active event handlers with fixed event names whose filters restrict the location of the primary unit, organized by event name and hex. They are not in by_name_.
 		handler_list dynamic_; /// Active event handlers with variables in their event names.
 		id_map_t     id_map_;  /// Allows quick locating of handlers by id.
 
+		std::vector<dynamic_name> dynamic_names_; /// The event names of the handlers in dynamic_, in index order.
+		resolved_map_t by_resolved_name_; /// The handlers in dynamic_, organized by the event names resolved from the variables. Those with formulas are in every list.
+		boost::shared_ptr<handler_list> unresolved_; /// The handlers in dynamic_ whose event names use formulas.
+		version_list dynamic_variables_; /// All the variables of dynamic_names_, with their versions when by_resolved_name_ was built.
+		bool dynamic_index_valid_; /// Whether by_resolved_name_ is built for all the handlers in dynamic_.
+		size_t dynamic_generation_; /// Counts the builds of by_resolved_name_.
+
 
 		void log_handlers();
 		/// Utility to standardize the event names used in by_name_.
 		static std::string standardize_name(const std::string & name);
+		/// Resolves the event names of @a dn from the variables of @a gd.
+		static void resolve(dynamic_name & dn, const game_data & gd);
+		/// Builds by_resolved_name_, resolving the event names whose variables changed.
+		void index_dynamic_names(const game_data & gd);
 
 	public:
 		typedef handler_vec::size_type size_type;
@@ -51,14 +88,36 @@ namespace game_events {
 		t_event_handlers()
 			: active_()
 			, by_name_()
+			, by_hex_()
 			, dynamic_()
 			, id_map_()
+			, dynamic_names_()
+			, by_resolved_name_()
+			, unresolved_()
+			, dynamic_variables_()
+			, dynamic_index_valid_(false)
+			, dynamic_generation_(0)
 		{}
 
 		/// Read-only access to the handlers with varying event names.
 		const handler_list & get() const { return dynamic_; }
 		/// Read-only access to the handlers with fixed event names, by event name.
+		/// The handlers filed by hex are not included.
 		const handler_list & get(const std::string & name) const;
+		/// Read-only access to the handlers with fixed event names filed by hex,
+		/// by event name and the filter location of the primary unit.
+		const handler_list & get(const std::string & name, const map_location & loc) const;
+		/// The handlers with varying event names which may match @a name, given
+		/// the current values of the variables of @a gd. It is a subset of get(),
+		/// valid while dynamic_index_current() holds for the current
+		/// dynamic_generation().
+		/// Returns NULL if get() must be searched instead.
+		boost::shared_ptr<const handler_list> get_dynamic(const std::string & name, const game_data * gd);
+		/// Counts the changes of the lists returned by get_dynamic().
+		size_t dynamic_generation() const { return dynamic_generation_; }
+		/// Whether the lists of get_dynamic() at @a generation still hold for
+		/// the variables of @a gd.
+		bool dynamic_index_current(size_t generation, const game_data & gd) const;
 
 		/// Adds an event handler.
 		void add_event_handler(const config & cfg, manager & man, bool is_menu_item=false);
@@ -21,6 +21,7 @@
 #include "../global.hpp"
 #include "pump.hpp"
 #include "conditional_wml.hpp"
+#include "filters.hpp"
 #include "handlers.hpp"
 #include "manager.hpp"
 
@@ -30,8 +31,10 @@
 #include "../game_data.hpp"
 #include "../gettext.hpp"
 #include "../log.hpp"
+#include "../pathfind/teleport.hpp"
 #include "../play_controller.hpp"
 #include "../scripting/game_lua_kernel.hpp"
+#include "../scripting/lua_profiler.hpp"
 #include "../side_filter.hpp"
 #include "../unit.hpp"
 #include "../unit_map.hpp"
@@ -54,7 +57,7 @@ static lg::log_domain log_wml("wml");
 #define WRN_WML LOG_STREAM(warn, log_wml)
 #define ERR_WML LOG_STREAM(err, log_wml)
 
-static lg::log_domain log_event_handler("event_handler");
+static lg::hot_log_domain log_event_handler("event_handler");
 #define DBG_EH LOG_STREAM(debug, log_event_handler)
 
 // std::getline might be broken in Visual Studio so show a warning
@@ -187,40 +190,47 @@ namespace { // Support functions
 	 * Returns true iff the given event passes all its filters.
 	 */
 	bool t_pump::filter_event(const event_handler& handler, const queued_event& ev)
+	{
+		const event_filters *prepared = handler.filters(impl_->resources->filter_con);
+		if ( !prepared ) {
+			// The filters depend on the variables.
+			const event_filters current(handler.get_config(), impl_->resources->filter_con);
+			return filter_event(current, ev);
+		}
+		return filter_event(*prepared, ev);
+	}
+
+	bool t_pump::filter_event(const event_filters& filters, const queued_event& ev)
 	{
 		const unit_map *units = impl_->resources->units;
 		unit_map::const_iterator unit1 = units->find(ev.loc1);
 		unit_map::const_iterator unit2 = units->find(ev.loc2);
-		vconfig filters(handler.get_config());
 
-		BOOST_FOREACH(const vconfig &condition, filters.get_children("filter_condition"))
+		BOOST_FOREACH(const vconfig &condition, filters.conditions())
 		{
 			if (!conditional_passed(condition)) {
 				return false;
 			}
 		}
 
-		BOOST_FOREACH(const vconfig &f, filters.get_children("filter_side"))
+		BOOST_FOREACH(const vconfig &f, filters.side_filters())
 		{
 			side_filter ssf(f, impl_->resources->filter_con);
 			if ( !ssf.match(impl_->resources->current_side()) )
 				return false;
 		}
 
-		BOOST_FOREACH(const vconfig &f, filters.get_children("filter"))
-		{
-			if ( !ev.loc1.matches_unit_filter(unit1, f) ) {
-				return false;
-			}
+		if ( !filters.first().matches(ev.loc1, unit1) ) {
+			return false;
 		}
 
-		vconfig::child_list special_filters = filters.get_children("filter_attack");
-		bool special_matches = special_filters.empty();
+		const vconfig::child_list &first_attack = filters.first_attack();
+		bool special_matches = first_attack.empty();
 		if ( !special_matches  &&  unit1 != units->end() )
 		{
 			const bool matches_unit = ev.loc1.matches_unit(unit1);
 			const config & attack = ev.data.child("first");
-			BOOST_FOREACH(const vconfig &f, special_filters)
+			BOOST_FOREACH(const vconfig &f, first_attack)
 			{
 				if ( f.empty() )
 					special_matches = true;
@@ -235,20 +245,17 @@ namespace { // Support functions
 			return false;
 		}
 
-		BOOST_FOREACH(const vconfig &f, filters.get_children("filter_second"))
-		{
-			if ( !ev.loc2.matches_unit_filter(unit2, f) ) {
-				return false;
-			}
+		if ( !filters.second().matches(ev.loc2, unit2) ) {
+			return false;
 		}
 
-		special_filters = filters.get_children("filter_second_attack");
-		special_matches = special_filters.empty();
+		const vconfig::child_list &second_attack = filters.second_attack();
+		special_matches = second_attack.empty();
 		if ( !special_matches  &&  unit2 != units->end() )
 		{
 			const bool matches_unit = ev.loc2.matches_unit(unit2);
 			const config & attack = ev.data.child("second");
-			BOOST_FOREACH(const vconfig &f, special_filters)
+			BOOST_FOREACH(const vconfig &f, second_attack)
 			{
 				if ( f.empty() )
 					special_matches = true;
@@ -286,6 +293,13 @@ namespace { // Support functions
 			return false;
 
 		unit_map *units = impl_->resources->units;
+
+		// Most handlers for other sides or hexes are rejected here, before
+		// storing the units and weapons in the variables.
+		const event_filters *filters = handler_p->filters(impl_->resources->filter_con);
+		if ( filters  &&  filters->rejects(ev, *units) )
+			return false;
+
 		scoped_xy_unit first_unit("unit", ev.loc1.x, ev.loc1.y, *units);
 		scoped_xy_unit second_unit("second_unit", ev.loc2.x, ev.loc2.y, *units);
 		scoped_weapon_info first_weapon("weapon", ev.data.child("first"));
@@ -528,10 +542,13 @@ bool t_pump::operator()()
 	{
 		queued_event & ev = pump_instance.next();
 		const std::string& event_name = ev.name;
+		const lua_profiler::context profiling("event", event_name);
 
 		// Clear the unit cache, since the best clearing time is hard to figure out
 		// due to status changes by WML. Every event will flush the cache.
 		unit::clear_status_caches();
+		// Same for the tunnel locations, whose filters may use variables.
+		pathfind::tunnel_cache::invalidate();
 
 		if ( impl_->resources->lua_kernel->run_event(ev) ) {
 			++impl_->internal_wml_tracking;
@@ -539,7 +556,10 @@ bool t_pump::operator()()
 
 		// Initialize an iteration over event handlers matching this event.
 		assert(impl_->my_manager);
-		manager::iteration handler_iter(event_name, *impl_->my_manager);
+		// The handlers filed by hex are those at the filter location of the
+		// primary unit, see event_filters::filter_hexes().
+		manager::iteration handler_iter(event_name, *impl_->my_manager,
+			map_location(ev.loc1.filter_x(), ev.loc1.filter_y()));
 
 		// If there are any matching event handlers, initialize variables.
 		// Note: Initializing variables all the time would not be
@@ -109,6 +109,7 @@ namespace game_events
 
 	private:
 		bool filter_event(const event_handler& handler, const queued_event& ev);
+		bool filter_event(const event_filters& filters, const queued_event& ev);
 
 		bool process_event(handler_ptr& handler_p, const queued_event& ev);
 
@@ -15,6 +15,7 @@
 
 #include "addon/manager.hpp" // for get_installed_addons
 #include "dialogs.hpp"
+#include "filesystem.hpp"
 #include "formula_string_utils.hpp"
 #include "game_preferences.hpp"
 #include "generators/map_create.hpp"
@@ -43,6 +44,7 @@
 #include "playmp_controller.hpp"
 #include "settings.hpp"
 #include "scripting/plugins/context.hpp"
+#include "serialization/parser.hpp"
 #include "sound.hpp"
 #include "statistics.hpp"
 #include "unit_id.hpp"
@@ -56,6 +58,7 @@ static lg::log_domain log_network("network");
 
 static lg::log_domain log_mp("mp/main");
 #define DBG_MP LOG_STREAM(debug, log_mp)
+#define ERR_MP LOG_STREAM(err, log_mp)
 
 namespace {
 
@@ -897,9 +900,44 @@ void start_local_game_commandline(game_display& disp, const config& game_config,
 	//resources::recorder->add_log_data("ai_log","ai_label",label);
 
 	unsigned int repeat = (cmdline_opts.multiplayer_repeat) ? *cmdline_opts.multiplayer_repeat : 1;
+
+	// When playing several games, or recording them, each gets its own
+	// seed. They are drawn before playing, so that with --rng-seed the
+	// same games are played again.
+	const bool batch = repeat > 1 || cmdline_opts.multiplayer_stats;
+	std::vector<int> seeds;
+	if (batch) {
+		for(unsigned int i = 0; i < repeat; i++){
+			seeds.push_back(rand());
+		}
+	}
+
+	config results;
 	for(unsigned int i = 0; i < repeat; i++){
 		saved_game state_copy(state);
-		play_game(disp, state_copy, game_config, game_config_manager::get()->terrain_types(), IO_SERVER, false, false);
+		if (batch) {
+			state_copy.set_random_seed(seeds[i]);
+			statistics::fresh_stats();
+		}
+		const LEVEL_RESULT result = play_game(disp, state_copy, game_config, game_config_manager::get()->terrain_types(), IO_SERVER, false, false);
+
+		if (cmdline_opts.multiplayer_stats) {
+			config& game = results.add_child("game");
+			game["number"] = i + 1;
+			game["label"] = label;
+			game["scenario"] = parameters.name;
+			game["seed"] = seeds[i];
+			game["result"] = LEVEL_RESULT_to_string(result);
+			game.add_child("statistics", statistics::write_stats());
+
+			// Written after every game, so that an aborted batch keeps its results.
+			try {
+				filesystem::scoped_ostream out = filesystem::ostream_file(*cmdline_opts.multiplayer_stats);
+				write(*out, results);
+			} catch(filesystem::io_exception& e) {
+				ERR_MP << "could not write the game statistics to " << *cmdline_opts.multiplayer_stats << ": " << e.what() << std::endl;
+			}
+		}
 	}
 }
 
@@ -15,6 +15,7 @@
 #include "game_launcher.hpp"
 #include "global.hpp"                   // for false_, bool_
 
+#include "ai/profiler.hpp"            // for profiler
 #include "about.hpp" //for show_about
 #include "commandline_options.hpp"      // for commandline_options
 #include "config.hpp"                   // for config, etc
@@ -48,6 +49,7 @@
 #include "game_initialization/playcampaign.hpp"             // for play_game, etc
 #include "preferences.hpp"              // for disable_preferences_save, etc
 #include "preferences_display.hpp"      // for detect_video_settings, etc
+#include "replay_controller.hpp"        // for validate_replay_level
 #include "savegame.hpp"                 // for clean_saves, etc
 #include "scripting/application_lua_kernel.hpp"
 #include "sdl/utils.hpp"                // for surface
@@ -197,14 +199,18 @@ game_launcher::game_launcher(const commandline_options& cmdline_opts, const char
 		}
 		preferences::set_draw_delay(fps);
 	}
-	if (cmdline_opts_.nogui || cmdline_opts_.headless_unit_test) {
+	if (cmdline_opts_.nogui || cmdline_opts_.headless_unit_test || cmdline_opts_.validate_replay) {
 		no_sound = true;
 		preferences::disable_preferences_save();
 	}
+	if (cmdline_opts_.ai_profile)
+		ai::profiler::set_enabled(true);
 	if (cmdline_opts_.new_widgets)
 		gui2::new_widgets = true;
 	if (cmdline_opts_.nodelay)
 		game_config::no_delay = true;
+	if (cmdline_opts_.render_benchmark)
+		game_config::render_benchmark_frames = *cmdline_opts_.render_benchmark;
 	if (cmdline_opts_.nomusic)
 		no_music = true;
 	if (cmdline_opts_.nosound)
@@ -370,8 +376,8 @@ bool game_launcher::init_language()
 
 bool game_launcher::init_video()
 {
-	if(cmdline_opts_.nogui || cmdline_opts_.headless_unit_test) {
-		if( !(cmdline_opts_.multiplayer || cmdline_opts_.screenshot || cmdline_opts_.plugin_file || cmdline_opts_.headless_unit_test) ) {
+	if(cmdline_opts_.nogui || cmdline_opts_.headless_unit_test || cmdline_opts_.validate_replay) {
+		if( !(cmdline_opts_.multiplayer || cmdline_opts_.screenshot || cmdline_opts_.plugin_file || cmdline_opts_.headless_unit_test || cmdline_opts_.validate_replay) ) {
 			std::cerr << "--nogui flag is only valid with --multiplayer or --screenshot or --plugin flags\n";
 			return false;
 		}
@@ -645,6 +651,73 @@ int game_launcher::unit_test()
 	return 0; //we passed, huzzah!
 }
 
+int game_launcher::validate_replays()
+{
+	int worst_result = 0;
+
+	BOOST_FOREACH(const std::string& name, *cmdline_opts_.validate_replay) {
+		const int start = SDL_GetTicks();
+		int result = 0;
+		std::string error;
+		std::vector<std::string> oos_errors;
+		bool incomplete = false;
+
+		clear_loaded_game();
+		game::load_game_exception::game = name;
+		game::load_game_exception::show_replay = true;
+		game::load_game_exception::cancel_orders = true;
+		game::load_game_exception::select_difficulty = false;
+		game::load_game_exception::difficulty.clear();
+		game::load_game_exception::skip_version_check = true;
+
+		try {
+			if (!load_game()) {
+				result = 3;
+			} else {
+				state_.get_replay().set_pos(0);
+				const LEVEL_RESULT res = validate_replay_level(game_config_manager::get()->game_config(),
+					game_config_manager::get()->terrain_types(), video_, state_, oos_errors);
+				incomplete = res != VICTORY;
+				result = oos_errors.empty() ? 0 : 1;
+			}
+		} catch(game::load_game_failed& e) {
+			error = e.message;
+			result = 3;
+		} catch(game::game_error& e) {
+			error = e.message;
+			result = 4;
+		} catch(incorrect_map_format_error& e) {
+			error = e.message;
+			result = 4;
+		} catch(twml_exception& e) {
+			error = e.dev_message;
+			result = 4;
+		} catch(quit_game_exception&) {
+			error = "the replay was aborted";
+			result = 4;
+		}
+		clear_loaded_game();
+
+		std::cout << (result == 0 ? "PASS REPLAY " : "FAIL REPLAY ")
+			<< (result == 1 ? "(OUT OF SYNC) " : "")
+			<< (result == 3 ? "(INVALID REPLAY) " : "")
+			<< (result == 4 ? "(ERRORED REPLAY) " : "")
+			<< (incomplete ? "(INCOMPLETE) " : "")
+			<< SDL_GetTicks() - start << " ms, "
+			<< oos_errors.size() << " out of sync errors: " << name << std::endl;
+		BOOST_FOREACH(const std::string& oos, oos_errors) {
+			std::cout << "\t" << oos << std::endl;
+		}
+		if (!error.empty()) {
+			std::cout << "\t" << error << std::endl;
+		}
+
+		worst_result = std::max(worst_result, result);
+	}
+
+	return worst_result;
+}
+
 bool game_launcher::play_screenshot_mode()
 {
 	if(!cmdline_opts_.screenshot) {
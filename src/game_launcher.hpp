@@ -68,6 +68,8 @@ public:
 	bool play_screenshot_mode();
 	bool play_render_image_mode();
 	int unit_test();
+	/** Replays the saves of --validate-replay, returning the exit code. */
+	int validate_replays();
 
 	bool is_loading() const;
 	void clear_loaded_game() { game::load_game_exception::game.clear(); }
@@ -56,6 +56,8 @@ typedef std::vector<std::vector<int> > height_map;
 typedef t_translation::t_map terrain_map;
 typedef map_location location;
 
+static void normalize_heights(height_map& res);
+
 /**
  * Generate a height-map.
  *
@@ -103,6 +105,13 @@ height_map default_map_generator_job::generate_height_map(size_t width, size_t h
 		}
 	}
 
+	// The rounded down distances for the squared distances inside a hill,
+	// so that the hills do not each take a square root per point.
+	std::vector<int> distances(2 * hill_size * hill_size + 1);
+	for(size_t d2 = 0; d2 != distances.size(); ++d2) {
+		distances[d2] = int(std::sqrt(double(d2)));
+	}
+
 	for(size_t i = 0; i != iterations; ++i) {
 
 		// (x1,y1) is the location of the hill,
@@ -139,27 +148,37 @@ height_map default_map_generator_job::generate_height_map(size_t width, size_t h
 		const int max_y = y1 + radius < static_cast<long>(res.front().size()) ? y1 + radius : res.front().size();
 
 		for(int x2 = min_x; x2 < max_x; ++x2) {
+			std::vector<int>& column = res[x2];
+			const int xdiff = (x2-x1);
 			for(int y2 = min_y; y2 < max_y; ++y2) {
-				const int xdiff = (x2-x1);
 				const int ydiff = (y2-y1);
 
-				const int height = radius - int(std::sqrt(double(xdiff*xdiff + ydiff*ydiff)));
+				const int height = radius - distances[xdiff*xdiff + ydiff*ydiff];
 
 				if(height > 0) {
 					if(is_valley) {
-						if(height > res[x2][y2]) {
-							res[x2][y2] = 0;
+						if(height > column[y2]) {
+							column[y2] = 0;
 						} else {
-							res[x2][y2] -= height;
+							column[y2] -= height;
 						}
 					} else {
-						res[x2][y2] += height;
+						column[y2] += height;
 					}
 				}
 			}
 		}
 	}
 
+	normalize_heights(res);
+	return res;
+}
+
+/**
+ * Normalizes the heights of @a res to the range 0-1000.
+ */
+static void normalize_heights(height_map& res)
+{
 	// Find the highest and lowest points on the map for normalization:
 	int heighest = 0, lowest = 100000, x;
 	for(x = 0; size_t(x) != res.size(); ++x) {
@@ -182,7 +201,95 @@ height_map default_map_generator_job::generate_height_map(size_t width, size_t h
 				res[x][y] /= heighest;
 		}
 	}
+}
+
+namespace {
+
+/** A pseudo-random value in [0,1) for the lattice point (x,y) of an octave. */
+double lattice_value(boost::uint32_t seed, int x, int y)
+{
+	boost::uint32_t h = seed ^ (static_cast<boost::uint32_t>(x) * 0x8da6b343u)
+		^ (static_cast<boost::uint32_t>(y) * 0xd8163841u);
+	h ^= h >> 16;
+	h *= 0x7feb352du;
+	h ^= h >> 15;
+	h *= 0x846ca68bu;
+	h ^= h >> 16;
+	return (h >> 8) / double(1 << 24);
+}
+
+double smooth(double t)
+{
+	return t * t * (3 - 2 * t);
+}
+
+} // end anon namespace
+
+/**
+ * Generate a height-map from fractal value noise.
+ *
+ * Each octave interpolates random values placed on a lattice, the first
+ * lattice having a point every 2*'hill_size' tiles, and each next octave
+ * having twice as many points and half the amplitude. Every tile is
+ * computed independently, in a single pass over the map. With an
+ * 'island_size', the height falls off with the distance beyond
+ * 'island_size' from the (possibly off-centered) center of the map, so
+ * that the map tends toward an island. The range of heights is normalized
+ * to 0-1000, as with generate_height_map().
+ */
+height_map default_map_generator_job::generate_noise_height_map(size_t width, size_t height,
+                               size_t hill_size, size_t island_size, size_t island_off_center)
+{
+	height_map res(width, std::vector<int>(height,0));
+
+	int center_x = width/2;
+	int center_y = height/2;
+	if(island_off_center != 0) {
+		switch(rng_()%4) {
+		case 0: center_x += island_off_center; break;
+		case 1: center_y += island_off_center; break;
+		case 2: center_x = std::max<int>(0, center_x - island_off_center); break;
+		case 3: center_y = std::max<int>(0, center_y - island_off_center); break;
+		}
+	}
+
+	const int first_period = std::max<int>(2, 2*hill_size);
+	std::vector<boost::uint32_t> seeds;
+	for(int period = first_period; period >= 2; period /= 2) {
+		seeds.push_back(rng_());
+	}
+
+	for(int x = 0; x != int(width); ++x) {
+		std::vector<int>& column = res[x];
+		for(int y = 0; y != int(height); ++y) {
+			double value = 0, amplitude = 1000;
+			int period = first_period;
+			for(size_t octave = 0; octave != seeds.size(); ++octave, period /= 2, amplitude /= 2) {
+				const int cell_x = x / period, cell_y = y / period;
+				const double fx = smooth(double(x % period) / period);
+				const double fy = smooth(double(y % period) / period);
+				const boost::uint32_t seed = seeds[octave];
+				const double top = lattice_value(seed, cell_x, cell_y) * (1 - fx) +
+					lattice_value(seed, cell_x + 1, cell_y) * fx;
+				const double bottom = lattice_value(seed, cell_x, cell_y + 1) * (1 - fx) +
+					lattice_value(seed, cell_x + 1, cell_y + 1) * fx;
+				value += amplitude * (top * (1 - fy) + bottom * fy);
+			}
+
+			if(island_size != 0) {
+				const int diffx = x - center_x;
+				const int diffy = y - center_y;
+				const double dist = std::sqrt(double(diffx*diffx + diffy*diffy));
+				if(dist > island_size) {
+					value -= 2000 * (dist - island_size) / island_size;
+				}
+			}
+
+			column[y] = std::max(0, int(value));
+		}
+	}
 
+	normalize_heights(res);
 	return res;
 }
 
@@ -777,7 +884,10 @@ std::string default_map_generator_job::default_generate_map(size_t width, size_t
 
 	LOG_NG << "generating height map...\n";
 	// Generate the height of everything.
-	const height_map heights = generate_height_map(width,height,iterations,hill_size,island_size,island_off_center);
+	// height_engine=noise selects the fractal noise over the hills.
+	const height_map heights = cfg["height_engine"] == "noise" ?
+		generate_noise_height_map(width,height,hill_size,island_size,island_off_center) :
+		generate_height_map(width,height,iterations,hill_size,island_size,island_off_center);
 	LOG_NG << "done generating height map...\n";
 	LOG_NG << (SDL_GetTicks() - ticks) << "\n"; ticks = SDL_GetTicks();
 
@@ -56,6 +56,9 @@ private:
 	height_map generate_height_map(size_t width, size_t height,
                                size_t iterations, size_t hill_size,
 							   size_t island_size, size_t island_off_center);
+	/** As generate_height_map(), from fractal noise rather than hills, in linear time. */
+	height_map generate_noise_height_map(size_t width, size_t height, size_t hill_size,
+							   size_t island_size, size_t island_off_center);
 
 	bool generate_lake(t_translation::t_map& terrain, int x, int y, int lake_fall_off, std::set<map_location>& locs_touched);
 	map_location random_point_at_side(size_t width, size_t height);
@@ -11,7 +11,7 @@
 yamg_hexheap::yamg_hexheap(size_t taille)
     : last_(0)
     , max_(taille - 2)
-    , table_(new yamg_hex *[taille * sizeof(yamg_hex *)])
+    , table_(new entry[taille])
 {
 }
 
@@ -21,12 +21,13 @@ yamg_hexheap::yamg_hexheap(size_t taille)
 yamg_hexheap::~yamg_hexheap()
 {
     //dtor
-    delete table_;
+    delete[] table_;
 }
 
 /**
     Add an hex to the heap
     Note this function sets the done flag of the hex. This not only prevent heap overflow, but helps in various cases: no hex can be inserted more than once.
+    The key is read when inserting: the key of an hex must not change while it is in the heap (except through update_hexes).
 
     -> ptr to the hex to add
 */
@@ -35,18 +36,20 @@ void yamg_hexheap::add_hex(yamg_hex *h) {
 	if((last_ >= max_) || (h->done)) // overflow shield
         return;
 
+	const int key = h->key;
 	int i = last_++;
 
 	while(i > 0)
 	{
 		int j = i / 2; // searching father of this element
-		if( table_[j]->key <= h->key)
+		if( table_[j].key <= key)
 			break; // insert is finished
 
 		table_[i]   = table_[j];
 		i   =  j;
 	}
-	table_[i] = h;
+	table_[i].key = key;
+	table_[i].hex = h;
     h->done = true;
 }
 
@@ -56,23 +59,22 @@ void yamg_hexheap::add_hex(yamg_hex *h) {
     <- ptr on the element
 */
 yamg_hex *yamg_hexheap::pick_hex() {
-yamg_hex *h, *res;
 
 	  if( table_ == NULL || last_ == 0 )
 		  return NULL;
 
-      res = table_[0];
+      yamg_hex *res = table_[0].hex;
 
-	  h = table_[--last_];
+	  const entry h = table_[--last_];
 	  int i = 0;
 	  int j = 1;
 	  int k;
 	  while( j < last_ ) {
 		  // select the correct son
 		  k = j + 1;
-		  if( (k < last_) && ( table_[j]->key > table_[k]->key) )
+		  if( (k < last_) && ( table_[j].key > table_[k].key) )
 			  j = k;
-		  if(h->key <= table_[j]->key) break;
+		  if(h.key <= table_[j].key) break;
 		  table_[i] = table_[j];
 		  i = j; j *= 2;
 	  }
@@ -87,8 +89,10 @@ yamg_hex *h, *res;
 */
 void yamg_hexheap::update_hexes(int val) {
 
-    for(int i = 0; i < last_; i++)
-        table_[i]->key += val;
+    for(int i = 0; i < last_; i++) {
+        table_[i].key += val;
+        table_[i].hex->key += val;
+    }
 }
 
 /**
@@ -97,7 +101,7 @@ void yamg_hexheap::update_hexes(int val) {
 */
 int yamg_hexheap::test_hex() {
     if(last_ > 0)
-        return table_[0]->key;
+        return table_[0].key;
     else
         return -1;
 }
@@ -107,6 +111,6 @@ int yamg_hexheap::test_hex() {
 */
 void yamg_hexheap::clear_heap() {
     for(int i = 0; i < last_; i++)
-        table_[i]->done = false;
+        table_[i].hex->done = false;
     last_ = 0;
 }
@@ -44,8 +44,14 @@ public:
     void clear_heap();           ///< clear the heap and reset all items 'done' flag in it.
 
 protected:
+	/// A hex and its key, kept side by side so that sifting does not read the hexes.
+	struct entry {
+		int key;
+		yamg_hex *hex;
+	};
+
 	//*********** Members ************
-	yamg_hex **table_;          ///< holds the pointers table
+	entry *table_;              ///< holds the entries table
 
 private:
 };
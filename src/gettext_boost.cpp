@@ -15,11 +15,15 @@
 #include "global.hpp"
 #include "gettext.hpp"
 #include "log.hpp"
+#include "thread.hpp"
 
+#include <cstring>
 #include <iostream>
 #include <locale>
 #include <boost/locale.hpp>
 #include <boost/foreach.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/unordered_map.hpp>
 #include <set>
 
 #define DBG_G LOG_STREAM(debug, lg::general)
@@ -65,6 +69,25 @@ namespace
 
 		std::string name_;
 	};
+	/** Hashes the strings and the C strings alike, to look the latter up without copying them. */
+	struct string_hash
+	{
+		size_t operator()(const std::string& s) const
+		{ return boost::hash_range(s.begin(), s.end()); }
+		size_t operator()(const char* s) const
+		{ return boost::hash_range(s, s + std::strlen(s)); }
+	};
+
+	struct string_equal
+	{
+		bool operator()(const std::string& a, const std::string& b) const
+		{ return a == b; }
+		bool operator()(const char* a, const std::string& b) const
+		{ return b == a; }
+		bool operator()(const std::string& a, const char* b) const
+		{ return a == b; }
+	};
+
 	struct translation_manager
 	{
 		translation_manager()
@@ -74,6 +97,8 @@ namespace
 			, generator_()
 			, current_locale_()
 			, is_dirty_(true)
+			, translations_()
+			, mutex_()
 		{
 			current_language_ = default_utf8_locale_name::name();
 			const bl::localization_backend_manager& g_mgr = bl::localization_backend_manager::global();
@@ -167,6 +192,7 @@ namespace
 				      << "'" << std::endl;
 			}
 			is_dirty_ = false;
+			translations_.clear();
 		}
 
 		const std::locale& get_locale()
@@ -178,6 +204,27 @@ namespace
 			return current_locale_;
 		}
 
+		/**
+		 * The translation of @a msgid in @a domain, looked up in the
+		 * messages of boost::locale only the first time it is asked for
+		 * in the current locale.
+		 */
+		std::string translate(const char* domain, const char* msgid)
+		{
+			threading::lock lock(mutex_);
+			const std::locale& locale = get_locale();
+			domain_map::iterator d = translations_.find(domain, string_hash(), string_equal());
+			if(d == translations_.end()) {
+				d = translations_.insert(domain_map::value_type(domain, message_map())).first;
+			}
+			message_map::const_iterator m = d->second.find(msgid, string_hash(), string_equal());
+			if(m == d->second.end()) {
+				m = d->second.insert(message_map::value_type(msgid,
+					boost::locale::dgettext(domain, msgid, locale))).first;
+			}
+			return m->second;
+		}
+
 	private:
 		std::set<std::string> loaded_paths_;
 		std::set<std::string> loaded_domains_;
@@ -185,6 +232,12 @@ namespace
 		boost::locale::generator generator_;
 		std::locale current_locale_;
 		bool is_dirty_;
+
+		typedef boost::unordered_map<std::string, std::string, string_hash, string_equal> message_map;
+		typedef boost::unordered_map<std::string, message_map, string_hash, string_equal> domain_map;
+		/** The translations looked up in current_locale_, by domain and message id. */
+		domain_map translations_;
+		threading::mutex mutex_;
 	};
 
 	translation_manager& get_manager()
@@ -200,7 +253,7 @@ namespace translation
 
 std::string dgettext(const char* domain, const char* msgid)
 {
-	return boost::locale::dgettext(domain, msgid, get_manager().get_locale());
+	return get_manager().translate(domain, msgid);
 }
 std::string egettext(char const *msgid)
 {
@@ -25,6 +25,7 @@
 #include "../../image.hpp"
 #include "formatter.hpp"
 #include "gettext.hpp"
+#include "gui/auxiliary/draw_profiler.hpp"
 #include "gui/auxiliary/formula.hpp"
 #include "gui/auxiliary/log.hpp"
 #include "gui/widgets/helper.hpp"
@@ -1466,6 +1467,8 @@ void tcanvas::draw(const bool force)
 		return;
 	}
 
+	const tdraw_profiler::tscope profiler_scope(tdraw_profiler::CANVAS);
+
 	if(is_dirty_) {
 		get_screen_size_variables(variables_);
 		variables_.add("width", variant(w_));
@@ -1512,6 +1515,21 @@ void tcanvas::blit(surface& surf, SDL_Rect rect)
 	sdl_blit(canvas_, NULL, surf, &rect);
 }
 
+void tcanvas::set_variable(const std::string& key, const variant& value)
+{
+	const variant old = variables_.query_value(key);
+
+	// Comparing a string with a decimal would throw.
+	if(!old.is_null() && old.is_string() == value.is_string()
+	   && old.is_decimal() == value.is_decimal() && old == value) {
+
+		return;
+	}
+
+	variables_.add(key, value);
+	set_is_dirty(true);
+}
+
 void tcanvas::parse_cfg(const config& cfg)
 {
 	log_scope2(log_gui_parse, "Canvas: parsing config.");
@@ -111,8 +111,10 @@ public:
 
 	void set_width(const unsigned width)
 	{
-		w_ = width;
-		set_is_dirty(true);
+		if(width != w_) {
+			w_ = width;
+			set_is_dirty(true);
+		}
 	}
 	unsigned get_width() const
 	{
@@ -121,8 +123,10 @@ public:
 
 	void set_height(const unsigned height)
 	{
-		h_ = height;
-		set_is_dirty(true);
+		if(height != h_) {
+			h_ = height;
+			set_is_dirty(true);
+		}
 	}
 	unsigned get_height() const
 	{
@@ -134,11 +138,13 @@ public:
 		return canvas_;
 	}
 
-	void set_variable(const std::string& key, const variant& value)
-	{
-		variables_.add(key, value);
-		set_is_dirty(true);
-	}
+	/**
+	 * Sets a variable of the formulas.
+	 *
+	 * The controls set all their variables again at every layout, the
+	 * canvas is only redrawn when a value actually changes.
+	 */
+	void set_variable(const std::string& key, const variant& value);
 
 private:
 	/** Vector with the shapes to draw. */
@@ -0,0 +1,180 @@
+/*
+   Copyright (C) 2015 by the Battle for Wesnoth Project
+   Part of the Battle for Wesnoth Project http://www.wesnoth.org/
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY.
+
+   See the COPYING file for more details.
+*/
+
+#include "gui/auxiliary/draw_profiler.hpp"
+
+#include "sdl/rect.hpp"
+#include "video.hpp"
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/foreach.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+namespace gui2
+{
+
+bool tdraw_profiler::enabled_ = false;
+bool tdraw_profiler::show_heat_ = false;
+
+namespace
+{
+
+const char* const category_names[tdraw_profiler::CATEGORY_COUNT]
+		= { "window draws", "layouts", "canvas redraws", "events" };
+
+/** The alpha of the tint of a widget redrawn. */
+const Uint8 heat_alpha = 48;
+
+struct trecord
+{
+	trecord() : calls(0), microseconds(0), frame_microseconds(0), longest(0)
+	{
+	}
+
+	size_t calls;
+	long microseconds;
+	/** The time of the current frame and the longest one. */
+	long frame_microseconds;
+	long longest;
+};
+
+trecord records[tdraw_profiler::CATEGORY_COUNT];
+
+/** The scopes of each category entered and not left yet. */
+unsigned depths[tdraw_profiler::CATEGORY_COUNT] = { 0 };
+
+size_t frames = 0;
+size_t widgets_redrawn = 0;
+
+/** The areas redrawn during the current frame, for the heat overlay. */
+std::vector<SDL_Rect> redrawn_areas;
+
+boost::posix_time::ptime now()
+{
+	return boost::posix_time::microsec_clock::universal_time();
+}
+
+} // namespace
+
+tdraw_profiler::tscope::tscope(const tcategory category, const bool measured)
+	: category_(category), measured_(measured && enabled_), start_()
+{
+	if(measured_ && depths[category_]++ == 0) {
+		start_ = now();
+	}
+}
+
+tdraw_profiler::tscope::~tscope()
+{
+	// Profiling might have been toggled meanwhile.
+	if(!measured_ || !enabled_ || depths[category_] == 0) {
+		return;
+	}
+
+	const bool outermost = --depths[category_] == 0;
+	if(!start_.is_not_a_date_time()) {
+		assert(outermost);
+		const long microseconds = (now() - start_).total_microseconds();
+		records[category_].microseconds += microseconds;
+		records[category_].frame_microseconds += microseconds;
+	}
+	++records[category_].calls;
+}
+
+void tdraw_profiler::set_enabled(const bool enabled)
+{
+	if(enabled != enabled_) {
+		enabled_ = enabled;
+		std::fill(depths, depths + CATEGORY_COUNT, 0);
+		redrawn_areas.clear();
+	}
+}
+
+void tdraw_profiler::set_show_heat(const bool show_heat)
+{
+	show_heat_ = show_heat;
+}
+
+void tdraw_profiler::reset()
+{
+	std::fill(records, records + CATEGORY_COUNT, trecord());
+	frames = 0;
+	widgets_redrawn = 0;
+}
+
+void tdraw_profiler::widget_redrawn(const SDL_Rect& rect)
+{
+	if(!enabled_) {
+		return;
+	}
+
+	++widgets_redrawn;
+	if(show_heat_) {
+		redrawn_areas.push_back(rect);
+	}
+}
+
+void tdraw_profiler::end_frame(surface& frame_buffer)
+{
+	if(!enabled_) {
+		return;
+	}
+
+	++frames;
+	BOOST_FOREACH(trecord & record, records)
+	{
+		record.longest = std::max(record.longest, record.frame_microseconds);
+		record.frame_microseconds = 0;
+	}
+
+	if(!frame_buffer || redrawn_areas.empty()) {
+		return;
+	}
+
+	const Uint32 color = SDL_MapRGB(frame_buffer->format, 255, 0, 0);
+	BOOST_FOREACH(SDL_Rect & rect, redrawn_areas)
+	{
+		sdl::fill_rect_alpha(rect, color, heat_alpha, frame_buffer);
+		update_rect(rect);
+	}
+	redrawn_areas.clear();
+}
+
+std::string tdraw_profiler::summary()
+{
+	std::ostringstream stream;
+	stream << frames << " GUI frames";
+	if(frames == 0) {
+		return stream.str();
+	}
+
+	stream << std::fixed << std::setprecision(2)
+		   << ", per frame: " << double(widgets_redrawn) / frames
+		   << " widgets redrawn";
+	for(int category = 0; category != CATEGORY_COUNT; ++category) {
+		const trecord& record = records[category];
+		stream << "\n" << category_names[category] << ": "
+			   << double(record.calls) / frames << " in "
+			   << record.microseconds / 1000.0 / frames << " ms, longest "
+			   << record.longest / 1000.0 << " ms";
+	}
+	return stream.str();
+}
+
+} // namespace gui2
@@ -0,0 +1,120 @@
+/*
+   Copyright (C) 2015 by the Battle for Wesnoth Project
+   Part of the Battle for Wesnoth Project http://www.wesnoth.org/
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY.
+
+   See the COPYING file for more details.
+*/
+
+/**
+ * @file
+ * Timing and counters of the drawing of the GUI2 windows.
+ */
+
+#ifndef GUI_AUXILIARY_DRAW_PROFILER_HPP_INCLUDED
+#define GUI_AUXILIARY_DRAW_PROFILER_HPP_INCLUDED
+
+#include "sdl/utils.hpp"
+
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/noncopyable.hpp>
+
+#include <string>
+
+namespace gui2
+{
+
+/**
+ * Where the time of the GUI2 frames goes.
+ *
+ * For each frame drawn by the event handler, the profiler counts the
+ * windows drawn, the layouts, the canvases redrawn and the events
+ * dispatched, along with the time they took, and the widgets redrawn. The
+ * heat overlay tints the area of every widget redrawn, so the areas redrawn
+ * by several widgets, or at every frame, stand out.
+ *
+ * Profiling is off unless enabled with the :gui_profile command; the hooks
+ * then cost a flag test. Like the rest of GUI2, it must only be used from
+ * the main thread.
+ */
+class tdraw_profiler
+{
+public:
+	/** What is being measured. */
+	enum tcategory {
+		DRAW,
+		LAYOUT,
+		CANVAS,
+		EVENT,
+		CATEGORY_COUNT
+	};
+
+	/**
+	 * Counts a call of @a category and adds the time of its lifetime to
+	 * it, if profiling is enabled.
+	 *
+	 * The time of nested scopes of the same category, like events fired
+	 * while handling an event, is only counted once.
+	 *
+	 * @param category            The category measured.
+	 * @param measured            Whether to measure anything at all, for the
+	 *                            callers measuring only some of their calls.
+	 */
+	class tscope : private boost::noncopyable
+	{
+	public:
+		explicit tscope(const tcategory category, const bool measured = true);
+		~tscope();
+
+	private:
+		tcategory category_;
+		bool measured_;
+		boost::posix_time::ptime start_;
+	};
+
+	static bool enabled()
+	{
+		return enabled_;
+	}
+
+	static void set_enabled(const bool enabled);
+
+	static bool show_heat()
+	{
+		return show_heat_;
+	}
+
+	static void set_show_heat(const bool show_heat);
+
+	/** Drops everything recorded so far. */
+	static void reset();
+
+	/** Counts a widget redrawn, covering @a rect of the screen. */
+	static void widget_redrawn(const SDL_Rect& rect);
+
+	/**
+	 * Ends the frame drawn on @a frame_buffer, drawing the heat overlay
+	 * if it's shown.
+	 */
+	static void end_frame(surface& frame_buffer);
+
+	/**
+	 * The frames recorded, and for each category the calls and the time
+	 * per frame and the longest frame.
+	 */
+	static std::string summary();
+
+private:
+	static bool enabled_;
+	static bool show_heat_;
+};
+
+} // namespace gui2
+
+#endif
@@ -16,6 +16,7 @@
 
 #include "gui/auxiliary/event/dispatcher_private.hpp"
 
+#include "gui/auxiliary/draw_profiler.hpp"
 #include "gui/auxiliary/log.hpp"
 
 namespace gui2
@@ -144,6 +145,10 @@ public:
 bool tdispatcher::fire(const tevent event, twidget& target)
 {
 	assert(find<tset_event>(event, tevent_in_set()));
+
+	// Drawing is measured by the windows.
+	const tdraw_profiler::tscope scope(tdraw_profiler::EVENT, event != DRAW);
+
 	switch(event) {
 		case LEFT_BUTTON_DOUBLE_CLICK:
 			return fire_event_double_click<LEFT_BUTTON_CLICK,
@@ -200,6 +205,7 @@ bool
 tdispatcher::fire(const tevent event, twidget& target, const tpoint& coordinate)
 {
 	assert(find<tset_event_mouse>(event, tevent_in_set()));
+	const tdraw_profiler::tscope scope(tdraw_profiler::EVENT);
 	return fire_event<tsignal_mouse_function>(event,
 											  dynamic_cast<twidget*>(this),
 											  &target,
@@ -239,6 +245,7 @@ bool tdispatcher::fire(const tevent event,
 					   const utf8::string& unicode)
 {
 	assert(find<tset_event_keyboard>(event, tevent_in_set()));
+	const tdraw_profiler::tscope scope(tdraw_profiler::EVENT);
 	return fire_event<tsignal_keyboard_function>(
 			event,
 			dynamic_cast<twidget*>(this),
@@ -263,6 +270,7 @@ public:
 bool tdispatcher::fire(const tevent event, twidget& target, void*)
 {
 	assert(find<tset_event_notification>(event, tevent_in_set()));
+	const tdraw_profiler::tscope scope(tdraw_profiler::EVENT);
 	return fire_event<tsignal_notification_function>(
 			event,
 			dynamic_cast<twidget*>(this),
@@ -294,6 +302,7 @@ private:
 bool tdispatcher::fire(const tevent event, twidget& target, tmessage& message)
 {
 	assert(find<tset_event_message>(event, tevent_in_set()));
+	const tdraw_profiler::tscope scope(tdraw_profiler::EVENT);
 	return fire_event<tsignal_message_function>(event,
 												dynamic_cast<twidget*>(this),
 												&target,
@@ -17,6 +17,7 @@
 #include "gui/auxiliary/event/handler.hpp"
 
 #include "gui/auxiliary/event/dispatcher.hpp"
+#include "gui/auxiliary/draw_profiler.hpp"
 #include "gui/auxiliary/timer.hpp"
 #include "gui/auxiliary/log.hpp"
 #include "gui/widgets/helper.hpp"
@@ -541,6 +542,7 @@ void thandler::draw(const bool force)
 
 		surface frame_buffer = video.getSurface();
 
+		tdraw_profiler::end_frame(frame_buffer);
 		cursor::draw(frame_buffer);
 		video.flip();
 		cursor::undraw(frame_buffer);
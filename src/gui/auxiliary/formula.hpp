@@ -129,7 +129,9 @@ private:
 	/**
 	 * Contains the formula for the variable.
 	 *
-	 * If the string is empty, there's no formula.
+	 * If the string is empty, there's no formula. The formula is parsed once
+	 * for all the widgets sharing the definition, the parsed formula comes
+	 * from the cache of @ref game_logic::formula::get_cached().
 	 */
 	std::string formula_;
 
@@ -172,8 +174,8 @@ inline bool
 tformula<bool>::execute(const game_logic::map_formula_callable& variables,
 						game_logic::function_symbol_table* functions) const
 {
-	return game_logic::formula(formula_, functions)
-			.evaluate(variables)
+	return game_logic::formula::get_cached(formula_, functions)
+			->evaluate(variables)
 			.as_bool();
 }
 
@@ -182,8 +184,8 @@ inline int
 tformula<int>::execute(const game_logic::map_formula_callable& variables,
 					   game_logic::function_symbol_table* functions) const
 {
-	return game_logic::formula(formula_, functions)
-			.evaluate(variables)
+	return game_logic::formula::get_cached(formula_, functions)
+			->evaluate(variables)
 			.as_int();
 }
 
@@ -192,8 +194,8 @@ inline unsigned
 tformula<unsigned>::execute(const game_logic::map_formula_callable& variables,
 							game_logic::function_symbol_table* functions) const
 {
-	return game_logic::formula(formula_, functions)
-			.evaluate(variables)
+	return game_logic::formula::get_cached(formula_, functions)
+			->evaluate(variables)
 			.as_int();
 }
 
@@ -202,8 +204,8 @@ inline std::string tformula<std::string>::execute(
 		const game_logic::map_formula_callable& variables,
 		game_logic::function_symbol_table* functions) const
 {
-	return game_logic::formula(formula_, functions)
-			.evaluate(variables)
+	return game_logic::formula::get_cached(formula_, functions)
+			->evaluate(variables)
 			.as_string();
 }
 
@@ -212,8 +214,8 @@ inline t_string
 tformula<t_string>::execute(const game_logic::map_formula_callable& variables,
 							game_logic::function_symbol_table* functions) const
 {
-	return game_logic::formula(formula_, functions)
-			.evaluate(variables)
+	return game_logic::formula::get_cached(formula_, functions)
+			->evaluate(variables)
 			.as_string();
 }
 
@@ -222,9 +224,10 @@ inline PangoAlignment tformula<PangoAlignment>::execute(
 		const game_logic::map_formula_callable& variables,
 		game_logic::function_symbol_table* functions) const
 {
-	return decode_text_alignment(game_logic::formula(formula_, functions)
-										 .evaluate(variables)
-										 .as_string());
+	return decode_text_alignment(
+			game_logic::formula::get_cached(formula_, functions)
+					->evaluate(variables)
+					.as_string());
 }
 
 template <class T>
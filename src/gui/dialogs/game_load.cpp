@@ -22,6 +22,7 @@
 #include "game_preferences.hpp"
 #include "game_classification.hpp"
 #include "gui/auxiliary/log.hpp"
+#include "gui/auxiliary/timer.hpp"
 #include "gui/dialogs/field.hpp"
 #include "gui/dialogs/game_delete.hpp"
 #include "gui/dialogs/helper.hpp"
@@ -47,6 +48,10 @@
 namespace gui2
 {
 
+/** The rows added to the list at once, and how often the next ones are. */
+static const size_t list_page_size = 50;
+static const Uint32 list_page_interval = 50;
+
 /*WIKI
  * @page = GUIWindowDefinitionWML
  * @order = 2_game_load
@@ -103,7 +108,16 @@ tgame_load::tgame_load(const config& cache_config)
 	, games_()
 	, cache_config_(cache_config)
 	, last_words_()
+	, timer_id_(0)
+{
+}
+
+tgame_load::~tgame_load()
 {
+	if(timer_id_) {
+		remove_timer(timer_id_);
+	}
+	savegame::save_index_manager.stop_prefetch();
 }
 
 void tgame_load::pre_show(CVideo& /*video*/, twindow& window)
@@ -136,7 +150,14 @@ void tgame_load::pre_show(CVideo& /*video*/, twindow& window)
 		cursor::setter cur(cursor::WAIT);
 		games_ = savegame::get_saves_list();
 	}
-	fill_game_list(window, games_);
+	// The saves are listed newest first, those are read first too.
+	savegame::save_index_manager.prefetch(games_);
+	fill_game_list(window);
+	timer_id_ = add_timer(list_page_interval,
+						  boost::bind(&tgame_load::timer_callback,
+									  this,
+									  boost::ref(window)),
+						  true);
 
 	connect_signal_mouse_left_click(
 			find_widget<tbutton>(&window, "delete", false),
@@ -147,14 +168,16 @@ void tgame_load::pre_show(CVideo& /*video*/, twindow& window)
 	display_savegame(window);
 }
 
-void tgame_load::fill_game_list(twindow& window,
-								std::vector<savegame::save_info>& games)
+void tgame_load::fill_game_list(twindow& window)
 {
 	tlistbox& list = find_widget<tlistbox>(&window, "savegame_list", false);
-	list.clear();
 
-	FOREACH(const AUTO & game, games)
-	{
+	// The rows of the list are those of the first games_.
+	const size_t first = list.get_item_count();
+	const size_t last = std::min(games_.size(), first + list_page_size);
+	for(size_t i = first; i < last; ++i) {
+		const savegame::save_info& game = games_[i];
+
 		std::map<std::string, string_map> data;
 		string_map item;
 
@@ -165,7 +188,19 @@ void tgame_load::fill_game_list(twindow& window,
 		data.insert(std::make_pair("date", item));
 
 		list.add_row(data);
+		if(!matches_filter(game.name())) {
+			list.set_row_shown(i, false);
+		}
+	}
+}
+
+void tgame_load::timer_callback(twindow& window)
+{
+	if(find_widget<tlistbox>(&window, "savegame_list", false).get_item_count()
+	   < games_.size()) {
+		fill_game_list(window);
 	}
+	savegame::save_index_manager.collect_prefetched();
 }
 
 void tgame_load::list_item_clicked(twindow& window)
@@ -187,32 +222,8 @@ bool tgame_load::filter_text_changed(ttext_* textbox, const std::string& text)
 
 	std::vector<bool> show_items(list.get_item_count(), true);
 
-	if(!text.empty()) {
-		for(unsigned int i = 0; i < list.get_item_count(); i++) {
-			tgrid* row = list.get_row_grid(i);
-
-			tgrid::iterator it = row->begin();
-			tlabel& filename_label
-					= find_widget<tlabel>(*it, "filename", false);
-
-			bool found = false;
-			FOREACH(const AUTO & word, words)
-			{
-				found = std::search(filename_label.label().str().begin(),
-									filename_label.label().str().end(),
-									word.begin(),
-									word.end(),
-									chars_equal_insensitive)
-						!= filename_label.label().str().end();
-
-				if(!found) {
-					// one word doesn't match, we don't reach words.end()
-					break;
-				}
-			}
-
-			show_items[i] = found;
-		}
+	for(unsigned int i = 0; i < list.get_item_count(); i++) {
+		show_items[i] = matches_filter(games_[i].name());
 	}
 
 	list.set_row_shown(show_items);
@@ -220,8 +231,27 @@ bool tgame_load::filter_text_changed(ttext_* textbox, const std::string& text)
 	return false;
 }
 
+bool tgame_load::matches_filter(const std::string& name) const
+{
+	FOREACH(const AUTO & word, last_words_)
+	{
+		if(std::search(name.begin(),
+					   name.end(),
+					   word.begin(),
+					   word.end(),
+					   chars_equal_insensitive) == name.end()) {
+			// one word doesn't match
+			return false;
+		}
+	}
+	return true;
+}
+
 void tgame_load::post_show(twindow& window)
 {
+	remove_timer(timer_id_);
+	timer_id_ = 0;
+
 	change_difficulty_ = chk_change_difficulty_->get_widget_value(window);
 	show_replay_ = chk_show_replay_->get_widget_value(window);
 	cancel_orders_ = chk_cancel_orders_->get_widget_value(window);
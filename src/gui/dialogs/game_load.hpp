@@ -29,6 +29,8 @@ class tgame_load : public tdialog
 public:
 	explicit tgame_load(const config& cache_config);
 
+	~tgame_load();
+
 	const std::string& filename() const
 	{
 		return filename_;
@@ -64,8 +66,17 @@ private:
 	void display_savegame(twindow& window);
 	void evaluate_summary_string(std::stringstream& str,
 								 const config& cfg_summary);
-	void fill_game_list(twindow& window,
-						std::vector<savegame::save_info>& games);
+	/** Adds the next page of games_ to the list. */
+	void fill_game_list(twindow& window);
+
+	/** Whether the save @a name matches the words of the filter. */
+	bool matches_filter(const std::string& name) const;
+
+	/**
+	 * Adds the pages of games_ not listed yet, and the summaries read in
+	 * the background to the save index.
+	 */
+	void timer_callback(twindow& window);
 
 	tfield_text* txtFilter_;
 	tfield_bool* chk_change_difficulty_;
@@ -81,6 +92,9 @@ private:
 	const config& cache_config_;
 
 	std::vector<std::string> last_words_;
+
+	/** The id of the timer of timer_callback(), 0 when not running. */
+	size_t timer_id_;
 };
 }
 
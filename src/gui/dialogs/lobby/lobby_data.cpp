@@ -19,6 +19,7 @@
 #include "filesystem.hpp"
 #include "formula_string_utils.hpp"
 #include "gettext.hpp"
+#include "hash.hpp"
 #include "network.hpp"
 #include "log.hpp"
 #include "map.hpp"
@@ -163,7 +164,75 @@ std::string make_short_name(const std::string& long_name)
 
 } // end anonymous namespace
 
-game_info::game_info(const config& game, const config& game_config)
+game_info_lookups::game_info_lookups(const config& game_config)
+	: game_config_(game_config)
+	, tdata_()
+	, children_()
+	, map_files_()
+	, map_sizes_()
+{
+}
+
+const config& game_info_lookups::find_child(const std::string& key, const std::string& id)
+{
+	const std::pair<std::string, std::string> child(key, id);
+	std::map<std::pair<std::string, std::string>, const config*>::const_iterator itor
+			= children_.find(child);
+	if(itor == children_.end()) {
+		itor = children_.insert(std::make_pair(child,
+				&game_config_.find_child(key, "id", id))).first;
+	}
+	return *itor->second;
+}
+
+const std::string& game_info_lookups::read_map(const std::string& scenario)
+{
+	std::map<std::string, std::string>::const_iterator itor = map_files_.find(scenario);
+	if(itor == map_files_.end()) {
+		itor = map_files_.insert(std::make_pair(scenario,
+				filesystem::read_map(scenario))).first;
+	}
+	return itor->second;
+}
+
+bool game_info_lookups::map_size(const std::string& map_data, std::string& size_info)
+{
+	const boost::uint64_t key = util::content_hash(map_data);
+	std::map<boost::uint64_t, std::pair<bool, std::string> >::const_iterator itor
+			= map_sizes_.find(key);
+	if(itor != map_sizes_.end()) {
+		size_info = itor->second.second;
+		return itor->second.first;
+	}
+
+	if(!tdata_) {
+		tdata_ = boost::make_shared<terrain_type_data>(game_config_);
+	}
+	bool valid = false;
+	size_info.clear();
+	try
+	{
+		gamemap map(tdata_, map_data);
+		// mini_map = image::getMinimap(minimap_size_, minimap_size_, map,
+		// 0);
+		std::ostringstream msi;
+		msi << map.w() << utils::unicode_multiplication_sign << map.h();
+		size_info = msi.str();
+		valid = true;
+	}
+	catch(incorrect_map_format_error& e)
+	{
+		ERR_CF << "illegal map: " << e.message << std::endl;
+	}
+	catch(twml_exception& e)
+	{
+		ERR_CF << "map could not be loaded: " << e.dev_message << '\n';
+	}
+	map_sizes_.insert(std::make_pair(key, std::make_pair(valid, size_info)));
+	return valid;
+}
+
+game_info::game_info(const config& game, game_info_lookups& lookups)
 	: mini_map()
 	, id(game["id"])
 	, map_data(game["map_data"])
@@ -200,8 +269,7 @@ game_info::game_info(const config& game, const config& game_config)
 {
 	std::string turn = game["turn"];
 	if(!game["mp_era"].empty()) {
-		const config& era_cfg
-				= game_config.find_child("era", "id", game["mp_era"]);
+		const config& era_cfg = lookups.find_child("era", game["mp_era"]);
 		utils::string_map symbols;
 		symbols["era_id"] = game["mp_era"];
 		if(era_cfg) {
@@ -226,8 +294,7 @@ game_info::game_info(const config& game, const config& game_config)
 	if(!game.child_or_empty("modification").empty()) {
 		BOOST_FOREACH(const config &cfg, game.child_range("modification")) {
 			if (cfg["require_modification"].to_bool(false)) {
-				const config &mod = game_config.find_child("modification", "id",
-														   cfg["id"]);
+				const config &mod = lookups.find_child("modification", cfg["id"]);
 				if (!mod) {
 					have_all_mods = false;
 					break;
@@ -237,44 +304,25 @@ game_info::game_info(const config& game, const config& game_config)
 	}
 
 	if(map_data.empty()) {
-		map_data = filesystem::read_map(game["mp_scenario"]);
+		map_data = lookups.read_map(game["mp_scenario"]);
 	}
 
 	if(map_data.empty()) {
 		map_info += " — ??×??";
+	} else if(lookups.map_size(map_data, map_size_info)) {
+		map_info += " — " + map_size_info;
 	} else {
-		try
-		{
-			gamemap map(boost::make_shared<terrain_type_data>(game_config), map_data);
-			// mini_map = image::getMinimap(minimap_size_, minimap_size_, map,
-			// 0);
-			std::ostringstream msi;
-			msi << map.w() << utils::unicode_multiplication_sign << map.h();
-			map_size_info = msi.str();
-			map_info += " — " + map_size_info;
-		}
-		catch(incorrect_map_format_error& e)
-		{
-			ERR_CF << "illegal map: " << e.message << std::endl;
-			verified = false;
-		}
-		catch(twml_exception& e)
-		{
-			ERR_CF << "map could not be loaded: " << e.dev_message << '\n';
-			verified = false;
-		}
+		verified = false;
 	}
 	map_info += " ";
 	if(!game["mp_scenario"].empty()) {
 		// check if it's a multiplayer scenario
-		const config* level_cfg = &game_config.find_child("multiplayer",
-														  "id",
-														  game["mp_scenario"]);
+		const config* level_cfg = &lookups.find_child("multiplayer",
+													  game["mp_scenario"]);
 		if(!*level_cfg) {
 			// check if it's a user map
-			level_cfg = &game_config.find_child("generic_multiplayer",
-												"id",
-												game["mp_scenario"]);
+			level_cfg = &lookups.find_child("generic_multiplayer",
+											game["mp_scenario"]);
 		}
 		if(*level_cfg) {
 			scenario = (*level_cfg)["name"].str();
@@ -284,17 +332,10 @@ game_info::game_info(const config& game, const config& game_config)
 			// as remote scenarios
 			if(!reloaded) {
 				if(const config& hashes
-				   = game_config.child("multiplayer_hashes")) {
-					std::string hash = game["hash"];
-					bool hash_found = false;
-					FOREACH(const AUTO & i, hashes.attribute_range())
-					{
-						if(i.first == game["mp_scenario"] && i.second == hash) {
-							hash_found = true;
-							break;
-						}
-					}
-					if(!hash_found) {
+				   = lookups.game_config().child("multiplayer_hashes")) {
+					const config::attribute_value* hash
+							= hashes.get(game["mp_scenario"]);
+					if(!hash || hash->str() != game["hash"].str()) {
 						remote_scenario = true;
 						map_info += " — ";
 						map_info += _("Remote scenario");
@@ -17,11 +17,16 @@
 
 #include "sdl/utils.hpp"
 
+#include <boost/cstdint.hpp>
+#include <boost/shared_ptr.hpp>
+
 #include <set>
 #include <deque>
 #include <functional>
+#include <map>
 
 class config;
+class terrain_type_data;
 
 /** This class represents a single stored chat message */
 struct chat_message
@@ -133,9 +138,50 @@ struct user_info
 /**
  * This class represents the info a client has about a game on the server
  */
+/**
+ * The lookups of game_info in the game config, the map files and the map
+ * data, cached for a visit of the lobby. The games of the gamelist diffs
+ * keep to a few eras, scenarios and maps, which were looked up and parsed
+ * again on each update of a game.
+ */
+class game_info_lookups
+{
+public:
+	explicit game_info_lookups(const config& game_config);
+
+	/** The child [@a key] of the game config whose id is @a id, or an invalid config. */
+	const config& find_child(const std::string& key, const std::string& id);
+
+	/** What filesystem::read_map() gives for @a scenario. */
+	const std::string& read_map(const std::string& scenario);
+
+	/**
+	 * Parses @a map_data, once for every different map.
+	 *
+	 * @param size_info             Set to the size of the map, as "w×h".
+	 * @returns                     Whether the map could be read.
+	 */
+	bool map_size(const std::string& map_data, std::string& size_info);
+
+	const config& game_config() const
+	{
+		return game_config_;
+	}
+
+private:
+	const config& game_config_;
+	boost::shared_ptr<terrain_type_data> tdata_;
+
+	std::map<std::pair<std::string, std::string>, const config*> children_;
+	std::map<std::string, std::string> map_files_;
+
+	/** By util::content_hash() of the map data: whether it could be read, and its size. */
+	std::map<boost::uint64_t, std::pair<bool, std::string> > map_sizes_;
+};
+
 struct game_info
 {
-	game_info(const config& c, const config& game_config);
+	game_info(const config& c, game_info_lookups& lookups);
 
 	bool can_join() const;
 	bool can_observe() const;
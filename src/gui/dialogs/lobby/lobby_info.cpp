@@ -41,7 +41,7 @@ static lg::log_domain log_lobby("lobby");
 
 
 lobby_info::lobby_info(const config& game_config)
-	: game_config_(game_config)
+	: lookups_(game_config)
 	, gamelist_()
 	, gamelist_initialized_(false)
 	, rooms_()
@@ -109,7 +109,7 @@ void lobby_info::process_gamelist(const config& data)
 	games_by_id_.clear();
 	FOREACH(const AUTO & c, gamelist_.child("gamelist").child_range("game"))
 	{
-		game_info* game = new game_info(c, game_config_);
+		game_info* game = new game_info(c, lookups_);
 		games_by_id_[game->id] = game;
 	}
 	DBG_LB << dump_games_map(games_by_id_);
@@ -153,10 +153,10 @@ bool lobby_info::process_gamelist_diff(const config& data)
 		if(diff_result == "new" || diff_result == "modified") {
 			if(current_i == games_by_id_.end()) {
 				games_by_id_.insert(std::make_pair(
-						game_id, new game_info(c, game_config_)));
+						game_id, new game_info(c, lookups_)));
 			} else {
 				// had a game with that id, so update it and mark it as such
-				*(current_i->second) = game_info(c, game_config_);
+				*(current_i->second) = game_info(c, lookups_);
 				current_i->second->display_status = game_info::UPDATED;
 			}
 		} else if(diff_result == "deleted") {
@@ -98,7 +98,8 @@ public:
 private:
 	void process_userlist();
 
-	const config& game_config_;
+	/** Those of the games, made with the game config. */
+	game_info_lookups lookups_;
 	config gamelist_;
 	bool gamelist_initialized_;
 	std::vector<room_info> rooms_;
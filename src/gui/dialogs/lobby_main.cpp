@@ -644,7 +644,7 @@ void tlobby_main::update_gamelist_diff()
 					   << list_i << ")\n";
 				tgrid* grid = gamelistbox_->get_row_grid(list_i);
 				modify_grid_with_data(grid, make_game_row_data(game));
-				adjust_game_row_contents(game, list_i, grid);
+				adjust_game_row_contents(game, list_i, grid, false);
 				++list_i;
 				next_gamelist_id_at_row.push_back(game.id);
 			} else if(game.display_status == game_info::DELETED) {
@@ -764,7 +764,8 @@ tlobby_main::make_game_row_data(const game_info& game)
 
 void tlobby_main::adjust_game_row_contents(const game_info& game,
 										   int idx,
-										   tgrid* grid)
+										   tgrid* grid,
+										   bool add_callbacks)
 {
 	find_widget<tcontrol>(grid, "name", false).set_use_markup(true);
 
@@ -791,21 +792,25 @@ void tlobby_main::adjust_game_row_contents(const game_info& game,
 
 	tbutton* join_button = dynamic_cast<tbutton*>(grid->find("join", false));
 	if(join_button) {
-		connect_signal_mouse_left_click(
-				*join_button,
-				boost::bind(&tlobby_main::join_button_callback,
-							this,
-							boost::ref(*window_)));
+		if(add_callbacks) {
+			connect_signal_mouse_left_click(
+					*join_button,
+					boost::bind(&tlobby_main::join_button_callback,
+								this,
+								boost::ref(*window_)));
+		}
 		join_button->set_active(game.can_join());
 	}
 	tbutton* observe_button
 			= dynamic_cast<tbutton*>(grid->find("observe", false));
 	if(observe_button) {
-		connect_signal_mouse_left_click(
-				*observe_button,
-				boost::bind(&tlobby_main::observe_button_callback,
-							this,
-							boost::ref(*window_)));
+		if(add_callbacks) {
+			connect_signal_mouse_left_click(
+					*observe_button,
+					boost::bind(&tlobby_main::observe_button_callback,
+								this,
+								boost::ref(*window_)));
+		}
 		observe_button->set_active(game.can_observe());
 	}
 	tminimap* minimap = dynamic_cast<tminimap*>(grid->find("minimap", false));
@@ -104,7 +104,16 @@ protected:
 
 	std::map<std::string, string_map> make_game_row_data(const game_info& game);
 
-	void adjust_game_row_contents(const game_info& game, int idx, tgrid* grid);
+	/**
+	 * Sets the contents of a game row not set by its data.
+	 *
+	 * @param add_callbacks       Whether to connect the buttons of the row,
+	 *                            only needed when the row is created.
+	 */
+	void adjust_game_row_contents(const game_info& game,
+								  int idx,
+								  tgrid* grid,
+								  bool add_callbacks = true);
 
 public:
 	void update_playerlist();
@@ -32,6 +32,7 @@
 #include <boost/bind.hpp>
 
 #include <iomanip>
+#include <sstream>
 
 #define LOG_SCOPE_HEADER                                                       \
 	"tcontrol(" + get_control_type() + ") [" + id() + "] " + __func__
@@ -50,6 +51,9 @@ tcontrol::tcontrol(const unsigned canvas_count)
 	, canvas_(canvas_count)
 	, config_(NULL)
 	, renderer_()
+	, text_sizes_()
+	, text_sizes_key_()
+	, label_truncated_(false)
 	, text_maximum_width_(0)
 	, text_alignment_(PANGO_ALIGN_LEFT)
 	, shrunken_(false)
@@ -77,6 +81,9 @@ tcontrol::tcontrol(const implementation::tbuilder_control& builder,
 	, canvas_(canvas_count)
 	, config_(NULL)
 	, renderer_()
+	, text_sizes_()
+	, text_sizes_key_()
+	, label_truncated_(false)
 	, text_maximum_width_(0)
 	, text_alignment_(PANGO_ALIGN_LEFT)
 	, shrunken_(false)
@@ -250,7 +257,7 @@ void tcontrol::place(const tpoint& origin, const tpoint& size)
 
 	// Note we assume that the best size has been queried but otherwise it
 	// should return false.
-	if(renderer_.is_truncated() && use_tooltip_on_label_overflow_
+	if(label_truncated_ && use_tooltip_on_label_overflow_
 	   && tooltip_.empty()) {
 
 		set_tooltip(label_);
@@ -446,6 +453,21 @@ tpoint tcontrol::get_best_text_size(const tpoint& minimum_size,
 
 	assert(!label_.empty());
 
+	const std::string key = get_text_size_key();
+	if(key != text_sizes_key_) {
+		text_sizes_.clear();
+		text_sizes_key_ = key;
+	}
+	FOREACH(const AUTO & text_size, text_sizes_)
+	{
+		if(text_size.minimum_size == minimum_size
+		   && text_size.maximum_size == maximum_size) {
+
+			label_truncated_ = text_size.truncated;
+			return text_size.size;
+		}
+	}
+
 	const tpoint border(config_->text_extra_width, config_->text_extra_height);
 	tpoint size = minimum_size - border;
 
@@ -503,11 +525,31 @@ tpoint tcontrol::get_best_text_size(const tpoint& minimum_size,
 		size.y = minimum_size.y;
 	}
 
+	label_truncated_ = renderer_.is_truncated();
+
+	// The layout asks a few sizes, mostly the best one and a reduced width.
+	if(text_sizes_.size() == 4) {
+		text_sizes_.erase(text_sizes_.begin());
+	}
+	const ttext_size text_size = { minimum_size, maximum_size, size,
+								   label_truncated_ };
+	text_sizes_.push_back(text_size);
+
 	DBG_GUI_L << LOG_HEADER << " label '" << debug_truncate(label_)
 			  << "' result " << size << ".\n";
 	return size;
 }
 
+std::string tcontrol::get_text_size_key() const
+{
+	std::ostringstream key;
+	key << config_.get() << ' ' << use_markup_ << get_link_aware() << can_wrap()
+		<< ' ' << get_link_color() << ' ' << text_alignment_ << ' '
+		<< text_maximum_width_ << ' ' << get_characters_per_line() << ' '
+		<< label_.str();
+	return key.str();
+}
+
 void tcontrol::signal_handler_show_tooltip(const event::tevent event,
 										   bool& handled,
 										   const tpoint& location)
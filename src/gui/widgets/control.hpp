@@ -489,6 +489,33 @@ private:
 	 */
 	mutable font::ttext renderer_;
 
+	/** A text size found by @ref get_best_text_size(). */
+	struct ttext_size
+	{
+		tpoint minimum_size;
+		tpoint maximum_size;
+		tpoint size;
+		bool truncated;
+	};
+
+	/**
+	 * The last text sizes found by @ref get_best_text_size().
+	 *
+	 * Each layout of the window asks again the best size of every widget and
+	 * measuring the text with pango is the expensive part, so the sizes are
+	 * kept as long as @ref text_sizes_key_ doesn't change.
+	 */
+	mutable std::vector<ttext_size> text_sizes_;
+
+	/** The text and its properties when @ref text_sizes_ were measured. */
+	mutable std::string text_sizes_key_;
+
+	/** Was the text truncated in the last size asked? */
+	mutable bool label_truncated_;
+
+	/** Returns the text and the properties determining its size. */
+	std::string get_text_size_key() const;
+
 	/** The maximum width for the text in a control. */
 	int text_maximum_width_;
 
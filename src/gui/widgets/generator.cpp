@@ -17,6 +17,7 @@
 #include "gui/widgets/generator_private.hpp"
 
 #include "gui/widgets/window.hpp"
+#include "sdl/rect.hpp"
 #include "utils/foreach.tpp"
 #include "wml_exception.hpp"
 
@@ -301,12 +302,21 @@ void thorizontal_list::handle_key_right_arrow(SDLMod /*modifier*/,
 	}
 }
 
-tvertical_list::tvertical_list() : placed_(false)
+tvertical_list::tvertical_list()
+	: placed_(false)
+	, placed_items_()
+	, placed_item_count_(0)
+	, first_visible_item_(0)
+	, last_visible_item_(0)
+	, visible_items_set_(false)
 {
 }
 
 void tvertical_list::create_item(const unsigned /*index*/)
 {
+	// The new item hasn't got a visible rectangle yet.
+	visible_items_set_ = false;
+
 	if(!placed_) {
 		return;
 	}
@@ -350,22 +360,24 @@ void tvertical_list::place(const tpoint& origin, const tpoint& size)
 	 *   height.
 	 */
 
+	placed_items_.clear();
+	placed_item_count_ = get_item_count();
+
 	tpoint current_origin = origin;
 	for(size_t i = 0; i < get_item_count(); ++i) {
 
-		tgrid& grid = item(i);
-		if(grid.get_visible() == twidget::tvisible::invisible
-		   || !get_item_shown(i)) {
-
+		if(!is_placed(i)) {
 			continue;
 		}
 
+		tgrid& grid = item(i);
 		tpoint best_size = grid.get_best_size();
 		assert(best_size.x <= size.x);
 		// FIXME should we look at grow factors???
 		best_size.x = size.x;
 
 		grid.place(current_origin, best_size);
+		placed_items_.push_back(i);
 
 		current_origin.y += best_size.y;
 	}
@@ -398,11 +410,47 @@ void tvertical_list::set_visible_rectangle(const SDL_Rect& rectangle)
 	 * function in the tgenerator template class and call it from the wanted
 	 * placement functions.
 	 */
-	for(size_t i = 0; i < get_item_count(); ++i) {
+	if(placed_item_count_ != get_item_count()) {
+		for(size_t i = 0; i < get_item_count(); ++i) {
+			set_item_visible_rectangle(i, rectangle);
+		}
+		visible_items_set_ = false;
+		return;
+	}
 
-		tgrid& grid = item(i);
-		grid.set_visible_rectangle(rectangle);
+	if(!visible_items_set_) {
+		for(size_t i = 0; i < get_item_count(); ++i) {
+			set_item_visible_rectangle(i, rectangle);
+		}
+	}
+
+	// Only the items intersecting the rectangle can be drawn.
+	size_t first = get_item_count();
+	size_t last = first;
+	for(size_t i = first_placed_below(rectangle.y);
+		i < placed_items_.size()
+		&& item(placed_items_[i]).get_y() < rectangle.y + rectangle.h;
+		++i) {
+
+		if(first == get_item_count()) {
+			first = placed_items_[i];
+		}
+		last = placed_items_[i] + 1;
+		set_item_visible_rectangle(last - 1, rectangle);
+	}
+
+	// Hide the items which were visible before but no longer are.
+	if(visible_items_set_) {
+		for(size_t i = first_visible_item_; i < last_visible_item_; ++i) {
+			if(i < first || i >= last || !is_placed(i)) {
+				set_item_visible_rectangle(i, rectangle);
+			}
+		}
 	}
+
+	first_visible_item_ = first;
+	last_visible_item_ = last;
+	visible_items_set_ = true;
 }
 
 twidget* tvertical_list::find_at(const tpoint& coordinate,
@@ -410,6 +458,21 @@ twidget* tvertical_list::find_at(const tpoint& coordinate,
 {
 	assert(get_window());
 
+	if(placed_item_count_ == get_item_count()) {
+		for(size_t i = first_placed_below(coordinate.y);
+			i < placed_items_.size()
+			&& item(placed_items_[i]).get_y() <= coordinate.y;
+			++i) {
+
+			twidget* widget = item(placed_items_[i])
+									  .find_at(coordinate, must_be_active);
+			if(widget) {
+				return widget;
+			}
+		}
+		return NULL;
+	}
+
 	for(size_t i = 0; i < get_item_count(); ++i) {
 
 		tgrid& grid = item(i);
@@ -434,6 +497,21 @@ const twidget* tvertical_list::find_at(const tpoint& coordinate,
 {
 	assert(get_window());
 
+	if(placed_item_count_ == get_item_count()) {
+		for(size_t i = first_placed_below(coordinate.y);
+			i < placed_items_.size()
+			&& item(placed_items_[i]).get_y() <= coordinate.y;
+			++i) {
+
+			const twidget* widget = item(placed_items_[i])
+											.find_at(coordinate, must_be_active);
+			if(widget) {
+				return widget;
+			}
+		}
+		return NULL;
+	}
+
 	for(size_t i = 0; i < get_item_count(); ++i) {
 
 		const tgrid& grid = item(i);
@@ -452,6 +530,37 @@ const twidget* tvertical_list::find_at(const tpoint& coordinate,
 	return NULL;
 }
 
+bool tvertical_list::is_placed(const unsigned index) const
+{
+	return item(index).get_visible() != twidget::tvisible::invisible
+		   && get_item_shown(index);
+}
+
+size_t tvertical_list::first_placed_below(const int y) const
+{
+	size_t first = 0;
+	size_t last = placed_items_.size();
+	while(first != last) {
+		const size_t middle = first + (last - first) / 2;
+		const tgrid& grid = item(placed_items_[middle]);
+		if(grid.get_y() + static_cast<int>(grid.get_height()) <= y) {
+			first = middle + 1;
+		} else {
+			last = middle;
+		}
+	}
+	return first;
+}
+
+void tvertical_list::set_item_visible_rectangle(const unsigned index,
+												const SDL_Rect& rectangle)
+{
+	// The position of the items not laid out is outdated, they are not drawn
+	// but should not be drawn either after being shown outside the viewport.
+	item(index).set_visible_rectangle(is_placed(index) ? rectangle
+													   : sdl::empty_rect);
+}
+
 void tvertical_list::handle_key_up_arrow(SDLMod /*modifier*/, bool& handled)
 {
 	if(get_selected_item_count() == 0) {
@@ -338,6 +338,47 @@ private:
 	 * so do nothing.
 	 */
 	bool placed_;
+
+	/**
+	 * The items laid out by the last call to @ref place(), from top to
+	 * bottom.
+	 *
+	 * Lists can have thousands of items, so @ref set_visible_rectangle()
+	 * and @ref find_at() look up the few items in the viewport in this
+	 * list instead of visiting all of them.
+	 */
+	std::vector<unsigned> placed_items_;
+
+	/**
+	 * The number of items when @ref placed_items_ was built.
+	 *
+	 * When items have been added or removed since, the list is out of date
+	 * and all items are visited again until the next placement.
+	 */
+	size_t placed_item_count_;
+
+	/**
+	 * The items, [first, last), which got the last visible rectangle.
+	 *
+	 * All the items outside the range are not drawn, so when the rectangle
+	 * changes only these items and the ones now visible need an update.
+	 * Only valid when @ref visible_items_set_ is true.
+	 */
+	size_t first_visible_item_, last_visible_item_;
+	bool visible_items_set_;
+
+	/** Is the item laid out, occupying space in the list? */
+	bool is_placed(const unsigned index) const;
+
+	/**
+	 * Returns the first position in @ref placed_items_ of an item which
+	 * ends below @a y.
+	 */
+	size_t first_placed_below(const int y) const;
+
+	/** Sets the visible rectangle of an item, which may not be placed. */
+	void set_item_visible_rectangle(const unsigned index,
+									const SDL_Rect& rectangle);
 };
 
 /**
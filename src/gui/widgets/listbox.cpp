@@ -131,6 +131,11 @@ void tlistbox::set_row_shown(const unsigned row, const bool shown)
 {
 	assert(generator_);
 
+	// Laying out the rows again is expensive for long lists.
+	if(generator_->get_item_shown(row) == shown) {
+		return;
+	}
+
 	twindow* window = get_window();
 	assert(window);
 
@@ -163,6 +168,16 @@ void tlistbox::set_row_shown(const std::vector<bool>& shown)
 	assert(generator_);
 	assert(shown.size() == get_item_count());
 
+	// The lobby sets the rows shown after each update of its game list,
+	// which seldom changes which rows are shown.
+	bool changed = false;
+	for(size_t i = 0; i < shown.size() && !changed; ++i) {
+		changed = generator_->get_item_shown(i) != shown[i];
+	}
+	if(!changed) {
+		return;
+	}
+
 	twindow* window = get_window();
 	assert(window);
 
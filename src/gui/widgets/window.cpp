@@ -30,6 +30,7 @@
 #include "font.hpp"
 #include "gettext.hpp"
 #include "log.hpp"
+#include "gui/auxiliary/draw_profiler.hpp"
 #include "gui/auxiliary/event/distributor.hpp"
 #include "gui/auxiliary/event/handler.hpp"
 #include "gui/auxiliary/event/message.hpp"
@@ -740,6 +741,8 @@ void twindow::draw()
 		return;
 	}
 
+	const tdraw_profiler::tscope profiler_scope(tdraw_profiler::DRAW);
+
 	surface frame_buffer = video_.getSurface();
 
 	/***** ***** Layout and get dirty list ***** *****/
@@ -933,6 +936,7 @@ void twindow::draw()
 		}
 
 		update_rect(dirty_rect);
+		tdraw_profiler::widget_redrawn(dirty_rect);
 	}
 
 	dirty_list_.clear();
@@ -1051,6 +1055,7 @@ void twindow::layout()
 	assert(conf);
 
 	log_scope2(log_gui_layout, LOG_SCOPE_HEADER);
+	const tdraw_profiler::tscope profiler_scope(tdraw_profiler::LAYOUT);
 
 	const tpoint mouse = get_mouse_position();
 	variables_.add("mouse_x", variant(mouse.x));
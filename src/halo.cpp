@@ -31,10 +31,14 @@ namespace halo
 class halo_impl
 {
 
+/** The haloes lying over each hex, to find those in an invalidated area. */
+typedef std::map<map_location, std::set<int> > hex_index;
+
 class effect
 {
 public:
-	effect(display * screen, int xpos, int ypos, const animated<image::locator>::anim_description& img,
+	effect(display * screen, int id, hex_index& index, int xpos, int ypos,
+			const animated<image::locator>::anim_description& img,
 			const map_location& loc, ORIENTATION, bool infinite);
 
 	void set_location(int x, int y);
@@ -45,13 +49,18 @@ public:
 	bool expired()     const { return !images_.cycles() && images_.animation_finished(); }
 	bool need_update() const { return images_.need_update(); }
 	bool does_change() const { return !images_.does_not_change(); }
-	bool on_location(const std::set<map_location>& locations) const;
 
 	void add_overlay_location(std::set<map_location>& locations);
+
+	/** Removes the halo from the hex index, it is indexed again once rendered. */
+	void unindex();
 private:
 
 	const image::locator& current_image() { return images_.get_current_frame(); }
 
+	int id_;
+	hex_index* index_;
+
 	animated<image::locator> images_;
 
 	ORIENTATION orientation_;
@@ -60,6 +69,13 @@ private:
 	surface surf_, buffer_;
 	SDL_Rect rect_;
 
+	/**
+	 * The frame and zoom surf_ was made for, haloes that don't change are
+	 * neither scaled nor flipped again.
+	 */
+	image::locator surf_image_;
+	int surf_zoom_;
+
 	/** The location of the center of the halo. */
 	map_location loc_;
 
@@ -74,6 +90,8 @@ display* disp;
 std::map<int, effect> haloes;
 int halo_id;
 
+hex_index index;
+
 /**
  * Upon unrendering, an invalidation list is send. All haloes in that area and
  * the other invalidated haloes are stored in this set. Then there'll be
@@ -110,6 +128,7 @@ halo_impl(display & screen) :
 	disp(&screen),
 	haloes(),
 	halo_id(1),
+	index(),
 	invalidated_haloes(),
 	new_haloes(),
 	deleted_haloes(),
@@ -137,8 +156,11 @@ void render();
 
 }; //end halo_impl
 
-halo_impl::effect::effect(display * screen, int xpos, int ypos, const animated<image::locator>::anim_description& img,
+halo_impl::effect::effect(display * screen, int id, hex_index& index, int xpos, int ypos,
+		const animated<image::locator>::anim_description& img,
 		const map_location& loc, ORIENTATION orientation, bool infinite) :
+	id_(id),
+	index_(&index),
 	images_(img),
 	orientation_(orientation),
 	x_(xpos),
@@ -146,6 +168,8 @@ halo_impl::effect::effect(display * screen, int xpos, int ypos, const animated<i
 	surf_(NULL),
 	buffer_(NULL),
 	rect_(sdl::empty_rect),
+	surf_image_(),
+	surf_zoom_(0),
 	loc_(loc),
 	overlayed_hexes_(),
 	disp(screen)
@@ -166,7 +190,7 @@ void halo_impl::effect::set_location(int x, int y)
 		x_ = new_x;
 		y_ = new_y;
 		buffer_.assign(NULL);
-		overlayed_hexes_.clear();
+		unindex();
 	}
 }
 
@@ -194,15 +218,19 @@ bool halo_impl::effect::render()
 	}
 
 	images_.update_last_draw_time();
-	surf_.assign(image::get_image(current_image(),image::SCALED_TO_ZOOM));
-	if(surf_ == NULL) {
-		return false;
-	}
-	if(orientation_ == HREVERSE || orientation_ == HVREVERSE) {
-		surf_.assign(image::reverse_image(surf_));
-	}
-	if(orientation_ == VREVERSE || orientation_ == HVREVERSE) {
-		surf_.assign(flop_surface(surf_));
+	if(surf_ == NULL || !(surf_image_ == current_image()) || surf_zoom_ != disp->hex_size()) {
+		surf_image_ = current_image();
+		surf_zoom_ = disp->hex_size();
+		surf_.assign(image::get_image(surf_image_,image::SCALED_TO_ZOOM));
+		if(surf_ == NULL) {
+			return false;
+		}
+		if(orientation_ == HREVERSE || orientation_ == HVREVERSE) {
+			surf_.assign(image::reverse_image(surf_));
+		}
+		if(orientation_ == VREVERSE || orientation_ == HVREVERSE) {
+			surf_.assign(flop_surface(surf_));
+		}
 	}
 
 	const int screenx = disp->get_location_x(map_location::ZERO());
@@ -222,6 +250,7 @@ bool halo_impl::effect::render()
 		display::rect_of_hexes::iterator i = hexes.begin(), end = hexes.end();
 		for (;i != end; ++i) {
 			overlayed_hexes_.push_back(*i);
+			(*index_)[*i].insert(id_);
 		}
 	}
 
@@ -281,24 +310,29 @@ void halo_impl::effect::unrender()
 	update_rect(rect);
 }
 
-bool halo_impl::effect::on_location(const std::set<map_location>& locations) const
+void halo_impl::effect::add_overlay_location(std::set<map_location>& locations)
 {
 	for(std::vector<map_location>::const_iterator itor = overlayed_hexes_.begin();
 			itor != overlayed_hexes_.end(); ++itor) {
-		if(locations.find(*itor) != locations.end()) {
-			return true;
-		}
+
+		locations.insert(*itor);
 	}
-	return false;
 }
 
-void halo_impl::effect::add_overlay_location(std::set<map_location>& locations)
+void halo_impl::effect::unindex()
 {
 	for(std::vector<map_location>::const_iterator itor = overlayed_hexes_.begin();
 			itor != overlayed_hexes_.end(); ++itor) {
 
-		locations.insert(*itor);
+		const hex_index::iterator hex = index_->find(*itor);
+		if(hex != index_->end()) {
+			hex->second.erase(id_);
+			if(hex->second.empty()) {
+				index_->erase(hex);
+			}
+		}
 	}
+	overlayed_hexes_.clear();
 }
 
 // End halo_impl::effect impl's
@@ -325,7 +359,7 @@ int halo_impl::add(int x, int y, const std::string& image, const map_location& l
 		image_vector.push_back(animated<image::locator>::frame_description(time,image::locator(str)));
 
 	}
-	haloes.insert(std::pair<int,effect>(id,effect(disp,x,y,image_vector,loc,orientation,infinite)));
+	haloes.insert(std::pair<int,effect>(id,effect(disp,id,index,x,y,image_vector,loc,orientation,infinite)));
 	new_haloes.insert(id);
 	if(haloes.find(id)->second.does_change() || !infinite) {
 		changing_haloes.insert(id);
@@ -359,16 +393,17 @@ void halo_impl::unrender(std::set<map_location> invalidated_locations)
 	}
 	//assert(invalidated_haloes.size() == 0);
 
-	// Remove expired haloes
-	std::map<int, effect>::iterator itor = haloes.begin();
-	for(; itor != haloes.end(); ++itor ) {
-		if(itor->second.expired()) {
-			deleted_haloes.insert(itor->first);
+	// Remove expired haloes, only those with an expiration time are in
+	// changing_haloes
+	std::set<int>::const_iterator set_itor = changing_haloes.begin();
+	for(; set_itor != changing_haloes.end(); ++set_itor) {
+		if(haloes.find(*set_itor)->second.expired()) {
+			deleted_haloes.insert(*set_itor);
 		}
 	}
 
 	// Add the haloes marked for deletion to the invalidation set
-	std::set<int>::const_iterator set_itor = deleted_haloes.begin();
+	set_itor = deleted_haloes.begin();
 	for(;set_itor != deleted_haloes.end(); ++set_itor) {
 		invalidated_haloes.insert(*set_itor);
 		haloes.find(*set_itor)->second.add_overlay_location(invalidated_locations);
@@ -383,28 +418,33 @@ void halo_impl::unrender(std::set<map_location> invalidated_locations)
 		}
 	}
 
-	// Find all halo's in a the invalidated area
-	size_t halo_count;
-
-	// Repeat until set of haloes in the invalidated area didn't change
-	// (including none found) or all existing haloes are found.
-	do {
-		halo_count = invalidated_haloes.size();
-		for(itor = haloes.begin(); itor != haloes.end(); ++itor) {
-			// Test all haloes not yet in the set
-			// which match one of the locations
-			if(invalidated_haloes.find(itor->first) == invalidated_haloes.end() &&
-					itor->second.on_location(invalidated_locations)) {
-
-				// If found, add all locations which the halo invalidates,
-				// and add it to the set
-				itor->second.add_overlay_location(invalidated_locations);
-				invalidated_haloes.insert(itor->first);
+	// Find all halo's in a the invalidated area: look up the haloes over
+	// each invalidated hex, the hexes they cover are invalidated as well
+	// and looked up in turn.
+	std::vector<map_location> pending(invalidated_locations.begin(), invalidated_locations.end());
+	while(!pending.empty()) {
+		const hex_index::const_iterator hex = index.find(pending.back());
+		pending.pop_back();
+		if(hex == index.end()) {
+			continue;
+		}
+
+		for(set_itor = hex->second.begin(); set_itor != hex->second.end(); ++set_itor) {
+			if(!invalidated_haloes.insert(*set_itor).second) {
+				continue;
+			}
+
+			std::set<map_location> overlay;
+			haloes.find(*set_itor)->second.add_overlay_location(overlay);
+			for(std::set<map_location>::const_iterator loc = overlay.begin(); loc != overlay.end(); ++loc) {
+				if(invalidated_locations.insert(*loc).second) {
+					pending.push_back(*loc);
+				}
 			}
 		}
-	} while (halo_count != invalidated_haloes.size() && halo_count != haloes.size());
+	}
 
-	if(halo_count == 0) {
+	if(invalidated_haloes.empty()) {
 		return;
 	}
 
@@ -423,6 +463,7 @@ void halo_impl::unrender(std::set<map_location> invalidated_locations)
 
 		changing_haloes.erase(*set_itor);
 		invalidated_haloes.erase(*set_itor);
+		haloes.find(*set_itor)->second.unindex();
 		haloes.erase(*set_itor);
 	}
 
@@ -441,16 +482,12 @@ void halo_impl::render()
 	std::set<int> unrendered_new_haloes;
 
 	// Render the haloes:
-	// iterate through all the haloes and draw if in either set
-	for(std::map<int, effect>::iterator itor = haloes.begin();
-			itor != haloes.end(); ++itor) {
-
-		if(new_haloes.find(itor->first) != new_haloes.end() &&
-				! itor->second.render()) {
-
-			unrendered_new_haloes.insert(itor->first);
-		} else if(invalidated_haloes.find(itor->first) != invalidated_haloes.end()) {
-			itor->second.render();
+	// draw those in either set, in the order they were added
+	std::set<int> drawn(invalidated_haloes);
+	drawn.insert(new_haloes.begin(), new_haloes.end());
+	for(std::set<int>::const_iterator id = drawn.begin(); id != drawn.end(); ++id) {
+		if(!haloes.find(*id)->second.render() && new_haloes.count(*id)) {
+			unrendered_new_haloes.insert(*id);
 		}
 	}
 
@@ -20,6 +20,120 @@
 
 namespace util {
 
+namespace {
+
+const boost::uint64_t prime1 = (boost::uint64_t(0x9e3779b1u) << 32) | 0x85ebca87u;
+const boost::uint64_t prime2 = (boost::uint64_t(0xc2b2ae3du) << 32) | 0x27d4eb4fu;
+const boost::uint64_t prime3 = (boost::uint64_t(0x165667b1u) << 32) | 0x9e3779f9u;
+const boost::uint64_t prime4 = (boost::uint64_t(0x85ebca77u) << 32) | 0xc2b2ae63u;
+const boost::uint64_t prime5 = (boost::uint64_t(0x27d4eb2fu) << 32) | 0x165667c5u;
+
+inline boost::uint64_t rotl(boost::uint64_t x, int r)
+{
+	return (x << r) | (x >> (64 - r));
+}
+
+// Read as little endian whatever the platform; the compilers turn these
+// into plain loads where they can.
+inline boost::uint64_t read64(const unsigned char* p)
+{
+	boost::uint64_t res = 0;
+	for(int i = 7; i >= 0; --i) {
+		res = (res << 8) | p[i];
+	}
+	return res;
+}
+
+inline boost::uint32_t read32(const unsigned char* p)
+{
+	return boost::uint32_t(p[0]) | (boost::uint32_t(p[1]) << 8)
+		| (boost::uint32_t(p[2]) << 16) | (boost::uint32_t(p[3]) << 24);
+}
+
+inline boost::uint64_t round(boost::uint64_t acc, boost::uint64_t input)
+{
+	acc += input * prime2;
+	return rotl(acc, 31) * prime1;
+}
+
+inline boost::uint64_t merge_round(boost::uint64_t acc, boost::uint64_t val)
+{
+	acc ^= round(0, val);
+	return acc * prime1 + prime4;
+}
+
+} // end anonymous namespace
+
+boost::uint64_t content_hash(const void* data, size_t size, boost::uint64_t seed)
+{
+	const unsigned char* p = static_cast<const unsigned char*>(data);
+	const unsigned char* const end = p + size;
+	boost::uint64_t h;
+
+	if(size >= 32) {
+		// Four independent lanes, for the processor to run side by side.
+		boost::uint64_t v1 = seed + prime1 + prime2;
+		boost::uint64_t v2 = seed + prime2;
+		boost::uint64_t v3 = seed;
+		boost::uint64_t v4 = seed - prime1;
+		const unsigned char* const limit = end - 32;
+		do {
+			v1 = round(v1, read64(p));
+			v2 = round(v2, read64(p + 8));
+			v3 = round(v3, read64(p + 16));
+			v4 = round(v4, read64(p + 24));
+			p += 32;
+		} while(p <= limit);
+
+		h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+		h = merge_round(h, v1);
+		h = merge_round(h, v2);
+		h = merge_round(h, v3);
+		h = merge_round(h, v4);
+	} else {
+		h = seed + prime5;
+	}
+
+	h += size;
+
+	for(; p + 8 <= end; p += 8) {
+		h ^= round(0, read64(p));
+		h = rotl(h, 27) * prime1 + prime4;
+	}
+	if(p + 4 <= end) {
+		h ^= boost::uint64_t(read32(p)) * prime1;
+		h = rotl(h, 23) * prime2 + prime3;
+		p += 4;
+	}
+	for(; p != end; ++p) {
+		h ^= *p * prime5;
+		h = rotl(h, 11) * prime1;
+	}
+
+	h ^= h >> 33;
+	h *= prime2;
+	h ^= h >> 29;
+	h *= prime3;
+	h ^= h >> 32;
+	return h;
+}
+
+boost::uint64_t content_hash(const std::string& data)
+{
+	return content_hash(data.data(), data.size());
+}
+
+std::string content_hash_hex(const std::string& data)
+{
+	static const char digits[] = "0123456789abcdef";
+	boost::uint64_t h = content_hash(data);
+	std::string res(16, '0');
+	for(int i = 15; i >= 0; --i, h >>= 4) {
+		res[i] = digits[h & 0xf];
+	}
+	return res;
+}
+
 const std::string itoa64 = "./0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz" ;
 const std::string hash_prefix = "$H$";
 
@@ -15,10 +15,23 @@
 #ifndef HASH_HPP_INCLUDED
 #define HASH_HPP_INCLUDED
 
+#include <boost/cstdint.hpp>
+
+#include <cstddef>
 #include <string>
 
 namespace util {
 
+/**
+ * The 64-bit xxHash (XXH64) of @a size bytes at @a data, to tell contents
+ * apart quickly. It is not cryptographic: never use it for passwords.
+ */
+boost::uint64_t content_hash(const void* data, size_t size, boost::uint64_t seed = 0);
+boost::uint64_t content_hash(const std::string& data);
+
+/** content_hash() of @a data as 16 hexadecimal digits, usable as a file name. */
+std::string content_hash_hex(const std::string& data);
+
 unsigned char* md5(const std::string& input);
 int get_iteration_count(const std::string& hash);
 std::string get_salt(const std::string& hash);
@@ -93,6 +93,34 @@ const std::string faction_prefix = "faction_";
 const std::string era_prefix = "era_";
 const std::string variation_prefix = "variation_";
 
+namespace {
+
+/**
+ * The unit types of each race, in the order of unit_types.types(), while
+ * generate_contents() runs.
+ *
+ * The sections and topics of every race are generated from the units of
+ * the race; finding them by scanning all the unit types for each race made
+ * generating the contents quadratic with large eras loaded.
+ */
+typedef std::map<std::string, std::vector<const unit_type*> > race_units_map;
+race_units_map race_units;
+bool race_units_indexed = false;
+
+const std::vector<const unit_type*>& units_of_race(const std::string& race)
+{
+	if (!race_units_indexed) {
+		race_units.clear();
+		BOOST_FOREACH(const unit_type_data::unit_type_map::value_type &i, unit_types.types()) {
+			race_units[i.second.race_id()].push_back(&i.second);
+		}
+		race_units_indexed = true;
+	}
+	return race_units[race];
+}
+
+}
+
 bool section_is_referenced(const std::string &section_id, const config &cfg)
 {
 	if (const config &toplevel = cfg.child("toplevel"))
@@ -782,11 +810,8 @@ void generate_terrain_sections(const config* /*help_cfg*/, section& sec, int /*l
 
 void generate_unit_sections(const config* /*help_cfg*/, section& sec, int level, const bool /*sort_generated*/, const std::string& race)
 {
-	BOOST_FOREACH(const unit_type_data::unit_type_map::value_type &i, unit_types.types()) {
-		const unit_type &type = i.second;
-
-		if (type.race_id() != race)
-			continue;
+	BOOST_FOREACH(const unit_type *i, units_of_race(race)) {
+		const unit_type &type = *i;
 
 		if (!type.show_variations_in_help())
 			continue;
@@ -821,12 +846,9 @@ std::vector<topic> generate_unit_topics(const bool sort_generated, const std::st
 	std::set<std::string, string_less> race_topics;
 	std::set<std::string> alignments;
 
-	BOOST_FOREACH(const unit_type_data::unit_type_map::value_type &i, unit_types.types())
+	BOOST_FOREACH(const unit_type *i, units_of_race(race))
 	{
-		const unit_type &type = i.second;
-
-		if (type.race_id() != race)
-			continue;
+		const unit_type &type = *i;
 
 		UNIT_DESCRIPTION_TYPE desc_type = description_type(type);
 		if (desc_type != FULL_DESCRIPTION)
@@ -1281,6 +1303,7 @@ void generate_contents()
 {
 	toplevel.clear();
 	hidden_sections.clear();
+	race_units_indexed = false;
 	if (game_cfg != NULL) {
 		const config *help_config = &game_cfg->child("help");
 		if (!*help_config) {
@@ -1338,6 +1361,9 @@ void generate_contents()
 			std::cerr << msg.str() << std::endl;
 		}
 	}
+	// The unit types might change before the next generation.
+	race_units.clear();
+	race_units_indexed = false;
 }
 
 // id starting with '.' are hidden
@@ -263,6 +263,10 @@ namespace hotkey {
 				replay_next_turn();
 				break;
 
+			case HOTKEY_REPLAY_PREVIOUS_TURN:
+				replay_previous_turn();
+				break;
+
 			case HOTKEY_REPLAY_NEXT_SIDE:
 				replay_next_side();
 				break;
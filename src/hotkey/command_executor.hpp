@@ -82,6 +82,7 @@ namespace hotkey {
 			virtual void reset_replay() {}
 			virtual void stop_replay() {}
 			virtual void replay_next_turn() {  }
+			virtual void replay_previous_turn() {  }
 			virtual void replay_next_side() {  }
 			virtual void replay_next_move() {  }
 			virtual void replay_show_everything() {}
@@ -113,6 +113,7 @@ namespace {
 		{ hotkey::HOTKEY_REPLAY_RESET, "resetreplay", N_("Reset Replay"), false, scope_game, "" },
 		{ hotkey::HOTKEY_REPLAY_STOP, "stopreplay", N_("Stop Replay"), false, scope_game, "" },
 		{ hotkey::HOTKEY_REPLAY_NEXT_TURN, "replaynextturn", N_("Next Turn"), false, scope_game, "" },
+		{ hotkey::HOTKEY_REPLAY_PREVIOUS_TURN, "replaypreviousturn", N_("Previous Turn"), false, scope_game, "" },
 		{ hotkey::HOTKEY_REPLAY_NEXT_SIDE, "replaynextside", N_("Next Side"), false, scope_game, "" },
 		{ hotkey::HOTKEY_REPLAY_NEXT_MOVE, "replaynextmove", N_("Next Move"), false, scope_game, "" },
 		{ hotkey::HOTKEY_REPLAY_SHOW_EVERYTHING, "replayshoweverything", N_("Full Map"), false, scope_game, "" },
@@ -60,7 +60,7 @@ namespace hotkey {
 		HOTKEY_REPLAY_PLAY, HOTKEY_REPLAY_RESET, HOTKEY_REPLAY_STOP, HOTKEY_REPLAY_NEXT_TURN,
 		HOTKEY_REPLAY_NEXT_SIDE, HOTKEY_REPLAY_NEXT_MOVE, HOTKEY_REPLAY_SHOW_EVERYTHING,
 		HOTKEY_REPLAY_SHOW_EACH, HOTKEY_REPLAY_SHOW_TEAM1,
-		HOTKEY_REPLAY_SKIP_ANIMATION,
+		HOTKEY_REPLAY_SKIP_ANIMATION, HOTKEY_REPLAY_PREVIOUS_TURN,
 
 		// Controls
 		HOTKEY_SELECT_HEX, HOTKEY_DESELECT_HEX,
@@ -54,6 +54,7 @@ bool replay_controller::hotkey_handler::can_execute_command(const hotkey::hotkey
 		return true;
 
 	case hotkey::HOTKEY_REPLAY_RESET:
+	case hotkey::HOTKEY_REPLAY_PREVIOUS_TURN:
 		return events::commands_disabled <= 1;
 
 	//commands we only can do before the end of the replay
@@ -46,6 +46,8 @@ public:
 	{ return replay_controller_.play_replay(); }
 	virtual void replay_next_turn() OVERRIDE
 	{ return replay_controller_.replay_next_turn(); }
+	virtual void replay_previous_turn() OVERRIDE
+	{ return replay_controller_.replay_previous_turn(); }
 	virtual void replay_next_side() OVERRIDE
 	{ return replay_controller_.replay_next_side(); }
 	virtual void replay_next_move() OVERRIDE
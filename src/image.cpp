@@ -32,6 +32,7 @@
 #include "gui/dialogs/advanced_graphics_options.hpp"
 #include "preferences.hpp"
 #include "sdl/rect.hpp"
+#include "thread.hpp"
 
 #ifdef HAVE_LIBPNG
 #include "SDL_SavePNG/savepng.h"
@@ -39,13 +40,18 @@
 
 #include "serialization/string_utils.hpp"
 #include "video.hpp"
+#include "xBRZ/xbrz.hpp"
 
 #include "SDL_image.h"
 
 #include <boost/bind.hpp>
 #include <boost/functional/hash.hpp>
 #include <boost/foreach.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
+#include <boost/scoped_ptr.hpp>
 
+#include <deque>
 #include <list>
 #include <set>
 
@@ -61,25 +67,58 @@ using game_config::tile_size;
 template<typename T>
 struct cache_item
 {
-	cache_item(): item(), loaded(false)
-	{}
-
-	cache_item(const T &item): item(item), loaded(true)
+	cache_item(): item(), loaded(false), cost(0), prev(-1), next(-1)
 	{}
 
 	T item;
 	bool loaded;
+
+	/** The memory used by item, see cache_cost(). */
+	size_t cost;
+
+	/** The neighbours in the list of loaded items, from the most recently used. */
+	int prev, next;
 };
 
 
 
 namespace image {
 
+/** The memory counted against the budget of a cache for an item. */
+static size_t cache_cost(const surface& surf)
+{
+	return surf ? surf->h * surf->pitch : 0;
+}
+
+static size_t cache_cost(const lit_variants& variants)
+{
+	size_t res = 0;
+	BOOST_FOREACH(const lit_variants::value_type& variant, variants) {
+		res += cache_cost(variant.second);
+	}
+	return res;
+}
+
+// Textures live in video memory, and flags are small, they are not counted.
+template<typename T>
+static size_t cache_cost(const T&)
+{
+	return 0;
+}
+
+/**
+ * A cache of the items for each locator, indexed by locator::index_.
+ *
+ * With a budget, the loaded items are kept in a list ordered by their
+ * last use, and the least recently used ones are unloaded when the cost
+ * of the items goes over the budget.
+ */
 template<typename T>
 class cache_type
 {
 public:
-	cache_type(): content_()
+	cache_type(): content_(), budget_(0), bytes_(0), items_(0),
+		head_(-1), tail_(-1), hits_(0), misses_(0), evictions_(0)
 	{}
 
 	cache_item<T> &get_element(int index) {
@@ -88,16 +127,111 @@ public:
 		return content_[index];
 	}
 
-	void flush() { content_.clear(); }
+	/** Whether the item at @a index is loaded, without counting it as a use. */
+	bool loaded(int index) const {
+		return static_cast<unsigned>(index) < content_.size() && content_[index].loaded;
+	}
+
+	/** Whether the item at @a index is loaded, marking it as used if it is. */
+	bool lookup(int index) {
+		if(!get_element(index).loaded) {
+			++misses_;
+			return false;
+		}
+		++hits_;
+		if(head_ != index) {
+			unlink(index);
+			link_front(index);
+		}
+		return true;
+	}
+
+	void store(int index, const T &data) {
+		cache_item<T>& elem = get_element(index);
+		if(elem.loaded) {
+			unlink(index);
+			bytes_ -= elem.cost;
+			--items_;
+		}
+		elem.item = data;
+		elem.loaded = true;
+		elem.cost = cache_cost(data);
+		bytes_ += elem.cost;
+		++items_;
+		link_front(index);
+		evict();
+	}
+
+	void set_budget(size_t bytes) {
+		budget_ = bytes;
+		evict();
+	}
+
+	void flush() {
+		content_.clear();
+		bytes_ = 0;
+		items_ = 0;
+		head_ = tail_ = -1;
+	}
+
+	cache_stats statistics(const std::string& name) const {
+		cache_stats res;
+		res.name = name;
+		res.items = items_;
+		res.bytes = bytes_;
+		res.budget = budget_;
+		res.hits = hits_;
+		res.misses = misses_;
+		res.evictions = evictions_;
+		return res;
+	}
 
 private:
+	void unlink(int index) {
+		cache_item<T>& elem = content_[index];
+		if(elem.prev < 0) head_ = elem.next; else content_[elem.prev].next = elem.next;
+		if(elem.next < 0) tail_ = elem.prev; else content_[elem.next].prev = elem.prev;
+		elem.prev = elem.next = -1;
+	}
+
+	void link_front(int index) {
+		cache_item<T>& elem = content_[index];
+		elem.prev = -1;
+		elem.next = head_;
+		if(head_ >= 0) content_[head_].prev = index; else tail_ = index;
+		head_ = index;
+	}
+
+	/** Unloads the least recently used items, but the last one used, to fit into the budget. */
+	void evict() {
+		while(budget_ && bytes_ > budget_ && tail_ != head_) {
+			const int index = tail_;
+			unlink(index);
+			cache_item<T>& elem = content_[index];
+			bytes_ -= elem.cost;
+			--items_;
+			++evictions_;
+			elem = cache_item<T>();
+		}
+	}
+
 	std::vector<cache_item<T> > content_;
+	size_t budget_, bytes_, items_;
+	/** The most and least recently used loaded items, -1 if none. */
+	int head_, tail_;
+	size_t hits_, misses_, evictions_;
 };
 
 template <typename T>
 bool locator::in_cache(cache_type<T> &cache) const
 {
-	return index_ < 0 ? false : cache.get_element(index_).loaded;
+	return index_ < 0 ? false : cache.lookup(index_);
+}
+
+template <typename T>
+bool locator::cached(const cache_type<T> &cache) const
+{
+	return index_ >= 0 && cache.loaded(index_);
 }
 
 template <typename T>
@@ -118,7 +252,7 @@ template <typename T>
 void locator::add_to_cache(cache_type<T> &cache, const T &data) const
 {
 	if (index_ >= 0)
-		cache.get_element(index_) = cache_item<T>(data);
+		cache.store(index_, data);
 }
 
 }
@@ -139,6 +273,12 @@ image::image_cache images_,
 image::texture_cache txt_images_,
 		txt_hexed_images_,
 		txt_brightened_images_;
+
+/**
+ * Holds the hexed textures, so that drawing the terrain of a row of hexes
+ * doesn't change the texture at every hex.
+ */
+sdl::ttexture_atlas hex_atlas_(1024);
 #endif
 
 // cache storing if each image fit in a hex
@@ -160,11 +300,12 @@ image::lit_variants lightmaps_;
 
 std::map<std::string,bool> image_existence_map;
 
-// directories where we already cached file existence
-std::set<std::string> precached_dirs;
-
 std::map<surface, surface> reversed_images_;
 
+/** The images scaled by scaled_image(), by source image and size. */
+typedef std::map<std::pair<surface, std::pair<int, int> >, surface> scaled_image_map;
+scaled_image_map scaled_images_;
+
 int red_adjust = 0, green_adjust = 0, blue_adjust = 0;
 
 /** List of colors used by the TC image modification */
@@ -181,6 +322,187 @@ scaling_function scale_to_hex_func;
 
 } // end anon namespace
 
+namespace {
+
+/**
+ * Decodes image files on background threads, for prefetch().
+ *
+ * The workers only read and decode the files. Finding them, which uses the
+ * caches of the filesystem module, and everything done to the decoded
+ * surfaces happen on the main thread. The surfaces are not reference
+ * counted atomically, so they only change hands inside the lock.
+ */
+class decoder : private boost::noncopyable
+{
+public:
+	decoder()
+		: mutex_(), work_(), done_(), queue_(), requested_(), decoding_()
+		, decoded_(), generation_(0), stop_(false), workers_()
+	{
+		const unsigned count = std::min(2u, std::max(1u, threading::hardware_concurrency() - 1));
+		for(unsigned i = 0; i != count; ++i) {
+			workers_.push_back(new threading::thread(run, this));
+		}
+	}
+
+	~decoder()
+	{
+		{
+			const threading::lock lock(mutex_);
+			stop_ = true;
+			work_.notify_all();
+		}
+		// Joins the workers, once they have finished their current file.
+		workers_.clear();
+	}
+
+	/** Queues the file @a location of @a loc, unless it is already. */
+	void request(const image::locator& loc, const std::string& location)
+	{
+		const threading::lock lock(mutex_);
+		if(requested_.count(loc) || decoded_.count(loc)
+			|| requested_.size() + decoded_.size() >= max_prefetched) {
+			return;
+		}
+		queue_.push_back(request_type(loc, location, generation_));
+		requested_.insert(loc);
+		work_.notify_one();
+	}
+
+	/** Whether @a loc is queued or being decoded. */
+	bool pending(const image::locator& loc)
+	{
+		const threading::lock lock(mutex_);
+		return requested_.count(loc) != 0;
+	}
+
+	/**
+	 * Takes the decoded surface of @a loc if it was requested, waiting for
+	 * it if a worker is decoding it. A request that hasn't been started is
+	 * cancelled and false returned: the caller decodes the file itself.
+	 */
+	bool take(const image::locator& loc, surface& res)
+	{
+		const threading::lock lock(mutex_);
+		while(decoding_.count(loc)) {
+			done_.wait(mutex_);
+		}
+		std::map<image::locator, surface>::iterator i = decoded_.find(loc);
+		if(i != decoded_.end()) {
+			res = i->second;
+			decoded_.erase(i);
+			return true;
+		}
+		if(requested_.erase(loc)) {
+			for(std::deque<request_type>::iterator r = queue_.begin(); r != queue_.end(); ++r) {
+				if(r->loc == loc) {
+					queue_.erase(r);
+					break;
+				}
+			}
+		}
+		return false;
+	}
+
+	/** The images decoded and not taken yet. */
+	std::vector<image::locator> finished()
+	{
+		const threading::lock lock(mutex_);
+		std::vector<image::locator> res;
+		res.reserve(decoded_.size());
+		for(std::map<image::locator, surface>::const_iterator i = decoded_.begin(); i != decoded_.end(); ++i) {
+			res.push_back(i->first);
+		}
+		return res;
+	}
+
+	/** Drops the requests and their results; those being decoded are discarded when done. */
+	void clear()
+	{
+		const threading::lock lock(mutex_);
+		++generation_;
+		queue_.clear();
+		requested_ = decoding_;
+		decoded_.clear();
+	}
+
+private:
+	/** The most images requested or decoded and not taken. */
+	static const size_t max_prefetched = 256;
+
+	struct request_type
+	{
+		request_type() : loc(), location(), generation(0) {}
+		request_type(const image::locator& l, const std::string& p, unsigned g)
+			: loc(l), location(p), generation(g)
+		{}
+
+		image::locator loc;
+		std::string location;
+		/** The value of generation_ when requested. */
+		unsigned generation;
+	};
+
+	static int run(void* data)
+	{
+		decoder& self = *static_cast<decoder*>(data);
+		request_type req;
+		while(self.next(req)) {
+			// SDL takes ownership of the RWops.
+			surface res = IMG_Load_RW(filesystem::load_RWops(req.location), true);
+			self.finish(req, res);
+		}
+		return 0;
+	}
+
+	/** Waits for a request to decode, false when stopping. */
+	bool next(request_type& req)
+	{
+		const threading::lock lock(mutex_);
+		while(queue_.empty() && !stop_) {
+			work_.wait(mutex_);
+		}
+		if(stop_) {
+			return false;
+		}
+		req = queue_.front();
+		queue_.pop_front();
+		decoding_.insert(req.loc);
+		return true;
+	}
+
+	/** Hands @a res over, leaving it empty. */
+	void finish(const request_type& req, surface& res)
+	{
+		const threading::lock lock(mutex_);
+		decoding_.erase(req.loc);
+		requested_.erase(req.loc);
+		if(req.generation == generation_) {
+			decoded_[req.loc] = res;
+		}
+		res = surface();
+		done_.notify_all();
+	}
+
+	threading::mutex mutex_;
+	/** Signals requests to the workers, and their results to take(). */
+	threading::condition work_, done_;
+
+	std::deque<request_type> queue_;
+	/** The images queued or being decoded, and the latter. */
+	std::set<image::locator> requested_, decoding_;
+	std::map<image::locator, surface> decoded_;
+	unsigned generation_;
+	bool stop_;
+
+	boost::ptr_vector<threading::thread> workers_;
+};
+
+/** Started by the first prefetch(), stopped by the image::manager. */
+boost::scoped_ptr<decoder> background_decoder;
+
+}
+
 namespace image {
 
 mini_terrain_cache_map mini_terrain_cache;
@@ -209,8 +531,11 @@ void flush_cache()
 		mini_fogged_terrain_cache.clear();
 		mini_highlighted_terrain_cache.clear();
 		reversed_images_.clear();
+		scaled_images_.clear();
 		image_existence_map.clear();
-		precached_dirs.clear();
+	}
+	if(background_decoder) {
+		background_decoder->clear();
 	}
 	/* We can't reset last_index_, since some locators are still alive
 	   when using :refresh. That would cause them to point to the wrong
@@ -218,6 +543,43 @@ void flush_cache()
 	// last_index_ = 0;
 }
 
+std::vector<cache_stats> cache_statistics()
+{
+	std::vector<cache_stats> res;
+#ifdef _OPENMP
+#pragma omp critical(image_cache)
+#endif //_OPENMP
+	{
+		res.push_back(images_.statistics("images"));
+		res.push_back(scaled_to_zoom_.statistics("scaled to zoom"));
+		res.push_back(hexed_images_.statistics("hexed"));
+		res.push_back(scaled_to_hex_images_.statistics("scaled to hex"));
+		res.push_back(tod_colored_images_.statistics("ToD colored"));
+		res.push_back(brightened_images_.statistics("brightened"));
+		res.push_back(lit_images_.statistics("lit"));
+		res.push_back(lit_scaled_images_.statistics("lit scaled to hex"));
+	}
+	return res;
+}
+
+void set_cache_budget(size_t bytes)
+{
+	const size_t share = bytes / 8;
+#ifdef _OPENMP
+#pragma omp critical(image_cache)
+#endif //_OPENMP
+	{
+		images_.set_budget(share);
+		scaled_to_zoom_.set_budget(share);
+		hexed_images_.set_budget(share);
+		scaled_to_hex_images_.set_budget(share);
+		tod_colored_images_.set_budget(share);
+		brightened_images_.set_budget(share);
+		lit_images_.set_budget(share);
+		lit_scaled_images_.set_budget(share);
+	}
+}
+
 void locator::init_index()
 {
 	locator_finder_t::iterator i = locator_finder.find(val_);
@@ -493,8 +855,10 @@ static surface load_image_file(const image::locator &loc)
 			if (!loc_location.empty()) {
 				location = loc_location;
 			}
-			SDL_RWops *rwops = filesystem::load_RWops(location);
-			res = IMG_Load_RW(rwops, true); // SDL takes ownership of rwops
+			if(!background_decoder || !background_decoder->take(loc, res)) {
+				SDL_RWops *rwops = filesystem::load_RWops(location);
+				res = IMG_Load_RW(rwops, true); // SDL takes ownership of rwops
+			}
 			// If there was no standalone localized image, check if there is an overlay.
 			if (!res.null() && loc_location.empty()) {
 				const std::string ovr_location = get_localized_path(location, "--overlay");
@@ -659,6 +1023,7 @@ manager::manager() {}
 
 manager::~manager()
 {
+	background_decoder.reset();
 	flush_cache();
 }
 
@@ -758,13 +1123,97 @@ void set_zoom(int amount)
 	}
 }
 
+namespace {
+
+/** Scales slices of the rows of an image with xBRZ, see scale_xbrz(). */
+class xbrz_slices : public threading::parallel_job
+{
+public:
+	/** The rows of a slice: xBRZ analyses one more row at the start of each. */
+	static const int rows = 16;
+
+	xbrz_slices(size_t z, const Uint32* src, Uint32* dst, int w, int h)
+		: z_(z), src_(src), dst_(dst), w_(w), h_(h)
+	{}
+
+	size_t count() const { return (h_ + rows - 1) / rows; }
+
+	void run(size_t index)
+	{
+		const int first = index * rows;
+		xbrz::scale(z_, src_, dst_, w_, h_, xbrz::ScalerCfg(), first, std::min(h_, first + rows));
+	}
+
+private:
+	const size_t z_;
+	const Uint32* const src_;
+	Uint32* const dst_;
+	const int w_, h_;
+};
+
+#ifdef HAVE_LIBPNG
+/** The file keeping the result of scaling @a src by @a z, named after its pixels. */
+std::string xbrz_cache_file(const surface& src, size_t z)
+{
+	size_t hash;
+	{
+		const_surface_lock lock(src);
+		hash = boost::hash_range(lock.pixels(), lock.pixels() + src->w * src->h);
+	}
+	std::ostringstream res;
+	res << filesystem::get_cache_dir() << "/xbrz/" << src->w << 'x' << src->h
+		<< '-' << z << '-' << std::hex << hash << ".png";
+	return res.str();
+}
+#endif
+
+}
+
+surface scale_xbrz(const surface& surf, size_t z)
+{
+	// Smaller images are scaled about as fast as a file is read.
+	if(surf == NULL || z < 2 || z > 5 || surf->w * surf->h < 32 * 32) {
+		return scale_surface_xbrz(surf, z);
+	}
+
+	surface src(make_neutral_surface(surf));
+	surface dst(create_neutral_surface(surf->w * z, surf->h * z));
+	if(src == NULL || dst == NULL) {
+		return scale_surface_xbrz(surf, z);
+	}
+
+#ifdef HAVE_LIBPNG
+	const std::string file = xbrz_cache_file(src, z);
+	if(filesystem::file_exists(file)) {
+		const surface cached(IMG_Load_RW(filesystem::load_RWops(file), true));
+		if(cached != NULL && cached->w == dst->w && cached->h == dst->h) {
+			return create_optimized_surface(cached);
+		}
+	}
+#endif
+
+	{
+		const_surface_lock src_lock(src);
+		surface_lock dst_lock(dst);
+		xbrz_slices job(z, src_lock.pixels(), dst_lock.pixels(), src->w, src->h);
+		threading::run_parallel(job, job.count());
+	}
+
+#ifdef HAVE_LIBPNG
+	if(filesystem::create_directory_if_missing(filesystem::directory_name(file))) {
+		save_image(dst, file);
+	}
+#endif
+	return create_optimized_surface(dst);
+}
+
 // F should be a scaling algorithm without "integral" zoom limitations
 template <scaling_function F>
 static surface scale_xbrz_helper(const surface & res, int w, int h)
 {
 	int best_integer_zoom = std::min(w / res.get()->w, h / res.get()->h);
 	int legal_zoom = std::max(std::min(best_integer_zoom, 5), 1);
-	return F(scale_surface_xbrz(res, legal_zoom), w, h);
+	return F(scale_xbrz(res, legal_zoom), w, h);
 }
 
 static scaling_function select_algorithm(gui2::tadvanced_graphics_options::SCALING_ALGORITHM algo)
@@ -972,6 +1421,51 @@ surface get_image(const image::locator& i_locator, TYPE type)
 	return res;
 }
 
+/** The locator of the file decoded for @a i_locator. */
+static locator file_locator(const locator& i_locator)
+{
+	return i_locator.get_type() == locator::SUB_FILE ? locator(i_locator.get_filename()) : i_locator;
+}
+
+void prefetch(const locator& i_locator)
+{
+	if(background_decoder) {
+		// Moves the files decoded since the last call into the cache.
+		BOOST_FOREACH(const locator& loc, background_decoder->finished()) {
+			get_image(loc, UNSCALED);
+		}
+	}
+
+	if(i_locator.is_void() || i_locator.get_filename().empty() || i_locator.cached(images_)) {
+		return;
+	}
+	const locator file = file_locator(i_locator);
+	if(file.cached(images_)) {
+		return;
+	}
+	// Looks for the file as load_image_file(), which will use the
+	// localized version if there is one.
+	std::string location = filesystem::get_binary_file_location("images", file.get_filename());
+	if(location.empty()) {
+		return;
+	}
+	const std::string loc_location = get_localized_path(location);
+	if(!loc_location.empty()) {
+		location = loc_location;
+	}
+
+	if(!background_decoder) {
+		background_decoder.reset(new decoder);
+	}
+	background_decoder->request(file, location);
+}
+
+bool is_pending(const locator& i_locator)
+{
+	return background_decoder && !i_locator.is_void() && !i_locator.cached(images_)
+		&& background_decoder->pending(file_locator(i_locator));
+}
+
 #ifdef SDL_GPU
 sdl::timage get_texture(const locator& loc, TYPE type)
 {
@@ -1008,7 +1502,10 @@ sdl::timage get_texture(const locator& loc, TYPE type)
 			loc.add_to_cache(*cache, txt);
 		} else {
 			surface surf = get_hexed(loc);
-			sdl::timage txt(surf);
+			sdl::timage txt = hex_atlas_.add(surf);
+			if (txt.null()) {
+				txt = sdl::timage(surf);
+			}
 			loc.add_to_cache(*cache, txt);
 		}
 	}
@@ -1116,8 +1613,11 @@ surface get_lighted_image(const image::locator& i_locator, const light_string& l
 
 	// Optimizes surface before storing it
 	res = create_optimized_surface(res);
-	// record the lighted surface in the corresponding variants cache
-	i_locator.access_in_cache(*imap)[ls] = res;
+	// record the lighted surface in the corresponding variants cache,
+	// storing them again so that the cache accounts for the new one
+	lit_variants variants = i_locator.locate_in_cache(*imap);
+	variants[ls] = res;
+	i_locator.add_to_cache(*imap, variants);
 
 	return res;
 }
@@ -1194,66 +1694,54 @@ surface reverse_image(const surface& surf)
 	return rev;
 }
 
-bool exists(const image::locator& i_locator)
+surface scaled_image(const surface& surf, int w, int h)
 {
-	typedef image::locator loc;
-	loc::type type = i_locator.get_type();
-	if (type != loc::FILE && type != loc::SUB_FILE)
-		return false;
+	if(surf == NULL || (surf->w == w && surf->h == h)) {
+		return surf;
+	}
+
+	const scaled_image_map::key_type key(surf, std::make_pair(w, h));
+	const scaled_image_map::iterator itor = scaled_images_.find(key);
+	if(itor != scaled_images_.end()) {
+		return itor->second;
+	}
+
+	const surface res(scale_surface(surf, w, h));
+	if(res != NULL) {
+		scaled_images_.insert(std::make_pair(key, res));
+	}
+	return res;
+}
 
+static bool image_file_exists(const std::string& file)
+{
 	// The insertion will fail if there is already an element in the cache
 	std::pair< std::map< std::string, bool >::iterator, bool >
-		it = image_existence_map.insert(std::make_pair(i_locator.get_filename(), false));
+		it = image_existence_map.insert(std::make_pair(file, false));
 	bool &cache = it.first->second;
 	if (it.second)
-		cache = !filesystem::get_binary_file_location("images", i_locator.get_filename()).empty();
+		cache = !filesystem::get_binary_file_location("images", file).empty();
 	return cache;
 }
 
-static void precache_file_existence_internal(const std::string& dir, const std::string& subdir)
+bool exists(const image::locator& i_locator)
 {
-	const std::string checked_dir = dir + "/" + subdir;
-	if (precached_dirs.find(checked_dir) != precached_dirs.end())
-		return;
-	precached_dirs.insert(checked_dir);
-
-	if (!filesystem::is_directory(checked_dir))
-		return;
-
-	std::vector<std::string> files_found;
-	std::vector<std::string> dirs_found;
-	filesystem::get_files_in_dir(checked_dir, &files_found, &dirs_found,
-			filesystem::FILE_NAME_ONLY, filesystem::NO_FILTER, filesystem::DONT_REORDER);
-
-	for(std::vector<std::string>::const_iterator f = files_found.begin();
-			f != files_found.end(); ++f) {
-		image_existence_map[subdir + *f] = true;
-	}
+	typedef image::locator loc;
+	loc::type type = i_locator.get_type();
+	if (type != loc::FILE && type != loc::SUB_FILE)
+		return false;
 
-	for(std::vector<std::string>::const_iterator d = dirs_found.begin();
-			d != dirs_found.end(); ++d) {
-		precache_file_existence_internal(dir, subdir + *d + "/");
-	}
+	return image_file_exists(i_locator.get_filename());
 }
 
-void precache_file_existence(const std::string& subdir)
+void precache_file_existence()
 {
-	const std::vector<std::string>& paths = filesystem::get_binary_paths("images");
-
-	for(std::vector<std::string>::const_iterator p = paths.begin();
-			 p != paths.end(); ++p) {
-
-		precache_file_existence_internal(*p, subdir);
-	}
+	filesystem::index_binary_paths("images");
 }
 
 bool precached_file_exists(const std::string& file)
 {
-	std::map<std::string, bool>::const_iterator b =  image_existence_map.find(file);
-	if (b != image_existence_map.end())
-		return b->second;
-	else
-		return false;
+	return image_file_exists(file);
 }
 
 void save_image(const locator & i_locator, const std::string & filename)
@@ -1321,6 +1809,8 @@ bool update_from_preferences()
 
 	scale_to_zoom_func = select_algorithm(algo);
 
+	set_cache_budget(static_cast<size_t>(preferences::image_cache_size()) * 1024 * 1024);
+
 	return true;
 }
 
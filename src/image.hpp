@@ -109,6 +109,9 @@ namespace image {
 
 		template <typename T>
 		bool in_cache(cache_type<T> &cache) const;
+		/** As in_cache(), but not counted as a use of the image. */
+		template <typename T>
+		bool cached(const cache_type<T> &cache) const;
 		template <typename T>
 		T &access_in_cache(cache_type<T> &cache) const;
 		template <typename T>
@@ -161,6 +164,28 @@ namespace image {
 
 	void flush_cache();
 
+	/** The state of one of the image caches, see cache_statistics(). */
+	struct cache_stats
+	{
+		std::string name;
+		size_t items;      /**< The images held. */
+		size_t bytes;      /**< The memory they use. */
+		size_t budget;     /**< The memory allowed, 0 for no limit. */
+		size_t hits, misses, evictions;
+	};
+
+	/** The statistics of the caches of surfaces, since the start. */
+	std::vector<cache_stats> cache_statistics();
+
+	/**
+	 * Sets the memory the caches of surfaces may use, 0 for no limit.
+	 *
+	 * The budget is shared evenly between the caches. When one goes over
+	 * its share, the images it holds that were used least recently are
+	 * dropped, to be loaded again when needed.
+	 */
+	void set_cache_budget(size_t bytes);
+
 	///the image manager is responsible for setting up images, and destroying
 	///all images when the program exits. It should probably
 	///be created once for the life of the program
@@ -215,6 +240,24 @@ namespace image {
 	sdl::timage get_texture(const locator &loc, TYPE type=UNSCALED);
 #endif
 
+	/**
+	 * Starts decoding the file of an image on a background thread, so that
+	 * get_image() finds it ready later on.
+	 *
+	 * Only the file is decoded in the background, the modifications of the
+	 * locator and the scaling are still applied by get_image(), which waits
+	 * for a decoding in progress rather than starting it again. The files
+	 * decoded are moved into the cache by the next call.
+	 */
+	void prefetch(const locator& i_locator);
+
+	/**
+	 * Whether the file of an image is being decoded after prefetch(), in
+	 * which case get_image() would wait for it. Callers drawing animations
+	 * can show something else meanwhile.
+	 */
+	bool is_pending(const locator& i_locator);
+
 	///function to get the surface corresponding to an image.
 	///after applying the lightmap encoded in ls
 	///type should be HEXED or SCALED_TO_HEX
@@ -223,6 +266,14 @@ namespace image {
 #endif
 	surface get_lighted_image(const image::locator& i_locator, const light_string& ls, TYPE type);
 
+	/**
+	 * As scale_surface_xbrz(), but the rows of the larger images are scaled
+	 * on several threads, and when saving PNG files is supported the
+	 * results are kept in the cache directory, named after the pixels of
+	 * the source, to be read back the next time.
+	 */
+	surface scale_xbrz(const surface& surf, size_t z);
+
 	///function to get the standard hex mask
 	surface get_hexmask();
 
@@ -239,11 +290,18 @@ namespace image {
 	///and must be freed using SDL_FreeSurface()
 	surface reverse_image(const surface &surf);
 
+	///function to scale an image to @a w x @a h, for the previews and icons
+	///drawn at another size than their own. As for reverse_image(), the image
+	///MUST have originally been returned from an image:: function, and the
+	///scaled images are kept until the cache is flushed.
+	surface scaled_image(const surface &surf, int w, int h);
+
 	///returns true if the given image actually exists, without loading it.
 	bool exists(const locator& i_locator);
 
-	/// precache the existence of files in the subdir (ex: "terrain/")
-	void precache_file_existence(const std::string& subdir = "");
+	/// index the image files of the binary paths, if not done yet
+	void precache_file_existence();
+	/// like exists(), for a plain file name
 	bool precached_file_exists(const std::string& file);
 
 	std::string describe_versions();
@@ -153,7 +153,30 @@ modification_queue modification::decode(const std::string& encoded_mods)
 surface rc_modification::operator()(const surface& src) const
 {
 	// unchecked
-	return recolor_image(src, rc_map_);
+	return recoloring_ ? recolor_image(src, recoloring_->table) : src;
+}
+
+const std::map<Uint32, Uint32>& rc_modification::map() const
+{
+	static const std::map<Uint32, Uint32> empty_map;
+	return recoloring_ ? recoloring_->map : empty_map;
+}
+
+boost::shared_ptr<const rc_modification::recoloring> rc_modification::cached_recoloring(
+	const color_range& new_rgb, const std::vector<Uint32>& old_rgb)
+{
+	// There are a few palettes and color ranges, so there's no need to drop any.
+	typedef std::map<std::pair<color_range, std::vector<Uint32> >,
+		boost::shared_ptr<const recoloring> > tcache;
+	static tcache cache;
+
+	const tcache::key_type key(new_rgb, old_rgb);
+	tcache::iterator i = cache.find(key);
+	if(i == cache.end()) {
+		const boost::shared_ptr<const recoloring> res(new recoloring(recolor_range(new_rgb, old_rgb)));
+		i = cache.insert(std::make_pair(key, res)).first;
+	}
+	return i->second;
 }
 
 surface fl_modification::operator()(const surface& src) const
@@ -435,7 +458,7 @@ surface xbrz_modification::operator()(const surface& src) const
 		return src;
 	}
 
-	return scale_surface_xbrz(src, z_);
+	return scale_xbrz(src, z_);
 }
 
 surface o_modification::operator()(const surface& src) const
@@ -613,14 +636,14 @@ REGISTER_MOD_PARSER(TC, args)
 		return NULL;
 	}
 
-	std::map<Uint32, Uint32> rc_map;
+	boost::shared_ptr<const rc_modification::recoloring> recoloring;
 	try {
 		color_range const& new_color =
 			game_config::color_info(team_color);
 		std::vector<Uint32> const& old_color =
 			game_config::tc_info(params[1]);
 
-		rc_map = recolor_range(new_color,old_color);
+		recoloring = rc_modification::cached_recoloring(new_color,old_color);
 	}
 	catch(config::error const& e) {
 		ERR_DP << "caught config::error while processing TC: "
@@ -631,7 +654,7 @@ REGISTER_MOD_PARSER(TC, args)
 		return NULL;
 	}
 
-	return new rc_modification(rc_map);
+	return new rc_modification(recoloring);
 }
 
 // Team-color-based color range selection and recoloring
@@ -643,14 +666,14 @@ REGISTER_MOD_PARSER(RC, args)
 		//
 		// recolor source palette to color range
 		//
-		std::map<Uint32, Uint32> rc_map;
+		boost::shared_ptr<const rc_modification::recoloring> recoloring;
 		try {
 			color_range const& new_color =
 				game_config::color_info(recolor_params[1]);
 			std::vector<Uint32> const& old_color =
 				game_config::tc_info(recolor_params[0]);
 
-			rc_map = recolor_range(new_color,old_color);
+			recoloring = rc_modification::cached_recoloring(new_color,old_color);
 		}
 		catch (config::error& e) {
 			ERR_DP
@@ -659,10 +682,10 @@ REGISTER_MOD_PARSER(RC, args)
 				<< '\n';
 			ERR_DP
 				<< "bailing out from RC\n";
-			rc_map.clear();
+			recoloring.reset();
 		}
 
-		return new rc_modification(rc_map);
+		return new rc_modification(recoloring);
 	}
 	else {
 		///@Deprecated 1.6 palette switch syntax
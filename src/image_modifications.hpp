@@ -19,8 +19,13 @@
 
 #include "lua_jailbreak_exception.hpp"
 #include "sdl/utils.hpp"
+
+#include <boost/shared_ptr.hpp>
+
 #include <queue>
 
+class color_range;
+
 namespace image {
 
 class modification;
@@ -115,31 +120,53 @@ public:
 class rc_modification : public modification
 {
 public:
+	/** A recolor map and its lookup table, shared by the modifications using it. */
+	struct recoloring
+	{
+		explicit recoloring(const std::map<Uint32, Uint32>& recolor_map)
+			: map(recolor_map)
+			, table(recolor_map)
+		{}
+
+		const std::map<Uint32, Uint32> map;
+		const recolor_table table;
+	};
+
 	/**
 	 * Default constructor.
 	 */
 	rc_modification()
-		: rc_map_()
+		: recoloring_()
 	{}
 	/**
 	 * RC-map based constructor.
 	 * @param recolor_map The palette switch map.
 	 */
 	rc_modification(const std::map<Uint32, Uint32>& recolor_map)
-		: rc_map_(recolor_map)
+		: recoloring_(new recoloring(recolor_map))
+	{}
+	/** Constructor sharing a recoloring, see cached_recoloring(). */
+	rc_modification(const boost::shared_ptr<const recoloring>& recoloring)
+		: recoloring_(recoloring)
 	{}
 	virtual surface operator()(const surface& src) const;
 
 	// The rc modification has a higher priority
 	virtual int priority() const { return 1; }
 
-	bool no_op() const { return rc_map_.empty(); }
+	bool no_op() const { return !recoloring_ || recoloring_->map.empty(); }
+
+	const std::map<Uint32, Uint32>& map() const;
 
-	const std::map<Uint32, Uint32>& map() const { return rc_map_;}
-	std::map<Uint32, Uint32>& map() { return rc_map_;}
+	/**
+	 * The recoloring of @a old_rgb to @a new_rgb, as by recolor_range(),
+	 * computed once for each pair. Units of the same color ranges share it.
+	 */
+	static boost::shared_ptr<const recoloring> cached_recoloring(
+		const color_range& new_rgb, const std::vector<Uint32>& old_rgb);
 
 private:
-	std::map<Uint32, Uint32> rc_map_;
+	boost::shared_ptr<const recoloring> recoloring_;
 };
 
 /**
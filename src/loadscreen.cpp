@@ -36,10 +36,15 @@
 static lg::log_domain log_display("display");
 static lg::log_domain log_loadscreen("loadscreen");
 #define LOG_LS LOG_STREAM(info, log_loadscreen)
+static lg::log_domain log_performance("performance");
+#define LOG_PERF LOG_STREAM(info, log_performance)
 #define ERR_DP LOG_STREAM(err, log_display)
 
 loadscreen::global_loadscreen_manager* loadscreen::global_loadscreen_manager::manager = NULL;
 
+/** Whether a stage was started since the loadscreen was created. */
+static bool stage_started = false;
+
 loadscreen::global_loadscreen_manager::global_loadscreen_manager(CVideo& screen)
   : owns(global_loadscreen == NULL)
 {
@@ -64,6 +69,7 @@ void loadscreen::global_loadscreen_manager::reset()
 		global_loadscreen->clear_screen();
 		delete global_loadscreen;
 		global_loadscreen = NULL;
+		stage_started = false;
 	}
 }
 
@@ -359,12 +365,19 @@ void loadscreen::start_stage(char const *id)
 	}
 	assert(s >= 0);
 
+	const unsigned ticks = SDL_GetTicks();
+	if(stage_started) {
+		LOG_PERF << "loading stage '" << stages[current_stage].id << "' took "
+			<< ticks - stage_time[current_stage] << " ms\n";
+	}
+
 	const load_stage &cs = stages[s];
 	global_loadscreen->prcnt_ = cs.start_pos;
 	global_loadscreen->draw_screen(translation::gettext(cs.name));
 	stage_counter[s] = 0;
-	stage_time[s] = SDL_GetTicks();
+	stage_time[s] = ticks;
 	current_stage = s;
+	stage_started = true;
 }
 
 void loadscreen::increment_progress()
@@ -25,10 +25,14 @@
 #include "SDL_timer.h"
 
 #include "log.hpp"
+#include "thread.hpp"
 
 #include <boost/foreach.hpp>
 #include <boost/date_time.hpp>
 
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 #include <map>
 #include <sstream>
 #include <ctime>
@@ -42,14 +46,233 @@ public:
 	null_streambuf() {}
 };
 
+/** The log waiting to be written, past which the new lines are dropped. */
+const size_t max_pending_bytes = 16 * 1024 * 1024;
+
+class async_sink;
+
+/** Gathers what a thread logs, and hands the complete lines to the sink. */
+class line_streambuf : public std::streambuf
+{
+public:
+	explicit line_streambuf(async_sink& sink) : sink_(sink), line_() {}
+
+protected:
+	virtual int overflow(int c);
+	virtual std::streamsize xsputn(const char* s, std::streamsize n);
+	virtual int sync();
+
+private:
+	async_sink& sink_;
+	std::string line_;
+};
+
+struct thread_stream
+{
+	explicit thread_stream(async_sink& sink) : buf(sink), stream(&buf) {}
+
+	line_streambuf buf;
+	std::ostream stream;
+};
+
+/** Writes the log from its own thread, see lg::start_async_output(). */
+class async_sink : private boost::noncopyable
+{
+public:
+	async_sink(const std::string& path, size_t rotate_size);
+
+	/** Writes what is pending, and waits for the writing thread to end. */
+	~async_sink();
+
+	bool good() const { return path_.empty() || file_.is_open(); }
+
+	/** The stream of the calling thread. */
+	std::ostream& stream();
+
+	/** Queues @a size characters of complete lines for writing. */
+	void append(const char* data, size_t size);
+
+private:
+	static int run(void* data);
+
+	void write(const std::string& text);
+
+	threading::mutex mutex_;
+	threading::condition ready_;
+	std::string pending_;
+	/** The characters dropped since the previous write. */
+	size_t dropped_;
+	bool stopping_;
+	std::map<boost::uint32_t, thread_stream*> streams_;
+
+	const std::string path_;
+	const size_t rotate_size_;
+	std::ofstream file_;
+	size_t file_size_;
+
+	/** Started last; it writes nothing before the first append(). */
+	threading::thread writer_;
+};
+
+int line_streambuf::overflow(int c)
+{
+	if(c != std::char_traits<char>::eof()) {
+		line_ += char(c);
+		if(c == '\n') {
+			sink_.append(line_.data(), line_.size());
+			line_.clear();
+		}
+	}
+	return std::char_traits<char>::not_eof(c);
+}
+
+std::streamsize line_streambuf::xsputn(const char* s, std::streamsize n)
+{
+	line_.append(s, static_cast<size_t>(n));
+	if(memchr(s, '\n', static_cast<size_t>(n))) {
+		const size_t end = line_.rfind('\n') + 1;
+		sink_.append(line_.data(), end);
+		line_.erase(0, end);
+	}
+	return n;
+}
+
+int line_streambuf::sync()
+{
+	if(!line_.empty()) {
+		sink_.append(line_.data(), line_.size());
+		line_.clear();
+	}
+	return 0;
+}
+
+async_sink::async_sink(const std::string& path, size_t rotate_size)
+	: mutex_()
+	, ready_()
+	, pending_()
+	, dropped_(0)
+	, stopping_(false)
+	, streams_()
+	, path_(path)
+	, rotate_size_(rotate_size)
+	, file_()
+	, file_size_(0)
+	, writer_(&async_sink::run, this)
+{
+	if(!path_.empty()) {
+		file_.open(path_.c_str(), std::ios::out | std::ios::app | std::ios::binary);
+		if(file_.is_open()) {
+			file_.seekp(0, std::ios::end);
+			file_size_ = static_cast<size_t>(file_.tellp());
+		}
+	}
+}
+
+async_sink::~async_sink()
+{
+	{
+		threading::lock lock(mutex_);
+		stopping_ = true;
+		ready_.notify_one();
+	}
+	writer_.join();
+	typedef std::map<boost::uint32_t, thread_stream*>::value_type stream_entry;
+	BOOST_FOREACH(const stream_entry& s, streams_) {
+		delete s.second;
+	}
+}
+
+std::ostream& async_sink::stream()
+{
+	const boost::uint32_t id = threading::get_current_thread_id();
+	threading::lock lock(mutex_);
+	thread_stream*& res = streams_[id];
+	if(!res) {
+		res = new thread_stream(*this);
+	}
+	return res->stream;
+}
+
+void async_sink::append(const char* data, size_t size)
+{
+	threading::lock lock(mutex_);
+	if(pending_.size() + size > max_pending_bytes) {
+		dropped_ += size;
+		return;
+	}
+	pending_.append(data, size);
+	ready_.notify_one();
+}
+
+int async_sink::run(void* data)
+{
+	async_sink& sink = *static_cast<async_sink*>(data);
+	std::string text;
+	for(;;) {
+		size_t dropped;
+		bool stopping;
+		{
+			threading::lock lock(sink.mutex_);
+			while(sink.pending_.empty() && !sink.stopping_) {
+				sink.ready_.wait(sink.mutex_);
+			}
+			// Keep both buffers, rather than allocating a new one each time.
+			text.clear();
+			text.swap(sink.pending_);
+			dropped = sink.dropped_;
+			sink.dropped_ = 0;
+			stopping = sink.stopping_;
+		}
+		if(dropped != 0) {
+			std::ostringstream msg;
+			msg << "(" << dropped << " characters of log dropped, the writing falling behind)\n";
+			sink.write(msg.str());
+		}
+		sink.write(text);
+		if(stopping) {
+			return 0;
+		}
+	}
+}
+
+void async_sink::write(const std::string& text)
+{
+	if(!file_.is_open()) {
+		std::cerr.write(text.data(), text.size());
+		std::cerr.flush();
+		return;
+	}
+	file_.write(text.data(), text.size());
+	file_.flush();
+	file_size_ += text.size();
+	if(rotate_size_ != 0 && file_size_ >= rotate_size_) {
+		file_.close();
+		const std::string old = path_ + ".1";
+		std::remove(old.c_str());
+		std::rename(path_.c_str(), old.c_str());
+		file_.open(path_.c_str(), std::ios::out | std::ios::trunc | std::ios::binary);
+		file_size_ = 0;
+	}
+}
+
+async_sink* sink = NULL;
+
+/** Stops the writing thread at exit, if still running. */
+struct sink_stopper
+{
+	~sink_stopper() { lg::stop_async_output(); }
+} stop_sink_at_exit;
+
 } // end anonymous namespace
 
 static std::ostream null_ostream(new null_streambuf);
 static int indent = 0;
 static bool timestamp = true;
 static bool precise_timestamp = false;
+static bool structured = false;
 
 static boost::posix_time::time_facet facet("%Y%m%d %H:%M:%S%F ");
+static boost::posix_time::time_facet structured_facet("%Y-%m-%dT%H:%M:%S%F");
 static std::ostream *output_stream = NULL;
 
 static std::ostream& output()
@@ -57,6 +280,9 @@ static std::ostream& output()
 	if(output_stream) {
 		return *output_stream;
 	}
+	if(sink) {
+		return sink->stream();
+	}
 	return std::cerr;
 }
 
@@ -78,6 +304,21 @@ static domain_map *domains;
 static int strict_level_ = -1;
 void timestamps(bool t) { timestamp = t; }
 void precise_timestamps(bool pt) { precise_timestamp = pt; }
+void structured_output(bool s) { structured = s; }
+
+bool start_async_output(const std::string& path, size_t rotate_size)
+{
+	stop_async_output();
+	sink = new async_sink(path, rotate_size);
+	return sink->good();
+}
+
+void stop_async_output()
+{
+	async_sink* s = sink;
+	sink = NULL;
+	delete s;
+}
 
 logger err("error", 0), warn("warning", 1), info("info", 2), debug("debug", 3);
 log_domain general("general");
@@ -163,15 +404,29 @@ std::string get_timespan(const time_t& t) {
 	return buf;
 }
 
-static void print_precise_timestamp(std::ostream & out)
+static void print_precise_timestamp(std::ostream & out, boost::posix_time::time_facet& f = facet)
 {
-	facet.put(
+	f.put(
 		std::ostreambuf_iterator<char>(out),
 		out,
 		' ',
 		boost::posix_time::microsec_clock::local_time());
 }
 
+static void print_structured_prefix(std::ostream& stream, const char* severity, const std::string& domain)
+{
+	if (timestamp) {
+		stream << "time=";
+		if(precise_timestamp) {
+			print_precise_timestamp(stream, structured_facet);
+		} else {
+			stream << get_timestamp(time(NULL), "%Y-%m-%dT%H:%M:%S");
+		}
+		stream << ' ';
+	}
+	stream << "severity=" << severity << " domain=" << domain << " message=";
+}
+
 std::ostream &logger::operator()(log_domain const &domain, bool show_names, bool do_indent) const
 {
 	if (severity_ > domain.domain_->second) {
@@ -184,6 +439,10 @@ std::ostream &logger::operator()(log_domain const &domain, bool show_names, bool
 			strict_threw_ = true;
 		}
 		std::ostream& stream = output();
+		if (structured) {
+			print_structured_prefix(stream, name_, domain.domain_->first);
+			return stream;
+		}
 		if(do_indent) {
 			for(int i = 0; i != indent; ++i)
 				stream << "  ";
@@ -226,6 +485,51 @@ void scope_logger::do_indent() const
 		(*output_) << "  ";
 }
 
+phase_timer::phase_timer(log_domain const &domain, const std::string& title)
+	: domain_(domain)
+	, title_(title)
+	, phases_()
+	, current_()
+	, start_ticks_(SDL_GetTicks())
+	, phase_ticks_(start_ticks_)
+	, reported_(false)
+{
+}
+
+phase_timer::~phase_timer()
+{
+	if(!reported_) {
+		report();
+	}
+}
+
+void phase_timer::start(const std::string& phase)
+{
+	const int ticks = SDL_GetTicks();
+	if(!current_.empty()) {
+		phases_.push_back(std::make_pair(current_, ticks - phase_ticks_));
+	}
+	current_ = phase;
+	phase_ticks_ = ticks;
+}
+
+void phase_timer::report()
+{
+	start(std::string());
+	reported_ = true;
+	if(info.dont_log(domain_)) {
+		return;
+	}
+
+	std::ostringstream res;
+	res << title_ << " took " << SDL_GetTicks() - start_ticks_ << " ms:\n";
+	for(std::vector<std::pair<std::string, int> >::const_iterator i = phases_.begin();
+			i != phases_.end(); ++i) {
+		res << "  " << i->first << ": " << i->second << " ms\n";
+	}
+	info(domain_) << res.str();
+}
+
 std::stringstream wml_error;
 
 } // end namespace lg
@@ -55,6 +55,7 @@
 #include <sstream> // as above. iostream (actually, iosfwd) declares stringstream as an incomplete type, but does not define it
 #include <string>
 #include <utility>
+#include <vector>
 
 namespace lg {
 
@@ -91,13 +92,50 @@ class logger;
 
 typedef std::pair<const std::string, int> logd;
 
+/** The severities of the loggers, as constants the compiler can test. */
+namespace severity {
+	const int err = 0, warn = 1, info = 2, debug = 3;
+}
+
 class log_domain {
 	logd *domain_;
 public:
 	log_domain(char const *name);
 	friend class logger;
+
+	/**
+	 * The most detailed severity compiled in for the domain; LOG_STREAM
+	 * tests it before anything else, so that the statements of the
+	 * severities above it are dropped by the compiler.
+	 */
+	enum { max_compiled_severity = severity::debug };
+};
+
+/**
+ * A log domain with its messages above @a MaxSeverity left out of the
+ * build: LOG_STREAM(debug, d) then costs nothing at all, not even the test
+ * of the severity set for @a d at run time.
+ */
+template<int MaxSeverity>
+class compiled_log_domain : public log_domain
+{
+public:
+	compiled_log_domain(char const *name) : log_domain(name) {}
+
+	enum { max_compiled_severity = MaxSeverity };
 };
 
+/**
+ * The domains of the hot code paths, such as the pathfinding, whose
+ * debug messages are left out of the builds made with
+ * DISABLE_HOT_DEBUG_LOG defined.
+ */
+#ifdef DISABLE_HOT_DEBUG_LOG
+typedef compiled_log_domain<severity::info> hot_log_domain;
+#else
+typedef compiled_log_domain<severity::debug> hot_log_domain;
+#endif
+
 bool set_log_domain_severity(std::string const &name, int severity);
 bool set_log_domain_severity(std::string const &name, const logger &lg);
 std::string list_logdomains(const std::string& filter);
@@ -132,6 +170,37 @@ public:
 
 void timestamps(bool);
 void precise_timestamps(bool);
+
+/** Writes the log lines as time=, severity=, domain= and message= fields. */
+void structured_output(bool);
+
+/**
+ * Writes the log from a background thread, so that logging never waits
+ * on the disk or the terminal.
+ *
+ * Each thread gathers what it logs in a buffer of its own, and hands the
+ * complete lines over to the writing thread, so that the lines of two
+ * threads no longer get mixed. Should the writing fall too far behind,
+ * the new lines are dropped, and their count logged, rather than waited
+ * for.
+ *
+ * @param path                The file to write the log to, the standard
+ *                            error if empty.
+ * @param rotate_size         When the file gets bigger than this (in bytes,
+ *                            0 for no limit), it is renamed to @a path.1,
+ *                            replacing the previous one, and a new file is
+ *                            started.
+ *
+ * @returns                   Whether the file could be opened; if not, the
+ *                            log still goes to the standard error.
+ */
+bool start_async_output(const std::string& path = std::string(), size_t rotate_size = 0);
+
+/**
+ * Writes what remains of the log and stops the writing thread, the log
+ * going to the standard error again. Called at exit if need be.
+ */
+void stop_async_output();
 std::string get_timestamp(const time_t& t, const std::string& format="%Y%m%d %H:%M:%S ");
 std::string get_timespan(const time_t& t);
 
@@ -168,6 +237,32 @@ private:
 	void do_log_exit();
 };
 
+/**
+ * Measures the wall time of consecutive phases, such as those of the
+ * startup, and logs it to @a domain at info level once they are over.
+ */
+class phase_timer
+{
+public:
+	phase_timer(log_domain const &domain, const std::string& title);
+	~phase_timer();
+
+	/** Ends the current phase, if any, and starts @a phase. */
+	void start(const std::string& phase);
+
+	/** Ends the current phase and logs the time of each phase and their total. */
+	void report();
+
+private:
+	log_domain const &domain_;
+	std::string title_;
+	std::vector<std::pair<std::string, int> > phases_;
+	std::string current_;
+	int start_ticks_;
+	int phase_ticks_;
+	bool reported_;
+};
+
 /**
  * Use this logger to send errors due to deprecated WML.
  * The preferred format is:
@@ -184,9 +279,9 @@ extern std::stringstream wml_error;
 #define log_scope(a) lg::scope_logger scope_logging_object__(lg::general, a);
 #define log_scope2(a,b) lg::scope_logger scope_logging_object__(a, b);
 
-#define LOG_STREAM(a, b) if (lg::a.dont_log(b)) ; else lg::a(b)
+#define LOG_STREAM(a, b) if (lg::severity::a > (b).max_compiled_severity || lg::a.dont_log(b)) ; else lg::a(b)
 
 // When using log_scope/log_scope2 it is nice to have all output indented.
-#define LOG_STREAM_INDENT(a,b) if (lg::a.dont_log(b)) ; else lg::a(b, true, true)
+#define LOG_STREAM_INDENT(a,b) if (lg::severity::a > (b).max_compiled_severity || lg::a.dont_log(b)) ; else lg::a(b, true, true)
 
 #endif
@@ -117,7 +117,8 @@ gamemap::gamemap(const tdata_cache& tdata, const std::string& data):
 		total_width_(0),
 		total_height_(0),
 		border_size_(gamemap::SINGLE_TILE_BORDER),
-		usage_(IS_MAP)
+		usage_(IS_MAP),
+		revision_(0)
 {
 	DBG_G << "loading map: '" << data << "'\n";
 
@@ -135,7 +136,8 @@ gamemap::gamemap(const tdata_cache& tdata, const config& level):
 		total_width_(0),
 		total_height_(0),
 		border_size_(gamemap::SINGLE_TILE_BORDER),
-		usage_(IS_MAP)
+		usage_(IS_MAP),
+		revision_(0)
 {
 	DBG_G << "loading map: '" << level.debug() << "'\n";
 
@@ -160,9 +162,16 @@ gamemap::~gamemap()
 {
 }
 
+void gamemap::new_revision()
+{
+	static unsigned last_revision = 0;
+	revision_ = ++last_revision;
+}
+
 void gamemap::read(const std::string& data, const bool allow_invalid, int border_size, std::string usage) {
 
 	// Initial stuff
+	new_revision();
 	border_size_ = border_size;
 	set_usage(usage);
 	tiles_.clear();
@@ -580,6 +589,7 @@ void gamemap::set_terrain(const map_location& loc, const t_translation::t_terrai
 	}
 
 	tiles_[loc.x + border_size_][loc.y + border_size_] = new_terrain;
+	new_revision();
 
 	// Update the off-map autogenerated tiles
 	map_location adj[6];
@@ -217,6 +217,13 @@ public:
 	std::vector<map_location> parse_location_range(const std::string& xvals,
 	const std::string &yvals, bool with_border = false) const;
 
+	/**
+	 * Identifies the current terrain of the map.
+	 * It changes whenever the terrain does, taking a value that no other map
+	 * had before, so data derived from the terrain can be cached against it.
+	 */
+	unsigned revision() const { return revision_; }
+
 
 protected:
 	t_translation::t_map tiles_;
@@ -232,6 +239,9 @@ protected:
 	 */
 	void clear_border_cache() { borderCache_.clear(); }
 
+	/** Gives the map a new revision(), needed after modifying tiles_. */
+	void new_revision();
+
 private:
 
 	void set_usage(const std::string& usage);
@@ -272,6 +282,8 @@ private:
 
 	/** The kind of map is being loaded. */
 	tusage usage_;
+
+	unsigned revision_;
 };
 
 #endif
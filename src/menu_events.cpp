@@ -27,19 +27,24 @@
 #include "actions/undo.hpp"
 #include "actions/vision.hpp"
 #include "ai/manager.hpp"
+#include "ai/profiler.hpp"
 #include "config_assign.hpp"
 #include "dialogs.hpp"
 #include "display_chat_manager.hpp"
 #include "filechooser.hpp"
+#include "font.hpp"
 #include "formatter.hpp"
+#include "formula.hpp"
 #include "formula_string_utils.hpp"
 #include "game_board.hpp"
+#include "game_config_manager.hpp"
 #include "game_end_exceptions.hpp"
 #include "game_events/manager.hpp"
 #include "game_events/pump.hpp"
 #include "game_preferences.hpp"
 #include "game_state.hpp"
 #include "gettext.hpp"
+#include "gui/auxiliary/draw_profiler.hpp"
 #include "gui/dialogs/chat_log.hpp"
 #include "gui/dialogs/edit_label.hpp"
 #include "gui/dialogs/message.hpp"
@@ -69,6 +74,7 @@
 #include "savegame.hpp"
 #include "save_index.hpp"
 #include "scripting/game_lua_kernel.hpp"
+#include "scripting/lua_profiler.hpp"
 #include "scripting/plugins/manager.hpp"
 #include "sound.hpp"
 #include "statistics_dialog.hpp"
@@ -2007,6 +2013,7 @@ class console_handler : public map_command_handler<console_handler>, private cha
 		void do_layers();
 		void do_fps();
 		void do_benchmark();
+		void do_profile();
 		void do_save();
 		void do_save_quit();
 		void do_quit();
@@ -2025,6 +2032,12 @@ class console_handler : public map_command_handler<console_handler>, private cha
 		void do_set_var();
 		void do_show_var();
 		void do_inspect();
+		void do_ai_profile();
+		void do_formula_cache();
+		void do_image_cache();
+		void do_meminfo();
+		void do_gui_profile();
+		void do_lua_profile();
 		void do_control_dialog();
 		void do_manage();
 		void do_unit();
@@ -2095,6 +2108,8 @@ class console_handler : public map_command_handler<console_handler>, private cha
 				_("Debug layers from terrain under the mouse."), "", "D");
 			register_command("fps", &console_handler::do_fps, _("Show fps."));
 			register_command("benchmark", &console_handler::do_benchmark);
+			register_command("profile", &console_handler::do_profile,
+				_("Show how long each phase of drawing takes, writing the frames to a CSV file if given."), _("[<file>]"));
 			register_command("save", &console_handler::do_save, _("Save game."));
 			register_alias("save", "w");
 			register_command("quit", &console_handler::do_quit, _("Quit game."));
@@ -2134,6 +2149,18 @@ class console_handler : public map_command_handler<console_handler>, private cha
 					, "N");
 			register_command("inspect", &console_handler::do_inspect,
 				_("Launch the gamestate inspector"), "", "D");
+			register_command("ai_profile", &console_handler::do_ai_profile,
+				_("Show or control the profiling of the AI turns."), _("[on|off|reset|dump]"), "D");
+			register_command("formula_cache", &console_handler::do_formula_cache,
+				_("Show the statistics of the formula cache, or clear it."), _("[clear]"), "D");
+			register_command("image_cache", &console_handler::do_image_cache,
+				_("Show the statistics of the image caches."), "", "D");
+			register_command("meminfo", &console_handler::do_meminfo,
+				_("Show the memory used by the caches and the main structures."), "", "D");
+			register_command("gui_profile", &console_handler::do_gui_profile,
+				_("Show or control the profiling of the drawing of the dialogs, heat tinting the widgets redrawn."), _("[on|off|reset|heat]"), "D");
+			register_command("lua_profile", &console_handler::do_lua_profile,
+				_("Show or control the profiling of the Lua scripts."), _("[on|off|reset|dump]"), "D");
 			register_command("manage", &console_handler::do_manage,
 				_("Manage persistence data"), "", "D");
 			register_command("alias", &console_handler::do_set_alias,
@@ -2937,6 +2964,11 @@ void console_handler::do_fps() {
 void console_handler::do_benchmark() {
 	menu_handler_.gui_->toggle_benchmark();
 }
+void console_handler::do_profile() {
+	if (!menu_handler_.gui_->toggle_profiler(get_data())) {
+		command_failed(_("Could not write the profile file."));
+	}
+}
 void console_handler::do_save() {
 	menu_handler_.pc_.do_consolesave(get_data());
 }
@@ -3139,6 +3171,110 @@ void console_handler::do_inspect() {
 	inspect_dialog.show(menu_handler_.gui_->video());
 }
 
+void console_handler::do_ai_profile() {
+	const std::string action = get_data();
+	if (action == "on") {
+		ai::profiler::set_enabled(true);
+	} else if (action == "off") {
+		ai::profiler::set_enabled(false);
+	} else if (action == "reset") {
+		ai::profiler::reset();
+	} else if (action == "dump") {
+		ai::profiler::write_report();
+	} else if (!action.empty()) {
+		command_failed(_("Unknown option: ") + action);
+		return;
+	}
+	print(get_cmd(), ai::profiler::summary());
+}
+
+void console_handler::do_formula_cache() {
+	const std::string action = get_data();
+	if (action == "clear") {
+		game_logic::formula_cache::clear();
+	} else if (!action.empty()) {
+		command_failed(_("Unknown option: ") + action);
+		return;
+	}
+	const game_logic::formula_cache::statistics stats = game_logic::formula_cache::get_statistics();
+	std::ostringstream msg;
+	msg << stats.entries << " formulas (" << stats.text_size << " characters) cached, "
+		<< stats.hits << " hits, " << stats.misses << " misses, "
+		<< stats.uncached << " not cached";
+	print(get_cmd(), msg.str());
+}
+
+void console_handler::do_gui_profile() {
+	const std::string action = get_data();
+	if (action == "on") {
+		gui2::tdraw_profiler::set_enabled(true);
+	} else if (action == "off") {
+		gui2::tdraw_profiler::set_enabled(false);
+	} else if (action == "reset") {
+		gui2::tdraw_profiler::reset();
+	} else if (action == "heat") {
+		gui2::tdraw_profiler::set_enabled(true);
+		gui2::tdraw_profiler::set_show_heat(!gui2::tdraw_profiler::show_heat());
+	} else if (!action.empty()) {
+		command_failed(_("Unknown option: ") + action);
+		return;
+	}
+	print(get_cmd(), gui2::tdraw_profiler::summary());
+}
+
+void console_handler::do_lua_profile() {
+	const std::string action = get_data();
+	if (action == "on") {
+		lua_profiler::set_enabled(true);
+	} else if (action == "off") {
+		lua_profiler::set_enabled(false);
+	} else if (action == "reset") {
+		lua_profiler::reset();
+	} else if (action == "dump") {
+		lua_profiler::write_report();
+	} else if (!action.empty()) {
+		command_failed(_("Unknown option: ") + action);
+		return;
+	}
+	print(get_cmd(), lua_profiler::summary());
+}
+
+void console_handler::do_image_cache() {
+	std::ostringstream msg;
+	BOOST_FOREACH(const image::cache_stats& stats, image::cache_statistics()) {
+		msg << stats.name << ": " << stats.items << " images, "
+			<< stats.bytes / 1024 << " of " << stats.budget / 1024 << " KiB, "
+			<< stats.hits << " hits, " << stats.misses << " misses, "
+			<< stats.evictions << " evicted\n";
+	}
+	print(get_cmd(), msg.str());
+}
+
+void console_handler::do_meminfo() {
+	size_t image_bytes = 0, images = 0;
+	BOOST_FOREACH(const image::cache_stats& stats, image::cache_statistics()) {
+		image_bytes += stats.bytes;
+		images += stats.items;
+	}
+	size_t unit_bytes = 0;
+	BOOST_FOREACH(const unit& u, *resources::units) {
+		unit_bytes += u.memory_usage();
+	}
+	config undo;
+	resources::undo_stack->write(undo);
+
+	std::ostringstream msg;
+	msg << "image caches: " << image_bytes / 1024 << " KiB, " << images << " images\n"
+		<< "font caches: " << font::cache_memory_usage() / 1024 << " KiB\n"
+		<< "game config: " << game_config_manager::get()->game_config().memory_usage() / 1024 << " KiB\n"
+		<< "units: " << unit_bytes / 1024 << " KiB, " << resources::units->size() << " units\n"
+		<< "replay: " << resources::recorder->memory_usage() / 1024 << " KiB, "
+		<< resources::recorder->ncommands() << " commands\n"
+		<< "undo stack: " << undo.memory_usage() / 1024 << " KiB as WML\n"
+		<< "Lua: " << resources::lua_kernel->memory_usage() / 1024 << " KiB";
+	print(get_cmd(), msg.str());
+}
+
 void console_handler::do_control_dialog()
 {
 	gui2::tmp_change_control mp_change_control(&menu_handler_);
@@ -42,246 +42,361 @@ static lg::log_domain log_display("display");
 
 namespace image {
 
-surface getMinimap(int w, int h, const gamemap &map, const team *vw, const std::map<map_location,unsigned int> *reach_map)
+namespace {
+
+const int scale = 8;
+
+/** The settings of the minimap, the hexes are drawn again when they change. */
+struct minimap_preferences
 {
-	const terrain_type_data & tdata = *map.tdata();
+	minimap_preferences()
+		: draw_terrain(preferences::minimap_draw_terrain())
+		, terrain_coding(preferences::minimap_terrain_coding())
+		, draw_villages(preferences::minimap_draw_villages())
+		, unit_coding(preferences::minimap_movement_coding())
+	{}
+
+	bool draw_terrain, terrain_coding, draw_villages, unit_coding;
+};
+
+/** Computes how @a loc looks on the minimap. */
+minimap_hex hex_look(const gamemap &map, const map_location &loc, const team *vw,
+		const std::map<map_location,unsigned int> *reach_map, const minimap_preferences &prefs)
+{
+	minimap_hex hex;
+	hex.highlighted = reach_map && reach_map->count(loc) != 0;
 
-	const int scale = 8;
+	const bool shrouded = (resources::screen != NULL && resources::screen->is_blindfolded()) || (vw != NULL && vw->shrouded(loc));
+	// shrouded hex are not considered fogged (no need to fog a black image)
+	hex.fogged = (vw != NULL && !shrouded && vw->fogged(loc));
 
-	DBG_DP << "creating minimap " << int(map.w()*scale*0.75) << "," << map.h()*scale << "\n";
+	hex.terrain = shrouded ? t_translation::VOID_TERRAIN : map[loc];
 
-	const bool preferences_minimap_draw_terrain = preferences::minimap_draw_terrain();
-	const bool preferences_minimap_terrain_coding = preferences::minimap_terrain_coding();
-	const bool preferences_minimap_draw_villages = preferences::minimap_draw_villages();
-	const bool preferences_minimap_unit_coding = preferences::minimap_movement_coding();
+	if (prefs.draw_villages && map.tdata()->get_terrain_info(hex.terrain).is_village()) {
 
-	const size_t map_width = map.w()*scale*3/4;
-	const size_t map_height = map.h()*scale;
-	if(map_width == 0 || map_height == 0) {
-		return surface(NULL);
-	}
+		int side = (resources::gameboard ? resources::gameboard->village_owner(loc) : -1); //check needed for mp create dialog
 
-	if(!preferences_minimap_draw_villages && !preferences_minimap_draw_terrain)
-	{
-		//return if there is nothing to draw.
-		//(optimisation)
-		double ratio = std::min<double>( w*1.0 / map_width, h*1.0 / map_height);
-		return create_neutral_surface(map_width * ratio, map_height * ratio);
+		SDL_Color col = int_to_color(game_config::team_rgb_range.find("white")->second.min());
+
+		if (!hex.fogged) {
+			if (side > -1) {
+
+				if (prefs.unit_coding || !vw ) {
+					col = team::get_minimap_color(side + 1);
+				} else {
+
+					if (vw->owns_village(loc))
+						col = int_to_color(game_config::color_info(preferences::unmoved_color()).rep());
+					else if (vw->is_enemy(side + 1))
+						col = int_to_color(game_config::color_info(preferences::enemy_color()).rep());
+					else
+						col = int_to_color(game_config::color_info(preferences::allied_color()).rep());
+				}
+			}
+		}
+
+		hex.village = true;
+		hex.village_color = col;
 	}
 
-	surface minimap(create_neutral_surface(map_width, map_height));
-	if(minimap == NULL)
-		return surface(NULL);
+	return hex;
+}
+
+/** Where the hex at @a x, @a y is drawn on the unscaled minimap. */
+SDL_Rect hex_rect(int x, int y)
+{
+	// we need a balanced shift up and down of the hexes.
+	// if not, only the bottom half-hexes are clipped
+	// and it looks asymmetrical.
+
+	// also do 1-pixel shift because the scaling
+	// function seems to do it with its rounding
+	return sdl::create_rect(
+			x * scale * 3 / 4 - 1
+			, y * scale + scale / 4 * (is_odd(x) ? 1 : -1) - 1
+			, scale
+			, scale);
+}
+
+void draw_hex(surface &minimap, const gamemap &map, int x, int y,
+		const minimap_hex &hex, const minimap_preferences &prefs)
+{
+	const terrain_type_data & tdata = *map.tdata();
 
 	typedef mini_terrain_cache_map cache_map;
 	cache_map *normal_cache = &mini_terrain_cache;
 	cache_map *fog_cache = &mini_fogged_terrain_cache;
 	cache_map *highlight_cache = &mini_highlighted_terrain_cache;
 
-	for(int y = 0; y != map.total_height(); ++y)
-		for(int x = 0; x != map.total_width(); ++x) {
+	const bool fogged = hex.fogged;
+	const bool highlighted = hex.highlighted;
+	const t_translation::t_terrain terrain = hex.terrain;
+	const terrain_type& terrain_info = tdata.get_terrain_info(terrain);
 
-			const map_location loc(x,y);
-			if(!map.on_board(loc))
-				continue;
+	SDL_Rect maprect = hex_rect(x, y);
 
-			const bool highlighted = reach_map && reach_map->count(loc) != 0;
+	if (prefs.draw_terrain) {
 
-			const bool shrouded = (resources::screen != NULL && resources::screen->is_blindfolded()) || (vw != NULL && vw->shrouded(loc));
-			// shrouded hex are not considered fogged (no need to fog a black image)
-			const bool fogged = (vw != NULL && !shrouded && vw->fogged(loc));
+		if (prefs.terrain_coding) {
 
-			const t_translation::t_terrain terrain = shrouded ?
-					t_translation::VOID_TERRAIN : map[loc];
-			const terrain_type& terrain_info = tdata.get_terrain_info(terrain);
+			surface surf(NULL);
 
-			// we need a balanced shift up and down of the hexes.
-			// if not, only the bottom half-hexes are clipped
-			// and it looks asymmetrical.
+			bool need_fogging = false;
+			bool need_highlighting = false;
 
-			// also do 1-pixel shift because the scaling
-			// function seems to do it with its rounding
-			SDL_Rect maprect = sdl::create_rect(
-					x * scale * 3 / 4 - 1
-					, y * scale + scale / 4 * (is_odd(x) ? 1 : -1) - 1
-					, 0
-					, 0);
+			cache_map* cache = fogged ? fog_cache : normal_cache;
+			if (highlighted)
+				cache = highlight_cache;
+			cache_map::iterator i = cache->find(terrain);
 
-			if (preferences_minimap_draw_terrain) {
+			if (fogged && i == cache->end()) {
+				// we don't have the fogged version in cache
+				// try the normal cache and ask fogging the image
+				cache = normal_cache;
+				i = cache->find(terrain);
+				need_fogging = true;
+			}
 
-				if (preferences_minimap_terrain_coding) {
+			if (highlighted && i == cache->end()) {
+				// we don't have the highlighted version in cache
+				// try the normal cache and ask fogging the image
+				cache = normal_cache;
+				i = cache->find(terrain);
+				need_highlighting = true;
+			}
 
-					surface surf(NULL);
+			if(i == cache->end()) {
+				std::string base_file =
+						"terrain/" + terrain_info.minimap_image() + ".png";
+				surface tile = get_image(base_file,image::HEXED);
+
+				//Compose images of base and overlay if necessary
+				// NOTE we also skip overlay when base is missing (to avoid hiding the error)
+				if(tile != NULL && tdata.get_terrain_info(terrain).is_combined()) {
+					std::string overlay_file =
+							"terrain/" + terrain_info.minimap_image_overlay() + ".png";
+					surface overlay = get_image(overlay_file,image::HEXED);
+
+					if(overlay != NULL && overlay != tile) {
+						surface combined = create_neutral_surface(tile->w, tile->h);
+						SDL_Rect r = sdl::create_rect(0,0,0,0);
+						sdl_blit(tile, NULL, combined, &r);
+						r.x = std::max(0, (tile->w - overlay->w)/2);
+						r.y = std::max(0, (tile->h - overlay->h)/2);
+						//blit_surface needs neutral surface
+						surface overlay_neutral = make_neutral_surface(overlay);
+						blit_surface(overlay_neutral, NULL, combined, &r);
+						tile = combined;
+					}
+				}
 
-					bool need_fogging = false;
-					bool need_highlighting = false;
+				surf = scale_surface_sharp(tile, scale, scale);
 
-					cache_map* cache = fogged ? fog_cache : normal_cache;
-					if (highlighted)
-						cache = highlight_cache;
-					cache_map::iterator i = cache->find(terrain);
+				i = normal_cache->insert(cache_map::value_type(terrain,surf)).first;
+			}
 
-					if (fogged && i == cache->end()) {
-						// we don't have the fogged version in cache
-						// try the normal cache and ask fogging the image
-						cache = normal_cache;
-						i = cache->find(terrain);
-						need_fogging = true;
-					}
+			surf = i->second;
 
-					if (highlighted && i == cache->end()) {
-						// we don't have the highlighted version in cache
-						// try the normal cache and ask fogging the image
-						cache = normal_cache;
-						i = cache->find(terrain);
-						need_highlighting = true;
-					}
+			if (need_fogging) {
+				surf = adjust_surface_color(surf,-50,-50,-50);
+				fog_cache->insert(cache_map::value_type(terrain,surf));
+			}
 
-					if(i == cache->end()) {
-						std::string base_file =
-								"terrain/" + terrain_info.minimap_image() + ".png";
-						surface tile = get_image(base_file,image::HEXED);
-
-						//Compose images of base and overlay if necessary
-						// NOTE we also skip overlay when base is missing (to avoid hiding the error)
-						if(tile != NULL && tdata.get_terrain_info(terrain).is_combined()) {
-							std::string overlay_file =
-									"terrain/" + terrain_info.minimap_image_overlay() + ".png";
-							surface overlay = get_image(overlay_file,image::HEXED);
-
-							if(overlay != NULL && overlay != tile) {
-								surface combined = create_neutral_surface(tile->w, tile->h);
-								SDL_Rect r = sdl::create_rect(0,0,0,0);
-								sdl_blit(tile, NULL, combined, &r);
-								r.x = std::max(0, (tile->w - overlay->w)/2);
-								r.y = std::max(0, (tile->h - overlay->h)/2);
-								//blit_surface needs neutral surface
-								surface overlay_neutral = make_neutral_surface(overlay);
-								blit_surface(overlay_neutral, NULL, combined, &r);
-								tile = combined;
-							}
-						}
+			if (need_highlighting) {
+				surf = adjust_surface_color(surf,50,50,50);
+				highlight_cache->insert(cache_map::value_type(terrain,surf));
+			}
 
-						surf = scale_surface_sharp(tile, scale, scale);
+			if(surf != NULL)
+				sdl_blit(surf, NULL, minimap, &maprect);
 
-						i = normal_cache->insert(cache_map::value_type(terrain,surf)).first;
-					}
+		} else {
 
-					surf = i->second;
+			SDL_Color col;
+			std::map<std::string, color_range>::const_iterator it = game_config::team_rgb_range.find(terrain_info.id());
+			if (it == game_config::team_rgb_range.end()) {
+				col = create_color(0,0,0,0);
+			} else
+				col = int_to_color(it->second.rep());
 
-					if (need_fogging) {
-						surf = adjust_surface_color(surf,-50,-50,-50);
-						fog_cache->insert(cache_map::value_type(terrain,surf));
-					}
+			bool first = true;
+			const t_translation::t_list& underlying_terrains = tdata.underlying_union_terrain(terrain);
+			BOOST_FOREACH(const t_translation::t_terrain& underlying_terrain, underlying_terrains) {
 
-					if (need_highlighting) {
-						surf = adjust_surface_color(surf,50,50,50);
-						highlight_cache->insert(cache_map::value_type(terrain,surf));
-					}
+				const std::string& terrain_id = tdata.get_terrain_info(underlying_terrain).id();
+				std::map<std::string, color_range>::const_iterator it = game_config::team_rgb_range.find(terrain_id);
+				if (it == game_config::team_rgb_range.end())
+					continue;
 
-					if(surf != NULL)
-						sdl_blit(surf, NULL, minimap, &maprect);
+				SDL_Color tmp = int_to_color(it->second.rep());
 
-				} else {
+				if (fogged) {
+					if (tmp.b < 50) tmp.b = 0;
+					else tmp.b -= 50;
+					if (tmp.g < 50) tmp.g = 0;
+					else tmp.g -= 50;
+					if (tmp.r < 50) tmp.r = 0;
+					else tmp.r -= 50;
+				}
 
-					SDL_Color col;
-					std::map<std::string, color_range>::const_iterator it = game_config::team_rgb_range.find(terrain_info.id());
-					if (it == game_config::team_rgb_range.end()) {
-						col = create_color(0,0,0,0);
-					} else
-						col = int_to_color(it->second.rep());
+				if (highlighted) {
+					if (tmp.b > 205) tmp.b = 255;
+					else tmp.b += 50;
+					if (tmp.g > 205) tmp.g = 255;
+					else tmp.g += 50;
+					if (tmp.r > 205) tmp.r = 255;
+					else tmp.r += 50;
+				}
 
-					bool first = true;
-					const t_translation::t_list& underlying_terrains = tdata.underlying_union_terrain(terrain);
-					BOOST_FOREACH(const t_translation::t_terrain& underlying_terrain, underlying_terrains) {
+				if (first) {
+					first = false;
+					col = tmp;
+				} else {
+					col.r = col.r - (col.r - tmp.r)/2;
+					col.g = col.g - (col.g - tmp.g)/2;
+					col.b = col.b - (col.b - tmp.b)/2;
+				}
+			}
+			SDL_Rect fillrect = sdl::create_rect(maprect.x, maprect.y, scale * 3/4, scale);
+			const Uint32 mapped_col = SDL_MapRGB(minimap->format,col.r,col.g,col.b);
+			sdl::fill_rect(minimap, &fillrect, mapped_col);
+		}
+	}
 
-						const std::string& terrain_id = tdata.get_terrain_info(underlying_terrain).id();
-						std::map<std::string, color_range>::const_iterator it = game_config::team_rgb_range.find(terrain_id);
-						if (it == game_config::team_rgb_range.end())
-							continue;
+	if (hex.village) {
 
-						SDL_Color tmp = int_to_color(it->second.rep());
+		SDL_Rect fillrect = sdl::create_rect(
+				maprect.x
+				, maprect.y
+				, scale * 3/4
+				, scale
+		);
 
-						if (fogged) {
-							if (tmp.b < 50) tmp.b = 0;
-							else tmp.b -= 50;
-							if (tmp.g < 50) tmp.g = 0;
-							else tmp.g -= 50;
-							if (tmp.r < 50) tmp.r = 0;
-							else tmp.r -= 50;
-						}
+		const Uint32 mapped_col = SDL_MapRGB(minimap->format,hex.village_color.r,hex.village_color.g,hex.village_color.b);
+		sdl::fill_rect(minimap, &fillrect, mapped_col);
 
-						if (highlighted) {
-							if (tmp.b > 205) tmp.b = 255;
-							else tmp.b += 50;
-							if (tmp.g > 205) tmp.g = 255;
-							else tmp.g += 50;
-							if (tmp.r > 205) tmp.r = 255;
-							else tmp.r += 50;
-						}
+	}
+}
 
-						if (first) {
-							first = false;
-							col = tmp;
-						} else {
-							col.r = col.r - (col.r - tmp.r)/2;
-							col.g = col.g - (col.g - tmp.g)/2;
-							col.b = col.b - (col.b - tmp.b)/2;
-						}
-					}
-					SDL_Rect fillrect = sdl::create_rect(maprect.x, maprect.y, scale * 3/4, scale);
-					const Uint32 mapped_col = SDL_MapRGB(minimap->format,col.r,col.g,col.b);
-					sdl::fill_rect(minimap, &fillrect, mapped_col);
-				}
-			}
+} // end anon namespace
 
-			if (terrain_info.is_village() && preferences_minimap_draw_villages) {
+bool minimap_hex::operator==(const minimap_hex& h) const
+{
+	return terrain == h.terrain && fogged == h.fogged && highlighted == h.highlighted
+		&& village == h.village && (!village || (village_color.r == h.village_color.r
+			&& village_color.g == h.village_color.g && village_color.b == h.village_color.b));
+}
 
-				int side = (resources::gameboard ? resources::gameboard->village_owner(loc) : -1); //check needed for mp create dialog
+incremental_minimap::incremental_minimap()
+	: minimap_()
+	, scaled_()
+	, scaled_w_(0)
+	, scaled_h_(0)
+	, hexes_()
+	, preferences_(0)
+{
+}
 
-				SDL_Color col = int_to_color(game_config::team_rgb_range.find("white")->second.min());
+void incremental_minimap::clear()
+{
+	minimap_ = NULL;
+	scaled_ = NULL;
+	hexes_.clear();
+}
 
-				if (!fogged) {
-					if (side > -1) {
+surface incremental_minimap::get(int w, int h, const gamemap &map, const team *vw, const std::map<map_location,unsigned int> *reach_map)
+{
+	DBG_DP << "creating minimap " << int(map.w()*scale*0.75) << "," << map.h()*scale << "\n";
 
-						if (preferences_minimap_unit_coding || !vw ) {
-							col = team::get_minimap_color(side + 1);
-						} else {
+	const minimap_preferences prefs;
 
-							if (vw->owns_village(loc))
-								col = int_to_color(game_config::color_info(preferences::unmoved_color()).rep());
-							else if (vw->is_enemy(side + 1))
-								col = int_to_color(game_config::color_info(preferences::enemy_color()).rep());
-							else
-								col = int_to_color(game_config::color_info(preferences::allied_color()).rep());
-						}
-					}
-				}
+	const size_t map_width = map.w()*scale*3/4;
+	const size_t map_height = map.h()*scale;
+	if(map_width == 0 || map_height == 0) {
+		return surface(NULL);
+	}
 
-				SDL_Rect fillrect = sdl::create_rect(
-						maprect.x
-						, maprect.y
-						, scale * 3/4
-						, scale
-				);
+	if(!prefs.draw_villages && !prefs.draw_terrain)
+	{
+		//return if there is nothing to draw.
+		//(optimisation)
+		double ratio = std::min<double>( w*1.0 / map_width, h*1.0 / map_height);
+		return create_neutral_surface(map_width * ratio, map_height * ratio);
+	}
 
-				const Uint32 mapped_col = SDL_MapRGB(minimap->format,col.r,col.g,col.b);
-				sdl::fill_rect(minimap, &fillrect, mapped_col);
+	const unsigned packed_prefs = 1 | prefs.draw_terrain << 1 | prefs.terrain_coding << 2
+		| prefs.draw_villages << 3 | prefs.unit_coding << 4;
+
+	const int total_width = map.total_width(), total_height = map.total_height();
+	const bool rebuild = minimap_ == NULL || size_t(minimap_->w) != map_width
+		|| size_t(minimap_->h) != map_height || packed_prefs != preferences_
+		|| hexes_.size() != size_t(total_width * total_height);
+	if(rebuild) {
+		minimap_ = create_neutral_surface(map_width, map_height);
+		if(minimap_ == NULL)
+			return surface(NULL);
+		hexes_.assign(total_width * total_height, minimap_hex());
+		preferences_ = packed_prefs;
+	}
 
-			}
+	// The hexes overlap: a changed hex is redrawn by clearing its area
+	// and drawing again, in the usual order, all the hexes overlapping it.
+	std::vector<map_location> changed;
+	for(int y = 0; y != total_height; ++y)
+		for(int x = 0; x != total_width; ++x) {
+			const map_location loc(x,y);
+			if(!map.on_board(loc))
+				continue;
 
+			const minimap_hex hex = hex_look(map, loc, vw, reach_map, prefs);
+			minimap_hex& old = hexes_[y * total_width + x];
+			if(rebuild) {
+				old = hex;
+				draw_hex(minimap_, map, x, y, hex, prefs);
+			} else if(!(hex == old)) {
+				old = hex;
+				changed.push_back(loc);
+			}
 		}
 
-	double wratio = w*1.0 / minimap->w;
-	double hratio = h*1.0 / minimap->h;
+	if(!rebuild && changed.empty() && scaled_ != NULL && scaled_w_ == w && scaled_h_ == h) {
+		return scaled_;
+	}
+
+	BOOST_FOREACH(const map_location& loc, changed) {
+		SDL_Rect area = hex_rect(loc.x, loc.y);
+		clip_rect_setter clip(minimap_, &area);
+		sdl::fill_rect(minimap_, &area, 0);
+
+		for(int y = std::max(loc.y - 1, 0); y <= std::min(loc.y + 1, total_height - 1); ++y)
+			for(int x = std::max(loc.x - 1, 0); x <= std::min(loc.x + 1, total_width - 1); ++x) {
+				const map_location neighbour(x,y);
+				if(!map.on_board(neighbour))
+					continue;
+				const SDL_Rect rect = hex_rect(x, y);
+				if(sdl::rects_overlap(area, rect)) {
+					draw_hex(minimap_, map, x, y, hexes_[y * total_width + x], prefs);
+				}
+			}
+	}
+
+	double wratio = w*1.0 / minimap_->w;
+	double hratio = h*1.0 / minimap_->h;
 	double ratio = std::min<double>(wratio, hratio);
 
-	minimap = scale_surface_sharp(minimap,
-		static_cast<int>(minimap->w * ratio), static_cast<int>(minimap->h * ratio));
+	scaled_ = scale_surface_sharp(minimap_,
+		static_cast<int>(minimap_->w * ratio), static_cast<int>(minimap_->h * ratio));
+	scaled_w_ = w;
+	scaled_h_ = h;
 
-	DBG_DP << "done generating minimap\n";
+	DBG_DP << "done generating minimap, " << changed.size() << " hexes redrawn\n";
 
-	return minimap;
+	return scaled_;
+}
+
+surface getMinimap(int w, int h, const gamemap &map, const team *vw, const std::map<map_location,unsigned int> *reach_map)
+{
+	return incremental_minimap().get(w, h, map, vw, reach_map);
 }
 
 #ifdef SDL_GPU
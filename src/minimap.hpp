@@ -15,7 +15,9 @@
 #define MINIMAP_HPP_INCLUDED
 
 #include <cstddef>
+#include <vector>
 #include "map.hpp"
+#include "sdl/utils.hpp"
 
 class gamemap;
 struct surface;
@@ -28,6 +30,47 @@ struct SDL_Rect;
 #endif
 
 namespace image {
+	/** What a hex looks like on the minimap. */
+	struct minimap_hex
+	{
+		minimap_hex() : terrain(), fogged(false), highlighted(false), village(false), village_color() {}
+
+		bool operator==(const minimap_hex& h) const;
+
+		t_translation::t_terrain terrain;
+		bool fogged, highlighted;
+		/** Whether the hex is drawn as a village, in @ref village_color. */
+		bool village;
+		SDL_Color village_color;
+	};
+
+	/**
+	 * A minimap kept between the calls, for a map which changes little at
+	 * a time: only the hexes which look different are drawn again.
+	 */
+	class incremental_minimap
+	{
+	public:
+		incremental_minimap();
+
+		/** Same as getMinimap(). */
+		surface get(int w, int h, const gamemap &map, const team *vw = NULL, const std::map<map_location,unsigned int> *reach_map = NULL);
+
+		/** Forgets the minimap, for example when the terrain images changed. */
+		void clear();
+
+	private:
+		/** The minimap at its full size, and scaled for the last call. */
+		surface minimap_, scaled_;
+		int scaled_w_, scaled_h_;
+
+		/** What each hex of the map looked like, by row. */
+		std::vector<minimap_hex> hexes_;
+
+		/** The minimap preferences it was drawn with. */
+		unsigned preferences_;
+	};
+
 	///function to create the minimap for a given map
 	///the surface returned must be freed by the user
 #ifdef SDL_GPU
@@ -30,6 +30,7 @@
 #include <boost/assign.hpp>
 #include <boost/foreach.hpp>
 #include <boost/make_shared.hpp>
+#include <boost/unordered_map.hpp>
 
 
 static lg::log_domain log_config("config");
@@ -137,7 +138,7 @@ private:
 	          const terrain_info * fallback, unsigned recurse_count) const;
 
 private:
-	typedef std::map<t_translation::t_terrain, int> cache_t;
+	typedef boost::unordered_map<t_translation::t_terrain, int> cache_t;
 
 	/// Config describing the terrain values.
 	config cfg_;
@@ -632,7 +633,8 @@ utils::string_map movetype::resistances::damage_table() const
 {
 	utils::string_map result;
 
-	BOOST_FOREACH( const config::attribute & attrb, cfg_.attribute_range() )
+	const config & cfg = *cfg_;
+	BOOST_FOREACH( const config::attribute & attrb, cfg.attribute_range() )
 		result[attrb.first] = attrb.second;
 
 	return result;
@@ -644,7 +646,8 @@ utils::string_map movetype::resistances::damage_table() const
  */
 int movetype::resistances::resistance_against(const attack_type & attack) const
 {
-	return cfg_[attack.type()].to_int(100);
+	const config & cfg = *cfg_;
+	return cfg[attack.type()].to_int(100);
 }
 
 
@@ -653,7 +656,8 @@ int movetype::resistances::resistance_against(const attack_type & attack) const
  */
 int movetype::resistances::resistance_against(const std::string & damage_type) const
 {
-	return cfg_[damage_type].to_int(100);
+	const config & cfg = *cfg_;
+	return cfg[damage_type].to_int(100);
 }
 
 
@@ -663,14 +667,22 @@ int movetype::resistances::resistance_against(const std::string & damage_type) c
  */
 void movetype::resistances::merge(const config & new_data, bool overwrite)
 {
+	if ( new_data.attribute_count() == 0 )
+		// Nothing will change, so skip the copy-on-write.
+		return;
+
+	// Copy-on-write.
+	if ( !cfg_.unique() )
+		cfg_.reset(new config(*cfg_));
+
 	if ( overwrite )
 		// We do not support child tags here, so do not copy any that might
 		// be in the input. (If in the future we need to support child tags,
 		// change "merge_attributes" to "merge_with".)
-		cfg_.merge_attributes(new_data);
+		cfg_->merge_attributes(new_data);
 	else
 		BOOST_FOREACH( const config::attribute & a, new_data.attribute_range() ) {
-			config::attribute_value & dest = cfg_[a.first];
+			config::attribute_value & dest = (*cfg_)[a.first];
 			dest = std::max(0, dest.to_int(100) + a.second.to_int(0));
 		}
 }
@@ -682,13 +694,13 @@ void movetype::resistances::merge(const config & new_data, bool overwrite)
  */
 void movetype::resistances::write(config & out_cfg, const std::string & child_name) const
 {
-	if ( cfg_.empty() )
+	if ( cfg_->empty() )
 		return;
 
 	if ( child_name.empty() )
-		out_cfg.merge_with(cfg_);
+		out_cfg.merge_with(*cfg_);
 	else
-		out_cfg.add_child(child_name, cfg_);
+		out_cfg.add_child(child_name, *cfg_);
 }
 
 
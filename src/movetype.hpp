@@ -150,11 +150,12 @@ public:
 	};
 
 	/// Stores a set of resistances.
+	/// The copies share the data until one of them is changed.
 	class resistances
 	{
 	public:
-		resistances() : cfg_() {}
-		explicit resistances(const config & cfg) : cfg_(cfg) {}
+		resistances() : cfg_(new config) {}
+		explicit resistances(const config & cfg) : cfg_(new config(cfg)) {}
 
 		/// Returns a map from attack types to resistances.
 		utils::string_map damage_table() const;
@@ -168,7 +169,8 @@ public:
 		void write(config & out_cfg, const std::string & child_name="") const;
 
 	private:
-		config cfg_;
+		/// Never NULL; shared with the copies, so only the const interface is used unless unique.
+		boost::shared_ptr<config> cfg_;
 	};
 
 public:
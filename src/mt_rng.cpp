@@ -71,6 +71,16 @@ uint32_t mt_rng::get_next_random()
 	return result;
 }
 
+void mt_rng::fill(uint32_t* out, size_t n)
+{
+	for(size_t i = 0; i != n; ++i) {
+		out[i] = mt_();
+	}
+	random_calls_ += n;
+	DBG_RND << "pulled " << n << " user randoms up to call " << random_calls_
+		<< " with seed " << std::hex << random_seed_ << '\n';
+}
+
 void mt_rng::rotate_random()
 {
 	seed_random(mt_(),0);
@@ -102,8 +112,9 @@ std::string mt_rng::get_random_seed_str() const {
 void mt_rng::discard(const unsigned int call_count)
 {
 	for(unsigned int i = 0; i < call_count; ++i) {
-		get_next_random();
+		mt_();
 	}
+	random_calls_ += call_count;
 }
 
 } // ends rand_rng namespace
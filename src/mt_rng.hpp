@@ -18,6 +18,8 @@
 #include <boost/cstdint.hpp>
 #include <boost/random/mersenne_twister.hpp>
 
+#include <cstddef>
+
 using boost::uint32_t;
 
 class config;
@@ -39,6 +41,12 @@ public:
 	/** Get a new random number. */
 	uint32_t get_next_random();
 
+	/**
+	 * Gets @a n new random numbers at once, the same as @a n calls of
+	 * get_next_random() would, and counted as many calls.
+	 */
+	void fill(uint32_t* out, size_t n);
+
 	/**
 	 *  Same as uint32_t version, but uses a stringstream to convert given
          *  hex string. 
@@ -88,6 +88,10 @@ struct connection_details {
 typedef std::map<network::connection,connection_details> connection_map;
 connection_map connections;
 
+/** The connection of each socket in #connections. */
+typedef std::map<TCPsocket,network::connection> socket_connection_map;
+socket_connection_map socket_connections;
+
 network::connection connection_id = 1;
 
 /** Stores the time of the last server ping we received. */
@@ -98,9 +102,17 @@ time_t last_ping, last_ping_check = 0;
 static int create_connection(TCPsocket sock, const std::string& host, int port)
 {
 	connections.insert(std::pair<network::connection,connection_details>(connection_id,connection_details(sock,host,port)));
+	socket_connections[sock] = connection_id;
 	return connection_id++;
 }
 
+/** The connection using @a sock, or 0. */
+static network::connection find_connection(TCPsocket sock)
+{
+	const socket_connection_map::const_iterator i = socket_connections.find(sock);
+	return i != socket_connections.end() ? i->second : 0;
+}
+
 static connection_details& get_connection_details(network::connection handle)
 {
 	const connection_map::iterator i = connections.find(handle);
@@ -118,7 +130,16 @@ static TCPsocket get_socket(network::connection handle)
 
 static void remove_connection(network::connection handle)
 {
-	connections.erase(handle);
+	const connection_map::iterator i = connections.find(handle);
+	if(i == connections.end()) {
+		return;
+	}
+
+	const socket_connection_map::iterator s = socket_connections.find(i->second.sock);
+	if(s != socket_connections.end() && s->second == handle) {
+		socket_connections.erase(s);
+	}
+	connections.erase(i);
 }
 
 static bool is_pending_remote_handle(network::connection handle)
@@ -136,10 +157,8 @@ static void check_error()
 {
 	const TCPsocket sock = network_worker_pool::detect_error();
 	if(sock) {
-		for(connection_map::const_iterator i = connections.begin(); i != connections.end(); ++i) {
-			if(i->second.sock == sock) {
-				throw network::error(_("Client disconnected"),i->first);
-			}
+		if(const network::connection connection = find_connection(sock)) {
+			throw network::error(_("Client disconnected"),connection);
 		}
 	}
 }
@@ -243,6 +262,11 @@ pending_statistics get_pending_stats()
 	return network_worker_pool::get_pending_stats();
 }
 
+void set_send_queue_limit(size_t bytes)
+{
+	network_worker_pool::set_send_queue_limit(bytes);
+}
+
 manager::manager(size_t min_threads, size_t max_threads) : free_(true)
 {
 	DBG_NW << "NETWORK MANAGER CALLED!\n";
@@ -697,6 +721,49 @@ void queue_disconnect(network::connection sock)
 	disconnection_queue.push_back(sock);
 }
 
+/**
+ * Hands the sockets with data to read over to the worker threads, which
+ * read a whole packet from them and queue it.
+ */
+static void receive_from_ready_sockets()
+{
+	// The number of ready sockets, to stop looking once all were found.
+	int res = SDLNet_CheckSockets(socket_set,0);
+
+	for(std::set<network::connection>::iterator i = waiting_sockets.begin(); res > 0 && i != waiting_sockets.end(); ) {
+		connection_details& details = get_connection_details(*i);
+		const TCPsocket sock = details.sock;
+		if(SDLNet_SocketReady(sock)) {
+
+			// See if this socket is still waiting for it to be assigned its remote handle.
+			// If it is, then the first 4 bytes must be the remote handle.
+			if(is_pending_remote_handle(*i)) {
+				union {
+				char data[4] ALIGN_4;
+				} buf;
+				int len = SDLNet_TCP_Recv(sock,&buf,4);
+				if(len != 4) {
+					throw error("Remote host disconnected",*i);
+				}
+
+				const int remote_handle = SDLNet_Read32(&buf);
+				set_remote_handle(*i,remote_handle);
+
+				--res;
+				++i;
+				continue;
+			}
+
+			--res;
+			waiting_sockets.erase(i++);
+			SDLNet_TCP_DelSocket(socket_set,sock);
+			network_worker_pool::receive_data(sock);
+		} else {
+			++i;
+		}
+	}
+}
+
 connection receive_data(config& cfg, connection connection_num, unsigned int timeout, bandwidth_in_ptr* bandwidth_in)
 {
 	unsigned int start_ticks = SDL_GetTicks();
@@ -742,37 +809,7 @@ connection receive_data(config& cfg, connection connection_num, bandwidth_in_ptr
 		return 0;
 	}
 
-	const int res = SDLNet_CheckSockets(socket_set,0);
-
-	for(std::set<network::connection>::iterator i = waiting_sockets.begin(); res != 0 && i != waiting_sockets.end(); ) {
-		connection_details& details = get_connection_details(*i);
-		const TCPsocket sock = details.sock;
-		if(SDLNet_SocketReady(sock)) {
-
-			// See if this socket is still waiting for it to be assigned its remote handle.
-			// If it is, then the first 4 bytes must be the remote handle.
-			if(is_pending_remote_handle(*i)) {
-				union {
-				char data[4] ALIGN_4;
-				} buf;
-				int len = SDLNet_TCP_Recv(sock,&buf,4);
-				if(len != 4) {
-					throw error("Remote host disconnected",*i);
-				}
-
-				const int remote_handle = SDLNet_Read32(&buf);
-				set_remote_handle(*i,remote_handle);
-
-				continue;
-			}
-
-			waiting_sockets.erase(i++);
-			SDLNet_TCP_DelSocket(socket_set,sock);
-			network_worker_pool::receive_data(sock);
-		} else {
-			++i;
-		}
-	}
+	receive_from_ready_sockets();
 
 
 	TCPsocket sock = connection_num == 0 ? 0 : get_socket(connection_num);
@@ -788,12 +825,7 @@ connection receive_data(config& cfg, connection connection_num, bandwidth_in_ptr
 		TCPsocket const * err_sock = boost::get_error_info<tcpsocket_info>(e);
 		if(err_sock == NULL)
 			throw;
-		connection err_connection = 0;
-		for(connection_map::const_iterator i = connections.begin(); i != connections.end(); ++i) {
-			if(i->second.sock == *err_sock) {
-				err_connection = i->first;
-			}
-		}
+		const connection err_connection = find_connection(*err_sock);
 		if(err_connection) {
 			throw e << connection_info(err_connection);
 		}
@@ -822,13 +854,7 @@ connection receive_data(config& cfg, connection connection_num, bandwidth_in_ptr
 		return 0;
 	}
 
-	connection result = 0;
-	for(connection_map::const_iterator j = connections.begin(); j != connections.end(); ++j) {
-		if(j->second.sock == sock) {
-			result = j->first;
-			break;
-		}
-	}
+	const connection result = find_connection(sock);
 	if(!cfg.empty()) {
 		DBG_NW << "RECEIVED from: " << result << ": " << cfg;
 	}
@@ -869,37 +895,7 @@ connection receive_data(std::vector<char>& buf, bandwidth_in_ptr* bandwidth_in)
 		return 0;
 	}
 
-	const int res = SDLNet_CheckSockets(socket_set,0);
-
-	for(std::set<network::connection>::iterator i = waiting_sockets.begin(); res != 0 && i != waiting_sockets.end(); ) {
-		connection_details& details = get_connection_details(*i);
-		const TCPsocket sock = details.sock;
-		if(SDLNet_SocketReady(sock)) {
-
-			// See if this socket is still waiting for it to be assigned its remote handle.
-			// If it is, then the first 4 bytes must be the remote handle.
-			if(is_pending_remote_handle(*i)) {
-				union {
-				char data[4] ALIGN_4;
-				} buf;
-				int len = SDLNet_TCP_Recv(sock,&buf,4);
-				if(len != 4) {
-					throw error("Remote host disconnected",*i);
-				}
-
-				const int remote_handle = SDLNet_Read32(&buf);
-				set_remote_handle(*i,remote_handle);
-
-				continue;
-			}
-
-			waiting_sockets.erase(i++);
-			SDLNet_TCP_DelSocket(socket_set,sock);
-			network_worker_pool::receive_data(sock);
-		} else {
-			++i;
-		}
-	}
+	receive_from_ready_sockets();
 
 
 	TCPsocket sock = network_worker_pool::get_received_data(buf);
@@ -925,13 +921,7 @@ connection receive_data(std::vector<char>& buf, bandwidth_in_ptr* bandwidth_in)
 		SDLNet_TCP_Close(sock);
 		return 0;
 	}
-	connection result = 0;
-	for(connection_map::const_iterator j = connections.begin(); j != connections.end(); ++j) {
-		if(j->second.sock == sock) {
-			result = j->first;
-			break;
-		}
-	}
+	const connection result = find_connection(sock);
 
 	assert(result != 0);
 	waiting_sockets.insert(result);
@@ -1155,7 +1145,44 @@ void send_raw_data(const char* buf, int len, connection connection_num, const st
 	const int packet_headers = 4;
 	add_bandwidth_out(packet_type, len + packet_headers);
 
-	network_worker_pool::queue_raw_data(info->second.sock, buf, len);
+	network_worker_pool::queue_raw_data(info->second.sock, buf, len, packet_type);
+}
+
+raw_packet make_raw_packet(const char* buf, int len)
+{
+	return network_worker_pool::make_raw_packet(buf, len);
+}
+
+void send_raw_packet(const raw_packet& packet, connection connection_num, const std::string& packet_type)
+{
+	send_raw_packet(packet, std::vector<connection>(1, connection_num), packet_type);
+}
+
+void send_raw_packet(const raw_packet& packet, const std::vector<connection>& connection_nums, const std::string& packet_type)
+{
+	if(bad_sockets.count(0)) {
+		return;
+	}
+
+	std::vector<TCPsocket> socks;
+	socks.reserve(connection_nums.size());
+	for(std::vector<connection>::const_iterator i = connection_nums.begin(); i != connection_nums.end(); ++i) {
+		if(bad_sockets.count(*i)) {
+			continue;
+		}
+		const connection_map::iterator info = connections.find(*i);
+		if (info == connections.end()) {
+			ERR_NW << "Error: socket: " << *i
+				<< "\tnot found in connection_map. Not sending...\n";
+			continue;
+		}
+		add_bandwidth_out(packet_type, packet->size());
+		socks.push_back(info->second.sock);
+	}
+
+	if(!socks.empty()) {
+		network_worker_pool::queue_raw_packet(socks, packet, packet_type);
+	}
 }
 
 void process_send_queue(connection, size_t)
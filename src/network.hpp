@@ -43,10 +43,26 @@ namespace network {
 struct pending_statistics {
 	int npending_sends;
 	int nbytes_pending_sends;
+	/** The pending sends of each class, which are sent in this order. */
+	int npending_game_sends, npending_chat_sends, npending_lobby_sends;
+	/** The bytes waiting to be sent to the connection most behind. */
+	int nbytes_largest_backlog;
+	/** Games list updates dropped since the start, a newer list having been queued. */
+	int ncoalesced_sends;
+	/** Connections dropped since the start for exceeding set_send_queue_limit(). */
+	int noverflowed_connections;
 };
 
 pending_statistics get_pending_stats();
 
+/**
+ * Limits the bytes waiting to be sent to each connection. A connection
+ * going over the limit is reported by check_error(), as if it had failed.
+ *
+ * @param bytes                   The limit, 0 (the default) for none.
+ */
+void set_send_queue_limit(size_t bytes);
+
 // A network manager must be created before networking can be used.
 // It must be destroyed only after all networking activity stops.
 
@@ -235,6 +251,21 @@ size_t send_data(const config& cfg, connection connection_num = 0,
 void send_raw_data(const char* buf, int len, connection connection_num,
 		const std::string& packet_type = "unknown");
 
+/**
+ * Raw data with its packet header, encoded once and sent down any number of
+ * connections. The send queues all refer to the same copy.
+ */
+typedef boost::shared_ptr<const std::vector<char> > raw_packet;
+
+raw_packet make_raw_packet(const char* buf, int len);
+
+void send_raw_packet(const raw_packet& packet, connection connection_num,
+		const std::string& packet_type = "unknown");
+
+/** Same as send_raw_packet() to each of @a connection_nums, but queued in one go. */
+void send_raw_packet(const raw_packet& packet, const std::vector<connection>& connection_nums,
+		const std::string& packet_type = "unknown");
+
 /**
  * Function to send any data that is in a connection's send_queue,
  * up to a maximum of 'max_size' bytes --
@@ -12,10 +12,11 @@
    See the COPYING file for more details.
 */
 
-#include <deque>
+#include <sstream>
 #include <boost/bind.hpp>
-#include <boost/ref.hpp>
 #include <boost/cstdint.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
 #include <boost/version.hpp>
 #include "log.hpp"
 #include "network_asio.hpp"
@@ -36,10 +37,12 @@ connection::connection(const std::string& host, const std::string& service)
 	, resolver_(io_service_)
 	, socket_(io_service_)
 	, done_(false)
-	, write_buf_()
+	, writes_()
+	, reads_()
 	, read_buf_()
+	, inflater_()
+	, response_text_()
 	, handshake_response_()
-	, payload_size_(0)
 	, bytes_to_write_(0)
 	, bytes_written_(0)
 	, bytes_to_read_(0)
@@ -97,7 +100,7 @@ void connection::handshake()
 	static const boost::uint32_t handshake = 0;
 	boost::asio::async_write(socket_,
 		boost::asio::buffer(reinterpret_cast<const char*>(&handshake), 4),
-		boost::bind(&connection::handle_write, this, _1, _2)
+		boost::bind(&connection::handle_handshake_write, this, _1)
 		);
 	boost::asio::async_read(socket_,
 		boost::asio::buffer(&handshake_response_.binary, 4),
@@ -105,6 +108,14 @@ void connection::handshake()
 		);
 }
 
+void connection::handle_handshake_write(
+		const boost::system::error_code& ec
+		)
+{
+	if(ec)
+		throw system_error(ec);
+}
+
 void connection::handle_handshake(
 		const boost::system::error_code& ec
 		)
@@ -116,27 +127,85 @@ void connection::handle_handshake(
 
 void connection::transfer(const config& request, config& response)
 {
-	io_service_.reset();
+	begin_operation();
+	queue_request(request);
+	queue_response(response_target(&response, NULL));
+}
+
+void connection::transfer(const config& request, wml_event_handler& response)
+{
+	begin_operation();
+	queue_request(request);
+	queue_response(response_target(NULL, &response));
+}
+
+void connection::receive(config& response)
+{
+	begin_operation();
+	queue_response(response_target(&response, NULL));
+}
+
+void connection::begin_operation()
+{
+	// Resetting while operations are queued would lose their handlers.
+	if(writes_.empty() && reads_.empty())
+		io_service_.reset();
 	done_ = false;
+}
 
-	std::ostream os(&write_buf_);
+void connection::queue_request(const config& request)
+{
+	std::ostringstream os;
 	write_gz(os, request);
-	bytes_to_write_ = write_buf_.size() + 4;
+	const std::string& data = os.str();
+	const boost::uint32_t size = htonl(data.size());
+	writes_.push_back(std::string(reinterpret_cast<const char*>(&size), 4));
+	writes_.back() += data;
+	if(writes_.size() == 1)
+		start_write();
+}
+
+void connection::start_write()
+{
+	bytes_to_write_ = writes_.front().size();
 	bytes_written_ = 0;
-	payload_size_ = htonl(bytes_to_write_ - 4);
-	boost::asio::streambuf::const_buffers_type gzipped_data = write_buf_.data();
-	std::deque<boost::asio::const_buffer> bufs(gzipped_data.begin(), gzipped_data.end());
-	bufs.push_front(boost::asio::buffer(reinterpret_cast<const char*>(&payload_size_), 4));
-	boost::asio::async_write(socket_, bufs,
+	boost::asio::async_write(socket_, boost::asio::buffer(writes_.front()),
 		boost::bind(&connection::is_write_complete, this, _1, _2),
 		boost::bind(&connection::handle_write, this, _1, _2)
 		);
+}
+
+void connection::queue_response(const response_target& target)
+{
+	reads_.push_back(target);
+	if(reads_.size() == 1)
+		start_read();
+}
+
+void connection::start_read()
+{
+	bytes_to_read_ = 0;
+	bytes_read_ = 0;
+	response_text_.clear();
+	inflater_.reset(new boost::iostreams::filtering_ostream);
+	inflater_->exceptions(std::ios_base::badbit);
+	inflater_->push(boost::iostreams::gzip_decompressor());
+	inflater_->push(boost::iostreams::back_inserter(response_text_));
 	boost::asio::async_read(socket_, read_buf_,
 		boost::bind(&connection::is_read_complete, this, _1, _2),
-		boost::bind(&connection::handle_read, this, _1, _2, boost::ref(response))
+		boost::bind(&connection::handle_read, this, _1, _2)
 		);
 }
 
+void connection::inflate_received()
+{
+	boost::asio::streambuf::const_buffers_type data = read_buf_.data();
+	for(boost::asio::streambuf::const_buffers_type::const_iterator i = data.begin(); i != data.end(); ++i) {
+		inflater_->write(boost::asio::buffer_cast<const char*>(*i), boost::asio::buffer_size(*i));
+	}
+	read_buf_.consume(read_buf_.size());
+}
+
 void connection::cancel()
 {
 	if(socket_.is_open()) {
@@ -169,9 +238,13 @@ void connection::handle_write(
 	)
 {
 	DBG_NW << "Written " << bytes_transferred << " bytes.\n";
-	write_buf_.consume(bytes_transferred);
 	if(ec)
 		throw system_error(ec);
+	writes_.pop_front();
+	if(!writes_.empty())
+		start_write();
+	else if(reads_.empty())
+		done_ = true;
 }
 
 std::size_t connection::is_read_complete(
@@ -194,6 +267,7 @@ std::size_t connection::is_read_complete(
 			if (bytes_to_read_ < 4)
 				bytes_to_read_ = bytes_transferred;
 		}
+		inflate_received();
 #if BOOST_VERSION >= 103700
 		return bytes_to_read_ - bytes_transferred;
 #else
@@ -204,18 +278,31 @@ std::size_t connection::is_read_complete(
 
 void connection::handle_read(
 	const boost::system::error_code& ec,
-	std::size_t bytes_transferred,
-	config& response
+	std::size_t bytes_transferred
 	)
 {
 	DBG_NW << "Read " << bytes_transferred << " bytes.\n";
 	bytes_to_read_ = 0;
-	bytes_to_write_ = 0;
-	done_ = true;
+	const response_target target = reads_.front();
+	reads_.pop_front();
+	if(reads_.empty() && writes_.empty()) {
+		bytes_to_write_ = 0;
+		done_ = true;
+	}
 	if(ec && ec != boost::asio::error::eof)
 		throw system_error(ec);
-	std::istream is(&read_buf_);
-	read_gz(response, is);
+
+	// Most of the response was inflated while it was received, flush the rest.
+	inflate_received();
+	inflater_->reset();
+	if(target.cfg) {
+		read(*target.cfg, response_text_);
+	} else {
+		std::istringstream is(response_text_);
+		read_events(*target.handler, is);
+	}
+	if(!reads_.empty())
+		start_read();
 }
 
 }
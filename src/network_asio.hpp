@@ -28,10 +28,16 @@
 	#endif
 #endif
 #include <boost/asio.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
 #include <boost/optional.hpp>
+#include <boost/scoped_ptr.hpp>
 #include "exceptions.hpp"
 #include "config.hpp"
 
+#include <deque>
+
+class wml_event_handler;
+
 namespace network_asio {
 
 struct error : public game::error
@@ -39,7 +45,15 @@ struct error : public game::error
 	error(const boost::system::error_code& error) : game::error(error.message()) {}
 };
 
-/** A class that represents a TCP/IP connection. */
+/**
+ * A class that represents a TCP/IP connection.
+ *
+ * Requests can be pipelined: transfer() may be called again before the
+ * previous transfers are done. The requests are then written one after the
+ * other and, since the peer answers them in order, the responses are read
+ * in the order of the calls. The config or handler given for each response
+ * must stay alive until it has been read.
+ */
 class connection
 {
 	boost::asio::io_service io_service_;
@@ -51,8 +65,26 @@ class connection
 
 	bool done_;
 
-	boost::asio::streambuf write_buf_;
+	/** The requests still to be written, each prefixed by its size. */
+	std::deque<std::string> writes_;
+
+	/** Where a response is to be stored, the config or the handler. */
+	struct response_target
+	{
+		response_target(config* c, wml_event_handler* h) : cfg(c), handler(h) {}
+		config* cfg;
+		wml_event_handler* handler;
+	};
+	/** The responses still to be read, the first one being read. */
+	std::deque<response_target> reads_;
+
 	boost::asio::streambuf read_buf_;
+	/**
+	 * Inflates the response being read as its data arrive, so that it is
+	 * ready to be parsed once its last bytes are received.
+	 */
+	boost::scoped_ptr<boost::iostreams::filtering_ostream> inflater_;
+	std::string response_text_;
 
 	void handle_resolve(
 		const boost::system::error_code& ec,
@@ -65,6 +97,9 @@ class connection
 		resolver::iterator iterator
 		);
 	void handshake();
+	void handle_handshake_write(
+		const boost::system::error_code& ec
+		);
 	void handle_handshake(
 		const boost::system::error_code& ec
 		);
@@ -73,6 +108,15 @@ class connection
 		boost::uint32_t num;
 	} handshake_response_;
 
+	/** Resets the io_service if nothing is in progress, before queuing anything. */
+	void begin_operation();
+	void queue_request(const config& request);
+	void queue_response(const response_target& target);
+	void start_write();
+	void start_read();
+	/** Passes the data received so far to the inflater. */
+	void inflate_received();
+
 	std::size_t is_write_complete(
 		const boost::system::error_code& error,
 		std::size_t bytes_transferred
@@ -87,10 +131,8 @@ class connection
 		);
 	void handle_read(
 		const boost::system::error_code& ec,
-		std::size_t bytes_transferred,
-		config& response
+		std::size_t bytes_transferred
 		);
-	boost::uint32_t payload_size_;
 	std::size_t bytes_to_write_;
 	std::size_t bytes_written_;
 	std::size_t bytes_to_read_;
@@ -107,6 +149,18 @@ class connection
 
 	void transfer(const config& request, config& response);
 
+	/**
+	 * Same as transfer(), but the response is passed to @a response as it
+	 * is parsed, see read_events().
+	 */
+	void transfer(const config& request, wml_event_handler& response);
+
+	/** Reads the next data sent by the peer, without sending anything. */
+	void receive(config& response);
+
+	/** The number of responses still to be read. */
+	std::size_t pending_transfers() const { return reads_.size(); }
+
 	/** Handle all pending asynchonous events and return */
 	std::size_t poll()
 	{
@@ -107,13 +107,17 @@ size_t get_shard(TCPsocket sock) { return reinterpret_cast<uintptr_t>(sock)%NUM_
 struct buffer {
 	explicit buffer(TCPsocket sock) :
 		sock(sock),
+		size(0),
 		config_buf(),
 		config_error(""),
 		stream(),
-		raw_buffer()
+		raw_buffer(),
+		shared_buffer()
 		{}
 
 	TCPsocket sock;
+	/** The bytes to send, as counted by get_pending_stats(). */
+	size_t size;
 	mutable config config_buf;
 	std::string config_error;
 	std::ostringstream stream;
@@ -124,19 +128,46 @@ struct buffer {
 	 * sent.
 	 */
 	std::vector<char> raw_buffer;
+
+	/**
+	 * Used instead of raw_buffer when the same data goes to several sockets;
+	 * the buffers queued for them all refer to the one copy.
+	 */
+	network::raw_packet shared_buffer;
 };
 
 
 bool managed = false, raw_data_only = false;
 typedef std::vector< buffer* > buffer_set;
-buffer_set outgoing_bufs[NUM_SHARDS];
+
+/**
+ * The classes of the data sent, in the order threads look for data to send.
+ * A socket gets its data in the order it was queued within a class only.
+ */
+enum SEND_CLASS { GAME_SEND, CHAT_SEND, LOBBY_SEND, NUM_SEND_CLASSES };
+buffer_set outgoing_bufs[NUM_SHARDS][NUM_SEND_CLASSES];
+
+/** The bytes queued for each socket in outgoing_bufs. */
+typedef std::map<TCPsocket, size_t> socket_backlog_map;
+socket_backlog_map send_backlogs[NUM_SHARDS];
+
+/** Sockets with more bytes queued are reported by detect_error(), 0 means no limit. */
+size_t send_queue_limit = 0;
+int coalesced_sends[NUM_SHARDS];
+int overflowed_sockets[NUM_SHARDS];
 
 /** a queue of sockets that we are waiting to receive on */
 typedef std::vector<TCPsocket> receive_list;
 receive_list pending_receives[NUM_SHARDS];
 
 typedef std::deque<buffer*> received_queue;
-received_queue received_data_queue;  // receive_mutex
+/** The data received by the threads of each shard, guarded by its received_mutexes. */
+received_queue received_data_queue[NUM_SHARDS];
+/**
+ * The data taken out of received_data_queue by the thread reading it, a
+ * batch at a time. Only that thread uses it, so it needs no lock.
+ */
+received_queue drained_data_queue;
 
 enum SOCKET_STATE { SOCKET_READY, SOCKET_LOCKED, SOCKET_ERRORED, SOCKET_INTERRUPT };
 typedef std::map<TCPsocket,SOCKET_STATE> socket_state_map;
@@ -148,7 +179,7 @@ socket_stats_map transfer_stats; // stats_mutex
 int socket_errors[NUM_SHARDS];
 threading::mutex* shard_mutexes[NUM_SHARDS];
 threading::mutex* stats_mutex = NULL;
-threading::mutex* received_mutex = NULL;
+threading::mutex* received_mutexes[NUM_SHARDS];
 threading::condition* cond[NUM_SHARDS];
 
 std::map<Uint32,threading::thread*> threads[NUM_SHARDS];
@@ -344,7 +375,7 @@ static void make_network_buffer(const char* input, int len, std::vector<char>& b
 	memcpy(&buf[4], input, len);
 }
 
-static SOCKET_STATE send_buffer(TCPsocket sock, std::vector<char>& buf, int in_size = -1)
+static SOCKET_STATE send_buffer(TCPsocket sock, const std::vector<char>& buf, int in_size = -1)
 {
 //	check_send_buffer_size(sock);
 	size_t upto = 0;
@@ -612,6 +643,10 @@ inline void check_socket_result(TCPsocket& sock, SOCKET_STATE& result)
 	const threading::lock lock(*shard_mutexes[shard]);
 	socket_state_map::iterator lock_it = sockets_locked[shard].find(sock);
 	assert(lock_it != sockets_locked[shard].end());
+	// Its send queue may have overflowed meanwhile, see push_buffer().
+	if(lock_it->second == SOCKET_ERRORED) {
+		result = SOCKET_ERRORED;
+	}
 	lock_it->second = result;
 	if(result == SOCKET_ERRORED) {
 		++socket_errors[shard];
@@ -648,16 +683,20 @@ static int process_queue(void* shard_num)
 			waiting_threads[shard]++;
 			for(;;) {
 
-				buffer_set::iterator itor = outgoing_bufs[shard].begin(), itor_end = outgoing_bufs[shard].end();
-				for(; itor != itor_end; ++itor) {
-					socket_state_map::iterator lock_it = sockets_locked[shard].find((*itor)->sock);
-					assert(lock_it != sockets_locked[shard].end());
-					if(lock_it->second == SOCKET_READY) {
-						lock_it->second = SOCKET_LOCKED;
-						sent_buf = *itor;
-						sock = sent_buf->sock;
-						outgoing_bufs[shard].erase(itor);
-						break;
+				for(int send_class = 0; send_class != NUM_SEND_CLASSES && sock == NULL; ++send_class) {
+					buffer_set& queue = outgoing_bufs[shard][send_class];
+					buffer_set::iterator itor = queue.begin(), itor_end = queue.end();
+					for(; itor != itor_end; ++itor) {
+						socket_state_map::iterator lock_it = sockets_locked[shard].find((*itor)->sock);
+						assert(lock_it != sockets_locked[shard].end());
+						if(lock_it->second == SOCKET_READY) {
+							lock_it->second = SOCKET_LOCKED;
+							sent_buf = *itor;
+							sock = sent_buf->sock;
+							send_backlogs[shard][sock] -= sent_buf->size;
+							queue.erase(itor);
+							break;
+						}
 					}
 				}
 
@@ -712,6 +751,8 @@ static int process_queue(void* shard_num)
  			{
  				// We have file to send over net
  				result = send_file(sent_buf);
+			} else if(sent_buf->shared_buffer) {
+				result = send_buffer(sent_buf->sock, *sent_buf->shared_buffer);
 			} else {
 				if(sent_buf->raw_buffer.empty()) {
 					const std::string &value = sent_buf->stream.str();
@@ -750,8 +791,8 @@ static int process_queue(void* shard_num)
 
 		{
 			// Now add data
-			const threading::lock lock_received(*received_mutex);
-			received_data_queue.push_back(received_data);
+			const threading::lock lock_received(*received_mutexes[shard]);
+			received_data_queue[shard].push_back(received_data);
 		}
 		check_socket_result(sock,result);
 	}
@@ -769,10 +810,10 @@ manager::manager(size_t p_min_threads,size_t p_max_threads) : active_(!managed)
 		managed = true;
 		for(int i = 0; i != NUM_SHARDS; ++i) {
 			shard_mutexes[i] = new threading::mutex();
+			received_mutexes[i] = new threading::mutex();
 			cond[i] = new threading::condition();
 		}
 		stats_mutex = new threading::mutex();
-		received_mutex = new threading::mutex();
 
 		min_threads = p_min_threads;
 		max_threads = p_max_threads;
@@ -819,15 +860,16 @@ manager::~manager()
  			cond[shard] = NULL;
 			delete shard_mutexes[shard];
  			shard_mutexes[shard] = NULL;
+			delete received_mutexes[shard];
+			received_mutexes[shard] = NULL;
  		}
 
 		delete stats_mutex;
-		delete received_mutex;
 		stats_mutex = 0;
-		received_mutex = 0;
 
 		for(int i = 0; i != NUM_SHARDS; ++i) {
 			sockets_locked[i].clear();
+			send_backlogs[i].clear();
 		}
 		transfer_stats.clear();
 
@@ -840,17 +882,39 @@ network::pending_statistics get_pending_stats()
 	network::pending_statistics stats;
 	stats.npending_sends = 0;
 	stats.nbytes_pending_sends = 0;
+	stats.npending_game_sends = 0;
+	stats.npending_chat_sends = 0;
+	stats.npending_lobby_sends = 0;
+	stats.nbytes_largest_backlog = 0;
+	stats.ncoalesced_sends = 0;
+	stats.noverflowed_connections = 0;
 	for(size_t shard = 0; shard != NUM_SHARDS; ++shard) {
 		const threading::lock lock(*shard_mutexes[shard]);
-		stats.npending_sends += outgoing_bufs[shard].size();
-		for(buffer_set::const_iterator i = outgoing_bufs[shard].begin(); i != outgoing_bufs[shard].end(); ++i) {
-			stats.nbytes_pending_sends += (*i)->raw_buffer.size();
+		for(int send_class = 0; send_class != NUM_SEND_CLASSES; ++send_class) {
+			const buffer_set& queue = outgoing_bufs[shard][send_class];
+			stats.npending_sends += queue.size();
+			for(buffer_set::const_iterator i = queue.begin(); i != queue.end(); ++i) {
+				stats.nbytes_pending_sends += (*i)->size;
+			}
 		}
+		stats.npending_game_sends += outgoing_bufs[shard][GAME_SEND].size();
+		stats.npending_chat_sends += outgoing_bufs[shard][CHAT_SEND].size();
+		stats.npending_lobby_sends += outgoing_bufs[shard][LOBBY_SEND].size();
+		for(socket_backlog_map::const_iterator i = send_backlogs[shard].begin(); i != send_backlogs[shard].end(); ++i) {
+			stats.nbytes_largest_backlog = std::max<int>(stats.nbytes_largest_backlog, i->second);
+		}
+		stats.ncoalesced_sends += coalesced_sends[shard];
+		stats.noverflowed_connections += overflowed_sockets[shard];
 	}
 
 	return stats;
 }
 
+void set_send_queue_limit(size_t bytes)
+{
+	send_queue_limit = bytes;
+}
+
 void set_raw_data_only()
 {
 	raw_data_only = true;
@@ -875,27 +939,55 @@ void receive_data(TCPsocket sock)
 	}
 }
 
-TCPsocket get_received_data(TCPsocket sock, config& cfg, network::bandwidth_in_ptr& bandwidth_in)
+/**
+ * Moves the data the threads received since the last call to the end of
+ * drained_data_queue, taking each lock once for all of it.
+ */
+static void drain_received_data()
+{
+	for(size_t shard = 0; shard != NUM_SHARDS; ++shard) {
+		const threading::lock lock_received(*received_mutexes[shard]);
+		received_queue& received = received_data_queue[shard];
+		if(drained_data_queue.empty()) {
+			drained_data_queue.swap(received);
+		} else {
+			drained_data_queue.insert(drained_data_queue.end(), received.begin(), received.end());
+			received.clear();
+		}
+	}
+}
+
+/** The first data received from @a sock, or from any socket if it is NULL, starting at @a itor. */
+static received_queue::iterator find_received_data(received_queue::iterator itor, TCPsocket sock)
 {
-	assert(!raw_data_only);
-	const threading::lock lock_received(*received_mutex);
-	received_queue::iterator itor = received_data_queue.begin();
 	if(sock != NULL) {
-		for(; itor != received_data_queue.end(); ++itor) {
+		for(; itor != drained_data_queue.end(); ++itor) {
 			if((*itor)->sock == sock) {
 				break;
 			}
 		}
 	}
+	return itor;
+}
+
+TCPsocket get_received_data(TCPsocket sock, config& cfg, network::bandwidth_in_ptr& bandwidth_in)
+{
+	assert(!raw_data_only);
+	received_queue::iterator itor = find_received_data(drained_data_queue.begin(), sock);
+	if(itor == drained_data_queue.end()) {
+		const size_t searched = drained_data_queue.size();
+		drain_received_data();
+		itor = find_received_data(drained_data_queue.begin() + searched, sock);
+	}
 
-	if(itor == received_data_queue.end()) {
+	if(itor == drained_data_queue.end()) {
 		return NULL;
 	} else if (!(*itor)->config_error.empty()){
 		// throw the error in parent thread
 		std::string error = (*itor)->config_error;
 		buffer* buf = *itor;
 		TCPsocket err_sock = (*itor)->sock;
-		received_data_queue.erase(itor);
+		drained_data_queue.erase(itor);
 		delete buf;
 		throw config::error(error) << network::tcpsocket_info(err_sock);
 	} else {
@@ -903,7 +995,7 @@ TCPsocket get_received_data(TCPsocket sock, config& cfg, network::bandwidth_in_p
 		const TCPsocket res = (*itor)->sock;
 		buffer* buf = *itor;
 		bandwidth_in.reset(new network::bandwidth_in((*itor)->raw_buffer.size()));
-		received_data_queue.erase(itor);
+		drained_data_queue.erase(itor);
 		delete buf;
 		return res;
 	}
@@ -912,37 +1004,126 @@ TCPsocket get_received_data(TCPsocket sock, config& cfg, network::bandwidth_in_p
 TCPsocket get_received_data(std::vector<char>& out)
 {
 	assert(raw_data_only);
-	const threading::lock lock_received(*received_mutex);
-	if(received_data_queue.empty()) {
-		return NULL;
+	if(drained_data_queue.empty()) {
+		drain_received_data();
+		if(drained_data_queue.empty()) {
+			return NULL;
+		}
 	}
 
-	buffer* buf = received_data_queue.front();
-	received_data_queue.pop_front();
+	buffer* buf = drained_data_queue.front();
+	drained_data_queue.pop_front();
 	out.swap(buf->raw_buffer);
 	const TCPsocket res = buf->sock;
 	delete buf;
 	return res;
 }
 
-static void queue_buffer(TCPsocket sock, buffer* queued_buf)
+static SEND_CLASS send_class(const std::string& packet_type)
+{
+	if(packet_type == "gamelist" || packet_type == "gamelist_diff") {
+		return LOBBY_SEND;
+	} else if(packet_type == "message" || packet_type == "whisper") {
+		return CHAT_SEND;
+	} else {
+		return GAME_SEND;
+	}
+}
+
+/**
+ * Adds @a queued_buf to the queue of its socket, whose shard's mutex the
+ * caller owns.
+ *
+ * A games list replaces the lobby data queued before it, which it
+ * includes. A socket with more than send_queue_limit bytes waiting is
+ * marked errored, so that detect_error() reports it.
+ *
+ * @returns                       Whether a thread should be woken up.
+ */
+static bool push_buffer(size_t shard, buffer* queued_buf, const std::string& packet_type)
+{
+	const TCPsocket sock = queued_buf->sock;
+	buffer_set& queue = outgoing_bufs[shard][send_class(packet_type)];
+	size_t& backlog = send_backlogs[shard][sock];
+
+	if(packet_type == "gamelist") {
+		for(buffer_set::iterator i = queue.begin(); i != queue.end();) {
+			if((*i)->sock == sock) {
+				backlog -= (*i)->size;
+				delete *i;
+				i = queue.erase(i);
+				++coalesced_sends[shard];
+			} else {
+				++i;
+			}
+		}
+	}
+
+	queue.push_back(queued_buf);
+	backlog += queued_buf->size;
+
+	socket_state_map::iterator i = sockets_locked[shard].insert(std::pair<TCPsocket,SOCKET_STATE>(sock,SOCKET_READY)).first;
+	if(send_queue_limit && backlog > send_queue_limit && i->second != SOCKET_ERRORED) {
+		ERR_NW << "more than " << send_queue_limit << " bytes waiting to be sent to socket "
+			<< sock << ", dropping it\n";
+		// A thread sending to it stops, see send_buffer().
+		i->second = SOCKET_ERRORED;
+		++socket_errors[shard];
+		++overflowed_sockets[shard];
+		return false;
+	}
+	return i->second == SOCKET_READY || i->second == SOCKET_ERRORED;
+}
+
+static void queue_buffer(TCPsocket sock, buffer* queued_buf, const std::string& packet_type)
 {
 	const size_t shard = get_shard(sock);
 	const threading::lock lock(*shard_mutexes[shard]);
-	outgoing_bufs[shard].push_back(queued_buf);
-	socket_state_map::const_iterator i = sockets_locked[shard].insert(std::pair<TCPsocket,SOCKET_STATE>(sock,SOCKET_READY)).first;
-	if(i->second == SOCKET_READY || i->second == SOCKET_ERRORED) {
+	if(push_buffer(shard, queued_buf, packet_type)) {
 		cond[shard]->notify_one();
 	}
 
 }
 
-void queue_raw_data(TCPsocket sock, const char* buf, int len)
+void queue_raw_data(TCPsocket sock, const char* buf, int len, const std::string& packet_type)
 {
 	buffer* queued_buf = new buffer(sock);
 	assert(*buf == 31);
 	make_network_buffer(buf, len, queued_buf->raw_buffer);
-	queue_buffer(sock, queued_buf);
+	queued_buf->size = queued_buf->raw_buffer.size();
+	queue_buffer(sock, queued_buf, packet_type);
+}
+
+network::raw_packet make_raw_packet(const char* buf, int len)
+{
+	assert(*buf == 31);
+	std::vector<char>* const data = new std::vector<char>();
+	const network::raw_packet packet(data);
+	make_network_buffer(buf, len, *data);
+	return packet;
+}
+
+void queue_raw_packet(const std::vector<TCPsocket>& socks, const network::raw_packet& packet, const std::string& packet_type)
+{
+	// Take each shard's lock once for all of its sockets.
+	for(size_t shard = 0; shard != NUM_SHARDS; ++shard) {
+		bool wake = false;
+		const threading::lock lock(*shard_mutexes[shard]);
+		for(std::vector<TCPsocket>::const_iterator i = socks.begin(); i != socks.end(); ++i) {
+			if(get_shard(*i) != shard) {
+				continue;
+			}
+			buffer* queued_buf = new buffer(*i);
+			queued_buf->shared_buffer = packet;
+			queued_buf->size = packet->size();
+			if(push_buffer(shard, queued_buf, packet_type)) {
+				wake = true;
+			}
+		}
+		if(wake) {
+			cond[shard]->notify_all();
+		}
+	}
 }
 
 
@@ -950,7 +1131,7 @@ void queue_file(TCPsocket sock, const std::string& filename)
 {
  	buffer* queued_buf = new buffer(sock);
  	queued_buf->config_error = filename;
- 	queue_buffer(sock, queued_buf);
+ 	queue_buffer(sock, queued_buf, "file");
 }
 
 size_t queue_data(TCPsocket sock,const config& buf, const std::string& packet_type)
@@ -960,9 +1141,10 @@ size_t queue_data(TCPsocket sock,const config& buf, const std::string& packet_ty
 	buffer* queued_buf = new buffer(sock);
 	output_to_buffer(sock, buf, queued_buf->stream);
 	const size_t size = queued_buf->stream.str().size();
+	queued_buf->size = size + 4;
 
 	network::add_bandwidth_out(packet_type, size);
-	queue_buffer(sock, queued_buf);
+	queue_buffer(sock, queued_buf, packet_type);
 	return size;
 }
 
@@ -974,27 +1156,33 @@ void remove_buffers(TCPsocket sock)
 {
 	{
 		const size_t shard = get_shard(sock);
-		for(buffer_set::iterator i = outgoing_bufs[shard].begin(); i != outgoing_bufs[shard].end();) {
-			if ((*i)->sock == sock)
-			{
-				buffer* buf = *i;
-				i = outgoing_bufs[shard].erase(i);
-				delete buf;
-			}
-			else
-			{
-				++i;
+		for(int send_class = 0; send_class != NUM_SEND_CLASSES; ++send_class) {
+			buffer_set& queue = outgoing_bufs[shard][send_class];
+			for(buffer_set::iterator i = queue.begin(); i != queue.end();) {
+				if ((*i)->sock == sock)
+				{
+					buffer* buf = *i;
+					i = queue.erase(i);
+					delete buf;
+				}
+				else
+				{
+					++i;
+				}
 			}
 		}
+		send_backlogs[shard].erase(sock);
 	}
 
-	{
-		const threading::lock lock_receive(*received_mutex);
-
-		for(received_queue::iterator j = received_data_queue.begin(); j != received_data_queue.end(); ) {
+	const size_t shard = get_shard(sock);
+	const threading::lock lock_receive(*received_mutexes[shard]);
+	received_queue* const queues[] = { &received_data_queue[shard], &drained_data_queue };
+	for(size_t q = 0; q != sizeof(queues) / sizeof(*queues); ++q) {
+		received_queue& queue = *queues[q];
+		for(received_queue::iterator j = queue.begin(); j != queue.end(); ) {
 			if((*j)->sock == sock) {
 				buffer *buf = *j;
-				j = received_data_queue.erase(j);
+				j = queue.erase(j);
 				delete buf;
 			} else {
 				++j;
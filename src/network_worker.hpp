@@ -51,6 +51,7 @@ private:
 };
 
 network::pending_statistics get_pending_stats();
+void set_send_queue_limit(size_t bytes);
 
 void set_raw_data_only();
 void set_use_system_sendfile(bool);
@@ -58,13 +59,27 @@ void set_use_system_sendfile(bool);
 /** Function to asynchronously received data to the given socket. */
 void receive_data(TCPsocket sock);
 
+/**
+ * Takes the data received from @a sock, or from any socket if it's NULL.
+ *
+ * These, close_socket() and detect_error() must all be called from the
+ * same thread, which reads the received data without locking it.
+ */
 TCPsocket get_received_data(TCPsocket sock, config& cfg, network::bandwidth_in_ptr&);
 
 TCPsocket get_received_data(std::vector<char>& buf);
 
 void queue_file(TCPsocket sock, const std::string&);
 
-void queue_raw_data(TCPsocket sock, const char* buf, int len);
+/**
+ * The queue functions take the type of the data, which decides its class:
+ * the games list and its updates ("gamelist", "gamelist_diff") are sent
+ * after the chat ("message", "whisper"), which is sent after the rest.
+ */
+void queue_raw_data(TCPsocket sock, const char* buf, int len, const std::string& packet_type);
+network::raw_packet make_raw_packet(const char* buf, int len);
+/** Queues @a packet to all of @a socks, which share it. */
+void queue_raw_packet(const std::vector<TCPsocket>& socks, const network::raw_packet& packet, const std::string& packet_type);
 size_t queue_data(TCPsocket sock, const config& buf, const std::string& packet_type);
 bool is_locked(const TCPsocket sock);
 bool close_socket(TCPsocket sock);
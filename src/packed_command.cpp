@@ -0,0 +1,343 @@
+/*
+   Copyright (C) 2015 by the Battle for Wesnoth Project
+   Part of the Battle for Wesnoth Project http://www.wesnoth.org/
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY.
+
+   See the COPYING file for more details.
+*/
+
+/**
+ * @file
+ * A config is packed as its number of attributes, each as a key and a value,
+ * followed by its number of children, each as a tag and the child config.
+ *
+ * A key or tag is a byte, the index of a word of the vocabulary, or
+ * inline_word followed by the string. A value is a type byte followed by
+ * the value. The numbers are unsigned LEB128 varints, the ints being zigzag
+ * encoded, and the strings their length followed by their bytes.
+ */
+
+#include "packed_command.hpp"
+
+#include "config.hpp"
+#include "tstring.hpp"
+#include "util.hpp"
+
+#include <boost/cstdint.hpp>
+#include <boost/foreach.hpp>
+#include <boost/variant/static_visitor.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+/** The tags and keys of the common commands, sorted for the lookups. */
+const char* const vocabulary[] = {
+	"animate", "attack", "attacker_lvl", "attacker_type", "auto_shroud",
+	"chance", "checkup", "choose", "command", "countdown_update", "damage",
+	"defender_lvl", "defender_type", "defender_weapon", "dependent",
+	"destination", "dies", "disband", "end_turn", "fire_event", "from",
+	"from_side", "global_variable", "hits", "id", "init_side", "input",
+	"lua_ai", "message", "move", "mp_checkup", "name", "new_seed",
+	"next_unit_id", "random_calls", "random_seed", "recall", "recruit",
+	"request_id", "result", "sent", "side", "side_invalid", "skip_sighted",
+	"source", "speak", "start", "stopped_early", "team", "team_name", "time",
+	"turn", "type", "undo", "unit_hit", "update_shroud", "value", "weapon", "x",
+	"y"
+};
+const unsigned char vocabulary_size = sizeof(vocabulary) / sizeof(*vocabulary);
+const unsigned char inline_word = 0xff;
+
+enum value_type {
+	BLANK, FALSE_TF, TRUE_TF, NO, YES, INT, UNSIGNED, DOUBLE, STRING, TSTRING,
+	/** A string of two or more comma-separated small numbers, as x= and y= of the moves. */
+	NUMBERS,
+	/** A string of eight lowercase hexadecimal digits, as the random seeds. */
+	SEED
+};
+
+bool word_less(const char* a, const char* b)
+{
+	return std::strcmp(a, b) < 0;
+}
+
+void write_number(std::string& out, unsigned long long n)
+{
+	while(n >= 0x80) {
+		out += char((n & 0x7f) | 0x80);
+		n >>= 7;
+	}
+	out += char(n);
+}
+
+void write_string(std::string& out, const std::string& str)
+{
+	write_number(out, str.size());
+	out += str;
+}
+
+void write_word(std::string& out, const std::string& word)
+{
+	const char* const* end = vocabulary + vocabulary_size;
+	const char* const* it = std::lower_bound(vocabulary, end, word.c_str(), word_less);
+	if(it != end && word == *it) {
+		out += char(it - vocabulary);
+	} else {
+		out += char(inline_word);
+		write_string(out, word);
+	}
+}
+
+/** Whether @a str stays a string of comma-separated numbers once written as NUMBERS. */
+bool parse_numbers(const std::string& str, std::vector<boost::uint32_t>& numbers)
+{
+	numbers.clear();
+	std::string::size_type beg = 0;
+	for(;;) {
+		std::string::size_type end = str.find(',', beg);
+		if(end == std::string::npos) {
+			end = str.size();
+		}
+		// No empty parts, leading zeros or overflows.
+		const std::string::size_type length = end - beg;
+		if(length == 0 || length > 9 || (str[beg] == '0' && length != 1)) {
+			return false;
+		}
+		boost::uint32_t n = 0;
+		for(std::string::size_type i = beg; i != end; ++i) {
+			if(str[i] < '0' || str[i] > '9') {
+				return false;
+			}
+			n = n * 10 + (str[i] - '0');
+		}
+		numbers.push_back(n);
+		if(end == str.size()) {
+			return numbers.size() >= 2;
+		}
+		beg = end + 1;
+	}
+}
+
+bool is_seed(const std::string& str)
+{
+	return str.size() == 8 && str.find_first_not_of("0123456789abcdef") == std::string::npos;
+}
+
+class value_writer : public boost::static_visitor<void>
+{
+	std::string& out_;
+	mutable std::vector<boost::uint32_t> numbers_;
+public:
+	value_writer(std::string& out) : out_(out), numbers_() {}
+
+	void operator()(boost::blank) const
+	{ out_ += char(BLANK); }
+	void operator()(config::attribute_value::true_false b) const
+	{ out_ += char(bool(b) ? TRUE_TF : FALSE_TF); }
+	void operator()(config::attribute_value::yes_no b) const
+	{ out_ += char(bool(b) ? YES : NO); }
+	void operator()(int i) const
+	{
+		out_ += char(INT);
+		const boost::uint32_t u = static_cast<boost::uint32_t>(i);
+		write_number(out_, i < 0 ? ~(u << 1) : u << 1);
+	}
+	void operator()(unsigned long long u) const
+	{ out_ += char(UNSIGNED); write_number(out_, u); }
+	void operator()(double d) const
+	{
+		out_ += char(DOUBLE);
+		boost::uint64_t bits;
+		memcpy(&bits, &d, sizeof(bits));
+		for(int i = 0; i != 8; ++i) {
+			out_ += char(bits >> (8 * i));
+		}
+	}
+	void operator()(const std::string& s) const
+	{
+		if(parse_numbers(s, numbers_)) {
+			out_ += char(NUMBERS);
+			write_number(out_, numbers_.size());
+			BOOST_FOREACH(boost::uint32_t n, numbers_) {
+				write_number(out_, n);
+			}
+		} else if(is_seed(s)) {
+			out_ += char(SEED);
+			const boost::uint32_t seed = static_cast<boost::uint32_t>(strtoul(s.c_str(), NULL, 16));
+			for(int i = 0; i != 4; ++i) {
+				out_ += char(seed >> (8 * i));
+			}
+		} else {
+			out_ += char(STRING);
+			write_string(out_, s);
+		}
+	}
+	void operator()(const t_string& s) const
+	{ out_ += char(TSTRING); write_string(out_, s.to_serialized()); }
+};
+
+void pack(const config& cfg, std::string& out)
+{
+	write_number(out, cfg.attribute_count());
+	BOOST_FOREACH(const config::attribute& a, cfg.attribute_range()) {
+		write_word(out, a.first);
+		a.second.apply_visitor(value_writer(out));
+	}
+	write_number(out, cfg.all_children_count());
+	BOOST_FOREACH(const config::any_child& c, cfg.all_children_range()) {
+		write_word(out, c.key);
+		pack(c.cfg, out);
+	}
+}
+
+/** Reads back what pack() wrote; the data is trusted, never having left the process. */
+class reader
+{
+public:
+	reader(const std::string& packed)
+		: pos_(reinterpret_cast<const unsigned char*>(packed.data()))
+		, end_(pos_ + packed.size())
+	{
+	}
+
+	void read_config(config& cfg)
+	{
+		for(size_t n = read_number(); n != 0; --n) {
+			config::attribute_value& v = cfg[read_word()];
+			switch(read_byte()) {
+			case BLANK:
+				break;
+			case FALSE_TF:
+				v = config::attribute_value::s_false;
+				break;
+			case TRUE_TF:
+				v = config::attribute_value::s_true;
+				break;
+			case NO:
+				v = false;
+				break;
+			case YES:
+				v = true;
+				break;
+			case INT: {
+				const boost::uint32_t u = static_cast<boost::uint32_t>(read_number());
+				v = static_cast<int>(u & 1 ? ~(u >> 1) : u >> 1);
+				break;
+			}
+			case UNSIGNED:
+				v = read_number();
+				break;
+			case DOUBLE: {
+				boost::uint64_t bits = 0;
+				for(int i = 0; i != 8; ++i) {
+					bits |= boost::uint64_t(read_byte()) << (8 * i);
+				}
+				double d;
+				memcpy(&d, &bits, sizeof(d));
+				v = d;
+				break;
+			}
+			case STRING:
+				v = read_string();
+				break;
+			case TSTRING:
+				v = t_string::from_serialized(read_string());
+				break;
+			case NUMBERS: {
+				std::string str;
+				for(size_t count = read_number(); count != 0; --count) {
+					if(!str.empty()) {
+						str += ',';
+					}
+					str += str_cast(read_number());
+				}
+				v = str;
+				break;
+			}
+			case SEED: {
+				boost::uint32_t seed = 0;
+				for(int i = 0; i != 4; ++i) {
+					seed |= boost::uint32_t(read_byte()) << (8 * i);
+				}
+				static const char digits[] = "0123456789abcdef";
+				std::string str(8, '0');
+				for(int i = 7; i >= 0; --i, seed >>= 4) {
+					str[i] = digits[seed & 0xf];
+				}
+				v = str;
+				break;
+			}
+			default:
+				assert(false);
+			}
+		}
+		for(size_t n = read_number(); n != 0; --n) {
+			read_config(cfg.add_child(read_word()));
+		}
+	}
+
+private:
+	unsigned char read_byte()
+	{
+		assert(pos_ != end_);
+		return *pos_++;
+	}
+
+	unsigned long long read_number()
+	{
+		unsigned long long res = 0;
+		for(unsigned shift = 0; ; shift += 7) {
+			const unsigned char c = read_byte();
+			res |= static_cast<unsigned long long>(c & 0x7f) << shift;
+			if(!(c & 0x80)) {
+				return res;
+			}
+		}
+	}
+
+	std::string read_string()
+	{
+		const size_t size = static_cast<size_t>(read_number());
+		assert(size <= static_cast<size_t>(end_ - pos_));
+		const std::string res(reinterpret_cast<const char*>(pos_), size);
+		pos_ += size;
+		return res;
+	}
+
+	std::string read_word()
+	{
+		const unsigned char word = read_byte();
+		if(word == inline_word) {
+			return read_string();
+		}
+		assert(word < vocabulary_size);
+		return vocabulary[word];
+	}
+
+	const unsigned char* pos_;
+	const unsigned char* const end_;
+};
+
+} // end anonymous namespace
+
+void pack_command(const config& cfg, std::string& out)
+{
+	out.clear();
+	pack(cfg, out);
+}
+
+void unpack_command(const std::string& packed, config& cfg)
+{
+	cfg.clear();
+	reader(packed).read_config(cfg);
+}
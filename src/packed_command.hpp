@@ -0,0 +1,41 @@
+/*
+   Copyright (C) 2015 by the Battle for Wesnoth Project
+   Part of the Battle for Wesnoth Project http://www.wesnoth.org/
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY.
+
+   See the COPYING file for more details.
+*/
+
+/**
+ * @file
+ * A compact binary form of the replay commands, for keeping them in memory.
+ *
+ * The tags and keys of the common commands (moves, attacks, recruits,
+ * recalls, end of turns, random seeds and their checkups) are stored as a
+ * byte, the coordinate lists of the moves and the seeds as numbers; the
+ * other tags, keys and values are stored as they are. Any config packs and
+ * unpacks to an equal config, with attributes of the same types.
+ *
+ * The form changes from one build to the next; it must not be written out.
+ */
+
+#ifndef PACKED_COMMAND_HPP_INCLUDED
+#define PACKED_COMMAND_HPP_INCLUDED
+
+#include <string>
+
+class config;
+
+/** Packs @a cfg, the contents of a [command], into @a out. */
+void pack_command(const config& cfg, std::string& out);
+
+/** Unpacks what pack_command() gave into @a cfg, clobbering existing data. */
+void unpack_command(const std::string& packed, config& cfg);
+
+#endif
@@ -19,11 +19,14 @@
 #include "map.hpp"
 #include "pathfind/pathfind.hpp"
 #include "pathfind/teleport.hpp"
+#include "thread.hpp"
 
-#include <queue>
-#include <map>
+#include <boost/detail/atomic_count.hpp>
+#include <boost/foreach.hpp>
 
-static lg::log_domain log_engine("engine");
+#include <algorithm>
+
+static lg::hot_log_domain log_engine("engine");
 #define LOG_PF LOG_STREAM(info, log_engine)
 #define DBG_PF LOG_STREAM(debug, log_engine)
 #define ERR_PF LOG_STREAM(err, log_engine)
@@ -59,15 +62,13 @@ double heuristic(const map_location& src, const map_location& dst)
 
 // values 0 and 1 mean uninitialized
 const unsigned bad_search_counter = 0;
-// The number of nodes already processed.
-static unsigned search_counter = bad_search_counter;
 
 struct node {
 	double g, h, t;
 	map_location curr, prev;
 	/**
-	 * If equal to search_counter, the node is off the list.
-	 * If equal to search_counter + 1, the node is on the list.
+	 * If equal to the search counter of the workspace, the node is off the list.
+	 * If equal to that search counter + 1, the node is on the list.
 	 * Otherwise it is outdated.
 	 */
 	unsigned in;
@@ -81,41 +82,94 @@ struct node {
 		, in(bad_search_counter)
 	{
 	}
-	node(double s, const map_location &c, const map_location &p, const map_location &dst, bool i, const teleport_map* teleports):
-		g(s), h(heuristic(c, dst)), t(g + h), curr(c), prev(p), in(search_counter + i)
+	node(double s, const map_location &c, const map_location &p, double heur, bool i, unsigned search_counter):
+		g(s), h(heur), t(g + h), curr(c), prev(p), in(search_counter + i)
 	{
-		if (teleports && !teleports->empty()) {
+	}
 
-			double new_srch = 1.0;
-			std::set<map_location> sources;
-			teleports->get_sources(sources);
+	bool operator<(const node& o) const {
+		return t < o.t;
+	}
+};
 
-			std::set<map_location>::const_iterator it = sources.begin();
-			for(; it != sources.end(); ++it) {
-				const double tmp_srch = heuristic(c, *it);
-				if (tmp_srch < new_srch) { new_srch = tmp_srch; }
-			}
+/** The goal of a search towards a single destination. */
+class single_goal {
+	const map_location dst_;
+
+public:
+	explicit single_goal(const map_location& dst) : dst_(dst) { }
+	double distance(const map_location& loc) const {
+		return heuristic(loc, dst_);
+	}
+	bool contains(const map_location& loc) const {
+		return loc == dst_;
+	}
+};
+
+/**
+ * The goal of a search towards the nearest of several destinations.
+ * Using the minimum over the destinations keeps the heuristic admissible.
+ */
+class multi_goal {
+	const std::vector<map_location>& dsts_;
+
+public:
+	/** @a dsts must be sorted and not empty. */
+	explicit multi_goal(const std::vector<map_location>& dsts) : dsts_(dsts) { }
+	double distance(const map_location& loc) const {
+		double res = heuristic(loc, dsts_.front());
+		for (size_t i = 1; i < dsts_.size(); ++i) {
+			const double tmp = heuristic(loc, dsts_[i]);
+			if (tmp < res) { res = tmp; }
+		}
+		return res;
+	}
+	bool contains(const map_location& loc) const {
+		return std::binary_search(dsts_.begin(), dsts_.end(), loc);
+	}
+};
 
+/**
+ * Computes the heuristic of a search, accounting for teleports.
+ * The part that only depends on the goals is computed once per search.
+ */
+template <typename Goals>
+class search_heuristic {
+	const Goals& goals_;
+	const std::vector<map_location>* sources_;
+	double dst_teleport_h_;
 
-			double new_dsth = 1.0;
-			std::set<map_location> targets;
-			teleports->get_targets(targets);
+public:
+	search_heuristic(const Goals& goals, const teleport_map* teleports)
+		: goals_(goals)
+		, sources_(NULL)
+		, dst_teleport_h_(1.0)
+	{
+		if (teleports && !teleports->empty()) {
+			sources_ = &teleports->sources();
+			BOOST_FOREACH(const map_location& target, teleports->targets()) {
+				const double tmp_dsth = goals_.distance(target);
+				if (tmp_dsth < dst_teleport_h_) { dst_teleport_h_ = tmp_dsth; }
+			}
+		}
+	}
 
-			for(it = targets.begin(); it != targets.end(); ++it) {
-				const double tmp_dsth = heuristic(*it, dst);
-				if (tmp_dsth < new_dsth) { new_dsth = tmp_dsth; }
+	double operator()(const map_location& c) const
+	{
+		double h = goals_.distance(c);
+		if (sources_) {
+			double new_srch = 1.0;
+			BOOST_FOREACH(const map_location& source, *sources_) {
+				const double tmp_srch = heuristic(c, source);
+				if (tmp_srch < new_srch) { new_srch = tmp_srch; }
 			}
 
-			double new_h = new_srch + new_dsth + 1.0;
+			const double new_h = new_srch + dst_teleport_h_ + 1.0;
 			if (new_h < h) {
 				h = new_h;
-				t = g + h;
 			}
 		}
-	}
-
-	bool operator<(const node& o) const {
-		return t < o.t;
+		return h;
 	}
 };
 
@@ -140,44 +194,151 @@ public:
 };
 }//anonymous namespace
 
+/** Counts the searches for get_search_statistics(). */
+boost::detail::atomic_count astar_searches(0);
 
-plain_route a_star_search(const map_location& src, const map_location& dst,
-                          double stop_at, const cost_calculator *calc,
-                          const size_t width, const size_t height,
-                          const teleport_map *teleports) {
-	//----------------- PRE_CONDITIONS ------------------
-	assert(src.valid(width, height));
-	assert(dst.valid(width, height));
-	assert(calc != NULL);
-	assert(stop_at <= calc->getNoPathValue());
-	//---------------------------------------------------
+struct search_workspace::implementation
+{
+	implementation()
+		: nodes()
+		, pq()
+		, search_counter(bad_search_counter)
+	{
+	}
 
-	DBG_PF << "A* search: " << src << " -> " << dst << '\n';
+	std::vector<node> nodes;
+	/** The open list, kept between searches to reuse its buffer. */
+	std::vector<int> pq;
+	/** The number of searches already done with this workspace. */
+	unsigned search_counter;
+};
 
-	if (calc->cost(dst, 0) >= stop_at) {
-		LOG_PF << "aborted A* search because Start or Dest is invalid\n";
-		plain_route locRoute;
-		locRoute.move_cost = int(calc->getNoPathValue());
-		return locRoute;
+search_workspace::search_workspace()
+	: impl_(new implementation())
+{
+}
+
+search_workspace::~search_workspace()
+{
+}
+
+void search_workspace::clear()
+{
+	// Swap to really release the memory; the counter stays valid since
+	// fresh nodes are always considered outdated.
+	std::vector<node>().swap(impl_->nodes);
+	std::vector<int>().swap(impl_->pq);
+}
+
+namespace {
+
+/** The workspaces not currently borrowed by a search. */
+class workspace_pool
+{
+public:
+	workspace_pool()
+		: mutex_()
+		, free_()
+	{
 	}
 
+	~workspace_pool()
+	{
+		for(std::vector<search_workspace*>::iterator i = free_.begin(); i != free_.end(); ++i) {
+			delete *i;
+		}
+	}
+
+	search_workspace* acquire()
+	{
+		const threading::lock lock(mutex_);
+		if(free_.empty()) {
+			return new search_workspace();
+		}
+		search_workspace* res = free_.back();
+		free_.pop_back();
+		return res;
+	}
+
+	void release(search_workspace* workspace)
+	{
+		const threading::lock lock(mutex_);
+		free_.push_back(workspace);
+	}
+
+private:
+	threading::mutex mutex_;
+	std::vector<search_workspace*> free_;
+};
+
+workspace_pool& get_workspace_pool()
+{
+	static workspace_pool pool;
+	return pool;
+}
+
+}//anonymous namespace
+
+namespace {
+
+/**
+ * The goal of a search towards all the hexes it can reach. Without a
+ * heuristic, the search settles the hexes by increasing cost.
+ */
+class no_goal {
+public:
+	double distance(const map_location&) const {
+		return 0;
+	}
+	bool contains(const map_location&) const {
+		return false;
+	}
+};
+
+/**
+ * The search shared by all a_star_search() variants.
+ * Stops as soon as the cheapest goal is settled, and returns its index,
+ * or -1 if no goal is cheaper than @a stop_at.
+ */
+template <typename Goals>
+int expand(const map_location& src, const Goals& goals,
+           double stop_at, const cost_calculator *calc,
+           const size_t width, const size_t height,
+           const teleport_map *teleports, search_workspace& workspace)
+{
+	search_workspace::implementation& ws = workspace.impl();
+	++astar_searches;
+
 	// increment search_counter but skip the range equivalent to uninitialized
-	search_counter += 2;
-	if (search_counter - bad_search_counter <= 1u)
-		search_counter += 2;
+	ws.search_counter += 2;
+	if (ws.search_counter - bad_search_counter <= 1u)
+		ws.search_counter += 2;
+	const unsigned search_counter = ws.search_counter;
 
-	static std::vector<node> nodes;
+	std::vector<node>& nodes = ws.nodes;
 	nodes.resize(width * height);  // this create uninitialized nodes
 
 	indexer index(width);
 	comp node_comp(nodes);
+	const search_heuristic<Goals> heur(goals, teleports);
+	const bool use_teleports = teleports && !teleports->empty();
 
-	nodes[index(dst)].g = stop_at + 1;
-	nodes[index(src)] = node(0, src, map_location::null_location(), dst, true, teleports);
+	// The cheapest goal found so far.
+	double best_g = stop_at + 1;
+	int best = -1;
 
-	std::vector<int> pq;
+	nodes[index(src)] = node(0, src, map_location::null_location(), heur(src), true, search_counter);
+	if (goals.contains(src)) {
+		best_g = 0;
+		best = index(src);
+	}
+
+	std::vector<int>& pq = ws.pq;
+	pq.clear();
 	pq.push_back(index(src));
 
+	map_location adjacent[6];
+
 	while (!pq.empty()) {
 		node& n = nodes[pq.front()];
 
@@ -186,50 +347,64 @@ plain_route a_star_search(const map_location& src, const map_location& dst,
 		std::pop_heap(pq.begin(), pq.end(), node_comp);
 		pq.pop_back();
 
-		if (n.t >= nodes[index(dst)].g) break;
+		if (n.t >= best_g) break;
 
-		std::vector<map_location> locs(6);
+		get_adjacent_tiles(n.curr, adjacent);
 
-		if (teleports && !teleports->empty()) {
-
-			std::set<map_location> allowed_teleports;
-			teleports->get_adjacents(allowed_teleports, n.curr);
-			locs.insert(locs.end(), allowed_teleports.begin(), allowed_teleports.end());
+		// The neighbors are the six adjacent hexes followed by the teleport
+		// exits, processed in reverse order.
+		teleport_map::location_range teleport_exits(NULL, NULL);
+		if (use_teleports) {
+			teleport_exits = teleports->adjacents(n.curr);
 		}
 
-		int i = locs.size();
-
-		get_adjacent_tiles(n.curr, &locs[0]);
+		int i = 6 + static_cast<int>(teleport_exits.second - teleport_exits.first);
 
 		for (; i-- > 0;) {
-			if (!locs[i].valid(width, height)) continue;
-			if (locs[i] == n.curr) continue;
-			node& next = nodes[index(locs[i])];
+			const map_location& loc = i < 6 ? adjacent[i] : teleport_exits.first[i - 6];
+			if (!loc.valid(width, height)) continue;
+			if (loc == n.curr) continue;
+			node& next = nodes[index(loc)];
 
 			double thresh = (next.in - search_counter <= 1u) ? next.g : stop_at + 1;
 			// cost() is always >= 1  (assumed and needed by the heuristic)
 			if (n.g + 1 >= thresh) continue;
-			double cost = n.g + calc->cost(locs[i], n.g);
+			double cost = n.g + calc->cost(loc, n.g);
 			if (cost >= thresh) continue;
 
 			bool in_list = next.in == search_counter + 1;
 
-			next = node(cost, locs[i], n.curr, dst, true, teleports);
+			next = node(cost, loc, n.curr, heur(loc), true, search_counter);
+
+			if (cost < best_g && goals.contains(loc)) {
+				best_g = cost;
+				best = index(loc);
+			}
 
 			if (in_list) {
-				std::push_heap(pq.begin(), std::find(pq.begin(), pq.end(), static_cast<int>(index(locs[i]))) + 1, node_comp);
+				std::push_heap(pq.begin(), std::find(pq.begin(), pq.end(), static_cast<int>(index(loc))) + 1, node_comp);
 			} else {
-				pq.push_back(index(locs[i]));
+				pq.push_back(index(loc));
 				std::push_heap(pq.begin(), pq.end(), node_comp);
 			}
 		}
 	}
 
+	return best_g <= stop_at ? best : -1;
+}
+
+/** The route to the node of index @a dst found by the last expand(). */
+plain_route make_route(const map_location& src, int dst, const cost_calculator *calc,
+                       const size_t width, search_workspace& workspace)
+{
+	const std::vector<node>& nodes = workspace.impl().nodes;
+	indexer index(width);
+
 	plain_route route;
-	if (nodes[index(dst)].g <= stop_at) {
+	if (dst >= 0) {
 		DBG_PF << "found solution; calculating it...\n";
-		route.move_cost = static_cast<int>(nodes[index(dst)].g);
-		for (node curr = nodes[index(dst)]; curr.prev != map_location::null_location(); curr = nodes[index(curr.prev)]) {
+		route.move_cost = static_cast<int>(nodes[dst].g);
+		for (node curr = nodes[dst]; curr.prev != map_location::null_location(); curr = nodes[index(curr.prev)]) {
 			route.steps.push_back(curr.curr);
 		}
 		route.steps.push_back(src);
@@ -242,5 +417,143 @@ plain_route a_star_search(const map_location& src, const map_location& dst,
 	return route;
 }
 
+template <typename Goals>
+plain_route search(const map_location& src, const Goals& goals,
+                   double stop_at, const cost_calculator *calc,
+                   const size_t width, const size_t height,
+                   const teleport_map *teleports, search_workspace& workspace)
+{
+	const int best = expand(src, goals, stop_at, calc, width, height, teleports, workspace);
+	return make_route(src, best, calc, width, workspace);
+}
+
+}//anonymous namespace
+
+pooled_search_workspace::pooled_search_workspace()
+	: workspace_(get_workspace_pool().acquire())
+{
+}
+
+pooled_search_workspace::~pooled_search_workspace()
+{
+	get_workspace_pool().release(workspace_);
+}
+
+
+plain_route a_star_search(const map_location& src, const map_location& dst,
+                          double stop_at, const cost_calculator *calc,
+                          const size_t width, const size_t height,
+                          const teleport_map *teleports) {
+	pooled_search_workspace workspace;
+	return a_star_search(src, dst, stop_at, calc, width, height, teleports, workspace.get());
+}
+
+plain_route a_star_search(const map_location& src, const map_location& dst,
+                          double stop_at, const cost_calculator *calc,
+                          const size_t width, const size_t height,
+                          const teleport_map *teleports, search_workspace& workspace) {
+	//----------------- PRE_CONDITIONS ------------------
+	assert(src.valid(width, height));
+	assert(dst.valid(width, height));
+	assert(calc != NULL);
+	assert(stop_at <= calc->getNoPathValue());
+	//---------------------------------------------------
+
+	DBG_PF << "A* search: " << src << " -> " << dst << '\n';
+
+	if (calc->cost(dst, 0) >= stop_at) {
+		LOG_PF << "aborted A* search because Start or Dest is invalid\n";
+		plain_route locRoute;
+		locRoute.move_cost = int(calc->getNoPathValue());
+		return locRoute;
+	}
+
+	return search(src, single_goal(dst), stop_at, calc, width, height, teleports, workspace);
+}
+
+plain_route a_star_search(const map_location& src, const std::set<map_location>& dsts,
+                          double stop_at, const cost_calculator *calc,
+                          const size_t width, const size_t height,
+                          const teleport_map *teleports) {
+	pooled_search_workspace workspace;
+	return a_star_search(src, dsts, stop_at, calc, width, height, teleports, workspace.get());
+}
+
+plain_route a_star_search(const map_location& src, const std::set<map_location>& dsts,
+                          double stop_at, const cost_calculator *calc,
+                          const size_t width, const size_t height,
+                          const teleport_map *teleports, search_workspace& workspace) {
+	//----------------- PRE_CONDITIONS ------------------
+	assert(src.valid(width, height));
+	assert(calc != NULL);
+	assert(stop_at <= calc->getNoPathValue());
+	//---------------------------------------------------
+
+	DBG_PF << "A* search: " << src << " -> " << dsts.size() << " destinations\n";
+
+	// Destinations that cannot be entered at all are not worth searching for.
+	// (The set is sorted, so the vector is as well.)
+	std::vector<map_location> goals;
+	goals.reserve(dsts.size());
+	BOOST_FOREACH(const map_location& dst, dsts) {
+		assert(dst.valid(width, height));
+		if (calc->cost(dst, 0) < stop_at) {
+			goals.push_back(dst);
+		}
+	}
+
+	if (goals.empty()) {
+		LOG_PF << "aborted A* search because no destination is valid\n";
+		plain_route locRoute;
+		locRoute.move_cost = int(calc->getNoPathValue());
+		return locRoute;
+	}
+
+	return search(src, multi_goal(goals), stop_at, calc, width, height, teleports, workspace);
+}
+
+std::vector<plain_route> route_search_all(const map_location& src, const std::vector<map_location>& dsts,
+                                          double stop_at, const cost_calculator *calc,
+                                          const size_t width, const size_t height,
+                                          const teleport_map *teleports) {
+	pooled_search_workspace workspace;
+	return route_search_all(src, dsts, stop_at, calc, width, height, teleports, workspace.get());
+}
+
+std::vector<plain_route> route_search_all(const map_location& src, const std::vector<map_location>& dsts,
+                                          double stop_at, const cost_calculator *calc,
+                                          const size_t width, const size_t height,
+                                          const teleport_map *teleports, search_workspace& workspace) {
+	//----------------- PRE_CONDITIONS ------------------
+	assert(src.valid(width, height));
+	assert(calc != NULL);
+	assert(stop_at <= calc->getNoPathValue());
+	//---------------------------------------------------
+
+	DBG_PF << "route search: " << src << " -> " << dsts.size() << " destinations\n";
+
+	std::vector<plain_route> routes;
+	routes.reserve(dsts.size());
+	if (dsts.empty()) {
+		return routes;
+	}
+
+	expand(src, no_goal(), stop_at, calc, width, height, teleports, workspace);
+
+	// Every node cheaper than stop_at got settled, in this search.
+	const search_workspace::implementation& ws = workspace.impl();
+	indexer index(width);
+	BOOST_FOREACH(const map_location& dst, dsts) {
+		assert(dst.valid(width, height));
+		const node& n = ws.nodes[index(dst)];
+		const bool reached = n.in - ws.search_counter <= 1u && n.g <= stop_at
+			// Same as a_star_search(), which does not enter such hexes.
+			&& calc->cost(dst, 0) < stop_at;
+		routes.push_back(make_route(src, reached ? static_cast<int>(index(dst)) : -1,
+		                            calc, width, workspace));
+	}
+	return routes;
+}
+
 
 }//namespace pathfind
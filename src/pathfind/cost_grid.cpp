@@ -0,0 +1,166 @@
+/*
+   Copyright (C) 2015 by the Battle for Wesnoth Project
+   Part of the Battle for Wesnoth Project http://www.wesnoth.org/
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY.
+
+   See the COPYING file for more details.
+*/
+
+/**
+ * @file
+ * Flattened per-hex terrain costs, shared between pathfinding calls.
+ */
+
+#include "global.hpp"
+
+#include "pathfind/cost_grid.hpp"
+
+#include "map.hpp"
+#include "thread.hpp"
+
+#include <map>
+
+namespace pathfind {
+
+/**
+ * Keeps the grids built for the map used last.
+ *
+ * The terrains of the map are numbered once per map revision; the costs of
+ * a movetype on those few terrains then identify its grid, so building the
+ * key for a lookup does not depend on the size of the map.
+ */
+class cost_grid_cache
+{
+public:
+	cost_grid_cache()
+		: map_(NULL), revision_(0), w_(0), h_(0)
+		, terrains_(), hex_terrains_(), grids_(), mutex_()
+	{}
+
+	cost_grid::ptr get(const gamemap& map, const movetype::terrain_costs& costs, bool slowed);
+	void clear();
+
+private:
+	void reset();
+	void index_terrains(const gamemap& map);
+
+	/** The costs of terrains_, identifying a grid. */
+	typedef std::vector<boost::uint8_t> signature;
+	typedef std::map<signature, cost_grid::ptr> grid_map;
+
+	/** Grids beyond this number are not worth keeping around. */
+	static const size_t max_grids = 64;
+
+	/** The map (and its state) that the members below describe. */
+	const gamemap* map_;
+	unsigned revision_;
+	int w_, h_;
+
+	/** The distinct terrains of the map. */
+	std::vector<t_translation::t_terrain> terrains_;
+	/** For each hex, the index of its terrain in terrains_. */
+	std::vector<unsigned> hex_terrains_;
+	grid_map grids_;
+
+	threading::mutex mutex_;
+};
+
+void cost_grid_cache::clear()
+{
+	const threading::lock lock(mutex_);
+	reset();
+}
+
+void cost_grid_cache::reset()
+{
+	map_ = NULL;
+	terrains_.clear();
+	hex_terrains_.clear();
+	grids_.clear();
+}
+
+void cost_grid_cache::index_terrains(const gamemap& map)
+{
+	reset();
+	map_ = &map;
+	revision_ = map.revision();
+	w_ = map.w();
+	h_ = map.h();
+
+	std::map<t_translation::t_terrain, unsigned> numbers;
+	hex_terrains_.reserve(w_ * h_);
+	for (int y = 0; y < h_; ++y) {
+		for (int x = 0; x < w_; ++x) {
+			const t_translation::t_terrain terrain = map[map_location(x, y)];
+			const std::pair<std::map<t_translation::t_terrain, unsigned>::iterator, bool>
+				entry = numbers.insert(std::make_pair(terrain, terrains_.size()));
+			if (entry.second) {
+				terrains_.push_back(terrain);
+			}
+			hex_terrains_.push_back(entry.first->second);
+		}
+	}
+}
+
+cost_grid::ptr cost_grid_cache::get(const gamemap& map,
+		const movetype::terrain_costs& costs, bool slowed)
+{
+	const threading::lock lock(mutex_);
+
+	if (map_ != &map || revision_ != map.revision() || w_ != map.w() || h_ != map.h()) {
+		index_terrains(map);
+	}
+
+	signature key;
+	key.reserve(terrains_.size());
+	for (size_t i = 0; i != terrains_.size(); ++i) {
+		const int cost = costs.cost(terrains_[i], slowed);
+		if (cost < 0 || cost > 255) {
+			return cost_grid::ptr();
+		}
+		key.push_back(static_cast<boost::uint8_t>(cost));
+	}
+
+	grid_map::iterator it = grids_.find(key);
+	if (it != grids_.end()) {
+		return it->second;
+	}
+
+	if (grids_.size() >= max_grids) {
+		grids_.clear();
+	}
+	cost_grid* grid = new cost_grid(w_, h_);
+	for (size_t i = 0; i != hex_terrains_.size(); ++i) {
+		grid->costs_[i] = key[hex_terrains_[i]];
+	}
+	cost_grid::ptr result(grid);
+	grids_.insert(std::make_pair(key, result));
+	return result;
+}
+
+namespace {
+	cost_grid_cache& get_cache()
+	{
+		static cost_grid_cache cache;
+		return cache;
+	}
+}
+
+cost_grid::ptr cost_grid::get(const gamemap& map,
+		const movetype::terrain_costs& costs, bool slowed)
+{
+	return get_cache().get(map, costs, slowed);
+}
+
+void cost_grid::clear_cache()
+{
+	get_cache().clear();
+}
+
+}
@@ -0,0 +1,84 @@
+/*
+   Copyright (C) 2015 by the Battle for Wesnoth Project
+   Part of the Battle for Wesnoth Project http://www.wesnoth.org/
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY.
+
+   See the COPYING file for more details.
+*/
+
+/**
+ * @file
+ * Flattened per-hex terrain costs, shared between pathfinding calls.
+ */
+
+#ifndef PATHFIND_COST_GRID_H_INCLUDED
+#define PATHFIND_COST_GRID_H_INCLUDED
+
+#include "map_location.hpp"
+#include "movetype.hpp"
+
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <vector>
+
+class gamemap;
+
+namespace pathfind {
+
+/**
+ * The cost of entering every hex of a map, for one set of terrain costs,
+ * stored as one byte per hex, so that looking a cost up is a single load
+ * instead of a terrain lookup plus a walk through the movetype caches.
+ *
+ * Grids are obtained through get(), which keeps them for as long as the
+ * terrain of the map does not change (see gamemap::revision()). Movetypes
+ * that agree on the costs of all terrains present on the map share a grid.
+ * Grids are immutable, so they can be read from any thread; get() itself
+ * evaluates the terrain costs and must be called from the main thread.
+ */
+class cost_grid : private boost::noncopyable
+{
+public:
+	typedef boost::shared_ptr<const cost_grid> ptr;
+
+	/**
+	 * Returns the grid of @a costs on @a map.
+	 * Returns an empty pointer if some cost does not fit in a byte, in
+	 * which case the caller should fall back to terrain_costs::cost().
+	 */
+	static ptr get(const gamemap& map, const movetype::terrain_costs& costs,
+	               bool slowed=false);
+
+	/** Drops all cached grids. */
+	static void clear_cache();
+
+	/** The width and height of the map the grid was built for. */
+	int w() const { return w_; }
+	int h() const { return h_; }
+
+	/** The cost of entering @a loc, which must be on the map. */
+	int cost(const map_location& loc) const
+		{ return costs_[loc.x + loc.y * w_]; }
+	/** The cost of entering the hex with index x + y*w(). */
+	int operator[](int index) const { return costs_[index]; }
+
+private:
+	cost_grid(int w, int h) : w_(w), h_(h), costs_(w * h) {}
+
+	const int w_, h_;
+	std::vector<boost::uint8_t> costs_;
+
+	friend class cost_grid_cache;
+};
+
+}
+
+#endif
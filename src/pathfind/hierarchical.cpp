@@ -0,0 +1,424 @@
+/*
+   Copyright (C) 2015 by the Battle for Wesnoth Project
+   Part of the Battle for Wesnoth Project http://www.wesnoth.org/
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY.
+
+   See the COPYING file for more details.
+*/
+
+/**
+ * @file
+ * Hierarchical (HPA*) route finding for large maps.
+ */
+
+#include "global.hpp"
+
+#include "pathfind/hierarchical.hpp"
+
+#include "log.hpp"
+#include "pathfind/teleport.hpp"
+#include "thread.hpp"
+
+#include <boost/foreach.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/weak_ptr.hpp>
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <map>
+#include <queue>
+
+static lg::log_domain log_engine("engine");
+#define DBG_PF LOG_STREAM(debug, log_engine)
+
+namespace pathfind {
+
+namespace {
+
+/** Width and height (in hexes) of a cluster. */
+const int cluster_size = 16;
+/** Minimum distance between two entrances on the same cluster border. */
+const int entrance_spacing = 4;
+
+const int no_cost = std::numeric_limits<int>::max();
+
+/** (cost, index) pairs, popped cheapest first. */
+typedef std::pair<int, int> queue_entry;
+typedef std::priority_queue<queue_entry, std::vector<queue_entry>,
+                            std::greater<queue_entry> > min_queue;
+
+/**
+ * The abstract graph of one cost grid: a few entrance hexes on each cluster
+ * border, connected by the cheapest terrain costs between them.
+ */
+class abstract_graph : private boost::noncopyable
+{
+public:
+	explicit abstract_graph(const cost_grid& grid);
+
+	int cluster_of(const map_location& loc) const
+		{ return loc.x / cluster_size + (loc.y / cluster_size) * clusters_w_; }
+	size_t nb_clusters() const { return cluster_nodes_.size(); }
+
+	/**
+	 * Marks in @a corridor the clusters crossed by the cheapest abstract
+	 * route from @a src to @a dst. Returns false if there is no such route.
+	 */
+	bool find_corridor(const cost_grid& grid, const map_location& src,
+	                   const map_location& dst, std::vector<bool>& corridor) const;
+
+	/** Adds the clusters around those already in @a corridor. */
+	void widen(std::vector<bool>& corridor) const;
+
+private:
+	struct edge {
+		edge(int t, int c) : to(t), cost(c) {}
+		int to, cost;
+	};
+	struct node {
+		explicit node(const map_location& l) : loc(l), edges() {}
+		map_location loc;
+		std::vector<edge> edges;
+	};
+
+	static bool passable(const cost_grid& grid, const map_location& loc)
+		{ return grid.cost(loc) < movetype::UNREACHABLE; }
+
+	int node_at(const map_location& loc, std::map<map_location, int>& node_of);
+	void cluster_costs(const cost_grid& grid, const map_location& start,
+	                   bool reverse, std::vector<int>& costs) const;
+	int local_index(int cluster, const map_location& loc) const;
+
+	int w_, h_;
+	int clusters_w_, clusters_h_;
+	std::vector<node> nodes_;
+	/** The nodes of each cluster. */
+	std::vector<std::vector<int> > cluster_nodes_;
+};
+
+abstract_graph::abstract_graph(const cost_grid& grid)
+	: w_(grid.w()), h_(grid.h())
+	, clusters_w_((w_ + cluster_size - 1) / cluster_size)
+	, clusters_h_((h_ + cluster_size - 1) / cluster_size)
+	, nodes_()
+	, cluster_nodes_(clusters_w_ * clusters_h_)
+{
+	// Pick the entrances: pairs of passable hexes on both sides of a
+	// cluster border, not too close to the entrances already picked for
+	// the same pair of clusters.
+	typedef std::map<std::pair<int, int>, std::vector<map_location> > entrance_map;
+	entrance_map entrances;
+	std::map<map_location, int> node_of;
+
+	for (int y = 0; y < h_; ++y) {
+		for (int x = 0; x < w_; ++x) {
+			const map_location loc(x, y);
+			if (!passable(grid, loc)) {
+				continue;
+			}
+			map_location adj[6];
+			get_adjacent_tiles(loc, adj);
+			for (int i = 0; i != 6; ++i) {
+				const map_location& next = adj[i];
+				if (next.x < 0 || next.x >= w_ || next.y < 0 || next.y >= h_ ||
+						!(loc < next) || !passable(grid, next)) {
+					continue;
+				}
+				const int from = cluster_of(loc), to = cluster_of(next);
+				if (from == to) {
+					continue;
+				}
+
+				std::vector<map_location>& picked = entrances[std::make_pair(from, to)];
+				bool too_close = false;
+				for (size_t j = 0; j != picked.size() && !too_close; ++j) {
+					too_close = static_cast<int>(distance_between(picked[j], loc)) < entrance_spacing;
+				}
+				if (too_close) {
+					continue;
+				}
+				picked.push_back(loc);
+
+				const int a = node_at(loc, node_of), b = node_at(next, node_of);
+				nodes_[a].edges.push_back(edge(b, grid.cost(next)));
+				nodes_[b].edges.push_back(edge(a, grid.cost(loc)));
+			}
+		}
+	}
+
+	// Connect the entrances of each cluster.
+	std::vector<int> costs;
+	for (size_t c = 0; c != cluster_nodes_.size(); ++c) {
+		const std::vector<int>& members = cluster_nodes_[c];
+		for (size_t i = 0; i != members.size(); ++i) {
+			node& from = nodes_[members[i]];
+			cluster_costs(grid, from.loc, false, costs);
+			for (size_t j = 0; j != members.size(); ++j) {
+				const int cost = costs[local_index(c, nodes_[members[j]].loc)];
+				if (i != j && cost != no_cost) {
+					from.edges.push_back(edge(members[j], cost));
+				}
+			}
+		}
+	}
+
+	DBG_PF << "abstract graph of " << w_ << "x" << h_ << " map: "
+	       << nodes_.size() << " nodes in " << cluster_nodes_.size() << " clusters\n";
+}
+
+int abstract_graph::node_at(const map_location& loc, std::map<map_location, int>& node_of)
+{
+	const std::pair<std::map<map_location, int>::iterator, bool> it =
+		node_of.insert(std::make_pair(loc, static_cast<int>(nodes_.size())));
+	if (it.second) {
+		nodes_.push_back(node(loc));
+		cluster_nodes_[cluster_of(loc)].push_back(it.first->second);
+	}
+	return it.first->second;
+}
+
+int abstract_graph::local_index(int cluster, const map_location& loc) const
+{
+	const int x0 = (cluster % clusters_w_) * cluster_size;
+	const int y0 = (cluster / clusters_w_) * cluster_size;
+	return (loc.x - x0) + (loc.y - y0) * cluster_size;
+}
+
+/**
+ * Dijkstra's algorithm restricted to the cluster of @a start.
+ * Fills @a costs (indexed by local_index()) with the cost of going from
+ * @a start to each hex, or, if @a reverse, from each hex to @a start.
+ */
+void abstract_graph::cluster_costs(const cost_grid& grid, const map_location& start,
+		bool reverse, std::vector<int>& costs) const
+{
+	const int cluster = cluster_of(start);
+	costs.assign(cluster_size * cluster_size, no_cost);
+	costs[local_index(cluster, start)] = 0;
+
+	min_queue queue;
+	queue.push(queue_entry(0, start.x + start.y * w_));
+	while (!queue.empty()) {
+		const queue_entry current = queue.top();
+		queue.pop();
+		const map_location loc(current.second % w_, current.second / w_);
+		if (current.first != costs[local_index(cluster, loc)]) {
+			continue;
+		}
+		if (reverse && !passable(grid, loc)) {
+			continue;
+		}
+
+		map_location adj[6];
+		get_adjacent_tiles(loc, adj);
+		for (int i = 0; i != 6; ++i) {
+			const map_location& next = adj[i];
+			if (next.x < 0 || next.x >= w_ || next.y < 0 || next.y >= h_ ||
+					cluster_of(next) != cluster || !passable(grid, next)) {
+				continue;
+			}
+			const int cost = current.first + grid.cost(reverse ? loc : next);
+			int& best = costs[local_index(cluster, next)];
+			if (cost < best) {
+				best = cost;
+				queue.push(queue_entry(cost, next.x + next.y * w_));
+			}
+		}
+	}
+}
+
+bool abstract_graph::find_corridor(const cost_grid& grid, const map_location& src,
+		const map_location& dst, std::vector<bool>& corridor) const
+{
+	const int src_cluster = cluster_of(src), dst_cluster = cluster_of(dst);
+	// The destination is an extra node, reached from the nodes of its cluster.
+	const int dst_node = nodes_.size();
+	std::vector<int> best(nodes_.size() + 1, no_cost);
+	std::vector<int> prev(nodes_.size() + 1, -1);
+	min_queue queue;
+
+	std::vector<int> to_dst;
+	cluster_costs(grid, dst, true, to_dst);
+
+	std::vector<int> costs;
+	cluster_costs(grid, src, false, costs);
+	BOOST_FOREACH(int n, cluster_nodes_[src_cluster]) {
+		const int cost = costs[local_index(src_cluster, nodes_[n].loc)];
+		if (cost != no_cost) {
+			best[n] = cost;
+			queue.push(queue_entry(cost + distance_between(nodes_[n].loc, dst), n));
+		}
+	}
+	if (src_cluster == dst_cluster && costs[local_index(src_cluster, dst)] != no_cost) {
+		best[dst_node] = costs[local_index(src_cluster, dst)];
+		queue.push(queue_entry(best[dst_node], dst_node));
+	}
+
+	while (!queue.empty()) {
+		const int n = queue.top().second;
+		const int estimate = queue.top().first;
+		queue.pop();
+		if (n == dst_node) {
+			break;
+		}
+		if (estimate != best[n] + static_cast<int>(distance_between(nodes_[n].loc, dst))) {
+			continue;
+		}
+
+		const node& current = nodes_[n];
+		BOOST_FOREACH(const edge& e, current.edges) {
+			const int cost = best[n] + e.cost;
+			if (cost < best[e.to]) {
+				best[e.to] = cost;
+				prev[e.to] = n;
+				queue.push(queue_entry(cost + distance_between(nodes_[e.to].loc, dst), e.to));
+			}
+		}
+		if (cluster_of(current.loc) == dst_cluster) {
+			const int remaining = to_dst[local_index(dst_cluster, current.loc)];
+			if (remaining != no_cost && best[n] + remaining < best[dst_node]) {
+				best[dst_node] = best[n] + remaining;
+				prev[dst_node] = n;
+				queue.push(queue_entry(best[dst_node], dst_node));
+			}
+		}
+	}
+
+	if (best[dst_node] == no_cost) {
+		return false;
+	}
+
+	corridor.assign(nb_clusters(), false);
+	corridor[src_cluster] = true;
+	corridor[dst_cluster] = true;
+	for (int n = prev[dst_node]; n >= 0; n = prev[n]) {
+		corridor[cluster_of(nodes_[n].loc)] = true;
+	}
+	return true;
+}
+
+void abstract_graph::widen(std::vector<bool>& corridor) const
+{
+	const std::vector<bool> narrow = corridor;
+	for (int cy = 0; cy < clusters_h_; ++cy) {
+		for (int cx = 0; cx < clusters_w_; ++cx) {
+			if (!narrow[cx + cy * clusters_w_]) {
+				continue;
+			}
+			for (int y = std::max(cy - 1, 0); y <= std::min(cy + 1, clusters_h_ - 1); ++y) {
+				for (int x = std::max(cx - 1, 0); x <= std::min(cx + 1, clusters_w_ - 1); ++x) {
+					corridor[x + y * clusters_w_] = true;
+				}
+			}
+		}
+	}
+}
+
+/**
+ * The caller's cost calculator, with everything outside a corridor of
+ * clusters made impassable.
+ */
+class corridor_calculator : public cost_calculator
+{
+public:
+	corridor_calculator(const cost_calculator& calc, const abstract_graph& graph,
+	                    const std::vector<bool>& corridor)
+		: calc_(calc), graph_(graph), corridor_(corridor)
+	{}
+
+	virtual double cost(const map_location& loc, const double so_far) const
+	{
+		if (!corridor_[graph_.cluster_of(loc)]) {
+			return getNoPathValue();
+		}
+		return calc_.cost(loc, so_far);
+	}
+
+private:
+	const cost_calculator& calc_;
+	const abstract_graph& graph_;
+	const std::vector<bool>& corridor_;
+};
+
+/**
+ * The abstract graphs built so far. A graph is dropped once its cost grid
+ * is gone, which happens when the terrain of the map changes.
+ */
+struct graph_cache
+{
+	struct entry {
+		entry() : grid(), graph() {}
+		boost::weak_ptr<const cost_grid> grid;
+		boost::shared_ptr<const abstract_graph> graph;
+	};
+	typedef std::map<const cost_grid*, entry> entry_map;
+
+	graph_cache() : entries(), mutex() {}
+
+	entry_map entries;
+	threading::mutex mutex;
+};
+
+boost::shared_ptr<const abstract_graph> get_graph(const cost_grid::ptr& grid)
+{
+	static graph_cache cache;
+	const threading::lock lock(cache.mutex);
+
+	for (graph_cache::entry_map::iterator i = cache.entries.begin(); i != cache.entries.end(); ) {
+		if (i->second.grid.expired()) {
+			cache.entries.erase(i++);
+		} else {
+			++i;
+		}
+	}
+
+	graph_cache::entry& e = cache.entries[grid.get()];
+	if (!e.graph) {
+		e.grid = grid;
+		e.graph.reset(new abstract_graph(*grid));
+	}
+	return e.graph;
+}
+
+}
+
+plain_route hierarchical_search(const map_location& src, const map_location& dst,
+		double stop_at, const cost_calculator* calc,
+		const size_t parWidth, const size_t parHeight,
+		const cost_grid::ptr& grid, const teleport_map* teleports)
+{
+	if (!grid || (teleports && !teleports->empty()) ||
+			static_cast<int>(distance_between(src, dst)) < 2 * cluster_size) {
+		return a_star_search(src, dst, stop_at, calc, parWidth, parHeight, teleports);
+	}
+	assert(grid->w() == static_cast<int>(parWidth) && grid->h() == static_cast<int>(parHeight));
+
+	const boost::shared_ptr<const abstract_graph> graph = get_graph(grid);
+	std::vector<bool> corridor;
+	if (graph->find_corridor(*grid, src, dst, corridor)) {
+		const corridor_calculator restricted(*calc, *graph, corridor);
+		plain_route route = a_star_search(src, dst, stop_at, &restricted, parWidth, parHeight);
+		if (!route.steps.empty()) {
+			return route;
+		}
+
+		DBG_PF << "widening the corridor from " << src << " to " << dst << "\n";
+		graph->widen(corridor);
+		route = a_star_search(src, dst, stop_at, &restricted, parWidth, parHeight);
+		if (!route.steps.empty()) {
+			return route;
+		}
+	}
+
+	DBG_PF << "no corridor from " << src << " to " << dst << ", searching the whole map\n";
+	return a_star_search(src, dst, stop_at, calc, parWidth, parHeight);
+}
+
+}
@@ -0,0 +1,54 @@
+/*
+   Copyright (C) 2015 by the Battle for Wesnoth Project
+   Part of the Battle for Wesnoth Project http://www.wesnoth.org/
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY.
+
+   See the COPYING file for more details.
+*/
+
+/**
+ * @file
+ * Hierarchical (HPA*) route finding for large maps.
+ */
+
+#ifndef PATHFIND_HIERARCHICAL_H_INCLUDED
+#define PATHFIND_HIERARCHICAL_H_INCLUDED
+
+#include "pathfind/cost_grid.hpp"
+#include "pathfind/pathfind.hpp"
+
+namespace pathfind {
+
+/**
+ * Finds a route from @a src to @a dst like a_star_search(), but explores
+ * far fewer hexes on big maps, at the price of the route possibly not being
+ * the very cheapest one.
+ *
+ * The map is split into square clusters. For each cost grid (i.e. for each
+ * set of movement costs, see cost_grid) an abstract graph is built once per
+ * map revision: its nodes are a few passable hexes on the cluster borders,
+ * and its edges are the cheapest terrain-only costs between them. A route
+ * is found in that graph first; then a_star_search() is run with
+ * @a calc, restricted to the clusters crossed by the abstract route, so
+ * that the cost of the result means the same as usual. If that corridor
+ * turns out to be blocked (e.g. by units), it is widened once before
+ * falling back to searching the whole map.
+ *
+ * @a grid must hold the terrain costs that @a calc is based on. Searches
+ * without a grid, that may teleport, or that are short anyway, are handed
+ * straight to a_star_search().
+ */
+plain_route hierarchical_search(const map_location& src, const map_location& dst,
+		double stop_at, const cost_calculator* calc,
+		const size_t parWidth, const size_t parHeight,
+		const cost_grid::ptr& grid, const teleport_map* teleports = NULL);
+
+}
+
+#endif
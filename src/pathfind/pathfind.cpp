@@ -21,6 +21,7 @@
 #include "global.hpp"
 
 #include "pathfind/pathfind.hpp"
+#include "pathfind/cost_grid.hpp"
 #include "pathfind/teleport.hpp"
 
 #include "game_board.hpp"
@@ -30,10 +31,13 @@
 #include "map.hpp"
 #include "resources.hpp"
 #include "team.hpp"
+#include "thread.hpp"
 #include "unit.hpp"
 #include "unit_map.hpp"
 #include "wml_exception.hpp"
 
+#include <boost/cstdint.hpp>
+#include <boost/detail/atomic_count.hpp>
 #include <boost/foreach.hpp>
 
 #include <iostream>
@@ -45,6 +49,21 @@ static lg::log_domain log_engine("engine");
 
 namespace pathfind {
 
+namespace {
+	boost::detail::atomic_count route_searches(0);
+}
+
+/** Defined in astarsearch.cpp. */
+extern boost::detail::atomic_count astar_searches;
+
+search_statistics get_search_statistics()
+{
+	search_statistics res;
+	res.routes = route_searches;
+	res.astar = astar_searches;
+	return res;
+}
+
 
 /**
  * Function that will find a location on the board that is as near
@@ -123,6 +142,133 @@ map_location find_vacant_castle(const unit & leader)
 }
 
 
+namespace {
+	/** State of the adjacency_cache. */
+	struct adjacency_state {
+		adjacency_state() : units(NULL), w(0), h(0), counts(), enemy_adjacent() {}
+
+		int index(const map_location& loc) const {
+			return loc.x < 0 || w <= loc.x || loc.y < 0 || h <= loc.y ? -1 : loc.x + loc.y * w;
+		}
+
+		/** The unit map the counts were taken from; NULL when invalid. */
+		const unit_map * units;
+		int w, h;
+		/** counts[side-1][hex]: the number of units of side next to hex. */
+		std::vector<std::vector<boost::uint8_t> > counts;
+		/** enemy_adjacent[side-1][hex]: whether an enemy of side is next to hex.
+		 *  Empty until that side is asked about. */
+		std::vector<std::vector<bool> > enemy_adjacent;
+	};
+
+	adjacency_state adjacency;
+
+	/** Whether an enemy of side s (0-based) is next to hex, according to counts. */
+	bool compute_enemy_adjacent(const std::vector<team>& teams, size_t s, int hex)
+	{
+		for ( size_t t = 0; t != adjacency.counts.size(); ++t ) {
+			if ( adjacency.counts[t][hex] != 0  &&  teams[s].is_enemy(t+1) )
+				return true;
+		}
+		return false;
+	}
+
+	/** Updates the counts (and bitmaps) for a unit of side entering or leaving loc. */
+	void update_adjacency(const map_location& loc, int side, int delta)
+	{
+		if ( !resources::teams  ||  resources::teams->size() != adjacency.counts.size() ) {
+			adjacency_cache::invalidate_all();
+			return;
+		}
+		const std::vector<team>& teams = *resources::teams;
+		if ( side < 1 || side > static_cast<int>(teams.size()) )
+			return;
+
+		map_location adj[6];
+		get_adjacent_tiles(loc, adj);
+		for ( int i = 0; i != 6; ++i ) {
+			const int hex = adjacency.index(adj[i]);
+			if ( hex < 0 )
+				continue;
+			adjacency.counts[side-1][hex] += delta;
+			for ( size_t s = 0; s != adjacency.enemy_adjacent.size(); ++s ) {
+				std::vector<bool>& bits = adjacency.enemy_adjacent[s];
+				if ( !bits.empty()  &&  teams[s].is_enemy(side) )
+					bits[hex] = delta > 0 || compute_enemy_adjacent(teams, s, hex);
+			}
+		}
+	}
+
+	void rebuild_adjacency()
+	{
+		const gamemap& map = resources::gameboard->map();
+		adjacency.units = &resources::gameboard->units();
+		adjacency.w = map.w();
+		adjacency.h = map.h();
+		adjacency.counts.assign(resources::teams->size(),
+			std::vector<boost::uint8_t>(map.w() * map.h(), 0));
+		adjacency.enemy_adjacent.assign(resources::teams->size(), std::vector<bool>());
+
+		BOOST_FOREACH(const unit& u, *adjacency.units) {
+			update_adjacency(u.get_location(), u.side(), 1);
+		}
+	}
+}
+
+namespace adjacency_cache {
+
+bool enemy_adjacent(const team& current_team, const map_location& loc)
+{
+	if ( !resources::gameboard || !resources::teams )
+		return true;
+
+	const gamemap& map = resources::gameboard->map();
+	if ( adjacency.units != &resources::gameboard->units()  ||
+	     adjacency.w != map.w()  ||  adjacency.h != map.h()  ||
+	     adjacency.counts.size() != resources::teams->size() )
+		rebuild_adjacency();
+
+	const int side = current_team.side();
+	const int hex = adjacency.index(loc);
+	if ( side < 1  ||  side > static_cast<int>(adjacency.counts.size())  ||  hex < 0 )
+		return true;
+
+	std::vector<bool>& bits = adjacency.enemy_adjacent[side-1];
+	if ( bits.empty() ) {
+		bits.resize(adjacency.w * adjacency.h);
+		for ( int i = 0; i != adjacency.w * adjacency.h; ++i )
+			bits[i] = compute_enemy_adjacent(*resources::teams, side-1, i);
+	}
+	return bits[hex];
+}
+
+void unit_added(const unit_map& units, const map_location& loc, int side)
+{
+	if ( &units == adjacency.units )
+		update_adjacency(loc, side, 1);
+}
+
+void unit_removed(const unit_map& units, const map_location& loc, int side)
+{
+	if ( &units == adjacency.units )
+		update_adjacency(loc, side, -1);
+}
+
+void invalidate(const unit_map& units)
+{
+	if ( &units == adjacency.units )
+		invalidate_all();
+}
+
+void invalidate_all()
+{
+	adjacency.units = NULL;
+	adjacency.counts.clear();
+	adjacency.enemy_adjacent.clear();
+}
+
+}
+
 /**
  * Determines if a given location is in an enemy zone of control.
  *
@@ -136,6 +282,10 @@ map_location find_vacant_castle(const unit & leader)
 bool enemy_zoc(team const &current_team, map_location const &loc,
                team const &viewing_team, bool see_all)
 {
+	// Most hexes are not even next to an enemy.
+	if ( !adjacency_cache::enemy_adjacent(current_team, loc) )
+		return false;
+
 	// Check the adjacent tiles.
 	map_location locs[6];
 	get_adjacent_tiles(loc,locs);
@@ -210,6 +360,18 @@ namespace {
 		}
 	};
 
+	/**
+	 * Scratch memory for find_routes().
+	 * Each thread running find_routes() concurrently needs its own.
+	 */
+	struct findroute_workspace {
+		std::vector<findroute_node> nodes;
+		// Incrementing search_counter means we ignore results from earlier searches.
+		unsigned search_counter;
+
+		findroute_workspace() : nodes(), search_counter(0) { }
+	};
+
 	/**
 	 * A function object for comparing indices.
 	 */
@@ -261,6 +423,11 @@ namespace {
  *                           Destinations is ignored.
  *                           full_cost_map is a vector of pairs. The first entry is the
  *                           cost itself, the second how many units already visited this hex
+ * @param[in]  workspace     If not NULL, the node storage to use for this search.
+ *                           If NULL, a static one is used (only safe on the main thread).
+ * @param[in]  teleports     If not NULL, the (already built) teleport map of teleporter.
+ * @param[in]  grid          If not NULL, the flattened costs (same as costs and slowed)
+ *                           to use instead of looking each terrain up.
  */
 static void find_routes(
 		const map_location & origin, const movetype::terrain_costs & costs,
@@ -269,8 +436,12 @@ static void find_routes(
 		const unit * teleporter, const team * current_team,
 		const unit * skirmisher, const team * viewing_team,
 		const std::map<map_location, int> * jamming_map=NULL,
-		std::vector<std::pair<int, int> > * full_cost_map=NULL)
+		std::vector<std::pair<int, int> > * full_cost_map=NULL,
+		findroute_workspace * workspace=NULL,
+		const teleport_map * teleports=NULL,
+		const cost_grid * grid=NULL)
 {
+	++route_searches;
 	const gamemap& map = resources::gameboard->map();
 
 	const bool see_all =  viewing_team == NULL;
@@ -280,14 +451,18 @@ static void find_routes(
 		viewing_team = &resources::teams->front();
 
 	// Build a teleport map, if needed.
-	const teleport_map teleports = teleporter ?
+	const teleport_map built_teleports = teleporter && !teleports ?
 			get_teleport_locations(*teleporter, *viewing_team, see_all, current_team == NULL) :
 			teleport_map();
+	if ( !teleports )
+		teleports = &built_teleports;
 
 	// Since this is called so often, keep memory reserved for the node list.
-	static std::vector<findroute_node> nodes;
-	static unsigned search_counter = 0;
-	// Incrementing search_counter means we ignore results from earlier searches.
+	static findroute_workspace default_workspace;
+	if ( !workspace )
+		workspace = &default_workspace;
+	std::vector<findroute_node> & nodes = workspace->nodes;
+	unsigned & search_counter = workspace->search_counter;
 	++search_counter;
 	// Whenever the counter cycles, trash the contents of nodes and restart at 1.
 	if ( search_counter == 0 ) {
@@ -295,6 +470,7 @@ static void find_routes(
 		search_counter = 1;
 	}
 	// Initialize the nodes for this search.
+	assert(!grid || (grid->w() == map.w() && grid->h() == map.h()));
 	nodes.resize(map.w() * map.h());
 	findroute_comp node_comp(nodes);
 	findroute_indexer index(map.w(), map.h());
@@ -332,17 +508,18 @@ static void find_routes(
 		std::pop_heap(hexes_to_process.begin(), hexes_to_process.end(), node_comp);
 		hexes_to_process.pop_back();
 
-		// Get the locations adjacent to current.
-		std::vector<map_location> adj_locs(6);
-		get_adjacent_tiles(cur_hex, &adj_locs[0]);
+		// Get the locations adjacent to current, followed by the teleport
+		// exits (without allocating).
+		map_location adj_locs[6];
+		get_adjacent_tiles(cur_hex, adj_locs);
+		teleport_map::location_range teleport_exits(NULL, NULL);
 		if ( teleporter ) {
-			std::set<map_location> allowed_teleports;
-			teleports.get_adjacents(allowed_teleports, cur_hex);
-			adj_locs.insert(adj_locs.end(), allowed_teleports.begin(), allowed_teleports.end());
+			teleport_exits = teleports->adjacents(cur_hex);
 		}
-		for ( int i = adj_locs.size()-1; i >= 0; --i ) {
+		const int nb_adjacent = 6 + static_cast<int>(teleport_exits.second - teleport_exits.first);
+		for ( int i = nb_adjacent-1; i >= 0; --i ) {
 			// Get the node associated with this location.
-			const map_location & next_hex = adj_locs[i];
+			const map_location & next_hex = i < 6 ? adj_locs[i] : teleport_exits.first[i-6];
 			const int next_index = index(next_hex);
 			if ( next_index < 0 ) {
 				// Off the map.
@@ -364,7 +541,7 @@ static void find_routes(
 			next.prev = cur_hex;
 
 			// Calculate the cost of entering next_hex.
-			int cost = costs.cost(map[next_hex], slowed);
+			int cost = grid ? (*grid)[next_index] : costs.cost(map[next_hex], slowed);
 			if ( jamming_map ) {
 				const std::map<map_location, int>::const_iterator jam_it =
 					jamming_map->find(next_hex);
@@ -510,11 +687,85 @@ bool paths::dest_vect::contains(const map_location &loc) const
 	return find(loc) != end();
 }
 
+namespace {
+	/** Everything besides the board state that affects the reach of a unit. */
+	struct reach_key {
+		size_t unit_id;
+		map_location loc;
+		int moves_left, total_movement, additional_turns, viewing_side;
+		bool slowed, force_ignore_zoc, see_all, ignore_units;
+
+		bool operator<(const reach_key& o) const {
+			if ( unit_id != o.unit_id ) return unit_id < o.unit_id;
+			if ( loc != o.loc ) return loc < o.loc;
+			if ( moves_left != o.moves_left ) return moves_left < o.moves_left;
+			if ( total_movement != o.total_movement ) return total_movement < o.total_movement;
+			if ( additional_turns != o.additional_turns ) return additional_turns < o.additional_turns;
+			if ( viewing_side != o.viewing_side ) return viewing_side < o.viewing_side;
+			if ( slowed != o.slowed ) return slowed < o.slowed;
+			if ( force_ignore_zoc != o.force_ignore_zoc ) return force_ignore_zoc < o.force_ignore_zoc;
+			if ( see_all != o.see_all ) return see_all < o.see_all;
+			return ignore_units < o.ignore_units;
+		}
+	};
+
+	struct reach_entry {
+		paths::dest_vect destinations;
+		// The region in which a change can affect the result: the reached
+		// hexes plus a margin for zones of control, blocking units and
+		// adjacency-based abilities (skirmisher, hides).
+		int xmin, xmax, ymin, ymax;
+	};
+
+	typedef std::map<reach_key, reach_entry> reach_map;
+
+	/** Past this size the cache is simply flushed. */
+	const size_t max_reach_entries = 1024;
+	const int reach_margin = 2;
+
+	reach_map reach_entries;
+	reach_cache::statistics reach_stats;
+}
+
+namespace reach_cache {
+
+void invalidate(const map_location& loc)
+{
+	// Whatever changes a reach may also change where tunnels lead.
+	tunnel_cache::invalidate();
+	for ( reach_map::iterator i = reach_entries.begin(); i != reach_entries.end(); ) {
+		const reach_entry& e = i->second;
+		if ( e.xmin <= loc.x && loc.x <= e.xmax && e.ymin <= loc.y && loc.y <= e.ymax ) {
+			reach_entries.erase(i++);
+			++reach_stats.invalidated;
+		} else {
+			++i;
+		}
+	}
+}
+
+void invalidate_all()
+{
+	tunnel_cache::invalidate();
+	reach_stats.invalidated += reach_entries.size();
+	reach_entries.clear();
+}
+
+statistics get_statistics()
+{
+	statistics res = reach_stats;
+	res.entries = reach_entries.size();
+	return res;
+}
+
+}
+
 /**
  * Construct a list of paths for the specified unit.
  *
  * This function is used for several purposes, including showing a unit's
  * potential moves and generating currently possible paths.
+ * Results for units on the map are kept in the reach_cache.
  * @param u                The unit whose moves and movement type will be used.
  * @param force_ignore_zoc Set to true to completely ignore zones of control.
  * @param allow_teleport   Set to true to consider teleportation abilities.
@@ -533,6 +784,30 @@ paths::paths(const unit& u, bool force_ignore_zoc,
 		return;
 	}
 
+	// Only units on the map are cached: the invalidation hooks cannot see
+	// changes to fake or private units. Teleporting units are not cached
+	// either, since tunnel filters may depend on any part of the board.
+	bool cacheable = false;
+	if ( resources::units ) {
+		const unit_map::const_iterator on_map = resources::units->find(u.get_location());
+		cacheable = on_map.valid() && &*on_map == &u &&
+			!(allow_teleport && u.get_ability_bool("teleport"));
+	}
+
+	reach_key key = { u.underlying_id(), u.get_location(), u.movement_left(),
+		u.total_movement(), additional_turns, see_all ? 0 : viewing_team.side(),
+		u.get_state(unit::STATE_SLOWED), force_ignore_zoc, see_all, ignore_units };
+
+	if ( cacheable ) {
+		const reach_map::const_iterator cached = reach_entries.find(key);
+		if ( cached != reach_entries.end() ) {
+			++reach_stats.hits;
+			destinations = cached->second.destinations;
+			return;
+		}
+		++reach_stats.misses;
+	}
+
 	find_routes(u.get_location(), u.movement_type().get_movement(),
 	            u.get_state(unit::STATE_SLOWED), u.movement_left(),
 	            u.total_movement(), additional_turns, destinations, NULL,
@@ -540,6 +815,26 @@ paths::paths(const unit& u, bool force_ignore_zoc,
 	            ignore_units ? NULL : &teams[u.side()-1],
 	            force_ignore_zoc ? NULL : &u,
 	            see_all ? NULL : &viewing_team);
+
+	if ( cacheable ) {
+		if ( reach_entries.size() >= max_reach_entries ) {
+			reach_cache::invalidate_all();
+		}
+		reach_entry& entry = reach_entries[key];
+		entry.destinations = destinations;
+		entry.xmin = entry.xmax = u.get_location().x;
+		entry.ymin = entry.ymax = u.get_location().y;
+		BOOST_FOREACH(const step& s, destinations) {
+			entry.xmin = std::min(entry.xmin, s.curr.x);
+			entry.xmax = std::max(entry.xmax, s.curr.x);
+			entry.ymin = std::min(entry.ymin, s.curr.y);
+			entry.ymax = std::max(entry.ymax, s.curr.y);
+		}
+		entry.xmin -= reach_margin;
+		entry.ymin -= reach_margin;
+		entry.xmax += reach_margin;
+		entry.ymax += reach_margin;
+	}
 }
 
 /**
@@ -568,9 +863,12 @@ vision_path::vision_path(const unit& viewer, map_location const &loc,
 
 	// The four NULL parameters indicate (in order): no teleports,
 	// ignore units, ignore ZoC (no effect), and see all (no effect).
+	const cost_grid::ptr grid = cost_grid::get(resources::gameboard->map(),
+		viewer.movement_type().get_vision(), viewer.get_state(unit::STATE_SLOWED));
 	find_routes(loc, viewer.movement_type().get_vision(),
 	            viewer.get_state(unit::STATE_SLOWED), sight_range, sight_range,
-	            0, destinations, &edges, NULL, NULL, NULL, NULL, &jamming_map);
+	            0, destinations, &edges, NULL, NULL, NULL, NULL, &jamming_map,
+	            NULL, NULL, NULL, grid.get());
 }
 
 /**
@@ -591,8 +889,11 @@ vision_path::vision_path(const movetype::terrain_costs & view_costs, bool slowed
 {
 	// The four NULL parameters indicate (in order): no teleports,
 	// ignore units, ignore ZoC (no effect), and see all (no effect).
+	const cost_grid::ptr grid = cost_grid::get(resources::gameboard->map(),
+		view_costs, slowed);
 	find_routes(loc, view_costs, slowed, sight_range, sight_range, 0,
-	            destinations, &edges, NULL, NULL, NULL, NULL, &jamming_map);
+	            destinations, &edges, NULL, NULL, NULL, NULL, &jamming_map,
+	            NULL, NULL, NULL, grid.get());
 }
 
 /// Default destructor
@@ -617,9 +918,12 @@ jamming_path::jamming_path(const unit& jammer, map_location const &loc)
 
 	// The five NULL parameters indicate (in order): no edges, no teleports,
 	// ignore units, ignore ZoC (no effect), and see all (no effect).
+	const cost_grid::ptr grid = cost_grid::get(resources::gameboard->map(),
+		jammer.movement_type().get_jamming(), jammer.get_state(unit::STATE_SLOWED));
 	find_routes(loc, jammer.movement_type().get_jamming(),
 	            jammer.get_state(unit::STATE_SLOWED), jamming_range, jamming_range,
-	            0, destinations, NULL, NULL, NULL, NULL, NULL);
+	            0, destinations, NULL, NULL, NULL, NULL, NULL, NULL,
+	            NULL, NULL, NULL, grid.get());
 }
 
 /// Default destructor
@@ -696,7 +1000,9 @@ shortest_path_calculator::shortest_path_calculator(unit const &u, team const &t,
 	  movement_left_(unit_.movement_left()),
 	  total_movement_(unit_.total_movement()),
 	  ignore_unit_(ignore_unit), ignore_defense_(ignore_defense),
-	  see_all_(see_all)
+	  see_all_(see_all),
+	  grid_(cost_grid::get(map, u.movement_type().get_movement(),
+	                       u.get_state(unit::STATE_SLOWED)))
 {}
 
 double shortest_path_calculator::cost(const map_location& loc, const double so_far) const
@@ -708,8 +1014,7 @@ double shortest_path_calculator::cost(const map_location& loc, const double so_f
 	if (!see_all_ && viewing_team_.shrouded(loc))
 		return getNoPathValue();
 
-	const t_translation::t_terrain terrain = map_[loc];
-	int const terrain_cost = unit_.movement_cost(terrain);
+	int const terrain_cost = grid_ ? grid_->cost(loc) : unit_.movement_cost(map_[loc]);
 	// Pathfinding heuristic: the cost must be at least 1
 	VALIDATE(terrain_cost >= 1, _("Terrain with a movement cost less than 1 encountered."));
 
@@ -771,7 +1076,7 @@ double shortest_path_calculator::cost(const map_location& loc, const double so_f
 	// We will add a tiny cost based on terrain defense, so the pathfinding
 	// will prefer good terrains between 2 with the same MP cost
 	// Keep in mind that defense_modifier is inverted (= 100 - defense%)
-	const int defense_subcost = ignore_defense_ ? 0 : unit_.defense_modifier(terrain);
+	const int defense_subcost = ignore_defense_ ? 0 : unit_.defense_modifier(map_[loc]);
 
 	// We divide subcosts by 100 * 100, because defense is 100-based and
 	// we don't want any impact on move cost for less then 100-steps path
@@ -912,6 +1217,118 @@ void full_cost_map::add_unit(const map_location& origin, const unit_type* const
 	add_unit(u);
 }
 
+namespace {
+	/**
+	 * Computes the cost layers of a batch of units for full_cost_map::add_units(),
+	 * one unit per slot. Everything that is not safe to evaluate off the main
+	 * thread (teleport filters, the terrain costs) is resolved by prepare().
+	 */
+	struct cost_layer_job : public threading::parallel_job {
+		struct slot {
+			map_location origin;
+			// Only passed along; grid is used instead.
+			const movetype::terrain_costs * costs;
+			int moves_left, max_moves;
+			const unit * teleporter;
+			teleport_map teleports;
+			cost_grid::ptr grid;
+			findroute_workspace workspace;
+			std::vector<std::pair<int, int> > layer;
+
+			slot() : origin(), costs(NULL), moves_left(0), max_moves(0), teleporter(NULL),
+				teleports(), grid(), workspace(), layer() { }
+		};
+
+		explicit cost_layer_job(size_t nb_slots) : slots(nb_slots) { }
+
+		/// Returns false if @a u cannot be handled off the main thread.
+		bool prepare(size_t index, const unit & u, bool use_max_moves,
+		             bool allow_teleport, const team & viewing_team, bool see_all)
+		{
+			const movetype::terrain_costs & costs = u.movement_type().get_movement();
+			slot & s = slots[index];
+			s.grid = cost_grid::get(resources::gameboard->map(), costs,
+			                        u.get_state(unit::STATE_SLOWED));
+			if ( !s.grid )
+				return false;
+
+			s.origin = u.get_location();
+			s.costs = &costs;
+			s.moves_left = use_max_moves ? u.total_movement() : u.movement_left();
+			s.max_moves = u.total_movement();
+			s.teleporter = allow_teleport ? &u : NULL;
+			s.teleports = allow_teleport ?
+				get_teleport_locations(u, viewing_team, see_all, true) : teleport_map();
+			return true;
+		}
+
+		void run(size_t index)
+		{
+			slot & s = slots[index];
+			s.layer.assign(s.grid->w() * s.grid->h(), std::make_pair(0, 0));
+			paths::dest_vect dummy;
+			find_routes(s.origin, *s.costs, false,
+			            s.moves_left, s.max_moves, 99, dummy, NULL,
+			            s.teleporter, NULL, NULL, NULL, NULL, &s.layer,
+			            &s.workspace, &s.teleports, s.grid.get());
+		}
+
+		std::vector<slot> slots;
+	};
+}
+
+/**
+ * Adds the cost maps of several units to cost_map, computing them on several
+ * threads when that is safe (i.e. when units are ignored, so that no unit
+ * visibility or ability needs to be evaluated during the searches).
+ * The result is the same as calling add_unit() for each unit in turn.
+ * @param units real existing units on the map
+ */
+void full_cost_map::add_units(const std::vector<const unit*>& units, bool use_max_moves)
+{
+	const unsigned nb_threads = threading::hardware_concurrency();
+	if ( !ignore_units_ || nb_threads < 2 || units.size() < 2 ) {
+		BOOST_FOREACH(const unit* u, units) {
+			add_unit(*u, use_max_moves);
+		}
+		return;
+	}
+
+	std::vector<team> const &teams = *resources::teams;
+	// Teleport visibility is the only thing the viewing team matters for here.
+	const team & viewing_team = see_all_ ? teams.front() : viewing_team_;
+
+	// Work in batches so that only a few layers exist at any time.
+	cost_layer_job job(std::min<size_t>(units.size(), 2 * nb_threads));
+	for ( size_t next = 0; next < units.size(); ) {
+		size_t batch_size = 0;
+		for ( ; next < units.size() && batch_size < job.slots.size(); ++next ) {
+			const unit & u = *units[next];
+			if ( u.side() < 1 || u.side() > int(teams.size()) )
+				continue;
+			if ( job.prepare(batch_size, u, use_max_moves, allow_teleport_,
+			                 viewing_team, see_all_) )
+				++batch_size;
+			else
+				add_unit(u, use_max_moves);
+		}
+		threading::run_parallel(job, batch_size, nb_threads);
+
+		// Merge in unit order; the sums do not depend on it anyway.
+		for ( size_t i = 0; i != batch_size; ++i ) {
+			const std::vector<std::pair<int, int> > & layer = job.slots[i].layer;
+			for ( size_t h = 0; h != layer.size(); ++h ) {
+				if ( layer[h].second == 0 )
+					continue;
+				if ( cost_map[h].second == 0 )
+					cost_map[h].first = 0;
+				cost_map[h].first += layer[h].first;
+				cost_map[h].second += layer[h].second;
+			}
+		}
+	}
+}
+
 /**
  * Accessor for the cost/reach-amount pairs.
  * Read comment in pathfind.hpp to cost_map.
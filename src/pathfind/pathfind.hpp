@@ -24,6 +24,7 @@ class gamemap;
 class team;
 class unit;
 class unit_type;
+class unit_map;
 
 #include "map_location.hpp"
 #include "movetype.hpp"
@@ -32,8 +33,13 @@ class unit_type;
 #include <map>
 #include <set>
 
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+
 namespace pathfind {
 
+class cost_grid;
 class teleport_map;
 
 enum VACANT_TILE_TYPE { VACANT_CASTLE, VACANT_ANY };
@@ -99,6 +105,61 @@ struct paths
 	dest_vect destinations;
 };
 
+/**
+ * The number of searches run so far, for profiling: find_routes() runs (for
+ * reach, vision and cost maps) and A* searches. Counted in any thread.
+ */
+struct search_statistics
+{
+	search_statistics() : routes(0), astar(0) {}
+	size_t routes, astar;
+};
+search_statistics get_search_statistics();
+
+/**
+ * Cache of the reach maps built by the paths constructor for units on the map.
+ *
+ * Each entry remembers the region its search explored, so a change on the
+ * board only drops the entries whose search could have been affected by it.
+ * Like find_routes(), the cache must only be used from the main thread.
+ */
+namespace reach_cache {
+	/** Drops the entries whose explored region is near @a loc. */
+	void invalidate(const map_location& loc);
+	/** Drops all entries (terrain changes, unit modifications, new turns...). */
+	void invalidate_all();
+
+	struct statistics
+	{
+		statistics() : hits(0), misses(0), invalidated(0), entries(0) {}
+		size_t hits, misses, invalidated, entries;
+	};
+	statistics get_statistics();
+}
+
+/**
+ * Bitmaps, per side, of the hexes next to an enemy unit of that side.
+ *
+ * enemy_zoc() consults them before looking at the adjacent units, since
+ * most hexes are not next to any enemy. The bitmaps are built from the
+ * units of the game board when first needed, and then kept up to date by
+ * the unit_map of the game board as units are added, moved and removed.
+ * Like find_routes(), the cache must only be used from the main thread.
+ */
+namespace adjacency_cache {
+	/** Whether a unit (visible or not) of an enemy of @a current_team is next to @a loc. */
+	bool enemy_adjacent(const team& current_team, const map_location& loc);
+
+	/** Called by @a units when a unit of @a side is placed at @a loc. */
+	void unit_added(const unit_map& units, const map_location& loc, int side);
+	/** Called by @a units when a unit of @a side leaves @a loc. */
+	void unit_removed(const unit_map& units, const map_location& loc, int side);
+	/** Drops the bitmaps if they were built from @a units. */
+	void invalidate(const unit_map& units);
+	/** Drops the bitmaps (side or alliance changes...). */
+	void invalidate_all();
+}
+
 /**
  * A refinement of paths for use when calculating vision.
  */
@@ -189,7 +250,102 @@ struct marked_route
 	mark_map marks;
 };
 
+/**
+ * Scratch memory used by a_star_search().
+ *
+ * A workspace keeps the node array of a search alive, so that the next
+ * search using it does not need to reallocate it. A workspace must not be
+ * used by two searches at the same time; code that searches from several
+ * threads should give each thread its own workspace (or borrow one through
+ * pooled_search_workspace).
+ */
+class search_workspace : private boost::noncopyable
+{
+public:
+	search_workspace();
+	~search_workspace();
+
+	/** Releases the memory held by the workspace. */
+	void clear();
+
+	struct implementation;
+	implementation& impl() { return *impl_; }
+
+private:
+	boost::scoped_ptr<implementation> impl_;
+};
+
+/**
+ * Borrows a search_workspace from a process-wide pool for the lifetime of
+ * this object. The pool grows to the number of concurrent searches, so
+ * each thread effectively keeps reusing the same memory.
+ */
+class pooled_search_workspace : private boost::noncopyable
+{
+public:
+	pooled_search_workspace();
+	~pooled_search_workspace();
+
+	search_workspace& get() { return *workspace_; }
+
+private:
+	search_workspace* workspace_;
+};
+
+/**
+ * Finds the cheapest route from @a src to @a dst using @a workspace as
+ * scratch memory. Searches using different workspaces can run concurrently,
+ * provided the cost calculator can be used concurrently as well.
+ */
 plain_route a_star_search(map_location const &src, map_location const &dst,
+		double stop_at, const cost_calculator* costCalculator,
+		const size_t parWidth, const size_t parHeight,
+		const teleport_map* teleports, search_workspace& workspace);
+
+/**
+ * Same as above, but uses a workspace borrowed from the pool, so it is safe
+ * to call from several threads at once.
+ */
+plain_route a_star_search(map_location const &src, map_location const &dst,
+		double stop_at, const cost_calculator* costCalculator,
+		const size_t parWidth, const size_t parHeight,
+		const teleport_map* teleports = NULL);
+
+/**
+ * Finds the cheapest route from @a src to whichever of @a dsts is cheapest
+ * to reach, in a single search. The destination reached is the last step of
+ * the returned route. The search stops as soon as the first destination is
+ * settled, so this is cheaper than one search per destination.
+ */
+plain_route a_star_search(map_location const &src, std::set<map_location> const &dsts,
+		double stop_at, const cost_calculator* costCalculator,
+		const size_t parWidth, const size_t parHeight,
+		const teleport_map* teleports, search_workspace& workspace);
+
+/** Same as above, using a workspace borrowed from the pool. */
+plain_route a_star_search(map_location const &src, std::set<map_location> const &dsts,
+		double stop_at, const cost_calculator* costCalculator,
+		const size_t parWidth, const size_t parHeight,
+		const teleport_map* teleports = NULL);
+
+/**
+ * Finds the cheapest routes from @a src to each of @a dsts, in a single
+ * search that keeps going until every hex cheaper than @a stop_at is
+ * settled. The routes are returned in the order of @a dsts; those that
+ * cannot be reached are empty, as with a_star_search(). This is cheaper
+ * than one search per destination as soon as there are a few of them.
+ * Where several routes are equally cheap, the one returned may differ
+ * from the one a_star_search() would find.
+ */
+std::vector<plain_route> route_search_all(map_location const &src,
+		std::vector<map_location> const &dsts,
+		double stop_at, const cost_calculator* costCalculator,
+		const size_t parWidth, const size_t parHeight,
+		const teleport_map* teleports, search_workspace& workspace);
+
+/** Same as above, using a workspace borrowed from the pool. */
+std::vector<plain_route> route_search_all(map_location const &src,
+		std::vector<map_location> const &dsts,
 		double stop_at, const cost_calculator* costCalculator,
 		const size_t parWidth, const size_t parHeight,
 		const teleport_map* teleports = NULL);
@@ -218,6 +374,8 @@ private:
 	bool const ignore_unit_;
 	bool const ignore_defense_;
 	bool see_all_;
+	/** Flattened movement costs of unit_, if they fit in a byte. */
+	boost::shared_ptr<const cost_grid> grid_;
 };
 
 struct move_type_path_calculator : cost_calculator
@@ -278,6 +436,7 @@ struct full_cost_map
 
 	void add_unit(const unit& u, bool use_max_moves=true);
 	void add_unit(const map_location& origin, const unit_type* const unit_type, int side);
+	void add_units(const std::vector<const unit*>& units, bool use_max_moves=true);
 	int get_cost_at(int x, int y) const;
 	std::pair<int, int> get_pair_at(int x, int y) const;
 	double get_average_cost_at(int x, int y) const;
@@ -18,6 +18,7 @@
 #include "game_board.hpp"
 #include "log.hpp"
 #include "resources.hpp"
+#include "serialization/parser.hpp"
 #include "serialization/string_utils.hpp"
 #include "team.hpp"
 #include "terrain_filter.hpp"
@@ -27,6 +28,9 @@
 
 #include <boost/foreach.hpp>
 
+#include <algorithm>
+#include <sstream>
+
 static lg::log_domain log_engine("engine");
 #define ERR_PF LOG_STREAM(err, log_engine)
 
@@ -35,10 +39,26 @@ namespace pathfind {
 
 namespace {
 	const std::string reversed_suffix = "-__REVERSED__";
+
+	/* Bumped by tunnel_cache::invalidate(). */
+	unsigned tunnel_generation = 0;
+
+	/* Past this size the cache is simply flushed. */
+	const size_t max_cached_tunnels = 256;
+}
+
+namespace tunnel_cache {
+
+void invalidate()
+{
+	++tunnel_generation;
+}
+
 }
 
 // This constructor is *only* meant for loading from saves
-teleport_group::teleport_group(const config& cfg) : cfg_(cfg), reversed_(cfg["reversed"].to_bool(false)), id_(cfg["id"])
+teleport_group::teleport_group(const config& cfg) : cfg_(cfg), reversed_(cfg["reversed"].to_bool(false)), id_(cfg["id"]),
+	locations_key_(), locations_use_unit_(false)
 {
 	assert(cfg.has_attribute("id"));
 	assert(cfg.has_attribute("reversed"));
@@ -46,9 +66,11 @@ teleport_group::teleport_group(const config& cfg) : cfg_(cfg), reversed_(cfg["re
 	assert(cfg_.child_count("source") == 1);
 	assert(cfg_.child_count("target") == 1);
 	assert(cfg_.child_count("filter") == 1);
+	init_locations_key();
 }
 
-teleport_group::teleport_group(const vconfig& cfg, bool reversed) : cfg_(cfg.get_config()), reversed_(reversed), id_()
+teleport_group::teleport_group(const vconfig& cfg, bool reversed) : cfg_(cfg.get_config()), reversed_(reversed), id_(),
+	locations_key_(), locations_use_unit_(false)
 {
 	assert(cfg_.child_count("source") == 1);
 	assert(cfg_.child_count("target") == 1);
@@ -62,6 +84,19 @@ teleport_group::teleport_group(const vconfig& cfg, bool reversed) : cfg_(cfg.get
 	}
 }
 
+void teleport_group::init_locations_key()
+{
+	config filters;
+	filters.add_child("source", cfg_.child_or_empty("source"));
+	filters.add_child("target", cfg_.child_or_empty("target"));
+
+	std::ostringstream key;
+	write(key, filters);
+	key << (reversed_ ? 'r' : 'f');
+	locations_key_ = key.str();
+	locations_use_unit_ = locations_key_.find("teleport_unit") != std::string::npos;
+}
+
 class ignore_units_display_context : public display_context {
 public:
 	ignore_units_display_context(const display_context & dc)
@@ -107,6 +142,25 @@ void teleport_group::get_teleport_pair(
 		  teleport_pair& loc_pair
 		, const unit& u
 		, const bool ignore_units) const
+{
+	if (matches(u)) {
+		get_locations(loc_pair, u, ignore_units);
+	}
+}
+
+bool teleport_group::matches(const unit& u) const
+{
+	assert(resources::filter_con);
+
+	vconfig filter(cfg_.child_or_empty("filter"), true);
+	const unit_filter ufilt(filter, resources::filter_con); //Note: Don't use the ignore units filter context here, only for the terrain filters. (That's how it worked before the filter contexts were introduced)
+	return ufilt.matches(u, u.get_location());
+}
+
+void teleport_group::get_locations(
+		  teleport_pair& loc_pair
+		, const unit& u
+		, const bool ignore_units) const
 {
 	const map_location &loc = u.get_location();
 
@@ -117,12 +171,9 @@ void teleport_group::get_teleport_pair(
 		fc = new ignore_units_filter_context(*resources::filter_con);
 	}
 
-	vconfig filter(cfg_.child_or_empty("filter"), true);
 	vconfig source(cfg_.child_or_empty("source"), true);
 	vconfig target(cfg_.child_or_empty("target"), true);
-	const unit_filter ufilt(filter, resources::filter_con); //Note: Don't use the ignore units filter context here, only for the terrain filters. (That's how it worked before the filter contexts were introduced)
-	if (ufilt.matches(u, loc)) {
-
+	{
 		scoped_xy_unit teleport_unit("teleport_unit", loc.x, loc.y, *resources::units);
 
 		terrain_filter source_filter(source, fc);
@@ -162,12 +213,16 @@ teleport_map::teleport_map(
 	: teleport_map_()
 	, sources_()
 	, targets_()
+	, adjacent_index_()
+	, adjacent_targets_()
+	, source_list_()
+	, target_list_()
 {
 
 	BOOST_FOREACH(const teleport_group& group, groups) {
 
 		teleport_pair locations;
-		group.get_teleport_pair(locations, u, ignore_units);
+		resources::tunnels->get_teleport_pair(locations, group, u, ignore_units);
 		if (!see_all && !group.always_visible() && viewing_team.is_enemy(u.side())) {
 			teleport_pair filter_locs;
 			BOOST_FOREACH(const map_location &loc, locations.first)
@@ -194,6 +249,43 @@ teleport_map::teleport_map(
 		sources_.insert(std::make_pair(teleport_id, locations.first));
 		targets_.insert(std::make_pair(teleport_id, locations.second));
 	}
+
+	build_flat_lists();
+}
+
+void teleport_map::build_flat_lists()
+{
+	std::set<map_location> all_targets;
+	std::map<map_location, std::set<std::string> >::const_iterator it;
+	for(it = teleport_map_.begin(); it != teleport_map_.end(); ++it) {
+		std::set<map_location> exits;
+		BOOST_FOREACH(const std::string& id, it->second) {
+			const std::set<map_location>& target = targets_.find(id)->second;
+			exits.insert(target.begin(), target.end());
+		}
+		adjacent_range range = { it->first, adjacent_targets_.size(), 0 };
+		adjacent_targets_.insert(adjacent_targets_.end(), exits.begin(), exits.end());
+		range.end = adjacent_targets_.size();
+		adjacent_index_.push_back(range);
+		source_list_.push_back(it->first);
+	}
+
+	std::map<std::string, std::set<map_location> >::const_iterator t;
+	for(t = targets_.begin(); t != targets_.end(); ++t) {
+		all_targets.insert(t->second.begin(), t->second.end());
+	}
+	target_list_.assign(all_targets.begin(), all_targets.end());
+}
+
+teleport_map::location_range teleport_map::adjacents(const map_location& loc) const
+{
+	std::vector<adjacent_range>::const_iterator it =
+		std::lower_bound(adjacent_index_.begin(), adjacent_index_.end(), loc);
+	if(it == adjacent_index_.end() || it->source != loc || it->begin == it->end) {
+		return location_range(NULL, NULL);
+	}
+	const map_location* base = &adjacent_targets_[0];
+	return location_range(base + it->begin, base + it->end);
 }
 
 void teleport_map::get_adjacents(std::set<map_location>& adjacents, map_location loc) const {
@@ -249,7 +341,8 @@ const teleport_map get_teleport_locations(const unit &u,
 	return teleport_map(groups, u, viewing_team, see_all, ignore_units);
 }
 
-manager::manager(const config &cfg) : tunnels_(), id_(cfg["next_teleport_group_id"].to_int(0)) {
+manager::manager(const config &cfg) : tunnels_(), id_(cfg["next_teleport_group_id"].to_int(0)),
+	cache_(), cache_generation_(tunnel_generation) {
 	const int tunnel_count = cfg.child_count("tunnel");
 	for(int i = 0; i < tunnel_count; ++i) {
 		const config& t = cfg.child("tunnel", i);
@@ -277,6 +370,45 @@ void manager::remove(const std::string &id) {
 	}
 }
 
+bool manager::cache_key::operator<(const cache_key& other) const {
+	if (ignore_units != other.ignore_units)
+		return ignore_units < other.ignore_units;
+	if (unit_loc != other.unit_loc)
+		return unit_loc < other.unit_loc;
+	return locations < other.locations;
+}
+
+void manager::get_teleport_pair(
+		  teleport_pair& loc_pair
+		, const teleport_group& group
+		, const unit& u
+		, const bool ignore_units) const
+{
+	if (!group.matches(u)) {
+		return;
+	}
+
+	if (cache_generation_ != tunnel_generation || cache_.size() >= max_cached_tunnels) {
+		cache_.clear();
+		cache_generation_ = tunnel_generation;
+	}
+
+	cache_key key;
+	key.locations = group.locations_key();
+	key.ignore_units = ignore_units;
+	if (group.locations_use_unit()) {
+		key.unit_loc = u.get_location();
+	}
+
+	cache_map::iterator it = cache_.find(key);
+	if (it == cache_.end()) {
+		it = cache_.insert(std::make_pair(key, teleport_pair())).first;
+		group.get_locations(it->second, u, ignore_units);
+	}
+	loc_pair.first.insert(it->second.first.begin(), it->second.first.end());
+	loc_pair.second.insert(it->second.second.begin(), it->second.second.end());
+}
+
 const std::vector<teleport_group>& manager::get() const {
 	return tunnels_;
 }
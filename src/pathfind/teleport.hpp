@@ -58,6 +58,35 @@ public:
 			, const unit& u
 			, const bool ignore_units) const;
 
+	/*
+	 * @param u		the unit to test
+	 * @returns whether the unit u matches the group's filter
+	 */
+	bool matches(const unit& u) const;
+
+	/*
+	 * Fills the argument loc_pair with the tunnel entrances and exits,
+	 * without checking the group's filter.
+	 * @param loc_pair		returned teleport_pair
+	 * @param u				the unit stored in $teleport_unit
+	 * @param ignore_units	don't consider zoc and blocking when calculating the shorted path between
+	 */
+	void get_locations(
+			  teleport_pair& loc_pair
+			, const unit& u
+			, const bool ignore_units) const;
+
+	/*
+	 * Identifies the source and target filters (and the direction) of the
+	 * group, so that groups with the same filters can share cached locations.
+	 */
+	const std::string& locations_key() const { return locations_key_; }
+
+	/*
+	 * @returns whether the source and target filters refer to $teleport_unit
+	 */
+	bool locations_use_unit() const { return locations_use_unit_; }
+
 	/*
 	 * Can be set by the id attribute or is randomly chosen.
 	 * @return unique id of the teleport group
@@ -75,10 +104,13 @@ public:
 	config to_config() const;
 
 private:
+	void init_locations_key();
 
 	config cfg_; 		// unexpanded contents of a [tunnel] tag
 	bool reversed_; 	// Whether the tunnel's direction is reversed
 	std::string id_; 	// unique id of the group
+	std::string locations_key_;	// serialized source and target filters
+	bool locations_use_unit_;	// whether these mention $teleport_unit
 };
 
 
@@ -102,7 +134,8 @@ public:
 	 * Constructs an empty teleport map.
 	 */
 	teleport_map() :
-		teleport_map_(), sources_(), targets_() {}
+		teleport_map_(), sources_(), targets_(),
+		adjacent_index_(), adjacent_targets_(), source_list_(), target_list_() {}
 
 	/*
 	 * @param adjacents		used to return the adjacent hexes
@@ -118,6 +151,23 @@ public:
 	 */
 	void get_targets(std::set<map_location>& targets) const;
 
+	/*
+	 * Range of the hexes a unit can teleport to from @a loc.
+	 * The range points into storage owned by the teleport_map, so unlike
+	 * get_adjacents() this does not allocate.
+	 */
+	typedef std::pair<const map_location*, const map_location*> location_range;
+	location_range adjacents(const map_location& loc) const;
+
+	/*
+	 * @returns all tunnel entrances (without duplicates)
+	 */
+	const std::vector<map_location>& sources() const { return source_list_; }
+	/*
+	 * @returns all tunnel exits (without duplicates)
+	 */
+	const std::vector<map_location>& targets() const { return target_list_; }
+
 	/*
 	 * @returns whether the teleport_map does contain any defined tunnel
 	 */
@@ -126,9 +176,24 @@ public:
 	}
 
 private:
+	/* Builds the flat lookup vectors from the maps above. */
+	void build_flat_lists();
+
 	std::map<map_location, std::set<std::string> > teleport_map_;
 	std::map<std::string, std::set<map_location> > sources_;
 	std::map<std::string, std::set<map_location> > targets_;
+
+	struct adjacent_range {
+		map_location source;
+		size_t begin, end;
+		bool operator<(const map_location& loc) const { return source < loc; }
+	};
+	/* One entry per tunnel entrance, sorted by location. */
+	std::vector<adjacent_range> adjacent_index_;
+	/* The exits of each entrance, indexed by adjacent_index_. */
+	std::vector<map_location> adjacent_targets_;
+	std::vector<map_location> source_list_;
+	std::vector<map_location> target_list_;
 };
 
 /*
@@ -141,10 +206,32 @@ private:
 const teleport_map get_teleport_locations(const unit &u, const team &viewing_team,
 		bool see_all = false, bool ignore_units = false);
 
+/*
+ * The locations of the tunnels are cached by the manager, since evaluating
+ * the terrain filters of many [tunnel] tags again for every unit and every
+ * search is slow. The cache is dropped whenever something the filters may
+ * depend on changes: terrain, units, villages, fog, or variables (events).
+ */
+namespace tunnel_cache {
+	/* Drops all cached tunnel locations. */
+	void invalidate();
+}
+
 class manager: public savegame::savegame_config {
 public:
 	manager(const config &cfg);
 
+	/*
+	 * Same as group.get_teleport_pair(), except that the locations are
+	 * reused from an earlier call with a group having the same source and
+	 * target filters, when nothing changed in between (see tunnel_cache).
+	 */
+	void get_teleport_pair(
+			  teleport_pair& loc_pair
+			, const teleport_group& group
+			, const unit& u
+			, const bool ignore_units) const;
+
 	/*
 	 * @param group		teleport_group to be added
 	 */
@@ -168,8 +255,19 @@ public:
 	 */
 	std::string next_unique_id();
 private:
+	struct cache_key {
+		std::string locations;
+		bool ignore_units;
+		map_location unit_loc;	// only set for filters using $teleport_unit
+		bool operator<(const cache_key& other) const;
+	};
+	typedef std::map<cache_key, teleport_pair> cache_map;
+
 	std::vector<teleport_group> tunnels_;
 	int id_;
+
+	mutable cache_map cache_;
+	mutable unsigned cache_generation_;	// of the tunnel_cache when cache_ was filled
 };
 
 }
@@ -25,6 +25,8 @@
 
 #include <boost/foreach.hpp>
 
+#include <algorithm>
+
 
 /**
  * Function that will add to @a result all locations exactly @a radius tiles
@@ -241,38 +243,49 @@ void get_tiles_radius(gamemap const &map, std::vector<map_location> const &locs,
                       size_t radius, std::set<map_location> &result,
                       bool with_border, xy_pred const &pred)
 {
-	typedef std::set<map_location> location_set;
-
-	location_set must_visit, filtered_out;
-	location_set not_visited(locs.begin(), locs.end());
+	// The state of each hex of the board is kept in a bitmap, column by
+	// column, so that @a pred is called at most once per hex.
+	enum { UNSEEN, REACHED, FILTERED_OUT };
+	const int border = with_border ? map.border_size() : 0;
+	const int height = map.h() + 2 * border;
+	std::vector<unsigned char> state(std::max(0, (map.w() + 2 * border) * height), UNSEEN);
+
+	// The provided locations are included even if off the board.
+	std::vector<map_location> reached(locs);
+	BOOST_FOREACH(const map_location &loc, locs) {
+		if ( with_border ? map.on_board_with_border(loc) : map.on_board(loc) )
+			state[(loc.x + border) * height + loc.y + border] = REACHED;
+	}
 
-	for ( ; radius != 0  &&  !not_visited.empty(); --radius )
+	// Breadth-first, one ring of hexes per step.
+	size_t ring_begin = 0;
+	for ( ; radius != 0  &&  ring_begin != reached.size(); --radius )
 	{
-		location_set::const_iterator it = not_visited.begin();
-		location_set::const_iterator it_end = not_visited.end();
-
-		result.insert(it, it_end);
-		for(; it != it_end; ++it) {
+		const size_t ring_end = reached.size();
+		for(size_t r = ring_begin; r != ring_end; ++r) {
 			map_location adj[6];
-			get_adjacent_tiles(*it, adj);
+			get_adjacent_tiles(reached[r], adj);
 			for(size_t i = 0; i != 6; ++i) {
 				map_location const &loc = adj[i];
 				if ( with_border ? map.on_board_with_border(loc) :
 				                   map.on_board(loc) ) {
-					if ( !result.count(loc) && !filtered_out.count(loc) ) {
-						if ( pred(loc) )
-							must_visit.insert(loc);
-						else
-							filtered_out.insert(loc);
+					unsigned char &s = state[(loc.x + border) * height + loc.y + border];
+					if ( s == UNSEEN ) {
+						if ( pred(loc) ) {
+							s = REACHED;
+							reached.push_back(loc);
+						} else {
+							s = FILTERED_OUT;
+						}
 					}
 				}
 			}
 		}
-
-		not_visited.swap(must_visit);
-		must_visit.clear();
+		ring_begin = ring_end;
 	}
 
-	result.insert(not_visited.begin(), not_visited.end());
+	// Sorted, the locations are inserted next to each other.
+	std::sort(reached.begin(), reached.end());
+	result.insert(reached.begin(), reached.end());
 }
 
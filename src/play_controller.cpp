@@ -195,6 +195,8 @@ play_controller::~play_controller()
 {
 	hotkey::delete_all_wml_hotkeys();
 	clear_resources();
+	// The game may end before the last autosave is written.
+	savegame::finish_background_save();
 }
 struct throw_end_level { void operator()(const config&) { throw_quit_game_exception(); } };
 void play_controller::init(CVideo& video){
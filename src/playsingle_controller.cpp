@@ -39,6 +39,7 @@
 #include "marked-up_text.hpp"
 #include "playturn.hpp"
 #include "random_new_deterministic.hpp"
+#include "render_benchmark.hpp"
 #include "replay_helper.hpp"
 #include "resources.hpp"
 #include "savegame.hpp"
@@ -53,6 +54,7 @@
 #include "storyscreen/interface.hpp"
 #include "unit.hpp"
 #include "unit_animation.hpp"
+#include "unit_types.hpp"
 #include "util.hpp"
 #include "whiteboard/manager.hpp"
 #include "hotkey/hotkey_item.hpp"
@@ -202,7 +204,7 @@ void playsingle_controller::report_victory(
 void playsingle_controller::play_scenario_init() {
 	// At the beginning of the scenario, save a snapshot as replay_start
 	if(saved_game_.replay_start().empty()){
-		saved_game_.replay_start() = to_config();
+		saved_game_.set_replay_start(to_config());
 	}
 	start_game();
 	if( saved_game_.classification().random_mode != "" && (network::nconnections() != 0)) {
@@ -237,6 +239,23 @@ void playsingle_controller::play_scenario_main_loop() {
 	} //end for loop
 }
 
+/**
+ * Starts loading the sounds of the animations of the unit types on the map,
+ * so that the first attack of each doesn't wait for the disk.
+ */
+static void prefetch_unit_sounds(const unit_map& units)
+{
+	std::set<const unit_type*> types;
+	BOOST_FOREACH(const unit& u, units) {
+		if(!types.insert(&u.type()).second) {
+			continue;
+		}
+		BOOST_FOREACH(const unit_animation& anim, u.type().animations()) {
+			anim.prefetch_sounds();
+		}
+	}
+}
+
 LEVEL_RESULT playsingle_controller::play_scenario(
 	const config::const_child_itors &story)
 {
@@ -269,6 +288,11 @@ LEVEL_RESULT playsingle_controller::play_scenario(
 	LOG_NG << "entering try... " << (SDL_GetTicks() - ticks_) << "\n";
 	try {
 		play_scenario_init();
+		prefetch_unit_sounds(gamestate_.board_.units());
+		if (game_config::render_benchmark_frames != 0) {
+			run_render_benchmark(*gui_, game_config::render_benchmark_frames, std::cout);
+			exit(0);
+		}
 		if (!is_regular_game_end() && !linger_) {
 			play_scenario_main_loop();
 		}
@@ -874,6 +874,16 @@ void set_draw_delay(int value)
 	draw_delay_ = value;
 }
 
+int image_cache_size()
+{
+	return lexical_cast_in_range<int>(get("image_cache_size"), 1024, 0, 65536);
+}
+
+void set_image_cache_size(int size)
+{
+	prefs["image_cache_size"] = size;
+}
+
 bool use_color_cursors()
 {
 	return color_cursors;
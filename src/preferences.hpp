@@ -209,6 +209,10 @@ namespace preferences {
 	int draw_delay();
 	void set_draw_delay(int value);
 
+	/** The memory the image caches may use, in MiB, 0 for no limit. */
+	int image_cache_size();
+	void set_image_cache_size(int size);
+
 	bool animate_map();
 	void set_animate_map(bool value);
 
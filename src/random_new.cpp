@@ -51,6 +51,19 @@ namespace random_new
 		return next_random_impl();
 	}
 
+	void rng::fill(uint32_t* out, size_t n)
+	{
+		random_calls_ += n;
+		fill_impl(out, n);
+	}
+
+	void rng::fill_impl(uint32_t* out, size_t n)
+	{
+		for(size_t i = 0; i != n; ++i) {
+			out[i] = next_random_impl();
+		}
+	}
+
 	/** 
 	 *  This code is based on the boost implementation of uniform_smallint.
 	 *  http://www.boost.org/doc/libs/1_55_0/boost/random/uniform_smallint.hpp
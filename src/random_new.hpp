@@ -32,6 +32,13 @@ namespace random_new
 		 * Provides the next random draw. This is raw PRG output.
 		 */
 		uint32_t next_random();
+
+		/**
+		 * Provides @a n random draws at once, the same as @a n calls of
+		 * next_random() would, and counted as many calls.
+		 */
+		void fill(uint32_t* out, size_t n);
+
 		virtual ~rng();
 		/**
 		 * Provides the number of random calls to the rng in this context.
@@ -52,6 +59,8 @@ namespace random_new
 
 	protected:
 		virtual uint32_t next_random_impl();
+		/** Draws @a n numbers; by default, calls next_random_impl() @a n times. */
+		virtual void fill_impl(uint32_t* out, size_t n);
 		unsigned int random_calls_;
 
 	private:
@@ -33,6 +33,11 @@ namespace random_new
 		return generator_.get_next_random();
 	}
 
+	void rng_deterministic::fill_impl(uint32_t* out, size_t n)
+	{
+		generator_.fill(out, n);
+	}
+
 
 	set_random_determinstic::set_random_determinstic(rand_rng::mt_rng& rng)
 		: old_rng_(generator), new_rng_(rng)
@@ -32,6 +32,7 @@ namespace random_new
 
 	protected:
 		virtual uint32_t next_random_impl();
+		virtual void fill_impl(uint32_t* out, size_t n);
 	private:
 		rand_rng::mt_rng& generator_;
 	};
@@ -39,6 +39,16 @@ namespace random_new
 		return retv;
 	}
 
+	void synced_rng::fill_impl(uint32_t* out, size_t n)
+	{
+		if(!has_valid_seed_)
+		{
+			initialize();
+		}
+		gen_.fill(out, n);
+		LOG_RND << "random_new::rng::fill_impl drew " << n << " numbers\n";
+	}
+
 	void synced_rng::initialize()
 	{
 		std::string new_seed = seed_generator_();
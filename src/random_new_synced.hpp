@@ -36,6 +36,7 @@ namespace random_new
 
 	protected:
 		virtual uint32_t next_random_impl();
+		virtual void fill_impl(uint32_t* out, size_t n);
 	private:
 		void initialize();
 		bool has_valid_seed_;
@@ -23,20 +23,63 @@
 #include <boost/bind.hpp>
 #include <boost/foreach.hpp>
 
+recall_list_manager::recall_list_manager()
+	: recall_list_()
+	, ids_()
+	, underlying_ids_()
+	, indexed_(false)
+	, indexed_generation_(0)
+{
+}
+
 static bool find_if_matches_helper(const unit_ptr & ptr, const std::string & unit_id)
 {
 	return ptr->matches_id(unit_id);
 }
 
+bool recall_list_manager::indexes_current() const
+{
+	return indexed_ && indexed_generation_ == unit::id_generation();
+}
+
+void recall_list_manager::check_indexes() const
+{
+	if (indexes_current()) {
+		return;
+	}
+	ids_.clear();
+	underlying_ids_.clear();
+	// insert() keeps the first unit of each id.
+	for (size_t i = 0; i != recall_list_.size(); ++i) {
+		ids_.insert(std::make_pair(recall_list_[i]->id(), i));
+		underlying_ids_.insert(std::make_pair(recall_list_[i]->underlying_id(), i));
+	}
+	indexed_ = true;
+	indexed_generation_ = unit::id_generation();
+}
+
+size_t recall_list_manager::index_of_id(const std::string & unit_id) const
+{
+	check_indexes();
+	boost::unordered_map<std::string, size_t>::const_iterator it = ids_.find(unit_id);
+	return it != ids_.end() ? it->second : recall_list_.size();
+}
+
+size_t recall_list_manager::index_of_underlying_id(size_t uid) const
+{
+	check_indexes();
+	boost::unordered_map<size_t, size_t>::const_iterator it = underlying_ids_.find(uid);
+	return it != underlying_ids_.end() ? it->second : recall_list_.size();
+}
+
 /**
  * Used to find units in vectors by their ID.
  */
 unit_ptr recall_list_manager::find_if_matches_id(const std::string &unit_id)
 {
-	std::vector<unit_ptr >::iterator it = std::find_if(recall_list_.begin(), recall_list_.end(),
-	                    boost::bind(&find_if_matches_helper, _1, unit_id));
-	if (it != recall_list_.end()) {
-		return *it;
+	const size_t index = index_of_id(unit_id);
+	if (index != recall_list_.size()) {
+		return recall_list_[index];
 	} else {
 		return unit_ptr();
 	}
@@ -47,10 +90,9 @@ unit_ptr recall_list_manager::find_if_matches_id(const std::string &unit_id)
  */
 unit_const_ptr recall_list_manager::find_if_matches_id(const std::string &unit_id) const
 {
-	std::vector<unit_ptr >::const_iterator it = std::find_if(recall_list_.begin(), recall_list_.end(),
-	                    boost::bind(&find_if_matches_helper, _1, unit_id));
-	if (it != recall_list_.end()) {
-		return *it;
+	const size_t index = index_of_id(unit_id);
+	if (index != recall_list_.size()) {
+		return recall_list_[index];
 	} else {
 		return unit_ptr();
 	}
@@ -64,28 +106,29 @@ void recall_list_manager::erase_if_matches_id(const std::string &unit_id)
 	recall_list_.erase(std::remove_if(recall_list_.begin(), recall_list_.end(),
 	                                  boost::bind(&find_if_matches_helper, _1, unit_id)),
 	                       recall_list_.end());
+	indexed_ = false;
 }
 
 void recall_list_manager::add (const unit_ptr & ptr)
 {
 	recall_list_.push_back(ptr);
+	if (indexes_current()) {
+		ids_.insert(std::make_pair(ptr->id(), recall_list_.size() - 1));
+		underlying_ids_.insert(std::make_pair(ptr->underlying_id(), recall_list_.size() - 1));
+	}
 }
 
 size_t recall_list_manager::find_index(const std::string & unit_id) const
 {
-	std::vector<unit_ptr >::const_iterator it = std::find_if(recall_list_.begin(), recall_list_.end(),
-	                    boost::bind(&find_if_matches_helper, _1, unit_id));
-
-	return it - recall_list_.begin();
+	return index_of_id(unit_id);
 }
 
 unit_ptr recall_list_manager::extract_if_matches_id(const std::string &unit_id)
 {
-	std::vector<unit_ptr >::iterator it = std::find_if(recall_list_.begin(), recall_list_.end(),
-	                    boost::bind(&find_if_matches_helper, _1, unit_id));
-	if (it != recall_list_.end()) {
-		unit_ptr ret = *it;
-		recall_list_.erase(it);
+	const size_t index = index_of_id(unit_id);
+	if (index != recall_list_.size()) {
+		unit_ptr ret = recall_list_[index];
+		erase_at(index);
 		return ret;
 	} else {
 		return unit_ptr();
@@ -99,10 +142,9 @@ static bool find_if_matches_uid_helper(const unit_ptr & ptr, size_t uid)
 
 unit_ptr recall_list_manager::find_if_matches_underlying_id(size_t uid)
 {
-	std::vector<unit_ptr >::iterator it = std::find_if(recall_list_.begin(), recall_list_.end(),
-	                    boost::bind(&find_if_matches_uid_helper, _1, uid));
-	if (it != recall_list_.end()) {
-		return *it;
+	const size_t index = index_of_underlying_id(uid);
+	if (index != recall_list_.size()) {
+		return recall_list_[index];
 	} else {
 		return unit_ptr();
 	}
@@ -110,10 +152,9 @@ unit_ptr recall_list_manager::find_if_matches_underlying_id(size_t uid)
 
 unit_const_ptr recall_list_manager::find_if_matches_underlying_id(size_t uid) const
 {
-	std::vector<unit_ptr >::const_iterator it = std::find_if(recall_list_.begin(), recall_list_.end(),
-	                    boost::bind(&find_if_matches_uid_helper, _1, uid));
-	if (it != recall_list_.end()) {
-		return *it;
+	const size_t index = index_of_underlying_id(uid);
+	if (index != recall_list_.size()) {
+		return recall_list_[index];
 	} else {
 		return unit_ptr();
 	}
@@ -124,26 +165,70 @@ void recall_list_manager::erase_by_underlying_id(size_t uid)
 	recall_list_.erase(std::remove_if(recall_list_.begin(), recall_list_.end(),
 	                                  boost::bind(&find_if_matches_uid_helper, _1, uid)),
 	                       recall_list_.end());
+	indexed_ = false;
 }
 
 unit_ptr recall_list_manager::extract_if_matches_underlying_id(size_t uid)
 {
-	std::vector<unit_ptr >::iterator it = std::find_if(recall_list_.begin(), recall_list_.end(),
-	                    boost::bind(&find_if_matches_uid_helper, _1, uid));
-	if (it != recall_list_.end()) {
-		unit_ptr ret = *it;
-		recall_list_.erase(it);
+	const size_t index = index_of_underlying_id(uid);
+	if (index != recall_list_.size()) {
+		unit_ptr ret = recall_list_[index];
+		erase_at(index);
 		return ret;
 	} else {
 		return unit_ptr();
 	}
 }
 
+std::vector<unit_ptr>::iterator recall_list_manager::erase_at(size_t idx)
+{
+	const unit_ptr removed = recall_list_[idx];
+	const std::vector<unit_ptr>::iterator res = recall_list_.erase(recall_list_.begin()+idx);
+	if (!indexes_current()) {
+		return res;
+	}
+
+	// The units after it move down one place.
+	typedef boost::unordered_map<std::string, size_t>::value_type id_entry;
+	typedef boost::unordered_map<size_t, size_t>::value_type uid_entry;
+	bool was_first_id = ids_.find(removed->id())->second == idx;
+	bool was_first_uid = underlying_ids_.find(removed->underlying_id())->second == idx;
+	if (was_first_id) {
+		ids_.erase(removed->id());
+	}
+	if (was_first_uid) {
+		underlying_ids_.erase(removed->underlying_id());
+	}
+	BOOST_FOREACH(id_entry & entry, ids_) {
+		if (entry.second > idx) {
+			--entry.second;
+		}
+	}
+	BOOST_FOREACH(uid_entry & entry, underlying_ids_) {
+		if (entry.second > idx) {
+			--entry.second;
+		}
+	}
+
+	// A later unit with the same id now comes first.
+	for (size_t i = idx; i != recall_list_.size(); ++i) {
+		if (was_first_id && recall_list_[i]->id() == removed->id()) {
+			ids_.insert(std::make_pair(removed->id(), i));
+			was_first_id = false;
+		}
+		if (was_first_uid && recall_list_[i]->underlying_id() == removed->underlying_id()) {
+			underlying_ids_.insert(std::make_pair(removed->underlying_id(), i));
+			was_first_uid = false;
+		}
+	}
+	return res;
+}
+
 std::vector<unit_ptr>::iterator recall_list_manager::erase_index(size_t idx) {
 	assert(idx < recall_list_.size());
-	return recall_list_.erase(recall_list_.begin()+idx);
+	return erase_at(idx);
 }
 
 std::vector<unit_ptr>::iterator recall_list_manager::erase(std::vector<unit_ptr>::iterator it) {
-	return recall_list_.erase(it);
+	return erase_at(it - recall_list_.begin());
 }
@@ -19,6 +19,8 @@
 
 #include "unit_ptr.hpp"
 
+#include <boost/unordered_map.hpp>
+
 #include <string>
 #include <vector>
 
@@ -28,6 +30,8 @@ namespace ai {
 
 class recall_list_manager {
 public:
+	recall_list_manager();
+
 	typedef std::vector<unit_ptr >::iterator iterator;
 	typedef std::vector<unit_ptr >::const_iterator const_iterator;
 
@@ -62,6 +66,23 @@ public:
 private:
 	std::vector<unit_ptr > recall_list_; //!< The underlying data struture. TODO: Should this be a map based on underlying id instead?
 
+	size_t index_of_id(const std::string & unit_id) const; //!< Index of the first unit with this id, size() if none.
+	size_t index_of_underlying_id(size_t uid) const; //!< Index of the first unit with this underlying id, size() if none.
+	bool indexes_current() const; //!< Whether ids_ and underlying_ids_ hold for recall_list_.
+	void check_indexes() const; //!< Rebuilds ids_ and underlying_ids_ if they do not hold.
+	iterator erase_at(size_t index); //!< Erase by index, keeping the indexes current.
+
+	/**
+	 * The index in recall_list_ of the first unit with each id and
+	 * underlying id. They hold while indexed_ is set and the
+	 * unit::id_generation() is indexed_generation_, as the units can be
+	 * changed through the iterators.
+	 */
+	mutable boost::unordered_map<std::string, size_t> ids_;
+	mutable boost::unordered_map<size_t, size_t> underlying_ids_;
+	mutable bool indexed_;
+	mutable unsigned indexed_generation_;
+
 	friend class ai::readonly_context_impl; //!< Friend AI module for ease of implementation there.
 };
 
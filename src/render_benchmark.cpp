@@ -0,0 +1,106 @@
+/*
+   Copyright (C) 2015 by the Battle for Wesnoth Project
+   Part of the Battle for Wesnoth Project http://www.wesnoth.org/
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY.
+
+   See the COPYING file for more details.
+*/
+
+#include "global.hpp"
+
+#include "render_benchmark.hpp"
+
+#include "display.hpp"
+#include "events.hpp"
+#include "map.hpp"
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <algorithm>
+#include <iomanip>
+#include <ostream>
+#include <vector>
+
+namespace {
+
+/** The frames of each step of the camera path. */
+const unsigned step_frames = 60;
+
+/** How far the camera moves at each frame, in pixels and zoom steps. */
+const int scroll_speed = 8;
+const int zoom_speed = 2;
+
+boost::posix_time::ptime now()
+{
+	return boost::posix_time::microsec_clock::universal_time();
+}
+
+double percentile(const std::vector<long>& sorted, unsigned percent)
+{
+	return sorted[std::min(sorted.size() - 1, sorted.size() * percent / 100)] / 1000.0;
+}
+
+/** Moves the camera for frame @a frame of the path. */
+void move_camera(display& disp, unsigned frame)
+{
+	const unsigned step = frame / step_frames;
+	const int direction = (step / 4) % 2 == 0 ? 1 : -1;
+
+	switch(step % 4) {
+	case 0:
+		disp.scroll(direction * scroll_speed, 0, true);
+		break;
+	case 1:
+		disp.scroll(0, direction * scroll_speed, true);
+		break;
+	case 2:
+		// Zoom in the first half, back out the second one.
+		disp.set_zoom(frame % step_frames < step_frames / 2 ? zoom_speed : -zoom_speed);
+		break;
+	default:
+		// Only the animations change.
+		break;
+	}
+}
+
+}
+
+void run_render_benchmark(display& disp, unsigned frames, std::ostream& out)
+{
+	const gamemap& map = disp.get_map();
+	disp.scroll_to_tile(map_location(map.w() / 2, map.h() / 2), display::WARP, false, true);
+
+	std::vector<long> times;
+	times.reserve(frames);
+
+	const boost::posix_time::ptime started = now();
+	for(unsigned frame = 0; frame != frames; ++frame) {
+		events::pump();
+		move_camera(disp, frame);
+		disp.invalidate_all();
+
+		const boost::posix_time::ptime start = now();
+		disp.draw(true, true);
+		times.push_back((now() - start).total_microseconds());
+	}
+	const double seconds = (now() - started).total_microseconds() / 1e6;
+
+	out << frames << " frames in " << seconds << " s";
+	if(times.empty()) {
+		out << "\n";
+		return;
+	}
+	std::sort(times.begin(), times.end());
+	out << " (" << frames / seconds << " fps)\n"
+		<< std::fixed << std::setprecision(2)
+		<< "frame time in ms: p50 " << percentile(times, 50)
+		<< ", p90 " << percentile(times, 90)
+		<< ", p99 " << percentile(times, 99)
+		<< ", max " << times.back() / 1000.0 << "\n";
+}
@@ -0,0 +1,38 @@
+/*
+   Copyright (C) 2015 by the Battle for Wesnoth Project
+   Part of the Battle for Wesnoth Project http://www.wesnoth.org/
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY.
+
+   See the COPYING file for more details.
+*/
+
+/**
+ * @file
+ * The rendering benchmark run by --render-benchmark.
+ */
+
+#ifndef RENDER_BENCHMARK_HPP_INCLUDED
+#define RENDER_BENCHMARK_HPP_INCLUDED
+
+#include <iosfwd>
+
+class display;
+
+/**
+ * Draws @a frames frames of @a disp along a fixed camera path and prints
+ * the frame time percentiles to @a out.
+ *
+ * The camera starts at the center of the map, then repeatedly scrolls
+ * right, scrolls down, zooms in and out, and stays still to show only the
+ * animations; odd cycles scroll back left and up. The whole map is
+ * redrawn at every frame, and the frames don't wait for the frame delay.
+ */
+void run_render_benchmark(display& disp, unsigned frames, std::ostream& out);
+
+#endif
@@ -213,9 +213,8 @@ void replay::add_unit_checksum(const map_location& loc,config& cfg)
 void replay::init_side()
 {
 	config& cmd = add_command();
-	config init_side;
+	config& init_side = cmd.add_child("init_side");
 	init_side["side_number"] = resources::controller->current_side();
-	cmd.add_child("init_side", init_side);
 }
 
 void replay::add_start()
@@ -228,10 +227,9 @@ void replay::add_start()
 void replay::add_countdown_update(int value, int team)
 {
 	config& cmd = add_command();
-	config val;
+	config& val = cmd.add_child("countdown_update");
 	val["value"] = value;
 	val["team"] = team;
-	cmd.add_child("countdown_update",val);
 }
 void replay::add_synced_command(const std::string& name, const config& command)
 {
@@ -261,31 +259,25 @@ void replay::add_label(const terrain_label* label)
 {
 	assert(label);
 	config& cmd = add_nonundoable_command();
-	config val;
-
-	label->write(val);
-
-	cmd.add_child("label",val);
+	label->write(cmd.add_child("label"));
 }
 
 void replay::clear_labels(const std::string& team_name, bool force)
 {
 	config& cmd = add_nonundoable_command();
 
-	config val;
+	config& val = cmd.add_child("clear_labels");
 	val["team_name"] = team_name;
 	val["force"] = force;
-	cmd.add_child("clear_labels",val);
 }
 
 void replay::add_rename(const std::string& name, const map_location& loc)
 {
 	config& cmd = add_command();
 	cmd["async"] = true; // Not undoable, but depends on moves/recruits that are
-	config val;
+	config& val = cmd.add_child("rename");
 	loc.write(val);
 	val["name"] = name;
-	cmd.add_child("rename", val);
 }
 
 
@@ -394,13 +386,14 @@ struct async_cmd
 	int num;
 };
 
-void replay::redo(const config& cfg)
+void replay::redo(config& cfg)
 {
 	assert(base_->get_pos() == ncommands());
-	BOOST_FOREACH(const config &cmd, cfg.child_range("command"))
+	BOOST_FOREACH(config &cmd, cfg.child_range("command"))
 	{
-		base_->add_child() = cmd;
+		base_->add_child().swap(cmd);
 	}
+	cfg.clear();
 	base_->set_to_end();
 
 }
@@ -460,29 +453,27 @@ void replay::undo_cut(config& dst)
 	}
 
 	if (cmd < 0) return;
-	//we add the commands that we want to remove later to the passed cfg first.
-	dst.add_child("command", base_->get_command_at(cmd));
-	//we do this in a seperate loop because we don't want to loop forward in the loop while when we remove the elements to keepo the indexes simple.
+	//we move the commands that we want to remove later to the passed cfg first, instead of copying them.
+	config &c = dst.add_child("command");
+	c.swap(base_->get_command_at(cmd));
+	std::vector<int> dependent_cmds;
 	for(int cmd_2 = cmd + 1; cmd_2 < ncommands(); ++cmd_2)
 	{
 		if(command(cmd_2)["dependent"].to_bool(false))
 		{
-			dst.add_child("command", base_->get_command_at(cmd_2));
+			dependent_cmds.push_back(cmd_2);
+			dst.add_child("command").swap(base_->get_command_at(cmd_2));
 		}
 	}
 
 	//we remove dependent commands after the actual removed command that don't make sense if they stand alone especialy user choices and checksum data.
-	for(int cmd_2 = ncommands() - 1; cmd_2 > cmd; --cmd_2)
+	//we do this in a seperate loop, backwards, to keep the indexes simple.
+	for(std::vector<int>::reverse_iterator i = dependent_cmds.rbegin(); i != dependent_cmds.rend(); ++i)
 	{
-		if(command(cmd_2)["dependent"].to_bool(false))
-		{
-			remove_command(cmd_2);
-		}
+		remove_command(*i);
 	}
 
 
-	config &c = command(cmd);
-
 	if (const config &child = c.child("move"))
 	{
 		// A unit's move is being undone.
@@ -555,6 +546,11 @@ int replay::ncommands() const
 	return base_->size();
 }
 
+size_t replay::memory_usage() const
+{
+	return base_->memory_usage();
+}
+
 config& replay::add_command()
 {
 	//if we werent at teh end of teh replay we sould skip one or mutiple commands.
@@ -577,6 +573,16 @@ void replay::start_replay()
 	base_->set_pos(0);
 }
 
+int replay::get_pos() const
+{
+	return base_->get_pos();
+}
+
+void replay::set_pos(int pos)
+{
+	base_->set_pos(pos);
+}
+
 void replay::revert_action()
 {
 
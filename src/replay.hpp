@@ -101,11 +101,15 @@ public:
 	void undo_cut(config& dst);
 	/*
 		puts the given config which was cut with undo_cut back in the replay.
+		the commands are moved out of it, leaving it empty.
 	*/
-	void redo(const config& dst);
+	void redo(config& dst);
 
 	void start_replay();
 	void revert_action();
+	/** The position of the next action, for the keyframes of replay_controller. */
+	int get_pos() const;
+	void set_pos(int pos);
 	config* get_next_action();
 
 	bool at_end() const;
@@ -119,6 +123,9 @@ public:
 
 	int ncommands() const;
 
+	/** The memory used by the commands, see replay_recorder_base::memory_usage(). */
+	size_t memory_usage() const;
+
 	static void process_error(const std::string& msg);
 	/*
 		adds a [start] at the begnning of the replay if there is none.
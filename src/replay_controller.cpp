@@ -31,6 +31,7 @@
 #include "mouse_handler_base.hpp"
 #include "replay.hpp"
 #include "random_new_deterministic.hpp"
+#include "render_benchmark.hpp"
 #include "resources.hpp"
 #include "savegame.hpp"
 #include "saved_game.hpp"
@@ -68,6 +69,11 @@ LEVEL_RESULT play_replay_level(const config& game_config, const tdata_cache & td
 	rc.reset(new replay_controller(state_of_game.get_replay_starting_pos(), state_of_game, ticks, game_config, tdata, video));
 	DBG_NG << "created objects... " << (SDL_GetTicks() - rc->get_ticks()) << std::endl;
 
+	if (game_config::render_benchmark_frames != 0) {
+		run_render_benchmark(*resources::screen, game_config::render_benchmark_frames, std::cout);
+		exit(0);
+	}
+
 	//replay event-loop
 	play_replay_level_main_loop(*rc, is_unit_test);
 	if(rc->is_regular_game_end())
@@ -94,6 +100,25 @@ void play_replay_level_main_loop(replay_controller & replaycontroller, bool & is
 	}
 }
 
+LEVEL_RESULT validate_replay_level(const config& game_config, const tdata_cache & tdata,
+		CVideo& video, saved_game& state_of_game, std::vector<std::string>& oos_errors)
+{
+	const int ticks = SDL_GetTicks();
+	const events::command_disabler disable_commands;
+
+	replay_controller rc(state_of_game.get_replay_starting_pos(), state_of_game, ticks, game_config, tdata, video);
+	rc.validate(oos_errors);
+	return rc.is_regular_game_end() ? VICTORY : QUIT;
+}
+
+void replay_controller::validate(std::vector<std::string>& oos_errors)
+{
+	oos_errors_ = &oos_errors;
+	skip_replay_ = true;
+	try_run_to_completion();
+	oos_errors_ = NULL;
+}
+
 void replay_controller::try_run_to_completion() {
 	for (;;) {
 		play_slice();
@@ -114,9 +139,11 @@ replay_controller::replay_controller(const config& level,
 	: play_controller(level, state_of_game, ticks, game_config, tdata, video, false)
 	, gameboard_start_(gamestate_.board_)
 	, tod_manager_start_(level)
+	, keyframes_()
 	, is_playing_(false)
 	, show_everything_(false)
 	, show_team_(state_of_game.classification().campaign_type == game_classification::MULTIPLAYER ? 0 : 1)
+	, oos_errors_(NULL)
 {
 	hotkey_handler_.reset(new hotkey_handler(*this, saved_game_)); //upgrade hotkey handler to the replay controller version
 
@@ -302,19 +329,63 @@ void replay_controller::reset_replay_ui()
 }
 
 
+replay_controller::keyframe::keyframe(const config& snapshot, const game_board& board, const tod_manager& tod)
+	: snapshot(snapshot)
+	, board(board)
+	, tod(tod)
+	, stats(statistics::write_stats())
+	, recorder_pos(resources::recorder->get_pos())
+{
+}
+
 void replay_controller::reset_replay()
 {
 	DBG_REPLAY << "replay_controller::reset_replay\n";
 
-	gui_->get_chat_manager().clear_chat_messages();
-	is_playing_ = false;
 	player_number_ = level_["playing_team"].to_int() + 1;
 	it_is_a_new_turn_ = level_["it_is_a_new_turn"].to_bool(true);
 	init_side_done_ = level_["init_side_done"].to_bool(false);
-	skip_replay_ = false;
-	gamestate_.tod_manager_= tod_manager_start_;
+	loading_game_ = !level_["playing_team"].empty();
 	resources::recorder->start_replay();
-	gamestate_.board_ = gameboard_start_;
+	statistics::fresh_stats();
+
+	restore(level_, gameboard_start_, tod_manager_start_);
+}
+
+void replay_controller::add_keyframe()
+{
+	// (Validating never seeks back.)
+	if (oos_errors_ || keyframes_.count(turn()) != 0) {
+		return;
+	}
+	DBG_REPLAY << "keyframe of turn " << turn() << "\n";
+	keyframes_[turn()].reset(new keyframe(to_config(), gamestate_.board_, gamestate_.tod_manager_));
+}
+
+void replay_controller::restore_keyframe(const keyframe& kf)
+{
+	DBG_REPLAY << "replay_controller::restore_keyframe\n";
+
+	// As at the end of the last side of the previous turn.
+	player_number_ = 1;
+	it_is_a_new_turn_ = true;
+	init_side_done_ = false;
+	last_replay_action = REPLAY_FOUND_END_TURN;
+	// Continued as a game loaded from a save.
+	loading_game_ = true;
+	resources::recorder->set_pos(kf.recorder_pos);
+	statistics::read_stats(kf.stats);
+
+	restore(kf.snapshot, kf.board, kf.tod);
+}
+
+void replay_controller::restore(const config& level, const game_board& board, const tod_manager& tod)
+{
+	gui_->get_chat_manager().clear_chat_messages();
+	is_playing_ = false;
+	skip_replay_ = false;
+	gamestate_.tod_manager_= tod;
+	gamestate_.board_ = board;
 	gui_->change_display_context(&gamestate_.board_); //this doesn't change the pointer value, but it triggers the gui to update the internal terrain builder object,
 						   //idk what the consequences of not doing that are, but its probably a good idea to do it, esp. if layout
 						   //of game_board changes in the future
@@ -333,18 +404,17 @@ void replay_controller::reset_replay()
 	resources::game_events=NULL;
 	gamestate_.lua_kernel_.reset();
 	resources::lua_kernel=NULL;
-	gamestate_.lua_kernel_.reset(new game_lua_kernel(level_, &gui_->video(), gamestate_, *this, *gamestate_.reports_));
+	gamestate_.lua_kernel_.reset(new game_lua_kernel(level, &gui_->video(), gamestate_, *this, *gamestate_.reports_));
 	gamestate_.lua_kernel_->set_game_display(gui_.get());
 	resources::lua_kernel=gamestate_.lua_kernel_.get();
 	gamestate_.game_events_resources_->lua_kernel = resources::lua_kernel;
-	gamestate_.events_manager_.reset(new game_events::manager(level_, gamestate_.game_events_resources_));
+	gamestate_.events_manager_.reset(new game_events::manager(level, gamestate_.game_events_resources_));
 	resources::game_events=gamestate_.events_manager_.get();
 
-	gui_->labels().read(level_);
+	gui_->labels().read(level);
 
-	*resources::gamedata = game_data(level_);
-	n_unit::id_manager::instance().set_save_id(level_["next_underlying_unit_id"]);
-	statistics::fresh_stats();
+	*resources::gamedata = game_data(level);
+	n_unit::id_manager::instance().set_save_id(level["next_underlying_unit_id"]);
 
 	gui_->needs_rebuild(true);
 	gui_->maybe_rebuild();
@@ -375,6 +445,49 @@ void replay_controller::replay_next_turn()
 	replay_ui_playback_should_stop();
 }
 
+void replay_controller::replay_previous_turn()
+{
+	const keyframe_map::const_iterator kf = keyframes_.find(turn());
+	const bool at_turn_start = kf != keyframes_.end()
+		&& kf->second->recorder_pos == resources::recorder->get_pos();
+	seek_turn(at_turn_start ? turn() - 1 : turn());
+}
+
+void replay_controller::seek_turn(int turn)
+{
+	DBG_REPLAY << "replay_controller::seek_turn " << turn << "\n";
+
+	// The latest keyframe not after turn.
+	keyframe_map::const_iterator kf = keyframes_.upper_bound(turn);
+	const bool has_keyframe = kf != keyframes_.begin();
+	if (has_keyframe) {
+		--kf;
+	}
+
+	// Playing on is faster than restoring, if the keyframe isn't later.
+	if (has_keyframe && (kf->first > this->turn() || turn < this->turn()
+			|| (turn == this->turn() && kf->second->recorder_pos < resources::recorder->get_pos()))) {
+		restore_keyframe(*kf->second);
+	} else if (!has_keyframe && turn <= this->turn()) {
+		reset_replay();
+	}
+
+	// Play the remaining turns without animating them.
+	is_playing_ = true;
+	replay_ui_playback_should_start();
+	const bool skipping = skip_replay_;
+	skip_replay_ = true;
+	while (this->turn() < turn && !resources::recorder->at_end() && is_playing_) {
+		play_turn();
+	}
+	skip_replay_ = skipping;
+	is_playing_ = false;
+
+	gui_->scroll_to_leader(player_number_, game_display::ONSCREEN, false);
+	replay_ui_playback_should_stop();
+	update_gui();
+}
+
 void replay_controller::replay_next_move_or_side(bool one_move)
 {
 	is_playing_ = true;
@@ -405,6 +518,10 @@ void replay_controller::replay_next_move()
 
 void replay_controller::process_oos(const std::string& msg) const
 {
+	if (oos_errors_) {
+		oos_errors_->push_back(msg);
+		return;
+	}
 	if (game_config::ignore_replay_errors) {
 		return;
 	}
@@ -544,6 +661,7 @@ void replay_controller::play_move_or_side(bool one_move) {
 		it_is_a_new_turn_ = true;
 		player_number_ = 1;
 		gui_->new_turn();
+		add_keyframe();
 	}
 
 	// This is necessary for replays in order to show possible movements.
@@ -21,6 +21,9 @@
 #include "saved_game.hpp"
 #include "play_controller.hpp"
 
+#include <boost/shared_ptr.hpp>
+
+#include <map>
 #include <vector>
 
 class video;
@@ -37,6 +40,13 @@ public:
 	void stop_replay();
 	void replay_next_move_or_side(bool one_move);
 	void replay_next_turn();
+	/** Goes back to the start of the turn, or of the previous one if already there. */
+	void replay_previous_turn();
+	/**
+	 * Goes to the start of turn @a turn, from the latest keyframe not
+	 * after it, or from the start of the replay.
+	 */
+	void seek_turn(int turn);
 	void replay_next_side();
 	void replay_next_move();
 	void process_oos(const std::string& msg) const;
@@ -51,6 +61,13 @@ public:
 
 	void try_run_to_completion();
 
+	/**
+	 * Runs the replay to its end as fast as possible, without animating
+	 * it or taking keyframes, appending the out of sync errors to
+	 * @a oos_errors rather than stopping at the first one.
+	 */
+	void validate(std::vector<std::string>& oos_errors);
+
 	bool recorder_at_end();
 
 	class hotkey_handler;
@@ -61,6 +78,8 @@ protected:
 
 private:
 	void init();
+	/** Restarts the game from @a level, @a board and @a tod. */
+	void restore(const config& level, const game_board& board, const tod_manager& tod);
 	void play_turn();
 	void play_move_or_side(bool one_move = false);
 	void play_side();
@@ -92,16 +111,47 @@ private:
 	}
 	game_board gameboard_start_;
 	tod_manager tod_manager_start_;
+
+	/**
+	 * The state at the start of a turn, taken when the replay first
+	 * reaches it, so that seek_turn() restarts from there rather than
+	 * from the start of the replay.
+	 */
+	struct keyframe
+	{
+		keyframe(const config& snapshot, const game_board& board, const tod_manager& tod);
+
+		/** As in a save: the variables, events, Lua data, labels and ids. */
+		config snapshot;
+		game_board board;
+		tod_manager tod;
+		config stats;
+		int recorder_pos;
+	};
+	typedef std::map<int, boost::shared_ptr<keyframe> > keyframe_map;
+	keyframe_map keyframes_;
+	void add_keyframe();
+	void restore_keyframe(const keyframe& kf);
 	unsigned int last_replay_action;
 
 	bool is_playing_;
 
 	bool show_everything_;
 	unsigned int show_team_;
+
+	/** Where validate() collects the out of sync errors, NULL otherwise. */
+	std::vector<std::string>* oos_errors_;
 };
 
 
 LEVEL_RESULT play_replay_level(const config& game_config, const tdata_cache & tdata, CVideo& video,
 		saved_game& state_of_game, bool is_unit_test = false);
 
+/**
+ * Plays the replay of @a state_of_game as replay_controller::validate() does.
+ * Returns VICTORY if the replay reaches the end of the scenario, QUIT otherwise.
+ */
+LEVEL_RESULT validate_replay_level(const config& game_config, const tdata_cache & tdata, CVideo& video,
+		saved_game& state_of_game, std::vector<std::string>& oos_errors);
+
 #endif
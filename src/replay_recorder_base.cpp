@@ -1,13 +1,20 @@
 
 #include "replay_recorder_base.hpp"
+#include "packed_command.hpp"
 #include "serialization/binary_or_text.hpp"
 
 #include <boost/foreach.hpp>
 
+#include <sstream>
+
 replay_recorder_base::replay_recorder_base(void)
 	: upload_log_()
 	, commands_()
+	, packed_()
 	, pos_(0)
+	, written_()
+	, written_ends_()
+	, written_level_(0)
 {
 
 }
@@ -21,8 +28,12 @@ replay_recorder_base::~replay_recorder_base(void)
 void replay_recorder_base::swap(replay_recorder_base& other)
 {
 	commands_.swap(other.commands_);
+	packed_.swap(other.packed_);
 	std::swap(pos_, other.pos_);
 	upload_log_.swap(other.upload_log_);
+	written_.swap(other.written_);
+	written_ends_.swap(other.written_ends_);
+	std::swap(written_level_, other.written_level_);
 }
 
 int replay_recorder_base::get_pos() const
@@ -35,16 +46,53 @@ int replay_recorder_base::size() const
 	return commands_.size();
 }
 
+size_t replay_recorder_base::memory_usage() const
+{
+	size_t res = upload_log_.memory_usage()
+		+ commands_.capacity() * sizeof(config*)
+		+ packed_.capacity() * sizeof(std::string)
+		+ written_.capacity() + written_ends_.capacity() * sizeof(size_t);
+	for(size_t i = 0; i != commands_.size(); ++i) {
+		if(!commands_.is_null(i)) {
+			res += commands_[i].memory_usage();
+		}
+	}
+	BOOST_FOREACH(const std::string& packed, packed_) {
+		res += packed.capacity();
+	}
+	return res;
+}
+
 config& replay_recorder_base::get_command_at(int pos)
 {
 	assert(pos < size());
+	forget_written(pos);
+	if(commands_.is_null(pos))
+	{
+		config* command = new config();
+		unpack_command(packed_[pos], *command);
+		commands_.replace(pos, command);
+		std::string().swap(packed_[pos]);
+	}
 	return commands_[pos];
 }
 
+const config& replay_recorder_base::peek_command(int index, config& unpacked) const
+{
+	if(commands_.is_null(index))
+	{
+		unpack_command(packed_[index], unpacked);
+		return unpacked;
+	}
+	return commands_[index];
+}
+
 config& replay_recorder_base::add_child()
 {
 	assert(pos_ <= size());
+	forget_written(pos_);
 	commands_.insert(commands_.begin() + pos_, new config());
+	packed_.insert(packed_.begin() + pos_, std::string());
 	++pos_;
 	return commands_[pos_ - 1];
 }
@@ -65,7 +113,9 @@ config& replay_recorder_base::get_upload_log()
 void replay_recorder_base::remove_command(int index)
 {
 	assert(index < size());
+	forget_written(index);
 	commands_.erase(commands_.begin() + index);
+	packed_.erase(packed_.begin() + index);
 	if(index < pos_)
 	{
 		--pos_;
@@ -75,10 +125,12 @@ void replay_recorder_base::remove_command(int index)
 config& replay_recorder_base::insert_command(int index)
 {
 	assert(index <= size());
+	forget_written(index);
 	if(index < pos_)
 	{
 		++pos_;
 	}
+	packed_.insert(packed_.begin() + index, std::string());
 	return *commands_.insert(commands_.begin() + index, new config());
 }
 
@@ -91,7 +143,9 @@ void replay_recorder_base::append_config(const config& data)
 	}
 	BOOST_FOREACH(const config& command, data.child_range("command"))
 	{
-		commands_.push_back(new config(command));
+		packed_.push_back(std::string());
+		pack_command(command, packed_.back());
+		commands_.push_back(static_cast<config*>(NULL));
 	}
 }
 
@@ -103,18 +157,45 @@ void replay_recorder_base::append_config(config& data)
 	}
 	BOOST_FOREACH(config& command, data.child_range("command"))
 	{
-		config* new_config = new config();
-		new_config->swap(command);
-		commands_.push_back(new_config);
+		packed_.push_back(std::string());
+		pack_command(command, packed_.back());
+		commands_.push_back(static_cast<config*>(NULL));
+		command.clear();
 	}
 }
 
 void replay_recorder_base::write(config_writer& out) const
 {
 	out.write_child("upload_log", upload_log_);
-	for(int i = 0; i < pos_; ++i)
+
+	// The text kept is only right at the same indentation.
+	if(out.level() != written_level_)
+	{
+		forget_written(0);
+		written_level_ = out.level();
+	}
+	// Only the commands before pos_ are written.
+	forget_written(pos_);
+
+	std::ostringstream added;
+	config unpacked;
+	for(int i = written_ends_.size(); i < pos_; ++i)
+	{
+		write_open_child(added, "command", written_level_);
+		::write(added, peek_command(i, unpacked), written_level_ + 1);
+		write_close_child(added, "command", written_level_);
+		written_ends_.push_back(written_.size() + static_cast<size_t>(added.tellp()));
+	}
+	written_ += added.str();
+	out.write_serialized(written_);
+}
+
+void replay_recorder_base::forget_written(int index) const
+{
+	if(index < static_cast<int>(written_ends_.size()))
 	{
-		out.write_child("command", commands_[i]);
+		written_ends_.resize(index);
+		written_.resize(index == 0 ? 0 : written_ends_.back());
 	}
 }
 
@@ -123,6 +204,13 @@ void replay_recorder_base::write(config& out) const
 	out.add_child("upload_log", upload_log_);
 	for(int i = 0; i < pos_; ++i)
 	{
-		out.add_child("command", commands_[i]);
+		if(commands_.is_null(i))
+		{
+			unpack_command(packed_[i], out.add_child("command"));
+		}
+		else
+		{
+			out.add_child("command", commands_[i]);
+		}
 	}
 }
@@ -1,10 +1,27 @@
 #pragma once
 #include <cassert>
+#include <boost/ptr_container/nullable.hpp>
 #include <boost/ptr_container/ptr_vector.hpp>
 
 #include "config.hpp"
 
+#include <string>
+#include <vector>
+
 class config_writer;
+
+/**
+ * The commands of a replay.
+ *
+ * The saves write all the commands, which are mostly the same from one
+ * save to the next. The text of the commands written is therefore kept,
+ * and only the commands added since are serialized again. The commands
+ * given out by get_command_at() or moved by the other functions are
+ * serialized again, from the first of them on.
+ *
+ * The commands appended from a save or the server are kept packed (see
+ * packed_command.hpp) until asked for, most of them never being.
+ */
 class replay_recorder_base
 {
 public:
@@ -16,6 +33,9 @@ public:
 
 	int size() const;
 
+	/** An estimate of the memory used by the commands, packed or not, and their text. */
+	size_t memory_usage() const;
+
 	config& get_command_at(int pos);
 
 	config& add_child();
@@ -38,7 +58,21 @@ public:
 
 	void write(config& out) const;
 protected:
+	/** Forgets the text of the commands from @a index on. */
+	void forget_written(int index) const;
+
+	/** The command at @a index, unpacked into @a unpacked if needed. */
+	const config& peek_command(int index, config& unpacked) const;
+
 	config upload_log_;
-	boost::ptr_vector<config> commands_;
+	/** The commands, NULL for those still packed in packed_. */
+	boost::ptr_vector<boost::nullable<config> > commands_;
+	std::vector<std::string> packed_;
 	int pos_;
+
+	/** The text of the first commands, as written at written_level_. */
+	mutable std::string written_;
+	/** Where the text of each of these commands ends in written_. */
+	mutable std::vector<size_t> written_ends_;
+	mutable unsigned int written_level_;
 };
@@ -27,10 +27,15 @@
 #include "log.hpp"
 #include "serialization/binary_or_text.hpp"
 #include "serialization/parser.hpp"
+#include "thread.hpp"
 
 #include "filesystem.hpp"
 #include "config.hpp"
 #include <boost/foreach.hpp>
+#include <boost/noncopyable.hpp>
+
+#include <deque>
+#include <set>
 
 static lg::log_domain log_engine("engine");
 #define LOG_SAVE LOG_STREAM(info, log_engine)
@@ -49,6 +54,179 @@ void replace_space2underbar(std::string &name) {
 namespace savegame {
 
 void extract_summary_from_config(config &, config &);
+static void read_save_summary_source(const std::string& name, config& cfg, std::string* error_log);
+
+/**
+ * Reads the saves queued by save_index_class::prefetch() on a background
+ * thread.
+ *
+ * The worker only parses the saves with the summary reader; extracting the
+ * summary, which looks up the binary paths, happens on the main thread when
+ * the save is taken. The parts of a save that couldn't be read are kept as
+ * an empty config.
+ */
+class summary_loader : private boost::noncopyable
+{
+public:
+	/** The name of a save and its modification time when queued. */
+	typedef std::pair<std::string, time_t> request_type;
+	typedef std::map<std::string, std::pair<time_t, config> > loaded_map;
+
+	summary_loader()
+		: mutex_(), work_(), done_(), queue_(), requested_(), loading_()
+		, loaded_(), stop_(false), worker_()
+	{
+		worker_.reset(new threading::thread(run, this));
+	}
+
+	~summary_loader()
+	{
+		{
+			const threading::lock lock(mutex_);
+			stop_ = true;
+			work_.notify_all();
+		}
+		// Joins the worker, once it has finished its current save.
+		worker_.reset();
+	}
+
+	/** Queues the saves of @a requests which aren't already. */
+	void request(const std::vector<request_type>& requests)
+	{
+		const threading::lock lock(mutex_);
+		BOOST_FOREACH(const request_type& req, requests) {
+			if(!loaded_.count(req.first) && requested_.insert(req.first).second) {
+				queue_.push_back(req);
+			}
+		}
+		work_.notify_one();
+	}
+
+	/**
+	 * Takes the save @a name, waiting for it if the worker is reading it.
+	 * Returns false, and cancels the request if it wasn't started, when the
+	 * save isn't read: the caller reads it itself.
+	 */
+	bool take(const std::string& name, time_t& modified, config& source)
+	{
+		const threading::lock lock(mutex_);
+		while(!loading_.empty() && loading_ == name) {
+			done_.wait(mutex_);
+		}
+		const loaded_map::iterator i = loaded_.find(name);
+		if(i != loaded_.end()) {
+			modified = i->second.first;
+			source.swap(i->second.second);
+			loaded_.erase(i);
+			return true;
+		}
+		if(requested_.erase(name)) {
+			for(std::deque<request_type>::iterator r = queue_.begin(); r != queue_.end(); ++r) {
+				if(r->first == name) {
+					queue_.erase(r);
+					break;
+				}
+			}
+		}
+		return false;
+	}
+
+	/** Takes all the saves read so far. */
+	void take_all(loaded_map& loaded)
+	{
+		const threading::lock lock(mutex_);
+		loaded.swap(loaded_);
+		loaded_.clear();
+	}
+
+private:
+	static int run(void* data)
+	{
+		summary_loader& self = *static_cast<summary_loader*>(data);
+		request_type req;
+		while(self.next(req)) {
+			config source;
+			bool read = true;
+			try {
+				read_save_summary_source(req.first, source, NULL);
+			} catch(game::load_game_failed&) {
+				source.clear();
+			} catch(...) {
+				// Let the main thread read it again and see the error.
+				read = false;
+			}
+			self.finish(req, read ? &source : NULL);
+		}
+		return 0;
+	}
+
+	/** Waits for a save to read, false when stopping. */
+	bool next(request_type& req)
+	{
+		const threading::lock lock(mutex_);
+		while(queue_.empty() && !stop_) {
+			work_.wait(mutex_);
+		}
+		if(stop_) {
+			return false;
+		}
+		req = queue_.front();
+		queue_.pop_front();
+		loading_ = req.first;
+		return true;
+	}
+
+	void finish(const request_type& req, config* source)
+	{
+		const threading::lock lock(mutex_);
+		loading_.clear();
+		requested_.erase(req.first);
+		if(source) {
+			std::pair<time_t, config>& res = loaded_[req.first];
+			res.first = req.second;
+			res.second.swap(*source);
+		}
+		done_.notify_all();
+	}
+
+	threading::mutex mutex_;
+	/** Signals requests to the worker, and its results to take(). */
+	threading::condition work_, done_;
+
+	std::deque<request_type> queue_;
+	/** The saves queued or being read. */
+	std::set<std::string> requested_;
+	std::string loading_;
+	loaded_map loaded_;
+	bool stop_;
+
+	boost::scoped_ptr<threading::thread> worker_;
+};
+
+namespace {
+
+/** Once this many changes are in the journal, the whole index is written instead. */
+const size_t max_journal_entries = 64;
+
+std::string get_save_index_journal_file()
+{
+	return filesystem::get_save_index_file() + ".journal";
+}
+
+/** Removes the summary of the save @a name from the index @a index. */
+void remove_summary(config& index, const std::string& name)
+{
+	int i = 0;
+	BOOST_FOREACH(const config& summary, index.child_range("save")) {
+		if(summary["save"] == name) {
+			index.remove_child("save", i);
+			return;
+		}
+		++i;
+	}
+}
+
+} // end anonymous namespace
 
 void save_index_class::rebuild(const std::string& name) {
 	std::string filename = name;
@@ -59,23 +237,39 @@ void save_index_class::rebuild(const std::string& name) {
 
 void save_index_class::rebuild(const std::string& name, const time_t& modified) {
 	log_scope("load_summary_from_file");
-	config& summary = data(name);
+	config full;
+	bool corrupt = false;
 	try {
-		config full;
 		std::string dummy;
-		read_save_file(name, full, &dummy);
-		extract_summary_from_config(full, summary);
+		read_save_summary_source(name, full, &dummy);
 	} catch(game::load_game_failed&) {
+		corrupt = true;
+	}
+	store_summary(name, modified, corrupt ? NULL : &full);
+	journal_summary(name);
+}
+
+void save_index_class::store_summary(const std::string& name, const time_t& modified, config* source) {
+	config& summary = data(name);
+	if(source) {
+		extract_summary_from_config(*source, summary);
+	} else {
 		summary["corrupt"] = true;
-		}
+	}
 	summary["mod_time"] = str_cast(static_cast<int>(modified));
-	write_save_index();
 }
 
 void save_index_class::remove(const std::string& name) {
-	config& root = data();
-	root.remove_attribute(name);
-	write_save_index();
+	if(loader_) {
+		time_t modified;
+		config dummy;
+		loader_->take(name, modified, dummy);
+	}
+	modified_.erase(name);
+	remove_summary(data(), name);
+	config entry;
+	entry.add_child("remove")["save"] = name;
+	write_journal_entry(entry);
 }
 
 void save_index_class::set_modified(const std::string& name, const time_t& modified) {
@@ -87,30 +281,186 @@ config& save_index_class::get(const std::string& name) {
 	time_t m = modified_[name];
 	config::attribute_value& mod_time = result["mod_time"];
 	if (mod_time.empty() || static_cast<time_t>(mod_time.to_int()) != m) {
-		rebuild(name, m);
+		time_t prefetched;
+		config source;
+		if(loader_ && loader_->take(name, prefetched, source) && prefetched == m) {
+			store_summary(name, m, source.empty() ? NULL : &source);
+			journal_summary(name);
+		} else {
+			rebuild(name, m);
+		}
 	}
 	return result;
 }
 
+bool save_index_class::is_indexed(const std::string& name) {
+	const config& summary = data().find_child("save", "save", name);
+	if(!summary) {
+		return false;
+	}
+	const std::map<std::string, time_t>::const_iterator m = modified_.find(name);
+	const config::attribute_value& mod_time = summary["mod_time"];
+	return m != modified_.end() && !mod_time.empty()
+		&& static_cast<time_t>(mod_time.to_int()) == m->second;
+}
+
+void save_index_class::prefetch(const std::vector<save_info>& games) {
+	std::vector<summary_loader::request_type> requests;
+	BOOST_FOREACH(const save_info& game, games) {
+		if(!is_indexed(game.name())) {
+			requests.push_back(std::make_pair(game.name(), game.modified()));
+		}
+	}
+	if(requests.empty()) {
+		return;
+	}
+	if(!loader_) {
+		loader_.reset(new summary_loader());
+	}
+	loader_->request(requests);
+}
+
+void save_index_class::collect_prefetched() {
+	if(!loader_) {
+		return;
+	}
+	summary_loader::loaded_map loaded;
+	loader_->take_all(loaded);
+	BOOST_FOREACH(summary_loader::loaded_map::value_type& save, loaded) {
+		// The save might have been overwritten, or deleted, meanwhile.
+		const std::map<std::string, time_t>::const_iterator m = modified_.find(save.first);
+		if(m == modified_.end() || m->second != save.second.first) {
+			continue;
+		}
+		config& source = save.second.second;
+		store_summary(save.first, m->second, source.empty() ? NULL : &source);
+		prefetched_unwritten_ = true;
+	}
+}
+
+void save_index_class::stop_prefetch() {
+	if(!loader_) {
+		return;
+	}
+	collect_prefetched();
+	loader_.reset();
+	if(prefetched_unwritten_) {
+		write_save_index();
+	}
+}
+
 void save_index_class::write_save_index() {
 	log_scope("write_save_index()");
+	prefetched_unwritten_ = false;
+	// Written aside and moved over the index, so that a crash meanwhile
+	// leaves the previous index and its journal.
+	const std::string index_file = filesystem::get_save_index_file();
+	const std::string new_file = index_file + ".new";
 	try {
-		filesystem::scoped_ostream stream = filesystem::ostream_file(filesystem::get_save_index_file());
-		if (preferences::save_compression_format() != compression::NONE) {
-			// TODO: maybe allow writing this using bz2 too?
-			write_gz(*stream, data());
-		} else {
-			write(*stream, data());
+		{
+			filesystem::scoped_ostream stream = filesystem::ostream_file(new_file);
+			if (preferences::save_compression_format() != compression::NONE) {
+				// TODO: maybe allow writing this using bz2 too?
+				write_gz(*stream, data());
+			} else {
+				write(*stream, data());
+			}
+			stream->flush();
+			if(!stream->good()) {
+				throw filesystem::io_exception("could not write " + new_file);
+			}
+		}
+		if(!filesystem::rename_file(new_file, index_file)) {
+			throw filesystem::io_exception("could not replace " + index_file);
 		}
 	} catch(filesystem::io_exception& e) {
 		ERR_SAVE << "error writing to save index file: '" << e.what() << "'" << std::endl;
+		return;
+	}
+	filesystem::delete_file(get_save_index_journal_file());
+	journal_entries_ = 0;
+}
+
+void save_index_class::write_journal_entry(const config& entry) {
+	if(journal_entries_ >= max_journal_entries) {
+		write_save_index();
+		return;
+	}
+	const std::string file = get_save_index_journal_file();
+	try {
+		filesystem::scoped_ostream stream = filesystem::ostream_file(file, filesystem::file_exists(file));
+		write(*stream, entry);
+		stream->flush();
+		if(!stream->good()) {
+			throw filesystem::io_exception("could not write " + file);
+		}
+	} catch(filesystem::io_exception& e) {
+		ERR_SAVE << "error writing to save index journal: '" << e.what() << "'" << std::endl;
+		write_save_index();
+		return;
+	}
+	++journal_entries_;
+}
+
+void save_index_class::journal_summary(const std::string& name) {
+	config entry;
+	entry.add_child("save", data(name));
+	write_journal_entry(entry);
+}
+
+void save_index_class::read_journal() {
+	const std::string file = get_save_index_journal_file();
+	if(!filesystem::file_exists(file)) {
+		return;
+	}
+	std::string journal;
+	try {
+		journal = filesystem::read_file(file);
+	} catch(filesystem::io_exception& e) {
+		ERR_SAVE << "error reading save index journal: '" << e.what() << "'" << std::endl;
+		return;
+	}
+
+	// The closing tags of the entries are the only ones without indentation;
+	// an entry cut short by a crash has none, and is dropped.
+	std::string::size_type entry_begin = 0, line_begin = 0;
+	for(std::string::size_type line_end; (line_end = journal.find('\n', line_begin)) != std::string::npos; ) {
+		const std::string line = journal.substr(line_begin, line_end - line_begin);
+		line_begin = line_end + 1;
+		if(line != "[/save]" && line != "[/remove]") {
+			continue;
+		}
+
+		config entry;
+		try {
+			read(entry, journal.substr(entry_begin, line_begin - entry_begin));
+		} catch(config::error& e) {
+			ERR_SAVE << "error parsing save index journal entry:\n" << e.message << std::endl;
+		}
+		entry_begin = line_begin;
+		++journal_entries_;
+
+		BOOST_FOREACH(const config& summary, entry.child_range("save")) {
+			remove_summary(data_, summary["save"]);
+			data_.add_child("save", summary);
+		}
+		BOOST_FOREACH(const config& removed, entry.child_range("remove")) {
+			remove_summary(data_, removed["save"]);
+		}
 	}
 }
 
 save_index_class::save_index_class()
 	: loaded_(false)
 	, data_()
+	, journal_entries_(0)
 	, modified_()
+	, loader_()
+	, prefetched_unwritten_(false)
+{
+}
+
+save_index_class::~save_index_class()
 {
 }
 
@@ -140,6 +490,7 @@ config& save_index_class::data() {
 			ERR_SAVE << "error parsing save index config file:\n" << e.message << std::endl;
 			data_.clear();
 		}
+		read_journal();
 		loaded_ = true;
 	}
 	return data_;
@@ -230,10 +581,10 @@ bool save_info_less_time::operator() (const save_info& a, const save_info& b) co
 
 static std::istream* find_save_file(const std::string &name, const std::string &alt_name, const std::vector<std::string> &suffixes) {
 	BOOST_FOREACH(const std::string &suf, suffixes) {
-		std::istream *file_stream = filesystem::istream_file(filesystem::get_saves_dir() + "/" + name + suf);
+		std::istream *file_stream = filesystem::istream_mapped_file(filesystem::get_saves_dir() + "/" + name + suf);
 		if (file_stream->fail()) {
 			delete file_stream;
-			file_stream = filesystem::istream_file(filesystem::get_saves_dir() + "/" + alt_name + suf);
+			file_stream = filesystem::istream_mapped_file(filesystem::get_saves_dir() + "/" + alt_name + suf);
 		}
 		if (!file_stream->fail())
 			return file_stream;
@@ -244,7 +595,115 @@ static std::istream* find_save_file(const std::string &name, const std::string &
 	throw game::load_game_failed();
 }
 
-void read_save_file(const std::string& name, config& cfg, std::string* error_log)
+namespace {
+
+/**
+ * Keeps the parts of a save that extract_summary_from_config() looks at:
+ * the toplevel attributes, the sides of the starting and current states
+ * and their units, but not what is inside the units, nor the replay
+ * commands, variables or statistics, which make most of a save.
+ */
+class summary_source_reader : public wml_event_handler
+{
+public:
+	explicit summary_source_reader(config& cfg)
+		: stack_(1, frame(&cfg, ""))
+	{
+	}
+
+	bool open_tag(const std::string& tag, bool append)
+	{
+		const frame& parent = stack_.back();
+		bool keep = false;
+		switch(stack_.size()) {
+		case 1:
+			keep = tag == "snapshot" || tag == "replay_start" || tag == "scenario"
+				|| tag == "replay" || tag == "carryover_sides_start";
+			break;
+		case 2:
+			if(parent.tag == "replay") {
+				// Only whether the replay is empty matters.
+				if(!parent.cfg->has_child(tag)) {
+					parent.cfg->add_child(tag);
+				}
+			} else {
+				keep = tag == "side" && parent.tag != "carryover_sides_start";
+			}
+			break;
+		case 3:
+			keep = tag == "unit";
+			break;
+		}
+		if(!keep) {
+			return false;
+		}
+
+		config* child = append ? &parent.cfg->child(tag, -1) : NULL;
+		if(child == NULL || !*child) {
+			child = &parent.cfg->add_child(tag);
+		}
+		stack_.push_back(frame(child, tag));
+		return true;
+	}
+
+	void close_tag(const std::string&)
+	{
+		stack_.pop_back();
+	}
+
+	void attribute(const std::string& key, const config::attribute_value& value)
+	{
+		(*stack_.back().cfg)[key] = value;
+	}
+
+private:
+	struct frame
+	{
+		frame(config* c, const std::string& t) : cfg(c), tag(t) {}
+		config* cfg;
+		std::string tag;
+	};
+	std::vector<frame> stack_;
+};
+
+/*
+ * The compression is found from the contents, since the file opened might
+ * have a .gz or .bz2 suffix the name does not have, or be named after
+ * another format than the one it was written in.
+ */
+void read_save_stream(config& cfg, std::istream& in)
+{
+	switch(compression::detect_format(in)) {
+	case compression::GZIP:
+		read_gz(cfg, in);
+		break;
+	case compression::BZIP2:
+		read_bz2(cfg, in);
+		break;
+	case compression::NONE:
+		read(cfg, in);
+		break;
+	}
+}
+
+void read_save_stream(wml_event_handler& handler, std::istream& in)
+{
+	switch(compression::detect_format(in)) {
+	case compression::GZIP:
+		read_events_gz(handler, in);
+		break;
+	case compression::BZIP2:
+		read_events_bz2(handler, in);
+		break;
+	case compression::NONE:
+		read_events(handler, in);
+		break;
+	}
+}
+
+/** Reads the save @a name into @a target, a config or a wml_event_handler. */
+template <typename Target>
+void read_save_data(const std::string& name, Target& target, std::string* error_log)
 {
 	std::string modified_name = name;
 	replace_space2underbar(modified_name);
@@ -252,19 +711,8 @@ void read_save_file(const std::string& name, config& cfg, std::string* error_log
 	static const std::vector<std::string> suffixes = boost::assign::list_of("")(".gz")(".bz2");
 	filesystem::scoped_istream file_stream = find_save_file(modified_name, name, suffixes);
 
-	cfg.clear();
 	try{
-		/*
-		 * Test the modified name, since it might use a .gz
-		 * file even when not requested.
-		 */
-		if(filesystem::is_gzip_file(modified_name)) {
-			read_gz(cfg, *file_stream);
-		} else if(filesystem::is_bzip2_file(modified_name)) {
-			read_bz2(cfg, *file_stream);
-		} else {
-			read(cfg, *file_stream);
-		}
+		read_save_stream(target, *file_stream);
 	} catch(const std::ios_base::failure& e) {
 		LOG_SAVE << e.what();
 		if(error_log) {
@@ -278,6 +726,27 @@ void read_save_file(const std::string& name, config& cfg, std::string* error_log
 		}
 		throw game::load_game_failed();
 	}
+}
+
+}
+
+/** Same as read_save_file(), but only keeps what the summary needs. */
+static void read_save_summary_source(const std::string& name, config& cfg, std::string* error_log)
+{
+	cfg.clear();
+	summary_source_reader reader(cfg);
+	read_save_data(name, reader, error_log);
+
+	if(cfg.empty()) {
+		LOG_SAVE << "Could not parse file data into config\n";
+		throw game::load_game_failed();
+	}
+}
+
+void read_save_file(const std::string& name, config& cfg, std::string* error_log)
+{
+	cfg.clear();
+	read_save_data(name, cfg, error_log);
 
 	if(cfg.empty()) {
 		LOG_SAVE << "Could not parse file data into config\n";
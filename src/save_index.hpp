@@ -19,12 +19,16 @@
 #include "config.hpp"
 #include "serialization/compression.hpp"
 
+#include <boost/scoped_ptr.hpp>
+
 class config_writer;
 class game_display;
 
 
 namespace savegame {
 
+class summary_loader;
+
 /** Filename and modification date for a file list */
 class save_info {
 private:
@@ -83,17 +87,69 @@ public:
 	void set_modified(const std::string& name, const time_t& modified) ;
 	config& get(const std::string& name) ;
 public:
+	/**
+	 * Writes the whole index, replacing the file atomically, and drops the
+	 * journal it now includes.
+	 */
 	void write_save_index() ;
 
+	/**
+	 * Reads the saves of @a games whose summary is missing or out of date on
+	 * a background thread, in the order of @a games.
+	 *
+	 * Only the parsing of the saves happens there: collect_prefetched() adds
+	 * the summaries to the index, and get() takes the one it needs, waiting
+	 * if it's being read.
+	 */
+	void prefetch(const std::vector<save_info>& games) ;
+
+	/**
+	 * Adds the summaries read in the background since the last call to the
+	 * index. The index is only written by stop_prefetch().
+	 */
+	void collect_prefetched() ;
+
+	/**
+	 * Stops the background reading, dropping the saves not read yet, and
+	 * writes the index if summaries were added to it.
+	 */
+	void stop_prefetch() ;
+
 public:
 	save_index_class();
+	~save_index_class();
 private:
 	config& data(const std::string& name) ;
 	config& data() ;
+
+	/** Whether the summary of @a name is up to date, so get() won't read the save. */
+	bool is_indexed(const std::string& name) ;
+
+	/**
+	 * Sets the summary of @a name, from the parts of the save kept by the
+	 * summary reader, or as corrupt if @a source is NULL.
+	 */
+	void store_summary(const std::string& name, const time_t& modified, config* source) ;
+
+	/**
+	 * Records a change of the index by appending @a entry, a [save] with the
+	 * new summary or a [remove] with the name in save=, to the journal, or
+	 * by writing the whole index once the journal has grown long.
+	 */
+	void write_journal_entry(const config& entry) ;
+	/** Records the summary of @a name in the journal. */
+	void journal_summary(const std::string& name) ;
+	/** Applies the entries of the journal, written since the index, to it. */
+	void read_journal() ;
 private:
 	bool loaded_;
 	config data_;
+	/** The entries in the journal, applied to data_. */
+	size_t journal_entries_;
 	std::map< std::string, time_t > modified_;
+	boost::scoped_ptr<summary_loader> loader_;
+	/** Whether collect_prefetched() added summaries not written yet. */
+	bool prefetched_unwritten_;
 };
 extern save_index_class save_index_manager;
 } //end of namespace savegame
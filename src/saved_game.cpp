@@ -112,13 +112,20 @@ void saved_game::set_random_seed()
 	carryover_["random_calls"] = 0;
 }
 
+void saved_game::set_random_seed(int seed)
+{
+	assert(!has_carryover_expanded_);
+	carryover_["random_seed"] = seed;
+	carryover_["random_calls"] = 0;
+}
+
 void saved_game::write_config(config_writer& out) const
 {
 	write_general_info(out);
 	write_starting_pos(out);
 	if(!this->replay_start_.empty())
 	{
-		out.write_child("replay_start", replay_start_);
+		out.write_child("replay_start", replay_start_.get());
 	}
 	out.open_child("replay");
 	replay_data_.write(out);
@@ -130,11 +137,11 @@ void saved_game::write_starting_pos(config_writer& out) const
 {
 	if(starting_pos_type_ == STARTINGPOS_SNAPSHOT)
 	{
-		out.write_child("snapshot", starting_pos_);
+		out.write_child("snapshot", starting_pos_.get());
 	}
 	else if(starting_pos_type_ == STARTINGPOS_SCENARIO)
 	{
-		out.write_child("scenario", starting_pos_);
+		out.write_child("scenario", starting_pos_.get());
 	}
 }
 void saved_game::write_carryover(config_writer& out) const
@@ -156,7 +163,8 @@ void saved_game::set_defaults()
 		("carryover_percentage")
 		("carryover_add")
 	;
-	BOOST_FOREACH(config& side, starting_pos_.child_range("side"))
+	config& starting_pos = starting_pos_.get_mutable();
+	BOOST_FOREACH(config& side, starting_pos.child_range("side"))
 	{
 		// Set save_id default value directly after loading to its default to prevent different default behaviour in mp_connect code and sp code.
 		if(side["save_id"].empty())
@@ -166,7 +174,7 @@ void saved_game::set_defaults()
 		// Set some team specific values to their defaults specified in scenario
 		BOOST_FOREACH(const std::string& att_name, team_defaults)
 		{
-			const config::attribute_value* scenario_value = starting_pos_.get(att_name);
+			const config::attribute_value* scenario_value = starting_pos.get(att_name);
 			config::attribute_value& team_value = side[att_name];
 			if(scenario_value && team_value.empty())
 			{
@@ -189,7 +197,8 @@ void saved_game::expand_scenario()
 		if(scenario)
 		{
 			this->starting_pos_type_ = STARTINGPOS_SCENARIO;
-			this->starting_pos_ = scenario;
+			config scenario_copy(scenario);
+			this->starting_pos_.take(scenario_copy);
 			// A hash has to be generated using an unmodified scenario data.
 			mp_settings_.hash = scenario.hash();
 
@@ -199,7 +208,7 @@ void saved_game::expand_scenario()
 		else
 		{
 			this->starting_pos_type_ = STARTINGPOS_INVALID;
-			this->starting_pos_ = config();
+			this->starting_pos_.clear();
 		}
 	}
 }
@@ -229,8 +238,9 @@ private:
 void saved_game::expand_mp_events()
 {
 	expand_scenario();
-	if(this->starting_pos_type_ == STARTINGPOS_SCENARIO && !this->starting_pos_["has_mod_events"].to_bool(false))
+	if(this->starting_pos_type_ == STARTINGPOS_SCENARIO && !this->starting_pos_.get()["has_mod_events"].to_bool(false))
 	{
+		config& starting_pos = starting_pos_.get_mutable();
 		std::vector<modevents_entry> mods;
 
 		boost::copy( mp_settings_.active_mods
@@ -254,12 +264,12 @@ void saved_game::expand_mp_events()
 				// Copy events
 				BOOST_FOREACH(const config& modevent, cfg.child_range("event"))
 				{
-					this->starting_pos_.add_child("event", modevent);
+					starting_pos.add_child("event", modevent);
 				}
 				// Copy lua
 				BOOST_FOREACH(const config& modlua, cfg.child_range("lua"))
 				{
-					this->starting_pos_.add_child("lua", modlua);
+					starting_pos.add_child("lua", modlua);
 				}
 			}
 			else
@@ -269,7 +279,7 @@ void saved_game::expand_mp_events()
 			}
 		}
 
-		this->starting_pos_["has_mod_events"] = true;
+		starting_pos["has_mod_events"] = true;
 	}
 }
 
@@ -308,36 +318,37 @@ void saved_game::expand_random_scenario()
 	expand_scenario();
 	if(this->starting_pos_type_ == STARTINGPOS_SCENARIO)
 	{
+		config& starting_pos = starting_pos_.get_mutable();
 		// If the entire scenario should be randomly generated
-		if(!starting_pos_["scenario_generation"].empty())
+		if(!starting_pos["scenario_generation"].empty())
 		{
 			LOG_NG << "randomly generating scenario...\n";
 			const cursor::setter cursor_setter(cursor::WAIT);
 
-			config scenario_new = random_generate_scenario(starting_pos_["scenario_generation"],
-				starting_pos_.child("generator"));
+			config scenario_new = random_generate_scenario(starting_pos["scenario_generation"],
+				starting_pos.child("generator"));
 			//Preserve "story" form the scenario toplevel.
-			BOOST_FOREACH(config& story, starting_pos_.child_range("story"))
+			BOOST_FOREACH(config& story, starting_pos.child_range("story"))
 			{
 				scenario_new.add_child("story", story);
 			}
-			scenario_new["id"] = starting_pos_["id"]; 
-			starting_pos_ = scenario_new;
+			scenario_new["id"] = starting_pos["id"]; 
+			starting_pos.swap(scenario_new);
 			update_label();
 			set_defaults();
 		}
 		//it looks like we support a map= where map=filename equals more or less map_data={filename}
-		if(starting_pos_["map_data"].empty() && !starting_pos_["map"].empty()) {
-			starting_pos_["map_data"] = filesystem::read_map(starting_pos_["map"]);
+		if(starting_pos["map_data"].empty() && !starting_pos["map"].empty()) {
+			starting_pos["map_data"] = filesystem::read_map(starting_pos["map"]);
 		}
 		// If the map should be randomly generated
-		// We don’t want that we accidentally to this twice so we check for starting_pos_["map_data"].empty()
-		if(starting_pos_["map_data"].empty() && !starting_pos_["map_generation"].empty()) {
+		// We don’t want that we accidentally to this twice so we check for starting_pos["map_data"].empty()
+		if(starting_pos["map_data"].empty() && !starting_pos["map_generation"].empty()) {
 			LOG_NG << "randomly generating map...\n";
 			const cursor::setter cursor_setter(cursor::WAIT);
 
-			starting_pos_["map_data"] = random_generate_map(
-				starting_pos_["map_generation"], starting_pos_.child("generator"));
+			starting_pos["map_data"] = random_generate_map(
+				starting_pos["map_generation"], starting_pos.child("generator"));
 		}
 	}
 }
@@ -355,7 +366,8 @@ void saved_game::expand_carryover()
 			sides.transfer_all_to(side_cfg);
 		}
 
-		carryover_ = sides.to_config();
+		config carryover = sides.to_config();
+		carryover_.swap(carryover);
 		has_carryover_expanded_ = true;
 	}
 }
@@ -368,14 +380,14 @@ bool saved_game::valid()
 config& saved_game::set_snapshot(config snapshot)
 {
 	this->starting_pos_type_ = STARTINGPOS_SNAPSHOT;
-	this->starting_pos_.swap(snapshot);
-	return this->starting_pos_;
+	this->starting_pos_.take(snapshot);
+	return this->starting_pos_.get_mutable();
 }
 
 void saved_game::set_scenario(config scenario)
 {
 	this->starting_pos_type_ = STARTINGPOS_SCENARIO;
-	this->starting_pos_.swap(scenario);
+	this->starting_pos_.take(scenario);
 	has_carryover_expanded_ = false;
 	update_label();
 }
@@ -383,12 +395,17 @@ void saved_game::set_scenario(config scenario)
 void saved_game::remove_snapshot()
 {
 	this->starting_pos_type_ = STARTINGPOS_NONE;
-	this->starting_pos_ = config();
+	this->starting_pos_.clear();
 }
 
 config& saved_game::get_starting_pos()
 {
-	return starting_pos_;
+	return starting_pos_.get_mutable();
+}
+
+void saved_game::set_replay_start(config replay_start)
+{
+	replay_start_.take(replay_start);
 }
 
 
@@ -396,7 +413,7 @@ const config& saved_game::get_replay_starting_pos()
 {
 	if(!replay_start_.empty())
 	{
-		return replay_start_;
+		return replay_start_.get();
 	}
 	if(!has_carryover_expanded_)
 	{
@@ -406,21 +423,22 @@ const config& saved_game::get_replay_starting_pos()
 	}
 	if(starting_pos_type_ == STARTINGPOS_SCENARIO)
 	{
-		return starting_pos_;
+		return starting_pos_.get();
 	}
-	return this->replay_start_.child("some_non_existet_invalid");
+	return this->replay_start_.get().child("some_non_existet_invalid");
 }
 
 void saved_game::convert_to_start_save()
 {
 	assert(starting_pos_type_ == STARTINGPOS_SNAPSHOT);
-	carryover_info sides(starting_pos_, true);
+	carryover_info sides(starting_pos_.get(), true);
 	sides.merge_old_carryover(carryover_info(carryover_));
 	sides.rng().rotate_random();
-	carryover_ = sides.to_config();
+	config carryover = sides.to_config();
+	carryover_.swap(carryover);
 	has_carryover_expanded_ = false;
 	replay_data_ = replay_recorder_base();
-	replay_start_ = config();
+	replay_start_.clear();
 	remove_snapshot();
 }
 
@@ -430,17 +448,17 @@ config saved_game::to_config() const
 	config r = classification_.to_config();
 	if(!this->replay_start_.empty())
 	{
-		r.add_child("replay_start", replay_start_);
+		r.add_child("replay_start", replay_start_.get());
 	}
 	replay_data_.write(r.add_child("replay"));
 	
 	if(starting_pos_type_ == STARTINGPOS_SNAPSHOT)
 	{
-		r.add_child("snapshot", starting_pos_);
+		r.add_child("snapshot", starting_pos_.get());
 	}
 	else if(starting_pos_type_ == STARTINGPOS_SCENARIO)
 	{
-		r.add_child("scenario", starting_pos_);
+		r.add_child("scenario", starting_pos_.get());
 	}
 	r.add_child(has_carryover_expanded_ ? "carryover_sides" : "carryover_sides_start" , carryover_);
 	r.add_child("multiplayer", mp_settings_.to_config());
@@ -453,7 +471,7 @@ std::string saved_game::get_scenario_id()
 	if(this->starting_pos_type_ == STARTINGPOS_SNAPSHOT
 		|| this->starting_pos_type_ == STARTINGPOS_SCENARIO)
 	{
-		scenario_id = starting_pos_["id"].str();
+		scenario_id = starting_pos_.get()["id"].str();
 	}
 	else if(!has_carryover_expanded_)
 	{
@@ -475,15 +493,15 @@ bool saved_game::not_corrupt() const
 void saved_game::update_label()
 {
 	if (classification().abbrev.empty())
-		classification().label = starting_pos_["name"].str();
+		classification().label = starting_pos_.get()["name"].str();
 	else {
-		classification().label = classification().abbrev + "-" + starting_pos_["name"];
+		classification().label = classification().abbrev + "-" + starting_pos_.get()["name"];
 	}
 }
 
 void saved_game::cancel_orders()
 {
-	BOOST_FOREACH(config &side, this->starting_pos_.child_range("side"))
+	BOOST_FOREACH(config &side, get_starting_pos().child_range("side"))
 	{
 		// for humans "goto_x/y" is used for multi-turn-moves
 		// for the ai "goto_x/y" is a way for wml to order the ai to move a unit to a certain place.
@@ -499,7 +517,7 @@ void saved_game::cancel_orders()
 
 void saved_game::unify_controllers()
 {
-	BOOST_FOREACH(config &side, this->starting_pos_.child_range("side"))
+	BOOST_FOREACH(config &side, get_starting_pos().child_range("side"))
 	{
 		if (side["controller"] == "network")
 			side["controller"] = "human";
@@ -548,11 +566,11 @@ void saved_game::set_data(config& cfg)
 
 	if(config & replay_start = cfg.child("replay_start"))
 	{
-		replay_start_.swap(replay_start);
+		replay_start_.take(replay_start);
 	}
 	else
 	{
-		replay_start_ = config();
+		replay_start_.clear();
 	}
 	replay_data_ = replay_recorder_base();
 	//Serversided replays can contain multiple [replay]
@@ -564,17 +582,17 @@ void saved_game::set_data(config& cfg)
 	if(config& snapshot = cfg.child("snapshot"))
 	{
 		this->starting_pos_type_ = STARTINGPOS_SNAPSHOT;
-		this->starting_pos_.swap(snapshot);
+		this->starting_pos_.take(snapshot);
 	}
 	else if(config& scenario = cfg.child("scenario"))
 	{
 		this->starting_pos_type_ = STARTINGPOS_SCENARIO;
-		this->starting_pos_.swap(scenario);
+		this->starting_pos_.take(scenario);
 	}
 	else
 	{
 		this->starting_pos_type_ = STARTINGPOS_NONE;
-		this->starting_pos_ = config();
+		this->starting_pos_.clear();
 	}
 
 	LOG_NG << "scenario: '" << carryover_["next_scenario"].str() << "'\n";
@@ -6,6 +6,7 @@
 #include "game_classification.hpp"
 #include "mp_game_settings.hpp"
 #include "replay_recorder_base.hpp"
+#include "shared_config.hpp"
 
 class config_writer;
 
@@ -80,15 +81,18 @@ public:
 	void convert_to_start_save();
 	/// sets the random seed if that didn't already happen.
 	void set_random_seed();
+	/// sets the random seed, replacing the one set before; must be called before expand_carryover().
+	void set_random_seed(int seed);
 	/// @return the starting pos for replays. Usualy this is [replay_start] but it can also be a [scenario] if no [replay_start] is present
 	const config& get_replay_starting_pos();
 	/// @return the id of the currently played scenario or the id of the next scenario if this is a between-scenaios-save (also called start-of-scenario-save).
 	std::string get_scenario_id();
 	/// @return the config from which the game will be started. (this is [scenario] or [snapshot] in the savefile)
+	/// copies the starting pos first if a copy of this saved_game still shares it.
 	config& get_starting_pos();
-	const config& get_starting_pos() const { return starting_pos_; }
-	config& replay_start() { return replay_start_; }
-	const config& replay_start() const { return replay_start_; }
+	const config& get_starting_pos() const { return starting_pos_.get(); }
+	const config& replay_start() const { return replay_start_.get(); }
+	void set_replay_start(config replay_start);
 
 	bool not_corrupt() const;
 	/** sets classification().label to the correct value. */
@@ -111,7 +115,7 @@ private:
 	*/
 	config carryover_;
 	/** snapshot made before the start event. To be used as a starting pos for replays */
-	config replay_start_;
+	shared_config replay_start_;
 	/** some general information of the game that doesn't change during the game */
 	game_classification classification_;
 	mp_game_settings mp_settings_;
@@ -120,8 +124,9 @@ private:
 	/**
 		The starting pos where the (non replay) game will be started from.
 		This can eigher be a [scenario] for a fresh game or a [snapshot] if this is a reloaded game
+		The copies of a saved_game share it until one of them changes it.
 	*/
-	config starting_pos_;
+	shared_config starting_pos_;
 
 	replay_recorder_base replay_data_;
 };
@@ -14,7 +14,10 @@
 */
 
 #include <boost/assign/list_of.hpp>
+#include <boost/iostreams/filter/bzip2.hpp>
 #include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+#include <boost/scoped_ptr.hpp>
 
 #include "savegame.hpp"
 
@@ -46,6 +49,7 @@
 #include "serialization/binary_or_text.hpp"
 #include "serialization/parser.hpp"
 #include "statistics.hpp"
+#include "thread.hpp"
 //#include "unit.hpp"
 #include "unit_id.hpp"
 #include "version.hpp"
@@ -62,6 +66,111 @@ static lg::log_domain log_enginerefac("enginerefac");
 
 namespace savegame {
 
+namespace {
+
+/** A save being compressed and written by a background thread. */
+struct background_save
+{
+	background_save(const std::string& text, const compression::format compress,
+			const std::string& path, const std::string& label, const std::string& error_message)
+		: text(text)
+		, compress(compress)
+		, path(path)
+		, label(label)
+		, error_message(error_message)
+		, failed(false)
+		, error()
+		, thread()
+	{}
+
+	/** The uncompressed contents of the file. */
+	const std::string text;
+	const compression::format compress;
+	const std::string path;
+	/** The label whose entry in save_index_manager is updated afterwards. */
+	const std::string label;
+	const std::string error_message;
+
+	/** Set by the thread. */
+	bool failed;
+	std::string error;
+
+	/** Joined when destroyed, so it comes last. */
+	boost::scoped_ptr<threading::thread> thread;
+};
+
+boost::scoped_ptr<background_save> pending_save;
+
+/**
+ * Writes the file of a background_save, through a hidden temporary file
+ * renamed over it, so that the save is never seen half written.
+ */
+int write_in_background(void* data)
+{
+	background_save& save = *static_cast<background_save*>(data);
+	const std::string::size_type slash = save.path.rfind('/');
+	const std::string temp_path = save.path.substr(0, slash + 1) + "."
+		+ save.path.substr(slash + 1) + ".tmp";
+
+	try {
+		{
+			filesystem::scoped_ostream os(filesystem::ostream_file(temp_path));
+			{
+				// The same compression as config_writer.
+				boost::iostreams::filtering_stream<boost::iostreams::output> filter;
+				if(save.compress == compression::GZIP) {
+					filter.push(boost::iostreams::gzip_compressor(boost::iostreams::gzip_params(9)));
+				} else if(save.compress == compression::BZIP2) {
+					filter.push(boost::iostreams::bzip2_compressor(boost::iostreams::bzip2_params()));
+				}
+				filter.push(*os);
+				filter << save.text;
+				if(save.compress != compression::NONE) {
+					filter << "\n";
+				}
+			}
+			save.failed = !os->good();
+		}
+		if(!save.failed && !filesystem::rename_file(temp_path, save.path)) {
+			save.failed = true;
+		}
+	} catch(filesystem::io_exception& e) {
+		save.failed = true;
+		save.error = e.what();
+	} catch(std::exception& e) {
+		save.failed = true;
+		save.error = e.what();
+	}
+
+	if(save.failed) {
+		filesystem::delete_file(temp_path);
+	}
+	return 0;
+}
+
+} // end anonymous namespace
+
+void finish_background_save(CVideo* video)
+{
+	if(!pending_save) {
+		return;
+	}
+
+	pending_save->thread.reset();
+	boost::scoped_ptr<background_save> save;
+	save.swap(pending_save);
+
+	if(save->failed) {
+		const std::string message = save->error.empty() ? _("Could not write to file") : save->error;
+		ERR_SAVE << save->error_message << message << std::endl;
+		if(video) {
+			gui2::show_error_message(*video, save->error_message + message);
+		}
+		return;
+	}
+	save_index_manager.remove(save->label);
+}
+
 bool save_game_exists(const std::string& name, compression::format compressed)
 {
 	std::string fname = name;
@@ -74,6 +183,7 @@ bool save_game_exists(const std::string& name, compression::format compressed)
 
 void clean_saves(const std::string& label)
 {
+	finish_background_save();
 	std::vector<save_info> games = get_saves_list();
 	std::string prefix = label + "-" + _("Auto-Save");
 	LOG_SAVE << "Cleaning saves with prefix '" << prefix << "'\n";
@@ -171,6 +281,7 @@ void loadgame::show_difficulty_dialog()
 // throws a "load_game_exception" to signal a resulting load game request.
 bool loadgame::load_game()
 {
+	finish_background_save(&gui_.video());
 	if (!gui_.video().faked()) {
 		show_dialog(false, false);
 	}
@@ -205,6 +316,7 @@ bool loadgame::load_game(
 		, const std::string& difficulty
 		, bool skip_version_check)
 {
+	finish_background_save(&gui_.video());
 	filename_ = filename;
 	difficulty_ = difficulty;
 	select_difficulty_ = select_difficulty;
@@ -325,6 +437,7 @@ void loadgame::set_gamestate()
 
 bool loadgame::load_multiplayer_game()
 {
+	finish_background_save(&gui_.video());
 	show_dialog(false, false);
 
 	if (filename_.empty())
@@ -377,6 +490,7 @@ savegame::savegame(saved_game& gamestate, const compression::format compress_sav
 	, error_message_(_("The game could not be saved: "))
 	, show_confirmation_(false)
 	, compress_saves_(compress_saves)
+	, write_in_background_(false)
 {}
 
 bool savegame::save_game_automatic(CVideo& video, bool ask_for_overwrite, const std::string& filename)
@@ -525,6 +639,11 @@ void savegame::write_game_to_disk(const std::string& filename)
 	filename_ = filename;
 	filename_ += compression::format_extension(compress_saves_);
 
+	if (write_in_background_) {
+		start_background_write();
+		return;
+	}
+
 	std::stringstream ss;
 	{
 		config_writer out(ss, compress_saves_);
@@ -539,6 +658,27 @@ void savegame::write_game_to_disk(const std::string& filename)
 	}
 }
 
+void savegame::start_background_write()
+{
+	std::stringstream ss;
+	{
+		config_writer out(ss, compression::NONE);
+		write_game(out);
+		if(!out.good()) {
+			throw game::save_game_failed(_("Could not write to file"));
+		}
+	}
+
+	// The previous save must be done, and only one is in flight.
+	finish_background_save();
+
+	std::string name = filename_;
+	replace_space2underbar(name);
+	pending_save.reset(new background_save(ss.str(), compress_saves_,
+		filesystem::get_saves_dir() + "/" + name, gamestate_.classification().label, error_message_));
+	pending_save->thread.reset(new threading::thread(write_in_background, pending_save.get()));
+}
+
 void savegame::write_game(config_writer &out)
 {
 	log_scope("write_game");
@@ -619,6 +759,7 @@ autosave_savegame::autosave_savegame(saved_game &gamestate,
 	: ingame_savegame(gamestate, gui, compress_saves)
 {
 	set_error_message(_("Could not auto save the game. Please save the game manually."));
+	set_write_in_background(true);
 }
 
 void autosave_savegame::autosave(const bool disable_autosave, const int autosave_max, const int infinite_autosaves)
@@ -626,6 +767,8 @@ void autosave_savegame::autosave(const bool disable_autosave, const int autosave
 	if(disable_autosave)
 		return;
 
+	// Blocks only if the previous autosave is still being written.
+	finish_background_save(&gui_.video());
 	save_game_automatic(gui_.video());
 
 	remove_old_auto_saves(autosave_max, infinite_autosaves);
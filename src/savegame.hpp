@@ -32,6 +32,13 @@ bool save_game_exists(const std::string& name, compression::format compressed);
 /** Delete all autosaves of a certain scenario. */
 void clean_saves(const std::string& label);
 
+/**
+ * Waits for the autosave written by a background thread, if any, and
+ * updates the save index for it; a failure is shown on @a video if given.
+ * The saves must not be listed or deleted before.
+ */
+void finish_background_save(CVideo* video = NULL);
+
 /** The class for loading a savefile. */
 class loadgame
 {
@@ -133,6 +140,9 @@ protected:
 	/** Customize the standard error message */
 	void set_error_message(const std::string& error_message) { error_message_ = error_message; }
 
+	/** Compress and write the file on a background thread, see finish_background_save(). */
+	void set_write_in_background(bool background) { write_in_background_ = background; }
+
 	const std::string& title() { return title_; }
 	const saved_game& gamestate() { return gamestate_; }
 
@@ -157,6 +167,8 @@ private:
 	/** The actual method for saving the game to disk. All interactive filename choosing and
 		data manipulation has to happen before calling this method. */
 	void write_game_to_disk(const std::string& filename);
+	/** Serializes the game and leaves the rest of write_game_to_disk() to a background thread. */
+	void start_background_write();
 
 	/** Update the save_index */
 	void finish_save_game(const config_writer &out);
@@ -175,6 +187,8 @@ private:
 	bool show_confirmation_; /** Determines if a confirmation of successful saving the game is shown. */
 
 	compression::format compress_saves_; /** Determines, what compression format is used for the savegame file */
+
+	bool write_in_background_; /** Determines if the file is compressed and written by a background thread */
 };
 
 /** Class for "normal" midgame saves. The additional members are needed for creating the snapshot
@@ -64,6 +64,7 @@
 #include "map_location.hpp"             // for map_location
 #include "mouse_events.hpp"             // for mouse_handler
 #include "mp_game_settings.hpp"         // for mp_game_settings
+#include "pathfind/hierarchical.hpp"    // for hierarchical_search
 #include "pathfind/pathfind.hpp"        // for full_cost_map, plain_route, etc
 #include "pathfind/teleport.hpp"        // for get_teleport_locations, etc
 #include "play_controller.hpp"          // for play_controller
@@ -74,6 +75,7 @@
 #include "scripting/lua_common.hpp"
 #include "scripting/lua_cpp_function.hpp"
 #include "scripting/lua_gui2.hpp"	// for show_gamestate_inspector
+#include "scripting/lua_map_views.hpp"
 #include "scripting/lua_race.hpp"
 #include "scripting/lua_team.hpp"
 #include "scripting/lua_types.hpp"      // for getunitKey, dlgclbkKey, etc
@@ -201,6 +203,82 @@ namespace {
 	};
 }//unnamed namespace for queued_event_context
 
+/**
+ * Pushes the proxy of the unit with underlying id @a uid on the map.
+ * The proxies are kept in a table with weak values, so the proxy handed out
+ * last is reused as long as Lua holds it and it still refers to the unit on
+ * the map.
+ * - Arg cache: absolute stack index of the table of the proxies.
+ */
+static void push_unit_proxy(lua_State *L, int cache, size_t uid)
+{
+	lua_pushinteger(L, uid);
+	lua_rawget(L, cache);
+	lua_unit *lu = static_cast<lua_unit *>(lua_touserdata(L, -1));
+	if (lu && lu->is_map_proxy_of(uid))
+		return;
+	lua_pop(L, 1);
+
+	new(lua_newuserdata(L, sizeof(lua_unit))) lua_unit(uid);
+	lua_pushlightuserdata(L
+			, getunitKey);
+	lua_rawget(L, LUA_REGISTRYINDEX);
+	lua_setmetatable(L, -2);
+	lua_pushinteger(L, uid);
+	lua_pushvalue(L, -2);
+	lua_rawset(L, cache);
+}
+
+/**
+ * Pushes the proxy of the unit with underlying id @a uid on the map.
+ */
+static void push_unit_proxy(lua_State *L, size_t uid)
+{
+	lua_pushlightuserdata(L
+			, unitproxyKey);
+	lua_rawget(L, LUA_REGISTRYINDEX);
+	push_unit_proxy(L, lua_gettop(L), uid);
+	lua_remove(L, -2);
+}
+
+namespace {
+	/// The properties of a unit read by impl_unit_get.
+	enum unit_property {
+		UNIT_UNKNOWN, UNIT_VALID, UNIT_X, UNIT_Y, UNIT_LOC, UNIT_SIDE, UNIT_ID,
+		UNIT_TYPE, UNIT_IMAGE_MODS, UNIT_HITPOINTS, UNIT_MAX_HITPOINTS,
+		UNIT_EXPERIENCE, UNIT_MAX_EXPERIENCE, UNIT_RECALL_COST, UNIT_MOVES,
+		UNIT_MAX_MOVES, UNIT_MAX_ATTACKS, UNIT_ATTACKS_LEFT, UNIT_NAME,
+		UNIT_CANRECRUIT, UNIT_EXTRA_RECRUIT, UNIT_ADVANCES_TO, UNIT_STATUS,
+		UNIT_VARIABLES, UNIT_ATTACKS, UNIT_HIDDEN, UNIT_PETRIFIED,
+		UNIT_RESTING, UNIT_ROLE, UNIT_FACING, UNIT_CFG, UNIT_PROPERTY_COUNT
+	};
+
+	/// The names of the properties, in the order of unit_property.
+	char const *const unit_property_names[UNIT_PROPERTY_COUNT] = {
+		NULL, "valid", "x", "y", "loc", "side", "id",
+		"type", "image_mods", "hitpoints", "max_hitpoints",
+		"experience", "max_experience", "recall_cost", "moves",
+		"max_moves", "max_attacks", "attacks_left", "name",
+		"canrecruit", "extra_recruit", "advances_to", "status",
+		"variables", "attacks", "hidden", "petrified",
+		"resting", "role", "facing", "__cfg"
+	};
+}//unnamed namespace for unit_property
+
+/**
+ * Pushes a table from the names of the properties of a unit to their
+ * unit_property, the upvalue of impl_unit_get. Looking the (interned) key up
+ * in it costs a hash lookup, instead of comparing it with every name.
+ */
+static void push_unit_properties(lua_State *L)
+{
+	lua_createtable(L, 0, UNIT_PROPERTY_COUNT - 1);
+	for (int property = UNIT_VALID; property != UNIT_PROPERTY_COUNT; ++property) {
+		lua_pushinteger(L, property);
+		lua_setfield(L, -2, unit_property_names[property]);
+	}
+}
+
 /**
  * Destroys a unit object before it is collected (__gc metamethod).
  */
@@ -232,10 +310,14 @@ static int impl_unit_equality(lua_State* L)
 static int impl_unit_get(lua_State *L)
 {
 	lua_unit *lu = static_cast<lua_unit *>(lua_touserdata(L, 1));
-	char const *m = luaL_checkstring(L, 2);
+	luaL_checkstring(L, 2);
+	lua_pushvalue(L, 2);
+	lua_rawget(L, lua_upvalueindex(1));
+	const int property = lua_tointeger(L, -1); // UNIT_UNKNOWN if nil
+	lua_pop(L, 1);
 	const unit_const_ptr pu = lu->get();
 
-	if (strcmp(m, "valid") == 0)
+	if (property == UNIT_VALID)
 	{
 		if (!pu) return 0;
 		if (lu->on_map())
@@ -251,33 +333,43 @@ static int impl_unit_get(lua_State *L)
 	unit const &u = *pu;
 
 	// Find the corresponding attribute.
-	return_int_attrib("x", u.get_location().x + 1);
-	return_int_attrib("y", u.get_location().y + 1);
-	if (strcmp(m, "loc") == 0) {
+	switch (property) {
+	case UNIT_X:              lua_pushinteger(L, u.get_location().x + 1); return 1;
+	case UNIT_Y:              lua_pushinteger(L, u.get_location().y + 1); return 1;
+	case UNIT_LOC:
 		lua_pushinteger(L, u.get_location().x + 1);
 		lua_pushinteger(L, u.get_location().y + 1);
 		return 2;
-	}
-	return_int_attrib("side", u.side());
-	return_string_attrib("id", u.id());
-	return_string_attrib("type", u.type_id());
-	return_string_attrib("image_mods", u.effect_image_mods());
-	return_int_attrib("hitpoints", u.hitpoints());
-	return_int_attrib("max_hitpoints", u.max_hitpoints());
-	return_int_attrib("experience", u.experience());
-	return_int_attrib("max_experience", u.max_experience());
-	return_int_attrib("recall_cost", u.recall_cost());
-	return_int_attrib("moves", u.movement_left());
-	return_int_attrib("max_moves", u.total_movement());
-	return_int_attrib("max_attacks", u.max_attacks());
-	return_int_attrib("attacks_left", u.attacks_left());
-	return_tstring_attrib("name", u.name());
-	return_bool_attrib("canrecruit", u.can_recruit());
+	case UNIT_SIDE:           lua_pushinteger(L, u.side()); return 1;
+	case UNIT_ID:             lua_pushstring(L, u.id().c_str()); return 1;
+	case UNIT_TYPE:           lua_pushstring(L, u.type_id().c_str()); return 1;
+	case UNIT_IMAGE_MODS:     lua_pushstring(L, u.effect_image_mods().c_str()); return 1;
+	case UNIT_HITPOINTS:      lua_pushinteger(L, u.hitpoints()); return 1;
+	case UNIT_MAX_HITPOINTS:  lua_pushinteger(L, u.max_hitpoints()); return 1;
+	case UNIT_EXPERIENCE:     lua_pushinteger(L, u.experience()); return 1;
+	case UNIT_MAX_EXPERIENCE: lua_pushinteger(L, u.max_experience()); return 1;
+	case UNIT_RECALL_COST:    lua_pushinteger(L, u.recall_cost()); return 1;
+	case UNIT_MOVES:          lua_pushinteger(L, u.movement_left()); return 1;
+	case UNIT_MAX_MOVES:      lua_pushinteger(L, u.total_movement()); return 1;
+	case UNIT_MAX_ATTACKS:    lua_pushinteger(L, u.max_attacks()); return 1;
+	case UNIT_ATTACKS_LEFT:   lua_pushinteger(L, u.attacks_left()); return 1;
+	case UNIT_NAME:           luaW_pushtstring(L, u.name()); return 1;
+	case UNIT_CANRECRUIT:     lua_pushboolean(L, u.can_recruit()); return 1;
+	case UNIT_HIDDEN:         lua_pushboolean(L, u.get_hidden()); return 1;
+	case UNIT_PETRIFIED:      lua_pushboolean(L, u.incapacitated()); return 1;
+	case UNIT_RESTING:        lua_pushboolean(L, u.resting()); return 1;
+	case UNIT_ROLE:           lua_pushstring(L, u.get_role().c_str()); return 1;
+	case UNIT_FACING:         lua_pushstring(L, map_location::write_direction(u.facing()).c_str()); return 1;
+	default:                  break;
+	}
+
+	char const *m = unit_property_names[property];
+	if (!m) return 0;
 
 	return_vector_string_attrib("extra_recruit", u.recruits());
 	return_vector_string_attrib("advances_to", u.advances_to());
 
-	if (strcmp(m, "status") == 0) {
+	if (property == UNIT_STATUS) {
 		lua_createtable(L, 1, 0);
 		lua_pushvalue(L, 1);
 		lua_rawseti(L, -2, 1);
@@ -287,7 +379,7 @@ static int impl_unit_get(lua_State *L)
 		lua_setmetatable(L, -2);
 		return 1;
 	}
-	if (strcmp(m, "variables") == 0) {
+	if (property == UNIT_VARIABLES) {
 		lua_createtable(L, 1, 0);
 		lua_pushvalue(L, 1);
 		lua_rawseti(L, -2, 1);
@@ -297,7 +389,7 @@ static int impl_unit_get(lua_State *L)
 		lua_setmetatable(L, -2);
 		return 1;
 	}
-	if (strcmp(m, "attacks") == 0) {
+	if (property == UNIT_ATTACKS) {
 		lua_createtable(L, 1, 0);
 		lua_pushvalue(L, 1);
 		// hack: store the unit at -1 becasue we want positive indexes to refers to the attacks.
@@ -307,11 +399,6 @@ static int impl_unit_get(lua_State *L)
 		lua_setmetatable(L, -2);
 		return 1;
 	}
-	return_bool_attrib("hidden", u.get_hidden());
-	return_bool_attrib("petrified", u.incapacitated());
-	return_bool_attrib("resting", u.resting());
-	return_string_attrib("role", u.get_role());
-	return_string_attrib("facing", map_location::write_direction(u.facing()));
 	return_cfg_attrib("__cfg", u.write(cfg); u.get_location().write(cfg));
 	return 0;
 }
@@ -673,11 +760,7 @@ int game_lua_kernel::intf_get_unit(lua_State *L)
 
 	if (!ui.valid()) return 0;
 
-	new(lua_newuserdata(L, sizeof(lua_unit))) lua_unit(ui->underlying_id());
-	lua_pushlightuserdata(L
-			, getunitKey);
-	lua_rawget(L, LUA_REGISTRYINDEX);
-	lua_setmetatable(L, -2);
+	push_unit_proxy(L, ui->underlying_id());
 	return 1;
 }
 
@@ -698,11 +781,7 @@ int game_lua_kernel::intf_get_displayed_unit(lua_State *L)
 		game_display_->show_everything());
 	if (!ui.valid()) return 0;
 
-	new(lua_newuserdata(L, sizeof(lua_unit))) lua_unit(ui->underlying_id());
-	lua_pushlightuserdata(L
-			, getunitKey);
-	lua_rawget(L, LUA_REGISTRYINDEX);
-	lua_setmetatable(L, -2);
+	push_unit_proxy(L, ui->underlying_id());
 	return 1;
 }
 
@@ -717,10 +796,10 @@ int game_lua_kernel::intf_get_units(lua_State *L)
 	vconfig filter = luaW_checkvconfig(L, 1, true);
 
 	// Go through all the units while keeping the following stack:
-	// 1: metatable, 2: return table, 3: userdata, 4: metatable copy
+	// 1: proxies, 2: return table, 3: userdata
 	lua_settop(L, 0);
 	lua_pushlightuserdata(L
-			, getunitKey);
+			, unitproxyKey);
 	lua_rawget(L, LUA_REGISTRYINDEX);
 	lua_newtable(L);
 	int i = 1;
@@ -728,9 +807,7 @@ int game_lua_kernel::intf_get_units(lua_State *L)
 	// note that if filter is null, this yields a null filter matching everything (and doing no work)
 	filter_context & fc = game_state_;
 	BOOST_FOREACH ( const unit * ui, unit_filter(filter, &fc).all_matches_on_map()) {
-		new(lua_newuserdata(L, sizeof(lua_unit))) lua_unit(ui->underlying_id());
-		lua_pushvalue(L, 1);
-		lua_setmetatable(L, 3);
+		push_unit_proxy(L, 1, ui->underlying_id());
 		lua_rawseti(L, 2, i);
 		++i;
 	}
@@ -1141,6 +1218,127 @@ int game_lua_kernel::intf_get_terrain(lua_State *L)
 	return 1;
 }
 
+namespace {
+	/// A rectangle of hexes read by the bulk map functions.
+	struct map_rect
+	{
+		int x1, y1, x2, y2;
+		int width() const { return x2 - x1 + 1; }
+		int size() const { return width() * (y2 - y1 + 1); }
+	};
+}//unnamed namespace for map_rect
+
+/**
+ * Reads the rectangle of the bulk map functions, and pushes the table they
+ * fill.
+ * - Args arg to arg+3: x1, y1, x2, y2, the corners of the rectangle,
+ *   included. The border of the map can be read.
+ * - Arg arg+4: optional table to fill, reused across the calls; else a new
+ *   table is pushed.
+ */
+static map_rect check_map_rect(lua_State *L, int arg, const gamemap &map)
+{
+	map_rect rect;
+	rect.x1 = luaL_checkint(L, arg);
+	rect.y1 = luaL_checkint(L, arg + 1);
+	rect.x2 = luaL_checkint(L, arg + 2);
+	rect.y2 = luaL_checkint(L, arg + 3);
+
+	if (!map.on_board_with_border(map_location(rect.x1 - 1, rect.y1 - 1)))
+		luaL_argerror(L, arg, "corner out of the map");
+	if (!map.on_board_with_border(map_location(rect.x2 - 1, rect.y2 - 1)))
+		luaL_argerror(L, arg + 2, "corner out of the map");
+	if (rect.x2 < rect.x1 || rect.y2 < rect.y1)
+		luaL_argerror(L, arg + 2, "empty rectangle");
+
+	if (lua_istable(L, arg + 4))
+		lua_pushvalue(L, arg + 4);
+	else
+		lua_createtable(L, rect.size(), 0);
+	return rect;
+}
+
+/**
+ * Gets the terrain codes of a rectangle of the map.
+ * - Args 1 to 5: see check_map_rect.
+ * - Ret 1: table of the terrain codes, row after row: the code of x, y is at
+ *   (y - y1) * (x2 - x1 + 1) + x - x1 + 1.
+ */
+int game_lua_kernel::intf_get_terrain_rect(lua_State *L)
+{
+	const gamemap &map = board().map();
+	const map_rect rect = check_map_rect(L, 1, map);
+
+	// The terrain codes are written once each, then copied from their
+	// first hex.
+	std::map<t_translation::t_terrain, int> first_index;
+	int i = 1;
+	for (int y = rect.y1; y <= rect.y2; ++y) {
+		for (int x = rect.x1; x <= rect.x2; ++x, ++i) {
+			const t_translation::t_terrain &t = map.get_terrain(map_location(x - 1, y - 1));
+			std::map<t_translation::t_terrain, int>::const_iterator it = first_index.find(t);
+			if (it == first_index.end()) {
+				first_index.insert(std::make_pair(t, i));
+				lua_pushstring(L, t_translation::write_terrain_code(t).c_str());
+			} else {
+				lua_rawgeti(L, -1, it->second);
+			}
+			lua_rawseti(L, -2, i);
+		}
+	}
+	return 1;
+}
+
+/**
+ * Gets the sides owning the villages of a rectangle of the map.
+ * - Args 1 to 5: see check_map_rect.
+ * - Ret 1: table of the sides, laid out as by get_terrain_rect, 0 for the
+ *   hexes without a village owned.
+ */
+int game_lua_kernel::intf_get_village_owners_rect(lua_State *L)
+{
+	const gamemap &map = board().map();
+	const map_rect rect = check_map_rect(L, 1, map);
+
+	int i = 1;
+	for (int y = rect.y1; y <= rect.y2; ++y) {
+		for (int x = rect.x1; x <= rect.x2; ++x, ++i) {
+			const map_location loc(x - 1, y - 1);
+			lua_pushinteger(L, map.is_village(loc) ? board().village_owner(loc) + 1 : 0);
+			lua_rawseti(L, -2, i);
+		}
+	}
+	return 1;
+}
+
+/**
+ * Gets the fog and shroud of a side over a rectangle of the map.
+ * - Arg 1: side number.
+ * - Args 2 to 6: see check_map_rect.
+ * - Ret 1: table laid out as by get_terrain_rect, with 0 for the hexes seen,
+ *   1 for the fogged ones and 2 for the shrouded ones.
+ */
+int game_lua_kernel::intf_get_fog_rect(lua_State *L)
+{
+	const int side = luaL_checkint(L, 1);
+	if (side < 1 || side > static_cast<int>(teams().size()))
+		return luaL_argerror(L, 1, "invalid side");
+	const team &t = teams()[side - 1];
+
+	const gamemap &map = board().map();
+	const map_rect rect = check_map_rect(L, 2, map);
+
+	int i = 1;
+	for (int y = rect.y1; y <= rect.y2; ++y) {
+		for (int x = rect.x1; x <= rect.x2; ++x, ++i) {
+			const map_location loc(x - 1, y - 1);
+			lua_pushinteger(L, t.shrouded(loc) ? 2 : t.fogged(loc) ? 1 : 0);
+			lua_rawseti(L, -2, i);
+		}
+	}
+	return 1;
+}
+
 /**
  * Sets a terrain code.
  * - Args 1,2: map location.
@@ -1794,7 +1992,8 @@ namespace {
  * - Args 1,2: source location. (Or Arg 1: unit.)
  * - Args 3,4: destination.
  * - Arg 5: optional cost function or
- *          table (optional fields: ignore_units, ignore_teleport, max_cost, viewing_side).
+ *          table (optional fields: ignore_units, ignore_teleport, max_cost, viewing_side,
+ *          hierarchical).
  * - Ret 1: array of pairs containing path steps.
  * - Ret 2: path cost.
  */
@@ -1832,9 +2031,10 @@ int game_lua_kernel::intf_find_path(lua_State *L)
 
 	const gamemap &map = board().map();
 	int viewing_side = 0;
-	bool ignore_units = false, see_all = false, ignore_teleport = false;
+	bool ignore_units = false, see_all = false, ignore_teleport = false, hierarchical = false;
 	double stop_at = 10000;
 	pathfind::cost_calculator *calc = NULL;
+	pathfind::cost_grid::ptr grid;
 
 	if (lua_istable(L, arg))
 	{
@@ -1854,6 +2054,11 @@ int game_lua_kernel::intf_find_path(lua_State *L)
 			stop_at = luaL_checknumber(L, -1);
 		lua_pop(L, 1);
 
+		lua_pushstring(L, "hierarchical");
+		lua_rawget(L, arg);
+		hierarchical = luaW_toboolean(L, -1);
+		lua_pop(L, 1);
+
 		lua_pushstring(L, "viewing_side");
 		lua_rawget(L, arg);
 		if (!lua_isnil(L, -1)) {
@@ -1880,10 +2085,17 @@ int game_lua_kernel::intf_find_path(lua_State *L)
 		}
 		calc = new pathfind::shortest_path_calculator(*u, viewing_team,
 			teams(), map, ignore_units, false, see_all);
+		if (hierarchical) {
+			grid = pathfind::cost_grid::get(map, u->movement_type().get_movement(),
+				u->get_state(unit::STATE_SLOWED));
+		}
 	}
 
-	pathfind::plain_route res = pathfind::a_star_search(src, dst, stop_at, calc, map.w(), map.h(),
-		&teleport_locations);
+	pathfind::plain_route res = grid ?
+		pathfind::hierarchical_search(src, dst, stop_at, calc, map.w(), map.h(),
+			grid, &teleport_locations) :
+		pathfind::a_star_search(src, dst, stop_at, calc, map.w(), map.h(),
+			&teleport_locations);
 	delete calc;
 
 	int nb = res.steps.size();
@@ -1992,9 +2204,10 @@ static bool intf_find_cost_map_helper(const unit * ptr) {
  * Is called with one or more units and builds a cost map.
  * - Args 1,2: source location. (Or Arg 1: unit. Or Arg 1: table containing a filter)
  * - Arg 3: optional array of tables with 4 elements (coordinates + side + unit type string)
- * - Arg 4: optional table (optional fields: ignore_units, ignore_teleport, viewing_side, debug).
+ * - Arg 4: optional table (optional fields: ignore_units, ignore_teleport, viewing_side, debug, view).
  * - Arg 5: optional table: standard location filter.
- * - Ret 1: array of triples (coordinates + array of tuples(summed cost + reach counter)).
+ * - Ret 1: array of triples (coordinates + array of tuples(summed cost + reach counter)),
+ *          or if view is true, a view on the whole cost map (see lua_map_views.hpp).
  */
 int game_lua_kernel::intf_find_cost_map(lua_State *L)
 {
@@ -2069,6 +2282,7 @@ int game_lua_kernel::intf_find_cost_map(lua_State *L)
 
 	int viewing_side = 0;
 	bool ignore_units = true, see_all = true, ignore_teleport = false, debug = false, use_max_moves = false;
+	bool view = false;
 
 	if (lua_istable(L, arg))  // 4. arg - options
 	{
@@ -2115,6 +2329,14 @@ int game_lua_kernel::intf_find_cost_map(lua_State *L)
 			use_max_moves = luaW_toboolean(L, -1);
 		}
 		lua_pop(L, 1);
+
+		lua_pushstring(L, "view");
+		lua_rawget(L, arg);
+		if (!lua_isnil(L, -1))
+		{
+			view = luaW_toboolean(L, -1);
+		}
+		lua_pop(L, 1);
 		++arg;
 	}
 
@@ -2136,10 +2358,7 @@ int game_lua_kernel::intf_find_cost_map(lua_State *L)
 	pathfind::full_cost_map cost_map(
 			ignore_units, !ignore_teleport, viewing_team, see_all, ignore_units);
 
-	BOOST_FOREACH(const unit* const u, real_units)
-	{
-		cost_map.add_unit(*u, use_max_moves);
-	}
+	cost_map.add_units(real_units, use_max_moves);
 	BOOST_FOREACH(const unit_type_vector::value_type& fu, fake_units)
 	{
 		const unit_type* ut = unit_types.find(fu.get<2>());
@@ -2161,6 +2380,12 @@ int game_lua_kernel::intf_find_cost_map(lua_State *L)
 		}
 	}
 
+	if (view)
+	{
+		luaW_pushcostmapview(L, cost_map);
+		return 1;
+	}
+
 	// create return value
 	lua_createtable(L, location_set.size(), 0);
 	int counter = 1;
@@ -3973,6 +4198,7 @@ game_lua_kernel::game_lua_kernel(const config &cfg, CVideo * video, game_state &
 		{ "float_label",               boost::bind(&game_lua_kernel::intf_float_label,               this, _1        )},
 		{ "gamestate_inspector",       boost::bind(&game_lua_kernel::intf_gamestate_inspector,       this, _1        )},
 		{ "get_all_vars",              boost::bind(&game_lua_kernel::intf_get_all_vars,              this, _1        )},
+		{ "get_fog_rect",              boost::bind(&game_lua_kernel::intf_get_fog_rect,              this, _1        )},
 		{ "get_locations",             boost::bind(&game_lua_kernel::intf_get_locations,             this, _1        )},
 		{ "get_map_size",              boost::bind(&game_lua_kernel::intf_get_map_size,              this, _1        )},
 		{ "get_mouseover_tile",        boost::bind(&game_lua_kernel::intf_get_mouseover_tile,        this, _1        )},
@@ -3981,6 +4207,7 @@ game_lua_kernel::game_lua_kernel(const config &cfg, CVideo * video, game_state &
 		{ "get_sides",                 boost::bind(&game_lua_kernel::intf_get_sides,                 this, _1        )},
 		{ "get_starting_location",     boost::bind(&game_lua_kernel::intf_get_starting_location,     this, _1        )},
 		{ "get_terrain",               boost::bind(&game_lua_kernel::intf_get_terrain,               this, _1        )},
+		{ "get_terrain_rect",          boost::bind(&game_lua_kernel::intf_get_terrain_rect,          this, _1        )},
 		{ "get_terrain_info",          boost::bind(&game_lua_kernel::intf_get_terrain_info,          this, _1        )},
 		{ "get_time_of_day",           boost::bind(&game_lua_kernel::intf_get_time_of_day,           this, _1        )},
 		{ "get_unit",                  boost::bind(&game_lua_kernel::intf_get_unit,                  this, _1        )},
@@ -3988,6 +4215,7 @@ game_lua_kernel::game_lua_kernel(const config &cfg, CVideo * video, game_state &
 		{ "get_variable",              boost::bind(&game_lua_kernel::intf_get_variable,              this, _1        )},
 		{ "get_villages",              boost::bind(&game_lua_kernel::intf_get_villages,              this, _1        )},
 		{ "get_village_owner",         boost::bind(&game_lua_kernel::intf_get_village_owner,         this, _1        )},
+		{ "get_village_owners_rect",   boost::bind(&game_lua_kernel::intf_get_village_owners_rect,   this, _1        )},
 		{ "get_displayed_unit",        boost::bind(&game_lua_kernel::intf_get_displayed_unit,        this, _1        )},
 		{ "heal_unit",                 boost::bind(&game_lua_kernel::intf_heal_unit,                 this, _1        )},
 		{ "highlight_hex",             boost::bind(&game_lua_kernel::intf_highlight_hex,             this, _1        )},
@@ -4043,6 +4271,9 @@ game_lua_kernel::game_lua_kernel(const config &cfg, CVideo * video, game_state &
 	//Create the getrace metatable
 	cmd_log_ << lua_race::register_metatable(L);
 
+	// Create the move map and cost map view metatables.
+	cmd_log_ << lua_map_views::register_metatables(L);
+
 	// Create the getunit metatable.
 	cmd_log_ << "Adding getunit metatable...\n";
 
@@ -4053,7 +4284,8 @@ game_lua_kernel::game_lua_kernel(const config &cfg, CVideo * video, game_state &
 	lua_setfield(L, -2, "__gc");
 	lua_pushcfunction(L, impl_unit_equality);
 	lua_setfield(L, -2, "__eq");
-	lua_pushcfunction(L, impl_unit_get);
+	push_unit_properties(L);
+	lua_pushcclosure(L, impl_unit_get, 1);
 	lua_setfield(L, -2, "__index");
 	lua_pushcfunction(L, impl_unit_set);
 	lua_setfield(L, -2, "__newindex");
@@ -4061,6 +4293,17 @@ game_lua_kernel::game_lua_kernel(const config &cfg, CVideo * video, game_state &
 	lua_setfield(L, -2, "__metatable");
 	lua_rawset(L, LUA_REGISTRYINDEX);
 
+	// Create the table of the proxies of the units on the map, with weak
+	// values so that the proxies no longer used are collected.
+	lua_pushlightuserdata(L
+			, unitproxyKey);
+	lua_newtable(L);
+	lua_createtable(L, 0, 1);
+	lua_pushstring(L, "v");
+	lua_setfield(L, -2, "__mode");
+	lua_setmetatable(L, -2);
+	lua_rawset(L, LUA_REGISTRYINDEX);
+
 	// Create the unit status metatable.
 	cmd_log_ << "Adding unit status metatable...\n";
 
@@ -4182,6 +4425,11 @@ game_lua_kernel::game_lua_kernel(const config &cfg, CVideo * video, game_state &
 	lua_setfield(L, -2, "theme_items");
 	lua_pop(L, 1);
 
+	// The events create many short-lived tables: collect more often, in
+	// shorter steps, to spread the work between the frames.
+	cmd_log_ << "Tuning the garbage collector...\n";
+	set_gc_parameters(150, 150);
+
 	lua_settop(L, 0);
 }
 
@@ -4426,11 +4674,7 @@ bool game_lua_kernel::run_filter(char const *name, unit const &u)
 		return false;
 	}
 	// Pass the unit as argument.
-	new(lua_newuserdata(L, sizeof(lua_unit))) lua_unit(ui->underlying_id());
-	lua_pushlightuserdata(L
-			, getunitKey);
-	lua_rawget(L, LUA_REGISTRYINDEX);
-	lua_setmetatable(L, -2);
+	push_unit_proxy(L, ui->underlying_id());
 
 	if (!luaW_pcall(L, 1, 1)) return false;
 
@@ -90,6 +90,9 @@ class game_lua_kernel : public lua_kernel_base
 	int intf_view_locked(lua_State *L);
 	int intf_lock_view(lua_State *L);
 	int intf_get_terrain(lua_State *L);
+	int intf_get_terrain_rect(lua_State *L);
+	int intf_get_village_owners_rect(lua_State *L);
+	int intf_get_fog_rect(lua_State *L);
 	int intf_set_terrain(lua_State *L);
 	int intf_get_terrain_info(lua_State *L);
 	int intf_get_time_of_day(lua_State *L);
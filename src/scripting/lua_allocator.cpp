@@ -0,0 +1,174 @@
+/*
+   Copyright (C) 2015 by the Battle for Wesnoth Project
+   Part of the Battle for Wesnoth Project http://www.wesnoth.org/
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY.
+
+   See the COPYING file for more details.
+*/
+
+#include "scripting/lua_allocator.hpp"
+
+#include <boost/foreach.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+namespace {
+
+/** The size classes of the small blocks, the granularity being the alignment of malloc. */
+const size_t granularity = 16;
+const size_t size_classes = 16;
+const size_t max_small_size = granularity * size_classes;
+
+/** The size of the slabs, each holding blocks of a single size class. */
+const size_t slab_size = 16384;
+
+bool is_small(const size_t size)
+{
+	return size <= max_small_size;
+}
+
+size_t size_class(const size_t size)
+{
+	return size == 0 ? 0 : (size - 1) / granularity;
+}
+
+size_t block_size(const size_t size_class)
+{
+	return (size_class + 1) * granularity;
+}
+
+} // end anonymous namespace
+
+lua_allocator::statistics::statistics()
+	: bytes(0)
+	, peak_bytes(0)
+	, slab_bytes(0)
+	, small_blocks(0)
+	, large_blocks(0)
+	, allocations(0)
+{
+}
+
+lua_allocator::lua_allocator()
+	: free_lists_(size_classes, static_cast<free_block*>(NULL))
+	, slabs_()
+	, statistics_()
+{
+}
+
+lua_allocator::~lua_allocator()
+{
+	BOOST_FOREACH(void* slab, slabs_) {
+		std::free(slab);
+	}
+}
+
+void* lua_allocator::allocate(void* ud, void* ptr, size_t osize, size_t nsize)
+{
+	// When ptr is NULL, osize is the type of the object created, not a size.
+	return static_cast<lua_allocator*>(ud)->reallocate(ptr, ptr ? osize : 0, nsize);
+}
+
+void* lua_allocator::reallocate(void* ptr, size_t osize, size_t nsize)
+{
+	void* result = NULL;
+
+	if(nsize == 0) {
+		// Freeing.
+	} else if(ptr && is_small(osize) && is_small(nsize)
+			&& size_class(osize) == size_class(nsize)) {
+		// Still fits in its block.
+		result = ptr;
+	} else if(ptr && !is_small(osize) && !is_small(nsize)) {
+		result = std::realloc(ptr, nsize);
+		if(!result) {
+			return NULL;
+		}
+	} else {
+		result = is_small(nsize) ? take_block(size_class(nsize)) : std::malloc(nsize);
+		if(!result) {
+			// Lua keeps the old block and collects before retrying.
+			return NULL;
+		}
+		++statistics_.allocations;
+		if(is_small(nsize)) {
+			++statistics_.small_blocks;
+		} else {
+			++statistics_.large_blocks;
+		}
+		if(ptr) {
+			std::memcpy(result, ptr, std::min(osize, nsize));
+		}
+	}
+
+	// Release the old block if it was not kept.
+	if(ptr && result != ptr) {
+		if(is_small(osize)) {
+			give_block(ptr, size_class(osize));
+			--statistics_.small_blocks;
+		} else if(nsize == 0 || is_small(nsize)) {
+			// (The blocks moved by realloc() are released by it.)
+			std::free(ptr);
+			--statistics_.large_blocks;
+		}
+	}
+
+	statistics_.bytes += nsize;
+	statistics_.bytes -= osize;
+	statistics_.peak_bytes = std::max(statistics_.peak_bytes, statistics_.bytes);
+	return result;
+}
+
+void* lua_allocator::take_block(const size_t size_class)
+{
+	free_block*& free_list = free_lists_[size_class];
+	if(!free_list) {
+		char* slab = static_cast<char*>(std::malloc(slab_size));
+		if(!slab) {
+			return NULL;
+		}
+		slabs_.push_back(slab);
+		statistics_.slab_bytes += slab_size;
+
+		// Carve the slab, keeping its first block in front.
+		const size_t size = block_size(size_class);
+		for(size_t offset = slab_size / size * size; offset != 0; ) {
+			offset -= size;
+			free_block* block = reinterpret_cast<free_block*>(slab + offset);
+			block->next = free_list;
+			free_list = block;
+		}
+	}
+
+	free_block* block = free_list;
+	free_list = block->next;
+	return block;
+}
+
+void lua_allocator::give_block(void* ptr, const size_t size_class)
+{
+	free_block* block = static_cast<free_block*>(ptr);
+	block->next = free_lists_[size_class];
+	free_lists_[size_class] = block;
+}
+
+std::string lua_allocator::report() const
+{
+	std::ostringstream stream;
+	stream << "memory used: " << statistics_.bytes / 1024 << " KiB"
+		<< ", at most " << statistics_.peak_bytes / 1024 << " KiB\n"
+		<< "slabs: " << statistics_.slab_bytes / 1024 << " KiB reserved for "
+		<< statistics_.small_blocks << " blocks of up to " << max_small_size << " bytes\n"
+		<< "heap: " << statistics_.large_blocks << " blocks\n"
+		<< "allocations: " << statistics_.allocations << "\n";
+	return stream.str();
+}
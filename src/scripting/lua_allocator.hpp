@@ -0,0 +1,84 @@
+/*
+   Copyright (C) 2015 by the Battle for Wesnoth Project
+   Part of the Battle for Wesnoth Project http://www.wesnoth.org/
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY.
+
+   See the COPYING file for more details.
+*/
+
+#ifndef LUA_ALLOCATOR_HPP_INCLUDED
+#define LUA_ALLOCATOR_HPP_INCLUDED
+
+#include <boost/noncopyable.hpp>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * The memory of a Lua state.
+ *
+ * The small blocks, making up most of the tables, closures and strings
+ * created by the scripts, come from slabs of blocks of the same size class;
+ * the others come from the heap. Lua gives the size of each block it frees
+ * or resizes, so the blocks need no header. The slabs are only released with
+ * the allocator, after the state is closed.
+ *
+ * An allocator serves a single Lua state, from the thread of that state.
+ */
+class lua_allocator : private boost::noncopyable
+{
+public:
+	lua_allocator();
+	~lua_allocator();
+
+	/** The lua_Alloc function for lua_newstate(), @a ud being the allocator. */
+	static void* allocate(void* ud, void* ptr, size_t osize, size_t nsize);
+
+	struct statistics
+	{
+		statistics();
+
+		/** The bytes used by Lua, now and at most. */
+		size_t bytes;
+		size_t peak_bytes;
+		/** The bytes reserved in slabs. */
+		size_t slab_bytes;
+		/** The blocks used, from the slabs and from the heap. */
+		size_t small_blocks;
+		size_t large_blocks;
+		/** The blocks allocated since the state was created. */
+		size_t allocations;
+	};
+
+	const statistics& get_statistics() const { return statistics_; }
+
+	/** A few lines describing the statistics. */
+	std::string report() const;
+
+private:
+	void* reallocate(void* ptr, size_t osize, size_t nsize);
+
+	/** Takes a block of size class @a size_class, adding a slab if needed. */
+	void* take_block(size_t size_class);
+	void give_block(void* ptr, size_t size_class);
+
+	struct free_block
+	{
+		free_block* next;
+	};
+
+	/** The free blocks of each size class. */
+	std::vector<free_block*> free_lists_;
+	std::vector<void*> slabs_;
+
+	statistics statistics_;
+};
+
+#endif
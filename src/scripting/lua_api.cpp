@@ -13,6 +13,7 @@
 */
 
 #include "lua_api.hpp"
+#include "lua_profiler.hpp"
 #include "lua_types.hpp"
 
 #include "lua_jailbreak_exception.hpp"  // for tlua_jailbreak_exception
@@ -70,6 +71,7 @@ bool luaW_pcall(lua_State *L
 	int error_handler_index = lua_gettop(L) - nArgs - 1;
 
 	// Call the function.
+	lua_profiler::entering_lua();
 	int res = lua_pcall(L, nArgs, nRets, -2 - nArgs);
 	tlua_jailbreak_exception::rethrow();
 
@@ -66,6 +66,8 @@ public:
 	~lua_unit();
 	bool on_map() const { return !ptr && side == 0; }
 	int on_recall_list() const { return side; }
+	/// Whether *this refers to the unit with underlying id @a u on the map.
+	bool is_map_proxy_of(size_t u) const { return on_map() && uid == u; }
 	unit_ptr get();
 
 	// Clobbers loc
@@ -27,11 +27,13 @@
 #include "scripting/debug_lua.hpp"
 #endif
 
+#include "scripting/lua_allocator.hpp"
 #include "scripting/lua_common.hpp"
 #include "scripting/lua_cpp_function.hpp"
 #include "scripting/lua_fileops.hpp"
 #include "scripting/lua_gui2.hpp"
 #include "scripting/lua_map_location_ops.hpp"
+#include "scripting/lua_profiler.hpp"
 #include "scripting/lua_rng.hpp"
 #include "scripting/lua_types.hpp"
 
@@ -131,15 +133,30 @@ int lua_kernel_base::intf_show_lua_console(lua_State *L)
 	return lua_gui2::show_lua_console(L, *video_, this);
 }
 
+int lua_kernel_base::intf_memory_report(lua_State *L)
+{
+	lua_pushstring(L, memory_report().c_str());
+	return 1;
+}
+
 // End Callback implementations
 
+static int panic(lua_State *L)
+{
+	ERR_LUA << "unprotected error in call to Lua API (" << lua_tostring(L, -1) << ")" << std::endl;
+	return 0;  // return to Lua to abort
+}
+
 lua_kernel_base::lua_kernel_base(CVideo * video)
- : mState(luaL_newstate())
+ : allocator_(new lua_allocator())
+ , mState(lua_newstate(&lua_allocator::allocate, allocator_.get()))
  , video_(video)
  , cmd_log_()
 {
 	get_lua_kernel_base_ptr(mState) = this;
 	lua_State *L = mState;
+	lua_atpanic(L, &panic);
+	lua_profiler::attach(L);
 
 	cmd_log_ << "Initializing " << my_name() << "...\n";
 
@@ -241,6 +258,7 @@ lua_kernel_base::lua_kernel_base(CVideo * video)
 		{ "require", 		boost::bind(&lua_kernel_base::intf_require, this, _1)},
 		{ "show_dialog",	boost::bind(&lua_kernel_base::intf_show_dialog, this, _1)},
 		{ "show_lua_console",	boost::bind(&lua_kernel_base::intf_show_lua_console, this, _1)},
+		{ "memory_report",	boost::bind(&lua_kernel_base::intf_memory_report, this, _1)},
 		{ NULL, NULL }
 	};
 
@@ -323,9 +341,31 @@ lua_kernel_base::lua_kernel_base(CVideo * video)
 
 lua_kernel_base::~lua_kernel_base()
 {
+	lua_profiler::detach(mState);
 	lua_close(mState);
 }
 
+void lua_kernel_base::set_gc_parameters(int pause, int step_multiplier)
+{
+	lua_gc(mState, LUA_GCSETPAUSE, pause);
+	lua_gc(mState, LUA_GCSETSTEPMUL, step_multiplier);
+}
+
+std::string lua_kernel_base::memory_report()
+{
+	std::ostringstream stream;
+	stream << my_name() << "\n"
+		<< "collector: " << lua_gc(mState, LUA_GCCOUNT, 0) << " KiB counted"
+		<< (lua_gc(mState, LUA_GCISRUNNING, 0) ? "" : ", stopped") << "\n"
+		<< allocator_->report();
+	return stream.str();
+}
+
+size_t lua_kernel_base::memory_usage() const
+{
+	return allocator_->get_statistics().bytes;
+}
+
 void lua_kernel_base::log_error(char const * msg, char const * context)
 {
 	ERR_LUA << context << ": " << msg;
@@ -365,6 +405,7 @@ bool lua_kernel_base::protected_call(lua_State * L, int nArgs, int nRets, error_
 	int error_handler_index = lua_gettop(L) - nArgs - 1;
 
 	// Call the function.
+	lua_profiler::entering_lua();
 	int errcode = lua_pcall(L, nArgs, nRets, -2 - nArgs);
 	tlua_jailbreak_exception::rethrow();
 
@@ -20,9 +20,11 @@
 #include <vector>
 #include "utils/boost_function_guarded.hpp"
 #include <boost/cstdint.hpp>
+#include <boost/scoped_ptr.hpp>
 
 struct lua_State;
 class CVideo;
+class lua_allocator;
 
 class lua_kernel_base {
 public:
@@ -63,7 +65,19 @@ public:
 	}
 
 	virtual boost::uint32_t get_random_seed();
+
+	/** Sets how much the memory may grow between two collections, and the speed of the collection relative to the allocations, both in percent (as collectgarbage("setpause") and collectgarbage("setstepmul")). */
+	void set_gc_parameters(int pause, int step_multiplier);
+
+	/** The memory used by this kernel, for the :lua debug commands. */
+	std::string memory_report();
+
+	/** The bytes allocated by the Lua state. */
+	size_t memory_usage() const;
 protected:
+	/// The memory of mState, declared before it to be created first.
+	boost::scoped_ptr<lua_allocator> allocator_;
+
 	lua_State *mState;
 
 	CVideo * video_;
@@ -116,6 +130,9 @@ protected:
 
 	// require (using lua_fileops, protected_call)
 	int intf_require(lua_State * L);
+
+	// Returns the memory_report() of this kernel
+	int intf_memory_report(lua_State * L);
 private:
 	static lua_kernel_base*& get_lua_kernel_base_ptr(lua_State *L);
 };
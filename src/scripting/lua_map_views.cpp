@@ -0,0 +1,317 @@
+/*
+   Copyright (C) 2015 by the Battle for Wesnoth Project
+   Part of the Battle for Wesnoth Project http://www.wesnoth.org/
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY.
+
+   See the COPYING file for more details.
+*/
+
+#include "scripting/lua_map_views.hpp"
+
+#include "game_board.hpp"
+#include "map.hpp"
+#include "pathfind/pathfind.hpp"
+#include "resources.hpp"
+
+#include <iterator>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "lua/lua.h"
+#include "lua/lauxlib.h"
+
+// Registry keys
+static const char * MoveMapView = "move map view";
+static const char * CostMapView = "cost map view";
+
+namespace {
+
+/** The costs of a full_cost_map, without the team it refers to. */
+struct cost_map_view
+{
+	cost_map_view(const pathfind::full_cost_map& m, int w, int h)
+		: costs(m.cost_map), w(w), h(h)
+	{}
+
+	std::pair<int, int> get_pair_at(int x, int y) const
+	{
+		if (x < 0 || x >= w || y < 0 || y >= h) {
+			return std::make_pair(-1, 0);
+		}
+		return costs[x + y * w];
+	}
+
+	std::vector<std::pair<int, int> > costs;
+	int w, h;
+};
+
+/** The hashing of location_set.lua, with C++ coordinates. */
+int hash_location(const map_location& loc)
+{
+	return (loc.x + 1) * 16384 + (loc.y + 1) + 2000;
+}
+
+map_location unhash_location(int hash)
+{
+	hash -= 2000;
+	return map_location(hash / 16384 - 1, hash % 16384 - 1);
+}
+
+map_location check_location(lua_State* L, int index)
+{
+	const int x = luaL_checkinteger(L, index);
+	const int y = luaL_checkinteger(L, index + 1);
+	return map_location(x - 1, y - 1);
+}
+
+void push_location(lua_State* L, const map_location& loc)
+{
+	lua_createtable(L, 0, 2);
+	lua_pushinteger(L, loc.x + 1);
+	lua_setfield(L, -2, "x");
+	lua_pushinteger(L, loc.y + 1);
+	lua_setfield(L, -2, "y");
+}
+
+/** Pushes the locations mapped from @a loc as an array, or nil. */
+void push_targets(lua_State* L, const ai::move_map& m, const map_location& loc)
+{
+	typedef ai::move_map::const_iterator iterator;
+	const std::pair<iterator, iterator> range = m.equal_range(loc);
+	if (range.first == range.second) {
+		lua_pushnil(L);
+		return;
+	}
+	lua_createtable(L, std::distance(range.first, range.second), 0);
+	int index = 1;
+	for (iterator i = range.first; i != range.second; ++i, ++index) {
+		push_location(L, i->second);
+		lua_rawseti(L, -2, index);
+	}
+}
+
+ai::move_map& check_move_map(lua_State* L)
+{
+	return *static_cast<ai::move_map *>(luaL_checkudata(L, 1, MoveMapView));
+}
+
+cost_map_view& check_cost_map(lua_State* L)
+{
+	return *static_cast<cost_map_view *>(luaL_checkudata(L, 1, CostMapView));
+}
+
+}
+
+/**
+ * Gets the locations mapped from a hex, or a method (__index metamethod).
+ * - Arg 1: move map view.
+ * - Arg 2: hashed location, or the name of a method.
+ */
+static int impl_move_map_get(lua_State* L)
+{
+	const ai::move_map& m = check_move_map(L);
+	if (lua_type(L, 2) == LUA_TNUMBER) {
+		push_targets(L, m, unhash_location(lua_tointeger(L, 2)));
+		return 1;
+	}
+	lua_getmetatable(L, 1);
+	lua_pushvalue(L, 2);
+	lua_rawget(L, -2);
+	return 1;
+}
+
+/**
+ * Iterates over the hexes with locations mapped from them (__pairs metamethod).
+ * - Ret 1, 2, 3: an iterator function, the view and nil.
+ */
+static int impl_move_map_next(lua_State* L)
+{
+	const ai::move_map& m = check_move_map(L);
+	ai::move_map::const_iterator i = lua_isnoneornil(L, 2) ? m.begin() :
+		m.upper_bound(unhash_location(luaL_checkinteger(L, 2)));
+	if (i == m.end()) {
+		return 0;
+	}
+	lua_pushinteger(L, hash_location(i->first));
+	push_targets(L, m, i->first);
+	return 2;
+}
+
+static int impl_move_map_pairs(lua_State* L)
+{
+	check_move_map(L);
+	lua_pushcfunction(L, &impl_move_map_next);
+	lua_pushvalue(L, 1);
+	lua_pushnil(L);
+	return 3;
+}
+
+/**
+ * Destroys a move map view before it is collected (__gc metamethod).
+ */
+static int impl_move_map_collect(lua_State* L)
+{
+	using ai::move_map;
+	move_map& m = check_move_map(L);
+	m.~move_map();
+	return 0;
+}
+
+/**
+ * - Args 1, 2, 3: view, x, y.
+ * - Ret 1: array of the locations mapped from (x, y), or nil.
+ */
+static int intf_move_map_get(lua_State* L)
+{
+	push_targets(L, check_move_map(L), check_location(L, 2));
+	return 1;
+}
+
+/**
+ * - Args 1, 2, 3: view, x, y.
+ * - Ret 1: number of locations mapped from (x, y).
+ */
+static int intf_move_map_count(lua_State* L)
+{
+	lua_pushinteger(L, check_move_map(L).count(check_location(L, 2)));
+	return 1;
+}
+
+/**
+ * - Args 1, 2, 3, 4, 5: view, x, y, x2, y2.
+ * - Ret 1: whether (x2, y2) is mapped from (x, y).
+ */
+static int intf_move_map_has(lua_State* L)
+{
+	typedef ai::move_map::const_iterator iterator;
+	const ai::move_map& m = check_move_map(L);
+	const map_location to = check_location(L, 4);
+	const std::pair<iterator, iterator> range = m.equal_range(check_location(L, 2));
+	for (iterator i = range.first; i != range.second; ++i) {
+		if (i->second == to) {
+			lua_pushboolean(L, true);
+			return 1;
+		}
+	}
+	lua_pushboolean(L, false);
+	return 1;
+}
+
+/**
+ * - Arg 1: view.
+ * - Ret 1: number of pairs of locations.
+ */
+static int intf_move_map_size(lua_State* L)
+{
+	lua_pushinteger(L, check_move_map(L).size());
+	return 1;
+}
+
+/**
+ * Destroys a cost map view before it is collected (__gc metamethod).
+ */
+static int impl_cost_map_collect(lua_State* L)
+{
+	cost_map_view& m = check_cost_map(L);
+	m.~cost_map_view();
+	return 0;
+}
+
+/**
+ * - Args 1, 2, 3: view, x, y.
+ * - Ret 1: summed cost of the units to reach (x, y), -1 if none can.
+ */
+static int intf_cost_map_cost(lua_State* L)
+{
+	const map_location loc = check_location(L, 2);
+	lua_pushinteger(L, check_cost_map(L).get_pair_at(loc.x, loc.y).first);
+	return 1;
+}
+
+/**
+ * - Args 1, 2, 3: view, x, y.
+ * - Ret 1: number of units that can reach (x, y).
+ */
+static int intf_cost_map_reach(lua_State* L)
+{
+	const map_location loc = check_location(L, 2);
+	lua_pushinteger(L, check_cost_map(L).get_pair_at(loc.x, loc.y).second);
+	return 1;
+}
+
+/**
+ * - Args 1, 2, 3: view, x, y.
+ * - Ret 1: average cost of the units to reach (x, y), -1 if none can.
+ */
+static int intf_cost_map_average(lua_State* L)
+{
+	const map_location loc = check_location(L, 2);
+	const std::pair<int, int> p = check_cost_map(L).get_pair_at(loc.x, loc.y);
+	lua_pushnumber(L, p.second == 0 ? -1 : static_cast<double>(p.first) / p.second);
+	return 1;
+}
+
+namespace lua_map_views {
+
+	std::string register_metatables(lua_State * L)
+	{
+		luaL_newmetatable(L, MoveMapView);
+
+		static luaL_Reg const move_map_callbacks[] = {
+			{ "__gc",           &impl_move_map_collect},
+			{ "__index",        &impl_move_map_get},
+			{ "__pairs",        &impl_move_map_pairs},
+			{ "get",            &intf_move_map_get},
+			{ "count",          &intf_move_map_count},
+			{ "has",            &intf_move_map_has},
+			{ "size",           &intf_move_map_size},
+			{ NULL, NULL }
+		};
+		luaL_setfuncs(L, move_map_callbacks, 0);
+
+		lua_pushstring(L, "move map view");
+		lua_setfield(L, -2, "__metatable");
+		lua_pop(L, 1);
+
+		luaL_newmetatable(L, CostMapView);
+
+		static luaL_Reg const cost_map_callbacks[] = {
+			{ "__gc",           &impl_cost_map_collect},
+			{ "cost",           &intf_cost_map_cost},
+			{ "reach",          &intf_cost_map_reach},
+			{ "average",        &intf_cost_map_average},
+			{ NULL, NULL }
+		};
+		luaL_setfuncs(L, cost_map_callbacks, 0);
+
+		lua_pushvalue(L, -1); //make a copy of this table, set it to be its own __index table
+		lua_setfield(L, -2, "__index");
+
+		lua_pushstring(L, "cost map view");
+		lua_setfield(L, -2, "__metatable");
+		lua_pop(L, 1);
+
+		return "Adding move map and cost map view metatables...\n";
+	}
+}
+
+void luaW_pushmovemapview(lua_State *L, const ai::move_map & m)
+{
+	new(lua_newuserdata(L, sizeof(ai::move_map))) ai::move_map(m);
+	luaL_setmetatable(L, MoveMapView);
+}
+
+void luaW_pushcostmapview(lua_State *L, const pathfind::full_cost_map & m)
+{
+	const gamemap& map = resources::gameboard->map();
+	new(lua_newuserdata(L, sizeof(cost_map_view))) cost_map_view(m, map.w(), map.h());
+	luaL_setmetatable(L, CostMapView);
+}
@@ -0,0 +1,51 @@
+/*
+   Copyright (C) 2015 by the Battle for Wesnoth Project
+   Part of the Battle for Wesnoth Project http://www.wesnoth.org/
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY.
+
+   See the COPYING file for more details.
+*/
+
+#ifndef LUA_MAP_VIEWS_HPP_INCLUDED
+#define LUA_MAP_VIEWS_HPP_INCLUDED
+
+#include "ai/game_info.hpp"
+
+struct lua_State;
+namespace pathfind { struct full_cost_map; }
+
+#include <string>
+
+/**
+ * This namespace contains bindings for lua to hold a move map or a cost
+ * map as userdata, and to look up single hexes in it. Unlike tables, the
+ * views hold the map as is, and only build the values that get indexed.
+ *
+ * A move map view m supports, with Lua coordinates:
+ * - m[hash] and m:get(x, y): an array of {x=, y=} tables, or nil, where
+ *   hash is (x * 16384) + y + 2000 as in location_set.lua;
+ * - m:count(x, y): how many locations are mapped from (x, y);
+ * - m:has(x, y, x2, y2): whether (x2, y2) is mapped from (x, y);
+ * - m:size(): the number of pairs;
+ * - pairs(m): the hashes and arrays, like the tables of get_new_dst_src().
+ *
+ * A cost map view c supports c:cost(x, y), c:reach(x, y) and
+ * c:average(x, y), as pathfind::full_cost_map does.
+ */
+namespace lua_map_views {
+	std::string register_metatables(lua_State *);
+} //end namespace lua_map_views
+
+/** Creates a view on a copy of @a m. */
+void luaW_pushmovemapview(lua_State *, const ai::move_map & m);
+
+/** Creates a view on a copy of the costs of @a m. */
+void luaW_pushcostmapview(lua_State *, const pathfind::full_cost_map & m);
+
+#endif
@@ -0,0 +1,224 @@
+/*
+   Copyright (C) 2015 by the Battle for Wesnoth Project
+   Part of the Battle for Wesnoth Project http://www.wesnoth.org/
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY.
+
+   See the COPYING file for more details.
+*/
+
+#include "scripting/lua_profiler.hpp"
+
+#include "config.hpp"
+#include "filesystem.hpp"
+#include "log.hpp"
+#include "serialization/parser.hpp"
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/foreach.hpp>
+
+#include <algorithm>
+#include <map>
+#include <sstream>
+#include <vector>
+
+#include "lua/lua.h"
+
+static lg::log_domain log_scripting_lua("scripting/lua");
+#define LOG_LUA LOG_STREAM(info, log_scripting_lua)
+#define ERR_LUA LOG_STREAM(err, log_scripting_lua)
+
+bool lua_profiler::enabled_ = false;
+
+namespace {
+
+/** The instructions run between two samples. */
+const int sample_instructions = 1000;
+
+struct record
+{
+	record() : samples(0), seconds(0)
+	{
+	}
+
+	size_t samples;
+	double seconds;
+};
+
+typedef std::map<std::string, record> record_map;
+
+record_map functions, chunks, contexts;
+
+/** The states profiled. */
+std::vector<lua_State*> states;
+
+/** What the Lua code is run for, innermost last. */
+std::vector<std::string> context_stack;
+
+/** The time of the previous sample, or of the entry into Lua after it. */
+boost::posix_time::ptime last_sample;
+
+boost::posix_time::ptime now()
+{
+	return boost::posix_time::microsec_clock::universal_time();
+}
+
+void add(record& r, const double seconds)
+{
+	++r.samples;
+	r.seconds += seconds;
+}
+
+void sample(lua_State* L, lua_Debug* ar)
+{
+	const boost::posix_time::ptime time = now();
+	const double seconds = last_sample.is_not_a_date_time() ? 0 :
+		(time - last_sample).total_microseconds() / 1e6;
+	last_sample = time;
+
+	if(!lua_getinfo(L, "Sn", ar)) {
+		return;
+	}
+	const std::string chunk = ar->short_src;
+	std::ostringstream function;
+	function << chunk << ':' << ar->linedefined << ' ';
+	if(ar->what && std::string(ar->what) == "main") {
+		function << "(main chunk)";
+	} else {
+		function << (ar->name ? ar->name : "(anonymous)");
+	}
+
+	add(functions[function.str()], seconds);
+	add(chunks[chunk], seconds);
+	add(contexts[context_stack.empty() ? "(none)" : context_stack.back()], seconds);
+}
+
+void set_hook(lua_State* L, const bool enabled)
+{
+	if(enabled) {
+		lua_sethook(L, &sample, LUA_MASKCOUNT, sample_instructions);
+	} else {
+		lua_sethook(L, NULL, 0, 0);
+	}
+}
+
+void write_records(config& cfg, const std::string& tag, const record_map& records)
+{
+	BOOST_FOREACH(const record_map::value_type& r, records) {
+		config& child = cfg.add_child(tag);
+		child["name"] = r.first;
+		child["samples"] = static_cast<int>(r.second.samples);
+		child["seconds"] = r.second.seconds;
+	}
+}
+
+/** The @a count records of @a records taking the most time, a line each. */
+void write_top(std::ostream& out, const char* title, const record_map& records, size_t count)
+{
+	std::vector<std::pair<double, const record_map::value_type*> > sorted;
+	BOOST_FOREACH(const record_map::value_type& r, records) {
+		sorted.push_back(std::make_pair(r.second.seconds, &r));
+	}
+	std::sort(sorted.rbegin(), sorted.rend());
+
+	out << '\n' << title << ':';
+	count = std::min(count, sorted.size());
+	for(size_t i = 0; i != count; ++i) {
+		const record_map::value_type& r = *sorted[i].second;
+		out << "\n  " << r.first << ": " << r.second.seconds << " s, "
+			<< r.second.samples << " samples";
+	}
+}
+
+} // end anonymous namespace
+
+lua_profiler::context::context(const char* what, const std::string& name)
+	: entered_(enabled_)
+{
+	if(entered_) {
+		context_stack.push_back(name.empty() ? std::string(what) : std::string(what) + ' ' + name);
+	}
+}
+
+lua_profiler::context::~context()
+{
+	if(entered_ && !context_stack.empty()) {
+		context_stack.pop_back();
+	}
+}
+
+void lua_profiler::attach(lua_State* L)
+{
+	states.push_back(L);
+	if(enabled_) {
+		set_hook(L, true);
+	}
+}
+
+void lua_profiler::detach(lua_State* L)
+{
+	states.erase(std::remove(states.begin(), states.end(), L), states.end());
+}
+
+void lua_profiler::restart_clock()
+{
+	last_sample = now();
+}
+
+void lua_profiler::set_enabled(bool enabled)
+{
+	if(enabled == enabled_) {
+		return;
+	}
+	LOG_LUA << (enabled ? "enabling" : "disabling") << " the Lua profiler" << std::endl;
+	enabled_ = enabled;
+	// (The coroutines get the hook of the state creating them.)
+	BOOST_FOREACH(lua_State* L, states) {
+		set_hook(L, enabled);
+	}
+	last_sample = boost::posix_time::ptime();
+}
+
+void lua_profiler::reset()
+{
+	functions.clear();
+	chunks.clear();
+	contexts.clear();
+}
+
+config lua_profiler::to_config()
+{
+	config res;
+	config& profile = res.add_child("lua_profile");
+	write_records(profile, "function", functions);
+	write_records(profile, "chunk", chunks);
+	write_records(profile, "context", contexts);
+	return res;
+}
+
+std::string lua_profiler::summary()
+{
+	std::ostringstream res;
+	res << (enabled_ ? "Lua profiling is on." : "Lua profiling is off.");
+	write_top(res, "functions", functions, 10);
+	write_top(res, "chunks", chunks, 5);
+	write_top(res, "contexts", contexts, 5);
+	return res.str();
+}
+
+void lua_profiler::write_report()
+{
+	const std::string path = filesystem::get_user_data_dir() + "/lua_profile.cfg";
+	try {
+		filesystem::scoped_ostream out = filesystem::ostream_file(path);
+		write(*out, to_config());
+		LOG_LUA << "wrote the Lua profile to " << path << std::endl;
+	} catch(filesystem::io_exception& e) {
+		ERR_LUA << "could not write the Lua profile: " << e.what() << std::endl;
+	}
+}
@@ -0,0 +1,93 @@
+/*
+   Copyright (C) 2015 by the Battle for Wesnoth Project
+   Part of the Battle for Wesnoth Project http://www.wesnoth.org/
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY.
+
+   See the COPYING file for more details.
+*/
+
+#ifndef LUA_PROFILER_HPP_INCLUDED
+#define LUA_PROFILER_HPP_INCLUDED
+
+#include <boost/noncopyable.hpp>
+
+#include <string>
+
+class config;
+struct lua_State;
+
+/**
+ * Where the time of the Lua scripts goes.
+ *
+ * While profiling, a count hook samples the function each Lua state runs
+ * every few thousand instructions, and accounts the time since the previous
+ * sample to it, to its chunk (a .lua file or the code of a [lua] tag) and to
+ * what had the script run, such as a WML event or the AI. The time spent in
+ * the C functions called is accounted to their Lua caller.
+ *
+ * Profiling is off unless enabled with the :lua_profile command; no hook is
+ * set then, and the entries into Lua only cost a flag test. It must only be
+ * used from the main thread.
+ */
+class lua_profiler
+{
+public:
+	/**
+	 * Accounts the Lua code run during its lifetime to @a what (and
+	 * @a name), rather than to what was accounted to before.
+	 */
+	class context
+		: private boost::noncopyable
+	{
+	public:
+		context(const char* what, const std::string& name);
+		~context();
+
+	private:
+		bool entered_;
+	};
+
+	/** The states of the kernels, profiled while they exist. */
+	static void attach(lua_State* L);
+	static void detach(lua_State* L);
+
+	/** Called before each call of a Lua function from C++. */
+	static void entering_lua()
+	{
+		if(enabled_) {
+			restart_clock();
+		}
+	}
+
+	static bool enabled() { return enabled_; }
+	static void set_enabled(bool enabled);
+
+	/** Drops everything recorded so far. */
+	static void reset();
+
+	/**
+	 * The records as
+	 * [lua_profile] [function] name= [chunk] name= [context] name= [/lua_profile],
+	 * each of them with samples= and seconds=.
+	 */
+	static config to_config();
+
+	/** A short text summary of the functions taking the most time. */
+	static std::string summary();
+
+	/** Writes lua_profile.cfg to the userdata directory. */
+	static void write_report();
+
+private:
+	static void restart_clock();
+
+	static bool enabled_;
+};
+
+#endif
@@ -21,6 +21,7 @@ typedef void* luatypekey;
 // a drawback is, that these are now normal static variables wich are initialised at initialisation time (so you shoudn't use these at/before initialisation time).
 extern luatypekey const executeKey;
 extern luatypekey const getunitKey;
+extern luatypekey const unitproxyKey;
 extern luatypekey const unitvarKey;
 extern luatypekey const ustatusKey;
 extern luatypekey const uattacksKey;
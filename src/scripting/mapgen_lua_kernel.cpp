@@ -19,12 +19,19 @@
 #include "log.hpp"
 #include "scripting/lua_api.hpp"
 #include "scripting/lua_common.hpp"
+#include "scripting/lua_cpp_function.hpp"
+#include "scripting/lua_profiler.hpp"
 #include "scripting/lua_rng.hpp"
+#include "thread.hpp"
 
+#include <algorithm>
 #include <ostream>
 #include <string>
+#include <vector>
 #include <boost/bind.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
 
+#include "lua/lauxlib.h"
 #include "lua/lua.h"
 
 static lg::log_domain log_mapgen("mapgen");
@@ -32,14 +39,28 @@ static lg::log_domain log_mapgen("mapgen");
 #define LOG_NG LOG_STREAM(info, log_mapgen)
 #define DBG_NG LOG_STREAM(debug, log_mapgen)
 
+static lg::log_domain log_scripting_lua("scripting/lua");
+
 struct lua_State;
 
 mapgen_lua_kernel::mapgen_lua_kernel()
 	: lua_kernel_base(NULL)
 	, random_seed_()
+	, worker_(false)
 {
 	lua_State *L = mState;
 	lua_settop(L, 0);
+
+	lua_cpp::Reg const cpp_callbacks[] = {
+		{ "generate_parallel",	boost::bind(&mapgen_lua_kernel::intf_generate_parallel, this, _1)},
+		{ NULL, NULL }
+	};
+	lua_getglobal(L, "wesnoth");
+	lua_cpp::set_functions(L, cpp_callbacks, 0);
+	lua_pop(L, 1);
+
+	// The generators run as a batch, so the collections can be fewer and longer.
+	set_gc_parameters(300, 400);
 }
 
 void mapgen_lua_kernel::run_generator(const char * prog, const config & generator)
@@ -97,3 +118,148 @@ boost::uint32_t mapgen_lua_kernel::get_random_seed()
 		return lua_kernel_base::get_random_seed();
 	}
 }
+
+static void store_error(std::string * error, char const * msg, char const * context)
+{
+	*error = std::string(context) + ": " + msg;
+}
+
+bool mapgen_lua_kernel::prepare(const char * prog, const config & generator, boost::uint32_t seed, std::string & error)
+{
+	worker_ = true;
+	random_seed_ = seed;
+	if (!load_string(prog, boost::bind(&store_error, &error, _1, _2))) {
+		return false;
+	}
+	luaW_pushconfig(mState, generator);
+	return true;
+}
+
+bool mapgen_lua_kernel::run_prepared(std::string & error)
+{
+	return protected_call(1, 1, boost::bind(&store_error, &error, _1, _2));
+}
+
+bool mapgen_lua_kernel::transfer_result(lua_State * L, std::string & error)
+{
+	if (lua_isstring(mState, -1)) {
+		size_t len;
+		char const * str = lua_tolstring(mState, -1, &len);
+		lua_pushlstring(L, str, len);
+		return true;
+	}
+
+	config result;
+	if (!lua_istable(mState, -1) || !luaW_toconfig(mState, -1, result)) {
+		error = "bad return value: expected a string or a config, found a ";
+		error += lua_typename(mState, lua_type(mState, -1));
+		return false;
+	}
+	luaW_pushconfig(L, result);
+	return true;
+}
+
+namespace {
+
+/** The scripts of a batch of generate_parallel(), one per kernel. */
+class parallel_generation : public threading::parallel_job
+{
+public:
+	parallel_generation(boost::ptr_vector<mapgen_lua_kernel> & kernels,
+			std::vector<std::string> & errors, std::vector<char> & succeeded)
+		: kernels_(kernels), errors_(errors), succeeded_(succeeded)
+	{}
+
+	virtual void run(size_t index)
+	{
+		if (!succeeded_[index]) {
+			return;
+		}
+		// A failure must not escape, or run_parallel() would run the script again.
+		try {
+			succeeded_[index] = kernels_[index].run_prepared(errors_[index]);
+		} catch (std::exception & e) {
+			errors_[index] = e.what();
+			succeeded_[index] = false;
+		} catch (...) {
+			errors_[index] = "unknown exception";
+			succeeded_[index] = false;
+		}
+	}
+
+private:
+	boost::ptr_vector<mapgen_lua_kernel> & kernels_;
+	std::vector<std::string> & errors_;
+	std::vector<char> & succeeded_;
+};
+
+} // end anonymous namespace
+
+/**
+ * Runs a generator script once for each of several configs, each time in a
+ * new kernel, on as many threads as there are cores.
+ * - Arg 1: the script, as a string, getting the config as argument.
+ * - Arg 2: the configs, as an array.
+ * - Arg 3: (optional) the most threads to use.
+ * - Ret 1: the maps or scenarios returned by the script, by index.
+ * - Ret 2: the error messages of the scripts failing, by index.
+ * The kernels share nothing with this one, only the configs and the
+ * results are copied between them.
+ */
+int mapgen_lua_kernel::intf_generate_parallel(lua_State * L)
+{
+	char const * prog = luaL_checkstring(L, 1);
+	luaL_checktype(L, 2, LUA_TTABLE);
+	unsigned threads = std::max(0, luaL_optint(L, 3, 0));
+	if (worker_) {
+		return luaL_error(L, "generate_parallel cannot be called from the scripts it runs");
+	}
+
+	const size_t count = lua_rawlen(L, 2);
+	std::vector<config> inputs(count);
+	for (size_t i = 0; i != count; ++i) {
+		lua_rawgeti(L, 2, i + 1);
+		if (!luaW_toconfig(L, -1, inputs[i])) {
+			return luaL_argerror(L, 2, "expected an array of configs");
+		}
+		lua_pop(L, 1);
+	}
+
+	if (threads == 0) {
+		threads = threading::hardware_concurrency();
+	}
+	// The log streams and the profiler are not shared safely between threads.
+	if (!lg::debug.dont_log(log_scripting_lua) || !lg::debug.dont_log(log_mapgen)
+			|| lua_profiler::enabled()) {
+		threads = 1;
+	}
+
+	lua_createtable(L, count, 0);
+	lua_newtable(L);
+	// A kernel for each thread at a time, rather than all of them at once.
+	for (size_t first = 0; first < count; first += threads) {
+		const size_t batch = std::min<size_t>(threads, count - first);
+
+		// The kernels load their libraries, so they are made on this thread.
+		boost::ptr_vector<mapgen_lua_kernel> kernels;
+		std::vector<std::string> errors(batch);
+		std::vector<char> succeeded(batch);
+		for (size_t i = 0; i != batch; ++i) {
+			kernels.push_back(new mapgen_lua_kernel());
+			succeeded[i] = kernels.back().prepare(prog, inputs[first + i], get_random_seed(), errors[i]);
+		}
+
+		parallel_generation job(kernels, errors, succeeded);
+		threading::run_parallel(job, batch, threads);
+
+		for (size_t i = 0; i != batch; ++i) {
+			if (succeeded[i] && kernels[i].transfer_result(L, errors[i])) {
+				lua_rawseti(L, -3, first + i + 1);
+			} else {
+				lua_pushstring(L, errors[i].c_str());
+				lua_rawseti(L, -2, first + i + 1);
+			}
+		}
+	}
+	return 2;
+}
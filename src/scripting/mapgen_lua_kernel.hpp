@@ -34,9 +34,27 @@ public:
 	config create_scenario(const char * prog, const config & generator, boost::optional<boost::uint32_t> seed); // throws game::lua_error
 	
 	virtual boost::uint32_t get_random_seed();
+
+	/**
+	 * Loads @a prog and pushes @a generator as its argument, for
+	 * run_prepared(). This kernel then draws its seeds from @a seed.
+	 */
+	bool prepare(const char * prog, const config & generator, boost::uint32_t seed, std::string & error);
+	/**
+	 * Runs the function prepared and leaves its result on the stack.
+	 * Only this kernel is touched, so several kernels can run at the same
+	 * time on different threads.
+	 */
+	bool run_prepared(std::string & error);
+	/** Moves the map or scenario returned by run_prepared() to @a L. */
+	bool transfer_result(lua_State * L, std::string & error);
 private:
 	void run_generator(const char * prog, const config & generator);
 	boost::optional<boost::uint32_t> random_seed_;
+	/** Whether this kernel runs a script for generate_parallel(). */
+	bool worker_;
+
+	int intf_generate_parallel(lua_State * L);
 };
 
 #endif
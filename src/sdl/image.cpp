@@ -21,7 +21,9 @@
 #include "sdl/utils.hpp"
 #include "video.hpp"
 
+#include <algorithm>
 #include <cassert>
+#include <vector>
 
 #ifdef SDL_GPU
 #include "rect.hpp"
@@ -193,8 +195,14 @@ timage &timage::operator =(const timage &texture)
 
 void timage::draw(CVideo &video, const int x, const int y)
 {
-	GPU_SetImageFilter(image_, smooth_ ? GPU_FILTER_LINEAR : GPU_FILTER_NEAREST);
-	GPU_SetWrapMode(image_, hwrap_, vwrap_);
+	// Both calls flush the pending blits, even when nothing changes.
+	const GPU_FilterEnum filter = smooth_ ? GPU_FILTER_LINEAR : GPU_FILTER_NEAREST;
+	if (image_->filter_mode != filter) {
+		GPU_SetImageFilter(image_, filter);
+	}
+	if (image_->wrap_mode_x != hwrap_ || image_->wrap_mode_y != vwrap_) {
+		GPU_SetWrapMode(image_, hwrap_, vwrap_);
+	}
 	video.set_texture_color_modulation(red_mod_, green_mod_, blue_mod_, alpha_mod_);
 	video.set_texture_submerge(float(submerge_));
 	video.set_texture_effects(effects_);
@@ -392,6 +400,51 @@ GPU_Image *timage::raw() const
 	return image_;
 }
 
+ttexture_atlas::ttexture_atlas(Uint16 size)
+	: size_(size)
+	, page_()
+	, x_(0)
+	, y_(0)
+	, row_height_(0)
+{
+}
+
+timage ttexture_atlas::add(const surface &source)
+{
+	// A transparent pixel between the areas keeps the linear filter from
+	// picking up the neighbouring images.
+	static const Uint16 gap = 1;
+
+	if (source.null() || source->w + gap > size_ || source->h + gap > size_) {
+		return timage();
+	}
+
+	if (x_ + source->w > size_) {
+		x_ = 0;
+		y_ += row_height_;
+		row_height_ = 0;
+	}
+	if (page_.null() || y_ + source->h > size_) {
+		page_ = timage(size_, size_);
+		// The new texture isn't initialized.
+		const std::vector<unsigned char> blank(size_ * size_ * 4, 0);
+		GPU_UpdateImageBytes(page_.raw(), NULL, &blank[0], size_ * 4);
+		x_ = 0;
+		y_ = 0;
+		row_height_ = 0;
+	}
+
+	GPU_Rect area = create_gpu_rect(x_, y_, source->w, source->h);
+	GPU_UpdateSubImage(page_.raw(), &area, source, NULL);
+
+	timage result(page_);
+	result.set_clip(sdl::create_rect(x_, y_, source->w, source->h));
+
+	x_ += source->w + gap;
+	row_height_ = std::max<Uint16>(row_height_, source->h + gap);
+	return result;
+}
+
 }
 
 #endif
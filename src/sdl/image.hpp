@@ -24,6 +24,8 @@
 #include "gpu.hpp"
 #include <string>
 
+#include <boost/noncopyable.hpp>
+
 struct surface;
 class CVideo;
 
@@ -287,6 +289,37 @@ private:
 	/** Shader effects (flip, flop, grayscale). */
 	int effects_;
 };
+
+/**
+ * Packs small surfaces into a few large textures.
+ *
+ * The textures returned by @ref add() share their GPU image and only differ
+ * by their clip area. Blitting several of them in a row doesn't bind another
+ * texture, which lets SDL_gpu send all of them to the GPU in one draw call.
+ */
+class ttexture_atlas : private boost::noncopyable
+{
+public:
+	/** @param size               The width and height of the pages. */
+	explicit ttexture_atlas(Uint16 size);
+
+	/**
+	 * Copies @a source to a free area of the atlas.
+	 *
+	 * @returns                   A texture showing that area, or a null
+	 *                            texture if @a source is too large.
+	 */
+	timage add(const surface &source);
+
+private:
+	Uint16 size_;
+
+	/** The page being filled, the older ones live as long as their textures. */
+	timage page_;
+
+	/** Where the next surface goes, and the height of the current row. */
+	Uint16 x_, y_, row_height_;
+};
 }
 #endif
 
@@ -13,6 +13,7 @@
 */
 
 #include "shader.hpp"
+#include <algorithm>
 #include <iostream>
 #include "image.hpp"
 #include "../image.hpp"
@@ -29,6 +30,9 @@ shader_program::shader_program(const std::string &vsrc, const std::string &fsrc)
 	, attr_color_mod_(0)
 	, attr_submerge_(0)
 	, attr_effects_(0)
+	, color_mod_()
+	, submerge_(0)
+	, effects_(0)
 	, uni_overlay_(0)
 	, overlay_image_()
 	, refcount_(new unsigned(1))
@@ -69,6 +73,9 @@ shader_program::shader_program()
 	, attr_color_mod_(0)
 	, attr_submerge_(0)
 	, attr_effects_(0)
+	, color_mod_()
+	, submerge_(0)
+	, effects_(0)
 	, uni_overlay_(0)
 	, overlay_image_()
 	, refcount_(new unsigned(1))
@@ -93,10 +100,14 @@ shader_program::shader_program(const shader_program &prog)
 	, attr_color_mod_(prog.attr_color_mod_)
 	, attr_submerge_(prog.attr_submerge_)
 	, attr_effects_(prog.attr_effects_)
+	, color_mod_()
+	, submerge_(prog.submerge_)
+	, effects_(prog.effects_)
 	, uni_overlay_(prog.uni_overlay_)
 	, overlay_image_(prog.overlay_image_)
 	, refcount_(prog.refcount_)
 {
+	std::copy(prog.color_mod_, prog.color_mod_ + 4, color_mod_);
 	(*refcount_)++;
 }
 
@@ -116,6 +127,9 @@ void shader_program::activate()
 								 "vert_texture_pos", "vert_draw_color",
 								 "model_view_proj");
 	GPU_ActivateShaderProgram(program_object_, &block_);
+	GPU_SetAttributefv(attr_color_mod_, 4, color_mod_);
+	GPU_SetAttributef(attr_submerge_, submerge_);
+	GPU_SetAttributei(attr_effects_, effects_);
 	//NOTE: this line can be removed once we made sure that a sane overlay
 	//      will be set before rendering anything.
 	set_overlay(image::get_texture("misc/blank.png"));
@@ -130,22 +144,33 @@ void shader_program::deactivate()
 
 void shader_program::set_color_mod(int r, int g, int b, int a)
 {
-	static float color_mod[4];
-	color_mod[0] = float(r) / 255;
-	color_mod[1] = float(g) / 255;
-	color_mod[2] = float(b) / 255;
-	color_mod[3] = float(a) / 255;
+	const float color_mod[4] = {
+		float(r) / 255, float(g) / 255, float(b) / 255, float(a) / 255 };
+	if (std::equal(color_mod, color_mod + 4, color_mod_)) {
+		return;
+	}
+	std::copy(color_mod, color_mod + 4, color_mod_);
 
-	GPU_SetAttributefv(attr_color_mod_, 4, color_mod);
+	GPU_SetAttributefv(attr_color_mod_, 4, color_mod_);
 }
 
 void shader_program::set_submerge(float val)
 {
+	if (val == submerge_) {
+		return;
+	}
+	submerge_ = val;
+
 	GPU_SetAttributef(attr_submerge_, val);
 }
 
 void shader_program::set_effects(int effects)
 {
+	if (effects == effects_) {
+		return;
+	}
+	effects_ = effects;
+
 	GPU_SetAttributei(attr_effects_, effects);
 }
 
@@ -53,6 +53,12 @@ private:
 	Uint32 program_object_, vertex_object_, fragment_object_;
 	GPU_ShaderBlock block_;
 	int attr_color_mod_, attr_submerge_, attr_effects_;
+	/**
+	 * The values of the attributes. Setting one flushes the blits SDL_gpu
+	 * has batched, so unchanged values aren't set again.
+	 */
+	float color_mod_[4], submerge_;
+	int effects_;
 	int uni_overlay_;
 	// we need to retain a copy of the overlay texture to prevent it from
 	// getting deleted
@@ -35,6 +35,10 @@
 
 #include <boost/math/constants/constants.hpp>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 surface_lock::surface_lock(surface &surf) : surface_(surf), locked_(false)
 {
 	if (SDL_MUSTLOCK(surface_))
@@ -146,6 +150,12 @@ static SDL_PixelFormat& get_neutral_pixel_format()
 		return format;
 	}
 
+/**
+ * Sets the format up before main(), as the tools convert surfaces on
+ * several threads at once.
+ */
+static const SDL_PixelFormat& neutral_pixel_format_init = get_neutral_pixel_format();
+
 surface make_neutral_surface(const surface &surf)
 {
 	if(surf == NULL) {
@@ -901,6 +911,70 @@ surface tile_surface(const surface& surf, int w, int h, bool optimize)
 	return optimize ? create_optimized_surface(dest) : dest;
 }
 
+#ifdef __SSE2__
+/*
+ * Helpers for the SSE2 versions of the pixel loops, enabled whenever the
+ * compiler targets SSE2, as it always does for x86-64. They process four
+ * neutral pixels at a time and leave the last ones, if any, to the scalar
+ * loops that follow them, which also define the results.
+ *
+ * SSE2 implies a little endian machine: the bytes of an ARGB pixel are
+ * B, G, R, A in memory, which the 16 bits lanes below follow.
+ */
+namespace {
+
+inline __m128i load_pixels(const Uint32* pixels)
+{
+	return _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels));
+}
+
+inline void store_pixels(Uint32* pixels, __m128i value)
+{
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(pixels), value);
+}
+
+/** The pixels of @a res, but those of @a orig which are fully transparent. */
+inline __m128i keep_transparent(__m128i orig, __m128i res)
+{
+	const __m128i transparent = _mm_cmpeq_epi32(
+		_mm_and_si128(orig, _mm_set1_epi32(static_cast<int>(0xFF000000))), _mm_setzero_si128());
+	return _mm_or_si128(_mm_and_si128(transparent, orig), _mm_andnot_si128(transparent, res));
+}
+
+/** The amounts, capped to 255, as the channels of a pixel without alpha. */
+inline __m128i channel_amounts(int red, int green, int blue)
+{
+	return _mm_set1_epi32((std::min(red, 255) << 16) | (std::min(green, 255) << 8) | std::min(blue, 255));
+}
+
+/**
+ * Multiplies the channels by the fixed_t factors in @a factors, rounding
+ * down and capping to 255 as fxpmult() and the scalar loops.
+ */
+inline __m128i scale_channels(__m128i pixels, __m128i factors)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i max = _mm_set1_epi16(255);
+	// (c << 8) * f >> 16 is c * f >> 8
+	__m128i lo = _mm_mulhi_epu16(_mm_unpacklo_epi8(zero, pixels), factors);
+	__m128i hi = _mm_mulhi_epu16(_mm_unpackhi_epi8(zero, pixels), factors);
+	// The packing saturates signed values, so cap them first.
+	lo = _mm_sub_epi16(lo, _mm_subs_epu16(lo, max));
+	hi = _mm_sub_epi16(hi, _mm_subs_epu16(hi, max));
+	return _mm_packus_epi16(lo, hi);
+}
+
+/** The 16 bits lanes of scale_channels() for @a color and @a alpha factors. */
+inline __m128i channel_factors(fixed_t color, fixed_t alpha)
+{
+	const short c = static_cast<short>(std::min<fixed_t>(std::max<fixed_t>(color, 0), 0xFFFF));
+	const short a = static_cast<short>(std::min<fixed_t>(std::max<fixed_t>(alpha, 0), 0xFFFF));
+	return _mm_set_epi16(a, c, c, c, a, c, c, c);
+}
+
+}
+#endif
+
 surface adjust_surface_color(const surface &surf, int red, int green, int blue, bool optimize)
 {
 	if(surf == NULL)
@@ -921,6 +995,19 @@ surface adjust_surface_color(const surface &surf, int red, int green, int blue,
 		Uint32* beg = lock.pixels();
 		Uint32* end = beg + nsurf->w*surf->h;
 
+#ifdef __SSE2__
+		{
+			// Adding the positive part of the amounts and subtracting their
+			// negative part, both saturated, clamps as below.
+			const __m128i up = channel_amounts(std::max(red, 0), std::max(green, 0), std::max(blue, 0));
+			const __m128i down = channel_amounts(std::max(-red, 0), std::max(-green, 0), std::max(-blue, 0));
+			for(; end - beg >= 4; beg += 4) {
+				const __m128i pixels = load_pixels(beg);
+				const __m128i res = _mm_subs_epu8(_mm_adds_epu8(pixels, up), down);
+				store_pixels(beg, keep_transparent(pixels, res));
+			}
+		}
+#endif
 		while(beg != end) {
 			Uint8 alpha = (*beg) >> 24;
 
@@ -1162,11 +1249,40 @@ surface shadow_image(const surface &surf, bool optimize)
 }
 
 
+const Uint32 recolor_table::empty_slot;
+
+recolor_table::recolor_table(const std::map<Uint32, Uint32>& map_rgb)
+	: slots_()
+	, mask_(0)
+	, shift_(31)
+	, size_(map_rgb.size())
+{
+	while((Uint32(1) << (32 - shift_)) < 2 * size_) {
+		--shift_;
+	}
+	slots_.resize(Uint32(1) << (32 - shift_), std::pair<Uint32, Uint32>(empty_slot, 0));
+	mask_ = slots_.size() - 1;
+
+	for(std::map<Uint32, Uint32>::const_iterator c = map_rgb.begin(); c != map_rgb.end(); ++c) {
+		Uint32 i = (c->first * 2654435761u) >> shift_;
+		while(slots_[i].first != empty_slot) {
+			i = (i + 1) & mask_;
+		}
+		slots_[i] = *c;
+	}
+}
+
 surface recolor_image(surface surf, const std::map<Uint32, Uint32>& map_rgb, bool optimize){
+	if(surf == NULL || map_rgb.empty())
+		return surf;
+	return recolor_image(surf, recolor_table(map_rgb), optimize);
+}
+
+surface recolor_image(surface surf, const recolor_table& table, bool optimize){
 	if(surf == NULL)
 		return NULL;
 
-	if(!map_rgb.empty()){
+	if(!table.empty()){
 	     surface nsurf(make_neutral_surface(surf));
 	     if(nsurf == NULL) {
 			std::cerr << "failed to make neutral surface\n";
@@ -1177,16 +1293,19 @@ surface recolor_image(surface surf, const std::map<Uint32, Uint32>& map_rgb, boo
 		Uint32* beg = lock.pixels();
 		Uint32* end = beg + nsurf->w*surf->h;
 
+		// Sprites have runs of the same color, looked up once.
+		Uint32 last_rgb = 0xFFFFFFFF, last_new_rgb = 0;
 		while(beg != end) {
 			Uint8 alpha = (*beg) >> 24;
 
 			if(alpha){	// don't recolor invisible pixels.
 				// palette use only RGB channels, so remove alpha
 				Uint32 oldrgb = (*beg) & 0x00FFFFFF;
-				std::map<Uint32, Uint32>::const_iterator i = map_rgb.find(oldrgb);
-				if(i != map_rgb.end()){
-					*beg = (alpha << 24) + i->second;
+				if(oldrgb != last_rgb) {
+					last_rgb = oldrgb;
+					last_new_rgb = table(oldrgb);
 				}
+				*beg = (alpha << 24) + last_new_rgb;
 			}
 		++beg;
 		}
@@ -1215,6 +1334,15 @@ surface brighten_image(const surface &surf, fixed_t amount, bool optimize)
 		Uint32* end = beg + nsurf->w*surf->h;
 
 		if (amount < 0) amount = 0;
+#ifdef __SSE2__
+		{
+			const __m128i factors = channel_factors(amount, ftofxp(1));
+			for(; end - beg >= 4; beg += 4) {
+				const __m128i pixels = load_pixels(beg);
+				store_pixels(beg, keep_transparent(pixels, scale_channels(pixels, factors)));
+			}
+		}
+#endif
 		while(beg != end) {
 			Uint8 alpha = (*beg) >> 24;
 
@@ -1257,6 +1385,15 @@ surface adjust_surface_alpha(const surface &surf, fixed_t amount, bool optimize)
 		Uint32* end = beg + nsurf->w*surf->h;
 
 		if (amount < 0) amount = 0;
+#ifdef __SSE2__
+		{
+			// Transparent pixels stay as they are without special care.
+			const __m128i factors = channel_factors(ftofxp(1), amount);
+			for(; end - beg >= 4; beg += 4) {
+				store_pixels(beg, scale_channels(load_pixels(beg), factors));
+			}
+		}
+#endif
 		while(beg != end) {
 			Uint8 alpha = (*beg) >> 24;
 
@@ -1527,6 +1664,23 @@ surface light_surface(const surface &surf, const surface &lightmap, bool optimiz
 		const Uint32* lbeg = llock.pixels();
 		const Uint32* lend = lbeg + lightmap->w * lightmap->h;
 
+#ifdef __SSE2__
+		{
+			// The change (l - 128) * 2 of each channel is split into its
+			// positive and negative parts, as in adjust_surface_color().
+			const __m128i half = _mm_set1_epi32(0x00808080);
+			for(; end - beg >= 4 && lend - lbeg >= 4; beg += 4, lbeg += 4) {
+				const __m128i pixels = load_pixels(beg);
+				const __m128i light = load_pixels(lbeg);
+				__m128i up = _mm_subs_epu8(_mm_and_si128(light, _mm_set1_epi32(0x00FFFFFF)), half);
+				__m128i down = _mm_subs_epu8(half, light);
+				up = _mm_adds_epu8(up, up);
+				down = _mm_adds_epu8(down, down);
+				const __m128i res = _mm_subs_epu8(_mm_adds_epu8(pixels, up), down);
+				store_pixels(beg, keep_transparent(pixels, res));
+			}
+		}
+#endif
 		while(beg != end && lbeg != lend) {
 			Uint8 alpha = (*beg) >> 24;
  			if(alpha) {
@@ -1935,6 +2089,23 @@ surface blend_surface(
 
 			vst4_u8(reinterpret_cast<Uint8*>(beg), rgba);
 		}
+#elif defined(__SSE2__)
+		{
+			// (c * ratio + color) >> 8 in 16 bits lanes, alpha being kept by
+			// a ratio of 256. The sums fit, being at most 255 * 256.
+			const short r = static_cast<short>(ratio);
+			const __m128i ratios = _mm_set_epi16(256, r, r, r, 256, r, r, r);
+			const __m128i colors = _mm_set_epi16(0, red, green, blue, 0, red, green, blue);
+			const __m128i zero = _mm_setzero_si128();
+			for(; end - beg >= 4; beg += 4) {
+				const __m128i pixels = load_pixels(beg);
+				__m128i lo = _mm_unpacklo_epi8(pixels, zero);
+				__m128i hi = _mm_unpackhi_epi8(pixels, zero);
+				lo = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(lo, ratios), colors), 8);
+				hi = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(hi, ratios), colors), 8);
+				store_pixels(beg, _mm_packus_epi16(lo, hi));
+			}
+		}
 #endif
 		while(beg != end) {
 			Uint8 a = static_cast<Uint8>(*beg >> 24);
@@ -27,6 +27,7 @@
 #include <iosfwd>
 #include <map>
 #include <string>
+#include <vector>
 
 //older versions of SDL don't define the
 //mouse wheel macros, so define them ourselves
@@ -269,6 +270,44 @@ surface shadow_image(const surface &surf, bool optimize=true);
 surface recolor_image(surface surf, const std::map<Uint32, Uint32>& map_rgb,
 	bool optimize=true);
 
+/**
+ * A recolor map as used by recolor_image(), in an open addressing hash
+ * table: looking a color up is a multiplication and usually one
+ * comparison, instead of a walk down the tree of the std::map.
+ */
+class recolor_table
+{
+public:
+	explicit recolor_table(const std::map<Uint32, Uint32>& map_rgb);
+
+	bool empty() const { return size_ == 0; }
+
+	/** The new color of @a rgb, which has no alpha, or @a rgb if it is not changed. */
+	Uint32 operator()(Uint32 rgb) const
+	{
+		for(Uint32 i = (rgb * 2654435761u) >> shift_; ; i = (i + 1) & mask_) {
+			if(slots_[i].first == rgb) {
+				return slots_[i].second;
+			} else if(slots_[i].first == empty_slot) {
+				return rgb;
+			}
+		}
+	}
+
+private:
+	/** Not a color, as it has alpha. */
+	static const Uint32 empty_slot = 0xFFFFFFFF;
+
+	/** The colors and their new values; half of the slots at least are empty. */
+	std::vector<std::pair<Uint32, Uint32> > slots_;
+	Uint32 mask_;
+	unsigned shift_;
+	size_t size_;
+};
+
+/** As above, with a prepared table. */
+surface recolor_image(surface surf, const recolor_table& table, bool optimize=true);
+
 surface brighten_image(const surface &surf, fixed_t amount, bool optimize=true);
 
 /** Get a portion of the screen.
@@ -102,6 +102,11 @@ void config_writer::close_child(const std::string &key)
 	::write_close_child(out_, key, --level_);
 }
 
+void config_writer::write_serialized(const std::string &text)
+{
+	out_ << text;
+}
+
 bool config_writer::good() const
 {
 	return out_.good();
@@ -41,6 +41,11 @@ public:
 	void close_child(const std::string &key);
 	bool good() const;
 
+	/** The indentation of what is written next, for write_serialized(). */
+	unsigned int level() const { return level_; }
+	/** Writes WML text produced (by ::write()) at the current level. */
+	void write_serialized(const std::string &text);
+
 	/// This template function will work with any type that can be assigned to
 	/// an attribute_value.
 	template <typename T>
@@ -0,0 +1,307 @@
+/*
+   Copyright (C) 2015 by the Battle for Wesnoth Project
+   Part of the Battle for Wesnoth Project http://www.wesnoth.org/
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY.
+
+   See the COPYING file for more details.
+*/
+
+/**
+ * @file
+ * A binary format for configs, used for the game config cache.
+ *
+ * The layout is
+ * - the magic bytes "WMLB" and the format version;
+ * - the number of strings, then each string as its length and bytes;
+ * - the root config.
+ *
+ * A config is its number of attributes, each as a key (a string index), a
+ * type and a value, followed by its number of children, each as a tag (a
+ * string index) and the child config. All the numbers are unsigned LEB128
+ * varints; ints are zigzag encoded and doubles stored as their 64 bits.
+ */
+
+#include "serialization/binary_wml.hpp"
+
+#include "config.hpp"
+#include "filesystem.hpp"
+#include "tstring.hpp"
+
+#include <boost/cstdint.hpp>
+#include <boost/foreach.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/variant/static_visitor.hpp>
+
+#include <cstring>
+#include <ostream>
+#include <vector>
+
+namespace {
+
+const char magic[4] = { 'W', 'M', 'L', 'B' };
+const unsigned format_version = 1;
+
+enum value_type { BLANK, TRUE_FALSE, YES_NO, INT, UNSIGNED, DOUBLE, STRING, TSTRING };
+
+class binary_writer
+{
+public:
+	binary_writer()
+		: body_()
+		, strings_()
+		, ids_()
+	{
+	}
+
+	void write_config(const config &cfg)
+	{
+		write_number(cfg.attribute_count());
+		BOOST_FOREACH(const config::attribute &a, cfg.attribute_range()) {
+			write_number(id(a.first));
+			a.second.apply_visitor(value_writer(*this));
+		}
+		write_number(cfg.all_children_count());
+		BOOST_FOREACH(const config::any_child &c, cfg.all_children_range()) {
+			write_number(id(c.key));
+			write_config(c.cfg);
+		}
+	}
+
+	void finish(std::ostream &out)
+	{
+		std::string head(magic, sizeof(magic));
+		write_number(head, format_version);
+		write_number(head, strings_.size());
+		BOOST_FOREACH(const std::string *str, strings_) {
+			write_number(head, str->size());
+			head += *str;
+		}
+		out.write(head.data(), head.size());
+		out.write(body_.data(), body_.size());
+	}
+
+private:
+	class value_writer : public boost::static_visitor<void>
+	{
+		binary_writer &w_;
+	public:
+		value_writer(binary_writer &w) : w_(w) {}
+
+		void operator()(boost::blank) const
+		{ w_.body_ += char(BLANK); }
+		void operator()(config::attribute_value::true_false b) const
+		{ w_.body_ += char(TRUE_FALSE); w_.body_ += char(bool(b)); }
+		void operator()(config::attribute_value::yes_no b) const
+		{ w_.body_ += char(YES_NO); w_.body_ += char(bool(b)); }
+		void operator()(int i) const
+		{
+			w_.body_ += char(INT);
+			// Zigzag, so that small negative numbers stay small.
+			const boost::uint32_t u = static_cast<boost::uint32_t>(i);
+			w_.write_number(i < 0 ? ~(u << 1) : u << 1);
+		}
+		void operator()(unsigned long long u) const
+		{ w_.body_ += char(UNSIGNED); w_.write_number(u); }
+		void operator()(double d) const
+		{
+			w_.body_ += char(DOUBLE);
+			boost::uint64_t bits;
+			memcpy(&bits, &d, sizeof(bits));
+			for(int i = 0; i != 8; ++i) {
+				w_.body_ += char(bits >> (8 * i));
+			}
+		}
+		void operator()(const std::string &s) const
+		{ w_.body_ += char(STRING); w_.write_number(w_.id(s)); }
+		void operator()(const t_string &s) const
+		{ w_.body_ += char(TSTRING); w_.write_number(w_.id(s.to_serialized())); }
+	};
+
+	void write_number(unsigned long long n)
+	{
+		write_number(body_, n);
+	}
+
+	static void write_number(std::string &out, unsigned long long n)
+	{
+		while(n >= 0x80) {
+			out += char((n & 0x7f) | 0x80);
+			n >>= 7;
+		}
+		out += char(n);
+	}
+
+	unsigned id(const std::string &str)
+	{
+		std::pair<boost::unordered_map<std::string, unsigned>::iterator, bool> res =
+			ids_.insert(std::make_pair(str, static_cast<unsigned>(strings_.size())));
+		if(res.second) {
+			strings_.push_back(&res.first->first);
+		}
+		return res.first->second;
+	}
+
+	std::string body_;
+	/** The interned strings in the order of their indices. */
+	std::vector<const std::string *> strings_;
+	boost::unordered_map<std::string, unsigned> ids_;
+};
+
+class binary_reader
+{
+public:
+	binary_reader(const char *data, size_t size)
+		: pos_(reinterpret_cast<const unsigned char *>(data))
+		, end_(pos_ + size)
+		, strings_()
+	{
+	}
+
+	void read(config &cfg)
+	{
+		if(size_t(end_ - pos_) < sizeof(magic) || memcmp(pos_, magic, sizeof(magic)) != 0) {
+			throw config::error("not a binary config");
+		}
+		pos_ += sizeof(magic);
+		if(read_number() != format_version) {
+			throw config::error("unsupported binary config version");
+		}
+
+		const size_t count = read_count();
+		strings_.resize(count);
+		for(size_t i = 0; i != count; ++i) {
+			const size_t size = read_count();
+			strings_[i].assign(reinterpret_cast<const char *>(pos_), size);
+			pos_ += size;
+		}
+
+		read_config(cfg);
+		if(pos_ != end_) {
+			throw config::error("trailing data after a binary config");
+		}
+	}
+
+private:
+	void read_config(config &cfg)
+	{
+		for(size_t n = read_count(); n != 0; --n) {
+			config::attribute_value &v = cfg[string()];
+			switch(read_byte()) {
+			case BLANK:
+				break;
+			case TRUE_FALSE:
+				v = read_byte() ? config::attribute_value::s_true : config::attribute_value::s_false;
+				break;
+			case YES_NO:
+				v = read_byte() != 0;
+				break;
+			case INT: {
+				const boost::uint32_t u = static_cast<boost::uint32_t>(read_number());
+				v = static_cast<int>(u & 1 ? ~(u >> 1) : u >> 1);
+				break;
+			}
+			case UNSIGNED:
+				v = read_number();
+				break;
+			case DOUBLE: {
+				boost::uint64_t bits = 0;
+				for(int i = 0; i != 8; ++i) {
+					bits |= boost::uint64_t(read_byte()) << (8 * i);
+				}
+				double d;
+				memcpy(&d, &bits, sizeof(d));
+				v = d;
+				break;
+			}
+			case STRING:
+				v = string();
+				break;
+			case TSTRING:
+				v = t_string::from_serialized(string());
+				break;
+			default:
+				throw config::error("unknown attribute type in a binary config");
+			}
+		}
+		for(size_t n = read_count(); n != 0; --n) {
+			read_config(cfg.add_child(string()));
+		}
+	}
+
+	unsigned char read_byte()
+	{
+		if(pos_ == end_) {
+			throw config::error("truncated binary config");
+		}
+		return *pos_++;
+	}
+
+	unsigned long long read_number()
+	{
+		unsigned long long res = 0;
+		for(unsigned shift = 0; shift < 64; shift += 7) {
+			const unsigned char c = read_byte();
+			res |= static_cast<unsigned long long>(c & 0x7f) << shift;
+			if(!(c & 0x80)) {
+				return res;
+			}
+		}
+		throw config::error("bad number in a binary config");
+	}
+
+	/** Reads a size, which cannot exceed the data left. */
+	size_t read_count()
+	{
+		const unsigned long long n = read_number();
+		if(n > static_cast<unsigned long long>(end_ - pos_)) {
+			throw config::error("truncated binary config");
+		}
+		return static_cast<size_t>(n);
+	}
+
+	const std::string &string()
+	{
+		const unsigned long long i = read_number();
+		if(i >= strings_.size()) {
+			throw config::error("bad string index in a binary config");
+		}
+		return strings_[i];
+	}
+
+	const unsigned char *pos_;
+	const unsigned char *const end_;
+	std::vector<std::string> strings_;
+};
+
+}
+
+void write_binary(std::ostream &out, const config &cfg)
+{
+	binary_writer writer;
+	writer.write_config(cfg);
+	writer.finish(out);
+}
+
+void read_binary(config &cfg, const char *data, size_t size)
+{
+	cfg.clear();
+	binary_reader(data, size).read(cfg);
+}
+
+void read_binary_file(config &cfg, const std::string &path)
+{
+	boost::iostreams::mapped_file_source file;
+	try {
+		file.open(path);
+	} catch(std::exception &e) {
+		throw filesystem::io_exception("could not map " + path + ": " + e.what());
+	}
+	read_binary(cfg, file.data(), file.size());
+}
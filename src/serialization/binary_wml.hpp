@@ -0,0 +1,51 @@
+/*
+   Copyright (C) 2015 by the Battle for Wesnoth Project
+   Part of the Battle for Wesnoth Project http://www.wesnoth.org/
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY.
+
+   See the COPYING file for more details.
+*/
+
+/**
+ * @file
+ * A binary format for configs, used for the game config cache.
+ *
+ * Reading it back does not involve any tokenizing or parsing: all the keys,
+ * tags and strings are stored once in a table, and the attributes keep the
+ * type they had in the config written, so numbers are stored as numbers.
+ * The format is meant for caches written and read by the same build; it is
+ * not portable between versions and not meant for anything else.
+ */
+
+#ifndef SERIALIZATION_BINARY_WML_HPP_INCLUDED
+#define SERIALIZATION_BINARY_WML_HPP_INCLUDED
+
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+
+class config;
+
+/** Writes @a cfg to @a out in the binary format. */
+void write_binary(std::ostream &out, const config &cfg);
+
+/**
+ * Reads a config written by write_binary() from the @a size bytes at @a data,
+ * clobbering existing data.
+ * Throws config::error if the data is not a valid binary config.
+ */
+void read_binary(config &cfg, const char *data, size_t size);
+
+/**
+ * Same as above, reading the file at @a path through a memory mapping.
+ * Throws filesystem::io_exception if the file cannot be mapped.
+ */
+void read_binary_file(config &cfg, const std::string &path);
+
+#endif
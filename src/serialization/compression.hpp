@@ -15,6 +15,7 @@
 #ifndef COMPRESSION_HPP_INCLUDED
 #define COMPRESSION_HPP_INCLUDED
 
+#include <istream>
 #include <string>
 
 namespace compression {
@@ -36,6 +37,32 @@ namespace compression {
 		}
 		return "";
 	}
+
+	/**
+	 * The format of the data @a in holds, recognized by the magic numbers
+	 * of gzip and bzip2. The stream is left where it was; one that cannot
+	 * seek back is taken as uncompressed.
+	 */
+	inline format detect_format(std::istream& in)
+	{
+		const std::streampos start = in.tellg();
+		if(start == std::streampos(-1)) {
+			return NONE;
+		}
+
+		char magic[3];
+		in.read(magic, sizeof(magic));
+		const std::streamsize size = in.gcount();
+		in.clear();
+		in.seekg(start);
+
+		if(size >= 2 && magic[0] == '\x1f' && magic[1] == '\x8b') {
+			return GZIP;
+		} else if(size == 3 && magic[0] == 'B' && magic[1] == 'Z' && magic[2] == 'h') {
+			return BZIP2;
+		}
+		return NONE;
+	}
 }
 
 #endif
@@ -49,14 +49,144 @@ static lg::log_domain log_config("config");
 static const size_t max_recursion_levels = 1000;
 
 namespace {
+
+/** Builds a config out of what the parser reads, for read(). */
+class config_sink
+{
+public:
+	config_sink(config& cfg, abstract_validator* validator)
+		: cfg_(cfg)
+		, validator_(validator)
+		, stack_()
+	{
+	}
+
+	void start()
+	{
+		cfg_.clear();
+		stack_.push(&cfg_);
+	}
+
+	void open_tag(const std::string& name, bool append, int line, const std::string& file)
+	{
+		config& parent = *stack_.top();
+		// [+element] continues the last child of the current element
+		// whose name is element, if there is one.
+		if (append) {
+			if (config& c = parent.child(name, -1)) {
+				stack_.push(&c);
+				if (validator_) {
+					validator_->open_tag(name, line, file, true);
+				}
+				return;
+			}
+		}
+		stack_.push(&parent.add_child(name));
+		if (validator_) {
+			validator_->open_tag(name, line, file);
+		}
+	}
+
+	void close_tag(const std::string& name, int start_line, const std::string& file)
+	{
+		if (validator_) {
+			validator_->validate(*stack_.top(), name, start_line, file);
+			validator_->close_tag();
+		}
+		stack_.pop();
+	}
+
+	void attribute(const std::string& key, const t_string_base& value, int line, const std::string& file)
+	{
+		config& cfg = *stack_.top();
+		if (value.translatable())
+			cfg[key] = t_string(value);
+		else
+			cfg[key] = value.value();
+		if (validator_) {
+			validator_->validate_key(cfg, key, value.value(), line, file);
+		}
+	}
+
+	void empty_attribute(const std::string& key)
+	{
+		(*stack_.top())[key] = "";
+	}
+
+private:
+	config& cfg_;
+	abstract_validator* validator_;
+	std::stack<config*> stack_;
+};
+
+/** Passes what the parser reads to a wml_event_handler, for read_events(). */
+class event_sink
+{
+public:
+	explicit event_sink(wml_event_handler& handler)
+		: handler_(handler)
+		, skipped_(0)
+	{
+	}
+
+	void start()
+	{
+	}
+
+	void open_tag(const std::string& name, bool append, int, const std::string&)
+	{
+		if (skipped_ != 0) {
+			++skipped_;
+		} else if (!handler_.open_tag(name, append)) {
+			skipped_ = 1;
+		}
+	}
+
+	void close_tag(const std::string& name, int, const std::string&)
+	{
+		if (skipped_ != 0) {
+			--skipped_;
+		} else {
+			handler_.close_tag(name);
+		}
+	}
+
+	void attribute(const std::string& key, const t_string_base& value, int, const std::string&)
+	{
+		if (skipped_ != 0) {
+			return;
+		}
+		config::attribute_value v;
+		if (value.translatable())
+			v = t_string(value);
+		else
+			v = value.value();
+		handler_.attribute(key, v);
+	}
+
+	void empty_attribute(const std::string& key)
+	{
+		if (skipped_ == 0) {
+			config::attribute_value v;
+			v = "";
+			handler_.attribute(key, v);
+		}
+	}
+
+private:
+	wml_event_handler& handler_;
+	/** How deep we are in a skipped element, 0 if not in one. */
+	unsigned skipped_;
+};
+
+template <typename Sink>
 class parser
 {
 	parser();
 	parser(const parser&);
 	parser& operator=(const parser&);
 public:
-	parser(config& cfg, std::istream& in,
-		   abstract_validator * validator = NULL);
+	parser(Sink& sink, std::istream& in);
 	~parser();
 	void operator()();
 
@@ -69,17 +199,15 @@ private:
 		const std::string &debug_string = "");
 	void error(const std::string& message, const std::string& pos_format = "");
 
-	config& cfg_;
+	Sink& sink_;
 	tokenizer tok_;
-	abstract_validator *validator_;
 
 	struct element {
-		element(config *cfg, std::string const &name,
+		element(std::string const &name,
 			int start_line = 0, const std::string &file = "") :
-			cfg(cfg), name(name), start_line(start_line), file(file)
+			name(name), start_line(start_line), file(file)
 		{}
 
-		config* cfg;
 		std::string name;
 		int start_line;
 		std::string file;
@@ -88,22 +216,24 @@ private:
 	std::stack<element> elements;
 };
 
-parser::parser(config &cfg, std::istream &in, abstract_validator * validator)
-			   :cfg_(cfg),
+template <typename Sink>
+parser<Sink>::parser(Sink& sink, std::istream &in)
+			   :sink_(sink),
 			   tok_(in),
-			   validator_(validator),
 			   elements()
 {
 }
 
 
-parser::~parser()
+template <typename Sink>
+parser<Sink>::~parser()
 {}
 
-void parser::operator()()
+template <typename Sink>
+void parser<Sink>::operator()()
 {
-	cfg_.clear();
-	elements.push(element(&cfg_, ""));
+	sink_.start();
+	elements.push(element(""));
 
 	do {
 		tok_.next_token();
@@ -153,23 +283,19 @@ void parser::operator()()
 	}
 }
 
-void parser::parse_element()
+template <typename Sink>
+void parser<Sink>::parse_element()
 {
 	tok_.next_token();
 	std::string elname;
-	config* current_element = NULL;
 	switch(tok_.current_token().type) {
 	case token::STRING: // [element]
 		elname = tok_.current_token().value;
 		if (tok_.next_token().type != ']')
 			error(_("Unterminated [element] tag"));
 		// Add the element
-		current_element = &(elements.top().cfg->add_child(elname));
-		elements.push(element(current_element, elname, tok_.get_start_line(), tok_.get_file()));
-		if (validator_){
-			validator_->open_tag(elname,tok_.get_start_line(),
-								  tok_.get_file());
-		}
+		sink_.open_tag(elname, false, tok_.get_start_line(), tok_.get_file());
+		elements.push(element(elname, tok_.get_start_line(), tok_.get_file()));
 		break;
 
 	case '+': // [+element]
@@ -179,22 +305,8 @@ void parser::parse_element()
 		if (tok_.next_token().type != ']')
 			error(_("Unterminated [+element] tag"));
 
-		// Find the last child of the current element whose name is
-		// element
-		if (config &c = elements.top().cfg->child(elname, -1)) {
-			current_element = &c;
-			if (validator_){
-				validator_->open_tag(elname,tok_.get_start_line(),
-									 tok_.get_file(),true);
-			}
-		} else {
-			current_element = &elements.top().cfg->add_child(elname);
-			if (validator_){
-				validator_->open_tag(elname,tok_.get_start_line(),
-									 tok_.get_file());
-			}
-		}
-		elements.push(element(current_element, elname, tok_.get_start_line(), tok_.get_file()));
+		sink_.open_tag(elname, true, tok_.get_start_line(), tok_.get_file());
+		elements.push(element(elname, tok_.get_start_line(), tok_.get_file()));
 		break;
 
 	case '/': // [/element]
@@ -215,10 +327,9 @@ void parser::parse_element()
 					_("Found invalid closing tag [/$tag2] for tag [$tag1]"),
 					_("opened at $pos")), _("closed at $pos"));
 		}
-		if(validator_){
-			element & el= elements.top();
-			validator_->validate(*el.cfg,el.name,el.start_line,el.file);
-			validator_->close_tag();
+		{
+			const element& el = elements.top();
+			sink_.close_tag(el.name, el.start_line, el.file);
 		}
 		elements.pop();
 		break;
@@ -227,9 +338,9 @@ void parser::parse_element()
 	}
 }
 
-void parser::parse_variable()
+template <typename Sink>
+void parser<Sink>::parse_variable()
 {
-	config& cfg = *elements.top().cfg;
 	std::vector<std::string> variables;
 	variables.push_back("");
 
@@ -268,15 +379,7 @@ void parser::parse_variable()
 		switch (tok_.current_token().type) {
 		case ',':
 			if ((curvar+1) != variables.end()) {
-				if (buffer.translatable())
-					cfg[*curvar] = t_string(buffer);
-				else
-					cfg[*curvar] = buffer.value();
-				if(validator_){
-					validator_->validate_key (cfg,*curvar,buffer.value(),
-											  tok_.get_start_line (),
-											  tok_.get_file ());
-				}
+				sink_.attribute(*curvar, buffer, tok_.get_start_line(), tok_.get_file());
 				buffer = t_string_base();
 				++curvar;
 			} else {
@@ -329,24 +432,17 @@ void parser::parse_variable()
 	}
 
 	finish:
-	if (buffer.translatable())
-		cfg[*curvar] = t_string(buffer);
-	else
-		cfg[*curvar] = buffer.value();
-	if(validator_){
-		validator_->validate_key (cfg,*curvar,buffer.value(),
-								  tok_.get_start_line (),
-								  tok_.get_file ());
-	}
+	sink_.attribute(*curvar, buffer, tok_.get_start_line(), tok_.get_file());
 	while (++curvar != variables.end()) {
-		cfg[*curvar] = "";
+		sink_.empty_attribute(*curvar);
 	}
 }
 
 /**
  * This function is crap. Don't use it on a string_map with prefixes.
  */
-std::string parser::lineno_string(utils::string_map &i18n_symbols,
+template <typename Sink>
+std::string parser<Sink>::lineno_string(utils::string_map &i18n_symbols,
 								  std::string const &lineno,
 								  std::string const &error_string,
 								  std::string const &hint_string,
@@ -368,7 +464,8 @@ std::string parser::lineno_string(utils::string_map &i18n_symbols,
 	return result;
 }
 
-void parser::error(const std::string& error_type, const std::string& pos_format)
+template <typename Sink>
+void parser<Sink>::error(const std::string& error_type, const std::string& pos_format)
 {
 	std::string hint_string = pos_format;
 
@@ -402,17 +499,19 @@ void parser::error(const std::string& error_type, const std::string& pos_format)
 
 void read(config &cfg, std::istream &in, abstract_validator * validator)
 {
-	parser(cfg, in, validator)();
+	config_sink sink(cfg, validator);
+	parser<config_sink>(sink, in)();
 }
 
 void read(config &cfg, const std::string &in, abstract_validator * validator)
 {
 	std::istringstream ss(in);
-	parser(cfg, ss, validator)();
+	config_sink sink(cfg, validator);
+	parser<config_sink>(sink, ss)();
 }
 
-template <typename decompressor>
-void read_compressed(config &cfg, std::istream &file, abstract_validator * validator)
+template <typename decompressor, typename Sink>
+void read_compressed(Sink &sink, std::istream &file)
 {
 	//an empty gzip file seems to confuse boost on msvc
 	//so return early if this is the case
@@ -450,19 +549,39 @@ void read_compressed(config &cfg, std::istream &file, abstract_validator * valid
 		LOG_CF << " filter.peek() != EOF but !filter.good(), this indicates a malformed gz stream, and can make wesnoth crash.";
 	}
 
-	parser(cfg, filter,validator)();
+	parser<Sink>(sink, filter)();
 }
 
 /// might throw a std::ios_base::failure especially a gzip_error
 void read_gz(config &cfg, std::istream &file, abstract_validator * validator)
 {
-	read_compressed<boost::iostreams::gzip_decompressor>(cfg, file, validator);
+	config_sink sink(cfg, validator);
+	read_compressed<boost::iostreams::gzip_decompressor>(sink, file);
 }
 
 /// might throw a std::ios_base::failure especially bzip2_error
 void read_bz2(config &cfg, std::istream &file, abstract_validator * validator)
 {
-	read_compressed<boost::iostreams::bzip2_decompressor>(cfg, file, validator);
+	config_sink sink(cfg, validator);
+	read_compressed<boost::iostreams::bzip2_decompressor>(sink, file);
+}
+
+void read_events(wml_event_handler &handler, std::istream &in)
+{
+	event_sink sink(handler);
+	parser<event_sink>(sink, in)();
+}
+
+void read_events_gz(wml_event_handler &handler, std::istream &file)
+{
+	event_sink sink(handler);
+	read_compressed<boost::iostreams::gzip_decompressor>(sink, file);
+}
+
+void read_events_bz2(wml_event_handler &handler, std::istream &file)
+{
+	event_sink sink(handler);
+	read_compressed<boost::iostreams::bzip2_decompressor>(sink, file);
 }
 
 namespace { // helpers for write_key_val().
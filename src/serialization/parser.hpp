@@ -33,6 +33,30 @@ void read_gz(config &cfg, std::istream &in,
 void read_bz2(config &cfg, std::istream &in,
 			 abstract_validator * validator = NULL);
 
+/**
+ * Receives the contents of a WML document from read_events(), in the order
+ * they are read, instead of having them stored in a config.
+ */
+class wml_event_handler
+{
+public:
+	virtual ~wml_event_handler() {}
+
+	/**
+	 * Called for [tag], or [+tag] if @a append.
+	 * Returning false skips the contents of the tag: nothing inside it is
+	 * passed on, and neither is its close_tag().
+	 */
+	virtual bool open_tag(const std::string &tag, bool append) = 0;
+	virtual void close_tag(const std::string &tag) = 0;
+	virtual void attribute(const std::string &key, const config::attribute_value &value) = 0;
+};
+
+// Read data in without building a config; same errors as read().
+void read_events(wml_event_handler &handler, std::istream &in);
+void read_events_gz(wml_event_handler &handler, std::istream &in);
+void read_events_bz2(wml_event_handler &handler, std::istream &in);
+
 void write(std::ostream &out, config const &cfg, unsigned int level=0);
 void write_gz(std::ostream &out, config const &cfg);
 void write_bz2(std::ostream &out, config const &cfg);
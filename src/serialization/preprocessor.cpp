@@ -25,6 +25,7 @@
 #include "filesystem.hpp"
 #include "game_config.hpp"
 #include "log.hpp"
+#include "thread.hpp"
 #include "wesconfig.h"
 #include "serialization/binary_or_text.hpp"
 #include "serialization/string_utils.hpp"
@@ -34,7 +35,13 @@
 #include "version.hpp"
 
 #include <boost/foreach.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/unordered_set.hpp>
 
+#include <cstdlib>
+#include <limits>
 #include <stdexcept>
 
 static lg::log_domain log_preprocessor("preprocessor");
@@ -49,6 +56,8 @@ using std::streambuf;
 // map associating each filename encountered to a number
 typedef std::map<std::string, int> t_file_number_map;
 static t_file_number_map file_number_map;
+// guards file_number_map, as independent files can be preprocessed in parallel
+static threading::mutex file_number_mutex;
 
 static bool encode_filename = true;
 
@@ -64,6 +73,7 @@ static std::string get_filename(const std::string& file_code){
 	int n = 0;
 	s >> std::hex >> n;
 
+	const threading::lock lock(file_number_mutex);
 	BOOST_FOREACH(const t_file_number_map::value_type& p, file_number_map){
 		if(p.second == n)
 			return p.first;
@@ -79,6 +89,7 @@ static std::string get_file_code(const std::string& filename){
 	// current number of encountered filenames
 	static int current_file_number = 0;
 
+	const threading::lock lock(file_number_mutex);
 	int& fnum = file_number_map[utils::escape(filename, " \\")];
 	if(fnum == 0)
 		fnum = ++current_file_number;
@@ -208,6 +219,87 @@ public:
 	virtual ~preprocessor();
 };
 
+/**
+ * What the expansion of a macro depended on while it was recorded, so that
+ * an identical invocation can replay its output instead.
+ */
+struct expansion_deps
+{
+	expansion_deps()
+		: symbols()
+		, impure(false)
+		, depth(0)
+		, min_caller(0)
+		, max_caller(std::numeric_limits<size_t>::max())
+	{
+	}
+	/** The symbols looked up, whether they were defined or not. */
+	std::set<std::string> symbols;
+	/** Set when the expansion changed the defines or included a file. */
+	bool impure;
+	/** The deepest nesting of the lookups, relative to the invocation. */
+	int depth;
+	/**
+	 * The sizes of the caller location, in [min_caller, max_caller), for
+	 * which the line changes are output the same way.
+	 */
+	size_t min_caller, max_caller;
+
+	void add(expansion_deps const &inner, int depth_offset);
+};
+
+void expansion_deps::add(expansion_deps const &inner, int depth_offset)
+{
+	symbols.insert(inner.symbols.begin(), inner.symbols.end());
+	impure = impure || inner.impure;
+	depth = std::max(depth, depth_offset + inner.depth);
+}
+
+/** An expansion of a macro, recorded with the placeholders of its level. */
+struct macro_expansion
+{
+	macro_expansion() : output(), deps(), level(0), serial(0) {}
+	std::string output;
+	expansion_deps deps;
+	unsigned level;
+	/** The value of macro_memo::serial when it was recorded. */
+	unsigned serial;
+};
+
+/**
+ * The macro expansions recorded while preprocessing a stream.
+ * They stay valid as long as none of the symbols they looked up is defined
+ * or undefined again.
+ */
+struct macro_memo
+{
+	macro_memo() : expansions(), seen(), changes(), serial(0) {}
+	typedef boost::unordered_map<std::string, macro_expansion> expansion_map;
+	expansion_map expansions;
+	/**
+	 * Hashes of the invocations expanded once. Only the repeated ones are
+	 * kept, most invocations with arguments happening once.
+	 */
+	boost::unordered_set<size_t> seen;
+	/** Serial number of the last #define or #undef of each symbol. */
+	boost::unordered_map<std::string, unsigned> changes;
+	unsigned serial;
+
+	bool unchanged(macro_expansion const &) const;
+};
+
+bool macro_memo::unchanged(macro_expansion const &e) const
+{
+	if (e.serial == serial)
+		return true;
+	BOOST_FOREACH(std::string const &symbol, e.deps.symbols) {
+		boost::unordered_map<std::string, unsigned>::const_iterator i = changes.find(symbol);
+		if (i != changes.end() && i->second > e.serial)
+			return false;
+	}
+	return true;
+}
+
 /**
  * Target for sending preprocessed output.
  * Objects of this class can be plugged into an STL stream.
@@ -220,6 +312,8 @@ class preprocessor_streambuf: public streambuf
 	preprocessor *current_;       /**< Input preprocessor. */
 	preproc_map *defines_;
 	preproc_map default_defines_;
+	/** If not NULL, receives the names of the files and directories opened. */
+	std::set<std::string> *included_;
 	std::string textdomain_;
 	std::string location_;
 	int linenum_;
@@ -229,29 +323,59 @@ class preprocessor_streambuf: public streambuf
 	 * Deeper-nested preprocessors are then forbidden to.
 	 */
 	bool quoted_;
+	/** Recorded macro expansions, shared with the nested buffers. */
+	boost::shared_ptr<macro_memo> memo_;
+	/** Set if this buffer records the expansion of a macro. */
+	bool recording_;
+	/** Number of the recording buffers this one is nested in, itself included. */
+	unsigned level_;
+	/**
+	 * When recording, the location standing for the one of the caller,
+	 * so that the output can be replayed from anywhere.
+	 */
+	std::string placeholder_;
+	/** When recording, the line and location of the caller, if any. */
+	std::string caller_location_;
+	int base_depth_;
+	expansion_deps deps_;
 	friend class preprocessor;
 	friend class preprocessor_file;
 	friend class preprocessor_data;
 	friend struct preprocessor_deleter;
 	preprocessor_streambuf(preprocessor_streambuf const &);
+	void record(std::string const &caller_location);
+	size_t caller_size() const
+	{ return caller_location_.empty() ? 0 : caller_location_.size() + 1; }
+	std::string resolved_location() const;
+	bool fits_in_newlines(unsigned lines);
+	void lookup(std::string const &symbol);
+	void redefine(std::string const &symbol);
 public:
-	preprocessor_streambuf(preproc_map *);
+	preprocessor_streambuf(preproc_map *, std::set<std::string> *included = NULL);
 	void error(const std::string &, int);
 	void warning(const std::string &, int);
 };
 
-preprocessor_streambuf::preprocessor_streambuf(preproc_map *def) :
+preprocessor_streambuf::preprocessor_streambuf(preproc_map *def, std::set<std::string> *included) :
 	streambuf(),
 	out_buffer_(""),
 	buffer_(),
 	current_(NULL),
 	defines_(def),
 	default_defines_(),
+	included_(included),
 	textdomain_(PACKAGE),
 	location_(""),
 	linenum_(0),
 	depth_(0),
-	quoted_(false)
+	quoted_(false),
+	memo_(new macro_memo),
+	recording_(false),
+	level_(0),
+	placeholder_(),
+	caller_location_(),
+	base_depth_(0),
+	deps_()
 {
 }
 
@@ -262,12 +386,94 @@ preprocessor_streambuf::preprocessor_streambuf(preprocessor_streambuf const &t)
 	current_(NULL),
 	defines_(t.defines_),
 	default_defines_(),
+	included_(t.included_),
 	textdomain_(PACKAGE),
 	location_(""),
 	linenum_(0),
 	depth_(t.depth_),
-	quoted_(t.quoted_)
+	quoted_(t.quoted_),
+	memo_(t.memo_),
+	recording_(false),
+	level_(t.level_),
+	placeholder_(),
+	caller_location_(),
+	base_depth_(t.depth_),
+	deps_()
+{
+}
+
+/**
+ * Makes this buffer record the expansion of a macro invoked at
+ * @a caller_location, empty for a macro argument.
+ * The location of the caller is the placeholder, at line 0.
+ */
+void preprocessor_streambuf::record(std::string const &caller_location)
+{
+	recording_ = true;
+	++level_;
+	std::ostringstream s;
+	s << '\377' << level_;
+	placeholder_ = s.str();
+	caller_location_ = caller_location;
+	location_ = placeholder_;
+	linenum_ = 0;
+}
+
+/** The location, with the one of the caller if recording. */
+std::string preprocessor_streambuf::resolved_location() const
 {
+	if (!recording_)
+		return location_;
+	if (location_ == placeholder_)
+		return caller_location_;
+	std::string const suffix = " 0 " + placeholder_;
+	if (location_.size() < suffix.size() ||
+	    location_.compare(location_.size() - suffix.size(), suffix.size(), suffix) != 0)
+		return location_;
+	std::string res = location_.substr(0, location_.size() - suffix.size());
+	if (!caller_location_.empty())
+		res += ' ' + caller_location_;
+	return res;
+}
+
+/**
+ * Whether a jump of @a lines lines is output as newlines rather than as a
+ * line directive, which is longer than them past the size of the location.
+ * When recording, notes the sizes of the caller location giving the same
+ * choice.
+ */
+bool preprocessor_streambuf::fits_in_newlines(unsigned lines)
+{
+	size_t const suffix = placeholder_.size() + 3;
+	if (!recording_ || location_.size() < suffix)
+		return lines <= location_.size() + 11;
+	size_t const relative = location_.size() - suffix;
+	bool const res = lines <= relative + caller_size() + 11;
+	if (lines > relative + 11) {
+		// Newlines for the callers at least this long.
+		size_t const bound = lines - relative - 11;
+		if (res)
+			deps_.min_caller = std::max(deps_.min_caller, bound);
+		else
+			deps_.max_caller = std::min(deps_.max_caller, bound);
+	}
+	return res;
+}
+
+/** Notes that the defines were looked up for @a symbol. */
+void preprocessor_streambuf::lookup(std::string const &symbol)
+{
+	if (recording_) {
+		deps_.symbols.insert(symbol);
+		deps_.depth = std::max(deps_.depth, depth_ - base_depth_);
+	}
+}
+
+/** Notes that @a symbol was defined or undefined. */
+void preprocessor_streambuf::redefine(std::string const &symbol)
+{
+	memo_->changes[symbol] = ++memo_->serial;
+	deps_.impure = true;
 }
 
 /**
@@ -347,7 +553,7 @@ void preprocessor_streambuf::error(const std::string& error_type, int l)
 {
 	std::string position, error;
 	std::ostringstream pos;
-	pos << l << ' ' << location_;
+	pos << l << ' ' << resolved_location();
 	position = lineno_string(pos.str());
 	error = error_type + '\n';
 	error += "at " + position;
@@ -359,7 +565,7 @@ void preprocessor_streambuf::warning(const std::string& warning_type, int l)
 {
 	std::string position, warning;
 	std::ostringstream pos;
-	pos << l << ' ' << location_;
+	pos << l << ' ' << resolved_location();
 	position = lineno_string(pos.str());
 	warning = warning_type + '\n';
 	warning += "at " + position;
@@ -494,6 +700,8 @@ class preprocessor_data: preprocessor
 	void put(std::string const & /*, int change_line
 	= 0 */);
 	void conditional_skip(bool skip);
+	std::string expand_macro(std::string const &symbol, preproc_define const &,
+	                         std::vector<std::string> &args);
 public:
 	preprocessor_data(preprocessor_streambuf &,
 	                  std::istream *,
@@ -524,6 +732,9 @@ preprocessor_file::preprocessor_file(preprocessor_streambuf &t, std::string cons
 	pos_(),
 	end_()
 {
+	if (t.included_) {
+		t.included_->insert(name);
+	}
 	if (filesystem::is_directory(name)) {
 
 		filesystem::get_files_in_dir(name, &files_, NULL, filesystem::ENTIRE_FILE_PATH, filesystem::SKIP_MEDIA_DIR, filesystem::DO_REORDER);
@@ -752,7 +963,7 @@ void preprocessor_data::put(char c)
 	if (unsigned diff = cond_linenum - target_.linenum_)
 	{
 		target_.linenum_ = cond_linenum;
-		if (diff <= target_.location_.size() + 11) {
+		if (target_.fits_in_newlines(diff)) {
 			target_.buffer_ << std::string(diff, '\n');
 		} else {
 			target_.buffer_ << "\376line " << target_.linenum_
@@ -888,12 +1099,14 @@ bool preprocessor_data::get_chunk()
 			if (!skipping_) {
 				buffer.erase(buffer.end() - 7, buffer.end());
 				(*target_.defines_)[symbol] = preproc_define(buffer, items, target_.textdomain_,
-					                       linenum + 1, target_.location_);
-				LOG_PREPROC << "defining macro " << symbol << " (location " << get_location(target_.location_) << ")\n";
+					                       linenum + 1, target_.resolved_location());
+				target_.redefine(symbol);
+				LOG_PREPROC << "defining macro " << symbol << " (location " << get_location(target_.resolved_location()) << ")\n";
 			}
 		} else if (command == "ifdef") {
 			skip_spaces();
 			std::string const &symbol = read_word();
+			target_.lookup(symbol);
 			bool found = target_.defines_->count(symbol) != 0;
 			DBG_PREPROC << "testing for macro " << symbol << ": "
 				<< (found ? "defined" : "not defined") << '\n';
@@ -901,6 +1114,7 @@ bool preprocessor_data::get_chunk()
 		} else if (command == "ifndef") {
 			skip_spaces();
 			std::string const &symbol = read_word();
+			target_.lookup(symbol);
 			bool found = target_.defines_->count(symbol) != 0;
 			DBG_PREPROC << "testing for macro " << symbol << ": "
 				<< (found ? "defined" : "not defined") << '\n';
@@ -928,6 +1142,7 @@ bool preprocessor_data::get_chunk()
 			std::string const& vverstr = read_word();
 
 			const VERSION_COMP_OP vop = parse_version_op(vopstr);
+			target_.lookup(vsymstr);
 
 			if(vop == OP_INVALID) {
 				target_.error("Invalid #ifver/#ifnver operator", linenum_);
@@ -987,7 +1202,8 @@ bool preprocessor_data::get_chunk()
 			std::string const &symbol = read_word();
 			if (!skipping_) {
 				target_.defines_->erase(symbol);
-				LOG_PREPROC << "undefine macro " << symbol << " (location " << get_location(target_.location_) << ")\n";
+				target_.redefine(symbol);
+				LOG_PREPROC << "undefine macro " << symbol << " (location " << get_location(target_.resolved_location()) << ")\n";
 			}
 		} else if (command == "error") {
 			if (!skipping_) {
@@ -1068,6 +1284,7 @@ bool preprocessor_data::get_chunk()
 			}
 			else if (target_.depth_ < 100 && (macro = target_.defines_->find(symbol)) != target_.defines_->end())
 			{
+				target_.lookup(symbol);
 				preproc_define const &val = macro->second;
 				size_t nb_arg = strings_.size() - token.stack_pos - 1;
 				if (nb_arg != val.arguments.size())
@@ -1078,35 +1295,13 @@ bool preprocessor_data::get_chunk()
 					      << nb_arg << " arguments";
 					target_.error(error.str(), linenum_);
 				}
-				std::istringstream *buffer = new std::istringstream(val.value);
-				std::map<std::string, std::string> *defines =
-					new std::map<std::string, std::string>;
-				for (size_t i = 0; i < nb_arg; ++i) {
-					(*defines)[val.arguments[i]] = strings_[token.stack_pos + i + 1];
-				}
+				std::vector<std::string> args(strings_.begin() + token.stack_pos + 1, strings_.end());
 				pop_token();
-				std::string const &dir = filesystem::directory_name(val.location.substr(0, val.location.find(' ')));
-				if (!slowpath_) {
-					DBG_PREPROC << "substituting macro " << symbol << '\n';
-					new preprocessor_data(target_, buffer, val.location, "",
-					                      val.linenum, dir, val.textdomain, defines);
-				} else {
-					DBG_PREPROC << "substituting (slow) macro " << symbol << '\n';
-					std::ostringstream res;
-					preprocessor_streambuf *buf =
-						new preprocessor_streambuf(target_);
-					// Make the nested preprocessor_data responsible for
-					// restoring our current textdomain if needed.
-					buf->textdomain_ = target_.textdomain_;
-					{	std::istream in(buf);
-						new preprocessor_data(*buf, buffer, val.location, "",
-						                      val.linenum, dir, val.textdomain, defines);
-						res << in.rdbuf(); }
-					delete buf;
-					put(res.str());
-				}
+				put(expand_macro(symbol, val, args));
 			} else if (target_.depth_ < 40) {
 				LOG_PREPROC << "Macro definition not found for " << symbol << " , attempting to open as file.\n";
+				// The content of files is not recorded.
+				target_.deps_.impure = true;
 				pop_token();
 				std::string nfname = filesystem::get_wml_location(symbol, directory_);
 				if (!nfname.empty())
@@ -1153,6 +1348,159 @@ bool preprocessor_data::get_chunk()
 	return true;
 }
 
+/**
+ * Copies the @a output of a macro expansion recorded with @a placeholder,
+ * replacing the location of the caller by @a caller and the line directives
+ * starting the arguments by @a arg_lines. An empty @a caller also drops the
+ * directives restoring its location.
+ */
+static std::string replay_expansion(std::string const &output, std::string const &placeholder,
+	std::string const &caller, std::vector<std::string> const &arg_lines)
+{
+	std::string res;
+	res.reserve(output.size());
+	std::string::size_type last = 0, pos = 0;
+	while ((pos = output.find('\377', pos)) != std::string::npos) {
+		std::string::size_type const end = pos + placeholder.size();
+		if (end >= output.size() || output.compare(pos, placeholder.size(), placeholder) != 0) {
+			++pos;
+			continue;
+		}
+		if (output[end] == '\n' && pos >= 3 && output.compare(pos - 3, 3, " 0 ") == 0) {
+			// The end of a location "... 0 <placeholder>", nested in the caller.
+			std::string::size_type const begin = pos - 3;
+			if (caller.empty() && begin >= 5 && output.compare(begin - 5, 5, "\376line") == 0) {
+				res.append(output, last, begin - 5 - last);
+				last = end + 1;
+			} else {
+				res.append(output, last, begin - last);
+				res += caller;
+				last = end;
+			}
+		} else if (output[end] == '.' && pos >= 6 && output.compare(pos - 6, 6, "\376line ") == 0) {
+			// The directive "\376line <placeholder>.<i>" starting argument i.
+			std::string::size_type const eol = output.find('\n', end);
+			size_t const i = std::strtoul(output.c_str() + end + 1, NULL, 10);
+			assert(eol != std::string::npos && i < arg_lines.size());
+			res.append(output, last, pos - 6 - last);
+			res += arg_lines[i];
+			last = eol + 1;
+		}
+		pos = end;
+	}
+	res.append(output, last, std::string::npos);
+	return res;
+}
+
+/**
+ * Expands macro @a symbol, defined as @a val, with the arguments @a args.
+ *
+ * The expansion is recorded in a nested buffer using placeholders for the
+ * location of the caller and for the line directives starting the arguments,
+ * so that an identical invocation from elsewhere can replay it, as long as
+ * the symbols it looked up are not redefined. Expansions that define
+ * symbols or include files are not kept.
+ * @return the expansion, located as if the macro had been read in place.
+ */
+std::string preprocessor_data::expand_macro(std::string const &symbol,
+	preproc_define const &val, std::vector<std::string> &args)
+{
+	macro_memo &memo = *target_.memo_;
+	// Macro arguments are not located in the caller.
+	bool const nested = !slowpath_ && !target_.location_.empty();
+	std::string caller_location, caller;
+	if (nested) {
+		std::ostringstream s;
+		s << target_.linenum_ << ' ' << target_.resolved_location();
+		caller_location = s.str();
+		std::ostringstream t;
+		t << ' ' << target_.linenum_ << ' ' << target_.location_;
+		caller = t.str();
+	}
+	size_t const caller_size = nested ? caller_location.size() + 1 : 0;
+
+	std::ostringstream s;
+	s << '\377' << target_.level_ + 1;
+	std::string const placeholder = s.str();
+	std::ostringstream key;
+	key << symbol << ' ' << target_.textdomain_ << ' ' << target_.quoted_;
+	std::vector<std::string> arg_lines(args.size());
+	for (size_t i = 0; i < args.size(); ++i) {
+		std::string &arg = args[i];
+		std::string::size_type const eol = arg.find('\n');
+		if (arg.compare(0, 6, "\376line ") == 0 && eol != std::string::npos) {
+			arg_lines[i] = arg.substr(0, eol + 1);
+			std::ostringstream line;
+			line << "\376line " << placeholder << '.' << i << '\n';
+			arg.replace(0, eol + 1, line.str());
+			key << " l" << arg.size() - line.str().size() << ':';
+			key.write(arg.data() + line.str().size(), arg.size() - line.str().size());
+		} else {
+			key << " a" << arg.size() << ':' << arg;
+		}
+	}
+
+	macro_memo::expansion_map::const_iterator i = memo.expansions.find(key.str());
+	macro_expansion recorded;
+	macro_expansion const *e = &recorded;
+	if (i != memo.expansions.end() && memo.unchanged(i->second) &&
+	    target_.depth_ + i->second.deps.depth < 100 &&
+	    caller_size >= i->second.deps.min_caller && caller_size < i->second.deps.max_caller)
+	{
+		DBG_PREPROC << "replaying macro " << symbol << '\n';
+		e = &i->second;
+	} else {
+		DBG_PREPROC << "substituting macro " << symbol << '\n';
+		std::istringstream *buffer = new std::istringstream(val.value);
+		std::map<std::string, std::string> *defines =
+			new std::map<std::string, std::string>;
+		for (size_t i = 0; i < args.size(); ++i) {
+			(*defines)[val.arguments[i]] = args[i];
+		}
+		std::string const &dir = filesystem::directory_name(val.location.substr(0, val.location.find(' ')));
+		std::ostringstream res;
+		// Let the errors of the expansion through, the output being never empty.
+		res.exceptions(std::ios_base::failbit);
+		preprocessor_streambuf *buf =
+			new preprocessor_streambuf(target_);
+		buf->record(caller_location);
+		// Make the nested preprocessor_data responsible for
+		// restoring our current textdomain if needed.
+		buf->textdomain_ = target_.textdomain_;
+		{	std::istream in(buf);
+			new preprocessor_data(*buf, buffer, val.location, "",
+			                      val.linenum, dir, val.textdomain, defines);
+			res << in.rdbuf(); }
+		recorded.output = res.str();
+		recorded.deps = buf->deps_;
+		recorded.deps.symbols.insert(symbol);
+		recorded.level = buf->level_;
+		recorded.serial = memo.serial;
+		delete buf;
+		if (!recorded.deps.impure && !memo.seen.insert(boost::hash<std::string>()(key.str())).second) {
+			macro_expansion &kept = memo.expansions[key.str()];
+			kept = recorded;
+			e = &kept;
+		}
+	}
+
+	if (target_.recording_) {
+		target_.deps_.add(e->deps, target_.depth_ - target_.base_depth_);
+		if (nested) {
+			// The caller location of this expansion ends with the one of ours.
+			size_t const offset = caller_size - target_.caller_size();
+			if (e->deps.min_caller > offset)
+				target_.deps_.min_caller = std::max(target_.deps_.min_caller, e->deps.min_caller - offset);
+			if (e->deps.max_caller != std::numeric_limits<size_t>::max())
+				target_.deps_.max_caller = std::min(target_.deps_.max_caller, e->deps.max_caller - offset);
+		}
+	}
+
+	std::ostringstream level;
+	level << '\377' << e->level;
+	return replay_expansion(e->output, level.str(), caller, arg_lines);
+}
+
 struct preprocessor_deleter: std::basic_istream<char>
 {
 	preprocessor_streambuf *buf_;
@@ -1176,7 +1524,8 @@ preprocessor_deleter::~preprocessor_deleter()
 	delete defines_;
 }
 
-std::istream *preprocess_file(std::string const &fname, preproc_map *defines)
+std::istream *preprocess_file(std::string const &fname, preproc_map *defines,
+                              std::set<std::string> *included)
 {
 	log_scope("preprocessing file " + fname + " ...");
 	preproc_map *owned_defines = NULL;
@@ -1188,7 +1537,7 @@ std::istream *preprocess_file(std::string const &fname, preproc_map *defines)
 		owned_defines = new preproc_map;
 		defines = owned_defines;
 	}
-	preprocessor_streambuf *buf = new preprocessor_streambuf(defines);
+	preprocessor_streambuf *buf = new preprocessor_streambuf(defines, included);
 
 	new preprocessor_file(*buf, fname);
 	return new preprocessor_deleter(buf, owned_defines);
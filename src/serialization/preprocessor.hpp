@@ -20,6 +20,7 @@
 
 #include <iosfwd>
 #include <map>
+#include <set>
 #include <vector>
 
 #include "game_errors.hpp"
@@ -68,10 +69,14 @@ std::ostream& operator<<(std::ostream& stream, const preproc_map::value_type& de
  * Function to use the WML preprocessor on a file.
  *
  * @param defines                 A map of symbols defined.
+ * @param included                If not NULL, receives the names of the
+ *                                files and directories included, as the
+ *                                returned stream reads them.
  *
  * @returns                       The resulting preprocessed file data.
  */
-std::istream *preprocess_file(std::string const &fname, preproc_map *defines = NULL);
+std::istream *preprocess_file(std::string const &fname, preproc_map *defines = NULL,
+                              std::set<std::string> *included = NULL);
 
 void preprocess_resource(const std::string& res_name, preproc_map *defines_map,
 			bool write_cfg=false, bool write_plain_cfg=false, std::string target_directory="");
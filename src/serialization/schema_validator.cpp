@@ -23,6 +23,8 @@
 
 #include <boost/foreach.hpp>
 
+#include <climits>
+
 namespace schema_validation{
 
 static lg::log_domain log_validation("validation");
@@ -119,6 +121,7 @@ schema_validator::schema_validator(const std::string & config_file_name)
 	: config_read_(false)
 	, create_exceptions_(strict_validation_enabled)
 	, root_()
+	, compiled_()
 	, stack_()
 	, counter_()
 	, cache_()
@@ -129,10 +132,10 @@ schema_validator::schema_validator(const std::string & config_file_name)
 		throw abstract_validator::error("Schema file "+ config_file_name
 										+ " was not read.\n");
 	}else{
-		stack_.push(&root_);
-		counter_.push(cnt_map());
-		cache_.push(message_map());
 		root_.expand_all(root_);
+		stack_.push(&compile(root_));
+		counter_.push(cnt_list(stack_.top()->counted.size()));
+		cache_.push(message_map());
 		LOG_VL << "Schema file "<< config_file_name << " was read.\n"
 				<< "Validator initialized\n";
 	}
@@ -168,6 +171,56 @@ bool schema_validator::read_config_file(const std::string &filename){
 	config_read_ = true;
 	return true;
 }
+
+schema_validator::compiled_tag & schema_validator::compile(const class_tag & tag){
+	std::map<const class_tag *, compiled_tag>::iterator it = compiled_.find(&tag);
+	if (it != compiled_.end()){
+		return it->second;
+	}
+	compiled_tag & res = compiled_[&tag];
+	res.schema = &tag;
+
+	class_tag::all_const_tag_iterators p = tag.tags();
+	for (class_tag::const_tag_iterator child = p.first;
+		 child != p.second ; ++child){
+		if (child->second.get_min() > 0 || child->second.get_max() < INT_MAX){
+			res.counted.push_back(&child->second);
+		}
+	}
+
+	class_tag::all_const_key_iterators k = tag.keys();
+	for (class_tag::const_key_iterator key = k.first;
+		 key != k.second ; ++key){
+		std::map<std::string,boost::regex>::const_iterator type =
+				types_.find(key->second.get_type());
+		res.keys[key->first] = type != types_.end() ? &type->second : NULL;
+		if (key->second.is_mandatory()){
+			res.mandatory_keys.push_back(&key->first);
+		}
+	}
+	return res;
+}
+
+const schema_validator::compiled_child & schema_validator::find_child(
+		compiled_tag & parent, const std::string & name){
+	boost::unordered_map<std::string, compiled_child>::iterator it =
+			parent.children.find(name);
+	if (it != parent.children.end()){
+		return it->second;
+	}
+	compiled_child & res = parent.children[name];
+	if (const class_tag * tag = parent.schema->find_tag(name,root_)){
+		res.tag = &compile(*tag);
+		// The counted children are the tag's own, which find_tag() returns
+		// rather than the linked ones.
+		for (size_t i = 0; i != parent.counted.size(); ++i){
+			if (parent.counted[i] == tag){
+				res.counter = i;
+			}
+		}
+	}
+	return res;
+}
 /*
  * Please, @Note that there is some magic in pushing and poping to/from stacks.
  * assume they all are on their place due to parser algorithm
@@ -178,16 +231,17 @@ void schema_validator::open_tag(const std::string & name,
 								const std::string &file,
 								bool addittion){
 	if (! stack_.empty()){
-		const class_tag * tag = NULL;
+		compiled_tag * tag = NULL;
 		if (stack_.top()){
-			tag = stack_.top()->find_tag(name,root_);
+			const compiled_child & child = find_child(*stack_.top(),name);
+			tag = child.tag;
 			if (! tag){
-				wrong_tag_error(file,start_line,name,stack_.top()->get_name(),
+				wrong_tag_error(file,start_line,name,
+								stack_.top()->schema->get_name(),
 								create_exceptions_);
 			}else{
-				if (! addittion){
-					counter & cnt = counter_.top()[name];
-					++ cnt.cnt;
+				if (! addittion && child.counter >= 0){
+					++ counter_.top()[child.counter];
 				}
 			}
 		}
@@ -195,7 +249,7 @@ void schema_validator::open_tag(const std::string & name,
 	}else{
 		stack_.push(NULL);
 	}
-	counter_.push(cnt_map());
+	counter_.push(cnt_list(stack_.top() ? stack_.top()->counted.size() : 0));
 	cache_.push(message_map());
 }
 
@@ -225,34 +279,31 @@ void schema_validator::validate(const config & cfg, const std::string & name,
 	// Please note that validating unknown tag keys the result will be false
 	// Checking all elements counters.
 	if (!stack_.empty() && stack_.top() && config_read_){
-		class_tag::all_const_tag_iterators p = stack_.top()->tags();
-		for (class_tag::const_tag_iterator tag = p.first;
-			 tag != p.second ; ++tag){
-			int cnt = counter_.top()[tag->first].cnt;
-			if (tag->second.get_min() > cnt){
+		const compiled_tag & current = *stack_.top();
+		const cnt_list & counts = counter_.top();
+		for (size_t i = 0; i != current.counted.size(); ++i){
+			const class_tag & tag = *current.counted[i];
+			int cnt = counts[i];
+			if (tag.get_min() > cnt){
 				cache_.top()[&cfg].push_back(
 						message_info(MISSING_TAG,file,start_line,
-									 tag->second.get_min(),tag->first,"",
+									 tag.get_min(),tag.get_name(),"",
 									 name));
 				continue;
 			}
-			if (tag->second.get_max() < cnt){
+			if (tag.get_max() < cnt){
 				cache_.top()[&cfg].push_back(
 						message_info(EXTRA_TAG,file,start_line,
-									 tag->second.get_max(),tag->first,"",
+									 tag.get_max(),tag.get_name(),"",
 									 name));
 			}
 		}
 		// Checking if all mandatory keys are present
-		class_tag::all_const_key_iterators k = stack_.top()->keys();
-		for (class_tag::const_key_iterator key = k.first;
-			 key != k.second ; ++key){
-			if (key->second.is_mandatory()){
-				if (cfg.get(key->first) == NULL){
-					cache_.top()[&cfg].push_back(
-							message_info(MISSING_KEY,file,start_line,0,
-										 name,key->first ));
-				}
+		BOOST_FOREACH(const std::string * key, current.mandatory_keys){
+			if (cfg.get(*key) == NULL){
+				cache_.top()[&cfg].push_back(
+						message_info(MISSING_KEY,file,start_line,0,
+									 name,*key ));
 			}
 		}
 	}
@@ -266,25 +317,21 @@ void schema_validator::validate_key(const config & cfg,
 				  const std::string &file){
 	if (!stack_.empty() && stack_.top() && config_read_){
 		// checking existing keys
-		const class_key * key =stack_.top()->find_key(name);
-		if (key){
-			std::map<std::string,boost::regex>::iterator itt =
-					types_.find(key->get_type());
-			if (itt != types_.end()){
-				boost::smatch sub;
-				bool res = boost::regex_match(value,sub,itt->second);
-				if (!res ) {
-					cache_.top()[&cfg].push_back(
-							message_info(WRONG_VALUE,file,start_line,0,
-										 stack_.top()->get_name(),
-										 name,value));
-				}
+		const compiled_tag & current = *stack_.top();
+		boost::unordered_map<std::string, const boost::regex *>::const_iterator
+				key = current.keys.find(name);
+		if (key != current.keys.end()){
+			if (key->second && !boost::regex_match(value,*key->second)) {
+				cache_.top()[&cfg].push_back(
+						message_info(WRONG_VALUE,file,start_line,0,
+									 current.schema->get_name(),
+									 name,value));
 			}
 		}
 		else{
 			cache_.top()[&cfg].push_back(
 					message_info(EXTRA_KEY,file,start_line,0,
-								 stack_.top()->get_name(),name));
+								 current.schema->get_name(),name));
 		}
 
 	}
@@ -25,11 +25,14 @@
 
 
 #include "boost/regex.hpp"
+#include <boost/unordered_map.hpp>
 
 #include <iostream>
+#include <map>
 #include <queue>
 #include <string>
 #include <stack>
+#include <vector>
 
 /** @file
  *  One of the realizations of serialization/validator.hpp abstract validator.
@@ -67,20 +70,42 @@ public:
 							  const std::string &file);
 private:
 // types section
-	// Just some magic to ensure zero initialization.
-	struct counter{
-		int cnt;
-		counter(): cnt(0){}
-	};
 	/**
-	 * Counters are mapped by tag name
+	 * Counters of the children whose number is limited, in the order of
+	 * compiled_tag::counted.
 	 */
-	typedef std::map<std::string,counter> cnt_map;
+	typedef std::vector<int> cnt_list;
 
 	/**
-	 * And counter maps are organize in stack.
+	 * And counter lists are organize in stack.
+	 */
+	typedef std::stack<cnt_list> cnt_stack;
+
+	struct compiled_tag;
+	/** A child tag, as seen from its parent. */
+	struct compiled_child{
+		compiled_child(): tag(NULL), counter(-1){}
+		/** NULL if the tag may not be used in the parent. */
+		compiled_tag * tag;
+		/** Index of its counter, or -1 if its number is not limited. */
+		int counter;
+	};
+	/**
+	 * What validation needs to know about a tag of the schema, flattened
+	 * when the tag is first met instead of being looked up in the class_tag
+	 * tree and the types for each node.
 	 */
-	typedef std::stack<cnt_map> cnt_stack;
+	struct compiled_tag{
+		compiled_tag(): schema(NULL), children(), counted(), mandatory_keys(), keys(){}
+		const class_tag * schema;
+		/** The children met so far, with links resolved. */
+		boost::unordered_map<std::string, compiled_child> children;
+		/** The children whose number is limited. */
+		std::vector<const class_tag *> counted;
+		std::vector<const std::string *> mandatory_keys;
+		/** The allowed keys, with the regex of their type if it has one. */
+		boost::unordered_map<std::string, const boost::regex *> keys;
+	};
 
 	enum message_type{WRONG_TAG,EXTRA_TAG,MISSING_TAG,
 					EXTRA_KEY,MISSING_KEY,WRONG_VALUE};
@@ -116,6 +141,15 @@ private:
 	typedef std::map<const config *, message_list> message_map;
 
 	void print(message_info &);
+	/**
+	 * Returns the compiled form of a tag of the schema.
+	 */
+	compiled_tag & compile(const class_tag & tag);
+	/**
+	 * Returns the child @a name of @a parent, compiling it the first time.
+	 */
+	const compiled_child & find_child(compiled_tag & parent,
+									  const std::string & name);
 	/**
 	 * Reads config from input.
 	 */
@@ -132,8 +166,12 @@ private:
 	 * Root of schema information
 	 */
 	class_tag root_;
+	/**
+	 * Compiled tags of the schema, by the tag they come from.
+	 */
+	std::map<const class_tag *, compiled_tag> compiled_;
 
-	std::stack<const class_tag *> stack_;
+	std::stack<compiled_tag *> stack_;
 	/**
 	 * Contains number of children
 	 */
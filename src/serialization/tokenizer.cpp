@@ -20,6 +20,61 @@
 #include "wesconfig.h"
 #include "serialization/tokenizer.hpp"
 
+#include <cstring>
+
+#if defined __SSE2__ || defined _M_X64 || (defined _M_IX86_FP && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TOKENIZER_SSE2
+#endif
+
+namespace {
+
+/**
+ * The first character of [p, end) that ends a run of a quoted string: a
+ * quote, a line end or a comment marker. The other characters are only
+ * copied, so they can be taken in bulk.
+ */
+const char* find_quoted_string_stop(const char* p, const char* end)
+{
+#ifdef TOKENIZER_SSE2
+	const __m128i quote = _mm_set1_epi8('"');
+	const __m128i lf = _mm_set1_epi8('\n');
+	const __m128i cr = _mm_set1_epi8('\r');
+	const __m128i marker = _mm_set1_epi8(static_cast<char>(254));
+	for (; end - p >= 16; p += 16) {
+		const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+		const __m128i hits = _mm_or_si128(
+			_mm_or_si128(_mm_cmpeq_epi8(c, quote), _mm_cmpeq_epi8(c, lf)),
+			_mm_or_si128(_mm_cmpeq_epi8(c, cr), _mm_cmpeq_epi8(c, marker)));
+		if (_mm_movemask_epi8(hits) != 0) {
+			// The scalar loop finds which one it is.
+			break;
+		}
+	}
+#endif
+	for (; p != end; ++p) {
+		switch (static_cast<unsigned char>(*p)) {
+		case '"': case '\n': case '\r': case 254:
+			return p;
+		}
+	}
+	return end;
+}
+
+/** Same as above for the strings between << and >>, which have no comments. */
+const char* find_raw_string_stop(const char* p, const char* end)
+{
+	for (; p != end; ++p) {
+		switch (*p) {
+		case '>': case '\n': case '\r':
+			return p;
+		}
+	}
+	return end;
+}
+
+}
+
 
 tokenizer::tokenizer(std::istream& in) :
 	current_(EOF),
@@ -63,6 +118,7 @@ const token &tokenizer::next_token()
 	for(;;)
 	{
 		while (is_space(current_)) {
+			skip_buffered(buffered_run_end(TOK_SPACE));
 			next_char_fast();
 		}
 		if (current_ != 254)
@@ -101,6 +157,9 @@ const token &tokenizer::next_token()
 				break;
 			}
 			token_.value += current_;
+			if (current_ != '\n') {
+				append_buffered(find_raw_string_stop(in_.buffered_begin(), in_.buffered_end()));
+			}
 		}
 		break;
 
@@ -122,6 +181,9 @@ const token &tokenizer::next_token()
 				continue;
 			}
 			token_.value += current_;
+			if (current_ != '\n') {
+				append_buffered(find_quoted_string_stop(in_.buffered_begin(), in_.buffered_end()));
+			}
 		}
 		break;
 
@@ -143,6 +205,7 @@ const token &tokenizer::next_token()
 			token_.type = token::STRING;
 			do {
 				token_.value += current_;
+				append_buffered(buffered_run_end(TOK_ALPHA | TOK_NUMERIC));
 				next_char_fast();
 				while (current_ == 254) {
 					skip_comment();
@@ -202,6 +265,10 @@ void tokenizer::skip_comment()
 	{
 		fail:
 		while (current_ != '\n' && current_ != EOF) {
+			const char* begin = in_.buffered_begin();
+			const char* end = in_.buffered_end();
+			const void* lf = memchr(begin, '\n', end - begin);
+			skip_buffered(lf ? static_cast<const char*>(lf) : end);
 			next_char_fast();
 		}
 		return;
@@ -160,6 +160,38 @@ private:
 		return (char_type(c) & (TOK_ALPHA | TOK_NUMERIC)) != TOK_NONE;
 	}
 
+	/**
+	 * The end of the run of buffered characters whose type has one of the
+	 * @a types bits, starting with the next one.
+	 */
+	const char* buffered_run_end(int types) const
+	{
+		const char* p = in_.buffered_begin();
+		const char* end = in_.buffered_end();
+		while (p != end && (char_type(static_cast<unsigned char>(*p)) & types) != 0) {
+			++p;
+		}
+		return p;
+	}
+
+	/**
+	 * Consumes the buffered characters up to @a stop, as next_char_fast()
+	 * would one at a time. They should not contain '\r', which it drops,
+	 * unless they are dropped anyway.
+	 */
+	void skip_buffered(const char* stop)
+	{
+		in_.skip(stop - in_.buffered_begin());
+	}
+
+	/** Same as above, appending the characters to the current token. */
+	void append_buffered(const char* stop)
+	{
+		const char* begin = in_.buffered_begin();
+		token_.value.append(begin, stop);
+		in_.skip(stop - begin);
+	}
+
 	void skip_comment();
 
 	/**
@@ -69,6 +69,25 @@ static lg::log_domain log_server("server");
 		return dummy;
 	}
 
+	banned_ptr banned::create_dummy(unsigned int ip)
+	{
+		banned_ptr dummy(new banned(ip));
+		return dummy;
+	}
+
+	banned::banned(unsigned int ip) :
+		ip_(ip),
+		mask_(0xFFFFFFFF),
+		ip_text_(),
+		end_time_(0),
+		start_time_(0),
+		reason_(),
+		who_banned_(who_banned_default_),
+		group_(),
+		nick_()
+	{
+	}
+
 	banned::banned(const std::string& ip) :
 		ip_(0),
 		mask_(0),
@@ -571,10 +590,14 @@ static lg::log_domain log_server("server");
 				break;
 			}
 
-			// This ban is going to expire so delete it.
-			LOG_SERVER << "Remove a ban " << ban->get_ip() << ". time: " << time_now << " end_time " << ban->get_end_time() << "\n";
-			std::ostringstream os;
-			unban(os, ban->get_ip());
+			// This ban is going to expire so delete it, unless it has been
+			// replaced or lifted already.
+			const ban_set::iterator current = bans_.find(ban);
+			if (current != bans_.end() && *current == ban) {
+				LOG_SERVER << "Remove a ban " << ban->get_ip() << ". time: " << time_now << " end_time " << ban->get_end_time() << "\n";
+				std::ostringstream os;
+				unban(os, ban->get_ip());
+			}
 			time_queue_.pop();
 
 		}
@@ -661,7 +684,18 @@ static lg::log_domain log_server("server");
 		} catch (banned::error&) {
 			return "";
 		}
-		ban_set::const_iterator ban = std::find_if(bans_.begin(), bans_.end(), boost::bind(&banned::match_ip, boost::bind(&banned_ptr::get, _1), pair));
+		// bans_ is ordered by the masked addresses of the bans, and parse_ip()
+		// only makes masks of whole bytes. So a ban matching the address can
+		// only be under one of these five keys; trying them from the widest
+		// mask finds the same ban a scan of bans_ in order would.
+		static const unsigned int masks[] = { 0, 0xFF000000, 0xFFFF0000, 0xFFFFFF00, 0xFFFFFFFF };
+		ban_set::const_iterator ban = bans_.end();
+		for (size_t i = 0; i != sizeof(masks) / sizeof(*masks) && ban == bans_.end(); ++i) {
+			ban = bans_.find(banned::create_dummy(pair.first & masks[i]));
+			if (ban != bans_.end() && !(*ban)->match_ip(pair)) {
+				ban = bans_.end();
+			}
+		}
 		if (ban == bans_.end()) return "";
 		const std::string& nick = (*ban)->get_nick();
 		return (*ban)->get_reason() + (nick.empty() ? "" : " (" + nick + ")") + " (" + (*ban)->get_human_time_span() + ")";
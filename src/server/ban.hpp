@@ -68,6 +68,7 @@ namespace wesnothd {
 		static const std::string who_banned_default_;
 
 		banned(const std::string& ip);
+		explicit banned(unsigned int ip);
 
 	public:
 		banned(const std::string& ip, const time_t end_time, const std::string& reason, const std::string& who_banned=who_banned_default_, const std::string& group="", const std::string& nick="");
@@ -112,6 +113,8 @@ namespace wesnothd {
 		{ return mask_; }
 
 		static banned_ptr create_dummy(const std::string& ip);
+		/** A dummy to find the ban on the masked address @a ip in a ban_set. */
+		static banned_ptr create_dummy(unsigned int ip);
 
 		bool operator>(const banned& b) const;
 
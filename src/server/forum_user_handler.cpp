@@ -19,6 +19,8 @@
 #include "log.hpp"
 #include "config.hpp"
 
+#include <algorithm>
+#include <cctype>
 #include <stdlib.h>
 #include <sstream>
 
@@ -41,6 +43,8 @@ fuh::fuh(const config& c)
 	, db_users_table_(c["db_users_table"].str())
 	, db_extra_table_(c["db_extra_table"].str())
 	, conn(mysql_init(NULL))
+	, cache_()
+	, cache_ttl_(c["db_cache_ttl"].to_int(60))
 {
 	if(!conn || !mysql_real_connect(conn, db_host_.c_str(),  db_user_.c_str(), db_password_.c_str(), db_name_.c_str(), 0, NULL, 0)) {
 		ERR_UH << "Could not connect to database: " << mysql_errno(conn) << ": " << mysql_error(conn) << std::endl;
@@ -113,10 +117,17 @@ void fuh::user_logged_in(const std::string& name) {
 
 bool fuh::user_exists(const std::string& name) {
 
+	const std::string key = cache_key(name, "exists");
+	if(const std::string* answer = cached(key)) {
+		return !answer->empty();
+	}
+
 	// Make a test query for this username
 	try {
 		mysql_result res = db_query("SELECT username FROM " + db_users_table_ + " WHERE UPPER(username)=UPPER('" + name + "')");
-		return mysql_fetch_row(res.get());
+		const bool exists = mysql_fetch_row(res.get());
+		cache(key, exists ? "1" : "");
+		return exists;
 	} catch (error& e) {
 		ERR_UH << "Could not execute test query for user '" << name << "' :" << e.message << std::endl;
 		// If the database is down just let all usernames log in
@@ -275,12 +286,24 @@ std::string fuh::db_query_to_string(const std::string& sql) {
 
 
 std::string fuh::get_detail_for_user(const std::string& name, const std::string& detail) {
-	return db_query_to_string("SELECT " + detail + " FROM " + db_users_table_ + " WHERE UPPER(username)=UPPER('" + name + "')");
+	const std::string key = cache_key(name, db_users_table_ + "." + detail);
+	if(const std::string* answer = cached(key)) {
+		return *answer;
+	}
+	const std::string value = db_query_to_string("SELECT " + detail + " FROM " + db_users_table_ + " WHERE UPPER(username)=UPPER('" + name + "')");
+	cache(key, value);
+	return value;
 }
 
 std::string fuh::get_writable_detail_for_user(const std::string& name, const std::string& detail) {
 	if(!extra_row_exists(name)) return "";
-	return db_query_to_string("SELECT " + detail + " FROM " + db_extra_table_ + " WHERE UPPER(username)=UPPER('" + name + "')");
+	const std::string key = cache_key(name, db_extra_table_ + "." + detail);
+	if(const std::string* answer = cached(key)) {
+		return *answer;
+	}
+	const std::string value = db_query_to_string("SELECT " + detail + " FROM " + db_extra_table_ + " WHERE UPPER(username)=UPPER('" + name + "')");
+	cache(key, value);
+	return value;
 }
 
 void fuh::write_detail(const std::string& name, const std::string& detail, const std::string& value) {
@@ -291,6 +314,8 @@ void fuh::write_detail(const std::string& name, const std::string& detail, const
 			db_query("INSERT INTO " + db_extra_table_ + " VALUES('" + name + "','" + value + "','0')");
 		}
 		db_query("UPDATE " + db_extra_table_ + " SET " + detail + "='" + value + "' WHERE UPPER(username)=UPPER('" + name + "')");
+		cache(cache_key(name, "extra_exists"), "1");
+		cache(cache_key(name, db_extra_table_ + "." + detail), value);
 	} catch (error& e) {
 		ERR_UH << "Could not set detail for user '" << name << "': " << e.message << std::endl;
 	}
@@ -298,14 +323,56 @@ void fuh::write_detail(const std::string& name, const std::string& detail, const
 
 bool fuh::extra_row_exists(const std::string& name) {
 
+	const std::string key = cache_key(name, "extra_exists");
+	if(const std::string* answer = cached(key)) {
+		return !answer->empty();
+	}
+
 	// Make a test query for this username
 	try {
 		mysql_result res = db_query("SELECT username FROM " + db_extra_table_ + " WHERE UPPER(username)=UPPER('" + name + "')");
-		return mysql_fetch_row(res.get());
+		const bool exists = mysql_fetch_row(res.get());
+		cache(key, exists ? "1" : "");
+		return exists;
 	} catch (error& e) {
 		ERR_UH << "Could not execute test query for user '" << name << "' :" << e.message << std::endl;
 		return false;
 	}
 }
 
+std::string fuh::cache_key(const std::string& name, const std::string& what) {
+	// The queries compare the names with UPPER() too.
+	std::string key = name;
+	std::transform(key.begin(), key.end(), key.begin(), ::toupper);
+	return key + '\n' + what;
+}
+
+const std::string* fuh::cached(const std::string& key) const {
+	const answer_cache::const_iterator i = cache_.find(key);
+	if(i == cache_.end() || i->second.time + cache_ttl_ <= time(NULL)) {
+		return NULL;
+	}
+	return &i->second.value;
+}
+
+void fuh::cache(const std::string& key, const std::string& value) {
+	if(cache_ttl_ <= 0) {
+		return;
+	}
+	cached_answer& answer = cache_[key];
+	answer.time = time(NULL);
+	answer.value = value;
+}
+
+void fuh::clean_up() {
+	const time_t now = time(NULL);
+	for(answer_cache::iterator i = cache_.begin(); i != cache_.end(); ) {
+		if(i->second.time + cache_ttl_ <= now) {
+			cache_.erase(i++);
+		} else {
+			++i;
+		}
+	}
+}
+
 #endif //HAVE_MYSQLPP
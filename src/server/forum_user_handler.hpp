@@ -17,6 +17,7 @@
 
 #include "user_handler.hpp"
 
+#include <map>
 #include <vector>
 
 #include <boost/shared_ptr.hpp>
@@ -32,7 +33,11 @@
 //	db_password=secret
 //	db_users_table=users
 //	db_extra_table=extra_data
+//	db_cache_ttl=60
 //[/user_handler]
+//
+// db_cache_ttl is how many seconds the answers of the database are reused
+// for, 0 to always ask it.
 
 /**
  * A user_handler implementation to link the server with a phpbb3 forum.
@@ -48,7 +53,8 @@ class fuh : public user_handler {
 		// Throws user_handler::error
 		void remove_user(const std::string& name);
 
-		void clean_up() {}
+		/** Forgets the cached answers that have expired. */
+		void clean_up();
 
 		bool login(const std::string& name, const std::string& password, const std::string& seed);
 
@@ -115,6 +121,28 @@ class fuh : public user_handler {
 
 		// Same as user_exists() but checks if we have a row for this user in the extra table
 		bool extra_row_exists(const std::string& name);
+
+		/**
+		 * The answers of recent queries, by user and query.
+		 *
+		 * A login asks about the same user several times, and the database
+		 * is queried on the main thread of the server, so every query holds
+		 * up all the clients.
+		 */
+		struct cached_answer {
+			time_t time;
+			std::string value;
+		};
+		typedef std::map<std::string, cached_answer> answer_cache;
+		answer_cache cache_;
+		time_t cache_ttl_;
+
+		/** The key of @a what about @a name in cache_. */
+		static std::string cache_key(const std::string& name, const std::string& what);
+
+		/** The cached answer, or NULL if there is none recent enough. */
+		const std::string* cached(const std::string& key) const;
+		void cache(const std::string& key, const std::string& value);
 };
 
 #endif //FORUM_USER_HANDLER_HPP_INCLUDED
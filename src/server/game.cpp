@@ -61,6 +61,7 @@ game::game(player_map& players, const network::connection host,
 	started_(false),
 	level_(),
 	history_(),
+	history_segments_(0),
 	description_(NULL),
 	end_turn_(0),
 	all_observers_muted_(false),
@@ -1442,25 +1443,37 @@ void game::send_history(const network::connection sock) const
 		return;
 	}
 
+	try {
+		// The segments are sent as they are, already compressed; only the
+		// documents recorded since the last one are compacted into a new one.
+		if(history_.size() - history_segments_ > 1) {
+			compact_history(history_segments_);
+		}
+		for(t_history::iterator i = history_.begin(); i != history_.end(); ++i) {
+			const simple_wml::string_span& data = i->output_compressed();
+			network::send_raw_data(data.begin(), data.size(), sock,"game_history");
+		}
+	} catch (simple_wml::error& e) {
+		WRN_CONFIG << __func__ << ": simple_wml error: " << e.message << std::endl;
+	}
+
+}
+
+void game::compact_history(size_t first) const
+{
 	//we make a new document based on converting to plain text and
 	//concatenating the buffers.
 	//TODO: Work out how to concentate buffers without decompressing.
 	std::string buf;
-	for(t_history::iterator i = history_.begin(); i != history_.end(); ++i) {
+	for(t_history::iterator i = history_.begin() + first; i != history_.end(); ++i) {
 		buf += i->output();
 	}
 
-	try {
-		simple_wml::document* doc = new simple_wml::document(buf.c_str(), simple_wml::INIT_STATIC);
-		const simple_wml::string_span& data = doc->output_compressed();
-		doc->compress();
-		network::send_raw_data(data.begin(), data.size(), sock,"game_history");
-		history_.clear();
-		history_.push_back(doc);
-	} catch (simple_wml::error& e) {
-		WRN_CONFIG << __func__ << ": simple_wml error: " << e.message << std::endl;
-	}
-
+	std::auto_ptr<simple_wml::document> doc(new simple_wml::document(buf.c_str(), simple_wml::INIT_STATIC));
+	doc->compress();
+	history_.erase(history_.begin() + first, history_.end());
+	history_.push_back(doc.release());
+	history_segments_ = first + 1;
 }
 
 static bool is_invalid_filename_char(char c) {
@@ -1482,6 +1495,7 @@ void game::save_replay() {
 		}
 	}
 	history_.clear();
+	history_segments_ = 0;
 
 	std::stringstream name;
 	name << (*starting_pos( level_.root()))["name"] << " Turn " << current_turn();
@@ -1523,14 +1537,33 @@ void game::save_replay() {
 	}
 }
 
+size_t game::memory_usage() const {
+	size_t res = level_.memory_usage();
+	for(t_history::const_iterator i = history_.begin(); i != history_.end(); ++i) {
+		res += i->memory_usage();
+	}
+	return res;
+}
+
 void game::record_data(simple_wml::document* data) {
 	data->compress();
 	history_.push_back(data);
+
+	// Compact the documents recorded since the last segment.
+	static const size_t segment_documents = 64;
+	if(history_.size() - history_segments_ >= segment_documents) {
+		try {
+			compact_history(history_segments_);
+		} catch (simple_wml::error& e) {
+			WRN_CONFIG << __func__ << ": simple_wml error: " << e.message << std::endl;
+		}
+	}
 }
 
 void game::clear_history() {
 	if (history_.empty()) return;
 	history_.clear();
+	history_segments_ = 0;
 }
 
 void game::set_description(simple_wml::node* desc) {
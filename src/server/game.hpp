@@ -203,6 +203,9 @@ public:
 	/** The full scenario data. */
 	simple_wml::document& level() { return level_; }
 
+	/** The memory used by the scenario data and the history, as simple_wml::document::memory_usage(). */
+	size_t memory_usage() const;
+
 	/**
 	 * Functions to set/get the address of the game's summary description as
 	 * sent to players in the lobby.
@@ -273,6 +276,7 @@ private:
 	 */
 	void send_observerjoins(const network::connection sock=0) const;
 	void send_observerquit(const player_map::const_iterator observer) const;
+	/** Sends the replay data to a joining observer, one compressed segment after the other. */
 	void send_history(const network::connection sock) const;
 
 	/** In case of a host transfer, notify the new host about its status. */
@@ -383,6 +387,17 @@ private:
 	/** Replay data. */
 	typedef boost::ptr_vector<simple_wml::document> t_history;
 	mutable t_history history_;
+	/** The number of documents at the start of history_ that are compacted segments. */
+	mutable size_t history_segments_;
+
+	/**
+	 * Replaces the documents of history_ from @a first on with a single
+	 * compressed document holding their contents.
+	 *
+	 * One compressed document takes a lot less memory than the many small
+	 * ones it replaces.
+	 */
+	void compact_history(size_t first) const;
 
 	/** Pointer to the game's description in the games_and_users_list_. */
 	simple_wml::node* description_;
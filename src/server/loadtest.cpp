@@ -0,0 +1,210 @@
+/*
+   Copyright (C) 2015 by the Battle for Wesnoth Project
+   Part of the Battle for Wesnoth Project http://www.wesnoth.org/
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY.
+
+   See the COPYING file for more details.
+*/
+
+/**
+ * @file
+ * Load generator for wesnothd.
+ *
+ * Opens a number of connections to a server, logs each of them into the
+ * lobby the way the game does, then has them all send queries as fast as
+ * the server answers. The throughput and the distribution of the round trip
+ * times are reported at the end.
+ */
+
+#include "../global.hpp"
+
+#include "../config.hpp"
+#include "../game_config.hpp"
+#include "../log.hpp"
+#include "../network_asio.hpp"
+#include "../thread.hpp"
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+namespace {
+
+struct options
+{
+	options()
+		: host("localhost")
+		, port("15000")
+		, prefix("loadtest")
+		, clients(10)
+		, requests(100)
+	{}
+
+	std::string host, port;
+	/** The clients log in as prefix_0, prefix_1, ... */
+	std::string prefix;
+	size_t clients;
+	/** The number of queries each client sends. */
+	size_t requests;
+};
+
+/** Waits for the data sent by the server, reading until @a wanted. */
+void receive(network_asio::connection& conn, config& response, const std::string& wanted)
+{
+	do {
+		conn.receive(response);
+		conn.run();
+	} while(!response.child(wanted));
+}
+
+/** Simulates one client, recording the round trip time of its queries. */
+class client_job : public threading::parallel_job
+{
+public:
+	explicit client_job(const options& opts)
+		: opts_(opts)
+		, guard_()
+		, latencies_()
+		, failures_(0)
+	{}
+
+	void run(size_t index)
+	{
+		std::vector<long> latencies;
+		try {
+			play(index, latencies);
+		} catch(std::exception& e) {
+			// Covers game::error and the errors of network_asio.
+			const threading::lock lock(guard_);
+			std::cerr << "client " << index << ": " << e.what() << "\n";
+			++failures_;
+		}
+
+		const threading::lock lock(guard_);
+		latencies_.insert(latencies_.end(), latencies.begin(), latencies.end());
+	}
+
+	/** The round trip times, in microseconds, of all the queries answered. */
+	std::vector<long>& latencies() { return latencies_; }
+	size_t failures() const { return failures_; }
+
+private:
+	void play(size_t index, std::vector<long>& latencies)
+	{
+		network_asio::connection conn(opts_.host, opts_.port);
+		conn.run();
+
+		config response;
+		receive(conn, response, "version");
+
+		config version;
+		version.add_child("version")["version"] = game_config::version;
+		conn.transfer(version, response);
+		conn.run();
+		if(!response.child("mustlogin")) {
+			throw game::error("the server didn't ask to log in");
+		}
+
+		std::ostringstream name;
+		name << opts_.prefix << '_' << index;
+		config login;
+		login.add_child("login")["username"] = name.str();
+		conn.transfer(login, response);
+		conn.run();
+		if(!response.child("join_lobby")) {
+			throw game::error("could not log in as " + name.str());
+		}
+		receive(conn, response, "gamelist");
+
+		config query;
+		query.add_child("query")["type"] = "help";
+		for(size_t i = 0; i != opts_.requests; ++i) {
+			const boost::posix_time::ptime sent = boost::posix_time::microsec_clock::universal_time();
+			conn.transfer(query, response);
+			conn.run();
+			// Lobby traffic from the other clients arrives in between.
+			while(!is_answer(response)) {
+				conn.receive(response);
+				conn.run();
+			}
+			latencies.push_back((boost::posix_time::microsec_clock::universal_time() - sent).total_microseconds());
+		}
+	}
+
+	static bool is_answer(const config& response)
+	{
+		const config& message = response.child("message");
+		return message && message["sender"] == "server"
+			&& message["message"].str().compare(0, 19, "Available commands ") == 0;
+	}
+
+	const options& opts_;
+	threading::mutex guard_;
+	std::vector<long> latencies_;
+	size_t failures_;
+};
+
+long percentile(const std::vector<long>& sorted, unsigned percent)
+{
+	return sorted[std::min(sorted.size() - 1, sorted.size() * percent / 100)];
+}
+
+}
+
+int main(int argc, char** argv)
+{
+	options opts;
+	for(int arg = 1; arg != argc; ++arg) {
+		const std::string val(argv[arg]);
+		if((val == "--host" || val == "-H") && arg + 1 != argc) {
+			opts.host = argv[++arg];
+		} else if((val == "--port" || val == "-p") && arg + 1 != argc) {
+			opts.port = argv[++arg];
+		} else if((val == "--clients" || val == "-c") && arg + 1 != argc) {
+			opts.clients = atoi(argv[++arg]);
+		} else if((val == "--requests" || val == "-r") && arg + 1 != argc) {
+			opts.requests = atoi(argv[++arg]);
+		} else if(val == "--prefix" && arg + 1 != argc) {
+			opts.prefix = argv[++arg];
+		} else {
+			std::cout << "usage: " << argv[0]
+				<< " [-H <host>] [-p <port>] [-c <clients>] [-r <requests>] [--prefix <name>]\n"
+				<< "  -H, --host <host>          The server to connect to (default: localhost).\n"
+				<< "  -p, --port <port>          Its port (default: 15000).\n"
+				<< "  -c, --clients <n>          Logs in n clients at the same time (default: 10).\n"
+				<< "  -r, --requests <n>         Queries sent by each client (default: 100).\n"
+				<< "  --prefix <name>            Names the clients <name>_0, <name>_1, ... (default: loadtest).\n";
+			return val == "--help" || val == "-h" ? 0 : 2;
+		}
+	}
+
+	client_job job(opts);
+	const boost::posix_time::ptime started = boost::posix_time::microsec_clock::universal_time();
+	threading::run_parallel(job, opts.clients, opts.clients);
+	const double seconds = (boost::posix_time::microsec_clock::universal_time() - started).total_microseconds() / 1e6;
+
+	std::vector<long>& latencies = job.latencies();
+	std::cout << opts.clients - job.failures() << " of " << opts.clients << " clients finished, "
+		<< latencies.size() << " requests answered in " << seconds << " s";
+	if(latencies.empty()) {
+		std::cout << "\n";
+		return 1;
+	}
+	std::sort(latencies.begin(), latencies.end());
+	std::cout << " (" << latencies.size() / seconds << " requests/s)\n"
+		<< "round trip in microseconds: p50 " << percentile(latencies, 50)
+		<< ", p90 " << percentile(latencies, 90)
+		<< ", p99 " << percentile(latencies, 99)
+		<< ", max " << latencies.back() << "\n";
+	return job.failures() ? 1 : 0;
+}
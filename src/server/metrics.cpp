@@ -77,15 +77,14 @@ void metrics::no_requests()
 	current_requests_ = 0;
 }
 
-void metrics::record_sample(const simple_wml::string_span& name,
-                            clock_t parsing_time, clock_t processing_time)
+metrics::sample* metrics::find_sample(const simple_wml::string_span& name)
 {
 	std::vector<sample>::iterator isample = std::lower_bound(samples_.begin(), samples_.end(), name,compare_samples_to_stringspan());
 	if(isample == samples_.end()
 		|| isample->name != name) {
 		//protect against DoS with memory exhaustion
 		if(samples_.size() > 30) {
-			return;
+			return NULL;
 		}
 		int index = isample - samples_.begin();
 		simple_wml::string_span dup_name(name.duplicate());
@@ -95,6 +94,16 @@ void metrics::record_sample(const simple_wml::string_span& name,
 
 		isample = samples_.begin() + index;
 	}
+	return &*isample;
+}
+
+void metrics::record_sample(const simple_wml::string_span& name,
+                            clock_t parsing_time, clock_t processing_time)
+{
+	sample* isample = find_sample(name);
+	if(isample == NULL) {
+		return;
+	}
 
 	isample->nsamples++;
 	isample->parsing_time += parsing_time;
@@ -103,6 +112,21 @@ void metrics::record_sample(const simple_wml::string_span& name,
 	isample->max_processing_time = std::max(processing_time,isample->max_processing_time);
 }
 
+const long metrics::duration_buckets[metrics::nduration_buckets] =
+	{ 100, 1000, 10000, 100000, 1000000, 10000000 };
+
+void metrics::record_request(const simple_wml::string_span& name, long duration)
+{
+	sample* isample = find_sample(name);
+	if(isample == NULL) {
+		return;
+	}
+
+	isample->nrequests++;
+	isample->total_duration += duration;
+	isample->durations[std::lower_bound(duration_buckets, duration_buckets + nduration_buckets, duration) - duration_buckets]++;
+}
+
 void metrics::game_terminated(const std::string& reason)
 {
 	terminations_[reason]++;
@@ -150,6 +174,66 @@ std::ostream& metrics::requests(std::ostream& out) const
 	return out;
 }
 
+namespace {
+
+/** Writes @a value as a label value, with the escapes the text format wants. */
+struct label
+{
+	explicit label(const std::string& v) : value(v) {}
+	const std::string& value;
+};
+
+std::ostream& operator<<(std::ostream& out, const label& l)
+{
+	out << '"';
+	for(std::string::const_iterator c = l.value.begin(); c != l.value.end(); ++c) {
+		if(*c == '\\' || *c == '"') {
+			out << '\\' << *c;
+		} else if(*c == '\n') {
+			out << "\\n";
+		} else {
+			out << *c;
+		}
+	}
+	return out << '"';
+}
+
+}
+
+std::ostream& metrics::exposition(std::ostream& out) const
+{
+	out << "# TYPE wesnothd_uptime_seconds gauge\n"
+		<< "wesnothd_uptime_seconds " << time(NULL) - started_at_ << "\n"
+		<< "# TYPE wesnothd_requests_total counter\n"
+		<< "wesnothd_requests_total " << nrequests_ << "\n"
+		<< "# TYPE wesnothd_requests_waited_total counter\n"
+		<< "wesnothd_requests_waited_total " << nrequests_waited_ << "\n"
+		<< "# TYPE wesnothd_request_burst_max gauge\n"
+		<< "wesnothd_request_burst_max " << most_consecutive_requests_ << "\n";
+
+	out << "# TYPE wesnothd_request_duration_microseconds histogram\n";
+	for(std::vector<sample>::const_iterator s = samples_.begin(); s != samples_.end(); ++s) {
+		const std::string type = s->name.to_string();
+		long count = 0;
+		for(size_t i = 0; i != nduration_buckets; ++i) {
+			count += s->durations[i];
+			out << "wesnothd_request_duration_microseconds_bucket{type=" << label(type)
+				<< ",le=\"" << duration_buckets[i] << "\"} " << count << "\n";
+		}
+		out << "wesnothd_request_duration_microseconds_bucket{type=" << label(type)
+			<< ",le=\"+Inf\"} " << s->nrequests << "\n"
+			<< "wesnothd_request_duration_microseconds_sum{type=" << label(type) << "} " << s->total_duration << "\n"
+			<< "wesnothd_request_duration_microseconds_count{type=" << label(type) << "} " << s->nrequests << "\n";
+	}
+
+	out << "# TYPE wesnothd_games_terminated_total counter\n";
+	for(std::map<std::string,int>::const_iterator i = terminations_.begin(); i != terminations_.end(); ++i) {
+		out << "wesnothd_games_terminated_total{reason=" << label(i->first) << "} " << i->second << "\n";
+	}
+
+	return out;
+}
+
 std::ostream& operator<<(std::ostream& out, metrics& met)
 {
 	const time_t time_up = time(NULL) - met.started_at_;
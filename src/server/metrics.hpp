@@ -19,6 +19,7 @@
 
 #include <iosfwd>
 
+#include <algorithm>
 #include <map>
 #include <string>
 #include <time.h>
@@ -37,12 +38,25 @@ public:
 	void record_sample(const simple_wml::string_span& name,
 	                   clock_t parsing_time, clock_t processing_time);
 
+	/** Records the wall time, in microseconds, taken to process a request. */
+	void record_request(const simple_wml::string_span& name, long duration);
+
 	void game_terminated(const std::string& reason);
 
 	std::ostream& games(std::ostream& out) const;
 	std::ostream& requests(std::ostream& out) const;
+
+	/**
+	 * Writes the metrics in the Prometheus text exposition format, one
+	 * "name{labels} value" line each, for monitoring tools to scrape.
+	 */
+	std::ostream& exposition(std::ostream& out) const;
 	friend std::ostream& operator<<(std::ostream& out, metrics& met);
 
+	/** The upper bounds, in microseconds, of the request duration histogram. */
+	static const long duration_buckets[];
+	static const size_t nduration_buckets = 6;
+
 	struct sample {
 
 		sample() :
@@ -51,8 +65,11 @@ public:
 			parsing_time(0),
 			processing_time(0),
 			max_parsing_time(0),
-			max_processing_time(0)
+			max_processing_time(0),
+			nrequests(0),
+			total_duration(0)
 		{
+			std::fill(durations, durations + nduration_buckets + 1, 0);
 		}
 
 		simple_wml::string_span name;
@@ -60,6 +77,11 @@ public:
 		clock_t parsing_time, processing_time;
 		clock_t max_parsing_time, max_processing_time;
 
+		/** All the requests, with the number per duration bucket; the last one has no bound. */
+		long nrequests;
+		long long total_duration;
+		long durations[nduration_buckets + 1];
+
 		operator const simple_wml::string_span&()
 		{
 			return name;
@@ -67,6 +89,9 @@ public:
 	};
 
 private:
+	/** The sample for @a name, created if needed, or NULL if there are too many already. */
+	sample* find_sample(const simple_wml::string_span& name);
+
 	std::vector<sample> samples_;
 
 	int most_consecutive_requests_;
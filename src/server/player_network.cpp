@@ -62,11 +62,16 @@ void send_to_many(simple_wml::document& data, const connection_vector& vec,
 		packet_type = data.root().first_child().to_string();
 	try {
 		simple_wml::string_span s = data.output_compressed();
+		connection_vector recipients;
+		recipients.reserve(vec.size());
 		for(connection_vector::const_iterator i = vec.begin(); i != vec.end(); ++i) {
 			if (*i != exclude) {
-				network::send_raw_data(s.begin(), s.size(), *i, packet_type);
+				recipients.push_back(*i);
 			}
 		}
+		if(!recipients.empty()) {
+			network::send_raw_packet(network::make_raw_packet(s.begin(), s.size()), recipients, packet_type);
+		}
 	} catch (simple_wml::error& e) {
 		WRN_CONFIG << __func__ << ": simple_wml error: " << e.message << std::endl;
 	}
@@ -80,11 +85,16 @@ void send_to_many(simple_wml::document& data, const connection_vector& vec,
 		packet_type = data.root().first_child().to_string();
 	try {
 		simple_wml::string_span s = data.output_compressed();
+		connection_vector recipients;
+		recipients.reserve(vec.size());
 		for(connection_vector::const_iterator i = vec.begin(); i != vec.end(); ++i) {
 			if ((*i != exclude) && pred(*i)) {
-				network::send_raw_data(s.begin(), s.size(), *i, packet_type);
+				recipients.push_back(*i);
 			}
 		}
+		if(!recipients.empty()) {
+			network::send_raw_packet(network::make_raw_packet(s.begin(), s.size()), recipients, packet_type);
+		}
 	} catch (simple_wml::error& e) {
 		WRN_CONFIG << __func__ << ": simple_wml error: " << e.message << std::endl;
 	}
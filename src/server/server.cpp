@@ -51,6 +51,7 @@
 #endif
 
 #include <boost/bind.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/scoped_ptr.hpp>
 #include <boost/scoped_array.hpp>
 #include <boost/foreach.hpp>
@@ -58,7 +59,10 @@
 #include <algorithm>
 #include <cassert>
 #include <cerrno>
+#include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <map>
@@ -309,7 +313,7 @@ namespace {
 	const std::string help_msg = "Available commands are: adminmsg <msg>,"
 		" ban <mask> <time> <reason>, bans [deleted] [<ipmask>], clones,"
 		" dul|deny_unregistered_login [yes|no], kick <mask> [<reason>],"
-		" k[ick]ban <mask> <time> <reason>, help, games, metrics,"
+		" k[ick]ban <mask> <time> <reason>, help, games, meminfo, metrics,"
 		" netstats [all], [lobby]msg <message>, motd [<message>],"
 		" pm|privatemsg <nickname> <message>, requests, sample, searchlog <mask>,"
 		" signout, stats, status [<mask>], unban <ipmask>\n"
@@ -324,12 +328,16 @@ server::server(int port, const std::string& config_file, size_t min_threads,
 	server_(port),
 	ban_manager_(),
 	ip_log_(),
+	ip_log_by_nick_(),
+	ip_log_by_ip_(),
 	failed_logins_(),
+	failed_logins_by_ip_(),
 	user_handler_(NULL),
 	seeds_(),
 	players_(),
 	ghost_players_(),
 	games_(),
+	changed_games_(),
 	not_logged_in_(),
 	rooms_(players_),
 	input_(),
@@ -356,6 +364,7 @@ server::server(int port, const std::string& config_file, size_t min_threads,
 	save_replays_(false),
 	replay_save_path_(),
 	allow_remote_shutdown_(false),
+	metrics_path_(),
 	tor_ip_list_(),
 	failed_login_limit_(),
 	failed_login_ban_(),
@@ -368,6 +377,7 @@ server::server(int port, const std::string& config_file, size_t min_threads,
 	last_ping_(time(NULL)),
 	last_stats_(last_ping_),
 	last_uh_clean_(last_ping_),
+	last_metrics_(last_ping_),
 	cmd_handlers_()
 {
 	setup_handlers();
@@ -395,6 +405,7 @@ void server::setup_handlers()
 	cmd_handlers_["games"] = &server::games_handler;
 	cmd_handlers_["wml"] = &server::wml_handler;
 	cmd_handlers_["netstats"] = &server::netstats_handler;
+	cmd_handlers_["meminfo"] = &server::meminfo_handler;
 	cmd_handlers_["report"]   = &server::adminmsg_handler;
 	cmd_handlers_["adminmsg"] = &server::adminmsg_handler;
 	cmd_handlers_["pm"] = &server::pm_handler;
@@ -520,6 +531,10 @@ void server::load_config() {
 
 	allow_remote_shutdown_ = cfg_["allow_remote_shutdown"].to_bool();
 
+	// Example config line, for the textfile collector of node_exporter:
+	// metrics_file="/var/lib/node_exporter/wesnothd.prom"
+	metrics_path_ = cfg_["metrics_file"].str();
+
 	disallowed_names_.clear();
 	if (cfg_["disallow_names"] == "") {
 		disallowed_names_.push_back("*admin*");
@@ -538,6 +553,9 @@ void server::load_config() {
 	default_time_period_ = cfg_["messages_time_period"].to_int(10);
 	concurrent_connections_ = cfg_["connections_allowed"].to_int(5);
 	max_ip_log_size_ = cfg_["max_ip_log_size"].to_int(500);
+	// In KiB. Clients not reading their data fast enough are disconnected
+	// beyond it, instead of having it pile up in the server.
+	network::set_send_queue_limit(cfg_["send_queue_limit"].to_int(65536) * 1024);
 
 	failed_login_limit_ = cfg_["failed_logins_limit"].to_int(10);
 	failed_login_ban_ = cfg_["failed_logins_ban"].to_int(3600);
@@ -596,6 +614,46 @@ void server::load_config() {
 	}
 }
 
+server::t_ip_log::iterator server::find_connection_log(const std::string& nick, const std::string& ip)
+{
+	const t_ip_log_index::const_iterator entries = ip_log_by_nick_.find(nick);
+	if(entries != ip_log_by_nick_.end()) {
+		BOOST_FOREACH(const t_ip_log::iterator& entry, entries->second) {
+			if(entry->ip == ip) {
+				return entry;
+			}
+		}
+	}
+	return ip_log_.end();
+}
+
+void server::log_connection(const std::string& nick, const std::string& ip)
+{
+	if(find_connection_log(nick, ip) != ip_log_.end()) {
+		return;
+	}
+	ip_log_.push_back(connection_log(nick, ip, 0));
+	ip_log_by_nick_[nick].push_back(--ip_log_.end());
+	ip_log_by_ip_[ip].push_back(--ip_log_.end());
+
+	// Remove the oldest entries if the size of the IP log exceeds the maximum size
+	while(ip_log_.size() > std::max<size_t>(max_ip_log_size_, 1)) {
+		// Being the oldest entry overall, it comes first for its nick and its ip.
+		const connection_log& oldest = ip_log_.front();
+		std::vector<t_ip_log::iterator>& by_nick = ip_log_by_nick_[oldest.nick];
+		by_nick.erase(by_nick.begin());
+		if(by_nick.empty()) {
+			ip_log_by_nick_.erase(oldest.nick);
+		}
+		std::vector<t_ip_log::iterator>& by_ip = ip_log_by_ip_[oldest.ip];
+		by_ip.erase(by_ip.begin());
+		if(by_ip.empty()) {
+			ip_log_by_ip_.erase(oldest.ip);
+		}
+		ip_log_.pop_front();
+	}
+}
+
 bool server::ip_exceeds_connection_limit(const std::string& ip) const {
 	if (concurrent_connections_ == 0) return false;
 	size_t connections = 0;
@@ -623,6 +681,43 @@ void server::dump_stats(const time_t& now) {
 		<< "\tlobby_users = " << rooms_.lobby().size() << "\n";
 }
 
+void server::export_metrics(const time_t& now) {
+	last_metrics_ = now;
+	const std::string tmp_path = metrics_path_ + ".tmp";
+	{
+		std::ofstream out(tmp_path.c_str());
+		const network::pending_statistics pending = network::get_pending_stats();
+		metrics_.exposition(out)
+			<< "# TYPE wesnothd_games gauge\n"
+			<< "wesnothd_games " << games_.size() << "\n"
+			<< "# TYPE wesnothd_users gauge\n"
+			<< "wesnothd_users " << players_.size() << "\n"
+			<< "# TYPE wesnothd_lobby_users gauge\n"
+			<< "wesnothd_lobby_users " << rooms_.lobby().size() << "\n"
+			<< "# TYPE wesnothd_pending_sends gauge\n"
+			<< "wesnothd_pending_sends " << pending.npending_sends << "\n"
+			<< "# TYPE wesnothd_pending_send_bytes gauge\n"
+			<< "wesnothd_pending_send_bytes " << pending.nbytes_pending_sends << "\n"
+			<< "# TYPE wesnothd_pending_sends_by_class gauge\n"
+			<< "wesnothd_pending_sends_by_class{class=\"game\"} " << pending.npending_game_sends << "\n"
+			<< "wesnothd_pending_sends_by_class{class=\"chat\"} " << pending.npending_chat_sends << "\n"
+			<< "wesnothd_pending_sends_by_class{class=\"lobby\"} " << pending.npending_lobby_sends << "\n"
+			<< "# TYPE wesnothd_largest_send_backlog_bytes gauge\n"
+			<< "wesnothd_largest_send_backlog_bytes " << pending.nbytes_largest_backlog << "\n"
+			<< "# TYPE wesnothd_coalesced_sends_total counter\n"
+			<< "wesnothd_coalesced_sends_total " << pending.ncoalesced_sends << "\n"
+			<< "# TYPE wesnothd_send_queue_overflows_total counter\n"
+			<< "wesnothd_send_queue_overflows_total " << pending.noverflowed_connections << "\n";
+		if(!out.good()) {
+			ERR_SERVER << "Could not write the metrics to " << tmp_path << std::endl;
+			return;
+		}
+	}
+	if(std::rename(tmp_path.c_str(), metrics_path_.c_str()) != 0) {
+		ERR_SERVER << "Could not replace " << metrics_path_ << ": " << strerror(errno) << std::endl;
+	}
+}
+
 void server::clean_user_handler(const time_t& now) {
 	if(!user_handler_) {
 		return;
@@ -708,6 +803,7 @@ void server::run() {
 				simple_wml::document ping( strstr.str().c_str(),
 							   simple_wml::INIT_COMPRESSED );
 				simple_wml::string_span s = ping.output_compressed();
+				const network::raw_packet packet = network::make_raw_packet(s.begin(), s.size());
 				BOOST_FOREACH(network::connection sock, ghost_players_) {
 					if (!lg::debug.dont_log(log_server)) {
 						wesnothd::player_map::const_iterator i = players_.find(sock);
@@ -717,7 +813,7 @@ void server::run() {
 							ERR_SERVER << "Player " << sock << " is in ghost_players_ but not in players_." << std::endl;
 						}
 					}
-					network::send_raw_data(s.begin(), s.size(), sock, "ping") ;
+					network::send_raw_packet(packet, sock, "ping");
 				}
 
  				// Copy new player list on top of ghost_players_ list.
@@ -730,6 +826,14 @@ void server::run() {
 				last_ping_ = now;
 			}
 
+			// The games changed while processing the previous batch of
+			// requests get a single lobby update each.
+			send_game_updates();
+
+			if (!metrics_path_.empty() && last_metrics_ + 10 <= now) {
+				export_metrics(now);
+			}
+
 			network::process_send_queue();
 
 			network::connection sock = network::accept_connection();
@@ -791,8 +895,14 @@ void server::run() {
 
 				const clock_t after_parsing = get_cpu_time(sample);
 
+				const boost::posix_time::ptime before_processing =
+					boost::posix_time::microsec_clock::universal_time();
+
 				process_data(sock, data);
 
+				metrics_.record_request(data.root().first_child(),
+					(boost::posix_time::microsec_clock::universal_time() - before_processing).total_microseconds());
+
 				bandwidth_type->set_type(data.root().first_child().to_string());
 				if(sample) {
 					const clock_t after_processing = get_cpu_time(sample);
@@ -879,15 +989,14 @@ void server::run() {
 					} else {
 						g->describe_slots();
 
-						update_game_in_lobby(*g, e.socket);
+						update_game_in_lobby(*g);
 					}
 					break;
 				}
 			}
 
 			// Find the matching nick-ip pair in the log and update the sign off time
-			connection_log ip_name = connection_log(pl_it->second.name(), ip, 0);
-			std::deque<connection_log>::iterator i = std::find(ip_log_.begin(), ip_log_.end(), ip_name);
+			const t_ip_log::iterator i = find_connection_log(pl_it->second.name(), ip);
 			if(i != ip_log_.end()) {
 				i->log_off = time(NULL);
 			}
@@ -1149,22 +1258,27 @@ void server::process_login(const network::connection sock,
 				seeds_.erase(sock);
 
 				login_log login_ip = login_log(network::ip_address(sock), 0, now);
-				std::deque<login_log>::iterator i = std::find(failed_logins_.begin(), failed_logins_.end(), login_ip);
-				if(i == failed_logins_.end()) {
+				std::list<login_log>::iterator i;
+				const boost::unordered_map<std::string, std::list<login_log>::iterator>::const_iterator
+					logged = failed_logins_by_ip_.find(login_ip.ip);
+				if(logged == failed_logins_by_ip_.end()) {
 					failed_logins_.push_back(login_ip);
 					i = --failed_logins_.end();
+					failed_logins_by_ip_.insert(std::make_pair(login_ip.ip, i));
 
 					// Remove oldest entry if maximum size is exceeded
-					if(failed_logins_.size() > failed_login_buffer_size_)
+					if(failed_logins_.size() > std::max<size_t>(failed_login_buffer_size_, 1)) {
+						failed_logins_by_ip_.erase(failed_logins_.front().ip);
 						failed_logins_.pop_front();
-
+					}
+				} else {
+					i = logged->second;
 				}
 
 				if (i->first_attempt + failed_login_ban_ < now) {
-					// Clear and move to the beginning
-					failed_logins_.erase(i);
-					failed_logins_.push_back(login_ip);
-					i = --failed_logins_.end();
+					// Clear and move to the end, as the newest entry
+					*i = login_ip;
+					failed_logins_.splice(failed_logins_.end(), failed_logins_, i);
 				}
 
 				i->attempts++;
@@ -1267,12 +1381,7 @@ void server::process_login(const network::connection sock,
 	}
 
 	// Log the IP
-	connection_log ip_name = connection_log(username, network::ip_address(sock), 0);
-	if (std::find(ip_log_.begin(), ip_log_.end(), ip_name) == ip_log_.end()) {
-		ip_log_.push_back(ip_name);
-		// Remove the oldest entry if the size of the IP log exceeds the maximum size
-		if(ip_log_.size() > max_ip_log_size_) ip_log_.pop_front();
-	}
+	log_connection(username, network::ip_address(sock));
 }
 
 void server::process_query(const network::connection sock,
@@ -1508,13 +1617,32 @@ void server::wml_handler(const std::string& /*issuer_name*/, const std::string&
 	*out << simple_wml::document::stats();
 }
 
+void server::meminfo_handler(const std::string& /*issuer_name*/, const std::string& /*query*/, std::string& /*parameters*/, std::ostringstream *out) {
+	assert(out != NULL);
+
+	size_t game_bytes = 0;
+	for(t_games::const_iterator g = games_.begin(); g != games_.end(); ++g) {
+		game_bytes += g->memory_usage();
+	}
+	const network::pending_statistics pending = network::get_pending_stats();
+	*out << "Games: " << games_.size() << " (" << game_bytes / 1024
+		<< " KiB of scenarios and histories)\nPending send buffers: "
+		<< pending.npending_sends << " (" << pending.nbytes_pending_sends / 1024
+		<< " KiB)\n" << simple_wml::document::stats();
+}
+
 void server::netstats_handler(const std::string& /*issuer_name*/, const std::string& /*query*/, std::string& parameters, std::ostringstream *out) {
 	assert(out != NULL);
 
 	network::pending_statistics stats = network::get_pending_stats();
 	*out << "Network stats:\nPending send buffers: "
-		<< stats.npending_sends << "\nBytes in buffers: "
-		<< stats.nbytes_pending_sends << "\n";
+		<< stats.npending_sends << " (game " << stats.npending_game_sends
+		<< ", chat " << stats.npending_chat_sends
+		<< ", lobby " << stats.npending_lobby_sends << ")\nBytes in buffers: "
+		<< stats.nbytes_pending_sends << "\nLargest backlog: "
+		<< stats.nbytes_largest_backlog << " bytes\nCoalesced lobby updates: "
+		<< stats.ncoalesced_sends << "\nConnections dropped for overflowing: "
+		<< stats.noverflowed_connections << "\n";
 
 	try {
 
@@ -1671,22 +1799,25 @@ void server::clones_handler(const std::string& /*issuer_name*/, const std::strin
 	assert(out != NULL);
 
 	*out << "CLONES STATUS REPORT";
-	std::set<std::string> clones;
+	// Group the players by ip, keeping the order of players_ within each group.
+	std::vector<std::string> ips;
+	boost::unordered_map<std::string, std::vector<wesnothd::player_map::const_iterator> > by_ip;
 	for (wesnothd::player_map::const_iterator pl = players_.begin(); pl != players_.end(); ++pl) {
-		if (clones.find(network::ip_address(pl->first)) != clones.end()) continue;
-		bool found = false;
-		for (wesnothd::player_map::const_iterator clone = boost::next(pl); clone != players_.end(); ++clone) {
-			if (network::ip_address(pl->first) == network::ip_address(clone->first)) {
-				if (!found) {
-					found = true;
-					clones.insert(network::ip_address(pl->first));
-					*out << std::endl << player_status(pl);
-				}
-				*out << std::endl << player_status(clone);
-			}
+		const std::string ip = network::ip_address(pl->first);
+		std::vector<wesnothd::player_map::const_iterator>& same_ip = by_ip[ip];
+		if (same_ip.empty()) ips.push_back(ip);
+		same_ip.push_back(pl);
+	}
+	bool found = false;
+	BOOST_FOREACH(const std::string& ip, ips) {
+		const std::vector<wesnothd::player_map::const_iterator>& same_ip = by_ip[ip];
+		if (same_ip.size() < 2) continue;
+		found = true;
+		BOOST_FOREACH(const wesnothd::player_map::const_iterator& pl, same_ip) {
+			*out << std::endl << player_status(pl);
 		}
 	}
-	if (clones.empty()) {
+	if (!found) {
 		*out << "No clones found.";
 	}
 }
@@ -1769,7 +1900,7 @@ void server::ban_handler(const std::string& issuer_name, const std::string& /*qu
 			// simple username was used to prevent accidental bans.
 			// @todo FIXME: since we can have several entries now we should only ban the latest or so
 			/*if (utils::isvalid_username(target)) {
-				for (std::deque<connection_log>::const_iterator i = ip_log_.begin();
+				for (t_ip_log::const_iterator i = ip_log_.begin();
 						i != ip_log_.end(); ++i) {
 					if (i->nick == target) {
 						if (banned) out << "\n";
@@ -1852,7 +1983,7 @@ void server::kickban_handler(const std::string& issuer_name, const std::string&
 				// simple username was used to prevent accidental bans.
 				// @todo FIXME: since we can have several entries now we should only ban the latest or so
 				/*if (utils::isvalid_username(target)) {
-					for (std::deque<connection_log>::const_iterator i = ip_log_.begin();
+					for (t_ip_log::const_iterator i = ip_log_.begin();
 							i != ip_log_.end(); ++i) {
 						if (i->nick == target) {
 							if (banned) out << "\n";
@@ -1924,7 +2055,7 @@ void server::gban_handler(const std::string& issuer_name, const std::string& /*q
 					// simple username was used to prevent accidental bans.
 					// @todo FIXME: since we can have several entries now we should only ban the latest or so
 					/*if (utils::isvalid_username(target)) {
-						for (std::deque<connection_log>::const_iterator i = ip_log_.begin();
+						for (t_ip_log::const_iterator i = ip_log_.begin();
 								i != ip_log_.end(); ++i) {
 							if (i->nick == target) {
 								if (banned) out << "\n";
@@ -2023,19 +2154,30 @@ void server::searchlog_handler(const std::string& /*issuer_name*/, const std::st
 	// If this looks like an IP look up which nicks have been connected from it
 	// Otherwise look for the last IP the nick used to connect
 	const bool match_ip = (std::count(parameters.begin(), parameters.end(), '.') >= 1);
-	for (std::deque<connection_log>::const_iterator i = ip_log_.begin();
-			i != ip_log_.end(); ++i) {
+	// Without wildcards only the entries of that ip or nick can match.
+	std::vector<t_ip_log::iterator> matches;
+	if(parameters.find_first_of("*?") == std::string::npos) {
+		const t_ip_log_index& index = match_ip ? ip_log_by_ip_ : ip_log_by_nick_;
+		const t_ip_log_index::const_iterator entries = index.find(parameters);
+		if(entries != index.end()) {
+			matches = entries->second;
+		}
+	} else {
+		for(t_ip_log::iterator i = ip_log_.begin(); i != ip_log_.end(); ++i) {
+			if(utils::wildcard_string_match(match_ip ? i->ip : i->nick, parameters)) {
+				matches.push_back(i);
+			}
+		}
+	}
+	BOOST_FOREACH(const t_ip_log::iterator& i, matches) {
 		const std::string& username = i->nick;
 		const std::string& ip = i->ip;
-		if ((match_ip && utils::wildcard_string_match(ip, parameters))
-		|| (!match_ip && utils::wildcard_string_match(username, parameters))) {
-			found_something = true;
-			wesnothd::player_map::const_iterator pl = std::find_if(players_.begin(), players_.end(), boost::bind(&::match_user, _1, username, ip));
-			if (pl != players_.end()) {
-				*out << std::endl << player_status(pl);
-			} else {
-				*out << "\n'" << username << "' @ " << ip << " last seen: " << lg::get_timestamp(i->log_off, "%H:%M:%S %d.%m.%Y");
-			}
+		found_something = true;
+		wesnothd::player_map::const_iterator pl = std::find_if(players_.begin(), players_.end(), boost::bind(&::match_user, _1, username, ip));
+		if (pl != players_.end()) {
+			*out << std::endl << player_status(pl);
+		} else {
+			*out << "\n'" << username << "' @ " << ip << " last seen: " << lg::get_timestamp(i->log_off, "%H:%M:%S %d.%m.%Y");
 		}
 	}
 	if (!found_something) *out << "\nNo match found.";
@@ -2654,7 +2796,7 @@ void server::process_data_game(const network::connection sock,
 		if (user) {
 			rooms_.enter_lobby(user);
 			if (g.describe_slots()) {
-				update_game_in_lobby(g, user);
+				update_game_in_lobby(g);
 			}
 			// Send all other players in the lobby the update to the gamelist.
 			simple_wml::document diff;
@@ -2776,15 +2918,27 @@ void server::delete_game(t_games::iterator game_it) {
 
 	game_it->send_data(games_and_users_list_);
 
+	changed_games_.erase(&*game_it);
 	games_.erase(game_it);
 }
 
-void server::update_game_in_lobby(const wesnothd::game& g, network::connection exclude)
+void server::update_game_in_lobby(const wesnothd::game& g)
 {
-	simple_wml::document diff;
-	if (make_change_diff(*games_and_users_list_.child("gamelist"), "gamelist", "game", g.description(), diff)) {
-		rooms_.lobby().send_data(diff, exclude);
+	changed_games_.insert(&g);
+}
+
+void server::send_game_updates()
+{
+	// Each game gets its own document: the lobby of the client applies a
+	// diff with tracking, which keeps deleted games, so the indices of a
+	// second change in the same [gamelist_diff] would be off.
+	BOOST_FOREACH(const wesnothd::game* g, changed_games_) {
+		simple_wml::document diff;
+		if (make_change_diff(*games_and_users_list_.child("gamelist"), "gamelist", "game", g->description(), diff)) {
+			rooms_.lobby().send_data(diff);
+		}
 	}
+	changed_games_.clear();
 }
 
        #include <sys/types.h>
@@ -2802,6 +2956,9 @@ int main(int argc, char** argv) {
 	srand(static_cast<unsigned>(time(NULL)));
 
 	std::string config_file;
+	bool log_async = false;
+	std::string log_file;
+	size_t log_rotate_size = 0;
 
 	// setting path to currentworking directory
 	game_config::path = filesystem::get_cwd();
@@ -2820,6 +2977,15 @@ int main(int argc, char** argv) {
 			config_file = argv[++arg];
 		} else if (val == "--verbose" || val == "-v") {
 			lg::set_log_domain_severity("all", lg::debug);
+		} else if (val == "--log-async") {
+			log_async = true;
+		} else if (val == "--log-file" && arg+1 != argc) {
+			log_async = true;
+			log_file = argv[++arg];
+		} else if (val == "--log-rotate" && arg+1 != argc) {
+			log_rotate_size = static_cast<size_t>(atoi(argv[++arg])) * 1024 * 1024;
+		} else if (val == "--log-structured") {
+			lg::structured_output(true);
 		} else if (val.substr(0, 6) == "--log-") {
 			size_t p = val.find('=');
 			if (p == std::string::npos) {
@@ -2857,6 +3023,12 @@ int main(int argc, char** argv) {
 				<< "                             sets the severity level of the debug domains.\n"
 				<< "                             'all' can be used to match any debug domain.\n"
 				<< "                             Available levels: error, warning, info, debug.\n"
+				<< "  --log-async                Writes the log from a background thread, so that\n"
+				<< "                             logging never waits on the disk.\n"
+				<< "  --log-file <path>          Writes the log to the file from a background thread.\n"
+				<< "  --log-rotate <n>           Starts a new log file when it gets bigger than n MiB,\n"
+				<< "                             the previous one being kept as <path>.1.\n"
+				<< "  --log-structured           Writes the log lines as key=value fields.\n"
 				<< "  -p, --port <port>          Binds the server to the specified port.\n"
 				<< "  -t, --threads <n>          Uses n worker threads for network I/O (default: 5).\n"
 				<< "  -v  --verbose              Turns on more verbose logging.\n"
@@ -2898,6 +3070,10 @@ int main(int argc, char** argv) {
 		}
 	}
 
+	if (log_async && !lg::start_async_output(log_file, log_rotate_size)) {
+		std::cerr << "could not open the log file " << log_file << ", logging to the standard error\n";
+	}
+
 	network::set_raw_data_only();
 
 	try {
@@ -27,7 +27,12 @@
 
 #include "utils/boost_function_guarded.hpp"
 #include <boost/scoped_ptr.hpp>
+#include <boost/unordered_map.hpp>
 #include <boost/ptr_container/ptr_vector.hpp>
+
+#include <list>
+#include <vector>
+
 class server
 {
 public:
@@ -69,7 +74,20 @@ private:
 		}
 	};
 
-	std::deque<connection_log> ip_log_;
+	/**
+	 * The nick-ip pairs seen, oldest first, indexed by nick and by ip.
+	 * The indexes list the entries of each key in the order of the log.
+	 */
+	typedef std::list<connection_log> t_ip_log;
+	typedef boost::unordered_map<std::string, std::vector<t_ip_log::iterator> > t_ip_log_index;
+	t_ip_log ip_log_;
+	t_ip_log_index ip_log_by_nick_;
+	t_ip_log_index ip_log_by_ip_;
+
+	/** The entry for @a nick connecting from @a ip, or ip_log_.end(). */
+	t_ip_log::iterator find_connection_log(const std::string& nick, const std::string& ip);
+	/** Adds the pair to ip_log_ unless it is there, dropping the oldest entries beyond max_ip_log_size_. */
+	void log_connection(const std::string& nick, const std::string& ip);
 
 	struct login_log {
 		login_log(std::string _ip, int _attempts, time_t _first_attempt) :
@@ -85,7 +103,9 @@ private:
 		}
 	};
 
-	std::deque<login_log> failed_logins_;
+	/** The recent failed logins, least recently reset first, and their ips. */
+	std::list<login_log> failed_logins_;
+	boost::unordered_map<std::string, std::list<login_log>::iterator> failed_logins_by_ip_;
 
 	boost::scoped_ptr<user_handler> user_handler_;
 	std::map<network::connection,std::string> seeds_;
@@ -96,6 +116,8 @@ private:
 
 	typedef boost::ptr_vector<wesnothd::game> t_games;
 	t_games games_;
+	/** The games update_game_in_lobby() was called for. */
+	std::set<const wesnothd::game*> changed_games_;
 	std::set<network::connection> not_logged_in_;
 
 	wesnothd::room_manager rooms_;
@@ -131,10 +153,12 @@ private:
 	bool save_replays_;
 	std::string replay_save_path_;
 	bool allow_remote_shutdown_;
+	/** Where export_metrics() writes, empty if the metrics aren't exported. */
+	std::string metrics_path_;
 	std::vector<std::string> tor_ip_list_;
 	int failed_login_limit_;
 	time_t failed_login_ban_;
-	std::deque<login_log>::size_type failed_login_buffer_size_;
+	size_t failed_login_buffer_size_;
 
 	/** Parse the server config into local variables. */
 	void load_config();
@@ -156,6 +180,14 @@ private:
 	time_t last_uh_clean_;
 	void clean_user_handler(const time_t& now);
 
+	time_t last_metrics_;
+	/**
+	 * Writes the metrics and the current load of the server to metrics_path_,
+	 * in the Prometheus text format. The file is replaced at once, so that
+	 * a scraper never reads half of it.
+	 */
+	void export_metrics(const time_t& now);
+
 	void process_data(const network::connection sock,
 	                  simple_wml::document& data);
 	void process_login(const network::connection sock,
@@ -180,7 +212,16 @@ private:
 	                       simple_wml::document& data);
 	void delete_game(t_games::iterator game_it);
 
-	void update_game_in_lobby(const wesnothd::game& g, network::connection exclude=0);
+	/**
+	 * Marks the lobby entry of @a g as changed.
+	 *
+	 * The diff isn't sent right away: send_game_updates() sends one for each
+	 * changed game, however many times it changed since the previous call.
+	 */
+	void update_game_in_lobby(const wesnothd::game& g);
+
+	/** Sends the lobby the diffs of the games changed since the last call. */
+	void send_game_updates();
 
 	void start_new_server();
 
@@ -199,6 +240,7 @@ private:
 	void games_handler(const std::string &, const std::string &, std::string &, std::ostringstream *);
 	void wml_handler(const std::string &, const std::string &, std::string &, std::ostringstream *);
 	void netstats_handler(const std::string &, const std::string &, std::string &, std::ostringstream *);
+	void meminfo_handler(const std::string &, const std::string &, std::string &, std::ostringstream *);
 	void adminmsg_handler(const std::string &, const std::string &, std::string &, std::ostringstream *);
 	void pm_handler(const std::string &, const std::string &, std::string &, std::ostringstream *);
 	void msg_handler(const std::string &, const std::string &, std::string &, std::ostringstream *);
@@ -12,12 +12,14 @@
    See the COPYING file for more details.
 */
 
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 
 #include "global.hpp"
 
 #include <boost/iostreams/copy.hpp>
+#include <boost/iostreams/device/array.hpp>
 #include <boost/iostreams/filtering_stream.hpp>
 #include <boost/iostreams/filter/bzip2.hpp>
 #include <boost/iostreams/filter/counter.hpp>
@@ -43,54 +45,74 @@ char* uncompress_buffer(const string_span& input, string_span* span)
 	int nalloc = input.size();
 	int state = 0;
 	try {
-		std::istringstream stream(std::string(input.begin(), input.end()));
+		boost::iostreams::array_source source(input.begin(), input.size());
 		state = 1;
 		boost::iostreams::filtering_stream<boost::iostreams::input> filter;
 		state = 2;
-		if (!span->empty() && *span->begin() == 'B') {
+		// compress_buffer() output starts with 'B' for bzip2, 31 for gzip.
+		const bool bzip2 = !input.empty() && *input.begin() == 'B';
+		if (bzip2) {
 			filter.push(boost::iostreams::bzip2_decompressor());
 		} else {
 			filter.push(boost::iostreams::gzip_decompressor());
 		}
-		filter.push(stream);
+		filter.push(source);
 		state = 3;
 
-		const size_t chunk_size = input.size() * 10;
-		nalloc = chunk_size;
-		std::vector<char> buf(chunk_size);
+		// A gzip stream ends with the size of the data it holds, so most of
+		// the time it is inflated straight into a buffer of the right size.
+		// The size is only a hint, bounded by the best ratio deflate gets.
+		size_t size = input.size() * 10;
+		if (!bzip2 && input.size() >= 18) {
+			const unsigned char* isize = reinterpret_cast<const unsigned char*>(input.end()) - 4;
+			const size_t hint = isize[0] | (isize[1] << 8) | (isize[2] << 16) | (static_cast<size_t>(isize[3]) << 24);
+			size = std::min<size_t>(hint, input.size() * 1032);
+		}
+		if(size > 40000000) {
+			throw error("WML document exceeds 40MB limit");
+		}
+		nalloc = size + 1;
+		char* buf = new char[size + 1];
 		state = 4;
-		size_t len = 0;
 		size_t pos = 0;
-		while(filter.good() && (len = filter.read(&buf[pos], chunk_size).gcount()) == chunk_size) {
-			if(pos + chunk_size > 40000000) {
-				throw error("WML document exceeds 40MB limit");
+		try {
+			while((pos += filter.read(buf + pos, size - pos).gcount()) == size
+					&& filter.good() && filter.peek() != std::char_traits<char>::eof()) {
+				const size_t grown_size = std::max<size_t>(size * 2, 1024);
+				if(grown_size > 40000000) {
+					throw error("WML document exceeds 40MB limit");
+				}
+				nalloc = grown_size + 1;
+				char* grown = new char[grown_size + 1];
+				memcpy(grown, buf, pos);
+				delete [] buf;
+				buf = grown;
+				size = grown_size;
 			}
 
-			pos += len;
-			buf.resize(pos + chunk_size);
-			len = 0;
-		}
+			if(!filter.eof() && !filter.good()) {
+				throw error("failed to uncompress");
+			}
 
-		if(!filter.eof() && !filter.good()) {
-			throw error("failed to uncompress");
+			state = 5;
+			if(pos != size) {
+				nalloc = pos + 1;
+				char* small_out = new char[pos + 1];
+				memcpy(small_out, buf, pos);
+				delete [] buf;
+				buf = small_out;
+			}
+			state = 6;
+		} catch(...) {
+			delete [] buf;
+			throw;
 		}
 
-		pos += len;
-		state = 5;
-		nalloc = pos;
+		buf[pos] = 0;
 
-		buf.resize(pos);
-		state = 6;
-
-		char* small_out = new char[pos+1];
-		memcpy(small_out, &buf[0], pos);
+		*span = string_span(buf, pos);
 		state = 7;
-
-		small_out[pos] = 0;
-
-		*span = string_span(small_out, pos);
-		state = 8;
-		return small_out;
+		return buf;
 	} catch (std::bad_alloc& e) {
 		ERR_SWML << "ERROR: bad_alloc caught in uncompress_buffer() state "
 		<< state << " alloc bytes " << nalloc << " with input: '"
@@ -1178,6 +1200,22 @@ void document::detach_list()
 	next_ = prev_ = NULL;
 }
 
+size_t document::memory_usage() const
+{
+	size_t res = 0;
+	if(compressed_buf_.is_null() == false) {
+		res += compressed_buf_.size();
+	}
+	if(output_) {
+		res += strlen(output_);
+	}
+	if(root_) {
+		res += (1 + root_->nchildren())*(sizeof(node) + 12)
+			+ root_->nattributes_recursive()*(sizeof(string_span)*2);
+	}
+	return res;
+}
+
 std::string document::stats()
 {
 	std::ostringstream s;
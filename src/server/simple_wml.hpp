@@ -277,6 +277,9 @@ public:
 
 	static std::string stats();
 
+	/** The memory used by this document, estimated as in stats(). */
+	size_t memory_usage() const;
+
 private:
 	void generate_root();
 	document(const document&);
@@ -0,0 +1,90 @@
+/*
+   Copyright (C) 2015 by the Battle for Wesnoth Project
+   Part of the Battle for Wesnoth Project http://www.wesnoth.org/
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY.
+
+   See the COPYING file for more details.
+*/
+
+#ifndef SHARED_CONFIG_HPP_INCLUDED
+#define SHARED_CONFIG_HPP_INCLUDED
+
+#include "config.hpp"
+
+#include <boost/shared_ptr.hpp>
+
+/**
+ * A config shared by the copies of its holder until one of them changes it.
+ *
+ * Copying a shared_config only counts one more reference to the same config;
+ * the copy is made by the first mutable access of a holder whose config is
+ * shared, so that the holders never see the changes of each other. This is
+ * meant for the large configs, such as the scenarios and the snapshots,
+ * which are copied more often than they are changed.
+ *
+ * The references to the config given by get_mutable() are only valid until
+ * the holder is copied.
+ */
+class shared_config
+{
+public:
+	shared_config()
+		: cfg_()
+	{
+	}
+
+	/** Takes the content of @a cfg, which is left empty. */
+	explicit shared_config(config& cfg)
+		: cfg_()
+	{
+		take(cfg);
+	}
+
+	const config& get() const
+	{
+		static const config empty_cfg;
+		return cfg_ ? *cfg_ : empty_cfg;
+	}
+
+	/** The config, copied first if another holder shares it. */
+	config& get_mutable()
+	{
+		if(!cfg_) {
+			cfg_.reset(new config);
+		} else if(!cfg_.unique()) {
+			cfg_.reset(new config(*cfg_));
+		}
+		return *cfg_;
+	}
+
+	/** Replaces the config by the content of @a cfg, which is left empty. */
+	void take(config& cfg)
+	{
+		boost::shared_ptr<config> new_cfg(new config);
+		new_cfg->swap(cfg);
+		cfg_.swap(new_cfg);
+	}
+
+	void clear() { cfg_.reset(); }
+
+	bool empty() const { return !cfg_ || cfg_->empty(); }
+
+	/** Whether both holders currently share the same config. */
+	bool shares_with(const shared_config& other) const
+	{
+		return cfg_ && cfg_ == other.cfg_;
+	}
+
+	void swap(shared_config& other) { cfg_.swap(other.cfg_); }
+
+private:
+	boost::shared_ptr<config> cfg_;
+};
+
+#endif
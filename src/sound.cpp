@@ -21,14 +21,19 @@
 #include "serialization/string_utils.hpp"
 #include "sound.hpp"
 #include "sound_music_track.hpp"
+#include "thread.hpp"
 #include "util.hpp"
 
 #include "SDL_mixer.h"
 #include "SDL.h" // Travis doesn't like this, although it works on my machine -> '#include "SDL_sound.h"
 
 #include <boost/foreach.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
 
+#include <deque>
 #include <list>
+#include <set>
 #include <string>
 #include <sstream>
 
@@ -88,6 +93,13 @@ unsigned max_cached_chunks = 64;
 unsigned max_cached_chunks = 256;
 #endif
 
+// Max size of the decoded sound chunks that we want to cache
+#ifdef LOW_MEM
+const size_t max_cached_bytes = 16 * 1024 * 1024;
+#else
+const size_t max_cached_bytes = 64 * 1024 * 1024;
+#endif
+
 std::map< Mix_Chunk*, int > chunk_usage;
 
 }
@@ -171,6 +183,146 @@ sound::music_track current_track;
 sound::music_track last_track;
 unsigned int current_track_index = 0;
 
+/**
+ * Decodes sound files on a background thread, for prefetch_sound().
+ *
+ * As for the images, finding the files happens on the main thread, the
+ * worker only reads and decodes them. The decoded chunks wait here until
+ * load_chunk() takes them into the sound cache.
+ */
+class sound_loader : private boost::noncopyable
+{
+public:
+	sound_loader()
+		: mutex_(), work_(), done_(), queue_(), requested_(), loading_()
+		, loaded_(), stop_(false), worker_()
+	{
+		worker_.reset(new threading::thread(run, this));
+	}
+
+	~sound_loader()
+	{
+		{
+			const threading::lock lock(mutex_);
+			stop_ = true;
+			work_.notify_all();
+		}
+		// Joins the worker, once it has finished its current file.
+		worker_.reset();
+		BOOST_FOREACH(const loaded_map::value_type& chunk, loaded_) {
+			Mix_FreeChunk(chunk.second);
+		}
+	}
+
+	/** Queues the file @a location of @a file, unless it is already. */
+	void request(const std::string& file, const std::string& location)
+	{
+		const threading::lock lock(mutex_);
+		if(requested_.count(file) || loaded_.count(file)
+			|| requested_.size() + loaded_.size() >= max_prefetched) {
+			return;
+		}
+		queue_.push_back(std::make_pair(file, location));
+		requested_.insert(file);
+		work_.notify_one();
+	}
+
+	/**
+	 * Takes the chunk of @a file, waiting for it if the worker is loading
+	 * it. Returns NULL, and cancels the request if it wasn't started, when
+	 * the chunk isn't loaded: the caller loads it itself.
+	 */
+	Mix_Chunk* take(const std::string& file)
+	{
+		const threading::lock lock(mutex_);
+		while(!loading_.empty() && loading_ == file) {
+			done_.wait(mutex_);
+		}
+		const loaded_map::iterator i = loaded_.find(file);
+		if(i != loaded_.end()) {
+			Mix_Chunk* res = i->second;
+			loaded_.erase(i);
+			return res;
+		}
+		if(requested_.erase(file)) {
+			for(std::deque<request_type>::iterator r = queue_.begin(); r != queue_.end(); ++r) {
+				if(r->first == file) {
+					queue_.erase(r);
+					break;
+				}
+			}
+		}
+		return NULL;
+	}
+
+private:
+	/** The most sounds requested or loaded and not taken. */
+	static const size_t max_prefetched = 128;
+
+	/** The file, as played, and where it was found. */
+	typedef std::pair<std::string, std::string> request_type;
+	typedef std::map<std::string, Mix_Chunk*> loaded_map;
+
+	static int run(void* data)
+	{
+		sound_loader& self = *static_cast<sound_loader*>(data);
+		request_type req;
+		while(self.next(req)) {
+#ifndef SDL_MIXER_OLD_VERSION
+			// SDL takes ownership of the RWops.
+			Mix_Chunk* chunk = Mix_LoadWAV_RW(filesystem::load_RWops(req.second), true);
+#else
+			Mix_Chunk* chunk = Mix_LoadWAV(req.second.c_str());
+#endif
+			self.finish(req, chunk);
+		}
+		return 0;
+	}
+
+	/** Waits for a request to load, false when stopping. */
+	bool next(request_type& req)
+	{
+		const threading::lock lock(mutex_);
+		while(queue_.empty() && !stop_) {
+			work_.wait(mutex_);
+		}
+		if(stop_) {
+			return false;
+		}
+		req = queue_.front();
+		queue_.pop_front();
+		loading_ = req.first;
+		return true;
+	}
+
+	void finish(const request_type& req, Mix_Chunk* chunk)
+	{
+		const threading::lock lock(mutex_);
+		loading_.clear();
+		requested_.erase(req.first);
+		if(chunk) {
+			loaded_[req.first] = chunk;
+		}
+		done_.notify_all();
+	}
+
+	threading::mutex mutex_;
+	/** Signals requests to the worker, and its results to take(). */
+	threading::condition work_, done_;
+
+	std::deque<request_type> queue_;
+	/** The files queued or being loaded. */
+	std::set<std::string> requested_;
+	std::string loading_;
+	loaded_map loaded_;
+	bool stop_;
+
+	boost::scoped_ptr<threading::thread> worker_;
+};
+
+/** Started by the first prefetch_sound(), stopped by close_sound(). */
+boost::scoped_ptr<sound_loader> background_loader;
+
 }
 
 static bool track_ok(const std::string& id)
@@ -369,6 +521,7 @@ void close_sound() {
 		stop_bell();
 		stop_UI_sound();
 		stop_sound();
+		background_loader.reset();
 		sound_cache.clear();
 		stop_music();
 		mix_ok = false;
@@ -719,13 +872,45 @@ static Mix_Chunk* load_chunk(const std::string& file, channel_group group)
 		//splice the most recently used chunk to the front of the cache
 		sound_cache.splice(it_bgn, sound_cache, it);
 	} else {
-		// remove the least recently used chunk from cache if it's full
+		temp_chunk.group = group;
+		Mix_Chunk* prefetched = background_loader ? background_loader->take(file) : NULL;
+		if (prefetched) {
+			temp_chunk.set_data(prefetched);
+		} else {
+			std::string const &filename = filesystem::get_binary_file_location("sounds", file);
+
+			if (!filename.empty()) {
+#ifndef SDL_MIXER_OLD_VERSION
+				SDL_RWops *rwops = filesystem::load_RWops(filename);
+				temp_chunk.set_data(Mix_LoadWAV_RW(rwops, true)); // SDL takes ownership of rwops
+#else
+				temp_chunk.set_data(Mix_LoadWAV(filename.c_str()));
+#endif
+			} else {
+				ERR_AUDIO << "Could not load sound file '" << file << "'." << std::endl;
+				throw chunk_load_exception();
+			}
+
+			if (temp_chunk.get_data() == NULL) {
+				ERR_AUDIO << "Could not load sound file '" << filename << "': "
+					<< Mix_GetError() << "\n";
+				throw chunk_load_exception();
+			}
+		}
+
+		// remove the least recently used chunks from cache while it's full,
+		// by count or by size
+		size_t cached_bytes = temp_chunk.get_data()->alen;
+		BOOST_FOREACH(const sound_cache_chunk& chunk, sound_cache) {
+			cached_bytes += chunk.get_data()->alen;
+		}
 		bool cache_full = (sound_cache.size() == max_cached_chunks);
-		while( cache_full && it != it_bgn ) {
+		while( (cache_full || cached_bytes > max_cached_bytes) && it != sound_cache.begin() ) {
 			// make sure this chunk is not being played before freeing it
 			std::vector<Mix_Chunk*>::iterator ch_end = channel_chunks.end();
 			if(std::find(channel_chunks.begin(), ch_end, (--it)->get_data()) == ch_end) {
-				sound_cache.erase(it);
+				cached_bytes -= it->get_data()->alen;
+				it = sound_cache.erase(it);
 				cache_full = false;
 			}
 		}
@@ -733,26 +918,6 @@ static Mix_Chunk* load_chunk(const std::string& file, channel_group group)
 			LOG_AUDIO << "Maximum sound cache size reached and all are busy, skipping.\n";
 			throw chunk_load_exception();
 		}
-		temp_chunk.group = group;
-		std::string const &filename = filesystem::get_binary_file_location("sounds", file);
-
-		if (!filename.empty()) {
-#ifndef SDL_MIXER_OLD_VERSION
-			SDL_RWops *rwops = filesystem::load_RWops(filename);
-			temp_chunk.set_data(Mix_LoadWAV_RW(rwops, true)); // SDL takes ownership of rwops
-#else
-			temp_chunk.set_data(Mix_LoadWAV(filename.c_str()));
-#endif
-		} else {
-			ERR_AUDIO << "Could not load sound file '" << file << "'." << std::endl;
-			throw chunk_load_exception();
-		}
-
-		if (temp_chunk.get_data() == NULL) {
-			ERR_AUDIO << "Could not load sound file '" << filename << "': "
-				<< Mix_GetError() << "\n";
-			throw chunk_load_exception();
-		}
 
 		sound_cache.push_front(temp_chunk);
 	}
@@ -825,6 +990,34 @@ void play_sound_internal(const std::string& files, channel_group group, unsigned
 	channel_chunks[res] = chunk;
 }
 
+void prefetch_sound(const std::string& files)
+{
+	if(files.empty() || !mix_ok || !preferences::sound_on()) {
+		return;
+	}
+
+	std::vector<std::string> ids = utils::square_parenthetical_split(files,',',"[","]");
+#ifdef LOW_MEM
+	// Only the first one is played, see pick_one()
+	ids.resize(std::min<size_t>(ids.size(), 1));
+#endif
+
+	BOOST_FOREACH(const std::string& file, ids) {
+		sound_cache_chunk temp_chunk(file);
+		if(std::find(sound_cache.begin(), sound_cache.end(), temp_chunk) != sound_cache.end()) {
+			continue;
+		}
+		const std::string& filename = filesystem::get_binary_file_location("sounds", file);
+		if(filename.empty()) {
+			continue;
+		}
+		if(!background_loader) {
+			background_loader.reset(new sound_loader);
+		}
+		background_loader->request(file, filename);
+	}
+}
+
 void play_sound(const std::string& files, channel_group group, unsigned int repeats)
 {
 	if(preferences::sound_on()) {
@@ -66,6 +66,10 @@ bool is_sound_playing(int id);
 // Stop sound associated with a given id
 void stop_sound(int id);
 
+// Start loading the comma-separated sounds in the background, so that playing
+// them first doesn't wait for the disk.
+void prefetch_sound(const std::string& files);
+
 // Play sound, or random one of comma-separated sounds.
 void play_sound(const std::string& files, channel_group group = SOUND_FX, unsigned int repeats = 0);
 
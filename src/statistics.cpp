@@ -107,268 +107,9 @@ static stats &get_stats(const std::string &save_id)
 	return team_stats[save_id];
 }
 
-static config write_str_int_map(const stats::str_int_map& m)
-{
-	config res;
-	for(stats::str_int_map::const_iterator i = m.begin(); i != m.end(); ++i) {
-		res[i->first] = i->second;
-	}
-
-	return res;
-}
-
-static void write_str_int_map(config_writer &out, const stats::str_int_map& m)
-{
-	for(stats::str_int_map::const_iterator i = m.begin(); i != m.end(); ++i) {
-		out.write_key_val(i->first, i->second);
-	}
-}
-
-static stats::str_int_map read_str_int_map(const config& cfg)
-{
-	stats::str_int_map m;
-	BOOST_FOREACH(const config::attribute &i, cfg.attribute_range()) {
-		m[i.first] = i.second;
-	}
-
-	return m;
-}
-
-static config write_battle_result_map(const stats::battle_result_map& m)
-{
-	config res;
-	for(stats::battle_result_map::const_iterator i = m.begin(); i != m.end(); ++i) {
-		config& new_cfg = res.add_child("sequence");
-		new_cfg = write_str_int_map(i->second);
-		new_cfg["_num"] = i->first;
-	}
-
-	return res;
-}
-
-static void write_battle_result_map(config_writer &out, const stats::battle_result_map& m)
-{
-	for(stats::battle_result_map::const_iterator i = m.begin(); i != m.end(); ++i) {
-		out.open_child("sequence");
-		write_str_int_map(out, i->second);
-		out.write_key_val("_num", i->first);
-		out.close_child("sequence");
-	}
-}
-
-static stats::battle_result_map read_battle_result_map(const config& cfg)
-{
-	stats::battle_result_map m;
-	BOOST_FOREACH(const config &i, cfg.child_range("sequence"))
-	{
-		config item = i;
-		int key = item["_num"];
-		item.remove_attribute("_num");
-		m[key] = read_str_int_map(item);
-	}
-
-	return m;
-}
-
-static void merge_str_int_map(stats::str_int_map& a, const stats::str_int_map& b)
-{
-	for(stats::str_int_map::const_iterator i = b.begin(); i != b.end(); ++i) {
-		a[i->first] += i->second;
-	}
-}
-
-static void merge_battle_result_maps(stats::battle_result_map& a, const stats::battle_result_map& b)
-{
-	for(stats::battle_result_map::const_iterator i = b.begin(); i != b.end(); ++i) {
-		merge_str_int_map(a[i->first],i->second);
-	}
-}
-
-static void merge_stats(stats& a, const stats& b)
-{
-	DBG_NG << "Merging statistics\n";
-	merge_str_int_map(a.recruits,b.recruits);
-	merge_str_int_map(a.recalls,b.recalls);
-	merge_str_int_map(a.advanced_to,b.advanced_to);
-	merge_str_int_map(a.deaths,b.deaths);
-	merge_str_int_map(a.killed,b.killed);
-
-	merge_battle_result_maps(a.attacks,b.attacks);
-	merge_battle_result_maps(a.defends,b.defends);
-
-	a.recruit_cost += b.recruit_cost;
-	a.recall_cost += b.recall_cost;
-
-	a.damage_inflicted += b.damage_inflicted;
-	a.damage_taken += b.damage_taken;
-	a.expected_damage_inflicted += b.expected_damage_inflicted;
-	a.expected_damage_taken += b.expected_damage_taken;
-	// Only take the last value for this turn
-	a.turn_damage_inflicted = b.turn_damage_inflicted;
-	a.turn_damage_taken = b.turn_damage_taken;
-	a.turn_expected_damage_inflicted = b.turn_expected_damage_inflicted;
-	a.turn_expected_damage_taken = b.turn_expected_damage_taken;
-}
-
 namespace statistics
 {
 
-stats::stats() :
-	recruits(),
-	recalls(),
-	advanced_to(),
-	deaths(),
-	killed(),
-	recruit_cost(0),
-	recall_cost(0),
-	attacks(),
-	defends(),
-	damage_inflicted(0),
-	damage_taken(0),
-	turn_damage_inflicted(0),
-	turn_damage_taken(0),
-	expected_damage_inflicted(0),
-	expected_damage_taken(0),
-	turn_expected_damage_inflicted(0),
-	turn_expected_damage_taken(0),
-	save_id()
-{}
-
-stats::stats(const config& cfg) :
-	recruits(),
-	recalls(),
-	advanced_to(),
-	deaths(),
-	killed(),
-	recruit_cost(0),
-	recall_cost(0),
-	attacks(),
-	defends(),
-	damage_inflicted(0),
-	damage_taken(0),
-	turn_damage_inflicted(0),
-	turn_damage_taken(0),
-	expected_damage_inflicted(0),
-	expected_damage_taken(0),
-	turn_expected_damage_inflicted(0),
-	turn_expected_damage_taken(0),
-	save_id()
-{
-	read(cfg);
-}
-
-config stats::write() const
-{
-	config res;
-	res.add_child("recruits",write_str_int_map(recruits));
-	res.add_child("recalls",write_str_int_map(recalls));
-	res.add_child("advances",write_str_int_map(advanced_to));
-	res.add_child("deaths",write_str_int_map(deaths));
-	res.add_child("killed",write_str_int_map(killed));
-	res.add_child("attacks",write_battle_result_map(attacks));
-	res.add_child("defends",write_battle_result_map(defends));
-
-	res["recruit_cost"] = recruit_cost;
-	res["recall_cost"] = recall_cost;
-
-	res["damage_inflicted"] = damage_inflicted;
-	res["damage_taken"] = damage_taken;
-	res["expected_damage_inflicted"] = expected_damage_inflicted;
-	res["expected_damage_taken"] = expected_damage_taken;
-
-	res["turn_damage_inflicted"] = turn_damage_inflicted;
-	res["turn_damage_taken"] = turn_damage_taken;
-	res["turn_expected_damage_inflicted"] = turn_expected_damage_inflicted;
-	res["turn_expected_damage_taken"] = turn_expected_damage_taken;
-
-	res["save_id"] = save_id;
-
-	return res;
-}
-
-void stats::write(config_writer &out) const
-{
-	out.open_child("recruits");
-	write_str_int_map(out, recruits);
-	out.close_child("recruits");
-	out.open_child("recalls");
-	write_str_int_map(out, recalls);
-	out.close_child("recalls");
-	out.open_child("advances");
-	write_str_int_map(out, advanced_to);
-	out.close_child("advances");
-	out.open_child("deaths");
-	write_str_int_map(out, deaths);
-	out.close_child("deaths");
-	out.open_child("killed");
-	write_str_int_map(out, killed);
-	out.close_child("killed");
-	out.open_child("attacks");
-	write_battle_result_map(out, attacks);
-	out.close_child("attacks");
-	out.open_child("defends");
-	write_battle_result_map(out, defends);
-	out.close_child("defends");
-
-	out.write_key_val("recruit_cost", recruit_cost);
-	out.write_key_val("recall_cost", recall_cost);
-
-	out.write_key_val("damage_inflicted", damage_inflicted);
-	out.write_key_val("damage_taken", damage_taken);
-	out.write_key_val("expected_damage_inflicted", expected_damage_inflicted);
-	out.write_key_val("expected_damage_taken", expected_damage_taken);
-
-	out.write_key_val("turn_damage_inflicted", turn_damage_inflicted);
-	out.write_key_val("turn_damage_taken", turn_damage_taken);
-	out.write_key_val("turn_expected_damage_inflicted", turn_expected_damage_inflicted);
-	out.write_key_val("turn_expected_damage_taken", turn_expected_damage_taken);
-
-	out.write_key_val("save_id", save_id);
-}
-
-void stats::read(const config& cfg)
-{
-	if (const config &c = cfg.child("recruits")) {
-		recruits = read_str_int_map(c);
-	}
-	if (const config &c = cfg.child("recalls")) {
-		recalls = read_str_int_map(c);
-	}
-	if (const config &c = cfg.child("advances")) {
-		advanced_to = read_str_int_map(c);
-	}
-	if (const config &c = cfg.child("deaths")) {
-		deaths = read_str_int_map(c);
-	}
-	if (const config &c = cfg.child("killed")) {
-		killed = read_str_int_map(c);
-	}
-	if (const config &c = cfg.child("recalls")) {
-		recalls = read_str_int_map(c);
-	}
-	if (const config &c = cfg.child("attacks")) {
-		attacks = read_battle_result_map(c);
-	}
-	if (const config &c = cfg.child("defends")) {
-		defends = read_battle_result_map(c);
-	}
-
-	recruit_cost = cfg["recruit_cost"].to_int();
-	recall_cost = cfg["recall_cost"].to_int();
-
-	damage_inflicted = cfg["damage_inflicted"].to_long_long();
-	damage_taken = cfg["damage_taken"].to_long_long();
-	expected_damage_inflicted = cfg["expected_damage_inflicted"].to_long_long();
-	expected_damage_taken = cfg["expected_damage_taken"].to_long_long();
-
-	turn_damage_inflicted = cfg["turn_damage_inflicted"].to_long_long();
-	turn_damage_taken = cfg["turn_damage_taken"].to_long_long();
-	turn_expected_damage_inflicted = cfg["turn_expected_damage_inflicted"].to_long_long();
-	turn_expected_damage_taken = cfg["turn_expected_damage_taken"].to_long_long();
-
-	save_id = cfg["save_id"].str();
-}
-
 scenario_context::scenario_context(const std::string& name)
 {
 	if(!mid_scenario || master_stats.empty()) {
@@ -630,16 +371,6 @@ void clear_current_scenario()
 	}
 }
 
-int sum_str_int_map(const stats::str_int_map& m)
-{
-	int res = 0;
-	for(stats::str_int_map::const_iterator i = m.begin(); i != m.end(); ++i) {
-		res += i->second;
-	}
-
-	return res;
-}
-
 int sum_cost_str_int_map(const stats::str_int_map &m)
 {
 	int cost = 0;
@@ -64,6 +64,9 @@ namespace statistics
 		std::string save_id;
 	};
 
+	/** Adds @a b to @a a, the turn statistics being those of @a b. */
+	void merge_stats(stats& a, const stats& b);
+
 	int sum_str_int_map(const stats::str_int_map& m);
 	int sum_cost_str_int_map(const stats::str_int_map &m);
 
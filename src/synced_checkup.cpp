@@ -20,6 +20,12 @@
 #include "replay.hpp"
 #include "resources.hpp"
 #include "game_display.hpp"
+#include "team.hpp"
+
+#include <boost/foreach.hpp>
+
+#include <iomanip>
+#include <sstream>
 static lg::log_domain log_replay("replay");
 #define DBG_REPLAY LOG_STREAM(debug, log_replay)
 #define LOG_REPLAY LOG_STREAM(info, log_replay)
@@ -39,6 +45,11 @@ checkup::~checkup()
 
 }
 
+bool checkup::final_checkup(const config& expected_data, config& real_data)
+{
+	return local_checkup(expected_data, real_data);
+}
+
 ignored_checkup::ignored_checkup()
 {
 }
@@ -109,7 +120,96 @@ namespace
 	};
 }
 
+namespace
+{
+	/** A 64 bit FNV-1a hash. */
+	class state_hash
+	{
+	public:
+		state_hash(boost::uint64_t value = 14695981039346656037ULL) : value_(value)
+		{
+		}
+		void add(const std::string& str)
+		{
+			BOOST_FOREACH(char c, str) {
+				value_ = (value_ ^ static_cast<unsigned char>(c)) * 1099511628211ULL;
+			}
+			// Keeps "ab" "c" and "a" "bc" apart.
+			value_ = (value_ ^ 0xff) * 1099511628211ULL;
+		}
+		void add(long long n)
+		{
+			for(int i = 0; i != 8; ++i, n >>= 8) {
+				value_ = (value_ ^ static_cast<unsigned char>(n)) * 1099511628211ULL;
+			}
+		}
+		void add(const config& cfg)
+		{
+			BOOST_FOREACH(const config::attribute& a, cfg.attribute_range()) {
+				add(a.first);
+				add(a.second.str());
+			}
+			BOOST_FOREACH(const config::any_child& c, cfg.all_children_range()) {
+				add(c.key);
+				add(c.cfg);
+			}
+			add(cfg.all_children_count());
+		}
+		boost::uint64_t value() const
+		{
+			return value_;
+		}
+	private:
+		boost::uint64_t value_;
+	};
+
+	/**
+		A digest of the units, gold and villages; the units are summed, since the order of the unit map
+		may differ between clients.
+	*/
+	boost::uint64_t game_state_digest()
+	{
+		boost::uint64_t units = 0;
+		if(resources::units) {
+			BOOST_FOREACH(const unit& u, *resources::units) {
+				state_hash h;
+				h.add(u.id());
+				h.add(u.underlying_id());
+				h.add(u.side());
+				h.add(u.get_location().x);
+				h.add(u.get_location().y);
+				h.add(u.hitpoints());
+				h.add(u.experience());
+				h.add(u.movement_left());
+				h.add(u.attacks_left());
+				units += h.value();
+			}
+		}
+		state_hash res;
+		res.add(units);
+		if(resources::teams) {
+			BOOST_FOREACH(const team& t, *resources::teams) {
+				res.add(t.gold());
+				res.add(t.villages().size());
+				BOOST_FOREACH(const map_location& loc, t.villages()) {
+					res.add(loc.x);
+					res.add(loc.y);
+				}
+			}
+		}
+		return res.value();
+	}
+
+	std::string format_digest(boost::uint64_t digest)
+	{
+		std::ostringstream res;
+		res << std::hex << std::setw(16) << std::setfill('0') << digest;
+		return res.str();
+	}
+}
+
 mp_debug_checkup::mp_debug_checkup()
+	: records_(), digest_(state_hash().value())
 {
 }
 
@@ -120,6 +220,37 @@ mp_debug_checkup::~mp_debug_checkup()
 bool mp_debug_checkup::local_checkup(const config& expected_data, config& real_data)
 {
 	assert(real_data.empty());
-	real_data = get_user_choice("mp_checkup", checkup_choice(expected_data));
-	return real_data == expected_data;
+	records_.push_back(expected_data);
+	state_hash h(digest_);
+	h.add(expected_data);
+	digest_ = h.value();
+	// Compared by final_checkup().
+	real_data = expected_data;
+	return true;
+}
+
+bool mp_debug_checkup::final_checkup(const config& expected_data, config& real_data)
+{
+	assert(real_data.empty());
+	records_.push_back(expected_data);
+	state_hash h(digest_);
+	h.add(expected_data);
+	h.add(game_state_digest());
+
+	config local = expected_data;
+	local["digest"] = format_digest(h.value());
+	real_data = get_user_choice("mp_checkup", checkup_choice(local));
+	if(real_data == local) {
+		return true;
+	}
+	if(real_data["digest"] != local["digest"]) {
+		std::stringstream msg;
+		msg << "The digest of the results and of the game state is " << local["digest"]
+			<< " but was " << real_data["digest"] << " in the original game. The results were:\n";
+		BOOST_FOREACH(const config& record, records_) {
+			msg << record.debug();
+		}
+		ERR_REPLAY << msg.str() << std::flush;
+	}
+	return false;
 }
@@ -16,6 +16,11 @@
 #define SYNCED_CHECKUP_H_INCLUDED
 
 #include "config.hpp"
+
+#include <boost/cstdint.hpp>
+
+#include <vector>
+
 struct map_location;
 /**
 	A class to check whether the results that were calculated in the replay match the results calculated during the original game.
@@ -34,6 +39,10 @@ public:
 		returns whether the two config objects are equal.
 	*/
 	virtual bool local_checkup(const config& expected_data, config& real_data) = 0;
+	/**
+		Same as local_checkup(), for the last check of a synced command, after which the command changes nothing.
+	*/
+	virtual bool final_checkup(const config& expected_data, config& real_data);
 };
 
 /**
@@ -64,6 +73,10 @@ public:
 };
 /**
 	This checkup always compares the results in from different clients in a mp game but it also causes more network overhead.
+
+	Rather than sending each result, it keeps them and sends a digest of them and of the game state
+	(units, gold, villages) with the final checkup of the command; a mismatch is then found at the end
+	of the command, and the results kept are logged to tell what differed.
 */
 class mp_debug_checkup : public checkup
 {
@@ -71,6 +84,12 @@ public:
 	mp_debug_checkup();
 	virtual ~mp_debug_checkup();
 	virtual bool local_checkup(const config& expected_data, config& real_data);
+	virtual bool final_checkup(const config& expected_data, config& real_data);
+private:
+	/** The results of the command so far. */
+	std::vector<config> records_;
+	/** The digest of records_. */
+	boost::uint64_t digest_;
 };
 
 /*
@@ -424,7 +424,7 @@ void set_scontext_synced::do_final_checkup(bool dont_throw)
 	config cn = config_of
 		("random_calls", new_rng_->get_random_calls())
 		("next_unit_id", n_unit::id_manager::instance().get_save_id() + 1);
-	if(checkup_instance->local_checkup(cn, co))
+	if(checkup_instance->final_checkup(cn, co))
 	{
 		return;
 	}
@@ -441,6 +441,10 @@ void set_scontext_synced::do_final_checkup(bool dont_throw)
 	{
 		msg << "Our next unit id is " << cn["next_unit_id"].to_int() << " but during the original the next unit id was " << co["next_unit_id"].to_int() << std::endl;
 	}
+	if(msg.str().empty() && !co["digest"].empty())
+	{
+		msg << "The results of the command or the game state differ from the original game." << std::endl;
+	}
 	if(!msg.str().empty())
 	{
 		msg << co.debug() << std::endl;
@@ -25,6 +25,8 @@
 #include "game_events/pump.hpp"
 #include "game_data.hpp"
 #include "map.hpp"
+#include "pathfind/pathfind.hpp"
+#include "pathfind/teleport.hpp"
 #include "resources.hpp"
 #include "play_controller.hpp"
 #include "game_preferences.hpp"
@@ -358,6 +360,7 @@ void team::write(config& cfg) const
 bool team::get_village(const map_location& loc, const int owner_side, game_data * gamedata)
 {
 	villages_.insert(loc);
+	pathfind::tunnel_cache::invalidate();
 	bool gamestate_changed = false;
 	if(gamedata) {
 		config::attribute_value& var = gamedata->get_variable("owner_side");
@@ -382,6 +385,7 @@ void team::lose_village(const map_location& loc)
 	const std::set<map_location>::const_iterator vil = villages_.find(loc);
 	assert(vil != villages_.end());
 	villages_.erase(vil);
+	pathfind::tunnel_cache::invalidate();
 }
 
 void team::set_recruits(const std::set<std::string>& recruits)
@@ -522,6 +526,10 @@ void team::change_team(const std::string &name, const t_string &user_name)
 }
 
 void team::clear_caches(){
+	// Alliances may have changed.
+	pathfind::reach_cache::invalidate_all();
+	pathfind::adjacency_cache::invalidate_all();
+
 	// Reset the cache of allies for all teams
 	if(teams != NULL) {
 		for(std::vector<team>::const_iterator i = teams->begin(); i != teams->end(); ++i) {
@@ -617,7 +625,72 @@ bool team::copy_ally_shroud()
 	if(!teams || !share_maps())
 		return false;
 
-	return shroud_.copy_from(ally_shroud(*teams));
+	const bool cleared = shroud_.copy_from(ally_shroud(*teams));
+	if(cleared)
+		pathfind::reach_cache::invalidate_all();
+	return cleared;
+}
+
+bool team::clear_shroud(const map_location& loc)
+{
+	if(!shroud_.clear(loc.x+1,loc.y+1))
+		return false;
+	pathfind::reach_cache::invalidate(loc);
+	return true;
+}
+
+void team::place_shroud(const map_location& loc)
+{
+	shroud_.place(loc.x+1,loc.y+1);
+	pathfind::reach_cache::invalidate(loc);
+}
+
+bool team::clear_fog(const map_location& loc)
+{
+	if(!fog_.clear(loc.x+1,loc.y+1))
+		return false;
+	pathfind::reach_cache::invalidate(loc);
+	return true;
+}
+
+void team::reshroud()
+{
+	shroud_.reset();
+	pathfind::reach_cache::invalidate_all();
+}
+
+void team::refog()
+{
+	fog_.reset();
+	pathfind::reach_cache::invalidate_all();
+}
+
+void team::set_shroud(bool shroud)
+{
+	shroud_.set_enabled(shroud);
+	pathfind::reach_cache::invalidate_all();
+}
+
+void team::set_fog(bool fog)
+{
+	fog_.set_enabled(fog);
+	pathfind::reach_cache::invalidate_all();
+}
+
+void team::merge_shroud_map_data(const std::string& shroud_data)
+{
+	shroud_.merge(shroud_data);
+	pathfind::reach_cache::invalidate_all();
+}
+
+/**
+ * Records hexes that were cleared of fog via WML.
+ * @param[in] hexes	The hexes to keep clear.
+ */
+void team::add_fog_override(const std::set<map_location> &hexes)
+{
+	fog_clearer_.insert(hexes.begin(), hexes.end());
+	pathfind::reach_cache::invalidate_all();
 }
 
 /**
@@ -635,6 +708,7 @@ void team::remove_fog_override(const std::set<map_location> &hexes)
 	// Put the result into fog_clearer_.
 	fog_clearer_.clear();
 	fog_clearer_.insert(result.begin(), result_end);
+	pathfind::reach_cache::invalidate_all();
 }
 
 void validate_side(int side)
@@ -648,19 +722,47 @@ void validate_side(int side)
 	}
 }
 
+const int team::shroud_map::word_bits;
+
+void team::shroud_map::resize(int width, int height)
+{
+	width = std::max(width, width_);
+	height = std::max(height, height_);
+
+	const int row_words = (width + word_bits - 1) / word_bits;
+	if(row_words != row_words_) {
+		std::vector<word> data(height * row_words, 0);
+		for(int y = 0; y != height_; ++y) {
+			std::copy(data_.begin() + y * row_words_, data_.begin() + (y + 1) * row_words_,
+				data.begin() + y * row_words);
+		}
+		data_.swap(data);
+		row_words_ = row_words;
+	} else {
+		data_.resize(height * row_words_, 0);
+	}
+
+	width_ = width;
+	height_ = height;
+}
+
 bool team::shroud_map::clear(int x, int y)
 {
 	if(enabled_ == false || x < 0 || y < 0)
 		return false;
 
-	if(x >= static_cast<int>(data_.size()))
-		data_.resize(x+1);
+	return set_cleared(x, y);
+}
 
-	if(y >= static_cast<int>(data_[x].size()))
-		data_[x].resize(y+1);
+bool team::shroud_map::set_cleared(int x, int y)
+{
+	if(x >= width_ || y >= height_)
+		resize(x + 1, y + 1);
 
-	if(data_[x][y] == false) {
-		data_[x][y] = true;
+	word& w = data_[y * row_words_ + x / word_bits];
+	const word bit = word(1) << (x % word_bits);
+	if((w & bit) == 0) {
+		w |= bit;
 		return true;
 	} else {
 		return false;
@@ -672,14 +774,14 @@ void team::shroud_map::place(int x, int y)
 	if(enabled_ == false || x < 0 || y < 0)
 		return;
 
-	if (x >= static_cast<int>(data_.size())) {
+	if (x >= width_) {
 		DBG_NG << "Couldn't place shroud on invalid x coordinate: ("
-			<< x << ", " << y << ") - max x: " << data_.size() - 1 << "\n";
-	} else if (y >= static_cast<int>(data_[x].size())) {
+			<< x << ", " << y << ") - max x: " << width_ - 1 << "\n";
+	} else if (y >= height_) {
 		DBG_NG << "Couldn't place shroud on invalid y coordinate: ("
-			<< x << ", " << y << ") - max y: " << data_[x].size() - 1 << "\n";
+			<< x << ", " << y << ") - max y: " << height_ - 1 << "\n";
 	} else {
-		data_[x][y] = false;
+		data_[y * row_words_ + x / word_bits] &= ~(word(1) << (x % word_bits));
 	}
 }
 
@@ -688,9 +790,7 @@ void team::shroud_map::reset()
 	if(enabled_ == false)
 		return;
 
-	for(std::vector<std::vector<bool> >::iterator i = data_.begin(); i != data_.end(); ++i) {
-		std::fill(i->begin(),i->end(),false);
-	}
+	std::fill(data_.begin(), data_.end(), 0);
 }
 
 bool team::shroud_map::value(int x, int y) const
@@ -699,14 +799,14 @@ bool team::shroud_map::value(int x, int y) const
 		return false;
 
 	// Locations for which we have no data are assumed to still be covered.
-	if ( x < 0  ||  x >= static_cast<int>(data_.size()) )
+	if ( x < 0  ||  x >= width_ )
 		return true;
-	if ( y < 0  ||  y >= static_cast<int>(data_[x].size()) )
+	if ( y < 0  ||  y >= height_ )
 		return true;
 
 	// data_ stores whether or not a location has been cleared, while
 	// we want to return whether or not a location is covered.
-	return !data_[x][y];
+	return !cleared(x, y);
 }
 
 bool team::shroud_map::shared_value(const std::vector<const shroud_map*>& maps, int x, int y) const
@@ -729,11 +829,11 @@ bool team::shroud_map::shared_value(const std::vector<const shroud_map*>& maps,
 std::string team::shroud_map::write() const
 {
 	std::stringstream shroud_str;
-	for(std::vector<std::vector<bool> >::const_iterator sh = data_.begin(); sh != data_.end(); ++sh) {
+	for(int x = 0; x != width_; ++x) {
 		shroud_str << '|';
 
-		for(std::vector<bool>::const_iterator i = sh->begin(); i != sh->end(); ++i) {
-			shroud_str << (*i ? '1' : '0');
+		for(int y = 0; y != height_; ++y) {
+			shroud_str << (cleared(x, y) ? '1' : '0');
 		}
 
 		shroud_str << '\n';
@@ -745,15 +845,20 @@ std::string team::shroud_map::write() const
 void team::shroud_map::read(const std::string& str)
 {
 	data_.clear();
-	for(std::string::const_iterator sh = str.begin(); sh != str.end(); ++sh) {
-		if(*sh == '|')
-			data_.resize(data_.size()+1);
+	width_ = 0;
+	height_ = 0;
+	row_words_ = 0;
 
-		if(data_.empty() == false) {
+	int x=-1, y=0;
+	for(std::string::const_iterator sh = str.begin(); sh != str.end(); ++sh) {
+		if(*sh == '|') {
+			y=0;
+			x++;
+		} else if(x >= 0) {
 			if(*sh == '1')
-				data_.back().push_back(true);
+				set_cleared(x,y++);
 			else if(*sh == '0')
-				data_.back().push_back(false);
+				y++;
 		}
 	}
 }
@@ -781,15 +886,19 @@ bool team::shroud_map::copy_from(const std::vector<const shroud_map*>& maps)
 
 	bool cleared = false;
 	for(std::vector<const shroud_map*>::const_iterator i = maps.begin(); i != maps.end(); ++i) {
-		if((*i)->enabled_ == false)
+		const shroud_map& map = **i;
+		if(map.enabled_ == false || map.data_.empty())
 			continue;
 
-		const std::vector<std::vector<bool> >& v = (*i)->data_;
-		for(size_t x = 0; x != v.size(); ++x) {
-			for(size_t y = 0; y != v[x].size(); ++y) {
-				if(v[x][y]) {
-					cleared |= clear(x,y);
-				}
+		resize(map.width_, map.height_);
+
+		// The rows of the other map are at most as long as ours.
+		for(int y = 0; y != map.height_; ++y) {
+			const word* from = &map.data_[y * map.row_words_];
+			word* to = &data_[y * row_words_];
+			for(int w = 0; w != map.row_words_; ++w) {
+				cleared |= (from[w] & ~to[w]) != 0;
+				to[w] |= from[w];
 			}
 		}
 	}
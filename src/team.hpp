@@ -23,6 +23,7 @@
 #include "unit_ptr.hpp"
 #include "util.hpp"
 
+#include <boost/cstdint.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/container/flat_set.hpp>
 
@@ -77,7 +78,7 @@ public:
 private:
 	class shroud_map {
 	public:
-		shroud_map() : enabled_(false), data_() {}
+		shroud_map() : enabled_(false), data_(), width_(0), height_(0), row_words_(0) {}
 
 		void place(int x, int y);
 		bool clear(int x, int y);
@@ -95,8 +96,27 @@ private:
 		bool enabled() const { return enabled_; }
 		void set_enabled(bool enabled) { enabled_ = enabled; }
 	private:
+		typedef boost::uint64_t word;
+		static const int word_bits = 64;
+
+		/** Makes the data cover at least @a width x @a height hexes. */
+		void resize(int width, int height);
+
+		/** Clears the hex even if the map is disabled, returns whether it was covered. */
+		bool set_cleared(int x, int y);
+
+		bool cleared(int x, int y) const
+		{ return (data_[y * row_words_ + x / word_bits] >> (x % word_bits)) & 1; }
+
 		bool enabled_;
-		std::vector<std::vector<bool> > data_;
+		/**
+		 * Whether each hex has been cleared, one bit per hex, row by row.
+		 * The hexes outside the data are still covered.
+		 */
+		std::vector<word> data_;
+		int width_, height_;
+		/** The words holding a row in data_. */
+		int row_words_;
 	};
 
 	struct team_info
@@ -308,21 +328,23 @@ public:
 	bool uses_shroud() const { return shroud_.enabled(); }
 	bool uses_fog() const { return fog_.enabled(); }
 	bool fog_or_shroud() const { return uses_shroud() || uses_fog(); }
-	bool clear_shroud(const map_location& loc) { return shroud_.clear(loc.x+1,loc.y+1); }
-	void place_shroud(const map_location& loc) { shroud_.place(loc.x+1,loc.y+1); }
-	bool clear_fog(const map_location& loc) { return fog_.clear(loc.x+1,loc.y+1); }
-	void reshroud() { shroud_.reset(); }
-	void refog() { fog_.reset(); }
-	void set_shroud(bool shroud) { shroud_.set_enabled(shroud); }
-	void set_fog(bool fog) { fog_.set_enabled(fog); }
+	// The vision modifiers also invalidate the cached reach maps that
+	// depend on what this team sees.
+	bool clear_shroud(const map_location& loc);
+	void place_shroud(const map_location& loc);
+	bool clear_fog(const map_location& loc);
+	void reshroud();
+	void refog();
+	void set_shroud(bool shroud);
+	void set_fog(bool fog);
 
 	/** Merge a WML shroud map with the shroud data of this player. */
-	void merge_shroud_map_data(const std::string& shroud_data) { shroud_.merge(shroud_data); }
+	void merge_shroud_map_data(const std::string& shroud_data);
 
 	bool knows_about_team(size_t index, bool is_multiplayer) const;
 	bool copy_ally_shroud();
 	/// Records hexes that were cleared of fog via WML.
-	void add_fog_override(const std::set<map_location> &hexes) { fog_clearer_.insert(hexes.begin(), hexes.end()); }
+	void add_fog_override(const std::set<map_location> &hexes);
 	/// Removes the record of hexes that were cleared of fog via WML.
 	void remove_fog_override(const std::set<map_location> &hexes);
 
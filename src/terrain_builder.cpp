@@ -24,9 +24,13 @@
 #include "log.hpp"
 #include "map.hpp"
 #include "serialization/string_utils.hpp"
+#include "thread.hpp"
 
 #include <boost/foreach.hpp>
 
+#include <algorithm>
+#include <climits>
+
 static lg::log_domain log_engine("engine");
 #define ERR_NG LOG_STREAM(err, log_engine)
 #define WRN_NG LOG_STREAM(warn, log_engine)
@@ -104,13 +108,15 @@ terrain_builder::tile::tile() :
 	images_foreground(),
 	images_background(),
 	last_tod("invalid_tod"),
-	sorted_images(false)
+	sorted_images(false),
+	next_update(INT_MIN)
 {}
 
 void terrain_builder::tile::rebuild_cache(const std::string& tod, logs* log)
 {
 	images_background.clear();
 	images_foreground.clear();
+	next_update = INT_MIN;
 
 	if(!sorted_images){
 		//sort images by their layer (and basey)
@@ -166,6 +172,7 @@ void terrain_builder::tile::clear()
 	images_foreground.clear();
 	images_background.clear();
 	last_tod = "invalid_tod";
+	next_update = INT_MIN;
 }
 
 static unsigned int get_noise(const map_location& loc, unsigned int index){
@@ -220,9 +227,11 @@ terrain_builder::terrain_builder(const config& level,
 	tilewidth_(game_config::tile_size),
 	map_(m),
 	tile_map_(m ? map().w() : 0, m ? map().h() :0),
+	terrain_types_(),
+	terrain_indices_(),
 	terrain_by_type_()
 {
-	image::precache_file_existence("terrain/");
+	image::precache_file_existence();
 
 	if(building_rules_.empty() && rules_cfg_){
 		//off_map first to prevent some default rule seems to block it
@@ -305,16 +314,21 @@ bool terrain_builder::update_animation(const map_location &loc)
 	bool changed = false;
 
 	tile& btile = tile_map_[loc];
+	if(get_current_animation_tick() <= btile.next_update)
+		return false;
 
+	btile.next_update = INT_MAX;
 	BOOST_FOREACH(animated<image::locator>& a, btile.images_background) {
 		if(a.need_update())
 			changed = true;
 		a.update_last_draw_time();
+		btile.next_update = std::min(btile.next_update, a.get_next_update_tick());
 	}
 	BOOST_FOREACH(animated<image::locator>& a, btile.images_foreground) {
 		if(a.need_update())
 			changed = true;
 		a.update_last_draw_time();
+		btile.next_update = std::min(btile.next_update, a.get_next_update_tick());
 	}
 
 	return changed;
@@ -328,6 +342,7 @@ void terrain_builder::rebuild_terrain(const map_location &loc)
 		// btile.images.clear();
 		btile.images_foreground.clear();
 		btile.images_background.clear();
+		btile.next_update = INT_MIN;
 		const std::string filename =
 			map().get_terrain_info(loc).minimap_image();
 		animated<image::locator> img_loc;
@@ -967,8 +982,13 @@ void terrain_builder::add_off_map_rule(const std::string& image)
 	parse_global_config(cfg);
 }
 
-bool terrain_builder::rule_matches(const terrain_builder::building_rule &rule,
-		const map_location &loc, const terrain_constraint *type_checked) const
+unsigned terrain_builder::terrain_index(const map_location &loc) const
+{
+	return terrain_indices_[(loc.x + 2) + (loc.y + 2) * (map().w() + 4)];
+}
+
+bool terrain_builder::rule_matches_terrain(const terrain_builder::building_rule &rule,
+		const map_location &loc, const terrain_match_table &matches) const
 {
 	if(rule.location_constraints.valid() && rule.location_constraints != loc) {
 		return false;
@@ -981,23 +1001,28 @@ bool terrain_builder::rule_matches(const terrain_builder::building_rule &rule,
 		}
 	}
 
-	BOOST_FOREACH(const terrain_constraint &cons, rule.constraints)
-	{
+	for(size_t c = 0; c != rule.constraints.size(); ++c) {
 		// Translated location
-		const map_location tloc = legacy_sum(loc,cons.loc);
+		const map_location tloc = legacy_sum(loc,rule.constraints[c].loc);
 
 		if(!tile_map_.on_map(tloc)) {
 			return false;
 		}
 
-		//std::cout << "testing..." << builder_letter(map().get_terrain(tloc))
-
-		// check if terrain matches except if we already know that it does
-		if (&cons != type_checked && !terrain_matches(map().get_terrain(tloc), cons.terrain_types_match)) {
+		if(!matches[c][terrain_index(tloc)]) {
 			return false;
 		}
+	}
+
+	return true;
+}
 
-		const std::set<std::string> &flags = tile_map_[tloc].flags;
+bool terrain_builder::rule_matches_flags(const terrain_builder::building_rule &rule,
+		const map_location &loc) const
+{
+	BOOST_FOREACH(const terrain_constraint &cons, rule.constraints)
+	{
+		const std::set<std::string> &flags = tile_map_[legacy_sum(loc,cons.loc)].flags;
 
 		BOOST_FOREACH(const std::string &s, cons.no_flag) {
 			// If a flag listed in "no_flag" is present, the rule does not match
@@ -1073,77 +1098,160 @@ unsigned int terrain_builder::building_rule::get_hash() const
 	return hash_;
 }
 
+class terrain_builder::rule_matching_job : public threading::parallel_job
+{
+public:
+	rule_matching_job(const terrain_builder& builder,
+			const std::vector<const building_rule*>& rules,
+			std::vector<std::vector<map_location> >& candidates)
+		: builder_(builder)
+		, rules_(rules)
+		, candidates_(candidates)
+	{
+	}
+
+	void run(size_t index)
+	{
+		candidates_[index].clear();
+		builder_.find_rule_candidates(*rules_[index], candidates_[index]);
+	}
+
+private:
+	const terrain_builder& builder_;
+	const std::vector<const building_rule*>& rules_;
+	std::vector<std::vector<map_location> >& candidates_;
+};
+
+void terrain_builder::find_rule_candidates(const building_rule &rule,
+		std::vector<map_location> &candidates) const
+{
+	if(rule.constraints.empty()) {
+		return;
+	}
+
+	// Which of the terrains of the map each constraint accepts, so that
+	// checking the constraints at a location only takes lookups.
+	const size_t ntypes = terrain_types_.size();
+	terrain_match_table matches(rule.constraints.size(), std::vector<bool>(ntypes));
+
+	// Find the constraint that contains the less terrain of all terrain rules.
+	// We will keep a track of the matching terrains of this constraint
+	// and later try to apply the rule only on them
+	size_t min_size = INT_MAX;
+	size_t min_constraint = 0;
+
+	for(size_t c = 0; c != rule.constraints.size(); ++c) {
+		const t_translation::t_match& match = rule.constraints[c].terrain_types_match;
+		size_t constraint_size = 0;
+
+		for(size_t t = 0; t != ntypes; ++t) {
+			if(terrain_matches(terrain_types_[t], match)) {
+				matches[c][t] = true;
+				constraint_size += terrain_by_type_[t].size();
+			}
+		}
+
+		if(constraint_size < min_size) {
+			min_size = constraint_size;
+			min_constraint = c;
+		}
+	}
+
+	if(min_size == 0) {
+		// a constraint is never matched on this map
+		return;
+	}
+
+	const map_location& offset = rule.constraints[min_constraint].loc;
+	for(size_t t = 0; t != ntypes; ++t) {
+		if(!matches[min_constraint][t]) {
+			continue;
+		}
+
+		const std::vector<map_location>& locations = terrain_by_type_[t];
+		for(std::vector<map_location>::const_iterator itor = locations.begin();
+				itor != locations.end(); ++itor) {
+			const map_location loc = legacy_difference(*itor,offset);
+
+			if(rule_matches_terrain(rule, loc, matches)) {
+				candidates.push_back(loc);
+			}
+		}
+	}
+}
+
 void terrain_builder::build_terrains()
 {
 	log_scope("terrain_builder::build_terrains");
 
+	// Numbers the terrains of the tile map. Getting them also fills the
+	// border cache of the map for all the tiles, so that the concurrent
+	// matching below only reads it.
+	std::vector<t_translation::t_terrain> terrains;
+	std::map<t_translation::t_terrain, unsigned> indices;
+	for(int y = -2; y <= map().h() + 1; ++y) {
+		for(int x = -2; x <= map().w() + 1; ++x) {
+			terrains.push_back(map().get_terrain(map_location(x,y)));
+			indices.insert(std::make_pair(terrains.back(), 0));
+		}
+	}
+
+	// The indices follow the order of the terrain codes,
+	// so that the rules are tried on the locations in the same order.
+	terrain_types_.clear();
+	for(std::map<t_translation::t_terrain, unsigned>::iterator it = indices.begin();
+			it != indices.end(); ++it) {
+		it->second = terrain_types_.size();
+		terrain_types_.push_back(it->first);
+	}
+
+	terrain_indices_.resize(terrains.size());
+	for(size_t i = 0; i != terrains.size(); ++i) {
+		terrain_indices_[i] = indices[terrains[i]];
+	}
+
 	// Builds the terrain_by_type_ cache
+	terrain_by_type_.assign(terrain_types_.size(), std::vector<map_location>());
 	for(int x = -2; x <= map().w(); ++x) {
 		for(int y = -2; y <= map().h(); ++y) {
 			const map_location loc(x,y);
-			const t_translation::t_terrain t = map().get_terrain(loc);
-
-			terrain_by_type_[t].push_back(loc);
+			terrain_by_type_[terrain_index(loc)].push_back(loc);
 		}
 	}
 
-	BOOST_FOREACH(const building_rule &rule, building_rules_)
-	{
-		// Find the constraint that contains the less terrain of all terrain rules.
-		// We will keep a track of the matching terrains of this constraint
-		// and later try to apply the rule only on them
-		size_t min_size = INT_MAX;
-		t_translation::t_list min_types = t_translation::t_list(); // <-- This must be explicitly initialized, just as min_constraint is, at start of loop, or we get a null pointer dereference when we go through on later times.
-		const terrain_constraint *min_constraint = NULL;
-
-		BOOST_FOREACH(const terrain_constraint &constraint, rule.constraints)
-		{
-			const t_translation::t_match& match = constraint.terrain_types_match;
-			t_translation::t_list matching_types;
-			size_t constraint_size = 0;
-
-			for (terrain_by_type_map::iterator type_it = terrain_by_type_.begin();
-					 type_it != terrain_by_type_.end(); ++type_it) {
-
-				const t_translation::t_terrain t = type_it->first;
-				if (terrain_matches(t, match)) {
-					const size_t match_size = type_it->second.size();
-					constraint_size += match_size;
-					if (constraint_size >= min_size) {
-						break; // not a minimum, bail out
-					}
-					matching_types.push_back(t);
-				}
-			}
-
-			if (constraint_size < min_size) {
-				min_size = constraint_size;
-				min_types = matching_types;
-				min_constraint = &constraint;
-				if (min_size == 0) {
-				 	// a constraint is never matched on this map
-				 	// we break with a empty type list
-					break;
-				}
-			}
+	/*
+	 * Whether a rule matches depends on the flags set by the rules applied
+	 * before it, so the rules are applied one after the other in their
+	 * order. The terrain constraints only depend on the map though, so the
+	 * locations passing them are found for a batch of rules at once, and
+	 * only the flags remain to be checked when applying them. The result
+	 * is the same as matching the rules one by one.
+	 */
+	static const size_t batch_size = 256;
+	std::vector<const building_rule*> batch;
+	batch.reserve(batch_size);
+	std::vector<std::vector<map_location> > candidates(batch_size);
+	rule_matching_job job(*this, batch, candidates);
+
+	for(building_ruleset::const_iterator rule = building_rules_.begin();
+			rule != building_rules_.end(); ) {
+
+		batch.clear();
+		for(; rule != building_rules_.end() && batch.size() != batch_size; ++rule) {
+			// The hash is computed on first use, do it before sharing the rule.
+			rule->get_hash();
+			batch.push_back(&*rule);
 		}
 
-		//NOTE: if min_types is not empty, we have found a valid min_constraint;
-		for(t_translation::t_list::const_iterator t = min_types.begin();
-				t != min_types.end(); ++t) {
-
-			const std::vector<map_location>* locations = &terrain_by_type_[*t];
+		threading::run_parallel(job, batch.size());
 
-			for(std::vector<map_location>::const_iterator itor = locations->begin();
-					itor != locations->end(); ++itor) {
-				const map_location loc = legacy_difference(*itor,min_constraint->loc);
-
-				if(rule_matches(rule, loc, min_constraint)) {
-					apply_rule(rule, loc);
+		for(size_t i = 0; i != batch.size(); ++i) {
+			BOOST_FOREACH(const map_location& loc, candidates[i]) {
+				if(rule_matches_flags(*batch[i], loc)) {
+					apply_rule(*batch[i], loc);
 				}
 			}
 		}
-
 	}
 }
 
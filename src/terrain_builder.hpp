@@ -121,6 +121,8 @@ public:
 
 	/** Updates the animation at a given tile.
 	 * Returns true if something has changed, and must be redrawn.
+	 * The images of the tile are only updated once the next frame change
+	 * of one of them is due.
 	 *
 	 * @param loc   the location to update
 	 *
@@ -332,6 +334,12 @@ public:
 
 		/** Indicates if 'images' is sorted */
 		bool sorted_images;
+
+		/**
+		 * The animation tick until which none of the images of the tile
+		 * changes frame, update_animation() does nothing before it.
+		 */
+		int next_update;
 	};
 
 	tile* get_tile(const map_location &loc);
@@ -740,15 +748,39 @@ private:
 		{ return terrain.is_empty ? true : t_translation::terrain_matches(tcode, terrain); }
 
 	/**
-	 * Checks whether a rule matches a given location in the map.
+	 * For each constraint of a rule, whether it accepts each terrain of
+	 * terrain_types_.
+	 */
+	typedef std::vector<std::vector<bool> > terrain_match_table;
+
+	/**
+	 * Checks whether a rule matches a given location in the map, apart
+	 * from its has_flag and no_flag constraints.
+	 *
+	 * This only depends on the map, not on the rules applied before, so
+	 * it can be checked for all the rules concurrently.
 	 *
 	 * @param rule      The rule to check.
 	 * @param loc       The location in the map where we want to check
 	 *                  whether the rule matches.
-	 * @param type_checked The constraint which we already know that its
-	 *                  terrain types matches.
+	 * @param matches   The terrains accepted by the constraints of the rule.
+	 */
+	bool rule_matches_terrain(const building_rule &rule, const map_location &loc, const terrain_match_table &matches) const;
+
+	/**
+	 * Checks the has_flag and no_flag constraints of a rule at a location
+	 * where rule_matches_terrain() is true: the rule matches if both are.
 	 */
-	bool rule_matches(const building_rule &rule, const map_location &loc, const terrain_constraint *type_checked) const;
+	bool rule_matches_flags(const building_rule &rule, const map_location &loc) const;
+
+	/**
+	 * Finds the locations where rule_matches_terrain() is true for @a rule,
+	 * using terrain_by_type_ to only test the likely ones.
+	 */
+	void find_rule_candidates(const building_rule &rule, std::vector<map_location> &candidates) const;
+
+	/** Runs find_rule_candidates() for several rules at once. */
+	class rule_matching_job;
 
 	/**
 	 * Applies a rule at a given location: applies the result of a
@@ -778,15 +810,20 @@ private:
 	 */
 	tilemap tile_map_;
 
-	/**
-	 * Shorthand typedef for a map associating a list of locations to a terrain type.
-	 */
-	typedef std::map<t_translation::t_terrain, std::vector<map_location> > terrain_by_type_map;
+	/** The terrains of the tile map, numbered in the order of their codes. */
+	std::vector<t_translation::t_terrain> terrain_types_;
+
+	/** The index in terrain_types_ of the terrain of each tile. */
+	std::vector<unsigned> terrain_indices_;
+
+	/** The index in terrain_types_ of the terrain at @a loc, on the tile map. */
+	unsigned terrain_index(const map_location &loc) const;
 
 	/**
-	 * A map representing all locations whose terrain is of a given type.
+	 * All the locations whose terrain is of a given type, by index in
+	 * terrain_types_.
 	 */
-	terrain_by_type_map terrain_by_type_;
+	std::vector<std::vector<map_location> > terrain_by_type_;
 
 	/** Parsed terrain rules. Cached between instances */
 	static building_ruleset building_rules_;
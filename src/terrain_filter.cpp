@@ -33,6 +33,8 @@
 
 #include <boost/foreach.hpp>
 
+#include <algorithm>
+
 static lg::log_domain log_engine("engine");
 #define ERR_NG LOG_STREAM(err, log_engine)
 #define WRN_NG LOG_STREAM(warn, log_engine)
@@ -334,8 +336,11 @@ bool terrain_filter::match(const map_location& loc) const
 	if(cfg_["x"] == "recall" && cfg_["y"] == "recall") {
 		return !fc_->get_disp_context().map().on_board(loc);
 	}
-	std::set<map_location> hexes;
-	std::vector<map_location> loc_vec(1, loc);
+	// The hexes to try, in increasing order; just loc without a radius,
+	// which is most of the time, so that case does not allocate.
+	std::vector<map_location> hexes;
+	const map_location* first = &loc;
+	const map_location* last = &loc + 1;
 
 	//handle radius
 	size_t radius = cfg_["radius"].to_size_t(0);
@@ -344,18 +349,33 @@ bool terrain_filter::match(const map_location& loc) const
 		<< ", restricting\n";
 		radius = max_loop_;
 	}
-	if ( radius == 0 )
-		hexes.insert(loc_vec.begin(), loc_vec.end());
-	else if ( cfg_.has_child("filter_radius") ) {
-		terrain_filter r_filter(cfg_.child("filter_radius"), *this);
-		get_tiles_radius(fc_->get_disp_context().map(), loc_vec, radius, hexes, false, r_filter);
-	} else {
-		get_tiles_radius(fc_->get_disp_context().map(), loc_vec, radius, hexes);
+	if ( radius != 0 ) {
+		if ( cfg_.has_child("filter_radius") ) {
+			terrain_filter r_filter(cfg_.child("filter_radius"), *this);
+			std::set<map_location> in_radius;
+			get_tiles_radius(fc_->get_disp_context().map(), std::vector<map_location>(1, loc),
+				radius, in_radius, false, r_filter);
+			hexes.assign(in_radius.begin(), in_radius.end());
+		} else {
+			// loc itself, and the hexes of the board around it.
+			const gamemap& map = fc_->get_disp_context().map();
+			std::vector<map_location> around;
+			get_tiles_in_radius(loc, radius, around);
+			hexes.reserve(around.size() + 1);
+			hexes.push_back(loc);
+			BOOST_FOREACH(const map_location& hex, around) {
+				if ( map.on_board(hex) )
+					hexes.push_back(hex);
+			}
+			std::sort(hexes.begin(), hexes.end());
+		}
+		// (There is always loc at least.)
+		first = &hexes.front();
+		last = first + hexes.size();
 	}
 
 	size_t loop_count = 0;
-	std::set<map_location>::const_iterator i;
-	for(i = hexes.begin(); i != hexes.end(); ++i) {
+	for(const map_location* i = first; i != last; ++i) {
 		bool matches = match_internal(*i, false);
 
 		//handle [and], [or], and [not] with in-order precedence
@@ -387,8 +407,7 @@ bool terrain_filter::match(const map_location& loc) const
 			return true;
 		}
 		if(++loop_count > max_loop_) {
-			std::set<map_location>::const_iterator temp = i;
-			if(++temp != hexes.end()) {
+			if(i + 1 != last) {
 				ERR_NG << "terrain_filter: loop count greater than " << max_loop_
 				<< ", aborting\n";
 				break;
@@ -410,13 +429,24 @@ void terrain_filter::get_locations(std::set<map_location>& locs, bool with_borde
 			&& !cfg_.has_attribute("find_in")
 			&& !cfg_.has_attribute("area") ) {
 
-		//consider all locations on the map
-		int bs = fc_->get_disp_context().map().border_size();
-		int w = with_border ? fc_->get_disp_context().map().w() + bs : fc_->get_disp_context().map().w();
-		int h = with_border ? fc_->get_disp_context().map().h() + bs : fc_->get_disp_context().map().h();
-		for (int x = with_border ? 0 - bs : 0; x < w; ++x) {
-			for (int y = with_border ? 0 - bs : 0; y < h; ++y) {
-				match_set.insert(map_location(x,y));
+		if (cfg_.has_child("filter")) {
+			// Only the hexes holding a unit can match.
+			const gamemap& map = fc_->get_disp_context().map();
+			BOOST_FOREACH(const unit& u, fc_->get_disp_context().units()) {
+				const map_location& loc = u.get_location();
+				if (with_border ? map.on_board_with_border(loc) : map.on_board(loc)) {
+					match_set.insert(loc);
+				}
+			}
+		} else {
+			//consider all locations on the map
+			int bs = fc_->get_disp_context().map().border_size();
+			int w = with_border ? fc_->get_disp_context().map().w() + bs : fc_->get_disp_context().map().w();
+			int h = with_border ? fc_->get_disp_context().map().h() + bs : fc_->get_disp_context().map().h();
+			for (int x = with_border ? 0 - bs : 0; x < w; ++x) {
+				for (int y = with_border ? 0 - bs : 0; y < h; ++y) {
+					match_set.insert(map_location(x,y));
+				}
 			}
 		}
 	} else
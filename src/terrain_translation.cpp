@@ -27,6 +27,8 @@
 #include "util.hpp"
 #include "wml_exception.hpp"
 
+#include <boost/unordered_map.hpp>
+
 
 #define ERR_G LOG_STREAM(err, lg::general)
 #define WRN_G LOG_STREAM(warn, lg::general)
@@ -283,17 +285,34 @@ t_map read_game_map(const std::string& str,	std::map<int, coordinate>& starting_
 		return result;
 	}
 
+	// A map uses few different codes, so each one is only converted once;
+	// the chunks with a starting position are always converted.
+	boost::unordered_map<std::string, t_terrain> converted;
+	std::string terrain;
+
 	while(offset < str.length()) {
 
 		// Get a terrain chunk
-		const std::string separators = ",\n\r";
-		const size_t pos_separator = str.find_first_of(separators, offset);
-		const std::string terrain = str.substr(offset, pos_separator - offset);
+		const size_t pos_separator = str.find_first_of(",\n\r", offset);
+		terrain.assign(str, offset, pos_separator == std::string::npos ?
+			std::string::npos : pos_separator - offset);
 
 		// Process the chunk
 		int starting_position = -1;
-		// The gamemap never has a wildcard
-		const t_terrain tile = string_to_number_(terrain, starting_position, NO_LAYER);
+		t_terrain tile;
+		if(terrain.find(' ') != std::string::npos) {
+			// The gamemap never has a wildcard
+			tile = string_to_number_(terrain, starting_position, NO_LAYER);
+		} else {
+			const boost::unordered_map<std::string, t_terrain>::const_iterator known =
+				converted.find(terrain);
+			if(known != converted.end()) {
+				tile = known->second;
+			} else {
+				tile = string_to_number_(terrain, starting_position, NO_LAYER);
+				converted.insert(std::make_pair(terrain, tile));
+			}
+		}
 
 		// Add to the resulting starting position
 		if(starting_position != -1) {
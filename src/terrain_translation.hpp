@@ -18,6 +18,7 @@
 #define TERRAIN_TRANSLATION_H_INCLUDED
 
 #include <SDL_types.h> //used for Uint32 definition
+#include <cstddef>
 #include <vector>
 #include <map>
 
@@ -68,6 +69,10 @@ namespace t_translation {
 	inline t_terrain operator|(const t_terrain& a, const t_terrain& b)
 		{ return t_terrain(a.base | b.base, a.overlay | b.overlay); }
 
+	/** For the hashed containers keyed by terrain. */
+	inline std::size_t hash_value(const t_terrain& a)
+		{ return static_cast<std::size_t>(a.base) * 31 ^ a.overlay; }
+
 	// operator<< is defined later
 
 	typedef std::vector<t_terrain> t_list;
@@ -28,24 +28,29 @@ terrain_type_data::terrain_type_data(const config & game_config)
 {
 }
 
-const t_translation::t_list & terrain_type_data::list() const
+void terrain_type_data::initialize() const
 {
-	if (!initialized_) {
-		create_terrain_maps(game_config_.child_range("terrain_type"), terrainList_, tcodeToTerrain_);
-		initialized_ = true;
+	if (initialized_) {
+		return;
+	}
+	create_terrain_maps(game_config_.child_range("terrain_type"), terrainList_, tcodeToTerrain_);
+	for (std::map<t_translation::t_terrain, terrain_type>::const_iterator i = tcodeToTerrain_.begin();
+			i != tcodeToTerrain_.end(); ++i) {
+		terrainIndex_[i->first] = &i->second;
 	}
+	initialized_ = true;
+}
 
+const t_translation::t_list & terrain_type_data::list() const
+{
+	initialize();
 	return terrainList_;
 }
 
 
 const std::map<t_translation::t_terrain, terrain_type> & terrain_type_data::map() const
 {
-	if (!initialized_) {
-		create_terrain_maps(game_config_.child_range("terrain_type"), terrainList_, tcodeToTerrain_);
-		initialized_ = true;
-	}
-
+	initialize();
 	return tcodeToTerrain_;
 }
 
@@ -53,54 +58,46 @@ const std::map<t_translation::t_terrain, terrain_type> & terrain_type_data::map(
 const terrain_type& terrain_type_data::get_terrain_info(const t_translation::t_terrain & terrain) const
 {
 	static const terrain_type default_terrain;
-	const std::map<t_translation::t_terrain,terrain_type>::const_iterator i =
-		tcodeToTerrain_.find(terrain);
-
-	if(i != tcodeToTerrain_.end())
-		return i->second;
-	else
-		return default_terrain;
+	const terrain_type * type = find(terrain);
+	return type ? *type : default_terrain;
 }
 
 const t_translation::t_list& terrain_type_data::underlying_mvt_terrain(const t_translation::t_terrain & terrain) const
 {
-	const std::map<t_translation::t_terrain,terrain_type>::const_iterator i =
-		tcodeToTerrain_.find(terrain);
+	const terrain_type * type = find(terrain);
 
-	if(i == tcodeToTerrain_.end()) {
+	if(!type) {
 		static t_translation::t_list result(1);
 		result[0] = terrain;
 		return result;
 	} else {
-		return i->second.mvt_type();
+		return type->mvt_type();
 	}
 }
 
 const t_translation::t_list& terrain_type_data::underlying_def_terrain(const t_translation::t_terrain & terrain) const
 {
-	const std::map<t_translation::t_terrain, terrain_type>::const_iterator i =
-		tcodeToTerrain_.find(terrain);
+	const terrain_type * type = find(terrain);
 
-	if(i == tcodeToTerrain_.end()) {
+	if(!type) {
 		static t_translation::t_list result(1);
 		result[0] = terrain;
 		return result;
 	} else {
-		return i->second.def_type();
+		return type->def_type();
 	}
 }
 
 const t_translation::t_list& terrain_type_data::underlying_union_terrain(const t_translation::t_terrain & terrain) const
 {
-	const std::map<t_translation::t_terrain,terrain_type>::const_iterator i =
-		tcodeToTerrain_.find(terrain);
+	const terrain_type * type = find(terrain);
 
-	if(i == tcodeToTerrain_.end()) {
+	if(!type) {
 		static t_translation::t_list result(1);
 		result[0] = terrain;
 		return result;
 	} else {
-		return i->second.union_type();
+		return type->union_type();
 	}
 }
 
@@ -167,8 +164,10 @@ bool terrain_type_data::try_merge_terrains(const t_translation::t_terrain & terr
 
 		terrain_type new_terrain(base_iter->second, overlay_iter->second);
 		terrainList_.push_back(new_terrain.number());
-		tcodeToTerrain_.insert(std::pair<t_translation::t_terrain, terrain_type>(
-								   new_terrain.number(), new_terrain));
+		const std::map<t_translation::t_terrain, terrain_type>::iterator inserted =
+			tcodeToTerrain_.insert(std::pair<t_translation::t_terrain, terrain_type>(
+								   new_terrain.number(), new_terrain)).first;
+		terrainIndex_[inserted->first] = &inserted->second;
 		return true;
 	}
 	return true; // Terrain already exists, nothing to do
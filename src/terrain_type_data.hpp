@@ -18,12 +18,26 @@
 #include "terrain.hpp"
 
 #include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
 #include <map>
 
 class terrain_type_data {
 private:
 	mutable t_translation::t_list terrainList_;
 	mutable std::map<t_translation::t_terrain, terrain_type> tcodeToTerrain_;
+	/// Hashes the terrains of tcodeToTerrain_, for the lookups of the game
+	/// logic (the costs, defense and village, castle and healing flags).
+	mutable boost::unordered_map<t_translation::t_terrain, const terrain_type *> terrainIndex_;
+
+	/// The terrain_type of @a terrain, or NULL if it is not known.
+	const terrain_type * find(const t_translation::t_terrain & terrain) const
+	{
+		const boost::unordered_map<t_translation::t_terrain, const terrain_type *>::const_iterator i =
+			terrainIndex_.find(terrain);
+		return i == terrainIndex_.end() ? NULL : i->second;
+	}
+	/// Creates the terrain types on first use.
+	void initialize() const;
 
 	mutable bool initialized_;
 	const config & game_config_;
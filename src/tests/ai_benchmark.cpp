@@ -0,0 +1,366 @@
+/*
+   Copyright (C) 2015 by the Battle for Wesnoth Project
+   Part of the Battle for Wesnoth Project http://www.wesnoth.org/
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY.
+
+   See the COPYING file for more details.
+*/
+
+/**
+ * @file
+ * Plays AI against AI games on mainline maps for a fixed number of turns and
+ * with fixed seeds, and writes as CSV, for every turn, the time the AI took,
+ * its path searches and fights, and the heap allocations made meanwhile.
+ *
+ * Run it from the data directory's parent, like the unit tests:
+ *   ./ai_benchmark [--output results.csv] [--map file.map]... [--seed N]...
+ *                  [--turns N] [--checksum HEX]...
+ *
+ * Each game, one per map and seed, ends with a line giving the checksum of
+ * its replay on the standard error. When --checksum is given, once per game
+ * and in the same order, the program fails if a replay differs: the AI did
+ * not play the same game as before.
+ */
+
+#define GETTEXT_DOMAIN "wesnoth-test"
+
+#include "SDL.h"
+
+#include "ai/profiler.hpp"
+#include "config.hpp"
+#include "events.hpp"
+#include "filesystem.hpp"
+#include "game_config.hpp"
+#include "gui/widgets/helper.hpp"
+#include "log.hpp"
+#include "replay_recorder_base.hpp"
+#include "resources.hpp"
+#include "saved_game.hpp"
+#include "serialization/parser.hpp"
+#include "tod_manager.hpp"
+
+#include "tests/utils/fake_display.hpp"
+#include "tests/utils/game_config_manager.hpp"
+#include "tests/utils/play_scenario.hpp"
+
+#include <boost/cstdint.hpp>
+#include <boost/detail/atomic_count.hpp>
+#include <boost/foreach.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <sstream>
+
+namespace {
+
+/** The heap allocations of the whole program, counted by the operator new below. */
+boost::detail::atomic_count allocations(0);
+
+}
+
+void* operator new(std::size_t size) throw(std::bad_alloc)
+{
+	++allocations;
+	void* p = std::malloc(size != 0 ? size : 1);
+	if (!p) {
+		throw std::bad_alloc();
+	}
+	return p;
+}
+
+void operator delete(void* p) throw()
+{
+	std::free(p);
+}
+
+namespace {
+
+/** The mainline maps used when none are given on the command line. */
+const char* const default_maps[] = {
+	"data/multiplayer/maps/2p_The_Freelands.map",
+	"data/multiplayer/maps/2p_Den_of_Onis.map",
+};
+
+const int default_seeds[] = { 1, 2 };
+
+/** The leader and recruits of each side, from the default era. */
+const char* const factions[][2] = {
+	{ "Lieutenant", "Spearman,Bowman,Cavalryman,Mage,Heavy Infantryman,Fencer,Horseman,Merman Fighter" },
+	{ "Orcish Warrior", "Orcish Grunt,Troll Whelp,Wolf Rider,Orcish Archer,Orcish Assassin,Naga Fighter,Goblin Spearman" },
+};
+
+/**
+ * A scenario on @a map_data where the AI plays both sides, ending without
+ * any dialog after @a turns turns however the fight goes.
+ */
+config ai_scenario(const std::string& map_data, int turns)
+{
+	config scenario;
+	scenario["id"] = "ai_benchmark";
+	scenario["name"] = "AI benchmark";
+	scenario["map_data"] = map_data;
+	scenario["turns"] = turns;
+	scenario["random_start_time"] = false;
+	scenario["victory_when_enemies_defeated"] = false;
+
+	int side = 0;
+	BOOST_FOREACH(const char* const* faction, factions) {
+		config& side_cfg = scenario.add_child("side");
+		side_cfg["side"] = ++side;
+		side_cfg["controller"] = "ai";
+		side_cfg["canrecruit"] = true;
+		side_cfg["type"] = faction[0];
+		side_cfg["recruit"] = faction[1];
+		side_cfg["gold"] = 100;
+		side_cfg["fog"] = false;
+		side_cfg["shroud"] = false;
+	}
+
+	config& time_over = scenario.add_child("event");
+	time_over["name"] = "time over";
+	config& endlevel = time_over.add_child("endlevel");
+	endlevel["result"] = "victory";
+	endlevel["carryover_report"] = false;
+	endlevel["linger_mode"] = false;
+	endlevel["replay_save"] = false;
+	endlevel["save"] = false;
+	return scenario;
+}
+
+/** What the AI turns of all sides did so far, from ai::profiler. */
+struct ai_totals
+{
+	ai_totals()
+		: seconds(0)
+		, route_searches(0)
+		, astar_searches(0)
+		, fights(0)
+		, simulated_fights(0)
+	{
+	}
+
+	static ai_totals current()
+	{
+		ai_totals res;
+		const config profile = ai::profiler::to_config();
+		BOOST_FOREACH(const config& side, profile.child("ai_profile").child_range("side")) {
+			if (const config& turn = side.child("turn")) {
+				res.seconds += turn["seconds"].to_double();
+				res.route_searches += turn["route_searches"].to_int();
+				res.astar_searches += turn["astar_searches"].to_int();
+				res.fights += turn["fights"].to_int();
+				res.simulated_fights += turn["simulated_fights"].to_int();
+			}
+		}
+		return res;
+	}
+
+	double seconds;
+	int route_searches, astar_searches, fights, simulated_fights;
+};
+
+class reporter
+{
+public:
+	explicit reporter(std::ostream& out) : out_(out)
+	{
+		out_ << "map,seed,turn,ai_ms,route_searches,astar_searches,fights,"
+		        "simulated_fights,allocations\n";
+	}
+
+	void report(const std::string& map_name, int seed, int turn,
+	            const ai_totals& start, const ai_totals& end, long nb_allocations)
+	{
+		out_ << map_name << ',' << seed << ',' << turn << ','
+		     << (end.seconds - start.seconds) * 1000.0 << ','
+		     << end.route_searches - start.route_searches << ','
+		     << end.astar_searches - start.astar_searches << ','
+		     << end.fights - start.fights << ','
+		     << end.simulated_fights - start.simulated_fights << ','
+		     << nb_allocations << '\n';
+		out_.flush();
+	}
+
+private:
+	std::ostream& out_;
+};
+
+/**
+ * Reports a line for each turn of the game being played, noticing the new
+ * turns when the events are pumped, as they are between the sides.
+ */
+class turn_sampler : public events::pump_monitor
+{
+public:
+	turn_sampler(const std::string& map_name, int seed, int nb_turns, reporter& report)
+		: map_name_(map_name)
+		, seed_(seed)
+		, nb_turns_(nb_turns)
+		, report_(report)
+		, turn_(0)
+		, start_()
+		, start_allocations_(0)
+	{
+	}
+
+	virtual void process(events::pump_info& /*info*/)
+	{
+		if (!resources::tod_manager || resources::tod_manager->turn() == turn_) {
+			return;
+		}
+		finish();
+		turn_ = resources::tod_manager->turn();
+		start_ = ai_totals::current();
+		start_allocations_ = allocations;
+	}
+
+	/** Reports the turn in progress, if any; the one the time over event starts is not. */
+	void finish()
+	{
+		if (turn_ > 0 && turn_ <= nb_turns_) {
+			report_.report(map_name_, seed_, turn_, start_, ai_totals::current(),
+				allocations - start_allocations_);
+		}
+		turn_ = 0;
+	}
+
+private:
+	const std::string map_name_;
+	const int seed_;
+	const int nb_turns_;
+	reporter& report_;
+	int turn_;
+	ai_totals start_;
+	long start_allocations_;
+};
+
+/** A 32-bit FNV-1a hash of the replay, as eight hexadecimal digits. */
+std::string replay_checksum(const saved_game& state)
+{
+	config replay;
+	state.get_replay().write(replay);
+	std::ostringstream text;
+	write(text, replay);
+	const std::string& str = text.str();
+
+	boost::uint32_t hash = 2166136261u;
+	BOOST_FOREACH(char c, str) {
+		hash = (hash ^ static_cast<unsigned char>(c)) * 16777619u;
+	}
+	char res[9];
+	std::sprintf(res, "%08x", static_cast<unsigned>(hash));
+	return res;
+}
+
+/** Plays one game, @return the checksum of its replay. */
+std::string play_one_game(const std::string& map_name, const std::string& map_data,
+		int seed, int nb_turns, reporter& report)
+{
+	ai::profiler::reset();
+	test_utils::play_ai_scenario game(ai_scenario(map_data, nb_turns));
+	turn_sampler sampler(map_name, seed, nb_turns, report);
+	game.play(seed);
+	sampler.finish();
+	return replay_checksum(game.get_state());
+}
+
+} // end anonymous namespace
+
+int main(int argc, char** argv)
+{
+	std::string output;
+	std::vector<std::string> maps;
+	std::vector<int> seeds;
+	std::vector<std::string> checksums;
+	int nb_turns = 10;
+
+	for (int i = 1; i < argc; ++i) {
+		const std::string arg = argv[i];
+		if (i + 1 >= argc) {
+			std::cerr << "Missing value for " << arg << "\n";
+			return 1;
+		}
+		const std::string value = argv[++i];
+		try {
+			if (arg == "--output") {
+				output = value;
+			} else if (arg == "--map") {
+				maps.push_back(value);
+			} else if (arg == "--seed") {
+				seeds.push_back(boost::lexical_cast<int>(value));
+			} else if (arg == "--turns") {
+				nb_turns = boost::lexical_cast<int>(value);
+			} else if (arg == "--checksum") {
+				checksums.push_back(value);
+			} else {
+				std::cerr << "Unknown option " << arg << "\n";
+				return 1;
+			}
+		} catch (boost::bad_lexical_cast&) {
+			std::cerr << "Invalid value for " << arg << ": " << value << "\n";
+			return 1;
+		}
+	}
+	if (maps.empty()) {
+		maps.assign(default_maps, default_maps + sizeof(default_maps) / sizeof(*default_maps));
+	}
+	if (seeds.empty()) {
+		seeds.assign(default_seeds, default_seeds + sizeof(default_seeds) / sizeof(*default_seeds));
+	}
+
+	// Same initialization as the unit tests.
+	game_config::path = filesystem::get_cwd();
+	SDL_Init(SDL_INIT_TIMER);
+	test_utils::get_fake_display(1024, 768);
+	gui2::init();
+	lg::set_log_domain_severity("engine", lg::err);
+	lg::set_log_domain_severity("ai", lg::err);
+	ai::profiler::set_enabled(true);
+
+	std::ofstream file;
+	if (!output.empty()) {
+		file.open(output.c_str());
+		if (!file) {
+			std::cerr << "Cannot write to " << output << "\n";
+			return 1;
+		}
+	}
+	reporter report(output.empty() ? std::cout : file);
+
+	size_t game = 0;
+	int res = 0;
+	BOOST_FOREACH(const std::string& map_file, maps) {
+		if (!filesystem::file_exists(map_file)) {
+			std::cerr << "Skipping missing map " << map_file << "\n";
+			continue;
+		}
+		const std::string map_name = filesystem::base_name(map_file);
+		const std::string map_data = filesystem::read_file(map_file);
+		BOOST_FOREACH(int seed, seeds) {
+			const std::string checksum = play_one_game(map_name, map_data, seed, nb_turns, report);
+			std::cerr << map_name << " seed " << seed << ": checksum " << checksum;
+			if (game < checksums.size() && checksums[game] != checksum) {
+				std::cerr << ", expected " << checksums[game];
+				res = 1;
+			}
+			std::cerr << "\n";
+			++game;
+		}
+	}
+	if (game < checksums.size()) {
+		std::cerr << checksums.size() << " checksums given for " << game << " games\n";
+		res = 1;
+	}
+
+	return res;
+}
@@ -0,0 +1,533 @@
+/*
+   Copyright (C) 2015 by the Battle for Wesnoth Project
+   Part of the Battle for Wesnoth Project http://www.wesnoth.org/
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY.
+
+   See the COPYING file for more details.
+*/
+
+/**
+ * @file
+ * Times the copies, merges, appends, child iterations, attribute lookups,
+ * reading and writing of configs, and the same queries on frozen_config, on
+ * the preprocessed game config and on saves, and writes the results as CSV.
+ *
+ * Run it from the data directory's parent, like the unit tests:
+ *   ./config_benchmark [--output results.csv] [--config path]...
+ *                      [--define SYMBOL]... [--save file]... [--rounds N]
+ *
+ * The configs are data/ unless --config or --save is given, preprocessed
+ * with MULTIPLAYER unless --define is given. Each time is the best of the
+ * rounds, and the throughput is in megabytes of WML text per second.
+ */
+
+#include "config.hpp"
+#include "config_cache.hpp"
+#include "filesystem.hpp"
+#include "frozen_config.hpp"
+#include "game_config.hpp"
+#include "log.hpp"
+#include "serialization/binary_or_text.hpp"
+#include "serialization/compression.hpp"
+#include "serialization/parser.hpp"
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/foreach.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace {
+
+/** Receives the results of the operations, so that none is optimized away. */
+size_t sink = 0;
+
+const char* const missing_key = "config_benchmark_missing_key";
+
+boost::posix_time::ptime now()
+{
+	return boost::posix_time::microsec_clock::universal_time();
+}
+
+/** An operation to time on a config. */
+class operation
+{
+public:
+	explicit operation(const char* name) : name_(name) {}
+	virtual ~operation() {}
+
+	const char* name() const { return name_; }
+
+	/** Called before each round, untimed. */
+	virtual void prepare() {}
+	virtual void run() = 0;
+
+private:
+	const char* name_;
+};
+
+/** The children tags and the attribute keys of each node of a config. */
+struct config_nodes
+{
+	std::vector<std::pair<const config*, std::string> > tags;
+	std::vector<std::pair<const config*, std::string> > keys;
+	std::vector<const config*> nodes;
+
+	explicit config_nodes(const config& cfg) : tags(), keys(), nodes() { add(cfg); }
+
+	void add(const config& cfg)
+	{
+		nodes.push_back(&cfg);
+		BOOST_FOREACH(const config::attribute& a, cfg.attribute_range()) {
+			keys.push_back(std::make_pair(&cfg, a.first));
+		}
+		std::string previous;
+		BOOST_FOREACH(const config::any_child& c, cfg.all_children_range()) {
+			// Children with the same tag are usually grouped.
+			if (c.key != previous) {
+				tags.push_back(std::make_pair(&cfg, c.key));
+				previous = c.key;
+			}
+			add(c.cfg);
+		}
+	}
+};
+
+/** The same for a frozen_config. */
+struct frozen_nodes
+{
+	std::vector<std::pair<frozen_config::node, std::string> > tags;
+	std::vector<std::pair<frozen_config::node, std::string> > keys;
+
+	explicit frozen_nodes(const frozen_config::node& cfg) : tags(), keys() { add(cfg); }
+
+	void add(const frozen_config::node& cfg)
+	{
+		BOOST_FOREACH(const frozen_config::attribute& a, cfg.attribute_range()) {
+			keys.push_back(std::make_pair(cfg, a.first));
+		}
+		std::string previous;
+		BOOST_FOREACH(const frozen_config::any_child& c, cfg.all_children_range()) {
+			if (c.key != previous) {
+				tags.push_back(std::make_pair(cfg, c.key));
+				previous = c.key;
+			}
+			add(c.cfg);
+		}
+	}
+};
+
+class copy_operation : public operation
+{
+public:
+	explicit copy_operation(const config& cfg) : operation("copy"), cfg_(cfg) {}
+	virtual void run()
+	{
+		const config copy(cfg_);
+		sink += copy.all_children_count();
+	}
+private:
+	const config& cfg_;
+};
+
+/** Merges or appends a config to a fresh copy of itself. */
+class combine_operation : public operation
+{
+public:
+	combine_operation(const config& cfg, bool append)
+		: operation(append ? "append" : "merge_with"), cfg_(cfg), target_(), append_(append)
+	{
+	}
+	virtual void prepare() { target_ = cfg_; }
+	virtual void run()
+	{
+		if (append_) {
+			target_.append(cfg_);
+		} else {
+			target_.merge_with(cfg_);
+		}
+		sink += target_.all_children_count();
+	}
+private:
+	const config& cfg_;
+	config target_;
+	bool append_;
+};
+
+/** Goes through the whole tree, with all_children_range(). */
+class walk_operation : public operation
+{
+public:
+	explicit walk_operation(const config& cfg) : operation("all_children_range"), cfg_(cfg) {}
+	virtual void run() { walk(cfg_); }
+private:
+	static void walk(const config& cfg)
+	{
+		BOOST_FOREACH(const config::any_child& c, cfg.all_children_range()) {
+			++sink;
+			walk(c.cfg);
+		}
+	}
+	const config& cfg_;
+};
+
+/** Goes through the children of each node, with child_range() for each tag. */
+class child_range_operation : public operation
+{
+public:
+	explicit child_range_operation(const config_nodes& nodes) : operation("child_range"), nodes_(nodes) {}
+	virtual void run()
+	{
+		typedef std::pair<const config*, std::string> tag;
+		BOOST_FOREACH(const tag& t, nodes_.tags) {
+			BOOST_FOREACH(const config& c, t.first->child_range(t.second)) {
+				sink += c.attribute_count();
+			}
+		}
+	}
+private:
+	const config_nodes& nodes_;
+};
+
+/** Looks up each attribute of each node. */
+class lookup_operation : public operation
+{
+public:
+	explicit lookup_operation(const config_nodes& nodes) : operation("operator[]"), nodes_(nodes) {}
+	virtual void run()
+	{
+		typedef std::pair<const config*, std::string> key;
+		BOOST_FOREACH(const key& k, nodes_.keys) {
+			sink += (*k.first)[k.second].blank();
+		}
+	}
+private:
+	const config_nodes& nodes_;
+};
+
+/** Looks up an attribute no node has, in each node. */
+class missing_lookup_operation : public operation
+{
+public:
+	explicit missing_lookup_operation(const config_nodes& nodes)
+		: operation("operator[]_missing"), nodes_(nodes), key_(missing_key)
+	{
+	}
+	virtual void run()
+	{
+		BOOST_FOREACH(const config* cfg, nodes_.nodes) {
+			sink += (*cfg)[key_].blank();
+		}
+	}
+private:
+	const config_nodes& nodes_;
+	const std::string key_;
+};
+
+class write_operation : public operation
+{
+public:
+	explicit write_operation(const config& cfg) : operation("write"), cfg_(cfg) {}
+	virtual void run()
+	{
+		std::ostringstream out;
+		write(out, cfg_);
+		sink += out.str().size();
+	}
+private:
+	const config& cfg_;
+};
+
+class config_writer_operation : public operation
+{
+public:
+	config_writer_operation(const config& cfg, compression::format format)
+		: operation(format == compression::GZIP ? "config_writer_gz" :
+		            format == compression::BZIP2 ? "config_writer_bz2" : "config_writer")
+		, cfg_(cfg)
+		, format_(format)
+	{
+	}
+	virtual void run()
+	{
+		std::ostringstream out;
+		{
+			config_writer writer(out, format_);
+			writer.write(cfg_);
+		}
+		sink += out.str().size();
+	}
+private:
+	const config& cfg_;
+	compression::format format_;
+};
+
+class read_operation : public operation
+{
+public:
+	explicit read_operation(const std::string& text) : operation("read"), text_(text) {}
+	virtual void run()
+	{
+		config cfg;
+		read(cfg, text_);
+		sink += cfg.all_children_count();
+	}
+private:
+	const std::string& text_;
+};
+
+class freeze_operation : public operation
+{
+public:
+	explicit freeze_operation(const config& cfg) : operation("frozen_build"), cfg_(cfg) {}
+	virtual void run()
+	{
+		const frozen_config frozen(cfg_);
+		sink += frozen.root().all_children_count();
+	}
+private:
+	const config& cfg_;
+};
+
+class frozen_child_range_operation : public operation
+{
+public:
+	explicit frozen_child_range_operation(const frozen_nodes& nodes)
+		: operation("frozen_child_range"), nodes_(nodes)
+	{
+	}
+	virtual void run()
+	{
+		typedef std::pair<frozen_config::node, std::string> tag;
+		BOOST_FOREACH(const tag& t, nodes_.tags) {
+			BOOST_FOREACH(const frozen_config::node& c, t.first.child_range(t.second)) {
+				sink += c.all_children_count();
+			}
+		}
+	}
+private:
+	const frozen_nodes& nodes_;
+};
+
+class frozen_lookup_operation : public operation
+{
+public:
+	explicit frozen_lookup_operation(const frozen_nodes& nodes)
+		: operation("frozen_operator[]"), nodes_(nodes)
+	{
+	}
+	virtual void run()
+	{
+		typedef std::pair<frozen_config::node, std::string> key;
+		BOOST_FOREACH(const key& k, nodes_.keys) {
+			sink += k.first[k.second].blank();
+		}
+	}
+private:
+	const frozen_nodes& nodes_;
+};
+
+/** Times operations and writes the results as CSV lines. */
+class reporter
+{
+public:
+	reporter(std::ostream& out, int rounds)
+		: out_(out), rounds_(rounds), name_(), configs_(0), attributes_(0), bytes_(0)
+	{
+		out_ << "input,operation,configs,attributes,bytes,best_ms,mb_per_s\n";
+	}
+
+	/** Sets the input the following operations are timed on. */
+	void set_input(const std::string& name, const config_nodes& nodes, size_t bytes)
+	{
+		name_ = name;
+		configs_ = nodes.nodes.size();
+		attributes_ = nodes.keys.size();
+		bytes_ = bytes;
+	}
+
+	void time(operation& op)
+	{
+		double best = 0;
+		for (int round = 0; round != rounds_; ++round) {
+			op.prepare();
+			const boost::posix_time::ptime start = now();
+			op.run();
+			const double elapsed = (now() - start).total_microseconds() / 1000.0;
+			if (round == 0 || elapsed < best) {
+				best = elapsed;
+			}
+		}
+		out_ << name_ << ',' << op.name() << ',' << configs_ << ',' << attributes_ << ','
+		     << bytes_ << ',' << best << ',' << (best > 0 ? bytes_ / best / 1000.0 : 0.0) << '\n';
+		out_.flush();
+	}
+
+private:
+	std::ostream& out_;
+	int rounds_;
+	std::string name_;
+	size_t configs_, attributes_, bytes_;
+};
+
+void benchmark(const std::string& name, const config& cfg, reporter& report)
+{
+	const config_nodes nodes(cfg);
+	std::ostringstream text;
+	write(text, cfg);
+	report.set_input(name, nodes, text.str().size());
+
+	copy_operation copy(cfg);
+	report.time(copy);
+	combine_operation merge(cfg, false);
+	report.time(merge);
+	combine_operation append(cfg, true);
+	report.time(append);
+	walk_operation walk(cfg);
+	report.time(walk);
+	child_range_operation children(nodes);
+	report.time(children);
+	lookup_operation lookup(nodes);
+	report.time(lookup);
+	missing_lookup_operation missing(nodes);
+	report.time(missing);
+	write_operation writing(cfg);
+	report.time(writing);
+	config_writer_operation writer(cfg, compression::NONE);
+	report.time(writer);
+	config_writer_operation writer_gz(cfg, compression::GZIP);
+	report.time(writer_gz);
+	read_operation reading(text.str());
+	report.time(reading);
+
+	freeze_operation freeze(cfg);
+	report.time(freeze);
+	const frozen_config frozen(cfg);
+	const frozen_nodes frozen_tree(frozen.root());
+	frozen_child_range_operation frozen_children(frozen_tree);
+	report.time(frozen_children);
+	frozen_lookup_operation frozen_lookup(frozen_tree);
+	report.time(frozen_lookup);
+}
+
+/** Reads a save, compressed or not. */
+bool read_save(const std::string& path, config& cfg)
+{
+	filesystem::scoped_istream in = filesystem::istream_file(path);
+	if (!in->good()) {
+		std::cerr << "Cannot read " << path << "\n";
+		return false;
+	}
+	try {
+		switch (compression::detect_format(*in)) {
+		case compression::GZIP:
+			read_gz(cfg, *in);
+			break;
+		case compression::BZIP2:
+			read_bz2(cfg, *in);
+			break;
+		case compression::NONE:
+			read(cfg, *in);
+			break;
+		}
+	} catch (config::error& e) {
+		std::cerr << "Cannot read " << path << ": " << e.message << "\n";
+		return false;
+	}
+	return true;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+	std::string output;
+	std::vector<std::string> paths;
+	std::vector<std::string> defines;
+	std::vector<std::string> saves;
+	int rounds = 5;
+
+	for (int i = 1; i < argc; ++i) {
+		const std::string arg = argv[i];
+		if (i + 1 >= argc) {
+			std::cerr << "Missing value for " << arg << "\n";
+			return 1;
+		}
+		const std::string value = argv[++i];
+		try {
+			if (arg == "--output") {
+				output = value;
+			} else if (arg == "--config") {
+				paths.push_back(value);
+			} else if (arg == "--define") {
+				defines.push_back(value);
+			} else if (arg == "--save") {
+				saves.push_back(value);
+			} else if (arg == "--rounds") {
+				rounds = boost::lexical_cast<int>(value);
+			} else {
+				std::cerr << "Unknown option " << arg << "\n";
+				return 1;
+			}
+		} catch (boost::bad_lexical_cast&) {
+			std::cerr << "Invalid value for " << arg << ": " << value << "\n";
+			return 1;
+		}
+	}
+	if (paths.empty() && saves.empty()) {
+		paths.push_back("data/");
+	}
+	if (defines.empty()) {
+		defines.push_back("MULTIPLAYER");
+	}
+	if (rounds < 1) {
+		std::cerr << "Invalid value for --rounds: " << rounds << "\n";
+		return 1;
+	}
+
+	std::ofstream file;
+	if (!output.empty()) {
+		file.open(output.c_str());
+		if (!file) {
+			std::cerr << "Cannot write to " << output << "\n";
+			return 1;
+		}
+	}
+	reporter report(output.empty() ? std::cout : file, rounds);
+
+	game_config::path = filesystem::get_cwd();
+	lg::set_log_domain_severity("config", lg::err);
+
+	game_config::config_cache& cache = game_config::config_cache::instance();
+	cache.clear_defines();
+	BOOST_FOREACH(const std::string& define, defines) {
+		cache.add_define(define);
+	}
+	BOOST_FOREACH(const std::string& path, paths) {
+		config cfg;
+		try {
+			cache.get_config(game_config::path + "/" + path, cfg);
+		} catch (config::error& e) {
+			std::cerr << "Cannot load " << path << ": " << e.message << "\n";
+			continue;
+		}
+		benchmark(path, cfg, report);
+	}
+
+	BOOST_FOREACH(const std::string& path, saves) {
+		config cfg;
+		if (read_save(path, cfg)) {
+			benchmark(filesystem::base_name(path), cfg, report);
+		}
+	}
+
+	return 0;
+}
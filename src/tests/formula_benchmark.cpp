@@ -0,0 +1,163 @@
+/*
+   Copyright (C) 2015 by the Battle for Wesnoth Project
+   Part of the Battle for Wesnoth Project http://www.wesnoth.org/
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY.
+
+   See the COPYING file for more details.
+*/
+
+/**
+ * @file
+ * Times the evaluation of formulas, through their bytecode and by walking
+ * their expression trees, and writes the results as CSV.
+ *
+ * The formulas are those of test_formula_function.cpp, and a few using
+ * variables, operators and 'where'. Usage:
+ *   ./formula_benchmark [--output results.csv] [--formula text]...
+ *                       [--iterations N]
+ */
+
+#define GETTEXT_DOMAIN "wesnoth-test"
+
+#include "formula.hpp"
+#include "formula_callable.hpp"
+#include "log.hpp"
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/foreach.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include <fstream>
+#include <iostream>
+
+namespace {
+
+const char* const default_formulas[] = {
+	// test_formula_function.cpp
+	"substring('hello world', 0)",
+	"substring('hello world', -5)",
+	"substring('hello world', 1, 9)",
+	"substring('hello world', -10, 9)",
+	"length('hello world')",
+	"concatenate(100, 200, 'a')",
+	"concatenate([1,2,3])",
+	"concatenate([1.0, 1.00, 1.000, 1.2, 1.23, 1.234])",
+	"sin(x)",
+	"cos(x)",
+	// Variables and operators
+	"x",
+	"x * 3 + y / 2 - 7",
+	"(x + y) / 2 > 12 and x != y",
+	"if(x > 12, abs(y - 20), 2 + 3)",
+	"[x, y, 3][1] + [1, 2, 3].size",
+	"a * b where a = x + 2, b = y - 1",
+	"2 * 3 ^ 3 + 2",
+	"'x: {x}, y: {y}'",
+	"max(x, y, [2, 18, 7])"
+};
+
+boost::posix_time::ptime now()
+{
+	return boost::posix_time::microsec_clock::universal_time();
+}
+
+/** Nanoseconds per evaluation, the best of a few rounds. */
+double time_evaluation(const game_logic::formula& f,
+		const game_logic::formula_callable& variables, bool tree, int iterations)
+{
+	double best = 0;
+	for (int round = 0; round != 5; ++round) {
+		const boost::posix_time::ptime start = now();
+		for (int i = 0; i != iterations; ++i) {
+			if (tree) {
+				f.evaluate_tree(variables);
+			} else {
+				f.evaluate(variables);
+			}
+		}
+		const double elapsed = (now() - start).total_nanoseconds();
+		if (round == 0 || elapsed < best) {
+			best = elapsed;
+		}
+	}
+	return best / iterations;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+	std::string output;
+	std::vector<std::string> formulas;
+	int iterations = 100000;
+
+	for (int i = 1; i < argc; ++i) {
+		const std::string arg = argv[i];
+		if (i + 1 >= argc) {
+			std::cerr << "Missing value for " << arg << "\n";
+			return 1;
+		}
+		const std::string value = argv[++i];
+		try {
+			if (arg == "--output") {
+				output = value;
+			} else if (arg == "--formula") {
+				formulas.push_back(value);
+			} else if (arg == "--iterations") {
+				iterations = boost::lexical_cast<int>(value);
+			} else {
+				std::cerr << "Unknown option " << arg << "\n";
+				return 1;
+			}
+		} catch (boost::bad_lexical_cast&) {
+			std::cerr << "Invalid value for " << arg << ": " << value << "\n";
+			return 1;
+		}
+	}
+	if (formulas.empty()) {
+		formulas.assign(default_formulas, default_formulas +
+			sizeof(default_formulas) / sizeof(*default_formulas));
+	}
+
+	std::ofstream file;
+	if (!output.empty()) {
+		file.open(output.c_str());
+		if (!file) {
+			std::cerr << "Cannot write to " << output << "\n";
+			return 1;
+		}
+	}
+	std::ostream& out = output.empty() ? std::cout : file;
+	out << "formula,tree_ns,bytecode_ns,speedup,same_result\n";
+
+	lg::set_log_domain_severity("scripting/formula", lg::err);
+	game_logic::map_formula_callable variables;
+	variables.add("x", variant(15)).add("y", variant(12));
+
+	BOOST_FOREACH(const std::string& text, formulas) {
+		try {
+			const game_logic::formula f(text);
+			const bool same = f.evaluate(variables) == f.evaluate_tree(variables);
+			const double tree = time_evaluation(f, variables, true, iterations);
+			const double bytecode = time_evaluation(f, variables, false, iterations);
+
+			std::string quoted = text;
+			for (size_t pos = 0; (pos = quoted.find('"', pos)) != std::string::npos; pos += 2) {
+				quoted.insert(pos, 1, '"');
+			}
+			out << '"' << quoted << "\"," << tree << ',' << bytecode << ','
+				<< (bytecode > 0 ? tree / bytecode : 0) << ','
+				<< (same ? "yes" : "no") << '\n';
+		} catch (game_logic::formula_error& e) {
+			std::cerr << "Skipping " << text << ": " << e.type << "\n";
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,516 @@
+/*
+   Copyright (C) 2015 by the Battle for Wesnoth Project
+   Part of the Battle for Wesnoth Project http://www.wesnoth.org/
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY.
+
+   See the COPYING file for more details.
+*/
+
+/**
+ * @file
+ * Times route, reach, cost map and teleport queries on mainline and random
+ * maps, for several unit counts, and writes the results as CSV.
+ *
+ * Run it from the data directory's parent, like the unit tests:
+ *   ./pathfind_benchmark [--output results.csv] [--map file.map]...
+ *                        [--units N]... [--queries N] [--seed N]
+ */
+
+#define GETTEXT_DOMAIN "wesnoth-test"
+
+#include "SDL.h"
+
+#include "config.hpp"
+#include "filesystem.hpp"
+#include "filter_context.hpp"
+#include "game_board.hpp"
+#include "game_config.hpp"
+#include "game_data.hpp"
+#include "gui/widgets/helper.hpp"
+#include "log.hpp"
+#include "map.hpp"
+#include "pathfind/cost_grid.hpp"
+#include "pathfind/hierarchical.hpp"
+#include "pathfind/pathfind.hpp"
+#include "pathfind/teleport.hpp"
+#include "resources.hpp"
+#include "serialization/string_utils.hpp"
+#include "team.hpp"
+#include "terrain_translation.hpp"
+#include "tod_manager.hpp"
+#include "unit.hpp"
+#include "unit_types.hpp"
+
+#include "tests/utils/fake_display.hpp"
+#include "tests/utils/game_config_manager.hpp"
+
+#include <boost/cstdint.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/foreach.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/make_shared.hpp>
+
+#include <fstream>
+#include <iostream>
+
+namespace {
+
+/** The mainline maps used when none are given on the command line. */
+const char* const default_maps[] = {
+	"data/multiplayer/maps/2p_Caves_of_the_Basilisk.map",
+	"data/multiplayer/maps/2p_Den_of_Onis.map",
+	"data/multiplayer/maps/4p_Isars_Cross.map",
+	"data/multiplayer/maps/6p_Team_Colors.map",
+};
+
+/** The sizes of the random maps. */
+const int random_map_sizes[] = { 60, 150, 250 };
+
+const int default_unit_counts[] = { 10, 40, 120 };
+
+const int nb_sides = 2;
+
+/** A small deterministic generator, so runs can be compared. */
+class lcg
+{
+public:
+	explicit lcg(boost::uint32_t seed) : state_(seed) {}
+	int operator()(int max)
+	{
+		state_ = state_ * 1664525u + 1013904223u;
+		return static_cast<int>((state_ >> 8) % static_cast<boost::uint32_t>(max));
+	}
+private:
+	boost::uint32_t state_;
+};
+
+/**
+ * Unit types with fixed movement costs, so that the results do not change
+ * with mainline balancing.
+ */
+config benchmark_units()
+{
+	config units;
+
+	static const char* const movetypes[][3] = {
+		// name, flat/hills/mountains/forest, shallow/deep water
+		{ "bench_foot", "1,2,3,2", "3,99" },
+		{ "bench_mounted", "1,2,99,3", "4,99" },
+		{ "bench_fly", "1,1,1,1", "1,1" },
+	};
+	BOOST_FOREACH(const char* const* mt, movetypes) {
+		const std::vector<std::string> land = utils::split(mt[1]);
+		const std::vector<std::string> water = utils::split(mt[2]);
+		config& movetype = units.add_child("movetype");
+		movetype["name"] = mt[0];
+		config& costs = movetype.add_child("movement_costs");
+		costs["flat"] = land[0];
+		costs["castle"] = land[0];
+		costs["village"] = land[0];
+		costs["hills"] = land[1];
+		costs["cave"] = land[1];
+		costs["mountains"] = land[2];
+		costs["forest"] = land[3];
+		costs["shallow_water"] = water[0];
+		costs["swamp_water"] = water[0];
+		costs["reef"] = water[0];
+		costs["sand"] = land[1];
+		costs["frozen"] = land[1];
+		costs["fungus"] = land[1];
+		costs["deep_water"] = water[1];
+		costs["impassable"] = "99";
+		costs["unwalkable"] = water[1];
+		movetype.add_child("defense");
+	}
+
+	static const char* const types[][3] = {
+		{ "Benchmark Infantry", "bench_foot", "5" },
+		{ "Benchmark Cavalry", "bench_mounted", "8" },
+		{ "Benchmark Flyer", "bench_fly", "6" },
+	};
+	BOOST_FOREACH(const char* const* t, types) {
+		config& type = units.add_child("unit_type");
+		type["id"] = t[0];
+		type["name"] = t[0];
+		type["movement_type"] = t[1];
+		type["movement"] = t[2];
+		type["hitpoints"] = 30;
+		type["experience"] = 40;
+		type["level"] = 1;
+		type["cost"] = 15;
+		type["do_not_list"] = true;
+	}
+	return units;
+}
+
+/** Generates a map of random terrain, with a few villages. */
+std::string random_map_data(int size, lcg& random)
+{
+	static const char* const terrains[] = {
+		"Gg", "Gg", "Gg", "Gs", "Hh", "Mm", "Ff", "Ww", "Wo", "Ss", "Xu", "Gg^Vh",
+	};
+	const int nb_terrains = sizeof(terrains) / sizeof(*terrains);
+
+	// The map includes a border of one hex on each side.
+	t_translation::t_map tiles(size + 2, t_translation::t_list(size + 2));
+	for (int x = 0; x < size + 2; ++x) {
+		for (int y = 0; y < size + 2; ++y) {
+			// Villages are rarer than the other terrains.
+			int t = random(nb_terrains);
+			if (t == nb_terrains - 1 && random(4) != 0) {
+				t = 0;
+			}
+			tiles[x][y] = t_translation::read_terrain_code(terrains[t]);
+		}
+	}
+	return gamemap::default_map_header + t_translation::write_game_map(tiles);
+}
+
+}
+
+namespace test_utils {
+
+/**
+ * A game board with sides and units, registered in resources the way the
+ * pathfinding code expects during a game.
+ */
+class benchmark_board : public filter_context, private boost::noncopyable
+{
+public:
+	benchmark_board(const config& game_config, const std::string& map_data);
+	~benchmark_board();
+
+	void place_units(const std::vector<const unit_type*>& types, int count, lcg& random);
+
+	const game_board& board() const { return board_; }
+	const gamemap& map() const { return board_.map(); }
+	const std::vector<team>& teams() const { return board_.teams(); }
+	std::vector<const unit*> units_of_side(int side) const;
+
+	// filter_context
+	virtual const display_context& get_disp_context() const { return board_; }
+	virtual const tod_manager& get_tod_man() const { return tod_; }
+	virtual const game_data* get_game_data() const { return &data_; }
+	virtual game_lua_kernel* get_lua_kernel() const { return NULL; }
+
+private:
+	static config level_config(const std::string& map_data);
+	static config tunnels_config();
+
+	const config level_;
+	game_data data_;
+	tod_manager tod_;
+	pathfind::manager tunnels_;
+	game_board board_;
+
+	// The resources in place before this board.
+	game_board* old_gameboard_;
+	std::vector<team>* old_teams_;
+	unit_map* old_units_;
+	filter_context* old_filter_con_;
+	game_data* old_gamedata_;
+	::tod_manager* old_tod_manager_;
+	pathfind::manager* old_tunnels_;
+};
+
+config benchmark_board::level_config(const std::string& map_data)
+{
+	config level;
+	level["map_data"] = map_data;
+	return level;
+}
+
+/** A tunnel between all villages, usable by all units. */
+config benchmark_board::tunnels_config()
+{
+	config cfg;
+	config& tunnel = cfg.add_child("tunnel");
+	tunnel["id"] = "benchmark_villages";
+	tunnel["reversed"] = false;
+	tunnel.add_child("source")["terrain"] = "*^V*";
+	tunnel.add_child("target")["terrain"] = "*^V*";
+	tunnel.add_child("filter");
+	return cfg;
+}
+
+benchmark_board::benchmark_board(const config& game_config, const std::string& map_data)
+	: level_(level_config(map_data))
+	, data_(level_)
+	, tod_(level_)
+	, tunnels_(tunnels_config())
+	, board_(boost::make_shared<terrain_type_data>(game_config), level_)
+	, old_gameboard_(resources::gameboard)
+	, old_teams_(resources::teams)
+	, old_units_(resources::units)
+	, old_filter_con_(resources::filter_con)
+	, old_gamedata_(resources::gamedata)
+	, old_tod_manager_(resources::tod_manager)
+	, old_tunnels_(resources::tunnels)
+{
+	board_.teams_.resize(nb_sides);
+	for (int side = 1; side <= nb_sides; ++side) {
+		config side_cfg;
+		side_cfg["side"] = side;
+		side_cfg["team_name"] = "team" + boost::lexical_cast<std::string>(side);
+		side_cfg["controller"] = "ai";
+		board_.teams_[side - 1].build(side_cfg, board_.map(), 100);
+	}
+
+	resources::gameboard = &board_;
+	resources::teams = &board_.teams_;
+	resources::units = &board_.units_;
+	resources::filter_con = this;
+	resources::gamedata = &data_;
+	resources::tod_manager = &tod_;
+	resources::tunnels = &tunnels_;
+}
+
+benchmark_board::~benchmark_board()
+{
+	// Units first, while the resources they notify are still around.
+	board_.units_.clear();
+
+	resources::gameboard = old_gameboard_;
+	resources::teams = old_teams_;
+	resources::units = old_units_;
+	resources::filter_con = old_filter_con_;
+	resources::gamedata = old_gamedata_;
+	resources::tod_manager = old_tod_manager_;
+	resources::tunnels = old_tunnels_;
+	pathfind::reach_cache::invalidate_all();
+}
+
+void benchmark_board::place_units(const std::vector<const unit_type*>& types,
+		int count, lcg& random)
+{
+	const gamemap& map = board_.map();
+	for (int i = 0, attempts = 0; i < count && attempts < 100 * count; ++attempts) {
+		const map_location loc(random(map.w()), random(map.h()));
+		const unit_type& type = *types[i % types.size()];
+		if (type.movement_type().get_movement().cost(map[loc]) >= movetype::UNREACHABLE) {
+			continue;
+		}
+		const unit u(type, i % nb_sides + 1, false);
+		if (board_.units_.add(loc, u).second) {
+			++i;
+		}
+	}
+}
+
+std::vector<const unit*> benchmark_board::units_of_side(int side) const
+{
+	std::vector<const unit*> res;
+	BOOST_FOREACH(const unit& u, board_.units()) {
+		if (u.side() == side) {
+			res.push_back(&u);
+		}
+	}
+	return res;
+}
+
+}
+
+namespace {
+
+/** Collects the timings and writes them as CSV lines. */
+class reporter
+{
+public:
+	explicit reporter(std::ostream& out) : out_(out)
+	{
+		out_ << "map,width,height,units,query,queries,total_ms,mean_us\n";
+	}
+
+	void report(const std::string& map_name, const gamemap& map, int nb_units,
+	            const std::string& query, int nb_queries,
+	            const boost::posix_time::time_duration& elapsed)
+	{
+		const double total_us = static_cast<double>(elapsed.total_microseconds());
+		out_ << map_name << ',' << map.w() << ',' << map.h() << ',' << nb_units << ','
+		     << query << ',' << nb_queries << ',' << total_us / 1000.0 << ','
+		     << (nb_queries > 0 ? total_us / nb_queries : 0.0) << '\n';
+		out_.flush();
+	}
+
+private:
+	std::ostream& out_;
+};
+
+boost::posix_time::ptime now()
+{
+	return boost::posix_time::microsec_clock::universal_time();
+}
+
+void run_queries(const std::string& map_name, test_utils::benchmark_board& setup,
+		int nb_units, int nb_queries, lcg& random, reporter& report)
+{
+	const gamemap& map = setup.map();
+	const std::vector<team>& teams = setup.teams();
+	std::vector<const unit*> units;
+	BOOST_FOREACH(const unit& u, setup.board().units()) {
+		units.push_back(&u);
+	}
+	if (units.empty()) {
+		return;
+	}
+
+	std::vector<map_location> destinations;
+	for (int i = 0; i < nb_queries; ++i) {
+		destinations.push_back(map_location(random(map.w()), random(map.h())));
+	}
+
+	// Routes.
+	boost::posix_time::ptime start = now();
+	for (int i = 0; i < nb_queries; ++i) {
+		const unit& u = *units[i % units.size()];
+		const team& t = teams[u.side() - 1];
+		const pathfind::shortest_path_calculator calc(u, t, teams, map);
+		pathfind::a_star_search(u.get_location(), destinations[i], 10000.0, &calc,
+			map.w(), map.h());
+	}
+	report.report(map_name, map, nb_units, "route", nb_queries, now() - start);
+
+	start = now();
+	for (int i = 0; i < nb_queries; ++i) {
+		const unit& u = *units[i % units.size()];
+		const team& t = teams[u.side() - 1];
+		const pathfind::shortest_path_calculator calc(u, t, teams, map);
+		const pathfind::cost_grid::ptr grid = pathfind::cost_grid::get(map,
+			u.movement_type().get_movement(), u.get_state(unit::STATE_SLOWED));
+		pathfind::hierarchical_search(u.get_location(), destinations[i], 10000.0, &calc,
+			map.w(), map.h(), grid);
+	}
+	report.report(map_name, map, nb_units, "route_hierarchical", nb_queries, now() - start);
+
+	// Reach, without the help of the reach cache.
+	start = now();
+	BOOST_FOREACH(const unit* u, units) {
+		pathfind::reach_cache::invalidate_all();
+		const pathfind::paths reach(*u, false, false, teams[u->side() - 1]);
+	}
+	report.report(map_name, map, nb_units, "reach", units.size(), now() - start);
+
+	// Cost maps, one per side.
+	start = now();
+	for (int side = 1; side <= nb_sides; ++side) {
+		pathfind::full_cost_map cost_map(true, true, teams[side - 1], true, true);
+		cost_map.add_units(setup.units_of_side(side));
+	}
+	report.report(map_name, map, nb_units, "cost_map", nb_sides, now() - start);
+
+	// Teleport maps (the tunnel links all villages).
+	start = now();
+	BOOST_FOREACH(const unit* u, units) {
+		pathfind::get_teleport_locations(*u, teams[u->side() - 1], true, true);
+	}
+	report.report(map_name, map, nb_units, "teleport_map", units.size(), now() - start);
+}
+
+void benchmark_map(const config& game_config, const std::string& map_name,
+		const std::string& map_data, const std::vector<const unit_type*>& types,
+		const std::vector<int>& unit_counts, int nb_queries, boost::uint32_t seed,
+		reporter& report)
+{
+	BOOST_FOREACH(int nb_units, unit_counts) {
+		lcg random(seed);
+		test_utils::benchmark_board setup(game_config, map_data);
+		setup.place_units(types, nb_units, random);
+		run_queries(map_name, setup, nb_units, nb_queries, random, report);
+	}
+}
+
+}
+
+int main(int argc, char** argv)
+{
+	std::string output;
+	std::vector<std::string> maps;
+	std::vector<int> unit_counts;
+	int nb_queries = 200;
+	boost::uint32_t seed = 1;
+
+	for (int i = 1; i < argc; ++i) {
+		const std::string arg = argv[i];
+		if (i + 1 >= argc) {
+			std::cerr << "Missing value for " << arg << "\n";
+			return 1;
+		}
+		const std::string value = argv[++i];
+		try {
+			if (arg == "--output") {
+				output = value;
+			} else if (arg == "--map") {
+				maps.push_back(value);
+			} else if (arg == "--units") {
+				unit_counts.push_back(boost::lexical_cast<int>(value));
+			} else if (arg == "--queries") {
+				nb_queries = boost::lexical_cast<int>(value);
+			} else if (arg == "--seed") {
+				seed = boost::lexical_cast<boost::uint32_t>(value);
+			} else {
+				std::cerr << "Unknown option " << arg << "\n";
+				return 1;
+			}
+		} catch (boost::bad_lexical_cast&) {
+			std::cerr << "Invalid value for " << arg << ": " << value << "\n";
+			return 1;
+		}
+	}
+	if (maps.empty()) {
+		maps.assign(default_maps, default_maps + sizeof(default_maps) / sizeof(*default_maps));
+	}
+	if (unit_counts.empty()) {
+		unit_counts.assign(default_unit_counts, default_unit_counts +
+			sizeof(default_unit_counts) / sizeof(*default_unit_counts));
+	}
+
+	// Same initialization as the unit tests.
+	game_config::path = filesystem::get_cwd();
+	SDL_Init(SDL_INIT_TIMER);
+	test_utils::get_fake_display(1024, 768);
+	gui2::init();
+	lg::set_log_domain_severity("engine", lg::err);
+
+	const config& game_config = test_utils::get_test_config_ref();
+
+	config units = benchmark_units();
+	unit_types.set_config(units);
+	std::vector<const unit_type*> types;
+	BOOST_FOREACH(const config& type, units.child_range("unit_type")) {
+		types.push_back(unit_types.find(type["id"]));
+	}
+
+	std::ofstream file;
+	if (!output.empty()) {
+		file.open(output.c_str());
+		if (!file) {
+			std::cerr << "Cannot write to " << output << "\n";
+			return 1;
+		}
+	}
+	reporter report(output.empty() ? std::cout : file);
+
+	BOOST_FOREACH(const std::string& map_file, maps) {
+		if (!filesystem::file_exists(map_file)) {
+			std::cerr << "Skipping missing map " << map_file << "\n";
+			continue;
+		}
+		benchmark_map(game_config, filesystem::base_name(map_file),
+			filesystem::read_file(map_file), types, unit_counts, nb_queries, seed, report);
+	}
+
+	lcg random(seed);
+	BOOST_FOREACH(int size, random_map_sizes) {
+		const std::string name = "random_" + boost::lexical_cast<std::string>(size);
+		benchmark_map(game_config, name, random_map_data(size, random), types,
+			unit_counts, nb_queries, seed, report);
+	}
+
+	return 0;
+}
@@ -17,6 +17,7 @@
 #include <boost/test/unit_test.hpp>
 
 #include "addon/validation.hpp"
+#include "config.hpp"
 
 #include <boost/foreach.hpp>
 
@@ -43,6 +44,21 @@ BOOST_AUTO_TEST_CASE( validation )
 	BOOST_CHECK( !addon_name_legal("invalid$dollarsign$") );
 }
 
+BOOST_AUTO_TEST_CASE( archive_names )
+{
+	config archive;
+	config& dir = archive.add_child("dir");
+	dir["name"] = "My_Addon";
+	dir.add_child("file")["name"] = "_main.cfg";
+	dir.add_child("remove")["name"] = "obsolete.cfg";
+
+	BOOST_CHECK( check_names_legal(archive) );
+
+	dir.add_child("remove")["name"] = "..";
+
+	BOOST_CHECK( !check_names_legal(archive) );
+}
+
 BOOST_AUTO_TEST_CASE( encoding )
 {
 	BOOST_CHECK( encode_binary("") == "" );
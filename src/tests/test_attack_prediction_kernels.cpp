@@ -0,0 +1,119 @@
+/*
+   Copyright (C) 2015 by the Battle for Wesnoth Project
+   Part of the Battle for Wesnoth Project http://www.wesnoth.org/
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY.
+
+   See the COPYING file for more details.
+*/
+
+#define GETTEXT_DOMAIN "wesnoth-test"
+
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_real_distribution.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include "attack_prediction_kernels.hpp"
+
+#include <vector>
+
+namespace {
+
+const double tolerance = 1e-12;
+
+/** A row of probabilities, with some zeros like in the real planes. */
+std::vector<double> random_row(boost::mt19937& rng, unsigned size)
+{
+	boost::random::uniform_real_distribution<double> dist(0.0, 1.0);
+	std::vector<double> row(size);
+	for (unsigned i = 0; i != size; ++i) {
+		row[i] = dist(rng) < 0.3 ? 0.0 : dist(rng) / size;
+	}
+	return row;
+}
+
+void check_close(const std::vector<double>& a, const std::vector<double>& b)
+{
+	BOOST_REQUIRE_EQUAL(a.size(), b.size());
+	for (unsigned i = 0; i != a.size(); ++i) {
+		BOOST_CHECK_SMALL(a[i] - b[i], tolerance);
+	}
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE( attack_prediction_kernels )
+
+BOOST_AUTO_TEST_CASE( test_transfer_separate_rows )
+{
+	BOOST_TEST_MESSAGE("vector kernels use " << combat_kernels::instruction_set());
+	boost::mt19937 rng(42);
+	for (unsigned size = 1; size != 70; ++size) {
+		const std::vector<double> src = random_row(rng, size);
+		const std::vector<double> dst = random_row(rng, size);
+
+		std::vector<double> src_scalar = src, dst_scalar = dst;
+		std::vector<double> src_vector = src, dst_vector = dst;
+		const bool nonzero_scalar = combat_kernels::transfer_scalar(
+			&dst_scalar[0], &src_scalar[0], size, 0.35);
+		const bool nonzero_vector = combat_kernels::transfer(
+			&dst_vector[0], &src_vector[0], size, 0.35);
+
+		BOOST_CHECK_EQUAL(nonzero_scalar, nonzero_vector);
+		check_close(src_scalar, src_vector);
+		check_close(dst_scalar, dst_vector);
+	}
+}
+
+BOOST_AUTO_TEST_CASE( test_transfer_within_row )
+{
+	// shift_cols() moves values of a row towards column 0 of the same row.
+	boost::mt19937 rng(7);
+	for (unsigned shift = 0; shift != 9; ++shift) {
+		const std::vector<double> row = random_row(rng, 61);
+		const unsigned count = row.size() - shift;
+
+		std::vector<double> row_scalar = row, row_vector = row;
+		combat_kernels::transfer_scalar(&row_scalar[0], &row_scalar[shift], count, 0.6);
+		combat_kernels::transfer(&row_vector[0], &row_vector[shift], count, 0.6);
+
+		check_close(row_scalar, row_vector);
+	}
+}
+
+BOOST_AUTO_TEST_CASE( test_transfer_all )
+{
+	// merge_cols() moves whole rows; this must leave exact zeros behind.
+	boost::mt19937 rng(3);
+	const std::vector<double> src = random_row(rng, 37);
+	std::vector<double> src_vector = src, dst_vector(src.size(), 0.0);
+	combat_kernels::transfer(&dst_vector[0], &src_vector[0], src.size(), 1.0);
+
+	for (unsigned i = 0; i != src.size(); ++i) {
+		BOOST_CHECK_EQUAL(src_vector[i], 0.0);
+		BOOST_CHECK_EQUAL(dst_vector[i], src[i]);
+	}
+}
+
+BOOST_AUTO_TEST_CASE( test_take_sum )
+{
+	boost::mt19937 rng(11);
+	for (unsigned size = 1; size != 70; ++size) {
+		const std::vector<double> row = random_row(rng, size);
+
+		std::vector<double> row_scalar = row, row_vector = row;
+		const double sum_scalar = combat_kernels::take_sum_scalar(&row_scalar[0], size);
+		const double sum_vector = combat_kernels::take_sum(&row_vector[0], size);
+
+		BOOST_CHECK_SMALL(sum_scalar - sum_vector, tolerance);
+		check_close(row_scalar, std::vector<double>(size, 0.0));
+		check_close(row_vector, std::vector<double>(size, 0.0));
+	}
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -56,6 +56,7 @@ BOOST_AUTO_TEST_CASE (test_empty_options)
 	BOOST_CHECK(!co.multiplayer_ignore_map_settings);
 	BOOST_CHECK(!co.multiplayer_label);
 	BOOST_CHECK(!co.multiplayer_parm);
+	BOOST_CHECK(!co.multiplayer_stats);
 	BOOST_CHECK(!co.multiplayer_side);
 	BOOST_CHECK(!co.multiplayer_turns);
 	BOOST_CHECK(!co.max_fps);
@@ -79,6 +80,7 @@ BOOST_AUTO_TEST_CASE (test_empty_options)
 	BOOST_CHECK(!co.proxy_user);
 	BOOST_CHECK(!co.resolution);
 	BOOST_CHECK(!co.rng_seed);
+	BOOST_CHECK(!co.render_benchmark);
 	BOOST_CHECK(!co.multiplayer_scenario);
 	BOOST_CHECK(!co.server);
 	BOOST_CHECK(!co.screenshot);
@@ -161,6 +163,7 @@ BOOST_AUTO_TEST_CASE (test_default_options)
 	BOOST_CHECK(!co.proxy_user);
 	BOOST_CHECK(!co.resolution);
 	BOOST_CHECK(!co.rng_seed);
+	BOOST_CHECK(!co.render_benchmark);
 	BOOST_CHECK(co.server && co.server->empty());
 	BOOST_CHECK(!co.screenshot);
 	BOOST_CHECK(!co.screenshot_map_file);
@@ -234,6 +237,7 @@ BOOST_AUTO_TEST_CASE (test_full_options)
 		("--proxy-password=passfoo")
 		("--proxy-port=portfoo")
 		("--proxy-user=userfoo")
+		("--render-benchmark=500")
 		("--resolution=800x600")
 		("--rng-seed=1234")
 		("--scenario=scenfoo")
@@ -330,6 +334,7 @@ BOOST_AUTO_TEST_CASE (test_full_options)
 	BOOST_CHECK(co.resolution);
 	BOOST_CHECK(co.resolution->get<0>() == 800 && co.resolution->get<1>() == 600);
 	BOOST_CHECK(co.rng_seed && *co.rng_seed == 1234);
+	BOOST_CHECK(co.render_benchmark && *co.render_benchmark == 500);
 	BOOST_CHECK(co.server && *co.server == "servfoo");
 	BOOST_CHECK(co.screenshot && co.screenshot_map_file && co.screenshot_output_file);
 	BOOST_CHECK(*co.screenshot_map_file == "mapfoo" && *co.screenshot_output_file == "outssfoo");
@@ -406,6 +411,7 @@ BOOST_AUTO_TEST_CASE (test_positional_options)
 	BOOST_CHECK(!co.proxy_user);
 	BOOST_CHECK(!co.resolution);
 	BOOST_CHECK(!co.rng_seed);
+	BOOST_CHECK(!co.render_benchmark);
 	BOOST_CHECK(!co.server);
 	BOOST_CHECK(!co.screenshot);
 	BOOST_CHECK(!co.screenshot_map_file);
@@ -20,8 +20,16 @@
 
 #include "config.hpp"
 #include "config_assign.hpp"
+#include "frozen_config.hpp"
+#include "packed_command.hpp"
+#include "serialization/binary_wml.hpp"
+#include "serialization/parser.hpp"
+#include "shared_config.hpp"
 #include "variable_info.hpp"
 
+#include <sstream>
+#include <stack>
+
 BOOST_AUTO_TEST_SUITE ( test_config )
 
 BOOST_AUTO_TEST_CASE ( test_config_attribute_value )
@@ -287,4 +295,280 @@ BOOST_AUTO_TEST_CASE ( test_variable_info )
 	}
 }
 
+BOOST_AUTO_TEST_CASE ( test_variable_info_arrays )
+{
+	config c = config_of
+		("a", config_of("n", 0))
+		("b", config())
+		("a", config_of("n", 1))
+		("a", config_of("n", 2))
+		("b", config())
+		("a", config_of("n", 3));
+
+	// Shrinking an array removes the children at once, keeping the ordering.
+	std::vector<config> shorter(1, config_of("n", 9));
+	variable_access_create("a[1]", c).replace_array(shorter);
+	BOOST_CHECK_EQUAL (variable_access_const("a.length", c).as_scalar(), 4);
+	c.remove_children("a", 1, 3);
+	BOOST_CHECK_EQUAL (variable_access_const("a.length", c).as_scalar(), 2);
+	BOOST_CHECK_EQUAL (variable_access_const("a[1].n", c).as_scalar(), 3);
+	BOOST_CHECK_EQUAL (c.all_children_count(), 4);
+	config expected = config_of
+		("a", config_of("n", 0))
+		("b", config())
+		("b", config())
+		("a", config_of("n", 3));
+	BOOST_CHECK_EQUAL (c, expected);
+
+	// Growing it at its end appends the children.
+	std::vector<config> more(2, config_of("n", 5));
+	variable_access_create("a", c).append_array(more);
+	BOOST_CHECK_EQUAL (variable_access_const("a.length", c).as_scalar(), 4);
+	BOOST_CHECK_EQUAL (variable_access_const("a[3].n", c).as_scalar(), 5);
+	BOOST_CHECK_EQUAL (c.all_children_count(), 6);
+
+	// The ranges of an array index in O(1).
+	config::const_child_itors range = c.child_range("a");
+	BOOST_CHECK_EQUAL ((range.second - range.first), 4);
+	BOOST_CHECK_EQUAL ((range.first + 1)->get("n")->to_int(), 3);
+}
+
+BOOST_AUTO_TEST_CASE ( test_binary_round_trip )
+{
+	config c;
+	c["int"] = -7;
+	c["big"] = 12345678901234ULL;
+	c["double"] = 3.25;
+	c["yes"] = true;
+	c["true"] = "true";
+	c["string"] = "hello";
+	c["empty"] = "";
+	c["tstring"] = t_string("hello", "wesnoth");
+	c.add_child("unit")["id"] = "first";
+	c.add_child("side").add_child("unit")["id"] = "nested";
+	c.add_child("unit")["id"] = "second";
+
+	std::ostringstream out;
+	write_binary(out, c);
+	const std::string data = out.str();
+
+	config r;
+	read_binary(r, data.data(), data.size());
+	BOOST_CHECK_EQUAL(r, c);
+	BOOST_CHECK(r["tstring"].t_str().translatable());
+	BOOST_CHECK_EQUAL(r.all_children_range().first->key, "unit");
+	BOOST_CHECK_EQUAL(r.child("unit", 1)["id"], "second");
+
+	// Truncated data must be rejected, not read past.
+	for(size_t size = 0; size < data.size(); ++size) {
+		config t;
+		BOOST_CHECK_THROW(read_binary(t, data.data(), size), config::error);
+	}
+}
+
+BOOST_AUTO_TEST_CASE ( test_packed_command_round_trip )
+{
+	config c;
+	config& move = c.add_child("move");
+	move["x"] = "12,13,13,14";
+	move["y"] = "4,4,05,5";
+	move["skip_sighted"] = "all";
+	c.add_child("checkup").add_child("result")["final_hex_x"] = 14;
+	c.add_child("random_seed")["new_seed"] = "0a1b2c3d";
+	c["from_side"] = "server";
+	c["dependent"] = true;
+	c["undo"] = "false";
+	config& other = c.add_child("custom_command");
+	other["custom_key"] = -3;
+	other["ratio"] = 0.5;
+	other["text"] = t_string("translated", "wesnoth");
+	other["blank"];
+
+	std::string packed;
+	pack_command(c, packed);
+
+	config r;
+	unpack_command(packed, r);
+	BOOST_CHECK_EQUAL(r, c);
+	BOOST_CHECK_EQUAL(r.child("move")["x"].str(), "12,13,13,14");
+	BOOST_CHECK_EQUAL(r.child("move")["y"].str(), "4,4,05,5");
+	BOOST_CHECK_EQUAL(r.child("random_seed")["new_seed"].str(), "0a1b2c3d");
+	BOOST_CHECK(r.child("custom_command")["text"].t_str().translatable());
+
+	// The common commands take a fraction of their text.
+	c.remove_child("custom_command", 0);
+	pack_command(c, packed);
+	BOOST_CHECK(packed.size() < c.debug().size() / 2);
+}
+
+namespace {
+
+/** Rebuilds the config read, except for the tags named skip. */
+class rebuilding_handler : public wml_event_handler
+{
+public:
+	explicit rebuilding_handler(const std::string& skip) : cfg(), skip_(skip), stack_()
+	{ stack_.push(&cfg); }
+
+	bool open_tag(const std::string& tag, bool append)
+	{
+		if(tag == skip_) {
+			return false;
+		}
+		config& parent = *stack_.top();
+		stack_.push(append && parent.child(tag, -1) ? &parent.child(tag, -1) : &parent.add_child(tag));
+		return true;
+	}
+	void close_tag(const std::string&)
+	{ stack_.pop(); }
+	void attribute(const std::string& key, const config::attribute_value& value)
+	{ (*stack_.top())[key] = value; }
+
+	config cfg;
+
+private:
+	std::string skip_;
+	std::stack<config*> stack_;
+};
+
+}
+
+BOOST_AUTO_TEST_CASE ( test_read_events )
+{
+	const std::string wml =
+		"a=1\n"
+		"b,c,d=x,y\n"
+		"[unit]\n"
+		"  name=_ \"Elf\"\n"
+		"  [attack]\n"
+		"    text=\"two\n[lines]\"\n"
+		"  [/attack]\n"
+		"[/unit]\n"
+		"[+unit]\n"
+		"  id=first\n"
+		"[/unit]\n"
+		"[replay]\n"
+		"  [command]\n"
+		"    [replay]\n"
+		"    [/replay]\n"
+		"  [/command]\n"
+		"[/replay]\n"
+		"[side]\n"
+		"  side=1\n"
+		"[/side]\n";
+
+	config expected;
+	read(expected, wml);
+
+	std::istringstream in(wml);
+	rebuilding_handler all("");
+	read_events(all, in);
+	BOOST_CHECK_EQUAL(all.cfg, expected);
+	BOOST_CHECK(all.cfg.child("unit")["name"].t_str().translatable());
+
+	// Skipped tags lose their contents, nested tags of the same name included.
+	expected.clear_children("replay");
+	std::istringstream in2(wml);
+	rebuilding_handler skipping("replay");
+	read_events(skipping, in2);
+	BOOST_CHECK_EQUAL(skipping.cfg, expected);
+
+	// Errors inside skipped tags are still reported.
+	std::istringstream in3("[replay]\n[a]\n[/b]\n[/replay]\n");
+	rebuilding_handler failing("replay");
+	BOOST_CHECK_THROW(read_events(failing, in3), config::error);
+}
+
+BOOST_AUTO_TEST_CASE ( test_frozen_config )
+{
+	config c;
+	c["name"] = "root";
+	c["yes"] = true;
+	c.add_child("unit")["id"] = "first";
+	config& side = c.add_child("side");
+	side["side"] = 1;
+	side.add_child("unit")["id"] = "nested";
+	c.add_child("unit")["id"] = "second";
+	c.add_child("empty");
+
+	const frozen_config frozen(c);
+	const frozen_config::node root = frozen.root();
+
+	BOOST_CHECK_EQUAL(root["name"], "root");
+	BOOST_CHECK(root["yes"].to_bool());
+	BOOST_CHECK(root["missing"].blank());
+	BOOST_CHECK(!root.has_attribute("missing"));
+	BOOST_CHECK_EQUAL(root.child_count("unit"), 2);
+	BOOST_CHECK_EQUAL(root.all_children_count(), 4);
+	BOOST_CHECK_EQUAL(root.child("unit")["id"], "first");
+	BOOST_CHECK_EQUAL(root.child("unit", -1)["id"], "second");
+	BOOST_CHECK(!root.child("unit", 2));
+	BOOST_CHECK(!root.child("missing"));
+	BOOST_CHECK(!root.child("missing").child("unit"));
+	BOOST_CHECK_EQUAL(root.child("side").child("unit")["id"], "nested");
+	BOOST_CHECK(root.child("empty").empty());
+
+	std::vector<std::string> ids;
+	BOOST_FOREACH(const frozen_config::node& unit, root.child_range("unit")) {
+		ids.push_back(unit["id"]);
+	}
+	BOOST_CHECK_EQUAL(ids.size(), 2);
+	BOOST_CHECK_EQUAL(ids.back(), "second");
+
+	std::vector<std::string> tags;
+	BOOST_FOREACH(const frozen_config::any_child& child, root.all_children_range()) {
+		tags.push_back(child.key);
+	}
+	BOOST_CHECK_EQUAL(tags.size(), 4);
+	BOOST_CHECK_EQUAL(tags[1], "side");
+
+	BOOST_CHECK_EQUAL(root.thaw(), c);
+}
+
+BOOST_AUTO_TEST_CASE ( test_memory_usage )
+{
+	config c;
+	const size_t empty = c.memory_usage();
+	BOOST_CHECK(empty >= sizeof(config));
+
+	c["name"] = std::string(1000, 'x');
+	const size_t with_value = c.memory_usage();
+	BOOST_CHECK(with_value >= empty + 1000);
+
+	config& child = c.add_child("unit");
+	child["id"] = std::string(500, 'y');
+	BOOST_CHECK(c.memory_usage() >= with_value + child.memory_usage());
+	BOOST_CHECK(child.memory_usage() >= 500);
+}
+
+BOOST_AUTO_TEST_CASE ( test_shared_config )
+{
+	shared_config empty;
+	BOOST_CHECK(empty.empty());
+	BOOST_CHECK(empty.get().empty());
+
+	config c;
+	c.add_child("side")["id"] = "first";
+	shared_config a(c);
+	BOOST_CHECK(c.empty());
+	BOOST_CHECK_EQUAL(a.get().child("side")["id"], "first");
+
+	shared_config b(a);
+	BOOST_CHECK(b.shares_with(a));
+	BOOST_CHECK_EQUAL(&b.get(), &a.get());
+
+	b.get_mutable().child("side")["id"] = "second";
+	BOOST_CHECK(!b.shares_with(a));
+	BOOST_CHECK_EQUAL(a.get().child("side")["id"], "first");
+	BOOST_CHECK_EQUAL(b.get().child("side")["id"], "second");
+
+	// Not shared any more, so not copied again.
+	const config* own = &b.get_mutable();
+	BOOST_CHECK_EQUAL(&b.get_mutable(), own);
+
+	b.clear();
+	BOOST_CHECK(b.empty());
+	BOOST_CHECK(!a.empty());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -19,6 +19,7 @@
 
 #include "config_cache.hpp"
 #include "config.hpp"
+#include "filesystem.hpp"
 #include "game_config.hpp"
 #include "language.hpp"
 #include "version.hpp"
@@ -57,6 +58,8 @@ class test_config_cache : public game_config::config_cache {
 	{
 		game_config::config_cache::set_force_invalid_cache(force);
 	}
+
+	using game_config::config_cache::segment_of;
 };
 
 test_config_cache & test_config_cache::instance() {
@@ -284,6 +287,54 @@ BOOST_AUTO_TEST_CASE( test_define_loading )
 	cache.set_force_invalid_cache(false);
 }
 
+BOOST_AUTO_TEST_CASE( test_parallel_preprocessing )
+{
+	test_scoped_define macro("TEST_MACRO");
+
+	game_config::config_cache_transaction transaction;
+
+	config cached_config;
+	cache.get_config(test_data_path, cached_config);
+
+	transaction.lock();
+
+	// Without a valid cache, both files get preprocessed in advance.
+	cache.set_force_invalid_cache(true);
+	std::vector<std::string> paths;
+	paths.push_back("data/test/test/umc.cfg");
+	paths.push_back("data/test/test/leading_space.cfg");
+	cache.preprocess_in_parallel(paths);
+
+	config umc_config;
+	config* child = &umc_config.add_child("umc");
+	(*child)["test"] = "umc load";
+	child = &umc_config.add_child("test_key3");
+	(*child)["define"] = "transaction";
+	child = &umc_config.add_child("test_key4");
+	(*child)["defined"] = "parameter";
+	cached_config.clear();
+	cache.get_config("data/test/test/umc.cfg", cached_config);
+	BOOST_CHECK_EQUAL(umc_config, cached_config);
+
+	config space_config;
+	space_config.add_child("test_lead_space")["space"] = "empty char in middle";
+	cached_config.clear();
+	cache.get_config("data/test/test/leading_space.cfg", cached_config);
+	BOOST_CHECK_EQUAL(space_config, cached_config);
+	cache.set_force_invalid_cache(false);
+}
+
+BOOST_AUTO_TEST_CASE( test_cache_segments )
+{
+	const std::string user_data = filesystem::get_user_data_dir() + "/data/";
+	const std::string addon = user_data + "add-ons/Test_Addon";
+
+	BOOST_CHECK_EQUAL(test_config_cache::segment_of(test_data_path), "data/");
+	BOOST_CHECK_EQUAL(test_config_cache::segment_of(addon + "/_main.cfg"), addon);
+	BOOST_CHECK_EQUAL(test_config_cache::segment_of(addon + "/units/test.cfg"), addon);
+	BOOST_CHECK_EQUAL(test_config_cache::segment_of(user_data + "test.cfg"), user_data);
+}
+
 BOOST_AUTO_TEST_CASE( test_lead_spaces_loading )
 {
 	config test_config;
@@ -19,7 +19,11 @@
 #include "formula_function.hpp"
 #include "log.hpp"
 
+#include <boost/lexical_cast.hpp>
+
+#include <algorithm>
 #include <cmath>
+#include <functional>
 
 BOOST_AUTO_TEST_SUITE(formula_function)
 
@@ -154,5 +158,112 @@ BOOST_AUTO_TEST_CASE(test_formula_function_sin_cos)
 	}
 }
 
+BOOST_AUTO_TEST_CASE(test_formula_bytecode)
+{
+	// The compiled formulas have to give the same results as the trees.
+	const char* const formulas[] = {
+		"x", "17", "x/2 + y", "(x+y)/2", "x > 12", "2 and 1", "2 and 0",
+		"2 or 0", "-5", "-x", "not 5", "not x", "4^2", "2*3^3+2", "1.5*2.25 - 3",
+		"x % 4 + 7 % 3", "2.0 = 2", "'abcd' = 'acd'", "'x: {x}, y: {y}'",
+		"[1,2,3]", "[x,2][0]", "['a' -> 1, 'b' -> x]['b']", "[] = []",
+		"[1,2,3].size + [4,5].last", "x.size", "[1,2] .+ [3,4]",
+		"1 < 2 and 2 >= 2 and 2 != 3 and 2 <= 1",
+		"a * b where a = x + 2, b = y - 1", "[a, b] where a = x, b = 2",
+		"if(x > 12, abs(y - 20), 2 + 3)", "max(4, x, [2, 18, 7])",
+		"substring('hello world', 1, 9)", "concatenate([1.0, 1.2, x])",
+		"map([1, 2, 3], value * x)", "filter([1, 2, x], value > 1)",
+		"loc(2, 3).x + loc(x, 1).y", "sum(map([loc(1, 1), loc(3, x)], value.y))"
+	};
+
+	game_logic::map_formula_callable variables;
+	variables.add("x", variant(15)).add("y", variant(12));
+
+	for(size_t i = 0; i != sizeof(formulas) / sizeof(*formulas); ++i) {
+		const game_logic::formula f(formulas[i]);
+		BOOST_CHECK_MESSAGE(f.evaluate(variables) == f.evaluate_tree(variables),
+				"different result for " << formulas[i]);
+	}
+
+	BOOST_CHECK_EQUAL(game_logic::formula("2*3^3+2").evaluate().as_int(), 56);
+	BOOST_CHECK_EQUAL(
+			  game_logic::formula("x*(a*b where a=2,b=1) where x=5").evaluate().as_int()
+			, 10);
+}
+
+BOOST_AUTO_TEST_CASE(test_formula_function_table)
+{
+	using game_logic::formula;
+
+	// The builtins are found by a binary search.
+	const std::vector<std::string> names = game_logic::builtin_function_names();
+	BOOST_CHECK(std::adjacent_find(names.begin(), names.end(),
+			std::greater_equal<std::string>()) == names.end());
+	BOOST_CHECK_THROW(formula("no_such_function(1)"), game_logic::formula_error);
+	BOOST_CHECK_THROW(formula("loc(1)"), game_logic::formula_error);
+
+	// The fast paths of sum, map and filter.
+	BOOST_CHECK_EQUAL(formula("sum([1, 2, 15])").evaluate().as_int(), 18);
+	BOOST_CHECK_EQUAL(formula("sum([1, 2.5])").evaluate().as_decimal(), 3500);
+	BOOST_CHECK(formula("sum([[1], [2, 3]], [0])").evaluate() == formula("[0, 1, 2, 3]").evaluate());
+	BOOST_CHECK(formula("map(['a' -> 1, 'b' -> 15], value * 2)").evaluate()
+			== formula("['a' -> 2, 'b' -> 30]").evaluate());
+	BOOST_CHECK(formula("filter(['a' -> 1, 'b' -> 15], value > 1 and key = 'b')").evaluate()
+			== formula("['b' -> 15]").evaluate());
+	BOOST_CHECK(formula("filter(5, value)").evaluate() == formula("[]").evaluate());
+}
+
+BOOST_AUTO_TEST_CASE(test_formula_key_table)
+{
+	const char* const names[] = { "hitpoints", "x", "zzz_only_here", NULL };
+	const game_logic::formula_key_table keys(names);
+
+	BOOST_CHECK_EQUAL(game_logic::formula_key("x").id(), game_logic::formula_key("x").id());
+	BOOST_CHECK_EQUAL(game_logic::formula_key("self").id(), game_logic::formula_key::self_id);
+
+	BOOST_CHECK_EQUAL(keys.find(game_logic::formula_key("hitpoints")), 0);
+	BOOST_CHECK_EQUAL(keys.find(game_logic::formula_key("zzz_only_here")), 2);
+	BOOST_CHECK_EQUAL(keys.find(game_logic::formula_key("not_in_table")), -1);
+	BOOST_CHECK_EQUAL(keys.find(std::string("x")), 1);
+	BOOST_CHECK_EQUAL(keys.find(std::string("y")), -1);
+
+	// Keys interned after the table was made are not in it either.
+	BOOST_CHECK_EQUAL(keys.find(game_logic::formula_key("interned_later")), -1);
+}
+
+BOOST_AUTO_TEST_CASE(test_formula_cache)
+{
+	using game_logic::formula;
+	namespace formula_cache = game_logic::formula_cache;
+	formula_cache::clear();
+
+	const game_logic::const_formula_ptr f = formula::get_cached("2 + 3");
+	BOOST_CHECK_EQUAL(f->evaluate().as_int(), 5);
+	BOOST_CHECK(formula::get_cached("2 + 3") == f);
+	BOOST_CHECK_EQUAL(formula_cache::get_statistics().hits, 1u);
+	BOOST_CHECK_EQUAL(formula_cache::get_statistics().misses, 1u);
+
+	{
+		game_logic::function_symbol_table symbols;
+		BOOST_CHECK(formula::get_cached("2 + 3", &symbols) != f);
+		BOOST_CHECK_EQUAL(formula_cache::get_statistics().entries, 2u);
+
+		// Defining a function changes the table, so this is not kept.
+		formula::get_cached("def twice(n) n * 2; twice(4)", &symbols);
+		BOOST_CHECK_EQUAL(formula_cache::get_statistics().uncached, 1u);
+		BOOST_CHECK_EQUAL(formula::get_cached("twice(2)", &symbols)->evaluate().as_int(), 4);
+	}
+	// Nor is anything parsed with a table that is gone.
+	BOOST_CHECK_EQUAL(formula_cache::get_statistics().entries, 1u);
+
+	for(int i = 0; i <= int(formula_cache::max_entries); ++i) {
+		formula::get_cached(boost::lexical_cast<std::string>(i));
+	}
+	BOOST_CHECK_EQUAL(formula_cache::get_statistics().entries, formula_cache::max_entries);
+
+	BOOST_CHECK_THROW(formula::get_cached("2 +"), game_logic::formula_error);
+	formula_cache::clear();
+	BOOST_CHECK_EQUAL(formula_cache::get_statistics().entries, 0u);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
@@ -15,6 +15,7 @@
 #define GETTEXT_DOMAIN "wesnoth-test"
 
 #include <boost/test/unit_test.hpp>
+#include "counter_rng.hpp"
 #include "random_new_synced.hpp"
 #include "random_new_deterministic.hpp"
 #include "config.hpp"
@@ -327,5 +328,51 @@ BOOST_AUTO_TEST_CASE( validate_get_random_int2 )
 	BOOST_CHECK_EQUAL ( val , validation_get_random_int_correct_answer );
 }
 
+BOOST_AUTO_TEST_CASE( test_mt_rng_fill )
+{
+	rand_rng::mt_rng rng1(0x12345678);
+	rand_rng::mt_rng rng2(0x12345678);
+
+	uint32_t numbers[100];
+	rng1.fill(numbers, 100);
+	for (int i = 0; i < 100; i++) {
+		BOOST_CHECK_EQUAL(numbers[i], rng2.get_next_random());
+	}
+	BOOST_CHECK_EQUAL(rng1.get_random_calls(), 100u);
+	BOOST_CHECK(rng1 == rng2);
+}
+
+BOOST_AUTO_TEST_CASE( test_rng_fill )
+{
+	boost::shared_ptr<random_new::rng> gen1 (new random_new::synced_rng(validate_get_random_int_seed_generator));
+	boost::shared_ptr<random_new::rng> gen2 (new random_new::synced_rng(validate_get_random_int_seed_generator));
+
+	uint32_t numbers[50];
+	gen1->fill(numbers, 50);
+	for (int i = 0; i < 50; i++) {
+		BOOST_CHECK_EQUAL(numbers[i], gen2->next_random());
+	}
+	BOOST_CHECK_EQUAL(gen1->get_random_calls(), gen2->get_random_calls());
+	BOOST_CHECK_EQUAL(gen1->next_random(), gen2->next_random());
+}
+
+BOOST_AUTO_TEST_CASE( test_counter_rng )
+{
+	rand_rng::counter_rng rng1(42);
+	rand_rng::counter_rng rng2(42);
+	rand_rng::counter_rng rng3(43);
+
+	uint32_t numbers[64];
+	rng1.fill(numbers, 64);
+	bool differs = false;
+	for (int i = 0; i < 64; i++) {
+		BOOST_CHECK_EQUAL(numbers[i], rng2.get_next_random());
+		BOOST_CHECK_EQUAL(numbers[i], rng1.at(i));
+		differs = differs || numbers[i] != rng3.get_next_random();
+	}
+	BOOST_CHECK(differs);
+	BOOST_CHECK_EQUAL(rng1.get_position(), 64u);
+	BOOST_CHECK_EQUAL(rng1.get_next_random(), rng2.get_next_random());
+}
 
 BOOST_AUTO_TEST_SUITE_END()
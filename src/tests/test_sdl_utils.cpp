@@ -12,6 +12,181 @@
    See the COPYING file for more details.
 */
 
+#define GETTEXT_DOMAIN "wesnoth-test"
+
+#include "sdl/utils.hpp"
+
+#include <boost/foreach.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <iomanip>
+#include <map>
+#include <vector>
+
+/*
+ * The pixel loops may be vectorized (see sdl/utils.cpp); these tests check
+ * them against the per pixel formulas on surfaces whose sizes also leave
+ * pixels to the scalar loops.
+ */
+
+namespace {
+
+/** A neutral surface of varied colors, a fourth of it fully transparent. */
+surface varied_surface(int w, int h, Uint32 seed)
+{
+	surface res = create_neutral_surface(w, h);
+	surface_lock lock(res);
+	Uint32* pixels = lock.pixels();
+	for(int i = 0; i != w * h; ++i) {
+		seed = seed * 1103515245u + 12345u;
+		pixels[i] = (seed >> 16) | (seed << 16);
+		if(i % 4 == 1) {
+			pixels[i] &= 0x00FFFFFF;
+		}
+	}
+	return res;
+}
+
+std::vector<Uint32> pixels_of(const surface& surf)
+{
+	const_surface_lock lock(surf);
+	return std::vector<Uint32>(lock.pixels(), lock.pixels() + surf->w * surf->h);
+}
+
+void check_pixels(const surface& res, const std::vector<Uint32>& expected)
+{
+	const std::vector<Uint32> actual = pixels_of(res);
+	BOOST_REQUIRE_EQUAL(actual.size(), expected.size());
+	for(size_t i = 0; i != expected.size(); ++i) {
+		BOOST_CHECK_MESSAGE(actual[i] == expected[i], "pixel " << i << " is "
+			<< std::hex << std::setfill('0') << std::setw(8) << actual[i]
+			<< " instead of " << std::setw(8) << expected[i]);
+	}
+}
+
+Uint32 pixel(Uint32 a, int r, int g, int b)
+{
+	return (a << 24) | (r << 16) | (g << 8) | b;
+}
+
+int clamp255(int c)
+{
+	return std::max(0, std::min(255, c));
+}
+
+const int width = 13, height = 7;
+
+}
+
+BOOST_AUTO_TEST_SUITE(sdl_utils)
+
+BOOST_AUTO_TEST_CASE(test_adjust_surface_color)
+{
+	const surface src = varied_surface(width, height, 1);
+	const int amounts[][3] = { {40, -30, 0}, {-300, 300, 255}, {1, -1, -256} };
+	for(size_t n = 0; n != sizeof(amounts) / sizeof(amounts[0]); ++n) {
+		std::vector<Uint32> expected = pixels_of(src);
+		BOOST_FOREACH(Uint32& p, expected) {
+			if(p >> 24) {
+				p = pixel(p >> 24, clamp255(((p >> 16) & 0xFF) + amounts[n][0]),
+					clamp255(((p >> 8) & 0xFF) + amounts[n][1]), clamp255((p & 0xFF) + amounts[n][2]));
+			}
+		}
+		check_pixels(adjust_surface_color(src, amounts[n][0], amounts[n][1], amounts[n][2], false), expected);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(test_brighten_image)
+{
+	const surface src = varied_surface(width, height, 2);
+	const fixed_t amounts[] = { 0, ftofxp(0.5), ftofxp(1.5), 70000 };
+	BOOST_FOREACH(fixed_t amount, amounts) {
+		std::vector<Uint32> expected = pixels_of(src);
+		BOOST_FOREACH(Uint32& p, expected) {
+			if(p >> 24) {
+				p = pixel(p >> 24, std::min(255, fxpmult(int((p >> 16) & 0xFF), amount)),
+					std::min(255, fxpmult(int((p >> 8) & 0xFF), amount)), std::min(255, fxpmult(int(p & 0xFF), amount)));
+			}
+		}
+		check_pixels(brighten_image(src, amount, false), expected);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(test_adjust_surface_alpha)
+{
+	const surface src = varied_surface(width, height, 3);
+	const fixed_t amounts[] = { 0, ftofxp(0.3), ftofxp(2) };
+	BOOST_FOREACH(fixed_t amount, amounts) {
+		std::vector<Uint32> expected = pixels_of(src);
+		BOOST_FOREACH(Uint32& p, expected) {
+			const int a = std::min(255, fxpmult(int(p >> 24), amount));
+			p = (Uint32(a) << 24) | (p & 0x00FFFFFF);
+		}
+		check_pixels(adjust_surface_alpha(src, amount, false), expected);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(test_light_surface)
+{
+	const surface src = varied_surface(width, height, 4);
+	const surface lightmap = varied_surface(width, height, 5);
+	std::vector<Uint32> expected = pixels_of(src);
+	const std::vector<Uint32> light = pixels_of(lightmap);
+	for(size_t i = 0; i != expected.size(); ++i) {
+		const Uint32 p = expected[i], l = light[i];
+		if(p >> 24) {
+			expected[i] = pixel(p >> 24,
+				clamp255(int((p >> 16) & 0xFF) + (int((l >> 16) & 0xFF) - 128) * 2),
+				clamp255(int((p >> 8) & 0xFF) + (int((l >> 8) & 0xFF) - 128) * 2),
+				clamp255(int(p & 0xFF) + (int(l & 0xFF) - 128) * 2));
+		}
+	}
+	check_pixels(light_surface(src, lightmap, false), expected);
+}
+
+BOOST_AUTO_TEST_CASE(test_blend_surface_pixels)
+{
+	const surface src = varied_surface(width, height, 6);
+	const double amounts[] = { 0., 0.25, 0.8, 1. };
+	BOOST_FOREACH(double amount, amounts) {
+		const Uint32 color = 0x00C08040;
+		const int ratio = int(amount * 256);
+		std::vector<Uint32> expected = pixels_of(src);
+		BOOST_FOREACH(Uint32& p, expected) {
+			p = pixel(p >> 24,
+				((256 - ratio) * int((p >> 16) & 0xFF) + ratio * 0xC0) >> 8,
+				((256 - ratio) * int((p >> 8) & 0xFF) + ratio * 0x80) >> 8,
+				((256 - ratio) * int(p & 0xFF) + ratio * 0x40) >> 8);
+		}
+		check_pixels(blend_surface(src, amount, color, false), expected);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(test_recolor_image)
+{
+	const surface src = varied_surface(width, height, 7);
+	std::vector<Uint32> expected = pixels_of(src);
+
+	// Recolors every other color of the surface, and some absent ones.
+	std::map<Uint32, Uint32> map_rgb;
+	for(size_t i = 0; i < expected.size(); i += 2) {
+		map_rgb[expected[i] & 0x00FFFFFF] = (expected[i] * 7) & 0x00FFFFFF;
+	}
+	for(Uint32 c = 0; c != 40; ++c) {
+		map_rgb.insert(std::make_pair(c * 0x010203, c));
+	}
+
+	BOOST_FOREACH(Uint32& p, expected) {
+		const std::map<Uint32, Uint32>::const_iterator i = map_rgb.find(p & 0x00FFFFFF);
+		if((p >> 24) && i != map_rgb.end()) {
+			p = (p & 0xFF000000) | i->second;
+		}
+	}
+	check_pixels(recolor_image(src, map_rgb, false), expected);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
 //#define GETTEXT_DOMAIN "wesnoth-test"
 //
 //#include "tests/test_sdl_utils.hpp"
@@ -16,10 +16,14 @@
 
 #include <vector>
 #include <string>
+#include "serialization/compression.hpp"
 #include "serialization/string_utils.hpp"
+#include "serialization/tokenizer.hpp"
 #include "serialization/unicode.hpp"
 #include <boost/test/auto_unit_test.hpp>
 
+#include <sstream>
+
 BOOST_AUTO_TEST_SUITE ( test_serialization_utils_and_unicode )
 
 BOOST_AUTO_TEST_CASE( utils_join_test )
@@ -123,4 +127,61 @@ BOOST_AUTO_TEST_CASE( test_wildcard_string_match )
 	BOOST_CHECK(!utils::wildcard_string_match("", "???"));
 }
 
+BOOST_AUTO_TEST_CASE( test_tokenizer_runs )
+{
+	// Runs longer than the input buffer, so that the bulk scans cross its end.
+	const std::string name(3000, 'a');
+	const std::string text(2500, 'x');
+	std::ostringstream wml;
+	wml << "  \t" << name << "\tkey=\"" << text << "\r\n" << text << "\"\"q\xfeline 7 file.cfg\n" << text << "\"\n"
+	    << "# comment " << text << "\n"
+	    << "raw=<<" << text << ">" << text << ">>\n"
+	    << "\xfetextdomain wesnoth-test\nlast\n";
+	std::istringstream in(wml.str());
+	tokenizer tok(in);
+
+	BOOST_CHECK_EQUAL(tok.next_token().type, token::STRING);
+	BOOST_CHECK_EQUAL(tok.current_token().value, name);
+	BOOST_CHECK_EQUAL(tok.next_token().value, "key");
+	BOOST_CHECK_EQUAL(tok.next_token().type, token::EQUALS);
+	BOOST_CHECK_EQUAL(tok.next_token().type, token::QSTRING);
+	// The carriage return is dropped, the doubled quote kept once, and
+	// the comment in the string changes the line and file.
+	BOOST_CHECK_EQUAL(tok.current_token().value, text + "\n" + text + "\"q" + text);
+	BOOST_CHECK_EQUAL(tok.get_start_line(), 1);
+	BOOST_CHECK_EQUAL(tok.get_file(), "file.cfg");
+	BOOST_CHECK_EQUAL(tok.next_token().type, token::LF);
+	BOOST_CHECK_EQUAL(tok.get_start_line(), 7);
+	BOOST_CHECK_EQUAL(tok.next_token().type, token::LF);
+	BOOST_CHECK_EQUAL(tok.get_start_line(), 8);
+	BOOST_CHECK_EQUAL(tok.next_token().value, "raw");
+	BOOST_CHECK_EQUAL(tok.next_token().type, token::EQUALS);
+	BOOST_CHECK_EQUAL(tok.next_token().type, token::QSTRING);
+	BOOST_CHECK_EQUAL(tok.current_token().value, text + ">" + text);
+	BOOST_CHECK_EQUAL(tok.next_token().type, token::LF);
+	BOOST_CHECK_EQUAL(tok.next_token().value, "last");
+	BOOST_CHECK_EQUAL(tok.textdomain(), "wesnoth-test");
+	BOOST_CHECK_EQUAL(tok.next_token().type, token::LF);
+	BOOST_CHECK_EQUAL(tok.next_token().type, token::END);
+}
+
+BOOST_AUTO_TEST_CASE( test_detect_compression )
+{
+	std::istringstream gzip(std::string("\x1f\x8b\x08\x00", 4));
+	BOOST_CHECK_EQUAL(compression::detect_format(gzip), compression::GZIP);
+	BOOST_CHECK_EQUAL(gzip.get(), 0x1f);
+
+	std::istringstream bzip2("BZh91AY&SY");
+	BOOST_CHECK_EQUAL(compression::detect_format(bzip2), compression::BZIP2);
+	BOOST_CHECK_EQUAL(bzip2.get(), 'B');
+
+	std::istringstream text("[campaign]\n");
+	BOOST_CHECK_EQUAL(compression::detect_format(text), compression::NONE);
+	BOOST_CHECK_EQUAL(text.get(), '[');
+
+	std::istringstream short_text("B");
+	BOOST_CHECK_EQUAL(compression::detect_format(short_text), compression::NONE);
+	BOOST_CHECK_EQUAL(short_text.get(), 'B');
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,137 @@
+/*
+   Copyright (C) 2015 by the Battle for Wesnoth Project
+   Part of the Battle for Wesnoth Project http://www.wesnoth.org/
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY.
+
+   See the COPYING file for more details.
+*/
+
+#define GETTEXT_DOMAIN "wesnoth-test"
+
+#include <boost/test/unit_test.hpp>
+
+#include "thread.hpp"
+
+#include <stdexcept>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE( thread )
+
+namespace {
+
+struct squares : public threading::parallel_job
+{
+	squares(size_t count) : results(count, 0) {}
+
+	void run(size_t index)
+	{
+		results[index] = index * index;
+	}
+
+	std::vector<size_t> results;
+};
+
+/** Sums squares computed by a nested run_parallel(). */
+struct sums : public threading::parallel_job
+{
+	sums(size_t count) : results(count, 0) {}
+
+	void run(size_t index)
+	{
+		squares inner(index);
+		threading::run_parallel(inner, index);
+		for(size_t i = 0; i != index; ++i) {
+			results[index] += inner.results[i];
+		}
+	}
+
+	std::vector<size_t> results;
+};
+
+struct failing_once : public threading::parallel_job
+{
+	failing_once() : failures(0), fail_index(0), guard() {}
+
+	void run(size_t index)
+	{
+		const threading::lock l(guard);
+		if(index == fail_index && failures == 0) {
+			++failures;
+			throw std::runtime_error("failing once");
+		}
+	}
+
+	int failures;
+	size_t fail_index;
+	threading::mutex guard;
+};
+
+struct answer_task : public threading::pooled_task
+{
+	answer_task() : answer(0) {}
+	~answer_task() { wait(); }
+
+	void run() { answer = 42; }
+
+	int answer;
+};
+
+void check_pool()
+{
+	squares job(1000);
+	threading::run_parallel(job, job.results.size());
+	for(size_t i = 0; i != job.results.size(); ++i) {
+		BOOST_CHECK_EQUAL( job.results[i], i * i );
+	}
+
+	sums nested(50);
+	threading::run_parallel(nested, nested.results.size());
+	for(size_t i = 0; i != nested.results.size(); ++i) {
+		BOOST_CHECK_EQUAL( nested.results[i], i == 0 ? 0 : (i - 1) * i * (2 * i - 1) / 6 );
+	}
+
+	answer_task tasks[10];
+	for(size_t i = 0; i != 10; ++i) {
+		tasks[i].start();
+	}
+	for(size_t i = 0; i != 10; ++i) {
+		tasks[i].wait();
+		BOOST_CHECK( tasks[i].finished() );
+		BOOST_CHECK_EQUAL( tasks[i].answer, 42 );
+	}
+
+	answer_task never_started;
+	never_started.wait();
+	BOOST_CHECK_EQUAL( never_started.answer, 42 );
+}
+
+}
+
+BOOST_AUTO_TEST_CASE( test_run_parallel )
+{
+	threading::set_thread_count(4);
+	BOOST_CHECK_EQUAL( threading::hardware_concurrency(), 4u );
+	check_pool();
+	threading::set_thread_count(0);
+}
+
+BOOST_AUTO_TEST_CASE( test_single_threaded )
+{
+	threading::set_thread_count(1);
+	BOOST_CHECK_EQUAL( threading::hardware_concurrency(), 1u );
+	check_pool();
+
+	// Everything runs in order on this thread, so the exception comes here.
+	failing_once job;
+	job.fail_index = 3;
+	BOOST_CHECK_THROW( threading::run_parallel(job, 10), std::runtime_error );
+	threading::set_thread_count(0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -290,6 +290,46 @@ BOOST_AUTO_TEST_CASE( track_fake_unit_by_iterator ) {
 	BOOST_CHECK(unit_iterator == unit_iterator2);
 }
 
+BOOST_AUTO_TEST_CASE( track_units_by_side_and_radius ) {
+
+	config game_config(test_utils::get_test_config());
+
+	config orc_config;
+	orc_config["id"]="Orcish Grunt";
+	orc_config["random_traits"] = false;
+	orc_config["animate"]=false;
+	unit_type orc_type(orc_config);
+
+	unit_types.build_unit_type(orc_type, unit_type::FULL);
+
+	unit orc_side1(orc_type, 1, true);
+	unit orc_side2(orc_type, 2, true);
+
+	unit_map unit_map;
+	unit_map.add(map_location(1,1), orc_side1);
+	unit_map.add(map_location(2,1), orc_side1);
+	unit_map.add(map_location(9,9), orc_side2);
+
+	BOOST_CHECK_EQUAL(unit_map.units_of_side(1).size(), 2);
+	BOOST_CHECK_EQUAL(unit_map.units_of_side(2).size(), 1);
+	BOOST_CHECK(unit_map.units_of_side(3).empty());
+	BOOST_CHECK(unit_map.find_leader(1) == unit_map.end());
+
+	unit_map.find(map_location(2,1))->set_can_recurit(true);
+	BOOST_CHECK(unit_map.find_leader(1) == unit_map.find(map_location(2,1)));
+
+	unit_map.find(map_location(9,9))->set_side(1);
+	BOOST_CHECK_EQUAL(unit_map.units_of_side(1).size(), 3);
+	BOOST_CHECK(unit_map.units_of_side(2).empty());
+
+	unit_map.erase(map_location(1,1));
+	BOOST_CHECK_EQUAL(unit_map.units_of_side(1).size(), 2);
+
+	BOOST_CHECK_EQUAL(unit_map.units_in_radius(map_location(1,1), 1).size(), 1);
+	BOOST_CHECK_EQUAL(unit_map.units_in_radius(map_location(1,1), 10).size(), 2);
+	BOOST_CHECK(unit_map.units_in_radius(map_location(5,5), 2).empty());
+}
+
 /* vim: set ts=4 sw=4: */
 BOOST_AUTO_TEST_SUITE_END()
 
@@ -16,6 +16,7 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include "hash.hpp"
 #include "util.hpp"
 
 #include <boost/cstdint.hpp>
@@ -140,6 +141,21 @@ BOOST_AUTO_TEST_CASE( test_count_leading_ones )
 	BOOST_CHECK( count_leading_ones(static_cast<boost::uint16_t>(54321)) == 2 );
 }
 
+BOOST_AUTO_TEST_CASE( test_content_hash )
+{
+	// The reference values of XXH64.
+	BOOST_CHECK( util::content_hash("") == ((boost::uint64_t(0xEF46DB37) << 32) | 0x51D8E999) );
+	BOOST_CHECK( util::content_hash("a") == ((boost::uint64_t(0xD24EC4F1) << 32) | 0xA98C6E5B) );
+	BOOST_CHECK( util::content_hash("abc") == ((boost::uint64_t(0x44BC2CF5) << 32) | 0xAD770999) );
+	BOOST_CHECK_EQUAL( util::content_hash_hex("Nobody inspects the spammish repetition"),
+		"fbcea83c8a378bf1" );
+
+	const std::string long_data(1000, 'x');
+	BOOST_CHECK( util::content_hash(long_data) != util::content_hash(long_data.substr(1)) );
+	BOOST_CHECK( util::content_hash(long_data.data(), long_data.size(), 1)
+		!= util::content_hash(long_data) );
+}
+
 /* vim: set ts=4 sw=4: */
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -28,6 +28,8 @@
 
 #include <boost/make_shared.hpp>
 
+#include <cstdlib>
+
 #if !SDL_VERSION_ATLEAST(2, 0, 0)
 namespace test_utils {
 	play_scenario::play_scenario(const std::string& id) :
@@ -136,3 +138,32 @@ namespace test_utils {
 
 }
 #endif
+
+namespace test_utils {
+	play_ai_scenario::play_ai_scenario(const config& scenario) :
+		game_config_(get_test_config_ref()),
+		tdata_(boost::make_shared<terrain_type_data>(game_config_)),
+		state_(new saved_game())
+	{
+		state_->classification().campaign_type = game_classification::TEST;
+		state_->classification().random_mode = "deterministic";
+		state_->set_scenario(scenario);
+	}
+
+	play_ai_scenario::~play_ai_scenario()
+	{
+	}
+
+	void play_ai_scenario::play(int seed)
+	{
+		std::srand(seed);
+		state_->set_random_seed(seed);
+		play_game(get_fake_display(1024, 768), *state_, game_config_, tdata_,
+			IO_SERVER, false, false, false, true);
+	}
+
+	const saved_game& play_ai_scenario::get_state() const
+	{
+		return *state_;
+	}
+}
@@ -23,6 +23,7 @@
 #include <boost/shared_ptr.hpp>
 
 class config;
+class saved_game;
 class terrain_type_data;
 
 #if !SDL_VERSION_ATLEAST(2, 0, 0)
@@ -94,4 +95,34 @@ namespace test_utils {
 }
 
 #endif
+
+namespace test_utils {
+
+	/**
+	 * Plays a scenario whose sides are all under the AI, with no input at
+	 * all, for the benchmarks.
+	 *
+	 * The scenario must end by itself, without any dialog to close: with
+	 * victory_when_enemies_defeated=no and a time over event ending the
+	 * level with carryover_report=no, say. The synced randomness and the
+	 * rand() of the AI are both seeded, so that a build plays the same game
+	 * each time.
+	 **/
+	class play_ai_scenario {
+		const config& game_config_;
+		const boost::shared_ptr<terrain_type_data> tdata_;
+		boost::scoped_ptr<saved_game> state_;
+		public:
+			/** @param scenario The [test] to play; it need not be in the game config. */
+			explicit play_ai_scenario(const config& scenario);
+			~play_ai_scenario();
+
+			/** Plays the scenario once, @a seed seeding the randomness. */
+			void play(int seed);
+
+			/** The state at the end of the game, with its replay. */
+			const saved_game& get_state() const;
+	};
+}
+
 #endif
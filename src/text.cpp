@@ -29,6 +29,8 @@
 
 #include <cassert>
 #include <cstring>
+#include <list>
+#include <map>
 
 #if SDL_VERSION_ATLEAST(2,0,0)
 #include "video.hpp"
@@ -589,6 +591,95 @@ std::ostream& operator<<(std::ostream& s, const PangoRectangle &rect)
 	return s;
 }
 
+/** The properties of a ttext which determine its rendered surface. */
+struct trendered_key
+{
+	std::string font_families;
+	std::string text;
+	bool markedup;
+	bool link_aware;
+	std::string link_color;
+	unsigned font_size;
+	unsigned font_style;
+	Uint32 foreground_color;
+	int maximum_width;
+	unsigned characters_per_line;
+	int maximum_height;
+	PangoEllipsizeMode ellipse_mode;
+	PangoAlignment alignment;
+
+	bool operator<(const trendered_key& k) const
+	{
+		if(text != k.text) return text < k.text;
+		if(font_size != k.font_size) return font_size < k.font_size;
+		if(font_style != k.font_style) return font_style < k.font_style;
+		if(foreground_color != k.foreground_color) return foreground_color < k.foreground_color;
+		if(maximum_width != k.maximum_width) return maximum_width < k.maximum_width;
+		if(maximum_height != k.maximum_height) return maximum_height < k.maximum_height;
+		if(characters_per_line != k.characters_per_line) return characters_per_line < k.characters_per_line;
+		if(markedup != k.markedup) return markedup < k.markedup;
+		if(link_aware != k.link_aware) return link_aware < k.link_aware;
+		if(ellipse_mode != k.ellipse_mode) return ellipse_mode < k.ellipse_mode;
+		if(alignment != k.alignment) return alignment < k.alignment;
+		if(link_color != k.link_color) return link_color < k.link_color;
+		return font_families < k.font_families;
+	}
+};
+
+struct trendered_text
+{
+	surface surf;
+#ifdef SDL_GPU
+	sdl::timage texture;
+#endif
+};
+
+/**
+ * The surfaces rendered last, so texts shown again with the same properties,
+ * like the labels of dialogs opened again, skip the layout and rendering.
+ */
+class trendered_cache
+{
+public:
+	/** Returns the text rendered for @a key, NULL if it isn't cached. */
+	const trendered_text* find(const trendered_key& key)
+	{
+		const tindex::iterator itor = index_.find(key);
+		if(itor == index_.end()) {
+			return NULL;
+		}
+		texts_.splice(texts_.begin(), texts_, itor->second);
+		return &itor->second->second;
+	}
+
+	void add(const trendered_key& key, const trendered_text& text)
+	{
+		if(index_.count(key)) {
+			return;
+		}
+		if(texts_.size() >= max_size) {
+			index_.erase(texts_.back().first);
+			texts_.pop_back();
+		}
+		texts_.push_front(std::make_pair(key, text));
+		index_[key] = texts_.begin();
+	}
+
+	/** Bigger texts, like help pages, are not worth keeping. */
+	static const int max_area = 512 * 512;
+
+private:
+	static const size_t max_size = 200;
+
+	typedef std::list<std::pair<trendered_key, trendered_text> > tlist;
+	typedef std::map<trendered_key, tlist::iterator> tindex;
+
+	tlist texts_;
+	tindex index_;
+};
+
+trendered_cache rendered_cache;
+
 } // namespace
 
 void ttext::recalculate(const bool force) const
@@ -732,6 +823,32 @@ void ttext::rerender(const bool force) const
 	if(surface_dirty_ || force) {
 		assert(layout_);
 
+		trendered_key key;
+		key.font_families = get_font_families();
+		key.text = text_;
+		key.markedup = markedup_text_;
+		key.link_aware = link_aware_;
+		key.link_color = link_color_;
+		key.font_size = font_size_;
+		key.font_style = font_style_;
+		key.foreground_color = foreground_color_;
+		key.maximum_width = maximum_width_;
+		key.characters_per_line = characters_per_line_;
+		key.maximum_height = maximum_height_;
+		key.ellipse_mode = ellipse_mode_;
+		key.alignment = alignment_;
+
+		// The layout is only recalculated once its size is asked for.
+		const trendered_text* cached = force ? NULL : rendered_cache.find(key);
+		if(cached) {
+			surface_ = cached->surf;
+#ifdef SDL_GPU
+			texture_ = cached->texture;
+#endif
+			surface_dirty_ = false;
+			return;
+		}
+
 		recalculate(force);
 		surface_dirty_ = false;
 
@@ -783,6 +900,18 @@ void ttext::rerender(const bool force) const
 #endif
 		cairo_destroy(cr);
 		cairo_surface_destroy(cairo_surface);
+
+		// surface_ uses the buffer of this object, the cache needs a copy.
+		if(width * height <= trendered_cache::max_area) {
+			trendered_text text;
+			text.surf = make_neutral_surface(surface_);
+#ifdef SDL_GPU
+			text.texture = texture_;
+#endif
+			if(text.surf) {
+				rendered_cache.add(key, text);
+			}
+		}
 	}
 }
 
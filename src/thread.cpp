@@ -14,11 +14,17 @@
 
 #include "global.hpp"
 
+#include <algorithm>
+#include <cassert>
+#include <list>
 #include <vector>
 
+#include <boost/ptr_container/ptr_vector.hpp>
+
 #include "log.hpp"
 #include "thread.hpp"
 
+#include "SDL_cpuinfo.h"
 #include "SDL_mutex.h"
 #include "SDL_thread.h"
 #include "SDL_version.h"
@@ -145,6 +151,281 @@ bool condition::notify_all()
 	return true;
 }
 
+namespace {
+
+/** State shared by the threads of a single run_parallel() call, guarded by pool_guard. */
+struct parallel_run
+{
+	parallel_run(parallel_job& j, size_t n, size_t helpers)
+		: job(j), count(n), next(0), max_helpers(helpers), helping(0), failed()
+	{}
+
+	bool wants_help() const
+	{
+		return next < count && helping < max_helpers;
+	}
+
+	parallel_job& job;
+	const size_t count;
+	/** The next index to hand out. */
+	size_t next;
+	/** The number of indices the workers may run at the same time. */
+	const size_t max_helpers;
+	/** The number of indices the workers are running. */
+	size_t helping;
+	/** Indices whose run() threw on a worker thread. */
+	std::vector<size_t> failed;
+};
+
+/** The count given to set_thread_count(). */
+unsigned thread_count = 0;
+
+mutex pool_guard;
+/** Signalled when work is queued, or when the workers are to stop. */
+condition work_queued;
+/** Signalled when a worker is done with an index or a task. */
+condition work_done;
+std::list<parallel_run*> pending_runs;
+std::list<pooled_task*> pending_tasks;
+boost::ptr_vector<thread> workers;
+bool stopping = false;
+
+}
+
+/** The shared pool of worker threads. */
+struct pool
+{
+	/** Makes sure there are at least @a count workers; pool_guard must be held. */
+	static void start_workers(size_t count)
+	{
+		while(workers.size() < count) {
+			workers.push_back(new thread(&pool::worker));
+		}
+	}
+
+	static void stop_workers()
+	{
+		{
+			const lock l(pool_guard);
+			stopping = true;
+			work_queued.notify_all();
+		}
+		// The joining is done without the lock, which the workers need.
+		workers.clear();
+		const lock l(pool_guard);
+		stopping = false;
+	}
+
+	/** Waits for the workers to be done with @a run, and forgets it. */
+	static void finish(parallel_run& run)
+	{
+		const lock l(pool_guard);
+		while(run.helping != 0) {
+			work_done.wait(pool_guard);
+		}
+		pending_runs.remove(&run);
+	}
+
+	static int worker(void*)
+	{
+		for(;;) {
+			parallel_run* run = NULL;
+			pooled_task* task = NULL;
+			size_t index = 0;
+			{
+				const lock l(pool_guard);
+				for(;;) {
+					if(stopping) {
+						return 0;
+					}
+					for(std::list<parallel_run*>::const_iterator i = pending_runs.begin();
+							i != pending_runs.end() && !run; ++i) {
+						if((*i)->wants_help()) {
+							run = *i;
+						}
+					}
+					if(run || !pending_tasks.empty()) {
+						break;
+					}
+					work_queued.wait(pool_guard);
+				}
+				if(run) {
+					index = run->next++;
+					++run->helping;
+				} else {
+					task = pending_tasks.front();
+					pending_tasks.pop_front();
+					task->state_ = pooled_task::RUNNING;
+				}
+			}
+
+			bool ok = true;
+			try {
+				if(run) {
+					run->job.run(index);
+				} else {
+					task->run();
+				}
+			} catch(...) {
+				ok = false;
+			}
+
+			// The owners may go as soon as the lock is released.
+			const lock l(pool_guard);
+			if(run) {
+				if(!ok) {
+					run->failed.push_back(index);
+				}
+				--run->helping;
+			} else {
+				task->state_ = ok ? pooled_task::FINISHED : pooled_task::FAILED;
+			}
+			work_done.notify_all();
+		}
+	}
+
+	static void run_here(pooled_task& task)
+	{
+		try {
+			task.run();
+		} catch(...) {
+			const lock l(pool_guard);
+			task.state_ = pooled_task::FAILED;
+			throw;
+		}
+		const lock l(pool_guard);
+		task.state_ = pooled_task::FINISHED;
+	}
+
+	static void wait(pooled_task& task)
+	{
+		{
+			const lock l(pool_guard);
+			while(task.state_ == pooled_task::RUNNING) {
+				work_done.wait(pool_guard);
+			}
+			if(task.state_ == pooled_task::FINISHED) {
+				return;
+			}
+			if(task.state_ == pooled_task::QUEUED) {
+				pending_tasks.remove(&task);
+			}
+			task.state_ = pooled_task::RUNNING;
+		}
+		run_here(task);
+	}
+};
+
+namespace {
+
+/** Stops the workers at exit, before the state they share goes. */
+struct pool_stopper
+{
+	~pool_stopper()
+	{
+		pool::stop_workers();
+	}
+} stopper;
+
+}
+
+unsigned hardware_concurrency()
+{
+	if(thread_count != 0) {
+		return thread_count;
+	}
+	const int count = SDL_GetCPUCount();
+	return count > 1 ? count : 1;
+}
+
+void set_thread_count(unsigned count)
+{
+	thread_count = count;
+	pool::stop_workers();
+}
+
+void run_parallel(parallel_job& job, size_t count, unsigned max_threads)
+{
+	if(max_threads == 0) {
+		max_threads = hardware_concurrency();
+	}
+	const size_t helpers = std::min<size_t>(max_threads, count) - (count > 0 ? 1 : 0);
+	if(helpers == 0) {
+		for(size_t i = 0; i != count; ++i) {
+			job.run(i);
+		}
+		return;
+	}
+
+	parallel_run run(job, count, helpers);
+	{
+		const lock l(pool_guard);
+		pool::start_workers(std::max<size_t>(helpers, hardware_concurrency() - 1));
+		pending_runs.push_back(&run);
+		work_queued.notify_all();
+	}
+
+	// The calling thread takes its share of the work too. Exceptions are
+	// not caught here, but the workers must be done with the run before
+	// they propagate.
+	try {
+		for(;;) {
+			size_t index;
+			{
+				const lock l(pool_guard);
+				if(run.next == run.count) {
+					break;
+				}
+				index = run.next++;
+			}
+			job.run(index);
+		}
+	} catch(...) {
+		pool::finish(run);
+		throw;
+	}
+	pool::finish(run);
+
+	std::sort(run.failed.begin(), run.failed.end());
+	for(std::vector<size_t>::const_iterator i = run.failed.begin(); i != run.failed.end(); ++i) {
+		job.run(*i);
+	}
+}
+
+pooled_task::pooled_task()
+	: state_(IDLE)
+{
+}
+
+pooled_task::~pooled_task()
+{
+	assert(state_ != QUEUED && state_ != RUNNING);
+}
+
+void pooled_task::start()
+{
+	const lock l(pool_guard);
+	assert(state_ != QUEUED && state_ != RUNNING);
+	state_ = QUEUED;
+	const unsigned threads = hardware_concurrency();
+	if(threads > 1) {
+		pool::start_workers(threads - 1);
+	}
+	pending_tasks.push_back(this);
+	work_queued.notify_one();
+}
+
+void pooled_task::wait()
+{
+	pool::wait(*this);
+}
+
+bool pooled_task::finished() const
+{
+	const lock l(pool_guard);
+	return state_ == FINISHED;
+}
+
 bool async_operation::notify_finished()
 {
 	finishedVar_ = true;
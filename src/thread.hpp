@@ -15,6 +15,7 @@
 #ifndef THREAD_HPP_INCLUDED
 #define THREAD_HPP_INCLUDED
 
+#include <cstddef>
 #include <list>
 
 #include <boost/cstdint.hpp>
@@ -190,6 +191,78 @@ private:
 	SDL_cond* const cond_;
 };
 
+// Work item for run_parallel().
+//
+// run() is called once for every index handed out by run_parallel(),
+// possibly from several threads at the same time. It must therefore only
+// touch state that belongs to that index (or is guarded by a mutex), and
+// it must be safe to call again for an index whose previous run() threw.
+class parallel_job
+{
+public:
+	virtual ~parallel_job() {}
+	virtual void run(size_t index) = 0;
+};
+
+// The number of threads worth using for CPU bound work (at least 1): the
+// count given to set_thread_count(), or the number of processors.
+unsigned hardware_concurrency();
+
+// Sets the number of threads of the shared pool, the calling thread
+// included; 0 means the number of processors. With 1, all the work is done
+// on the thread asking for it, in order, as is best for debugging.
+//
+// The workers are started when first needed; those there are stop once
+// they finished what they are doing.
+void set_thread_count(unsigned count);
+
+// Calls job.run(i) for every i in [0, count) and returns once all of them
+// have finished. The work is spread over at most max_threads threads, the
+// calling thread included; 0 means hardware_concurrency().
+//
+// The indices are handed out one by one to the calling thread and to the
+// idle workers of the shared pool, so the results only depend on the
+// indices, not on the threads. A job may call run_parallel() again. Only a
+// max_threads over hardware_concurrency(), for work waiting on the
+// network, starts threads of its own.
+//
+// Indices whose run() threw on a worker thread are repeated on the calling
+// thread after the workers have finished, so that exceptions reach the
+// caller in the usual way.
+void run_parallel(parallel_job& job, size_t count, unsigned max_threads = 0);
+
+// Work done by the shared pool while the thread starting it does something
+// else; wait() is the future.
+//
+// Whichever comes first runs it: an idle worker, or wait(). So it is run
+// even with a single thread, or when all the workers are busy. wait() must
+// be called before the task is destroyed; the destructor of a derived
+// class is the place for it.
+class pooled_task
+	: private boost::noncopyable
+{
+public:
+	pooled_task();
+	virtual ~pooled_task();
+
+	// Queues the task for the workers. It must not be queued already.
+	void start();
+
+	// Returns once the task has been run, running it on this thread if no
+	// worker took it. If it threw on a worker, it is run again here, for
+	// the exception to reach the caller.
+	void wait();
+
+	bool finished() const;
+
+private:
+	virtual void run() = 0;
+
+	friend struct pool;
+	enum STATE { IDLE, QUEUED, RUNNING, FAILED, FINISHED };
+	STATE state_;
+};
+
 //class which defines an interface for waiting on an asynchronous operation
 class waiter {
 public:
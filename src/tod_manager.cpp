@@ -41,6 +41,7 @@ tod_manager::tod_manager(const config& scenario_cfg):
 	currentTime_(0),
 	times_(),
 	areas_(),
+	illumination_(),
 	turn_(scenario_cfg["turn_at"].to_int(1)),
 	num_turns_(scenario_cfg["turns"].to_int(-1))
 {
@@ -62,9 +63,11 @@ tod_manager& tod_manager::operator=(const tod_manager& manager)
 		return *this;
 	}
 
+	unit::clear_ability_cache();
 	currentTime_ = manager.currentTime_;
 	times_ = manager.times_;
 	areas_ = manager.areas_;
+	illumination_ = illumination_cache();
 
 	turn_ = manager.turn_;
 	num_turns_ = manager.num_turns_;
@@ -86,6 +89,7 @@ struct greater
 
 void tod_manager::resolve_random(random_new::rng& r)
 {
+	unit::clear_ability_cache();
 	//process the random_start_time string, which can be boolean yes/no true/false or a
 	//comma-separated string of integers >= 1 referring to the times_ array indices
 	std::vector<int> output;
@@ -161,6 +165,20 @@ int tod_manager::get_current_time(const map_location& loc) const
 	return currentTime_;
 }
 
+void tod_manager::set_current_time(int time)
+{
+	unit::clear_ability_cache();
+	currentTime_ = time;
+}
+
+void tod_manager::set_current_time(int time, int area_index)
+{
+	unit::clear_ability_cache();
+	assert(area_index < static_cast<int>(areas_.size()));
+	assert(time < static_cast<int>(areas_[area_index].times.size()) );
+	areas_[area_index].currentTime = time;
+}
+
 const std::vector<time_of_day>& tod_manager::times(const map_location& loc) const
 {
 	if ( loc != map_location::null_location() ) {
@@ -193,66 +211,113 @@ const time_of_day& tod_manager::get_time_of_day(const map_location& loc, int n_t
 	return get_time_of_day_turn(times_, n_turn, currentTime_);
 }
 
-const time_of_day tod_manager::get_illuminated_time_of_day(const unit_map & units, const gamemap & map, const map_location& loc, int for_turn) const
+int tod_manager::illuminated_bonus(const unit_map & units, const gamemap & map, const map_location& loc, const time_of_day& tod) const
 {
-	// get ToD ignoring illumination
-	time_of_day tod = get_time_of_day(loc, for_turn);
+	// Now add terrain illumination.
+	const int terrain_light = map.get_terrain_info(loc).light_bonus(tod.lawful_bonus);
+
+	std::vector<int> mod_list;
+	std::vector<int> max_list;
+	std::vector<int> min_list;
+	int most_add = 0;
+	int most_sub = 0;
+
+	// Find the "illuminates" effects from units that can affect loc.
+	map_location locs[7];
+	locs[0] = loc;
+	get_adjacent_tiles(loc,locs+1);
+	for ( size_t i = 0; i != 7; ++i ) {
+		const unit_map::const_iterator itor = units.find(locs[i]);
+		if (itor != units.end() &&
+		    itor->get_ability_bool("illuminates") &&
+		    !itor->incapacitated())
+		{
+			unit_ability_list illum = itor->get_abilities("illuminates");
+			unit_abilities::effect illum_effect(illum, terrain_light, false);
+			const int unit_mod = illum_effect.get_composite_value();
+
+			// Record this value.
+			mod_list.push_back(unit_mod);
+			max_list.push_back(illum.highest("max_value").first);
+			min_list.push_back(illum.lowest("min_value").first);
+			if ( unit_mod > most_add )
+				most_add = unit_mod;
+			else if ( unit_mod < most_sub )
+				most_sub = unit_mod;
+		}
+	}
+	const bool net_darker = most_add < -most_sub;
+
+	// Apply each unit's effect, tracking the best result.
+	int best_result = terrain_light;
+	const int base_light = terrain_light + (net_darker ? most_add : most_sub);
+	for ( size_t i = 0; i != mod_list.size(); ++i ) {
+		int result =
+			bounded_add(base_light, mod_list[i], max_list[i], min_list[i]);
+
+		if ( net_darker  &&  result < best_result )
+			best_result = result;
+		else if ( !net_darker  &&  result > best_result )
+			best_result = result;
+	}
+
+	return best_result;
+}
 
-	if ( map.on_board_with_border(loc) )
+tod_manager::illumination_cache::hex& tod_manager::illumination_entry(const unit_map & units, const gamemap & map, const map_location& loc) const
+{
+	illumination_cache& cache = illumination_;
+	if (cache.units != &units || cache.map != &map || cache.map_revision != map.revision() ||
+	    cache.generation != unit::ability_generation() || cache.turn != turn_)
 	{
-		// Now add terrain illumination.
-		const int terrain_light = map.get_terrain_info(loc).light_bonus(tod.lawful_bonus);
-
-		std::vector<int> mod_list;
-		std::vector<int> max_list;
-		std::vector<int> min_list;
-		int most_add = 0;
-		int most_sub = 0;
-
-		// Find the "illuminates" effects from units that can affect loc.
-		map_location locs[7];
-		locs[0] = loc;
-		get_adjacent_tiles(loc,locs+1);
-		for ( size_t i = 0; i != 7; ++i ) {
-			const unit_map::const_iterator itor = units.find(locs[i]);
-			if (itor != units.end() &&
-			    itor->get_ability_bool("illuminates") &&
-			    !itor->incapacitated())
-			{
-				unit_ability_list illum = itor->get_abilities("illuminates");
-				unit_abilities::effect illum_effect(illum, terrain_light, false);
-				const int unit_mod = illum_effect.get_composite_value();
-
-				// Record this value.
-				mod_list.push_back(unit_mod);
-				max_list.push_back(illum.highest("max_value").first);
-				min_list.push_back(illum.lowest("min_value").first);
-				if ( unit_mod > most_add )
-					most_add = unit_mod;
-				else if ( unit_mod < most_sub )
-					most_sub = unit_mod;
-			}
-		}
-		const bool net_darker = most_add < -most_sub;
-
-		// Apply each unit's effect, tracking the best result.
-		int best_result = terrain_light;
-		const int base_light = terrain_light + (net_darker ? most_add : most_sub);
-		for ( size_t i = 0; i != mod_list.size(); ++i ) {
-			int result =
-				bounded_add(base_light, mod_list[i], max_list[i], min_list[i]);
-
-			if ( net_darker  &&  result < best_result )
-				best_result = result;
-			else if ( !net_darker  &&  result > best_result )
-				best_result = result;
-		}
+		cache.units = &units;
+		cache.map = &map;
+		cache.map_revision = map.revision();
+		cache.generation = unit::ability_generation();
+		cache.turn = turn_;
+		cache.width = map.w() + 2 * map.border_size();
+		cache.hexes.assign(cache.width * (map.h() + 2 * map.border_size()), illumination_cache::hex());
+	}
+
+	const int border = map.border_size();
+	return cache.hexes[(loc.y + border) * cache.width + loc.x + border];
+}
 
-		// Update the object we will return.
+const time_of_day tod_manager::get_illuminated_time_of_day(const unit_map & units, const gamemap & map, const map_location& loc, int for_turn) const
+{
+	if ( !map.on_board_with_border(loc) )
+		return get_time_of_day(loc, for_turn);
+
+	// Only the current turn is cached, the others being seldom asked for.
+	if ( for_turn != 0 && for_turn != turn_ ) {
+		time_of_day tod = get_time_of_day(loc, for_turn);
+		const int best_result = illuminated_bonus(units, map, loc, tod);
 		tod.bonus_modified = best_result - tod.lawful_bonus;
 		tod.lawful_bonus = best_result;
+		return tod;
+	}
+
+	const illumination_cache::hex& cached = illumination_entry(units, map, loc);
+	if ( cached.tod != NULL ) {
+		time_of_day tod = *cached.tod;
+		tod.bonus_modified = cached.lawful_bonus - tod.lawful_bonus;
+		tod.lawful_bonus = cached.lawful_bonus;
+		return tod;
+	}
+
+	// The ability filters may look up other hexes, or change the game state.
+	const unsigned generation = unit::ability_generation();
+	time_of_day tod = get_time_of_day(loc);
+	const int best_result = illuminated_bonus(units, map, loc, tod);
+	if ( unit::ability_generation() == generation ) {
+		illumination_cache::hex& hex = illumination_entry(units, map, loc);
+		hex.tod = &get_time_of_day(loc);
+		hex.lawful_bonus = best_result;
 	}
 
+	// Update the object we will return.
+	tod.bonus_modified = best_result - tod.lawful_bonus;
+	tod.lawful_bonus = best_result;
 	return tod;
 }
 
@@ -265,6 +330,7 @@ bool tod_manager::is_start_ToD(const std::string& random_start_time)
 
 void tod_manager::replace_schedule(const config& time_cfg)
 {
+	unit::clear_ability_cache();
 	times_.clear();
 	time_of_day::parse_times(time_cfg,times_);
 	currentTime_ = time_cfg["current_time"].to_int(0);
@@ -272,17 +338,20 @@ void tod_manager::replace_schedule(const config& time_cfg)
 
 void tod_manager::replace_schedule(const std::vector<time_of_day>& schedule)
 {
+	unit::clear_ability_cache();
 	times_ = schedule;
 	currentTime_ = 0;
 }
 
 void tod_manager::replace_area_locations(int area_index, const std::set<map_location>& locs) {
+	unit::clear_ability_cache();
 	assert(area_index < static_cast<int>(areas_.size()));
 	areas_[area_index].hexes = locs;
 }
 
 void tod_manager::replace_local_schedule(const std::vector<time_of_day>& schedule, int area_index)
 {
+	unit::clear_ability_cache();
 	assert(area_index < static_cast<int>(areas_.size()));
 	areas_[area_index].times = schedule;
 	areas_[area_index].currentTime = 0;
@@ -318,6 +387,7 @@ const std::set<map_location>& tod_manager::get_area_by_index(int index) const
 
 void tod_manager::add_time_area(const gamemap & map, const config& cfg)
 {
+	unit::clear_ability_cache();
 	areas_.push_back(area_time_of_day());
 	area_time_of_day &area = areas_.back();
 	area.id = cfg["id"].str();
@@ -332,6 +402,7 @@ void tod_manager::add_time_area(const gamemap & map, const config& cfg)
 void tod_manager::add_time_area(const std::string& id, const std::set<map_location>& locs,
 		const config& time_cfg)
 {
+	unit::clear_ability_cache();
 	areas_.push_back(area_time_of_day());
 	area_time_of_day& area = areas_.back();
 	area.id = id;
@@ -342,6 +413,7 @@ void tod_manager::add_time_area(const std::string& id, const std::set<map_locati
 
 void tod_manager::remove_time_area(const std::string& area_id)
 {
+	unit::clear_ability_cache();
 	if(area_id.empty()) {
 		areas_.clear();
 	} else {
@@ -359,6 +431,7 @@ void tod_manager::remove_time_area(const std::string& area_id)
 
 void tod_manager::remove_time_area(int area_index)
 {
+	unit::clear_ability_cache();
 	assert(area_index < static_cast<int>(areas_.size()));
 	areas_.erase(areas_.begin() + area_index);
 }
@@ -395,6 +468,7 @@ void tod_manager::set_turn(const int num, boost::optional<game_data &> vars, con
 
 void tod_manager::set_new_current_times(const int new_current_turn_number)
 {
+	unit::clear_ability_cache();
 	currentTime_ = calculate_current_time(times_.size(), new_current_turn_number, currentTime_);
 	BOOST_FOREACH(area_time_of_day& area, areas_) {
 		area.currentTime = calculate_current_time(
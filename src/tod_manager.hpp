@@ -45,13 +45,8 @@ class tod_manager : public savegame::savegame_config
 		void resolve_random(random_new::rng& r);
 		int get_current_time(const map_location& loc = map_location::null_location()) const;
 
-		void set_current_time(int time) { currentTime_ = time; }
-
-		void set_current_time(int time, int area_index) {
-			assert(area_index < static_cast<int>(areas_.size()));
-			assert(time < static_cast<int>(areas_[area_index].times.size()) );
-			areas_[area_index].currentTime = time;
-		}
+		void set_current_time(int time);
+		void set_current_time(int time, int area_index);
 
 		void set_area_id(int area_index, const std::string& id);
 
@@ -77,6 +72,8 @@ class tod_manager : public savegame::savegame_config
 		 * Returns time of day object for the passed turn at a location.
 		 * tod areas matter, for_turn = 0 means current turn
 		 * taking account of illumination caused by units
+		 *
+		 * The results for the current turn are cached by hex.
 		 */
 		const time_of_day get_illuminated_time_of_day(const unit_map & units, const gamemap & map, const map_location& loc,
 				int for_turn = 0) const;
@@ -202,6 +199,74 @@ class tod_manager : public savegame::savegame_config
 		void set_new_current_times(const int new_current_turn_number);
 
 
+		/**
+		 * The lawful bonus at @a loc once @a tod is lit up by its terrain and
+		 * by the units on and next to it.
+		 */
+		int illuminated_bonus(const unit_map& units, const gamemap& map,
+				const map_location& loc, const time_of_day& tod) const;
+
+		/**
+		 * The illuminated times of day of the current turn, by hex of the map
+		 * and its border, filled as they are asked for.
+		 *
+		 * They hold while the units and map are the same and the map and
+		 * unit::ability_generation() did not change. The latter changes with
+		 * the moves and changes of the units, the events, and the changes of
+		 * the schedules, time areas and turn. Like the ability caches of the
+		 * units, this is not safe to use from several threads.
+		 */
+		struct illumination_cache {
+			illumination_cache() :
+				units(NULL),
+				map(NULL),
+				map_revision(0),
+				generation(0),
+				turn(0),
+				width(0),
+				hexes()
+			{}
+
+			/** Copies start empty, the entries pointing into the schedules. */
+			illumination_cache(const illumination_cache&) :
+				units(NULL),
+				map(NULL),
+				map_revision(0),
+				generation(0),
+				turn(0),
+				width(0),
+				hexes()
+			{}
+
+			illumination_cache& operator=(const illumination_cache&) {
+				units = NULL;
+				map = NULL;
+				hexes.clear();
+				return *this;
+			}
+
+			struct hex {
+				hex() : tod(NULL), lawful_bonus(0) {}
+
+				/** The time of day ignoring illumination, NULL if not filled. */
+				const time_of_day* tod;
+				int lawful_bonus;
+			};
+
+			const unit_map* units;
+			const gamemap* map;
+			unsigned map_revision;
+			unsigned generation;
+			int turn;
+			/** The width of the map, border included. */
+			int width;
+			std::vector<hex> hexes;
+		};
+
+		/** The entry of illumination_ for @a loc, emptying it if stale. */
+		illumination_cache::hex& illumination_entry(const unit_map& units,
+				const gamemap& map, const map_location& loc) const;
+
 		struct area_time_of_day {
 			area_time_of_day() :
 				xsrc(),
@@ -224,6 +289,8 @@ class tod_manager : public savegame::savegame_config
 		std::vector<time_of_day> times_;
 		std::vector<area_time_of_day> areas_;
 
+		mutable illumination_cache illumination_;
+
 		// current turn
 		int turn_;
 		//turn limit
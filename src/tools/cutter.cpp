@@ -18,25 +18,90 @@
  */
 
 #include "../game_config.hpp"
+#include "../thread.hpp"
 #include "exploder_composer.hpp"
 
 #include "SDL_image.h"
 
+#include <boost/foreach.hpp>
+
+#include <cstdlib>
 #include <iostream>
 
 namespace {
 
 	void print_usage(std::string name)
 	{
-		std::cerr << "usage: " << name << " [source] [dest_directory]\n";
+		std::cerr << "usage: " << name
+			<< " [--jobs count] [source...] [dest_directory]\n";
+	}
+
+	void cut_file(cutter& cut, const std::string& src, const std::string& dest_dir)
+	{
+		const config conf = cut.load_config(src);
+		cut.load_masks(conf);
+
+		const surface src_surface(make_neutral_surface(IMG_Load(src.c_str())));
+		if(src_surface == NULL)
+			throw exploder_failure("Unable to load the source image " + src);
+
+		const cutter::surface_map surfaces = cut.cut_surface(src_surface, conf);
+
+		for(cutter::surface_map::const_iterator itor = surfaces.begin();
+				itor != surfaces.end(); ++itor) {
+			const cutter::mask &mask = itor->second.mask;
+
+			surface surf = create_compatible_surface(
+					  itor->second.image
+					, mask.cut.w
+					, mask.cut.h);
+
+			masked_overwrite_surface(surf, itor->second.image, mask.image,
+					mask.cut.x - mask.shift.x, mask.cut.y - mask.shift.y);
+
+			save_image(surf, dest_dir + "/" + mask.name + ".png");
+		}
 	}
+
+	// Cuts each source on a cutter of its own, their surfaces not being
+	// safe to share between threads; the masks are decoded only once.
+	class cut_job : public threading::parallel_job
+	{
+	public:
+		cut_job(const std::vector<std::string>& sources,
+				const std::string& dest_dir, bool verbose)
+			: sources_(sources)
+			, dest_dir_(dest_dir)
+			, verbose_(verbose)
+			, errors_(sources.size())
+		{
+		}
+
+		void run(size_t index)
+		{
+			cutter cut;
+			cut.set_verbose(verbose_);
+			try {
+				cut_file(cut, sources_[index], dest_dir_);
+			} catch(exploder_failure& err) {
+				errors_[index] = err.message;
+			}
+		}
+
+		const std::vector<std::string>& errors() const { return errors_; }
+
+	private:
+		const std::vector<std::string>& sources_;
+		const std::string& dest_dir_;
+		bool verbose_;
+		std::vector<std::string> errors_;
+	};
 }
 
 int main(int argc, char* argv[])
 {
-	std::string src;
-	std::string dest_dir;
-	cutter cut;
+	std::vector<std::string> files;
+	bool verbose = false;
 
 	// Parse arguments that shouldn't require a display device
 	int arg;
@@ -50,57 +115,34 @@ int main(int argc, char* argv[])
 			print_usage(argv[0]);
 			return 0;
 		} else if(val == "--verbose" || val == "-v") {
-			cut.set_verbose(true);
+			verbose = true;
 		} else if(val == "--directory" || val == "-d" ) {
 			game_config::path = argv[++arg];
+		} else if(val == "--jobs" || val == "-j") {
+			threading::set_thread_count(atoi(argv[++arg]));
 		} else {
-			if(src.empty()) {
-				src = val;
-			} else if(dest_dir.empty()) {
-				dest_dir = val;
-			} else {
-				print_usage(argv[0]);
-				return 1;
-			}
+			files.push_back(val);
 		}
 	}
 
-	if(src.empty() || dest_dir.empty()) {
+	if(files.size() < 2) {
 		print_usage(argv[0]);
 		return 1;
 	}
 
-	try {
-		const config conf = cut.load_config(src);
-		cut.load_masks(conf);
-
-		const surface src_surface(make_neutral_surface(IMG_Load(src.c_str())));
-		if(src_surface == NULL)
-			throw exploder_failure("Unable to load the source image " + src);
-
-		const cutter::surface_map surfaces = cut.cut_surface(src_surface, conf);
-
-		for(cutter::surface_map::const_iterator itor = surfaces.begin();
-				itor != surfaces.end(); ++itor) {
-			const cutter::mask &mask = itor->second.mask;
+	const std::string dest_dir = files.back();
+	files.pop_back();
 
-			surface surf = create_compatible_surface(
-					  itor->second.image
-					, mask.cut.w
-					, mask.cut.h);
+	cut_job job(files, dest_dir, verbose);
+	threading::run_parallel(job, files.size());
 
-			masked_overwrite_surface(surf, itor->second.image, mask.image,
-					mask.cut.x - mask.shift.x, mask.cut.y - mask.shift.y);
-
-			save_image(surf, dest_dir + "/" + mask.name + ".png");
+	int res = 0;
+	BOOST_FOREACH(const std::string& error, job.errors()) {
+		if(!error.empty()) {
+			std::cerr << "Failed: " << error << "\n";
+			res = 1;
 		}
-
-	} catch(exploder_failure& err) {
-		std::cerr << "Failed: " << err.message << "\n";
-		return 1;
 	}
 
-	return 0;
+	return res;
 }
-
-
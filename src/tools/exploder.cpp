@@ -13,23 +13,72 @@
 */
 
 #include "../game_config.hpp"
+#include "../thread.hpp"
 #include "exploder_composer.hpp"
 
+#include <boost/foreach.hpp>
+
+#include <cstdlib>
 #include <iostream>
 
 namespace {
 
 	void print_usage(std::string name)
 	{
-		std::cerr << "usage: " << name << " [source] [destination]\n";
+		std::cerr << "usage: " << name
+			<< " [--jobs count] [source] [destination] [source destination...]\n";
 	}
+
+	// The sources to compose onto a destination, in order.
+	typedef std::pair<std::string, std::vector<std::string> > destination;
+
+	// Composes each destination on a composer of its own, their surfaces
+	// not being safe to share between threads. The sources of the same
+	// destination are composed in order, onto the result of the previous.
+	class compose_job : public threading::parallel_job
+	{
+	public:
+		compose_job(const std::vector<destination>& destinations,
+				bool interactive, bool verbose)
+			: destinations_(destinations)
+			, interactive_(interactive)
+			, verbose_(verbose)
+			, errors_(destinations.size())
+		{
+		}
+
+		void run(size_t index)
+		{
+			composer comp;
+			comp.set_interactive(interactive_);
+			comp.set_verbose(verbose_);
+
+			const destination& dest = destinations_[index];
+			try {
+				BOOST_FOREACH(const std::string& src, dest.second) {
+					surface image = comp.compose(src, dest.first);
+					save_image(image, dest.first);
+				}
+			} catch(exploder_failure& err) {
+				errors_[index] = err.message;
+			}
+		}
+
+		const std::vector<std::string>& errors() const { return errors_; }
+
+	private:
+		const std::vector<destination>& destinations_;
+		bool interactive_;
+		bool verbose_;
+		std::vector<std::string> errors_;
+	};
 }
 
 int main(int argc, char* argv[])
 {
-	std::string src;
-	std::string dest;
-	composer comp;
+	std::vector<std::string> files;
+	bool interactive = false;
+	bool verbose = false;
 
 	//parse arguments that shouldn't require a display device
 	int arg;
@@ -43,38 +92,46 @@ int main(int argc, char* argv[])
 			print_usage(argv[0]);
 			return 0;
 		} else if(val == "--interactive" || val == "-i") {
-			comp.set_interactive(true);
+			interactive = true;
 		} else if(val == "--verbose" || val == "-v") {
-			comp.set_verbose(true);
+			verbose = true;
 		} else if(val == "--directory" || val == "-d" ) {
 			game_config::path = argv[++arg];
+		} else if(val == "--jobs" || val == "-j") {
+			threading::set_thread_count(atoi(argv[++arg]));
 		} else {
-			if(src.empty()) {
-				src = val;
-			} else if(dest.empty()) {
-				dest = val;
-			} else {
-				print_usage(argv[0]);
-				return 1;
-			}
+			files.push_back(val);
 		}
 	}
 
-	if(src.empty() || dest.empty()) {
+	if(files.empty() || files.size() % 2 != 0) {
 		print_usage(argv[0]);
 		return 1;
 	}
 
-	try {
-		surface image = comp.compose(src, dest);
-		save_image(image, dest);
-	} catch(exploder_failure& err) {
-		std::cerr << "Failed: " << err.message << "\n";
-		return 1;
+	std::vector<destination> destinations;
+	for(size_t i = 0; i != files.size(); i += 2) {
+		std::vector<destination>::iterator itor = destinations.begin();
+		while(itor != destinations.end() && itor->first != files[i + 1]) {
+			++itor;
+		}
+		if(itor == destinations.end()) {
+			itor = destinations.insert(destinations.end(),
+					destination(files[i + 1], std::vector<std::string>()));
+		}
+		itor->second.push_back(files[i]);
 	}
 
-	return 0;
-}
-
+	compose_job job(destinations, interactive, verbose);
+	threading::run_parallel(job, destinations.size());
 
+	int res = 0;
+	BOOST_FOREACH(const std::string& error, job.errors()) {
+		if(!error.empty()) {
+			std::cerr << "Failed: " << error << "\n";
+			res = 1;
+		}
+	}
 
+	return res;
+}
@@ -18,12 +18,79 @@
 #include "serialization/parser.hpp"
 #include "serialization/preprocessor.hpp"
 #include "serialization/string_utils.hpp"
+#include "thread.hpp"
 #include "SDL_image.h"
 
 #include <boost/foreach.hpp>
+#include <boost/shared_ptr.hpp>
 
+#include <algorithm>
 #include <iostream>
 
+namespace {
+
+/** The pixels of a mask image, as a neutral surface has them. */
+struct mask_pixels
+{
+	mask_pixels() : w(0), h(0), pixels() {}
+
+	int w;
+	int h;
+	std::vector<Uint32> pixels;
+};
+
+typedef std::map<std::string, boost::shared_ptr<const mask_pixels> > mask_pixels_map;
+
+/**
+ * The mask images decoded so far, by file name.
+ *
+ * The same masks are used by most of the images, so they are only decoded
+ * once. The pixels are kept rather than the surfaces, whose reference
+ * counts are not safe to share between the threads cutting the images.
+ */
+mask_pixels_map mask_cache;
+threading::mutex mask_cache_mutex;
+
+/** Loads the mask image @a filename as a neutral surface, or NULL. */
+surface load_mask_image(const std::string& filename)
+{
+	boost::shared_ptr<const mask_pixels> cached;
+	{
+		threading::lock lock(mask_cache_mutex);
+		const mask_pixels_map::const_iterator itor = mask_cache.find(filename);
+		if(itor != mask_cache.end()) {
+			cached = itor->second;
+		}
+	}
+
+	if(!cached) {
+		const surface image(make_neutral_surface(IMG_Load(filename.c_str())));
+		if(image == NULL) {
+			return NULL;
+		}
+
+		boost::shared_ptr<mask_pixels> decoded(new mask_pixels);
+		decoded->w = image->w;
+		decoded->h = image->h;
+		const_surface_lock image_lock(image);
+		decoded->pixels.assign(image_lock.pixels()
+				, image_lock.pixels() + image->w * image->h);
+
+		// Another thread may have decoded it meanwhile; keep the first one.
+		threading::lock lock(mask_cache_mutex);
+		cached = mask_cache.insert(std::make_pair(filename, decoded)).first->second;
+	}
+
+	surface res(create_neutral_surface(cached->w, cached->h));
+	if(res != NULL) {
+		surface_lock res_lock(res);
+		std::copy(cached->pixels.begin(), cached->pixels.end(), res_lock.pixels());
+	}
+	return res;
+}
+
+} // end anonymous namespace
+
 cutter::cutter()
 	: masks_()
 	, verbose_(false)
@@ -78,11 +145,7 @@ void cutter::load_masks(const config& conf)
 			cur_mask.shift = shift;
 			cur_mask.cut = cut;
 			cur_mask.filename = image;
-			surface tmp(IMG_Load(image.c_str()));
-			if(tmp == NULL)
-				throw exploder_failure("Unable to load mask image " + image);
-
-			cur_mask.image = make_neutral_surface(tmp);
+			cur_mask.image = load_mask_image(image);
 		}
 
 		if(masks_[name].image == NULL)
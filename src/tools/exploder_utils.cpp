@@ -206,10 +206,26 @@ void save_image(surface surf, const std::string &filename)
 	//endianness problems.
 	util::scoped_array<rgba> rgba_data(new rgba[surf->w * surf->h]);
 
+	//neutral surfaces, which is what the tools write, are converted
+	//directly, the others pixel by pixel by SDL.
+	const bool neutral = is_neutral(surf) && surf->format->Amask == 0xFF000000;
+
 	Uint32 *surf_data = lock.pixels();
 	int pos = 0;
 	for(int y = 0; y < surf->h; ++y) {
 		row_pointers[y] = reinterpret_cast<png_byte*>(rgba_data + pos);
+		if(neutral) {
+			for(int x = 0; x < surf->w; ++x) {
+				const Uint32 pixel = *surf_data;
+				rgba_data[pos].r = (pixel >> 16) & 0xFF;
+				rgba_data[pos].g = (pixel >> 8) & 0xFF;
+				rgba_data[pos].b = pixel & 0xFF;
+				rgba_data[pos].a = pixel >> 24;
+				pos++;
+				surf_data++;
+			}
+			continue;
+		}
 		for(int x = 0; x < surf->w; ++x) {
 			Uint8 red, green, blue, alpha;
 			SDL_GetRGBA(*surf_data, surf->format, &red, &green, &blue, &alpha);
@@ -0,0 +1,490 @@
+/*
+   Copyright (C) 2015 by the Battle for Wesnoth Project
+   Part of the Battle for Wesnoth Project http://www.wesnoth.org/
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY.
+
+   See the COPYING file for more details.
+*/
+
+/**
+ * @file
+ * Standalone utility summing the [statistics] of many saves, by faction,
+ * by unit type and by faction matchup, as tab separated tables.
+ *
+ * The saves are read on several threads. Only the lines of the top level
+ * [statistics] and of the [side]s of [replay_start] are kept and parsed;
+ * the snapshots and replays, most of a save, are only scanned for the end
+ * of their tags. The parser and the translatable strings share state, so
+ * the (small) parsing of what was kept is done under a lock.
+ */
+
+#include "../config.hpp"
+#include "../filesystem.hpp"
+#include "../serialization/parser.hpp"
+#include "../statistics.hpp"
+#include "../thread.hpp"
+#include "../util.hpp"
+
+#include <boost/foreach.hpp>
+#include <boost/iostreams/filter/bzip2.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+
+namespace {
+
+typedef statistics::stats stats;
+
+void print_usage(const std::string& name)
+{
+	std::cerr << "usage: " << name << " [-j threads] [-o prefix] save_or_directory...\n"
+		"  -j, --threads N    read the saves on N threads (default: one per core)\n"
+		"  -o, --output P     write P_factions.tsv, P_units.tsv and P_matchups.tsv\n"
+		"                     rather than the three tables to the standard output\n";
+}
+
+/** A side of a save, with its faction and its statistics over all scenarios. */
+struct side_record
+{
+	side_record() : faction(), statistics() {}
+
+	std::string faction;
+	stats statistics;
+};
+
+struct save_record
+{
+	save_record() : sides(), error() {}
+
+	std::vector<side_record> sides;
+	/** Why the save could not be read, if it could not. */
+	std::string error;
+};
+
+/**
+ * Collects the lines of the subtrees of a save the tool uses, given the save
+ * a line at a time.
+ *
+ * The lines of a save are tags or attributes, the values in quotes possibly
+ * spanning lines with "" standing for a quote, so only the lines starting
+ * outside of quotes can be tags.
+ */
+class save_scanner
+{
+public:
+	save_scanner()
+		: statistics()
+		, sides()
+		, depth_(0)
+		, in_quotes_(false)
+		, in_statistics_(false)
+		, in_replay_start_(false)
+		, in_side_(false)
+	{
+	}
+
+	void line(const std::string& line)
+	{
+		const bool was_in_quotes = in_quotes_;
+		if(std::count(line.begin(), line.end(), '"') % 2 != 0) {
+			in_quotes_ = !in_quotes_;
+		}
+
+		const std::string::size_type beg = line.find_first_not_of(" \t");
+		const std::string::size_type end = line.find_last_not_of(" \t\r");
+		const bool is_tag = !was_in_quotes && beg != std::string::npos
+			&& line[beg] == '[' && line[end] == ']';
+		const bool closing = is_tag && end > beg + 1 && line[beg + 1] == '/';
+
+		if(closing) {
+			--depth_;
+		}
+		if(in_statistics_) {
+			statistics += line;
+			statistics += '\n';
+		} else if(in_side_ && !was_in_quotes && !is_tag && depth_ == 2) {
+			// Only the attributes of the side, none of its children.
+			if(starts_with(line, beg, "faction=") || starts_with(line, beg, "save_id=")) {
+				sides.back() += line;
+				sides.back() += '\n';
+			}
+		}
+
+		if(is_tag) {
+			const std::string tag = line.substr(beg, end + 1 - beg);
+			if(closing) {
+				if(depth_ == 0) {
+					in_statistics_ = in_replay_start_ = false;
+				} else if(depth_ == 1) {
+					in_side_ = false;
+				}
+			} else {
+				if(depth_ == 0 && tag == "[statistics]") {
+					in_statistics_ = true;
+					statistics = "[statistics]\n";
+				} else if(depth_ == 0 && tag == "[replay_start]") {
+					in_replay_start_ = true;
+				} else if(depth_ == 1 && in_replay_start_ && tag == "[side]") {
+					in_side_ = true;
+					sides.push_back("[side]\n");
+				}
+				++depth_;
+			}
+		}
+	}
+
+	/** The top level [statistics], tags included. */
+	std::string statistics;
+	/** The attributes of the [side]s of [replay_start] used, each without its closing tag. */
+	std::vector<std::string> sides;
+
+private:
+	static bool starts_with(const std::string& line, std::string::size_type pos, const char* prefix)
+	{
+		return line.compare(pos, strlen(prefix), prefix) == 0;
+	}
+
+	int depth_;
+	bool in_quotes_;
+	bool in_statistics_, in_replay_start_, in_side_;
+};
+
+void scan_stream(std::istream& in, save_scanner& scanner)
+{
+	std::string line;
+	while(std::getline(in, line)) {
+		scanner.line(line);
+	}
+}
+
+/** Scans @a file, compressed or not, telling its format by its first bytes. */
+void scan_file(const std::string& file, save_scanner& scanner)
+{
+	std::ifstream in(file.c_str(), std::ios_base::binary);
+	if(!in) {
+		throw std::ios_base::failure("cannot open the file");
+	}
+	char magic[3] = { 0, 0, 0 };
+	in.read(magic, sizeof(magic));
+	in.clear();
+	in.seekg(0);
+
+	if(magic[0] == '\x1f' && magic[1] == '\x8b') {
+		boost::iostreams::filtering_stream<boost::iostreams::input> filter;
+		filter.push(boost::iostreams::gzip_decompressor());
+		filter.push(in);
+		filter.exceptions(filter.exceptions() | std::ios_base::badbit);
+		scan_stream(filter, scanner);
+	} else if(magic[0] == 'B' && magic[1] == 'Z' && magic[2] == 'h') {
+		boost::iostreams::filtering_stream<boost::iostreams::input> filter;
+		filter.push(boost::iostreams::bzip2_decompressor());
+		filter.push(in);
+		filter.exceptions(filter.exceptions() | std::ios_base::badbit);
+		scan_stream(filter, scanner);
+	} else {
+		scan_stream(in, scanner);
+	}
+}
+
+/** Reads the saves, each into the record with its index. */
+class save_reader : public threading::parallel_job
+{
+public:
+	save_reader(const std::vector<std::string>& files, std::vector<save_record>& records)
+		: files_(files)
+		, records_(records)
+		, parser_mutex_()
+	{
+	}
+
+	void run(size_t index)
+	{
+		save_record& record = records_[index];
+		record = save_record();
+		try {
+			save_scanner scanner;
+			scan_file(files_[index], scanner);
+			if(scanner.statistics.empty()) {
+				record.error = "no [statistics]";
+				return;
+			}
+
+			config statistics_cfg;
+			std::vector<config> sides(scanner.sides.size());
+			{
+				threading::lock lock(parser_mutex_);
+				read(statistics_cfg, scanner.statistics);
+				for(size_t i = 0; i != sides.size(); ++i) {
+					read(sides[i], scanner.sides[i] + "[/side]\n");
+				}
+			}
+			add_sides(statistics_cfg.child_or_empty("statistics"), sides, record);
+		} catch(config::error& e) {
+			record.error = e.message;
+		} catch(std::exception& e) {
+			record.error = e.what();
+		}
+	}
+
+private:
+	/** Sums the statistics of each side over the scenarios, in order. */
+	static void add_sides(const config& statistics_cfg, const std::vector<config>& sides,
+		save_record& record)
+	{
+		std::map<std::string, std::string> factions;
+		BOOST_FOREACH(const config& side, sides) {
+			const config& s = side.child_or_empty("side");
+			factions[s["save_id"]] = s["faction"].empty() ? "(none)" : s["faction"].str();
+		}
+
+		std::map<std::string, size_t> indices;
+		BOOST_FOREACH(const config& scenario, statistics_cfg.child_range("scenario")) {
+			BOOST_FOREACH(const config& team, scenario.child_range("team")) {
+				const std::string& save_id = team["save_id"];
+				std::map<std::string, size_t>::iterator it = indices.find(save_id);
+				if(it == indices.end()) {
+					it = indices.insert(std::make_pair(save_id, record.sides.size())).first;
+					record.sides.push_back(side_record());
+					const std::map<std::string, std::string>::const_iterator faction = factions.find(save_id);
+					record.sides.back().faction = faction == factions.end() ? "(unknown)" : faction->second;
+				}
+				statistics::merge_stats(record.sides[it->second].statistics, stats(team));
+			}
+		}
+	}
+
+	const std::vector<std::string>& files_;
+	std::vector<save_record>& records_;
+	threading::mutex parser_mutex_;
+};
+
+/** The strikes and hits in @a results, and the hits expected from the chances to hit. */
+struct strike_totals
+{
+	strike_totals() : strikes(0), hits(0), expected_hits(0) {}
+
+	void add(const stats::battle_result_map& results)
+	{
+		BOOST_FOREACH(const stats::battle_result_map::value_type& chance, results) {
+			BOOST_FOREACH(const stats::battle_sequence_frequency_map::value_type& sequence, chance.second) {
+				// The sequences are "s" followed by a 0 or a 1 for each strike.
+				const long long count = sequence.second;
+				const long long sequence_hits = std::count(sequence.first.begin(), sequence.first.end(), '1');
+				const long long sequence_strikes = sequence_hits + std::count(sequence.first.begin(), sequence.first.end(), '0');
+				strikes += count * sequence_strikes;
+				hits += count * sequence_hits;
+				expected_hits += count * sequence_strikes * chance.first / 100.0;
+			}
+		}
+	}
+
+	long long strikes, hits;
+	double expected_hits;
+};
+
+/** The totals of the sides of a faction, or of a faction against another. */
+struct faction_totals
+{
+	faction_totals() : sides(0), statistics(), attacks(), defends() {}
+
+	void add(const stats& s)
+	{
+		++sides;
+		statistics::merge_stats(statistics, s);
+		attacks.add(s.attacks);
+		defends.add(s.defends);
+	}
+
+	int sides;
+	stats statistics;
+	strike_totals attacks, defends;
+};
+
+struct unit_totals
+{
+	unit_totals() : recruited(0), recalled(0), advanced_to(0), deaths(0), killed(0) {}
+
+	int recruited, recalled, advanced_to, deaths, killed;
+};
+
+typedef std::map<std::string, faction_totals> faction_map;
+typedef std::map<std::pair<std::string, std::string>, faction_totals> matchup_map;
+typedef std::map<std::string, unit_totals> unit_map;
+
+void add_units(unit_map& units, const stats::str_int_map& m, int unit_totals::*field)
+{
+	BOOST_FOREACH(const stats::str_int_map::value_type& u, m) {
+		units[u.first].*field += u.second;
+	}
+}
+
+/** How much more damage was done than expected, in percent. */
+double luck(long long damage, long long expected)
+{
+	return expected == 0 ? 0 : 100.0 * (damage * stats::decimal_shift - expected) / expected;
+}
+
+const char faction_columns[] =
+	"sides\trecruits\trecruit_cost\trecalls\trecall_cost\tkills\tdeaths\tadvances"
+	"\tdamage_inflicted\texpected_inflicted\tluck_inflicted"
+	"\tdamage_taken\texpected_taken\tluck_taken"
+	"\tstrikes\thits\texpected_hits\tstrikes_taken\thits_taken\texpected_hits_taken\n";
+
+void write_faction_totals(std::ostream& out, const faction_totals& t)
+{
+	const stats& s = t.statistics;
+	const double shift = stats::decimal_shift;
+	out << t.sides
+		<< '\t' << statistics::sum_str_int_map(s.recruits) << '\t' << s.recruit_cost
+		<< '\t' << statistics::sum_str_int_map(s.recalls) << '\t' << s.recall_cost
+		<< '\t' << statistics::sum_str_int_map(s.killed)
+		<< '\t' << statistics::sum_str_int_map(s.deaths)
+		<< '\t' << statistics::sum_str_int_map(s.advanced_to)
+		<< '\t' << s.damage_inflicted << '\t' << s.expected_damage_inflicted / shift
+		<< '\t' << luck(s.damage_inflicted, s.expected_damage_inflicted)
+		<< '\t' << s.damage_taken << '\t' << s.expected_damage_taken / shift
+		<< '\t' << luck(s.damage_taken, s.expected_damage_taken)
+		<< '\t' << t.attacks.strikes << '\t' << t.attacks.hits << '\t' << t.attacks.expected_hits
+		<< '\t' << t.defends.strikes << '\t' << t.defends.hits << '\t' << t.defends.expected_hits
+		<< '\n';
+}
+
+void write_factions(std::ostream& out, const faction_map& factions)
+{
+	out << "faction\t" << faction_columns;
+	BOOST_FOREACH(const faction_map::value_type& f, factions) {
+		out << f.first << '\t';
+		write_faction_totals(out, f.second);
+	}
+}
+
+void write_matchups(std::ostream& out, const matchup_map& matchups)
+{
+	out << "faction\topponent\t" << faction_columns;
+	BOOST_FOREACH(const matchup_map::value_type& m, matchups) {
+		out << m.first.first << '\t' << m.first.second << '\t';
+		write_faction_totals(out, m.second);
+	}
+}
+
+void write_units(std::ostream& out, const unit_map& units)
+{
+	out << "unit_type\trecruited\trecalled\tadvanced_to\tdeaths\tkilled\n";
+	BOOST_FOREACH(const unit_map::value_type& u, units) {
+		const unit_totals& t = u.second;
+		out << u.first << '\t' << t.recruited << '\t' << t.recalled << '\t'
+			<< t.advanced_to << '\t' << t.deaths << '\t' << t.killed << '\n';
+	}
+}
+
+/** Writes a table to the file @a prefix_@a name.tsv, or to the standard output after a title line. */
+template<typename Map>
+bool write_table(const std::string& prefix, const std::string& name,
+	void (*write)(std::ostream&, const Map&), const Map& table)
+{
+	if(prefix.empty()) {
+		std::cout << "# " << name << '\n';
+		write(std::cout, table);
+		std::cout << '\n';
+		return true;
+	}
+
+	const std::string file = prefix + "_" + name + ".tsv";
+	std::ofstream out(file.c_str());
+	write(out, table);
+	if(!out) {
+		std::cerr << "cannot write " << file << '\n';
+		return false;
+	}
+	return true;
+}
+
+} // end anonymous namespace
+
+int main(int argc, char* argv[])
+{
+	unsigned threads = 0;
+	std::string prefix;
+	std::vector<std::string> files;
+
+	for(int arg = 1; arg != argc; ++arg) {
+		const std::string val(argv[arg]);
+		if(val.empty()) {
+			continue;
+		}
+
+		if(val == "--help" || val == "-h") {
+			print_usage(argv[0]);
+			return 0;
+		} else if((val == "--threads" || val == "-j") && arg + 1 != argc) {
+			threads = lexical_cast_default<unsigned>(argv[++arg], 0);
+		} else if((val == "--output" || val == "-o") && arg + 1 != argc) {
+			prefix = argv[++arg];
+		} else if(filesystem::is_directory(val)) {
+			filesystem::get_files_in_dir(val, &files, NULL, filesystem::ENTIRE_FILE_PATH);
+		} else {
+			files.push_back(val);
+		}
+	}
+
+	if(files.empty()) {
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	std::vector<save_record> records(files.size());
+	save_reader reader(files, records);
+	threading::run_parallel(reader, files.size(), threads);
+
+	faction_map factions;
+	matchup_map matchups;
+	unit_map units;
+	size_t failed = 0;
+
+	for(size_t i = 0; i != records.size(); ++i) {
+		const save_record& record = records[i];
+		if(!record.error.empty()) {
+			std::cerr << files[i] << ": " << record.error << '\n';
+			++failed;
+			continue;
+		}
+
+		BOOST_FOREACH(const side_record& side, record.sides) {
+			const stats& s = side.statistics;
+			factions[side.faction].add(s);
+
+			add_units(units, s.recruits, &unit_totals::recruited);
+			add_units(units, s.recalls, &unit_totals::recalled);
+			add_units(units, s.advanced_to, &unit_totals::advanced_to);
+			add_units(units, s.deaths, &unit_totals::deaths);
+			add_units(units, s.killed, &unit_totals::killed);
+
+			// A side is counted against each of its opponents.
+			BOOST_FOREACH(const side_record& opponent, record.sides) {
+				if(&opponent != &side) {
+					matchups[std::make_pair(side.faction, opponent.faction)].add(s);
+				}
+			}
+		}
+	}
+
+	std::cerr << files.size() - failed << " saves read, " << failed << " failed\n";
+
+	const bool written = write_table(prefix, "factions", &write_factions, factions)
+		&& write_table(prefix, "units", &write_units, units)
+		&& write_table(prefix, "matchups", &write_matchups, matchups);
+
+	return written ? 0 : 1;
+}
@@ -32,6 +32,7 @@
 #include "log.hpp"                      // for LOG_STREAM, logger, etc
 #include "make_enum.hpp"                // for operator<<, operator>>
 #include "map.hpp"       // for gamemap
+#include "pathfind/pathfind.hpp"        // for reach_cache, adjacency_cache
 #include "random_new.hpp"               // for generator, rng
 #include "resources.hpp"                // for units, gameboard, teams, etc
 #include "scripting/game_lua_kernel.hpp"            // for game_lua_kernel
@@ -245,6 +246,9 @@ unit::unit(const unit& o)
 	, xp_bar_scaling_(o.xp_bar_scaling_)
 	, modifications_(o.modifications_)
 	, invisibility_cache_()
+	, ability_cache_()
+	, ability_bool_cache_()
+	, ability_cache_generation_(ability_generation_)
 {
 }
 
@@ -312,6 +316,9 @@ unit::unit(const config &cfg, bool use_traits, const vconfig* vcfg)
 	, xp_bar_scaling_(cfg["xp_bar_scaling"].blank() ? type_->xp_bar_scaling() : cfg["xp_bar_scaling"])
 	, modifications_()
 	, invisibility_cache_()
+	, ability_cache_()
+	, ability_bool_cache_()
+	, ability_cache_generation_(ability_generation_)
 {
 	side_ = cfg["side"];
 	if(side_ <= 0) {
@@ -561,6 +568,19 @@ void unit::clear_status_caches()
 	}
 
 	units_with_cache.clear();
+	clear_ability_cache();
+}
+
+unsigned unit::ability_generation_ = 0;
+unsigned unit::id_generation_ = 0;
+
+void unit::check_ability_cache() const
+{
+	if(ability_cache_generation_ != ability_generation_) {
+		ability_cache_.clear();
+		ability_bool_cache_.clear();
+		ability_cache_generation_ = ability_generation_;
+	}
 }
 
 unit::unit(const unit_type &u_type, int side, bool real_unit,
@@ -627,6 +647,9 @@ unit::unit(const unit_type &u_type, int side, bool real_unit,
 	, hidden_(false)
 	, modifications_()
 	, invisibility_cache_()
+	, ability_cache_()
+	, ability_bool_cache_()
+	, ability_cache_generation_(ability_generation_)
 {
 	cfg_["upkeep"]="full";
 
@@ -667,6 +690,10 @@ unit::~unit()
 void unit::swap(unit & o)
 {
 	using std::swap;
+	++id_generation_;
+
+	// The units may be on a map, and the sides and leaders exchanged.
+	unit_map::invalidate_side_indexes();
 
 	// Don't swap reference count, or it will be incorrect...
 	swap(cfg_, o.cfg_);
@@ -729,6 +756,9 @@ void unit::swap(unit & o)
 	swap(hidden_, o.hidden_);
 	swap(modifications_, o.modifications_);
 	swap(invisibility_cache_, o.invisibility_cache_);
+	swap(ability_cache_, o.ability_cache_);
+	swap(ability_bool_cache_, o.ability_bool_cache_);
+	swap(ability_cache_generation_, o.ability_cache_generation_);
 }
 
 /**
@@ -843,6 +873,12 @@ std::vector<std::string> unit::get_traits_list() const
 void unit::advance_to(const config &old_cfg, const unit_type &u_type,
 	bool use_traits)
 {
+	// The id of a unit without one is its type name.
+	++id_generation_;
+	// Movement costs and abilities are about to change.
+	pathfind::reach_cache::invalidate_all();
+	clear_ability_cache();
+
 	// For reference, the type before this advancement.
 	const unit_type & old_type = type();
 	// Adjust the new type for gender and variation.
@@ -1060,6 +1096,23 @@ SDL_Color unit::xp_color() const
 	return(color);
 }
 
+void unit::set_side(unsigned int new_side)
+{
+	// Units are not told which unit_map holds them, so drop everything that
+	// depends on the sides of the units on the board.
+	pathfind::reach_cache::invalidate_all();
+	pathfind::adjacency_cache::invalidate_all();
+	clear_ability_cache();
+	unit_map::invalidate_side_indexes();
+	side_ = new_side;
+}
+
+void unit::set_can_recurit(bool canrecruit)
+{
+	unit_map::invalidate_side_indexes();
+	canrecruit_ = canrecruit;
+}
+
 void unit::set_recruits(const std::vector<std::string>& recruits)
 {
 	unit_types.check_types(recruits);
@@ -1132,6 +1185,7 @@ void unit::expire_modifications(const std::string & duration)
 {
 	// If any modifications expire, then we will need to rebuild the unit.
 	const unit_type * rebuild_from = NULL;
+	pathfind::reach_cache::invalidate_all();
 
 	// Loop through all types of modifications.
 	for(unsigned int i = 0; i != NumModificationTypes; ++i) {
@@ -1201,6 +1255,7 @@ void unit::new_scenario()
 
 void unit::heal(int amount)
 {
+	clear_ability_cache();
 	int max_hp = max_hitpoints();
 	if (hit_points_ < max_hp) {
 		hit_points_ += amount;
@@ -1252,6 +1307,7 @@ bool unit::get_state(const std::string &state) const
 
 void unit::set_state(state_t state, bool value)
 {
+	clear_ability_cache();
 	known_boolean_states_[state] = value;
 }
 
@@ -1285,6 +1341,7 @@ std::map<std::string, unit::state_t> unit::get_known_boolean_state_names()
 
 void unit::set_state(const std::string &state, bool value)
 {
+	clear_ability_cache();
 	state_t known_boolean_state_id = get_known_boolean_state_id(state);
 	if (known_boolean_state_id != STATE_UNKNOWN) {
 		set_state(known_boolean_state_id, value);
@@ -1330,6 +1387,14 @@ void unit::remove_ability_by_id(const std::string &ability)
 	}
 }
 
+size_t unit::memory_usage() const
+{
+	return sizeof(unit) - 5 * sizeof(config)
+		+ cfg_.memory_usage() + variables_.memory_usage() + events_.memory_usage()
+		+ filter_recall_.memory_usage() + modifications_.memory_usage()
+		+ attacks_.capacity() * sizeof(attack_type);
+}
+
 void unit::write(config& cfg) const
 {
 	cfg.append(cfg_);
@@ -1614,6 +1679,10 @@ size_t unit::modification_count(const std::string& mod_type, const std::string&
 
 void unit::add_modification(const std::string& mod_type, const config& mod, bool no_add)
 {
+	// Effects may change movement costs and abilities.
+	pathfind::reach_cache::invalidate_all();
+	clear_ability_cache();
+
 	bool generate_description = mod["generate_description"].to_bool(true);
 
 	config *new_child = NULL;
@@ -2103,6 +2172,7 @@ bool unit::is_visible_to_team(team const& team, gamemap const& map, bool const s
 }
 
 void unit::set_underlying_id() {
+	++id_generation_;
 	if(underlying_id_ == 0) {
 		if(synced_context::get_synced_state() == synced_context::SYNCED || !resources::gamedata || resources::gamedata->phase() == game_data::INITIAL) {
 			underlying_id_ = n_unit::id_manager::instance().next_id();
@@ -2120,6 +2190,7 @@ void unit::set_underlying_id() {
 
 unit& unit::clone(bool is_temporary)
 {
+	++id_generation_;
 	if(is_temporary) {
 		underlying_id_ = n_unit::id_manager::instance().next_fake_id();
 	} else {
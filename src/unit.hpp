@@ -87,6 +87,27 @@ public:
 	 */
 	static void clear_status_caches();
 
+	/**
+	 * Drops the results of get_abilities() and get_ability_bool() cached by
+	 * all units. The ability filters may look at about anything, so this is
+	 * called whenever the game state changes: by clear_status_caches(), the
+	 * changes of the unit map and of the time of day, and the setters of the
+	 * units' hit points, experience, states, side and type.
+	 */
+	static void clear_ability_cache() { ++ability_generation_; }
+
+	/**
+	 * Changes with clear_ability_cache(), for the caches of what depends on
+	 * the abilities of the units.
+	 */
+	static unsigned ability_generation() { return ability_generation_; }
+
+	/**
+	 * Changes whenever the id() or underlying_id() of a unit may have
+	 * changed, for the indexes of the units by id.
+	 */
+	static unsigned id_generation() { return id_generation_; }
+
 	/** The path to the leader crown overlay. */
 	static const std::string& leader_crown();
 
@@ -132,7 +153,7 @@ public:
 	const unit_type& type() const { return *type_; }
 
 	/** id assigned by wml */
-	void set_id(const std::string& id) { id_ = id; }
+	void set_id(const std::string& id) { id_ = id; ++id_generation_; }
 	const std::string& id() const { if (id_.empty()) return type_name(); else return id_; }
 	/** The unique internal ID of the unit */
 	size_t underlying_id() const { return underlying_id_; }
@@ -155,10 +176,10 @@ public:
 
 	int hitpoints() const { return hit_points_; }
 	int max_hitpoints() const { return max_hit_points_; }
-	void set_hitpoints(int hp) { hit_points_ = hp; }
+	void set_hitpoints(int hp) { hit_points_ = hp; clear_ability_cache(); }
 	int experience() const { return experience_; }
 	int max_experience() const { return max_experience_; }
-	void set_experience(int xp) { experience_ = xp; }
+	void set_experience(int xp) { experience_ = xp; clear_ability_cache(); }
 	void set_recall_cost(int recall_cost) { recall_cost_ = recall_cost; }
 	int level() const { return level_; }
 	int recall_cost() const { return recall_cost_; }
@@ -188,11 +209,11 @@ public:
 	int side() const { return side_; }
 	const std::string& team_color() const { return flag_rgb_; }
 	unit_race::GENDER gender() const { return gender_; }
-	void set_side(unsigned int new_side) { side_ = new_side; }
+	void set_side(unsigned int new_side);
 	fixed_t alpha() const { return alpha_; }
 
 	bool can_recruit() const { return canrecruit_; }
-	void set_can_recurit(bool canrecruit) { canrecruit_ = canrecruit; }
+	void set_can_recurit(bool canrecruit);
 	const std::vector<std::string>& recruits() const
 		{ return recruit_list_; }
 	void set_recruits(const std::vector<std::string>& recruits);
@@ -223,9 +244,9 @@ public:
 	void new_scenario();
 	/** Called on every draw */
 
-	bool take_hit(int damage) { hit_points_ -= damage; return hit_points_ <= 0; }
+	bool take_hit(int damage) { hit_points_ -= damage; clear_ability_cache(); return hit_points_ <= 0; }
 	void heal(int amount);
-	void heal_all() { hit_points_ = max_hitpoints(); }
+	void heal_all() { hit_points_ = max_hitpoints(); clear_ability_cache(); }
 	bool resting() const { return resting_; }
 	void set_resting(bool rest) { resting_ = rest; }
 
@@ -248,6 +269,9 @@ public:
 
 	void write(config& cfg) const;
 
+	/** An estimate of the memory used by the unit, the data of its type aside. */
+	size_t memory_usage() const;
+
 	void set_role(const std::string& role) { role_ = role; }
 	const std::string &get_role() const { return role_; }
 
@@ -389,6 +413,9 @@ private:
 	bool ability_active(const std::string& ability,const config& cfg,const map_location& loc) const;
 	bool ability_affects_adjacent(const std::string& ability,const config& cfg,int dir,const map_location& loc) const;
 	bool ability_affects_self(const std::string& ability,const config& cfg,const map_location& loc) const;
+	/** What get_ability_bool() and get_abilities() return when not cached. */
+	bool find_ability_bool(const std::string& tag_name, const map_location& loc) const;
+	unit_ability_list find_abilities(const std::string& tag_name, const map_location& loc) const;
 	bool resistance_filter_matches(const config& cfg,bool attacker,const std::string& damage_name, int res) const;
 
 public:
@@ -495,6 +522,23 @@ private:
 	 */
 	mutable std::map<map_location, bool> invisibility_cache_;
 
+	/**
+	 * The results of get_abilities() and get_ability_bool() by tag and
+	 * location, while ability_cache_generation_ is ability_generation_.
+	 * They are not copied with the unit, the lists pointing to its config.
+	 */
+	typedef std::pair<std::string, map_location> ability_cache_key;
+	mutable std::map<ability_cache_key, unit_ability_list> ability_cache_;
+	mutable std::map<ability_cache_key, bool> ability_bool_cache_;
+	mutable unsigned ability_cache_generation_;
+	/** Bumped by clear_ability_cache(). */
+	static unsigned ability_generation_;
+	/** Bumped by set_id(), set_underlying_id(), clone(), swap() and advance_to(). */
+	static unsigned id_generation_;
+
+	/** Empties the ability caches if the game state changed since they were filled. */
+	void check_ability_cache() const;
+
 	/**
 	 * Clears the cache.
 	 *
@@ -17,6 +17,7 @@
  *  Manage unit-abilities, like heal, cure, and weapon_specials.
  */
 
+#include "config_keys.hpp"
 #include "game_board.hpp"
 #include "log.hpp"
 #include "resources.hpp"
@@ -96,21 +97,40 @@ namespace {
 bool affects_side(const config& cfg, const std::vector<team>& teams, size_t side, size_t other_side)
 {
 	if (side == other_side)
-		return cfg["affect_allies"].to_bool(true);
+		return cfg[config_keys::affect_allies].to_bool(true);
 	if (teams[side - 1].is_enemy(other_side))
-		return cfg["affect_enemies"].to_bool();
+		return cfg[config_keys::affect_enemies].to_bool();
 	else
-		return cfg["affect_allies"].to_bool();
+		return cfg[config_keys::affect_allies].to_bool();
 }
 
+/** The cached results a unit keeps at most, so that moving it around does not pile them up. */
+const size_t max_cached_abilities = 256;
+
 }
 
 
 bool unit::get_ability_bool(const std::string& tag_name, const map_location& loc) const
+{
+	check_ability_cache();
+	const ability_cache_key key(tag_name, loc);
+	std::map<ability_cache_key, bool>::const_iterator cached = ability_bool_cache_.find(key);
+	if(cached != ability_bool_cache_.end()) {
+		return cached->second;
+	}
+	if(ability_bool_cache_.size() >= max_cached_abilities) {
+		ability_bool_cache_.clear();
+	}
+	const bool res = find_ability_bool(tag_name, loc);
+	ability_bool_cache_.insert(std::make_pair(key, res));
+	return res;
+}
+
+bool unit::find_ability_bool(const std::string& tag_name, const map_location& loc) const
 {
 	assert(resources::teams);
 
-	if (const config &abilities = cfg_.child("abilities"))
+	if (const config &abilities = cfg_.child(config_keys::abilities))
 	{
 		BOOST_FOREACH(const config &i, abilities.child_range(tag_name)) {
 			if (ability_active(tag_name, i, loc) &&
@@ -133,7 +153,7 @@ bool unit::get_ability_bool(const std::string& tag_name, const map_location& loc
 		// ourself.
 		if ( &*it == this )
 			continue;
-		const config &adj_abilities = it->cfg_.child("abilities");
+		const config &adj_abilities = it->cfg_.child(config_keys::abilities);
 		if (!adj_abilities)
 			continue;
 		BOOST_FOREACH(const config &j, adj_abilities.child_range(tag_name)) {
@@ -147,13 +167,30 @@ bool unit::get_ability_bool(const std::string& tag_name, const map_location& loc
 
 	return false;
 }
+
 unit_ability_list unit::get_abilities(const std::string& tag_name, const map_location& loc) const
+{
+	check_ability_cache();
+	const ability_cache_key key(tag_name, loc);
+	std::map<ability_cache_key, unit_ability_list>::const_iterator cached = ability_cache_.find(key);
+	if(cached != ability_cache_.end()) {
+		return cached->second;
+	}
+	if(ability_cache_.size() >= max_cached_abilities) {
+		ability_cache_.clear();
+	}
+	const unit_ability_list res = find_abilities(tag_name, loc);
+	ability_cache_.insert(std::make_pair(key, res));
+	return res;
+}
+
+unit_ability_list unit::find_abilities(const std::string& tag_name, const map_location& loc) const
 {
 	assert(resources::teams);
 
 	unit_ability_list res;
 
-	if (const config &abilities = cfg_.child("abilities"))
+	if (const config &abilities = cfg_.child(config_keys::abilities))
 	{
 		BOOST_FOREACH(const config &i, abilities.child_range(tag_name)) {
 			if (ability_active(tag_name, i, loc) &&
@@ -176,7 +213,7 @@ unit_ability_list unit::get_abilities(const std::string& tag_name, const map_loc
 		// ourself.
 		if ( &*it == this )
 			continue;
-		const config &adj_abilities = it->cfg_.child("abilities");
+		const config &adj_abilities = it->cfg_.child(config_keys::abilities);
 		if (!adj_abilities)
 			continue;
 		BOOST_FOREACH(const config &j, adj_abilities.child_range(tag_name)) {
@@ -195,10 +232,10 @@ std::vector<std::string> unit::get_ability_list() const
 {
 	std::vector<std::string> res;
 
-	const config &abilities = cfg_.child("abilities");
+	const config &abilities = cfg_.child(config_keys::abilities);
 	if (!abilities) return res;
 	BOOST_FOREACH(const config::any_child &ab, abilities.all_children_range()) {
-		std::string const &id = ab.cfg["id"];
+		std::string const &id = ab.cfg[config_keys::id];
 		if (!id.empty())
 			res.push_back(id);
 	}
@@ -250,7 +287,7 @@ std::vector<boost::tuple<t_string,t_string,t_string> > unit::ability_tooltips(st
 	if ( active_list )
 		active_list->clear();
 
-	const config &abilities = cfg_.child("abilities");
+	const config &abilities = cfg_.child(config_keys::abilities);
 	if (!abilities) return res;
 
 	BOOST_FOREACH(const config::any_child &ab, abilities.all_children_range())
@@ -262,9 +299,9 @@ std::vector<boost::tuple<t_string,t_string,t_string> > unit::ability_tooltips(st
 
 			if (!name.empty()) {
 				res.push_back(boost::make_tuple(
-						ab.cfg["name"].t_str(),
+						ab.cfg[config_keys::name].t_str(),
 						name,
-						legacy::ability_description(ab.cfg["description"].t_str()) ));
+						legacy::ability_description(ab.cfg[config_keys::description].t_str()) ));
 				if ( active_list )
 					active_list->push_back(true);
 			}
@@ -300,7 +337,7 @@ bool unit::ability_active(const std::string& ability,const config& cfg,const map
 	bool illuminates = ability == "illuminates";
 	assert(resources::units && resources::gameboard && resources::teams && resources::tod_manager);
 
-	if (const config &afilter = cfg.child("filter"))
+	if (const config &afilter = cfg.child(config_keys::filter))
 		if ( !unit_filter(vconfig(afilter), resources::filter_con, illuminates).matches(*this, loc) )
 			return false;
 
@@ -308,10 +345,10 @@ bool unit::ability_active(const std::string& ability,const config& cfg,const map
 	get_adjacent_tiles(loc,adjacent);
 	const unit_map& units = *resources::units;
 
-	BOOST_FOREACH(const config &i, cfg.child_range("filter_adjacent"))
+	BOOST_FOREACH(const config &i, cfg.child_range(config_keys::filter_adjacent))
 	{
 		const unit_filter ufilt(vconfig(i), resources::filter_con, illuminates);
-		BOOST_FOREACH(const std::string &j, utils::split(i["adjacent"]))
+		BOOST_FOREACH(const std::string &j, utils::split(i[config_keys::adjacent]))
 		{
 			map_location::DIRECTION index =
 				map_location::parse_direction(j);
@@ -325,12 +362,12 @@ bool unit::ability_active(const std::string& ability,const config& cfg,const map
 		}
 	}
 
-	BOOST_FOREACH(const config &i, cfg.child_range("filter_adjacent_location"))
+	BOOST_FOREACH(const config &i, cfg.child_range(config_keys::filter_adjacent_location))
 	{
 		terrain_filter adj_filter(vconfig(i), resources::filter_con);
 		adj_filter.flatten(illuminates);
 
-		BOOST_FOREACH(const std::string &j, utils::split(i["adjacent"]))
+		BOOST_FOREACH(const std::string &j, utils::split(i[config_keys::adjacent]))
 		{
 			map_location::DIRECTION index = map_location::parse_direction(j);
 			if (index == map_location::NDIRECTIONS) {
@@ -355,14 +392,14 @@ bool unit::ability_affects_adjacent(const std::string& ability, const config& cf
 	assert(dir >=0 && dir <= 5);
 	static const std::string adjacent_names[6] = {"n","ne","se","s","sw","nw"};
 
-	BOOST_FOREACH(const config &i, cfg.child_range("affect_adjacent"))
+	BOOST_FOREACH(const config &i, cfg.child_range(config_keys::affect_adjacent))
 	{
-		if (i.has_attribute("adjacent")) { //key adjacent defined
-			std::vector<std::string> dirs = utils::split(i["adjacent"]);
+		if (i.has_attribute(config_keys::adjacent)) { //key adjacent defined
+			std::vector<std::string> dirs = utils::split(i[config_keys::adjacent]);
 			if (std::find(dirs.begin(),dirs.end(),adjacent_names[dir]) == dirs.end())
 				continue;
 		}
-		const config &filter = i.child("filter");
+		const config &filter = i.child(config_keys::filter);
 		if (!filter || //filter tag given
 			unit_filter(vconfig(filter), resources::filter_con, illuminates).matches(*this, loc) ) {
 			return true;
@@ -377,15 +414,15 @@ bool unit::ability_affects_adjacent(const std::string& ability, const config& cf
  */
 bool unit::ability_affects_self(const std::string& ability,const config& cfg,const map_location& loc) const
 {
-	const config &filter = cfg.child("filter_self");
-	bool affect_self = cfg["affect_self"].to_bool(true);
+	const config &filter = cfg.child(config_keys::filter_self);
+	bool affect_self = cfg[config_keys::affect_self].to_bool(true);
 	if (!filter || !affect_self) return affect_self;
 	return unit_filter(vconfig(filter), resources::filter_con, ability == "illuminates").matches(*this, loc);
 }
 
 bool unit::has_ability_type(const std::string& ability) const
 {
-	if (const config &list = cfg_.child("abilities")) {
+	if (const config &list = cfg_.child(config_keys::abilities)) {
 		config::const_child_itors itors = list.child_range(ability);
 		return itors.first != itors.second;
 	}
@@ -408,7 +445,7 @@ std::pair<int,map_location> unit_ability_list::highest(const std::string& key, i
 	BOOST_FOREACH(unit_ability const &p, cfgs_)
 	{
 		int value = (*p.first)[key].to_int(def);
-		if ((*p.first)["cumulative"].to_bool()) {
+		if ((*p.first)[config_keys::cumulative].to_bool()) {
 			stack += value;
 			if (value < 0) value = -value;
 			if (only_cumulative && value >= abs_max) {
@@ -439,7 +476,7 @@ std::pair<int,map_location> unit_ability_list::lowest(const std::string& key, in
 	BOOST_FOREACH(unit_ability const &p, cfgs_)
 	{
 		int value = (*p.first)[key].to_int(def);
-		if ((*p.first)["cumulative"].to_bool()) {
+		if ((*p.first)[config_keys::cumulative].to_bool()) {
 			stack += value;
 			if (value < 0) value = -value;
 			if (only_cumulative && value <= abs_max) {
@@ -500,7 +537,7 @@ namespace {
 	                           const std::string& id, bool just_peeking=false) {
 		BOOST_FOREACH(const config::any_child &sp, parent.all_children_range())
 		{
-			if (sp.key == id || sp.cfg["id"] == id) {
+			if (sp.key == id || sp.cfg[config_keys::id] == id) {
 				if(just_peeking) {
 					return true; // peek succeeded; done
 				} else {
@@ -590,9 +627,9 @@ std::vector<std::pair<t_string, t_string> > attack_type::special_tooltips(
 	BOOST_FOREACH(const config::any_child &sp, specials_.all_children_range())
 	{
 		if ( !active_list || special_active(sp.cfg, AFFECT_EITHER) ) {
-			const t_string &name = sp.cfg["name"];
+			const t_string &name = sp.cfg[config_keys::name];
 			if (!name.empty()) {
-				res.push_back(std::make_pair(name, legacy::ability_description(sp.cfg["description"].t_str()) ));
+				res.push_back(std::make_pair(name, legacy::ability_description(sp.cfg[config_keys::description].t_str()) ));
 				if ( active_list )
 					active_list->push_back(true);
 			}
@@ -625,7 +662,7 @@ std::string attack_type::weapon_specials(bool only_active, bool is_backstab) con
 		if ( only_active  &&  !special_active(sp.cfg, AFFECT_EITHER, is_backstab) )
 			continue;
 
-		std::string const &name = sp.cfg["name"].str();
+		std::string const &name = sp.cfg[config_keys::name].str();
 		if (!name.empty()) {
 			if (!res.empty()) res += ',';
 			res += name;
@@ -721,7 +758,7 @@ namespace { // Helpers for attack_type::special_active()
 	bool special_affects_opponent(const config& special, bool is_attacker)
 	{
 		//log_scope("special_affects_opponent");
-		std::string const &apply_to = special["apply_to"];
+		std::string const &apply_to = special[config_keys::apply_to];
 		if ( apply_to.empty() )
 			return false;
 		if ( apply_to == "both" )
@@ -743,7 +780,7 @@ namespace { // Helpers for attack_type::special_active()
 	bool special_affects_self(const config& special, bool is_attacker)
 	{
 		//log_scope("special_affects_self");
-		std::string const &apply_to = special["apply_to"];
+		std::string const &apply_to = special[config_keys::apply_to];
 		if ( apply_to.empty() )
 			return true;
 		if ( apply_to == "both" )
@@ -790,7 +827,7 @@ namespace { // Helpers for attack_type::special_active()
 			return false;
 
 		// Check for a weapon match.
-		if ( const config & filter_weapon = filter_child.child("filter_weapon") ) {
+		if ( const config & filter_weapon = filter_child.child(config_keys::filter_weapon) ) {
 			if ( !weapon || !weapon->matches_filter(filter_weapon) )
 				return false;
 		}
@@ -817,7 +854,7 @@ bool attack_type::special_active(const config& special, AFFECTS whom,
 
 	// Backstab check
 	if ( !include_backstab )
-		if ( special["backstab"].to_bool() )
+		if ( special[config_keys::backstab].to_bool() )
 			return false;
 
 	// Does this affect the specified unit?
@@ -831,7 +868,7 @@ bool attack_type::special_active(const config& special, AFFECTS whom,
 	}
 
 	// Is this active on attack/defense?
-	const std::string & active_on = special["active_on"];
+	const std::string & active_on = special[config_keys::active_on];
 	if ( !active_on.empty() ) {
 		if ( is_attacker_  &&  active_on != "offense" )
 			return false;
@@ -853,22 +890,22 @@ bool attack_type::special_active(const config& special, AFFECTS whom,
 	const attack_type * def_weapon = is_attacker_ ? other_attack_ : this;
 
 	// Filter the units involved.
-	if ( !special_unit_matches(self, self_loc_, this, special, "filter_self") )
+	if ( !special_unit_matches(self, self_loc_, this, special, config_keys::filter_self) )
 		return false;
-	if ( !special_unit_matches(other, other_loc_, other_attack_, special, "filter_opponent") )
+	if ( !special_unit_matches(other, other_loc_, other_attack_, special, config_keys::filter_opponent) )
 		return false;
-	if ( !special_unit_matches(att, att_loc, att_weapon, special, "filter_attacker") )
+	if ( !special_unit_matches(att, att_loc, att_weapon, special, config_keys::filter_attacker) )
 		return false;
-	if ( !special_unit_matches(def, def_loc, def_weapon, special, "filter_defender") )
+	if ( !special_unit_matches(def, def_loc, def_weapon, special, config_keys::filter_defender) )
 		return false;
 
 	map_location adjacent[6];
 	get_adjacent_tiles(self_loc_, adjacent);
 
 	// Filter the adjacent units.
-	BOOST_FOREACH(const config &i, special.child_range("filter_adjacent"))
+	BOOST_FOREACH(const config &i, special.child_range(config_keys::filter_adjacent))
 	{
-		BOOST_FOREACH(const std::string &j, utils::split(i["adjacent"]))
+		BOOST_FOREACH(const std::string &j, utils::split(i[config_keys::adjacent]))
 		{
 			map_location::DIRECTION index =
 				map_location::parse_direction(j);
@@ -882,9 +919,9 @@ bool attack_type::special_active(const config& special, AFFECTS whom,
 	}
 
 	// Filter the adjacent locations.
-	BOOST_FOREACH(const config &i, special.child_range("filter_adjacent_location"))
+	BOOST_FOREACH(const config &i, special.child_range(config_keys::filter_adjacent_location))
 	{
-		BOOST_FOREACH(const std::string &j, utils::split(i["adjacent"]))
+		BOOST_FOREACH(const std::string &j, utils::split(i[config_keys::adjacent]))
 		{
 			map_location::DIRECTION index =
 				map_location::parse_direction(j);
@@ -915,13 +952,13 @@ void individual_effect::set(value_modifier t, int val, const config *abil, const
 
 bool filter_base_matches(const config& cfg, int def)
 {
-	if (const config &apply_filter = cfg.child("filter_base_value")) {
-		config::attribute_value cond_eq = apply_filter["equals"];
-		config::attribute_value cond_ne = apply_filter["not_equals"];
-		config::attribute_value cond_lt = apply_filter["less_than"];
-		config::attribute_value cond_gt = apply_filter["greater_than"];
-		config::attribute_value cond_ge = apply_filter["greater_than_equal_to"];
-		config::attribute_value cond_le = apply_filter["less_than_equal_to"];
+	if (const config &apply_filter = cfg.child(config_keys::filter_base_value)) {
+		config::attribute_value cond_eq = apply_filter[config_keys::equals];
+		config::attribute_value cond_ne = apply_filter[config_keys::not_equals];
+		config::attribute_value cond_lt = apply_filter[config_keys::less_than];
+		config::attribute_value cond_gt = apply_filter[config_keys::greater_than];
+		config::attribute_value cond_ge = apply_filter[config_keys::greater_than_equal_to];
+		config::attribute_value cond_le = apply_filter[config_keys::less_than_equal_to];
 		return  (cond_eq.empty() || def == cond_eq.to_int()) &&
 			(cond_ne.empty() || def != cond_ne.to_int()) &&
 			(cond_lt.empty() || def <  cond_lt.to_int()) &&
@@ -947,16 +984,16 @@ effect::effect(const unit_ability_list& list, int def, bool backstab) :
 
 	BOOST_FOREACH (const unit_ability & ability, list) {
 		const config& cfg = *ability.first;
-		std::string const &effect_id = cfg[cfg["id"].empty() ? "name" : "id"];
+		std::string const &effect_id = cfg[cfg[config_keys::id].empty() ? config_keys::name : config_keys::id];
 
-		if (!backstab && cfg["backstab"].to_bool())
+		if (!backstab && cfg[config_keys::backstab].to_bool())
 			continue;
 		if (!filter_base_matches(cfg, def))
 			continue;
 
-		if (const config::attribute_value *v = cfg.get("value")) {
+		if (const config::attribute_value *v = cfg.get(config_keys::value)) {
 			int value = *v;
-			bool cumulative = cfg["cumulative"].to_bool();
+			bool cumulative = cfg[config_keys::cumulative].to_bool();
 			if (!value_is_set && !cumulative) {
 				value_set = value;
 				set_effect.set(SET, value, ability.first, ability.second);
@@ -970,28 +1007,28 @@ effect::effect(const unit_ability_list& list, int def, bool backstab) :
 			value_is_set = true;
 		}
 
-		if (const config::attribute_value *v = cfg.get("add")) {
+		if (const config::attribute_value *v = cfg.get(config_keys::add)) {
 			int add = *v;
 			std::map<std::string,individual_effect>::iterator add_effect = values_add.find(effect_id);
 			if(add_effect == values_add.end() || add > add_effect->second.value) {
 				values_add[effect_id].set(ADD, add, ability.first, ability.second);
 			}
 		}
-		if (const config::attribute_value *v = cfg.get("sub")) {
+		if (const config::attribute_value *v = cfg.get(config_keys::sub)) {
 			int sub = - *v;
 			std::map<std::string,individual_effect>::iterator sub_effect = values_add.find(effect_id);
 			if(sub_effect == values_add.end() || sub > sub_effect->second.value) {
 				values_add[effect_id].set(ADD, sub, ability.first, ability.second);
 			}
 		}
-		if (const config::attribute_value *v = cfg.get("multiply")) {
+		if (const config::attribute_value *v = cfg.get(config_keys::multiply)) {
 			int multiply = int(v->to_double() * 100);
 			std::map<std::string,individual_effect>::iterator mul_effect = values_mul.find(effect_id);
 			if(mul_effect == values_mul.end() || multiply > mul_effect->second.value) {
 				values_mul[effect_id].set(MUL, multiply, ability.first, ability.second);
 			}
 		}
-		if (const config::attribute_value *v = cfg.get("divide")) {
+		if (const config::attribute_value *v = cfg.get(config_keys::divide)) {
 			if (*v == 0) {
 				ERR_NG << "division by zero with divide= in ability/weapon special " << effect_id << std::endl;
 			}
@@ -861,6 +861,7 @@ void unit_animation::particule::override(int start_time
 
 bool unit_animation::particule::need_update() const
 {
+	if(image_delayed_) return true;
 	if(animated<unit_frame>::need_update()) return true;
 	if(get_current_frame().need_update()) return true;
 	if(parameters_.need_update()) return true;
@@ -882,7 +883,9 @@ unit_animation::particule::particule(
 		parameters_(),
 		halo_id_(),
 		last_frame_begin_time_(0),
-		cycles_(false)
+		cycles_(false),
+		shown_image_(),
+		image_delayed_(false)
 {
 	config::const_child_itors range = cfg.child_range(frame_string+"frame");
 	starting_frame_time_=INT_MAX;
@@ -1048,6 +1051,16 @@ void unit_animation::clear_haloes()
 		anim_itor->second.clear_halo();
 	}
 }
+
+void unit_animation::prefetch_sounds() const
+{
+	unit_anim_.prefetch_sounds();
+	for(std::map<std::string,particule>::const_iterator anim_itor = sub_anims_.begin();
+			anim_itor != sub_anims_.end(); ++anim_itor) {
+		anim_itor->second.prefetch_sounds();
+	}
+}
+
 bool unit_animation::invalidate(frame_parameters& value)
 {
 	if(invalidated_) return false;
@@ -1234,9 +1247,9 @@ void unit_animation::particule::redraw(const frame_parameters& value,const map_l
 	// for sound frames we want the first time variable set only after the frame has started.
 	if(get_current_frame_begin_time() != last_frame_begin_time_ && animation_time >= get_current_frame_begin_time()) {
 		last_frame_begin_time_ = get_current_frame_begin_time();
-		current_frame.redraw(get_current_frame_time(),true,in_scope_of_frame,src,dst,halo_id_,halo_man,default_val,value);
+		image_delayed_ = current_frame.redraw(get_current_frame_time(),true,in_scope_of_frame,src,dst,halo_id_,halo_man,default_val,value,shown_image_);
 	} else {
-		current_frame.redraw(get_current_frame_time(),false,in_scope_of_frame,src,dst,halo_id_,halo_man,default_val,value);
+		image_delayed_ = current_frame.redraw(get_current_frame_time(),false,in_scope_of_frame,src,dst,halo_id_,halo_man,default_val,value,shown_image_);
 	}
 }
 void unit_animation::particule::clear_halo()
@@ -1262,6 +1275,19 @@ void unit_animation::particule::start_animation(int start_time)
 	parameters_.override(get_animation_duration());
 	animated<unit_frame>::start_animation(start_time,cycles_);
 	last_frame_begin_time_ = get_begin_time() -1;
+	// decode the images of the coming frames in the background
+	parameters_.prefetch_images();
+	for(size_t i = 0; i != get_frames_count(); ++i) {
+		get_frame(i).prefetch_images();
+	}
+}
+
+void unit_animation::particule::prefetch_sounds() const
+{
+	parameters_.prefetch_sounds();
+	for(size_t i = 0; i != get_frames_count(); ++i) {
+		get_frame(i).prefetch_sounds();
+	}
 }
 
 
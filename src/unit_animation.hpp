@@ -65,6 +65,8 @@ class unit_animation
 		void redraw(frame_parameters& value, halo::manager & halo_man);
 		void clear_haloes();
 		bool invalidate(frame_parameters& value );
+		/** Starts loading the sounds of all the frames, see sound::prefetch_sound(). */
+		void prefetch_sounds() const;
 		std::string debug() const;
 		friend std::ostream& operator << (std::ostream& outstream, const unit_animation& u_animation);
 
@@ -92,7 +94,9 @@ class unit_animation
 				parameters_(builder),
 				halo_id_(),
 				last_frame_begin_time_(0),
-				cycles_(false)
+				cycles_(false),
+				shown_image_(),
+				image_delayed_(false)
 				{}
 			explicit particule(const config& cfg
 					, const std::string& frame_string ="frame");
@@ -113,6 +117,7 @@ class unit_animation
 			void redraw( const frame_parameters& value,const map_location &src, const map_location &dst, halo::manager & halo_man);
 			std::set<map_location> get_overlaped_hex(const frame_parameters& value,const map_location &src, const map_location &dst);
 			void start_animation(int start_time);
+			void prefetch_sounds() const;
 			const frame_parameters parameters(const frame_parameters & default_val) const { return get_current_frame().merge_parameters(get_current_frame_time(),parameters_.parameters(get_animation_time()-get_begin_time()),default_val); }
 			void clear_halo();
 			bool accelerate;
@@ -123,6 +128,10 @@ class unit_animation
 			halo::handle halo_id_;
 			int last_frame_begin_time_;
 			bool cycles_;
+			/** The image drawn last, shown while the current one is decoded. */
+			image::locator shown_image_;
+			/** Whether the last redraw() showed shown_image_ instead. */
+			bool image_delayed_;
 
 	};
 		t_translation::t_list terrain_types_;
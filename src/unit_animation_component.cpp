@@ -29,7 +29,10 @@ const unit_animation* unit_animation_component::choose_animation(const display&
 	// Select one of the matching animations at random
 	std::vector<const unit_animation*> options;
 	int max_val = unit_animation::MATCH_FAIL;
-	for(std::vector<unit_animation>::const_iterator i = animations_.begin(); i != animations_.end(); ++i) {
+	if(!animations_) {
+		return NULL;
+	}
+	for(std::vector<unit_animation>::const_iterator i = animations_->begin(); i != animations_->end(); ++i) {
 		int matching = i->matches(disp,loc,second_loc,&u_,event,value,hit,attack,second_attack,swing_num);
 		if(matching > unit_animation::MATCH_FAIL && matching == max_val) {
 			options.push_back(&*i);
@@ -184,7 +187,7 @@ bool unit_animation_component::invalidate (const display & disp)
 void unit_animation_component::reset_after_advance(const unit_type * newtype)
 {
 	if (newtype) {
-		animations_ = newtype->animations();
+		animations_ = newtype->shared_animations();
 	}
 
 	refreshing_ = false;
@@ -192,14 +195,18 @@ void unit_animation_component::reset_after_advance(const unit_type * newtype)
 }
 
 void unit_animation_component::apply_new_animation_effect(const config & effect) {
+	// The animations may be shared; add to a copy of them.
+	boost::shared_ptr<std::vector<unit_animation> > animations(animations_ ?
+		new std::vector<unit_animation>(*animations_) : new std::vector<unit_animation>);
 	if(effect["id"].empty()) {
-		unit_animation::add_anims(animations_, effect);
+		unit_animation::add_anims(*animations, effect);
 	} else {
 		static std::map< std::string, std::vector<unit_animation> > animation_cache;
 		std::vector<unit_animation> &built = animation_cache[effect["id"]];
 		if(built.empty()) {
 			unit_animation::add_anims(built, effect);
 		}
-		animations_.insert(animations_.end(),built.begin(),built.end());
+		animations->insert(animations->end(),built.begin(),built.end());
 	}
+	animations_ = animations;
 }
@@ -18,15 +18,60 @@
 #define UNIT_ANIM_COMP_HPP
 
 #include "halo.hpp"
+#include "sdl/rect.hpp"
+#include "sdl/utils.hpp"
 #include "unit_animation.hpp" //Note: only needed for enum
 
 #include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
 
 class config;
 class unit;
 class unit_drawer;
 class unit_type;
 
+/**
+ * A piece of the bars of a unit: an image, or a rectangle filled with a
+ * color if the image is null.
+ */
+struct unit_bar_piece
+{
+	surface image;
+	SDL_Rect clip;
+	int x, y;
+	SDL_Color fill;
+
+	bool operator==(const unit_bar_piece& p) const
+	{
+		return image.get() == p.image.get() && clip == p.clip
+			&& x == p.x && y == p.y && fill == p.fill;
+	}
+};
+
+/**
+ * The orb, bars, crown and overlays of a unit, composed by unit_drawer into
+ * a single image which is drawn again as long as its pieces don't change.
+ */
+struct unit_bars
+{
+	unit_bars() :
+		pieces(),
+		image(),
+#ifdef SDL_GPU
+		texture(),
+#endif
+		x(0),
+		y(0) {}
+
+	std::vector<unit_bar_piece> pieces;
+	surface image;
+#ifdef SDL_GPU
+	sdl::timage texture;
+#endif
+	/** The offset of image from the hex the unit is drawn in. */
+	int x, y;
+};
+
 class unit_animation_component
 {
 public:
@@ -46,7 +91,8 @@ public:
 		frame_begin_time_(0),
 		draw_bars_(false),
 		refreshing_(false),
-		unit_halo_() {}
+		unit_halo_(),
+		bars_() {}
 
 	/** Copy construct a unit animation component, for use when copy constructing a unit. */
 	unit_animation_component(unit & my_unit, const unit_animation_component & o) :
@@ -58,7 +104,8 @@ public:
 		frame_begin_time_(o.frame_begin_time_),
 		draw_bars_(o.draw_bars_),
 		refreshing_(o.refreshing_),
-		unit_halo_() {}
+		unit_halo_(),
+		bars_() {}
 
 	/** Chooses an appropriate animation from the list of known animations. */
 	const unit_animation* choose_animation(const display& disp,
@@ -113,7 +160,11 @@ private:
 	const unit & u_; /**< A reference to the unit that owns this object. It does so with a scoped pointer, so this reference should not dangle. */
 
 	boost::scoped_ptr<unit_animation> anim_; /**< The current animation. */
-	std::vector<unit_animation> animations_; /**< List of registered animations for this unit. */
+	/**
+	 * List of registered animations for this unit, shared with its type
+	 * (and the copies of the unit) until an effect adds to it.
+	 */
+	boost::shared_ptr<const std::vector<unit_animation> > animations_;
 
 	STATE state_; //!< animation state
 
@@ -124,6 +175,8 @@ private:
 	bool refreshing_; //!< avoid infinite recursion. flag used for drawing / animation
 
 	halo::handle unit_halo_; //!< handle to the halo of this unit
+
+	unit_bars bars_; //!< the bars last drawn by unit_drawer
 };
 
 #endif
@@ -29,6 +29,34 @@
 
 #include <boost/foreach.hpp>
 
+namespace {
+
+/** Adds the part @a clip of @a image, drawn at x, y, to the pieces of the bars. */
+void add_piece(std::vector<unit_bar_piece>& pieces, const surface& image,
+		SDL_Rect clip, int x, int y)
+{
+	if(image == NULL) {
+		return;
+	}
+	clip.w = std::min<int>(clip.w, image->w - clip.x);
+	clip.h = std::min<int>(clip.h, image->h - clip.y);
+	if(clip.w <= 0 || clip.h <= 0) {
+		return;
+	}
+
+	const unit_bar_piece piece = { image, clip, x, y, create_color(0, 0, 0, 0) };
+	pieces.push_back(piece);
+}
+
+void add_piece(std::vector<unit_bar_piece>& pieces, const surface& image, int x, int y)
+{
+	if(image != NULL) {
+		add_piece(pieces, image, sdl::create_rect(0, 0, image->w, image->h), x, y);
+	}
+}
+
+}
+
 unit_drawer::unit_drawer(display & thedisp, std::map<surface,SDL_Rect> & bar_rects) :
 	disp(thedisp),
 	dc(disp.get_disp_context()),
@@ -249,6 +277,7 @@ void unit_drawer::redraw_unit (const unit & u) const
 	}
 #endif
 	if(draw_bars) {
+		std::vector<unit_bar_piece> bars;
 		const image::locator* orb_img = NULL;
 		const surface unit_img = image::get_image(u.default_anim_image(), image::SCALED_TO_ZOOM);
 		const int xoff = (hex_size - unit_img->w)/2;
@@ -298,8 +327,7 @@ void unit_drawer::redraw_unit (const unit & u) const
 
 		if (orb_img != NULL) {
 			surface orb(image::get_image(*orb_img,image::SCALED_TO_ZOOM));
-			disp.drawing_buffer_add(display::LAYER_UNIT_BAR,
-				loc, xsrc + xoff, ysrc + yoff + adjusted_params.y, orb);
+			add_piece(bars, orb, xoff, yoff);
 		}
 
 		double unit_energy = 0.0;
@@ -311,44 +339,32 @@ void unit_drawer::redraw_unit (const unit & u) const
 
 		const fixed_t bar_alpha = (loc == mouse_hex || loc == sel_hex) ? ftofxp(1.0): ftofxp(0.8);
 
-		draw_bar(*energy_file, xsrc+xoff+bar_shift, ysrc+yoff+adjusted_params.y,
-			loc, hp_bar_height, unit_energy,hp_color, bar_alpha);
+		add_bar(*energy_file, xoff+bar_shift, yoff,
+			hp_bar_height, unit_energy, hp_color, bar_alpha, bars);
 
 		if(experience > 0 && can_advance) {
 			const double filled = double(experience)/double(max_experience);
 
 			const int xp_bar_height = static_cast<int>(max_experience * u.xp_bar_scaling() / std::max<int>(u.level(),1));
 
-			draw_bar(*energy_file, xsrc+xoff, ysrc+yoff+adjusted_params.y,
-				loc, xp_bar_height, filled, xp_color, bar_alpha);
+			add_bar(*energy_file, xoff, yoff,
+				xp_bar_height, filled, xp_color, bar_alpha, bars);
 		}
 
 		if (can_recruit) {
 			surface crown(image::get_image(u.leader_crown(),image::SCALED_TO_ZOOM));
-			if(!crown.null()) {
-				//if(bar_alpha != ftofxp(1.0)) {
-				//	crown = adjust_surface_alpha(crown, bar_alpha);
-				//}
-				disp.drawing_buffer_add(display::LAYER_UNIT_BAR,
-					loc, xsrc+xoff, ysrc+yoff+adjusted_params.y, crown);
-			}
+			//if(bar_alpha != ftofxp(1.0)) {
+			//	crown = adjust_surface_alpha(crown, bar_alpha);
+			//}
+			add_piece(bars, crown, xoff, yoff);
 		}
 
 		for(std::vector<std::string>::const_iterator ov = u.overlays().begin(); ov != u.overlays().end(); ++ov) {
-#ifdef SDL_GPU
-			const sdl::timage ov_img(image::get_texture(*ov, image::SCALED_TO_ZOOM));
-			if(!ov_img.null()) {
-				disp.drawing_buffer_add(display::LAYER_UNIT_BAR,
-					loc, xsrc, ysrc +adjusted_params.y, ov_img);
-			}
-#else
 			const surface ov_img(image::get_image(*ov, image::SCALED_TO_ZOOM));
-			if(ov_img != NULL) {
-				disp.drawing_buffer_add(display::LAYER_UNIT_BAR,
-					loc, xsrc+xoff, ysrc+yoff+adjusted_params.y, ov_img);
-			}
-#endif
+			add_piece(bars, ov_img, xoff, yoff);
 		}
+
+		draw_unit_bars(ac.bars_, bars, loc, xsrc, ysrc + adjusted_params.y);
 	}
 
 	// Smooth unit movements from terrain of different elevation.
@@ -370,10 +386,9 @@ void unit_drawer::redraw_unit (const unit & u) const
 	ac.refreshing_ = false;
 }
 
-//TODO: proper SDL_gpu implementation
-void unit_drawer::draw_bar(const std::string& image, int xpos, int ypos,
-		const map_location& loc, size_t height, double filled,
-		const SDL_Color& col, fixed_t alpha) const
+void unit_drawer::add_bar(const std::string& image, int xpos, int ypos,
+		size_t height, double filled, const SDL_Color& col, fixed_t alpha,
+		std::vector<unit_bar_piece>& pieces) const
 {
 
 	filled = std::min<double>(std::max<double>(filled,0.0),1.0);
@@ -424,30 +439,71 @@ void unit_drawer::draw_bar(const std::string& image, int xpos, int ypos,
 	SDL_Rect bot = sdl::create_rect(0, bar_loc.y + skip_rows, surf->w, 0);
 	bot.h = surf->w - bot.y;
 
-#ifdef SDL_GPU
-	sdl::timage img(surf);
-	img.set_clip(top);
-	disp.drawing_buffer_add(display::LAYER_UNIT_BAR, loc, xpos, ypos, surf);
-	img.set_clip(bot);
-	disp.drawing_buffer_add(display::LAYER_UNIT_BAR, loc, xpos, ypos + top.h, surf);
-#else
-	disp.drawing_buffer_add(display::LAYER_UNIT_BAR, loc, xpos, ypos, surf, top);
-	disp.drawing_buffer_add(display::LAYER_UNIT_BAR, loc, xpos, ypos + top.h, surf, bot);
-#endif
+	add_piece(pieces, surf, top, xpos, ypos);
+	add_piece(pieces, surf, bot, xpos, ypos + top.h);
 
 	size_t unfilled = static_cast<size_t>(height * (1.0 - filled));
 
 	if(unfilled < height && alpha >= ftofxp(0.3)) {
 		const Uint8 r_alpha = std::min<unsigned>(unsigned(fxpmult(alpha,255)),255);
-		surface filled_surf = create_compatible_surface(bar_surf, bar_loc.w, height - unfilled);
-		SDL_Rect filled_area = sdl::create_rect(0, 0, bar_loc.w, height-unfilled);
-		sdl::fill_rect(filled_surf,&filled_area,SDL_MapRGBA(bar_surf->format,col.r,col.g,col.b, r_alpha));
+		const unit_bar_piece filled_area = {
+			surface(NULL),
+			sdl::create_rect(0, 0, bar_loc.w, height - unfilled),
+			xpos + bar_loc.x,
+			static_cast<int>(ypos + bar_loc.y + unfilled),
+			create_color(col.r, col.g, col.b, r_alpha)
+		};
+		pieces.push_back(filled_area);
+	}
+}
+
+void unit_drawer::draw_unit_bars(unit_bars& bars, const std::vector<unit_bar_piece>& pieces,
+		const map_location& loc, int xpos, int ypos) const
+{
+	if(pieces.empty()) {
+		return;
+	}
+
+	if(bars.image == NULL || pieces != bars.pieces) {
+		int left = pieces.front().x, top = pieces.front().y;
+		int right = left, bottom = top;
+		BOOST_FOREACH(const unit_bar_piece& piece, pieces) {
+			left = std::min(left, piece.x);
+			top = std::min(top, piece.y);
+			right = std::max(right, piece.x + piece.clip.w);
+			bottom = std::max(bottom, piece.y + piece.clip.h);
+		}
+
+		surface image(create_neutral_surface(right - left, bottom - top));
+		if(image == NULL) {
+			return;
+		}
+		BOOST_FOREACH(const unit_bar_piece& piece, pieces) {
+			const SDL_Rect dst = sdl::create_rect(piece.x - left, piece.y - top, 0, 0);
+			if(piece.image != NULL) {
+				blit_surface(piece.image, &piece.clip, image, &dst);
+			} else {
+				surface filled(create_neutral_surface(piece.clip.w, piece.clip.h));
+				sdl::fill_rect(filled, NULL, SDL_MapRGBA(filled->format,
+					piece.fill.r, piece.fill.g, piece.fill.b, piece.fill.a));
+				blit_surface(filled, NULL, image, &dst);
+			}
+		}
+
+		bars.pieces = pieces;
+		bars.image = image;
 #ifdef SDL_GPU
-		disp.drawing_buffer_add(display::LAYER_UNIT_BAR, loc, xpos + bar_loc.x, ypos + bar_loc.y + unfilled, sdl::timage(filled_surf));
-#else
-		disp.drawing_buffer_add(display::LAYER_UNIT_BAR, loc, xpos + bar_loc.x, ypos + bar_loc.y + unfilled, filled_surf);
+		bars.texture = sdl::timage(image);
 #endif
+		bars.x = left;
+		bars.y = top;
 	}
+
+#ifdef SDL_GPU
+	disp.drawing_buffer_add(display::LAYER_UNIT_BAR, loc, xpos + bars.x, ypos + bars.y, bars.texture);
+#else
+	disp.drawing_buffer_add(display::LAYER_UNIT_BAR, loc, xpos + bars.x, ypos + bars.y, bars.image);
+#endif
 }
 
 struct is_energy_color {
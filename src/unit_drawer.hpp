@@ -34,6 +34,8 @@ class gamemap;
 namespace halo { class manager; }
 class team;
 class unit;
+struct unit_bar_piece;
+struct unit_bars;
 
 struct SDL_Color;
 struct SDL_Rect;
@@ -72,10 +74,20 @@ public:
 	void redraw_unit(const unit & u) const;
 
 private:
-	/** draw a health/xp bar of a unit */
-	void draw_bar(const std::string& image, int xpos, int ypos,
-		const map_location& loc, size_t height, double filled,
-		const SDL_Color& col, fixed_t alpha) const;
+	/**
+	 * Adds the pieces of a health/xp bar of a unit, at xpos, ypos from the
+	 * hex the unit is drawn in.
+	 */
+	void add_bar(const std::string& image, int xpos, int ypos,
+		size_t height, double filled, const SDL_Color& col, fixed_t alpha,
+		std::vector<unit_bar_piece>& pieces) const;
+
+	/**
+	 * Draws the bars of a unit at xpos, ypos, composing them again only if
+	 * @a pieces differ from those cached in @a bars.
+	 */
+	void draw_unit_bars(unit_bars& bars, const std::vector<unit_bar_piece>& pieces,
+		const map_location& loc, int xpos, int ypos) const;
 
 	/**
 	 * Finds the start and end rows on the energy bar image.
@@ -40,6 +40,7 @@
 #include <boost/optional.hpp>
 #include <boost/make_shared.hpp>
 #include <boost/shared_ptr.hpp>
+#include <boost/unordered_set.hpp>
 #include <boost/utility/in_place_factory.hpp> //needed for boost::in_place to initialize optionals
 
 #include <vector>
@@ -103,7 +104,7 @@ namespace conditional {
 /// This class lazily parses an attribute value to a vector of strings
 class lazy_string_list {
 public:
-	lazy_string_list( const config::attribute_value & attr) : my_str_(), my_list_() {
+	lazy_string_list( const config::attribute_value & attr) : my_str_(), my_list_(), my_set_() {
 		if (attr.blank()) {
 			my_list_ = std::vector<std::string>();
 		} else {
@@ -124,11 +125,21 @@ public:
 
 	bool find(const std::string & str) const {
 		const std::vector<std::string> & vals = get();
-		return std::find(vals.begin(), vals.end(), str) != vals.end();
+		if (vals.size() <= max_searched_size) {
+			return std::find(vals.begin(), vals.end(), str) != vals.end();
+		}
+		// Long lists, as the type= of the units of a faction, get hashed.
+		if (!my_set_) {
+			my_set_ = boost::unordered_set<std::string>(vals.begin(), vals.end());
+		}
+		return my_set_->count(str) != 0;
 	}
 private:
+	static const size_t max_searched_size = 8;
+
 	std::string my_str_;
 	mutable boost::optional<std::vector<std::string> > my_list_;
+	mutable boost::optional<boost::unordered_set<std::string> > my_set_;
 };
 
 
@@ -251,6 +262,10 @@ public:
 
 	virtual ~basic_unit_filter_impl() {}
 private:
+	/// The units on the map that can match, by underlying id, when x=,y= or
+	/// side= restrict them to a few hexes or sides; false to try all the units.
+	bool get_candidates(std::vector<unit_map::const_unit_iterator> & res) const;
+
 	const filter_context & fc_;
 	bool use_flat_tod_;
 
@@ -353,6 +368,11 @@ bool basic_unit_filter_impl::matches(const unit & u, const map_location& loc) co
 	return matches;
 }
 
+/**
+ * The conditions are all required, and tested cheapest first: the attributes
+ * of the unit, then the filters of its side and location, then what involves
+ * other units, serializing the unit, or running WML formulas and Lua.
+ */
 bool basic_unit_filter_impl::internal_matches_filter(const unit & u, const map_location& loc) const
 {
 	if (!cfg_name_.blank() && cfg_name_.str() != u.name()) {
@@ -370,17 +390,6 @@ bool basic_unit_filter_impl::internal_matches_filter(const unit & u, const map_l
 		return false;
 	}
 
-	if(cfg_filter_loc_) {
-		if(!cfg_filter_loc_->match(loc)) {
-			return false;
-		}
-	}
-
-	if(cfg_filter_side_) {
-		if(!cfg_filter_side_->match(u.side()))
-			return false;
-	}
-
 	// Also allow filtering on location ranges outside of the location filter
 	if (!cfg_x_.blank() || !cfg_y_.blank()){
 		if(cfg_x_ == "recall" && cfg_y_ == "recall") {
@@ -494,6 +503,17 @@ bool basic_unit_filter_impl::internal_matches_filter(const unit & u, const map_l
 		return false;
 	}
 
+	if(cfg_filter_side_) {
+		if(!cfg_filter_side_->match(u.side()))
+			return false;
+	}
+
+	if(cfg_filter_loc_) {
+		if(!cfg_filter_loc_->match(loc)) {
+			return false;
+		}
+	}
+
 	if (!cfg_defense_.blank() && cfg_defense_.to_int(-1) != u.defense_modifier(fc_.get_disp_context().map().get_terrain(loc))) {
 		return false;
 	}
@@ -615,8 +635,89 @@ bool basic_unit_filter_impl::internal_matches_filter(const unit & u, const map_l
 	return true;
 }
 
+namespace {
+
+bool is_number(const std::string & str) {
+	return !str.empty() && str.find_first_not_of("0123456789") == std::string::npos;
+}
+
+/// Whether @a str is a list of numbers and of ranges of numbers, which
+/// map_location::matches_range() and gamemap::parse_location_range() read alike.
+bool is_simple_range_list(const std::string & str) {
+	BOOST_FOREACH(const std::string & range, utils::split(str)) {
+		const std::string::size_type dash = range.find('-');
+		if (dash == std::string::npos ? !is_number(range) :
+		    !is_number(range.substr(0, dash)) || !is_number(range.substr(dash + 1))) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool by_underlying_id(const unit_map::const_unit_iterator & a, const unit_map::const_unit_iterator & b) {
+	return a->underlying_id() < b->underlying_id();
+}
+
+bool same_unit(const unit_map::const_unit_iterator & a, const unit_map::const_unit_iterator & b) {
+	return a->underlying_id() == b->underlying_id();
+}
+
+} // end anonymous namespace
+
+bool basic_unit_filter_impl::get_candidates(std::vector<unit_map::const_unit_iterator> & res) const {
+	// An [or] can let any unit match.
+	if (std::find(cond_child_types_.begin(), cond_child_types_.end(), conditional::OR) != cond_child_types_.end()) {
+		return false;
+	}
+	const unit_map & units = fc_.get_disp_context().units();
+
+	if (!cfg_x_.blank() && !cfg_y_.blank() &&
+	    is_simple_range_list(cfg_x_.str()) && is_simple_range_list(cfg_y_.str())) {
+		const std::vector<map_location> & locs =
+			fc_.get_disp_context().map().parse_location_range(cfg_x_, cfg_y_, true);
+		if (locs.size() < units.size()) {
+			BOOST_FOREACH(const map_location & loc, locs) {
+				const unit_map::const_unit_iterator u = units.find(loc);
+				if (u.valid()) {
+					res.push_back(u);
+				}
+			}
+			std::sort(res.begin(), res.end(), by_underlying_id);
+			res.erase(std::unique(res.begin(), res.end(), same_unit), res.end());
+			return true;
+		}
+	}
+
+	if (!cfg_side_.empty()) {
+		BOOST_FOREACH(const std::string & side, cfg_side_.get()) {
+			if (!is_number(side)) {
+				return false;
+			}
+		}
+		BOOST_FOREACH(const std::string & side, cfg_side_.get()) {
+			const std::vector<unit_map::const_unit_iterator> & side_units = units.units_of_side(atoi(side.c_str()));
+			res.insert(res.end(), side_units.begin(), side_units.end());
+		}
+		if (cfg_side_.get().size() > 1) {
+			std::sort(res.begin(), res.end(), by_underlying_id);
+			res.erase(std::unique(res.begin(), res.end(), same_unit), res.end());
+		}
+		return true;
+	}
+	return false;
+}
+
 std::vector<const unit *> basic_unit_filter_impl::all_matches_on_map() const {
 	std::vector<const unit *> ret;
+	std::vector<unit_map::const_unit_iterator> candidates;
+	if (get_candidates(candidates)) {
+		BOOST_FOREACH(const unit_map::const_unit_iterator & u, candidates) {
+			if (matches(*u, u->get_location())) {
+				ret.push_back(&*u);
+			}
+		}
+		return ret;
+	}
 	BOOST_FOREACH(const unit & u, fc_.get_disp_context().units()) {
 		if (matches(u, u.get_location())) {
 			ret.push_back(&u);
@@ -627,6 +728,15 @@ std::vector<const unit *> basic_unit_filter_impl::all_matches_on_map() const {
 
 unit_const_ptr basic_unit_filter_impl::first_match_on_map() const {
 	const unit_map & units = fc_.get_disp_context().units();
+	std::vector<unit_map::const_unit_iterator> candidates;
+	if (get_candidates(candidates)) {
+		BOOST_FOREACH(const unit_map::const_unit_iterator & u, candidates) {
+			if (matches(*u, u->get_location())) {
+				return u.get_shared_ptr();
+			}
+		}
+		return unit_const_ptr();
+	}
 	for(unit_map::const_iterator u = units.begin(); u != units.end(); u++) {
 		if (matches(*u,u->get_location())) {
 			return u.get_shared_ptr();
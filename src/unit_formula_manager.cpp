@@ -25,8 +25,8 @@
 bool unit_formula_manager::matches_filter(const std::string & cfg_formula, const map_location & loc, const unit & me)
 {
 	const unit_callable callable(loc,me);
-	const game_logic::formula form(cfg_formula);
-	if(!form.evaluate(callable).as_bool()) {///@todo use formula_ai
+	const game_logic::const_formula_ptr form = game_logic::formula::get_cached(cfg_formula);
+	if(!form->evaluate(callable).as_bool()) {///@todo use formula_ai
 		return false;
 	}
 	return true;
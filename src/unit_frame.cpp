@@ -116,6 +116,13 @@ const image::locator& progressive_image::get_current_element(int current_time) c
 	return data_[sub_image].first;
 }
 
+void progressive_image::prefetch() const
+{
+	for(std::vector<std::pair<image::locator,int> >::const_iterator i = data_.begin(); i != data_.end(); ++i) {
+		image::prefetch(i->first);
+	}
+}
+
 static const std::string empty_string;
 
 const std::string& progressive_string::get_current_element(int current_time) const
@@ -513,6 +520,17 @@ bool frame_parsed_parameters::need_update() const
 	return false;
 }
 
+void frame_parsed_parameters::prefetch_images() const
+{
+	image_.prefetch();
+	image_diagonal_.prefetch();
+}
+
+void frame_parsed_parameters::prefetch_sounds() const
+{
+	sound::prefetch_sound(sound_);
+}
+
 const frame_parameters frame_parsed_parameters::parameters(int current_time) const
 {
 	frame_parameters result;
@@ -627,7 +645,7 @@ std::vector<std::string> frame_parsed_parameters::debug_strings() const {
 }
 
 
-void unit_frame::redraw(const int frame_time,bool on_start_time,bool in_scope_of_frame,const map_location & src,const map_location & dst,halo::handle & halo_id,halo::manager & halo_man, const frame_parameters & animation_val,const frame_parameters & engine_val)const
+bool unit_frame::redraw(const int frame_time,bool on_start_time,bool in_scope_of_frame,const map_location & src,const map_location & dst,halo::handle & halo_id,halo::manager & halo_man, const frame_parameters & animation_val,const frame_parameters & engine_val, image::locator & shown_image)const
 {
 	const int xsrc = game_display::get_singleton()->get_location_x(src);
 	const int ysrc = game_display::get_singleton()->get_location_y(src);
@@ -664,8 +682,16 @@ void unit_frame::redraw(const int frame_time,bool on_start_time,bool in_scope_of
 	}
 
 	surface image;
+	bool delayed = false;
 	if(!image_loc.is_void() && image_loc.get_filename() != "") { // invalid diag image, or not diagonal
-		image=image::get_image(image_loc, image::SCALED_TO_ZOOM);
+		if(!shown_image.is_void() && image::is_pending(image_loc)) {
+			// keep showing the previous image rather than waiting for this one
+			image = image::get_image(shown_image, image::SCALED_TO_ZOOM);
+			delayed = true;
+		} else {
+			image=image::get_image(image_loc, image::SCALED_TO_ZOOM);
+			shown_image = image_loc;
+		}
 	}
 	const int x = static_cast<int>(tmp_offset * xdst + (1.0-tmp_offset) * xsrc) + d2;
 	const int y = static_cast<int>(tmp_offset * ydst + (1.0-tmp_offset) * ysrc) + d2;
@@ -700,7 +726,7 @@ void unit_frame::redraw(const int frame_time,bool on_start_time,bool in_scope_of
 	halo_id = halo::handle(); //halo::NO_HALO;
 
 	if (!in_scope_of_frame) { //check after frame as first/last frame image used in defense/attack anims
-		return;
+		return delayed;
 	}
 
 	if(!current_data.halo.empty()) {
@@ -749,6 +775,7 @@ void unit_frame::redraw(const int frame_time,bool on_start_time,bool in_scope_of
 					orientation);
 		}
 	}
+	return delayed;
 }
 std::set<map_location> unit_frame::get_overlaped_hex(const int frame_time,const map_location & src,const map_location & dst,const frame_parameters & animation_val,const frame_parameters & engine_val) const
 {
@@ -774,6 +801,18 @@ std::set<map_location> unit_frame::get_overlaped_hex(const int frame_time,const
 	// we always invalidate our own hex because we need to be called at redraw time even
 	// if we don't draw anything in the hex itself
 	std::set<map_location> result;
+	if(image::is_pending(image_loc)) {
+		// the size is unknown until the image is decoded, and redraw() shows
+		// the previous image meanwhile: assume it doesn't spill further than
+		// the hexes around src and dst
+		result.insert(src);
+		result.insert(dst);
+		for(int i = 0; i != map_location::NDIRECTIONS; ++i) {
+			result.insert(src.get_direction(map_location::DIRECTION(i)));
+			result.insert(dst.get_direction(map_location::DIRECTION(i)));
+		}
+		return result;
+	}
 	if(tmp_offset==0 && current_data.x == 0 && current_data.directional_x == 0 && image::is_in_hex(image_loc)) {
 		result.insert(src);
 		int my_y = current_data.y;
@@ -44,6 +44,8 @@ class progressive_image {
 		const image::locator & get_current_element(int time) const;
 		bool does_not_change() const { return data_.size() <= 1; }
 		std::string get_original() const { return input_; }
+		/** Calls image::prefetch() for all the images. */
+		void prefetch() const;
 	private:
 		std::vector<std::pair<image::locator,int> > data_;
 		std::string input_;
@@ -174,6 +176,10 @@ class frame_parsed_parameters {
 		bool does_not_change() const;
 		bool need_update() const;
 		std::vector<std::string> debug_strings() const; //contents of frame in strings
+		/** Starts decoding the images, see image::prefetch(). */
+		void prefetch_images() const;
+		/** Starts loading the sounds, see sound::prefetch_sound(). */
+		void prefetch_sounds() const;
 	private:
 		int duration_;
 		progressive_image image_;
@@ -205,7 +211,15 @@ class unit_frame {
 	public:
 		// Constructors
 		unit_frame(const frame_builder& builder=frame_builder()):builder_(builder){}
-		void redraw(const int frame_time,bool on_start_time,bool in_scope_of_frame,const map_location & src,const map_location & dst,halo::handle & halo_id, halo::manager & halo_man, const frame_parameters & animation_val,const frame_parameters & engine_val)const;
+		/**
+		 * Draws the frame. While its image is being decoded in the
+		 * background (see image::is_pending()), @a shown_image, the image
+		 * drawn last time, is drawn instead; otherwise it is set to the
+		 * image of the frame.
+		 *
+		 * @returns                   Whether @a shown_image was drawn instead.
+		 */
+		bool redraw(const int frame_time,bool on_start_time,bool in_scope_of_frame,const map_location & src,const map_location & dst,halo::handle & halo_id, halo::manager & halo_man, const frame_parameters & animation_val,const frame_parameters & engine_val, image::locator & shown_image)const;
 		const frame_parameters merge_parameters(int current_time,const frame_parameters & animation_val,const frame_parameters & engine_val=frame_parameters()) const;
 		const frame_parameters parameters(int current_time) const {return builder_.parameters(current_time);}
 		const frame_parameters end_parameters() const {return builder_.parameters(duration());}
@@ -215,6 +229,8 @@ class unit_frame {
 		bool need_update() const{ return builder_.need_update();}
 		std::set<map_location> get_overlaped_hex(const int frame_time,const map_location & src,const map_location & dst,const frame_parameters & animation_val,const frame_parameters & engine_val) const;
 		std::vector<std::string> debug_strings() const { return builder_.debug_strings();} //contents of frame in strings
+		void prefetch_images() const { builder_.prefetch_images(); }
+		void prefetch_sounds() const { builder_.prefetch_sounds(); }
 	private:
 		frame_parsed_parameters builder_;
 
@@ -17,6 +17,7 @@
 
 #include "unit_id.hpp"
 #include "log.hpp"
+#include "pathfind/pathfind.hpp"
 #include "unit.hpp"
 
 #include <functional>
@@ -24,21 +25,31 @@
 
 #include <boost/foreach.hpp>
 
+#include <algorithm>
+
 static lg::log_domain log_engine("engine");
 #define ERR_NG LOG_STREAM(err, log_engine)
 #define WRN_NG LOG_STREAM(warn, log_engine)
 #define LOG_NG LOG_STREAM(info, log_engine)
 #define DBG_NG LOG_STREAM(debug, log_engine)
 
+unsigned unit_map::side_changes_ = 0;
+
 unit_map::unit_map()
 	: umap_()
 	, lmap_()
+	, sides_()
+	, sides_indexed_(false)
+	, sides_changes_(0)
 {
 }
 
 unit_map::unit_map(const unit_map& that)
 	: umap_()
 	, lmap_()
+	, sides_()
+	, sides_indexed_(false)
+	, sides_changes_(0)
 {
 	for (const_unit_iterator i = that.begin(); i != that.end(); ++i) {
 		add(i->get_location(), *i);
@@ -53,9 +64,13 @@ unit_map &unit_map::operator=(const unit_map &that) {
 
 void unit_map::swap(unit_map &o) {
 	assert(num_iters()==0 && o.num_iters() == 0);
+	pathfind::adjacency_cache::invalidate(*this);
+	pathfind::adjacency_cache::invalidate(o);
 
 	std::swap(umap_, o.umap_);
 	std::swap(lmap_, o.lmap_);
+	unit_set_changed();
+	o.unit_set_changed();
 }
 
 unit_map::~unit_map() {
@@ -94,6 +109,8 @@ std::pair<unit_map::unit_iterator, bool> unit_map::move(const map_location &src,
 	unit_ptr p = uit->second.unit;
 	if(!p){ return std::make_pair(make_unit_iterator(uit), false);}
 
+	// src may be a reference to the location of the unit itself.
+	const map_location vacated = src;
 	p->set_location(dst);
 
 	lmap_.erase(i);
@@ -107,6 +124,12 @@ std::pair<unit_map::unit_iterator, bool> unit_map::move(const map_location &src,
 		return std::make_pair(make_unit_iterator(uit), false);
 	}
 
+	pathfind::reach_cache::invalidate(vacated);
+	pathfind::reach_cache::invalidate(dst);
+	unit::clear_ability_cache();
+	pathfind::adjacency_cache::unit_removed(*this, vacated, p->side());
+	pathfind::adjacency_cache::unit_added(*this, dst, p->side());
+
 	self_check();
 
 	return std::make_pair(make_unit_iterator(uit), true);
@@ -200,6 +223,11 @@ std::pair<unit_map::unit_iterator, bool> unit_map::insert(unit_ptr p) {
 		return std::make_pair(make_unit_iterator(umap_.end()), false);
 	}
 
+	pathfind::reach_cache::invalidate(loc);
+	unit::clear_ability_cache();
+	pathfind::adjacency_cache::unit_added(*this, loc, p->side());
+	unit_set_changed();
+
 	self_check();
 	return std::make_pair( make_unit_iterator( uinsert.first ), true);
 }
@@ -244,6 +272,10 @@ void unit_map::clear(bool force) {
 
 	lmap_.clear();
 	umap_.clear();
+	unit_set_changed();
+	pathfind::reach_cache::invalidate_all();
+	unit::clear_ability_cache();
+	pathfind::adjacency_cache::invalidate(*this);
 }
 
 unit_ptr unit_map::extract(const map_location &loc) {
@@ -268,6 +300,10 @@ unit_ptr unit_map::extract(const map_location &loc) {
 	}
 
 	lmap_.erase(i);
+	pathfind::reach_cache::invalidate(loc);
+	unit::clear_ability_cache();
+	pathfind::adjacency_cache::unit_removed(*this, loc, u->side());
+	unit_set_changed();
 	self_check();
 
 	return u;
@@ -294,34 +330,45 @@ unit_map::unit_iterator unit_map::find(const map_location &loc) {
 	return make_unit_iterator<t_lmap::iterator>(lmap_.find(loc) );
 }
 
+void unit_map::index_sides() const {
+	if (sides_indexed_ && sides_changes_ == side_changes_) { return; }
+
+	sides_.clear();
+	for (t_umap::iterator i = umap_.begin(); i != umap_.end(); ++i) {
+		const unit_ptr &u = i->second.unit;
+		if (!u || u->side() < 1) { continue; }
+		if (sides_.size() < static_cast<size_t>(u->side())) {
+			sides_.resize(u->side());
+		}
+		side_index &index = sides_[u->side() - 1];
+		index.units.push_back(i);
+		if (u->can_recruit()) {
+			index.leaders.push_back(i);
+		}
+	}
+	sides_indexed_ = true;
+	sides_changes_ = side_changes_;
+}
+
 unit_map::unit_iterator unit_map::find_leader(int side) {
-	unit_map::iterator i = begin(), i_end = end();
-	for (; i != i_end; ++i) {
-		if (i->side() == side && i->can_recruit())
-			return i;
+	index_sides();
+	if (side < 1 || static_cast<size_t>(side) > sides_.size() || sides_[side - 1].leaders.empty()) {
+		return end();
 	}
-	return i_end;
+	return make_unit_iterator(sides_[side - 1].leaders.front());
 }
 
 unit_map::unit_iterator unit_map::find_first_leader(int side) {
-	unit_map::iterator i = begin(), i_end = end();
-	unit_map::iterator first_leader = end();
-
-	for (; i != i_end; ++i) {
-		if (i->side() == side && i->can_recruit()){
-			if ((first_leader == end()) || (i->underlying_id() < first_leader->underlying_id()) )
-				first_leader = i;
-		}
-	}
-	return first_leader;
+	// The leaders are indexed by underlying id.
+	return find_leader(side);
 }
 
 std::vector<unit_map::unit_iterator> unit_map::find_leaders(int side) {
-	unit_map::unit_iterator i = begin(), i_end = end();
+	index_sides();
 	std::vector<unit_map::unit_iterator> leaders;
-	for(;i != i_end; ++i){
-		if(i->side() == side && i->can_recruit()){
-			leaders.push_back(i);
+	if (side >= 1 && static_cast<size_t>(side) <= sides_.size()) {
+		BOOST_FOREACH(const t_umap::iterator &i, sides_[side - 1].leaders) {
+			leaders.push_back(make_unit_iterator(i));
 		}
 	}
 	return leaders;
@@ -332,6 +379,57 @@ std::vector<unit_map::const_unit_iterator> unit_map::find_leaders(int side)const
 	return const_leaders;
 }
 
+std::vector<unit_map::unit_iterator> unit_map::units_of_side(int side) {
+	index_sides();
+	std::vector<unit_map::unit_iterator> res;
+	if (side >= 1 && static_cast<size_t>(side) <= sides_.size()) {
+		BOOST_FOREACH(const t_umap::iterator &i, sides_[side - 1].units) {
+			res.push_back(make_unit_iterator(i));
+		}
+	}
+	return res;
+}
+std::vector<unit_map::const_unit_iterator> unit_map::units_of_side(int side) const {
+	const std::vector<unit_map::unit_iterator> &units = const_cast<unit_map*>(this)->units_of_side(side);
+	return std::vector<unit_map::const_unit_iterator>(units.begin(), units.end());
+}
+
+static bool by_underlying_id(const unit_map::unit_iterator &a, const unit_map::unit_iterator &b) {
+	return a->underlying_id() < b->underlying_id();
+}
+
+std::vector<unit_map::unit_iterator> unit_map::units_in_radius(const map_location &loc, int radius) {
+	std::vector<unit_map::unit_iterator> res;
+	if (radius < 0) { return res; }
+
+	const size_t width = 2 * static_cast<size_t>(radius) + 1;
+	if (static_cast<size_t>(radius) < lmap_.size() && width * width < lmap_.size()) {
+		// Fewer hexes than units: look the hexes of the bounding box up.
+		for (int x = loc.x - radius; x <= loc.x + radius; ++x) {
+			for (int y = loc.y - radius; y <= loc.y + radius; ++y) {
+				const map_location hex(x, y);
+				if (distance_between(loc, hex) > static_cast<size_t>(radius)) { continue; }
+				t_lmap::iterator i = lmap_.find(hex);
+				if (i != lmap_.end()) {
+					res.push_back(make_unit_iterator(i));
+				}
+			}
+		}
+		std::sort(res.begin(), res.end(), by_underlying_id);
+	} else {
+		for (unit_iterator i = begin(); i != end(); ++i) {
+			if (distance_between(loc, i->get_location()) <= static_cast<size_t>(radius)) {
+				res.push_back(i);
+			}
+		}
+	}
+	return res;
+}
+std::vector<unit_map::const_unit_iterator> unit_map::units_in_radius(const map_location &loc, int radius) const {
+	const std::vector<unit_map::unit_iterator> &units = const_cast<unit_map*>(this)->units_in_radius(loc, radius);
+	return std::vector<unit_map::const_unit_iterator>(units.begin(), units.end());
+}
+
 #ifdef DEBUG_UNIT_MAP
 
 bool unit_map::self_check() const {
@@ -25,6 +25,7 @@
 #include <cassert>
 #include <list>
 #include <map>
+#include <vector>
 #include <boost/unordered_map.hpp>
 
 //#define DEBUG_UNIT_MAP
@@ -317,6 +318,29 @@ public:
 	std::vector<unit_iterator> find_leaders(int side);
 	std::vector<const_unit_iterator> find_leaders(int side) const;
 
+	/**
+	 * The units of @a side, in the order of the iteration.
+	 * @note This and the leader lookups use an index of the units by side,
+	 *       rebuilt when first needed after a unit was added or removed, or
+	 *       changed side or leadership.
+	 */
+	std::vector<unit_iterator> units_of_side(int side);
+	std::vector<const_unit_iterator> units_of_side(int side) const;
+
+	/**
+	 * The units at most @a radius hexes away from @a loc, in the order of the
+	 * iteration. Small radii only look the hexes up.
+	 */
+	std::vector<unit_iterator> units_in_radius(const map_location &loc, int radius);
+	std::vector<const_unit_iterator> units_in_radius(const map_location &loc, int radius) const;
+
+	/**
+	 * Drops the indexes by side of all the unit maps.
+	 * Called by the units when their side or ability to recruit changes,
+	 * since they do not know which map holds them.
+	 */
+	static void invalidate_side_indexes() { ++side_changes_; }
+
 	size_t count(const map_location& loc) const { return lmap_.count(loc); }
 
 	unit_iterator begin() { return make_unit_iterator( begin_core() ); }
@@ -419,6 +443,11 @@ private:
 		return is_found(i) && (i->second->second.unit != NULL);
 	}
 
+	/** Makes sure sides_ is up to date. */
+	void index_sides() const;
+	/** Drops the index of this map, after a unit was added or removed. */
+	void unit_set_changed() { sides_indexed_ = false; }
+
 	bool is_found(const t_umap::const_iterator &i) const { return i != umap_.end(); }
 	bool is_found(const t_lmap::const_iterator &i) const { return i != lmap_.end(); }
 
@@ -444,6 +473,19 @@ private:
 	 */
 	t_lmap lmap_;
 
+	/** The units and the leaders of a side, by underlying id. */
+	struct side_index {
+		side_index() : units(), leaders() {}
+		std::vector<t_umap::iterator> units;
+		std::vector<t_umap::iterator> leaders;
+	};
+
+	/** side - 1 -> side_index, valid if sides_indexed_ and sides_changes_ is side_changes_. */
+	mutable std::vector<side_index> sides_;
+	mutable bool sides_indexed_;
+	mutable unsigned sides_changes_;
+	static unsigned side_changes_;
+
 };
 
 template <typename T>
@@ -477,8 +477,14 @@ t_string unit_type::unit_description() const
 }
 
 const std::vector<unit_animation>& unit_type::animations() const {
-	if (animations_.empty()) {
-		unit_animation::fill_initial_animations(animations_,cfg_);
+	return *shared_animations();
+}
+
+const boost::shared_ptr<const std::vector<unit_animation> >& unit_type::shared_animations() const {
+	if (!animations_) {
+		boost::shared_ptr<std::vector<unit_animation> > animations(new std::vector<unit_animation>);
+		unit_animation::fill_initial_animations(*animations, cfg_);
+		animations_ = animations;
 	}
 
 	return animations_;
@@ -23,6 +23,7 @@
 #include "util.hpp"
 
 #include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
 #include <map>
 #include <set>
 #include <string>
@@ -132,6 +133,8 @@ public:
 	const std::string &big_profile() const { return big_profile_; }
 
 	const std::vector<unit_animation>& animations() const;
+	/** The animations, shared by the units of this type rather than copied. */
+	const boost::shared_ptr<const std::vector<unit_animation> >& shared_animations() const;
 
 	const std::string& flag_rgb() const { return flag_rgb_; }
 
@@ -277,7 +280,7 @@ private:
 	std::vector<unit_race::GENDER> genders_;
 
 	// animations are loaded only after the first animations() call
-	mutable std::vector<unit_animation> animations_;
+	mutable boost::shared_ptr<const std::vector<unit_animation> > animations_;
 
 	BUILD_STATUS build_status_;
 
@@ -306,6 +309,8 @@ public:
 	const unit_race *find_race(const std::string &) const;
 
 	/// Makes sure the all unit_types are built to the specified level.
+	/// Only for what lists every unit type, as the help; the others should
+	/// rely on find(), which only builds what is used.
 	void build_all(unit_type::BUILD_STATUS status);
 	/// Makes sure the provided unit_type is built to the specified level.
 	void build_unit_type(const unit_type & ut, unit_type::BUILD_STATUS status) const
@@ -33,8 +33,11 @@
 #include "team.hpp"
 
 #include <boost/foreach.hpp>
+#include <boost/make_shared.hpp>
 #include <boost/variant/static_visitor.hpp>
 
+#include <map>
+
 static lg::log_domain log_engine("engine");
 #define LOG_NG LOG_STREAM(info, log_engine)
 #define WRN_NG LOG_STREAM(warn, log_engine)
@@ -60,14 +63,28 @@ namespace
 
 const config vconfig::default_empty_config = config();
 
+/**
+ * The attributes of a vconfig expanded, valid while the variables are
+ * unchanged.
+ */
+struct vconfig::expansion_memo
+{
+	expansion_memo() : version(0), values() {}
+
+	/// The game_data::variables_version() the values are expanded at.
+	size_t version;
+	/// The attributes, unexpanded first and expanded second.
+	std::map<std::string, std::pair<config::attribute_value, config::attribute_value> > values;
+};
+
 
 vconfig::vconfig() :
-	cache_(), cfg_(&default_empty_config)
+	cache_(), cfg_(&default_empty_config), memo_()
 {
 }
 
 vconfig::vconfig(const config & cfg, const boost::shared_ptr<const config> & cache) :
-	cache_(cache), cfg_(&cfg)
+	cache_(cache), cfg_(&cfg), memo_()
 {
 }
 
@@ -83,7 +100,8 @@ vconfig::vconfig(const config & cfg, const boost::shared_ptr<const config> & cac
  */
 vconfig::vconfig(const config &cfg, bool manage_memory) :
 	cache_(manage_memory ? new config(cfg) : NULL),
-	cfg_(manage_memory ? cache_.get() : &cfg)
+	cfg_(manage_memory ? cache_.get() : &cfg),
+	memo_()
 {
 }
 
@@ -272,13 +290,71 @@ namespace {
 			result = utils::interpolate_variables_into_tstring(s, *(resources::gamedata));
 		}
 	};
+
+	/// How the expansion of an attribute value goes.
+	enum expansion { NO_VARIABLES, MEMOIZED, EVALUATED };
+
+	struct vconfig_expansion_visitor : boost::static_visitor<expansion>
+	{
+		template<typename T> expansion operator()(T const &) const { return NO_VARIABLES; }
+		expansion operator()(const std::string &s) const { return check(s); }
+		expansion operator()(const t_string &s) const { return check(s.str()); }
+
+		/// The formulas are evaluated every time, since their result does not
+		/// only depend on the variables.
+		static expansion check(const std::string &s)
+		{
+			if(s.find('$') == std::string::npos) {
+				return NO_VARIABLES;
+			}
+			return s.find("$(") == std::string::npos ? MEMOIZED : EVALUATED;
+		}
+	};
 }//unnamed namespace
 
+/**
+ * The attribute @a key with the variables expanded.
+ * The values without variables are returned as they are, and the others are
+ * memoized until a variable is written.
+ */
 config::attribute_value vconfig::expand(const std::string &key) const
 {
 	config::attribute_value val = (*cfg_)[key];
-	if (resources::gamedata)
+	if (!resources::gamedata) {
+		return val;
+	}
+
+	const expansion how = val.apply_visitor(vconfig_expansion_visitor());
+	if(how == NO_VARIABLES) {
+		return val;
+	}
+	if(how == EVALUATED) {
 		val.apply_visitor(vconfig_expand_visitor(val));
+		return val;
+	}
+
+	if(!memo_) {
+		memo_ = boost::make_shared<expansion_memo>();
+	}
+	const game_data& gamedata = *resources::gamedata;
+	if(memo_->version == gamedata.variables_version()) {
+		std::map<std::string, std::pair<config::attribute_value, config::attribute_value> >
+			::const_iterator it = memo_->values.find(key);
+		// The config itself may have changed meanwhile.
+		if(it != memo_->values.end() && it->second.first == val) {
+			return it->second.second;
+		}
+	}
+
+	const config::attribute_value unexpanded = val;
+	val.apply_visitor(vconfig_expand_visitor(val));
+
+	// Reading scoped variables can write them, so the version is taken after.
+	if(memo_->version != gamedata.variables_version()) {
+		memo_->values.clear();
+		memo_->version = gamedata.variables_version();
+	}
+	memo_->values[key] = std::make_pair(unexpanded, val);
 	return val;
 }
 
@@ -59,7 +59,7 @@ public:
 	/// Constructor from a config.
 	/// Equivalent to vconfig(cfg, false).
 	/// Do not use if the vconfig will persist after @a cfg is destroyed!
-	explicit vconfig(const config &cfg) : cache_(), cfg_(&cfg) {}
+	explicit vconfig(const config &cfg) : cache_(), cfg_(&cfg), memo_() {}
 	vconfig(const config &cfg, bool manage_memory);
 	~vconfig();
 
@@ -163,6 +163,9 @@ private:
 	mutable boost::shared_ptr<const config> cache_;
 	/// Used to access our config (original or copy, as appropriate).
 	mutable const config* cfg_;
+	/// The attributes expanded, shared by the copies of *this.
+	struct expansion_memo;
+	mutable boost::shared_ptr<expansion_memo> memo_;
 	static const config default_empty_config;
 };
 
@@ -359,9 +359,8 @@ namespace {
 		result_type operator()(typename maybe_const<vit, config>::type& child, const std::string& key, int startindex, int endindex) const
 		{
 			result_type r = child.child_range(key);
-			std::advance(r.first, startindex);
-			r.second = r.first;
-			std::advance(r.second, endindex - startindex);
+			r.first += startindex;
+			r.second = r.first + (endindex - startindex);
 			return r;
 		}
 	};
@@ -378,16 +377,20 @@ namespace {
 		result_type operator()(config& child, const std::string& key, int startindex, int endindex) const
 		{
 			int size_diff = datasource_.size() - (endindex - startindex);
-			//remove configs first
-			while(size_diff < 0)
+			//remove configs first, all at once
+			if(size_diff < 0)
 			{
-				child.remove_child(key, startindex);
-				++size_diff;
+				child.remove_children(key, startindex, startindex - size_diff);
+				size_diff = 0;
 			}
 			size_t index = 0;
 			for(index = 0; index < static_cast<size_t>(size_diff); ++index)
 			{
-				child.add_child_at(key, config(), startindex + index).swap(datasource_[index]);
+				//appending needs no update of the ordering of the children
+				const unsigned pos = startindex + index;
+				config& added = pos == child.child_count(key) ?
+					child.add_child(key) : child.add_child_at(key, config(), pos);
+				added.swap(datasource_[index]);
 			}
 			for(; index < datasource_.size(); ++index)
 			{
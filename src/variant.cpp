@@ -14,6 +14,7 @@
 
 #include "global.hpp"
 
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 #include <string.h>
@@ -222,6 +223,56 @@ bool variant_iterator::operator!=(const variant_iterator& that) const
 		return true;
 }
 
+namespace {
+
+/**
+ * Recycled memory for the reference counted contents of variants.
+ *
+ * Formulas create and drop lists, strings and maps all the time, mostly
+ * small ones, so their blocks are kept on a free list rather than going
+ * back to the heap. Like the reference counts of variants this is not
+ * thread safe; formulas are only evaluated by the main thread.
+ *
+ * It is a POD, so it is usable before static constructors ran.
+ */
+struct variant_pool {
+	struct block { block* next; };
+
+	void* allocate(size_t size) {
+		if(!free_blocks) {
+			return ::operator new(std::max(size, sizeof(block)));
+		}
+		block* b = free_blocks;
+		free_blocks = b->next;
+		--count;
+		return b;
+	}
+
+	void deallocate(void* p) {
+		if(!p) {
+			return;
+		}
+		if(count == max_free_blocks) {
+			::operator delete(p);
+			return;
+		}
+		block* b = static_cast<block*>(p);
+		b->next = free_blocks;
+		free_blocks = b;
+		++count;
+	}
+
+	/** Enough for what a formula run drops, without hoarding memory. */
+	static const size_t max_free_blocks = 4096;
+
+	block* free_blocks;
+	size_t count;
+};
+
+variant_pool list_pool, string_pool, map_pool;
+
+}
+
 struct variant_list {
 	variant_list()
 		: elements()
@@ -229,17 +280,23 @@ struct variant_list {
 	{
 	}
 
+	static void* operator new(size_t size) { return list_pool.allocate(size); }
+	static void operator delete(void* p) { list_pool.deallocate(p); }
+
 	std::vector<variant> elements;
 	int refcount;
 };
 
 struct variant_string {
-	variant_string()
-		: str()
+	explicit variant_string(const std::string& s)
+		: str(s)
 		, refcount(0)
 	{
 	}
 
+	static void* operator new(size_t size) { return string_pool.allocate(size); }
+	static void operator delete(void* p) { string_pool.deallocate(p); }
+
 	std::string str;
 	int refcount;
 };
@@ -251,6 +308,9 @@ struct variant_map {
 	{
 	}
 
+	static void* operator new(size_t size) { return map_pool.allocate(size); }
+	static void operator delete(void* p) { map_pool.deallocate(p); }
+
 	std::map<variant,variant> elements;
 	int refcount;
 };
@@ -337,8 +397,7 @@ variant::variant(std::vector<variant>* array)
 variant::variant(const std::string& str)
 	: type_(TYPE_STRING)
 {
-	string_ = new variant_string;
-	string_->str = str;
+	string_ = new variant_string(str);
 	increment_refcount();
 }
 
@@ -552,6 +611,13 @@ const std::string& variant::as_string() const
 	return string_->str;
 }
 
+const std::vector<variant>& variant::as_list() const
+{
+	must_be(TYPE_LIST);
+	assert(list_);
+	return list_->elements;
+}
+
 variant variant::operator+(const variant& v) const
 {
 	if(type_ == TYPE_LIST) {
@@ -89,6 +89,8 @@ public:
 	bool as_bool() const;
 
 	bool is_list() const { return type_ == TYPE_LIST; }
+	/** The items of a list, without copying them. */
+	const std::vector<variant>& as_list() const;
 
 	const std::string& as_string() const;
 
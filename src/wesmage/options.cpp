@@ -14,25 +14,59 @@
 
 #include "wesmage/options.hpp"
 
+#include "filesystem.hpp"
 #include "wesmage/exit.hpp"
 #include "wesmage/filter.hpp"
 
 #include <boost/foreach.hpp>
 
+#include <algorithm>
 #include <cassert>
 #include <cstdlib>
-#include <ctime>
 #include <iostream>
 
 toptions::toptions()
-	: input_filename()
+	: input_filenames()
 	, output_filename()
 	, filters()
 	, time(false)
 	, count(1)
+	, jobs(0)
 {
 }
 
+/** Whether @p filename has the extension of an image format wesmage reads. */
+static bool
+is_image(const std::string& filename)
+{
+	static const char* const extensions[] = { ".png", ".jpg", ".jpeg", ".bmp" };
+	BOOST_FOREACH(const char* extension, extensions) {
+		if(filesystem::ends_with(filename, extension)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/** Adds @p input, or the images in it if it is a directory, to @p result. */
+static void
+add_input(std::vector<std::string>& result, const std::string& input)
+{
+	if(!filesystem::is_directory(input)) {
+		result.push_back(input);
+		return;
+	}
+
+	std::vector<std::string> files;
+	filesystem::get_files_in_dir(input, &files, NULL, filesystem::ENTIRE_FILE_PATH);
+	std::sort(files.begin(), files.end());
+	BOOST_FOREACH(const std::string& file, files) {
+		if(is_image(file)) {
+			result.push_back(file);
+		}
+	}
+}
+
 /*
  * This function prints the option and its description in a nice fashion.
  *
@@ -110,18 +144,24 @@ static void
 print_help(const int exit_status)
 {
 	std::cout <<
-"Usage wesmage [OPTION...] [FILE]\n"
+"Usage wesmage [OPTION...] [FILE...]\n"
 "Helper program to test image manipulation algorithms.\n"
 "\n"
-"The FILE is the name of the input file to be converted.\n"
+"The FILEs are the names of the input files to be converted. A directory\n"
+"stands for the images in it.\n"
 "OPTIONS:\n"
-"-o, --output FILE       The name of the output file to be written.\n"
+"-o, --output FILE       The name of the output file to be written. With\n"
+"                        several input files, the directory to write them\n"
+"                        to, each as a png file named after its input file.\n"
 "-n, --dry-run           No output is written.\n"
-"-t, --time              Show the time it took to apply the filters.\n"
-"                        The resolution of the time depends on the platform.\n"
+"-t, --time              Show the time it took to apply the filters, and the\n"
+"                        throughput of each filter in megapixels a second.\n"
 "-c, --count COUNT       The number of times the filter needs to be applied.\n"
 "                        This feature is mainly for timing an algorithm and\n"
 "                        is applied on a new image every iteration.\n"
+"-j, --jobs JOBS         The number of threads applying the filters, each to\n"
+"                        its own images. The default, 0, uses one thread per\n"
+"                        processor.\n"
 "-f, --filter FILTER     Filters to be applied to the image. See FILTERS.\n"
 "-h, --help              Show this help and terminate the program.\n"
 "\n"
@@ -194,6 +234,19 @@ toptions::parse(int argc, char* argv[])
 						<< "« should be a positive number.\n";
 				print_help(EXIT_FAILURE);
 			}
+		} else if(option == "-j" || option == "--jobs") {
+			++i;
+			VALIDATE_NOT_PAST_END;
+
+			char* end;
+			const long jobs = strtol(argv[i], &end, 10);
+			if(*end || jobs < 0) {
+				std::cerr << "Error: Parameter of jobs »"
+						<< argv[i]
+						<< "« should be a number.\n";
+				print_help(EXIT_FAILURE);
+			}
+			result.jobs = jobs;
 		} else if(option == "-o" || option == "--output") {
 			++i;
 			VALIDATE_NOT_PAST_END;
@@ -206,15 +259,14 @@ toptions::parse(int argc, char* argv[])
 			result.filters.push_back(argv[i]);
 		} else if(option.substr(0, 2) == "-f") {
 			result.filters.push_back(option.substr(2));
-		} else {
-			if(!result.input_filename.empty()) {
-				std::cerr << "Error: Command line argument »"
-						<< option
-						<< "« is not recognised.\n";
+		} else if(!option.empty() && option[0] == '-') {
+			std::cerr << "Error: Command line argument »"
+					<< option
+					<< "« is not recognised.\n";
 
-				print_help(EXIT_FAILURE);
-			}
-			result.input_filename = option;
+			print_help(EXIT_FAILURE);
+		} else {
+			add_input(result.input_filenames, option);
 		}
 	}
 
@@ -227,7 +279,7 @@ toptions::parse(int argc, char* argv[])
 		print_help(EXIT_FAILURE);
 	}
 
-	if(result.input_filename.empty()) {
+	if(result.input_filenames.empty()) {
 		std::cerr << "Error: Input filename omitted.\n";
 		print_help(EXIT_FAILURE);
 	}
@@ -237,12 +289,12 @@ toptions::parse(int argc, char* argv[])
 		print_help(EXIT_FAILURE);
 	}
 
-	if(result.time && (std::clock() == -1)) {
-		std::cerr
-			<< "Error: No timing available on your platform, "
-			<< "option disabled.\n";
-
-		result.time = false;
+	if(result.input_filenames.size() > 1 && !result.output_filename.empty()
+			&& !filesystem::is_directory(result.output_filename)) {
+		std::cerr << "Error: With several input files, the output »"
+				<< result.output_filename
+				<< "« should be a directory.\n";
+		print_help(EXIT_FAILURE);
 	}
 
 	/*
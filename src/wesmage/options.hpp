@@ -59,10 +59,20 @@ public:
 	static const toptions&
 	options();
 
-	/** The filename of the input file. */
-	std::string input_filename;
+	/**
+	 * The filenames of the input files.
+	 *
+	 * The directories given on the command line are replaced by the images
+	 * they contain.
+	 */
+	std::vector<std::string> input_filenames;
 
-	/** The filename of the output file. */
+	/**
+	 * The filename of the output file.
+	 *
+	 * With several input files, the directory to write them to instead,
+	 * each named after its input file.
+	 */
 	std::string output_filename;
 
 	/** The filters to apply to the input file. */
@@ -78,6 +88,13 @@ public:
 	 */
 	int count;
 
+	/**
+	 * The number of threads applying the filters, each to its own images.
+	 *
+	 * 0 uses one per processor.
+	 */
+	unsigned jobs;
+
 private:
 
 	/**
@@ -17,88 +17,184 @@
  * Tool to test the image conversion functions.
  */
 
+#include "filesystem.hpp"
+#include "thread.hpp"
 #include "tools/exploder_utils.hpp"
 #include "wesmage/exit.hpp"
 #include "wesmage/filter.hpp"
 #include "wesmage/options.hpp"
 
+#include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/foreach.hpp>
 
 #include <SDL_image.h>
 
-#include <ctime>
+#include <iomanip>
 #include <iostream>
 
-static clock_t
-get_begin_time()
+static boost::posix_time::ptime
+now()
 {
-	clock_t begin = std::clock();
-	clock_t end = std::clock();
-
-	while(begin == (end = std::clock())) {
-		/* DO NOTHING */
-	}
-	std::cout << "Clock resolution "
-			<< end - begin
-			<< " ticks, using " << CLOCKS_PER_SEC << " ticks/second.\n"
-			<< "This give resolution of about "
-			<<static_cast<double>(end - begin) / CLOCKS_PER_SEC
-			<< " seconds.\n";
-
-	/* IO might be slow so wait until the next value. */
-	begin = std::clock();
-	while(begin == (end = std::clock())) {
-		/* DO NOTHING */
-	}
+	return boost::posix_time::microsec_clock::universal_time();
+}
 
-	return begin;
+static double
+seconds_since(const boost::posix_time::ptime& begin)
+{
+	return (now() - begin).total_microseconds() / 1e6;
 }
 
-int
-main(int argc, char* argv[])
+/**
+ * Applies the filters to the images, or to copies of them with --count.
+ *
+ * The index of the job is that of the image times the count plus that of
+ * the copy. Each index only touches its own results.
+ */
+class tbatch_job
+	: public threading::parallel_job
 {
-	try {
-		const toptions& options = toptions::parse(argc, argv);
+public:
+	explicit tbatch_job(const toptions& options)
+		: options_(options)
+		, seconds_(options.input_filenames.size() * options.count
+				, std::vector<double>(options.filters.size(), 0.))
+		, pixels_(seconds_.size()
+				, std::vector<double>(options.filters.size(), 0.))
+		, errors_(seconds_.size())
+	{
+	}
+
+	size_t
+	count() const
+	{
+		return seconds_.size();
+	}
 
-		surface surf(make_neutral_surface(
-				IMG_Load(options.input_filename.c_str())));
+	/** Does the work of @a index. */
+	void
+	process(size_t index)
+	{
+		const size_t copies = options_.count;
+		const std::string& input = options_.input_filenames[index / copies];
 
+		surface surf(make_neutral_surface(IMG_Load(input.c_str())));
 		if(!surf) {
-			std::cerr << "Error: Failed to load input file »"
-					<< options.input_filename
-					<< "«.\n";
+			errors_[index] = "Failed to load input file »" + input + "«";
+			return;
+		}
 
-			return EXIT_FAILURE;
+		for(size_t i = 0; i != options_.filters.size(); ++i) {
+			pixels_[index][i] = static_cast<double>(surf->w) * surf->h;
+			const boost::posix_time::ptime begin = now();
+			filter_apply(surf, options_.filters[i]);
+			seconds_[index][i] = seconds_since(begin);
 		}
 
-		std::vector<surface> surfaces;
-		if(options.count != 1) {
-			for(int i = 1; i < options.count; ++i) {
-				// make_neutral_surface make a deep-copy of the image.
-				surfaces.push_back(make_neutral_surface(surf));
+		if(index % copies == 0 && !options_.output_filename.empty()) {
+			try {
+				save_image(surf, output_filename(input));
+			} catch(exploder_failure& err) {
+				errors_[index] = "Failed to write the result of »" + input
+						+ "«: " + err.message;
 			}
 		}
-		surfaces.push_back(surf);
+	}
 
-		const clock_t begin = options.time ? get_begin_time() : 0;
+	/** Prints the errors; returns whether there was none. */
+	bool
+	report_errors() const
+	{
+		bool res = true;
+		BOOST_FOREACH(const std::string& error, errors_) {
+			if(!error.empty()) {
+				std::cerr << "Error: " << error << ".\n";
+				res = false;
+			}
+		}
+		return res;
+	}
 
-		for(int i = 0; i < options.count; ++i) {
-			BOOST_FOREACH(const std::string& filter, options.filters) {
-				filter_apply(surfaces[i], filter);
+	/** Prints the time spent in each filter and its throughput. */
+	void
+	report_times() const
+	{
+		for(size_t i = 0; i != options_.filters.size(); ++i) {
+			double seconds = 0, pixels = 0;
+			for(size_t j = 0; j != seconds_.size(); ++j) {
+				seconds += seconds_[j][i];
+				pixels += pixels_[j][i];
 			}
+			std::cout << "Filter »" << options_.filters[i] << "« took "
+					<< seconds << " seconds, "
+					<< std::fixed << std::setprecision(1)
+					<< (seconds > 0 ? pixels / seconds / 1e6 : 0.)
+					<< " MPix/s per thread.\n"
+					<< std::resetiosflags(std::ios_base::fixed)
+					<< std::setprecision(6);
+		}
+	}
+
+private:
+	/** The first index is processed before the others, see main(). */
+	void
+	run(size_t index)
+	{
+		process(index + 1);
+	}
+
+	std::string
+	output_filename(const std::string& input) const
+	{
+		if(options_.input_filenames.size() == 1) {
+			return options_.output_filename;
+		}
+		std::string name = filesystem::base_name(input);
+		const std::string::size_type dot = name.rfind('.');
+		if(dot != std::string::npos) {
+			name.erase(dot);
 		}
+		return options_.output_filename + "/" + name + ".png";
+	}
 
-		if(options.time) {
-			const clock_t end = std::clock();
-			std::cout << "Applying the filters took "
-					<<  end - begin
-					<< " ticks, "
-					<< static_cast<double>(end - begin) / CLOCKS_PER_SEC
-					<< " seconds.\n";
+	const toptions& options_;
+
+	/** The time each filter took, for each index. */
+	std::vector<std::vector<double> > seconds_;
+
+	/** The size of the image each filter got, for each index. */
+	std::vector<std::vector<double> > pixels_;
+
+	std::vector<std::string> errors_;
+};
+
+int
+main(int argc, char* argv[])
+{
+	try {
+		const toptions& options = toptions::parse(argc, argv);
+		threading::set_thread_count(options.jobs);
+
+		tbatch_job job(options);
+		const boost::posix_time::ptime begin = now();
+
+		/*
+		 * The first image is done alone, so that the errors in the filter
+		 * parameters, which end the program, are only reported once.
+		 */
+		job.process(0);
+		threading::run_parallel(job, job.count() - 1);
+		const double seconds = seconds_since(begin);
+
+		if(!job.report_errors()) {
+			return EXIT_FAILURE;
 		}
 
-		if(!options.output_filename.empty()) {
-			save_image(surfaces[0], options.output_filename);
+		if(options.time) {
+			std::cout << "Applying the filters to "
+					<< job.count() << " images took "
+					<< seconds << " seconds on "
+					<< threading::hardware_concurrency() << " threads.\n";
+			job.report_times();
 		}
 
 	} catch(const texit& exit) {
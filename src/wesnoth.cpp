@@ -54,6 +54,7 @@
 #include "serialization/unicode_cast.hpp"
 #include "sound.hpp"                    // for commit_music_changes, etc
 #include "statistics.hpp"               // for fresh_stats
+#include "thread.hpp"                   // for thread
 #include "tstring.hpp"                  // for operator==, t_string
 #include "version.hpp"                  // for version_info
 #include "video.hpp"                    // for CVideo
@@ -127,6 +128,8 @@ static lg::log_domain log_config("config");
 static lg::log_domain log_preprocessor("preprocessor");
 #define LOG_PREPROC LOG_STREAM(info,log_preprocessor)
 
+static lg::log_domain log_performance("performance");
+
 // this is needed to allow identical functionality with clean refactoring
 // play_game only returns on an error, all returns within play_game can
 // be replaced with this
@@ -451,9 +454,22 @@ static int process_command_args(const commandline_options& cmdline_opts) {
 	if(cmdline_opts.log_precise_timestamps) {
 		lg::precise_timestamps(true);
 	}
+	if(cmdline_opts.log_structured) {
+		lg::structured_output(true);
+	}
+	if(cmdline_opts.log_async) {
+		const size_t rotate_size = cmdline_opts.log_rotate ? static_cast<size_t>(*cmdline_opts.log_rotate) * 1024 * 1024 : 0;
+		if(!lg::start_async_output(*cmdline_opts.log_async, rotate_size)) {
+			std::cerr << "could not open the log file " << *cmdline_opts.log_async
+				<< ", logging to the standard error\n";
+		}
+	}
 	if(cmdline_opts.rng_seed) {
 		srand(*cmdline_opts.rng_seed);
 	}
+	if(cmdline_opts.threads) {
+		threading::set_thread_count(*cmdline_opts.threads);
+	}
 	if(cmdline_opts.screenshot || cmdline_opts.render_image) {
 #if SDL_VERSION_ATLEAST(2, 0, 0)
 		SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);
@@ -542,6 +558,26 @@ static void handle_lua_script_args(game_launcher * game, commandline_options & /
 	}
 }
 
+/**
+ * The part of the startup following the game config that does not need the
+ * main thread, done by the pool meanwhile.
+ */
+class background_preparation : public threading::pooled_task
+{
+public:
+	~background_preparation()
+	{
+		wait();
+	}
+
+private:
+	void run()
+	{
+		refresh_addon_version_info_cache();
+		image::precache_file_existence();
+	}
+};
+
 /**
  * Setups the game environment and enters
  * the titlescreen or game loops.
@@ -557,10 +593,13 @@ static int do_gameloop(const std::vector<std::string>& args)
 		return finished;
 	}
 
+	lg::phase_timer startup(log_performance, "startup");
+	startup.start("sound and preferences");
 	boost::scoped_ptr<game_launcher> game(
 		new game_launcher(cmdline_opts,args[0].c_str()));
 	const int start_ticks = SDL_GetTicks();
 
+	startup.start("locale");
 	init_locale();
 
 	bool res;
@@ -568,6 +607,7 @@ static int do_gameloop(const std::vector<std::string>& args)
 	// do initialize fonts before reading the game config, to have game
 	// config error messages displayed. fonts will be re-initialized later
 	// when the language is read from the game config.
+	startup.start("fonts");
 	res = font::load_font_config();
 	if(res == false) {
 		std::cerr << "could not initialize fonts\n";
@@ -576,18 +616,21 @@ static int do_gameloop(const std::vector<std::string>& args)
 		return 1;
 	}
 
+	startup.start("language");
 	res = game->init_language();
 	if(res == false) {
 		std::cerr << "could not initialize the language\n";
 		return 1;
 	}
 
+	startup.start("video");
 	res = game->init_video();
 	if(res == false) {
 		std::cerr << "could not initialize display\n";
 		return 1;
 	}
 
+	startup.start("images and joystick");
 	res = image::update_from_preferences();
 	if(res == false) {
 		std::cerr << "could not initialize image preferences\n";
@@ -608,6 +651,7 @@ static int do_gameloop(const std::vector<std::string>& args)
 	SDL_EventState(SDL_SYSWMEVENT, SDL_ENABLE);
 #endif
 
+	startup.start("gui");
 	loadscreen::global_loadscreen_manager loadscreen_manager(game->disp().video());
 
 	loadscreen::start_stage("init gui");
@@ -617,28 +661,39 @@ static int do_gameloop(const std::vector<std::string>& args)
 	game_config_manager config_manager(cmdline_opts, game->disp(),
 	    game->jump_to_editor());
 
+	startup.start("game config");
 	loadscreen::start_stage("load config");
 	res = config_manager.init_game_config(game_config_manager::NO_FORCE_RELOAD);
 	if(res == false) {
 		std::cerr << "could not initialize game config\n";
 		return 1;
 	}
-	loadscreen::start_stage("init fonts");
 
-	res = font::load_font_config();
+	// The fonts need the main thread; the versions of the add-ons are read
+	// and the image paths indexed meanwhile. The lists of binary paths are
+	// filled now, for the two threads to only read them, and nothing may
+	// look an image up until the preparation is over.
+	startup.start("fonts, add-ons and image paths");
+	loadscreen::start_stage("init fonts");
+	filesystem::get_binary_paths("fonts");
+	filesystem::get_binary_paths("images");
+	{
+		background_preparation background;
+		background.start();
+		res = font::load_font_config();
+		background.wait();
+	}
 	if(res == false) {
 		std::cerr << "could not re-initialize fonts for the current language\n";
 		return 1;
 	}
 
-	loadscreen::start_stage("refresh addons");
-	refresh_addon_version_info_cache();
-
 	config tips_of_day;
 
 	loadscreen::start_stage("titlescreen");
 
 	LOG_CONFIG << "time elapsed: "<<  (SDL_GetTicks() - start_ticks) << " ms\n";
+	startup.report();
 
 	plugins_manager plugins_man(new application_lua_kernel(&game->disp().video()));
 
@@ -699,6 +754,10 @@ static int do_gameloop(const std::vector<std::string>& args)
 			return worker_result;
 		}
 
+		if(cmdline_opts.validate_replay) {
+			return game->validate_replays();
+		}
+
 		if(game->play_test() == false) {
 			return 0;
 		}
@@ -295,10 +295,9 @@ config attack::to_config() const
 	// final_cfg["attack_movement_cost_"] = attack_movement_cost_; //Unnecessary
 	// final_cfg["temp_movement_subtracted_"] = temp_movement_subtracted_; //Unnecessary
 
-	config target_hex_cfg;
+	config& target_hex_cfg = final_cfg.add_child("target_hex_");
 	target_hex_cfg["x"]=target_hex_.x;
 	target_hex_cfg["y"]=target_hex_.y;
-	final_cfg.add_child("target_hex_",target_hex_cfg);
 
 	return final_cfg;
 }
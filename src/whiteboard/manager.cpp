@@ -619,13 +619,19 @@ static void print_to_chat(const std::string& title, const std::string& message)
 	void manager::on_mouseover_change (const map_location& hex)
 	{
 
+		if (has_temp_move () || wait_for_side_init_ || executing_actions_) {
+			return;
+		}
+
+		// Only build the planned unit map (every planned action applied)
+		// when there is a selected hex to look at.
 		map_location selected_hex = resources::controller -> get_mouse_handler_base ().get_selected_hex ();
-		bool hex_has_unit;
+		bool hex_has_unit = false;
+		if (selected_hex.valid ())
 		{ wb::future_map future; // start planned unit map scope
 			hex_has_unit = resources::units -> find (selected_hex) != resources::units -> end ();
 		} // end planned unit map scope
-		if (!((selected_hex.valid () && hex_has_unit)
-			|| has_temp_move () || wait_for_side_init_ || executing_actions_))
+		if (!hex_has_unit)
 		{
 			if (!highlighter_)
 			{
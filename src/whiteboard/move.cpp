@@ -547,6 +547,34 @@ namespace wb {
 		return get_dest_hex();
 	}
 
+	namespace {
+		/**
+		 * Whether @a u can follow @a steps to their end this turn: what
+		 * pathfind::mark_route() would mark with turns=1 for the last step,
+		 * without marking the stops (captures and invisibility) on the way.
+		 */
+		bool reaches_this_turn(const unit& u, const std::vector<map_location>& steps)
+		{
+			const gamemap& map = resources::gameboard->map();
+			const team& unit_team = resources::teams->at(u.side()-1);
+			const team& viewing_team = resources::teams->at(viewer_team());
+			int movement = u.movement_left();
+			bool zoc = false;
+			for(size_t i = 0; i + 1 < steps.size(); ++i)
+			{
+				const int move_cost = u.movement_cost(map[steps[i+1]]);
+				if(zoc || move_cost > movement) {
+					// Stopping before the end.
+					return false;
+				}
+				zoc = pathfind::enemy_zoc(unit_team, steps[i+1], viewing_team)
+					&& !u.get_ability_bool("skirmisher", steps[i+1]);
+				movement = zoc ? 0 : movement - move_cost;
+			}
+			return !steps.empty();
+		}
+	}
+
 	action::error move::check_validity() const
 	{
 		// Used to deal with multiple return paths.
@@ -622,11 +650,9 @@ namespace wb {
 		//check that the path is good
 		if(get_source_hex() != get_dest_hex()) 
 		{ //skip zero-hex move used by attack subclass
-			// Mark the plain route to see if the move can still be done in one turn,
+			// Check that the move can still be done in one turn,
 			// which is always the case for planned moves
-			pathfind::marked_route checked_route = pathfind::mark_route(get_route().route);
-
-			if(checked_route.marks[checked_route.steps.back()].turns != 1) 
+			if(!reaches_this_turn(*unit_it, get_route().route.steps))
 			{
 				return TOO_FAR;
 			}
@@ -655,28 +681,25 @@ namespace wb {
 	//	final_cfg["unit_id_"]=unit_id_; //Unnecessary
 
 		//Serialize route_
-		config route_cfg;
+		config& route_cfg = final_cfg.add_child("route_");
 		route_cfg["move_cost"]=route_->move_cost;
 		BOOST_FOREACH(map_location const& loc, route_->steps)
 		{
-			config loc_cfg;
+			config& loc_cfg = route_cfg.add_child("step");
 			loc_cfg["x"]=loc.x;
 			loc_cfg["y"]=loc.y;
-			route_cfg.add_child("step",loc_cfg);
 		}
 		typedef std::pair<map_location,pathfind::marked_route::mark> pair_loc_mark;
 		BOOST_FOREACH(pair_loc_mark const& item, route_->marks)
 		{
-			config mark_cfg;
+			config& mark_cfg = route_cfg.add_child("mark");
 			mark_cfg["x"]=item.first.x;
 			mark_cfg["y"]=item.first.y;
 			mark_cfg["turns"]=item.second.turns;
 			mark_cfg["zoc"]=item.second.zoc;
 			mark_cfg["capture"]=item.second.capture;
 			mark_cfg["invisible"]=item.second.invisible;
-			route_cfg.add_child("mark",mark_cfg);
 		}
-		final_cfg.add_child("route_",route_cfg);
 
 		return final_cfg;
 	}
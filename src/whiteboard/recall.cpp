@@ -276,10 +276,9 @@ namespace wb
 		final_cfg["temp_unit_"] = static_cast<int>(temp_unit_->underlying_id());
 	//	final_cfg["temp_cost_"] = temp_cost_; //Unnecessary
 
-		config loc_cfg;
+		config& loc_cfg = final_cfg.add_child("recall_hex_");
 		loc_cfg["x"]=recall_hex_.x;
 		loc_cfg["y"]=recall_hex_.y;
-		final_cfg.add_child("recall_hex_",loc_cfg);
 
 		return final_cfg;
 	}
@@ -214,10 +214,9 @@ config recruit::to_config() const
 	final_cfg["unit_name_"] = unit_name_;
 //	final_cfg["temp_cost_"] = temp_cost_; //Unnecessary
 
-	config loc_cfg;
+	config& loc_cfg = final_cfg.add_child("recruit_hex_");
 	loc_cfg["x"]=recruit_hex_.x;
 	loc_cfg["y"]=recruit_hex_.y;
-	final_cfg.add_child("recruit_hex_",loc_cfg);
 
 	return final_cfg;
 }
@@ -103,7 +103,7 @@ surface menu::style::get_item_image(const image::locator& img_loc) const
 		}
 		if(scale != 100)
 		{
-			return scale_surface(surf, (scale * surf->w)/100, (scale * surf->h)/100);
+			return image::scaled_image(surf, (scale * surf->w)/100, (scale * surf->h)/100);
 		}
 	}
 	return surf;